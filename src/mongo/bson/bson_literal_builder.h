@@ -0,0 +1,139 @@
+/* bson_literal_builder.h
+
+   Append fast paths for compile-time field name literals.
+*/
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+
+    /** Append fast paths for field names that are compile-time string literals.
+
+        BSONObjBuilder measures each field name at runtime and grows its buffer
+        separately for the type byte, the name and the value.  Internal hot paths
+        (oplog entry construction, write batch bookkeeping) build the same shapes
+        over and over with literal field names, where the name length -- and, for
+        fixed-width types, the entire element layout -- is known at compile time.
+        This wrapper writes such an element with a single BufBuilder::grow and a
+        couple of memcpys.
+
+        It layers on top of an ordinary BSONObjBuilder, so literal appends can be
+        freely mixed with generic appends for runtime field names, and the generic
+        builder itself is unchanged.  Like BufBuilder::appendNum, values are laid
+        down in native byte order.
+
+        The array size N of a string literal includes its terminating NUL, which
+        is exactly what the BSON field name encoding needs.
+    */
+    class BSONLiteralBuilder : private boost::noncopyable {
+    public:
+        explicit BSONLiteralBuilder( BSONObjBuilder& builder ) : _b( builder.bb() ) {}
+
+        /** NumberInt */
+        template <size_t N>
+        void append( const char (&fieldName)[N], int val ) {
+            char* p = header( NumberInt, fieldName, sizeof(int) );
+            memcpy( p, &val, sizeof(int) );
+        }
+
+        /** NumberLong */
+        template <size_t N>
+        void append( const char (&fieldName)[N], long long val ) {
+            char* p = header( NumberLong, fieldName, sizeof(long long) );
+            memcpy( p, &val, sizeof(long long) );
+        }
+
+        /** NumberDouble */
+        template <size_t N>
+        void append( const char (&fieldName)[N], double val ) {
+            char* p = header( NumberDouble, fieldName, sizeof(double) );
+            memcpy( p, &val, sizeof(double) );
+        }
+
+        /** Bool.  Named as in BSONObjBuilder to keep bool out of the numeric
+            overload set. */
+        template <size_t N>
+        void appendBool( const char (&fieldName)[N], bool val ) {
+            char* p = header( Bool, fieldName, 1 );
+            *p = val ? 1 : 0;
+        }
+
+        /** Date */
+        template <size_t N>
+        void appendDate( const char (&fieldName)[N], Date_t val ) {
+            char* p = header( Date, fieldName, 8 );
+            unsigned long long millis = val.millis;
+            memcpy( p, &millis, 8 );
+        }
+
+        /** Timestamp, from the raw 64 bit representation (as
+            BSONObjBuilder::appendTimestamp). */
+        template <size_t N>
+        void appendTimestamp( const char (&fieldName)[N], unsigned long long val ) {
+            char* p = header( Timestamp, fieldName, 8 );
+            memcpy( p, &val, 8 );
+        }
+
+        /** String with a runtime value. */
+        template <size_t N>
+        void append( const char (&fieldName)[N], const StringData& str ) {
+            const int lenWithNull = str.size() + 1;
+            char* p = header( String, fieldName, 4 + lenWithNull );
+            memcpy( p, &lenWithNull, 4 );
+            str.copyTo( p + 4, true );
+        }
+
+        /** Subobject with a runtime value. */
+        template <size_t N>
+        void append( const char (&fieldName)[N], const BSONObj& subObj ) {
+            char* p = header( Object, fieldName, subObj.objsize() );
+            memcpy( p, subObj.objdata(), subObj.objsize() );
+        }
+
+    private:
+        // Reserve a whole element in one grow() and lay down the type byte and the
+        // field name, returning the write position for the value.
+        template <size_t N>
+        char* header( BSONType type, const char (&fieldName)[N], int valueSize ) {
+            BOOST_STATIC_ASSERT( N > 1 ); // no empty field names in literal appends
+            char* p = _b.grow( 1 + static_cast<int>( N ) + valueSize );
+            *p++ = static_cast<char>( type );
+            memcpy( p, fieldName, N );
+            return p + N;
+        }
+
+        BufBuilder& _b;
+    };
+
+} // namespace mongo
@@ -275,6 +275,31 @@ namespace {
         ASSERT_EQUALS(status.reason(), "not null terminated string in object with unknown _id");
     }
 
+    TEST(BSONValidateFast, FlatDocAllScalarTypes) {
+        // exercises the flat-document fast path: every type it handles, then checks
+        // that truncation at any length is still rejected
+        BSONObjBuilder b;
+        b.genOID();
+        b.append( "int", 17 );
+        b.append( "dbl", 3.5 );
+        b.append( "lng", 17LL );
+        b.append( "str", "the quick brown fox jumped over the lazy dog" );
+        b.appendBool( "boo", true );
+        b.appendNull( "nul" );
+        b.appendDate( "dat", 12345678 );
+        b.appendTimestamp( "tsp", 12345678 );
+        b.appendRegex( "rex", "^a+b", "i" );
+        b.appendBinData( "bin", 8, BinDataGeneral, "abcdefgh" );
+        b.appendMinKey( "min" );
+        b.appendMaxKey( "max" );
+        const BSONObj x = b.obj();
+
+        ASSERT_OK( validateBSON( x.objdata(), x.objsize() ) );
+        for ( int i = 4; i < x.objsize(); i++ ) {
+            ASSERT_NOT_OK( validateBSON( x.objdata(), i ) );
+        }
+    }
+
     TEST(BSONValidateFast, NonTopLevelId) {
         BufBuilder bb;
         BSONObjBuilder ob(bb);
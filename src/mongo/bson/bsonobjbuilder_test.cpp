@@ -30,6 +30,7 @@
  * tests for BSONObjBuilder
  */
 
+#include "mongo/bson/bson_literal_builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 
@@ -249,6 +250,46 @@ namespace {
         ASSERT_EQUALS(o1, o2);
     }
 
+    TEST(BSONLiteralBuilderTest, MatchesGenericBuilder) {
+        // The literal fast paths must produce byte-identical output to the
+        // generic appends they replace.
+        BSONObjBuilder generic;
+        generic.appendTimestamp("ts", 0x0102030405060708ULL);
+        generic.append("h", -42LL);
+        generic.append("v", 2);
+        generic.append("d", 2.5);
+        generic.append("op", "u");
+        generic.appendBool("b", true);
+        generic.appendDate("w", mongo::Date_t(1234567890ULL));
+        generic.append("o2", BSON("_id" << 1));
+        BSONObj expected = generic.obj();
+
+        BSONObjBuilder builder;
+        mongo::BSONLiteralBuilder fast(builder);
+        fast.appendTimestamp("ts", 0x0102030405060708ULL);
+        fast.append("h", -42LL);
+        fast.append("v", 2);
+        fast.append("d", 2.5);
+        fast.append("op", mongo::StringData("u"));
+        fast.appendBool("b", true);
+        fast.appendDate("w", mongo::Date_t(1234567890ULL));
+        fast.append("o2", BSON("_id" << 1));
+        BSONObj actual = builder.obj();
+
+        ASSERT_TRUE(actual.binaryEqual(expected));
+    }
+
+    TEST(BSONLiteralBuilderTest, MixesWithGenericAppends) {
+        BSONObjBuilder builder;
+        mongo::BSONLiteralBuilder fast(builder);
+        fast.append("a", 1);
+        builder.append(std::string("runtimeName"), 2);
+        fast.append("c", 3LL);
+        BSONObj o = builder.obj();
+
+        ASSERT_TRUE(o.binaryEqual(BSON("a" << 1 << "runtimeName" << 2 << "c" << 3LL)));
+    }
+
     TEST(BSONObjBuilderTest, AppendMaxTimestampOpTimeConversion) {
         BSONObjBuilder b;
         b.appendMaxForType("a", mongo::Timestamp);
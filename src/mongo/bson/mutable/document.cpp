@@ -565,7 +565,9 @@ namespace mutablebson {
             , _leafBuilder(_leafBuf)
             , _fieldNameScratch()
             , _damages()
-            , _inPlaceMode(inPlaceMode) {
+            , _inPlaceMode(inPlaceMode)
+            , _fieldIndexes()
+            , _topoVersion(0) {
 
             // We always have a BSONObj for the leaves, and we often have
             // one for our base document, so reserve 2.
@@ -607,6 +609,9 @@ namespace mutablebson {
             _damages.clear();
             _inPlaceMode = inPlaceMode;
 
+            _fieldIndexes.clear();
+            _topoVersion = 0;
+
             // Ensure that we start in the same state as the ctor would leave us in.
             _objects.push_back(_leafBuilder.asTempObj());
         }
@@ -996,6 +1001,12 @@ namespace mutablebson {
 
         void disableInPlaceUpdates() {
             _inPlaceMode = Document::kInPlaceDisabled;
+
+            // Every structural mutation of the document (adding, removing, renaming or
+            // replacing Elements) funnels through here, which makes it a convenient place
+            // to invalidate the lazily built field name indexes. Value-only in-place
+            // updates don't come through, but those can't change field names or topology.
+            ++_topoVersion;
         }
 
         Document::InPlaceMode getCurrentInPlaceMode() const {
@@ -1086,6 +1097,109 @@ namespace mutablebson {
             return &_fieldNames[fieldNameId];
         }
 
+    public:
+
+        // Find the first child of 'parentIdx' named 'name', or return kInvalidRepIdx.
+        //
+        // Objects with at least kFieldIndexMinChildren children get a lazily built,
+        // open-addressed hash index over their field names so that repeated lookups (as
+        // done per path component by path_support::findLongestPrefix) cost O(1) instead
+        // of a linear sibling walk. Smaller objects keep the walk, which beats the index
+        // overhead at that size. Indexes are dropped wholesale whenever the document is
+        // structurally mutated (see disableInPlaceUpdates).
+        Element::RepIdx findFirstChildNamed(Element::RepIdx parentIdx, const StringData& name) {
+            FieldIndexMap::iterator where = _fieldIndexes.find(parentIdx);
+            if (where != _fieldIndexes.end()) {
+                if (where->second.version == _topoVersion)
+                    return probeFieldIndex(where->second, name);
+                _fieldIndexes.erase(where);
+            }
+
+            Element::RepIdx current = resolveLeftChild(parentIdx);
+            size_t walked = 0;
+            while ((current != Element::kInvalidRepIdx) &&
+                   (getFieldName(getElementRep(current)) != name)) {
+                current = resolveRightSibling(current);
+                ++walked;
+            }
+
+            // This walk was long enough that building the index is worth it; do it now so
+            // the next lookup under this parent gets the O(1) path.
+            if (walked >= kFieldIndexMinChildren)
+                buildFieldIndex(parentIdx);
+
+            return current;
+        }
+
+    private:
+
+        // Number of children walked past before we consider an object worth indexing.
+        static const size_t kFieldIndexMinChildren = 8;
+
+        struct FieldIndex {
+            uint64_t version; // _topoVersion when this index was built
+
+            // Power-of-two sized, linear probing, kInvalidRepIdx marks an empty slot. We
+            // store only rep indexes and re-read the field name on probe, so the index
+            // survives reallocation of the field name heap and the rep vector.
+            std::vector<Element::RepIdx> buckets;
+        };
+        typedef std::map<Element::RepIdx, FieldIndex> FieldIndexMap;
+
+        static size_t fieldNameHash(const StringData& name) {
+            // FNV-1a
+            size_t hash = static_cast<size_t>(2166136261UL);
+            for (size_t i = 0; i < name.size(); ++i) {
+                hash ^= static_cast<unsigned char>(name[i]);
+                hash *= 16777619UL;
+            }
+            return hash;
+        }
+
+        void buildFieldIndex(Element::RepIdx parentIdx) {
+            std::vector<Element::RepIdx> children;
+            for (Element::RepIdx current = resolveLeftChild(parentIdx);
+                 current != Element::kInvalidRepIdx;
+                 current = resolveRightSibling(current)) {
+                children.push_back(current);
+            }
+
+            // Keep the load factor at or below one half.
+            size_t numBuckets = 2;
+            while (numBuckets < 2 * children.size())
+                numBuckets *= 2;
+
+            FieldIndex& index = _fieldIndexes[parentIdx];
+            index.version = _topoVersion;
+            index.buckets.assign(numBuckets, Element::kInvalidRepIdx);
+
+            // Insert in sibling order: with linear probing and no deletions, equal names
+            // then appear in probe order, so probeFieldIndex finds the leftmost sibling
+            // first, matching the semantics of the linear walk.
+            const size_t mask = numBuckets - 1;
+            for (size_t i = 0; i < children.size(); ++i) {
+                size_t slot = fieldNameHash(getFieldName(getElementRep(children[i]))) & mask;
+                while (index.buckets[slot] != Element::kInvalidRepIdx)
+                    slot = (slot + 1) & mask;
+                index.buckets[slot] = children[i];
+            }
+        }
+
+        Element::RepIdx probeFieldIndex(const FieldIndex& index, const StringData& name) const {
+            const size_t mask = index.buckets.size() - 1;
+            size_t slot = fieldNameHash(name) & mask;
+            for (;;) {
+                const Element::RepIdx candidate = index.buckets[slot];
+                if (candidate == Element::kInvalidRepIdx)
+                    return Element::kInvalidRepIdx;
+                if (getFieldName(getElementRep(candidate)) == name)
+                    return candidate;
+                slot = (slot + 1) & mask;
+            }
+        }
+
+    public:
+
         size_t _numElements;
         ElementRep _fastElements[kFastReps];
         std::vector<ElementRep> _slowElements;
@@ -1107,6 +1221,11 @@ namespace mutablebson {
         // Queue of damage events and status bit for whether  in-place updates are possible.
         DamageVector _damages;
         Document::InPlaceMode _inPlaceMode;
+
+        // Lazily built per-object field name indexes, and the structural version used to
+        // invalidate them (see findFirstChildNamed).
+        FieldIndexMap _fieldIndexes;
+        uint64_t _topoVersion;
     };
 
     Status Element::addSiblingLeft(Element e) {
@@ -1404,13 +1523,7 @@ namespace mutablebson {
     Element Element::findFirstChildNamed(const StringData& name) const {
         verify(ok());
         Document::Impl& impl = _doc->getImpl();
-        Element::RepIdx current = _repIdx;
-        current = impl.resolveLeftChild(current);
-        // TODO: Could DRY this loop with the identical logic in findElementNamed.
-        while ((current != kInvalidRepIdx) &&
-               (impl.getFieldName(impl.getElementRep(current)) != name))
-            current = impl.resolveRightSibling(current);
-        return Element(_doc, current);
+        return Element(_doc, impl.findFirstChildNamed(_repIdx, name));
     }
 
     Element Element::findElementNamed(const StringData& name) const {
@@ -1169,6 +1169,42 @@ namespace {
         ASSERT_EQUALS(mongo::fromjson(outJson), outObj);
     }
 
+    TEST(Document, FindFirstChildNamedManyFields) {
+        // Once an object has enough children, repeated lookups are served from a lazily
+        // built per-object field name index. Exercise both the initial linear walk and
+        // the indexed path, including duplicate names and misses.
+        static const char inJson[] =
+            "{"
+            "  'a' : 1, 'b' : 2, 'c' : 3, 'd' : 4, 'e' : 5,"
+            "  'f' : 6, 'g' : 7, 'h' : 8, 'dup' : 9, 'dup' : 10, 'z' : 11"
+            "}";
+
+        mongo::BSONObj inObj = mongo::fromjson(inJson);
+        mmb::Document doc(inObj);
+
+        // First lookup walks past enough siblings to trigger the index build.
+        mmb::Element z = mmb::findFirstChildNamed(doc.root(), "z");
+        ASSERT_TRUE(z.ok());
+        ASSERT_EQUALS(11, z.getValueInt());
+
+        // Subsequent lookups are indexed and must still find the leftmost duplicate.
+        mmb::Element dup = mmb::findFirstChildNamed(doc.root(), "dup");
+        ASSERT_TRUE(dup.ok());
+        ASSERT_EQUALS(9, dup.getValueInt());
+        ASSERT_FALSE(mmb::findFirstChildNamed(doc.root(), "missing").ok());
+
+        // Structural mutations invalidate the index; lookups must see the new topology.
+        ASSERT_OK(dup.remove());
+        dup = mmb::findFirstChildNamed(doc.root(), "dup");
+        ASSERT_TRUE(dup.ok());
+        ASSERT_EQUALS(10, dup.getValueInt());
+
+        ASSERT_OK(doc.root().appendInt("q", 12));
+        mmb::Element q = mmb::findFirstChildNamed(doc.root(), "q");
+        ASSERT_TRUE(q.ok());
+        ASSERT_EQUALS(12, q.getValueInt());
+    }
+
     TEST(Document, ArrayIndexedAccessFromJson) {
         static const char inJson[] =
             "{"
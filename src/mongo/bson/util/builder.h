@@ -151,6 +151,17 @@ namespace mongo {
         */
         char* skip(int n) { return grow(n); }
 
+        /** size hint: ensure at least 'bytes' more can be appended without another
+            realloc-and-copy.  len() is unchanged.  callers that know the final size
+            up front (e.g. a reply embedding an already-built buffer) use this to pay
+            one allocation instead of a chain of doubling copies.
+        */
+        void reserveBytes(int bytes) {
+            int newCap = l + bytes;
+            if ( newCap > size )
+                grow_reallocate(newCap);
+        }
+
         /* note this may be deallocated (realloced) if you keep writing. */
         char* buf() { return data; }
         const char* buf() const { return data; }
@@ -0,0 +1,169 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/bson/util/multi_path_extractor.h"
+
+#include <utility>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * One level of the path lookup tree.  "literals" holds the full remaining
+     * dotted suffix of every path pending at this level -- getFieldDotted()
+     * matches a field named for the whole suffix before it ever splits at a dot.
+     * "children" holds the first component of each multi-component suffix for the
+     * descend-into-subobject fallback.  Both are searched linearly with strcmp;
+     * path sets are small (key patterns, projections) and a linear scan avoids
+     * allocating a lookup key per visited element.
+     */
+    struct MultiPathExtractor::Node {
+        struct Literal {
+            std::string name;
+            std::vector<size_t> slots;
+        };
+        struct Child {
+            std::string name;
+            Node* node;
+        };
+        std::vector<Literal> literals;
+        std::vector<Child> children;
+    };
+
+    MultiPathExtractor::MultiPathExtractor( const std::vector<std::string>& paths )
+        : _root( new Node() ),
+          _numPaths( paths.size() ) {
+        for ( size_t i = 0; i < paths.size(); i++ ) {
+            _addPath( _root, paths[i], i );
+        }
+    }
+
+    MultiPathExtractor::~MultiPathExtractor() {
+        _deleteNode( _root );
+    }
+
+    void MultiPathExtractor::_deleteNode( Node* node ) {
+        for ( size_t i = 0; i < node->children.size(); i++ ) {
+            _deleteNode( node->children[i].node );
+        }
+        delete node;
+    }
+
+    void MultiPathExtractor::_addPath( Node* node, const StringData& remaining, size_t index ) {
+        Node::Literal* literal = NULL;
+        for ( size_t i = 0; i < node->literals.size(); i++ ) {
+            if ( remaining == node->literals[i].name ) {
+                literal = &node->literals[i];
+                break;
+            }
+        }
+        if ( !literal ) {
+            node->literals.push_back( Node::Literal() );
+            literal = &node->literals.back();
+            literal->name = remaining.toString();
+        }
+        literal->slots.push_back( index );
+
+        size_t dot = remaining.find( '.' );
+        if ( dot == std::string::npos )
+            return;
+
+        // like getFieldDotted(), split only at the first dot; deeper dots are
+        // handled one level down
+        StringData first = remaining.substr( 0, dot );
+        Node* child = NULL;
+        for ( size_t i = 0; i < node->children.size(); i++ ) {
+            if ( first == node->children[i].name ) {
+                child = node->children[i].node;
+                break;
+            }
+        }
+        if ( !child ) {
+            node->children.push_back( Node::Child() );
+            node->children.back().name = first.toString();
+            child = node->children.back().node = new Node();
+        }
+        _addPath( child, remaining.substr( dot + 1 ), index );
+    }
+
+    void MultiPathExtractor::extract( const BSONObj& obj, std::vector<BSONElement>* out ) const {
+        out->clear();
+        out->resize( _numPaths );
+        _extract( obj, _root, out );
+    }
+
+    void MultiPathExtractor::_extract( const BSONObj& obj,
+                                       const Node* node,
+                                       std::vector<BSONElement>* out ) const {
+        // Remember subobjects to descend into, but only recurse after the whole
+        // level has been scanned: a literal match at this level outranks anything
+        // found deeper, and a slot already filled is never overwritten.  The
+        // first element of a given name wins, as with getField().
+        std::vector< std::pair<const Node*, BSONElement> > toDescend;
+
+        BSONObjIterator it( obj );
+        while ( it.more() ) {
+            BSONElement e = it.next();
+            const char* name = e.fieldName();
+
+            for ( size_t i = 0; i < node->literals.size(); i++ ) {
+                if ( node->literals[i].name != name )
+                    continue;
+                const std::vector<size_t>& slots = node->literals[i].slots;
+                for ( size_t j = 0; j < slots.size(); j++ ) {
+                    if ( (*out)[slots[j]].eoo() )
+                        (*out)[slots[j]] = e;
+                }
+                break;
+            }
+
+            for ( size_t i = 0; i < node->children.size(); i++ ) {
+                if ( node->children[i].name != name )
+                    continue;
+                bool seen = false;
+                for ( size_t j = 0; j < toDescend.size(); j++ ) {
+                    if ( toDescend[j].first == node->children[i].node ) {
+                        seen = true;
+                        break;
+                    }
+                }
+                if ( !seen )
+                    toDescend.push_back( std::make_pair( node->children[i].node, e ) );
+                break;
+            }
+        }
+
+        for ( size_t i = 0; i < toDescend.size(); i++ ) {
+            const BSONElement& e = toDescend[i].second;
+            // getObjectField() descends through objects and arrays alike
+            if ( e.type() == Object || e.type() == Array )
+                _extract( e.embeddedObject(), toDescend[i].first, out );
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,79 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class BSONElement;
+
+    /**
+     * Resolves a fixed set of dotted paths against a document in a single walk of
+     * the BSON buffer, where calling BSONObj::getFieldDotted() once per path would
+     * re-scan the buffer from the start for every path.
+     *
+     * Matching semantics are exactly those of getFieldDotted(): at each level a
+     * field whose name is the entire remaining dotted path wins over descending
+     * through a subobject, and arrays are reached by numeric component ("a.0")
+     * rather than expanded.
+     *
+     * Construction builds a small lookup tree over the paths, so build one of
+     * these per key pattern / field set and reuse it across documents.
+     */
+    class MultiPathExtractor {
+        MONGO_DISALLOW_COPYING(MultiPathExtractor);
+    public:
+        explicit MultiPathExtractor( const std::vector<std::string>& paths );
+        ~MultiPathExtractor();
+
+        size_t numPaths() const { return _numPaths; }
+
+        /**
+         * Resolves every path against obj.  On return (*out)[i] is the element
+         * matched by paths[i], or an eoo element if the path has no match.
+         */
+        void extract( const BSONObj& obj, std::vector<BSONElement>* out ) const;
+
+    private:
+        struct Node;
+
+        void _addPath( Node* node, const StringData& remaining, size_t index );
+        void _extract( const BSONObj& obj, const Node* node, std::vector<BSONElement>* out ) const;
+        static void _deleteNode( Node* node );
+
+        Node* _root;
+        size_t _numPaths;
+    };
+
+} // namespace mongo
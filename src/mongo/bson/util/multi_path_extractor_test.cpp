@@ -0,0 +1,112 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/util/multi_path_extractor.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    // every extracted element must equal what getFieldDotted() returns
+    void assertMatchesGetFieldDotted(const BSONObj& obj, const std::vector<std::string>& paths) {
+        MultiPathExtractor extractor(paths);
+        std::vector<BSONElement> elts;
+        extractor.extract(obj, &elts);
+        ASSERT_EQUALS(paths.size(), elts.size());
+        for (size_t i = 0; i < paths.size(); i++) {
+            BSONElement expected = obj.getFieldDotted(paths[i]);
+            if (expected.eoo()) {
+                ASSERT_TRUE(elts[i].eoo());
+            }
+            else {
+                ASSERT_EQUALS(0, expected.woCompare(elts[i], false));
+            }
+        }
+    }
+
+    TEST(MultiPathExtractor, TopLevelFields) {
+        std::vector<std::string> paths;
+        paths.push_back("a");
+        paths.push_back("c");
+        paths.push_back("missing");
+        assertMatchesGetFieldDotted(fromjson("{a: 1, b: 2, c: 'x'}"), paths);
+    }
+
+    TEST(MultiPathExtractor, DottedFields) {
+        std::vector<std::string> paths;
+        paths.push_back("a.b");
+        paths.push_back("a.c.d");
+        paths.push_back("a");
+        paths.push_back("a.missing");
+        assertMatchesGetFieldDotted(fromjson("{a: {b: 1, c: {d: 2}}, e: 3}"), paths);
+    }
+
+    TEST(MultiPathExtractor, LiteralDottedNameWinsOverDescent) {
+        std::vector<std::string> paths;
+        paths.push_back("a.b");
+        // a field literally named "a.b" is what getFieldDotted() finds first
+        assertMatchesGetFieldDotted(fromjson("{'a.b': 1, a: {b: 2}}"), paths);
+        assertMatchesGetFieldDotted(fromjson("{a: {b: 2}, 'a.b': 1}"), paths);
+    }
+
+    TEST(MultiPathExtractor, ArraysNotExpanded) {
+        std::vector<std::string> paths;
+        paths.push_back("a.b");   // not expanded through the array -> eoo
+        paths.push_back("a.0");   // numeric component reaches into the array
+        paths.push_back("a.1.b");
+        assertMatchesGetFieldDotted(fromjson("{a: [{b: 1}, {b: 2}]}"), paths);
+    }
+
+    TEST(MultiPathExtractor, NonObjectBlocksDescent) {
+        std::vector<std::string> paths;
+        paths.push_back("a.b");
+        assertMatchesGetFieldDotted(fromjson("{a: 5}"), paths);
+    }
+
+    TEST(MultiPathExtractor, ReusedAcrossDocuments) {
+        std::vector<std::string> paths;
+        paths.push_back("x");
+        paths.push_back("y.z");
+        MultiPathExtractor extractor(paths);
+
+        std::vector<BSONElement> elts;
+        extractor.extract(fromjson("{x: 1, y: {z: 2}}"), &elts);
+        ASSERT_EQUALS(1, elts[0].numberInt());
+        ASSERT_EQUALS(2, elts[1].numberInt());
+
+        extractor.extract(fromjson("{y: {z: 'q'}}"), &elts);
+        ASSERT_TRUE(elts[0].eoo());
+        ASSERT_EQUALS(std::string("q"), elts[1].str());
+    }
+
+}  // namespace
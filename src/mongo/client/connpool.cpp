@@ -49,6 +49,11 @@ namespace mongo {
     }
 
     void PoolForHost::clear() {
+        SimpleMutex::scoped_lock lk(_lock);
+        _clear_inlock();
+    }
+
+    void PoolForHost::_clear_inlock() {
         while ( ! _pool.empty() ) {
             StoredConnection sc = _pool.top();
             delete sc.conn;
@@ -59,36 +64,52 @@ namespace mongo {
     void PoolForHost::done(DBConnectionPool* pool, DBClientBase* c) {
 
         bool isFailed = c->isFailed();
+        bool destroy = false;
+
+        {
+            SimpleMutex::scoped_lock lk(_lock);
 
-        // Remember that this host had a broken connection for later
-        if (isFailed) reportBadConnectionAt(c->getSockCreationMicroSec());
+            // Remember that this host had a broken connection for later
+            if (isFailed) _reportBadConnectionAt_inlock(c->getSockCreationMicroSec());
+
+            if (isFailed ||
+                // Another (later) connection was reported as broken to this host
+                (c->getSockCreationMicroSec() < _minValidCreationTimeMicroSec) ||
+                // We have a pool size that we need to enforce
+                (_maxPoolSize >= 0 && static_cast<int>(_pool.size()) >= _maxPoolSize)) {
+                destroy = true;
+            }
+            else {
+                // The connection is probably fine, save for later
+                _pool.push(c);
+            }
+        }
 
-        if (isFailed ||
-            // Another (later) connection was reported as broken to this host
-            (c->getSockCreationMicroSec() < _minValidCreationTimeMicroSec) ||
-            // We have a pool size that we need to enforce
-            (_maxPoolSize >= 0 && static_cast<int>(_pool.size()) >= _maxPoolSize)) {
+        // Run the destroy hooks and free the connection outside our lock
+        if (destroy) {
             pool->onDestroy(c);
             delete c;
         }
-        else {
-            // The connection is probably fine, save for later
-            _pool.push(c);
-        }
     }
 
     void PoolForHost::reportBadConnectionAt(uint64_t microSec) {
+        SimpleMutex::scoped_lock lk(_lock);
+        _reportBadConnectionAt_inlock(microSec);
+    }
+
+    void PoolForHost::_reportBadConnectionAt_inlock(uint64_t microSec) {
         if (microSec != DBClientBase::INVALID_SOCK_CREATION_TIME &&
                 microSec > _minValidCreationTimeMicroSec) {
             _minValidCreationTimeMicroSec = microSec;
             log() << "Detected bad connection created at " << _minValidCreationTimeMicroSec
                     << " microSec, clearing pool for " << _hostName
                     << " of " << _pool.size() << " connections" << endl;
-            clear();
+            _clear_inlock();
         }
     }
 
     bool PoolForHost::isBadSocketCreationTime(uint64_t microSec) {
+        SimpleMutex::scoped_lock lk(_lock);
         return microSec != DBClientBase::INVALID_SOCK_CREATION_TIME &&
                 microSec <= _minValidCreationTimeMicroSec;
     }
@@ -96,36 +117,49 @@ namespace mongo {
     DBClientBase * PoolForHost::get( DBConnectionPool * pool , double socketTimeout ) {
 
         time_t now = time(0);
-        
-        while ( ! _pool.empty() ) {
-            StoredConnection sc = _pool.top();
-            _pool.pop();
-            
+
+        for ( ;; ) {
+            StoredConnection sc( NULL );
+            {
+                SimpleMutex::scoped_lock lk(_lock);
+                if ( _pool.empty() )
+                    return NULL;
+                sc = _pool.top();
+                _pool.pop();
+            }
+
+            // Validate outside the lock; ok() pokes the socket.
             if ( ! sc.ok( now ) )  {
                 pool->onDestroy( sc.conn );
                 delete sc.conn;
                 continue;
             }
-            
+
             verify( sc.conn->getSoTimeout() == socketTimeout );
 
             return sc.conn;
-
         }
-
-        return NULL;
     }
 
     void PoolForHost::flush() {
         vector<StoredConnection> all;
-        while ( ! _pool.empty() ) {
-            StoredConnection c = _pool.top();
-            _pool.pop();
+        {
+            SimpleMutex::scoped_lock lk(_lock);
+            while ( ! _pool.empty() ) {
+                all.push_back( _pool.top() );
+                _pool.pop();
+            }
+        }
+
+        // Ping each connection outside the lock so a slow host doesn't block
+        // checkout/checkin while we flush.
+        vector<StoredConnection> alive;
+        for ( vector<StoredConnection>::iterator i=all.begin(); i != all.end(); ++i ) {
+            StoredConnection& c = *i;
             bool res;
-            bool alive = false;
             try {
                 c.conn->isMaster( res );
-                alive = true;
+                alive.push_back( c );
             } catch ( const DBException e ) {
                 // There's something wrong with this connection, swallow the exception and do not
                 // put the connection back in the pool.
@@ -134,12 +168,10 @@ namespace mongo {
                 delete c.conn;
                 c.conn = NULL;
             }
-            if ( alive ) {
-                all.push_back( c );
-            }
         }
 
-        for ( vector<StoredConnection>::iterator i=all.begin(); i != all.end(); ++i ) {
+        SimpleMutex::scoped_lock lk(_lock);
+        for ( vector<StoredConnection>::iterator i=alive.begin(); i != alive.end(); ++i ) {
             _pool.push( *i );
         }
     }
@@ -148,18 +180,26 @@ namespace mongo {
         time_t now = time(0);
 
         vector<StoredConnection> all;
-        while ( ! _pool.empty() ) {
-            StoredConnection c = _pool.top();
-            _pool.pop();
-            
-            if ( c.ok( now ) )
-                all.push_back( c );
-            else
-                stale.push_back( c.conn );
+        {
+            SimpleMutex::scoped_lock lk(_lock);
+            while ( ! _pool.empty() ) {
+                all.push_back( _pool.top() );
+                _pool.pop();
+            }
         }
 
+        // ok() pokes the socket, so check outside the lock
+        vector<StoredConnection> keep;
         for ( size_t i=0; i<all.size(); i++ ) {
-            _pool.push( all[i] );
+            if ( all[i].ok( now ) )
+                keep.push_back( all[i] );
+            else
+                stale.push_back( all[i].conn );
+        }
+
+        SimpleMutex::scoped_lock lk(_lock);
+        for ( size_t i=0; i<keep.size(); i++ ) {
+            _pool.push( keep[i] );
         }
     }
 
@@ -175,12 +215,14 @@ namespace mongo {
     }
 
     void PoolForHost::createdOne( DBClientBase * base) {
+        SimpleMutex::scoped_lock lk(_lock);
         if ( _created == 0 )
             _type = base->type();
         _created++;
     }
 
     void PoolForHost::initializeHostName(const std::string& hostName) {
+        SimpleMutex::scoped_lock lk(_lock);
         if (_hostName.empty()) {
             _hostName = hostName;
         }
@@ -193,31 +235,45 @@ namespace mongo {
     const int PoolForHost::kPoolSizeUnlimited(-1);
 
     DBConnectionPool::DBConnectionPool()
-        : _mutex("DBConnectionPool") , 
-          _name( "dbconnectionpool" ) , 
+        : _mutex("DBConnectionPool") ,
+          _name( "dbconnectionpool" ) ,
           _maxPoolSize(PoolForHost::kPoolSizeUnlimited) ,
           _hooks( new list<DBConnectionHook*>() ) {
+        _currentPools.store( reinterpret_cast<uintptr_t>( new PoolMap() ) );
+    }
+
+    PoolForHost* DBConnectionPool::_getPool( const PoolKey& key ) {
+        const PoolMap* current = _currentPoolMap();
+        PoolMap::const_iterator it = current->find( key );
+        if ( it != current->end() )
+            return it->second;
+
+        // First use of this host (rare) - create its pool under the global lock
+        // and publish a new snapshot.
+        scoped_lock L(_mutex);
+        PoolForHost*& p = _pools[key];
+        if ( ! p ) {
+            p = new PoolForHost();
+            p->setMaxPoolSize(_maxPoolSize);
+            p->initializeHostName(key.ident);
+
+            const PoolMap* old = _currentPoolMap();
+            _currentPools.store( reinterpret_cast<uintptr_t>( new PoolMap( _pools ) ) );
+            _retiredPools.push_back( old );
+        }
+        return p;
     }
 
     DBClientBase* DBConnectionPool::_get(const string& ident , double socketTimeout ) {
         uassert(17382, "Can't use connection pool during shutdown",
                 !inShutdown());
-        scoped_lock L(_mutex);
-        PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
-        p.setMaxPoolSize(_maxPoolSize);
-        p.initializeHostName(ident);
-        return p.get( this , socketTimeout );
+        return _getPool( PoolKey(ident,socketTimeout) )->get( this , socketTimeout );
     }
 
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
-        {
-            scoped_lock L(_mutex);
-            PoolForHost& p = _pools[PoolKey(host,socketTimeout)];
-            p.setMaxPoolSize(_maxPoolSize);
-            p.initializeHostName(host);
-            p.createdOne( conn );
-        }
-        
+        _getPool( PoolKey(host,socketTimeout) )->createdOne( conn );
+
+
         try {
             onCreate( conn );
             onHandedOut( conn );
@@ -274,39 +330,46 @@ namespace mongo {
     }
 
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
-        scoped_lock L(_mutex);
-        _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        _getPool( PoolKey(host,c->getSoTimeout()) )->done(this,c);
     }
 
 
     DBConnectionPool::~DBConnectionPool() {
         // connection closing is handled by ~PoolForHost
+        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); ++i ) {
+            delete i->second;
+        }
+        delete _currentPoolMap();
+        for ( size_t i = 0; i < _retiredPools.size(); i++ ) {
+            delete _retiredPools[i];
+        }
     }
 
     void DBConnectionPool::flush() {
-        scoped_lock L(_mutex);
-        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); i++ ) {
-            PoolForHost& p = i->second;
-            p.flush();
+        // the snapshot is immutable and per-host pools lock themselves, so no
+        // need for the global lock here
+        const PoolMap* current = _currentPoolMap();
+        for ( PoolMap::const_iterator i = current->begin(); i != current->end(); ++i ) {
+            i->second->flush();
         }
     }
 
     void DBConnectionPool::clear() {
-        scoped_lock L(_mutex);
         LOG(2) << "Removing connections on all pools owned by " << _name  << endl;
-        for (PoolMap::iterator iter = _pools.begin(); iter != _pools.end(); ++iter) {
-            iter->second.clear();
+        const PoolMap* current = _currentPoolMap();
+        for ( PoolMap::const_iterator i = current->begin(); i != current->end(); ++i ) {
+            i->second->clear();
         }
     }
 
     void DBConnectionPool::removeHost( const string& host ) {
-        scoped_lock L(_mutex);
         LOG(2) << "Removing connections from all pools for host: " << host << endl;
-        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); ++i ) {
+        const PoolMap* current = _currentPoolMap();
+        for ( PoolMap::const_iterator i = current->begin(); i != current->end(); ++i ) {
             const string& poolHost = i->first.ident;
             if ( !serverNameCompare()(host, poolHost) && !serverNameCompare()(poolHost, host) ) {
                 // hosts are the same
-                i->second.clear();
+                i->second->clear();
             }
         }
     }
@@ -352,23 +415,23 @@ namespace mongo {
         
         BSONObjBuilder bb( b.subobjStart( "hosts" ) );
         {
-            scoped_lock lk( _mutex );
-            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                if ( i->second.numCreated() == 0 )
+            const PoolMap* current = _currentPoolMap();
+            for ( PoolMap::const_iterator i=current->begin(); i!=current->end(); ++i ) {
+                if ( i->second->numCreated() == 0 )
                     continue;
 
                 string s = str::stream() << i->first.ident << "::" << i->first.timeout;
 
                 BSONObjBuilder temp( bb.subobjStart( s ) );
-                temp.append( "available" , i->second.numAvailable() );
-                temp.appendNumber( "created" , i->second.numCreated() );
+                temp.append( "available" , i->second->numAvailable() );
+                temp.appendNumber( "created" , i->second->numCreated() );
                 temp.done();
 
-                avail += i->second.numAvailable();
-                created += i->second.numCreated();
+                avail += i->second->numAvailable();
+                created += i->second->numCreated();
 
-                long long& x = createdByType[i->second.type()];
-                x += i->second.numCreated();
+                long long& x = createdByType[i->second->type()];
+                x += i->second->numCreated();
             }
         }
         bb.done();
@@ -449,9 +512,10 @@ namespace mongo {
         }
 
         {
-            scoped_lock sl(_mutex);
-            PoolForHost& pool = _pools[PoolKey(hostName, conn->getSoTimeout())];
-            if (pool.isBadSocketCreationTime(conn->getSockCreationMicroSec())) {
+            const PoolMap* current = _currentPoolMap();
+            PoolMap::const_iterator it = current->find(PoolKey(hostName, conn->getSoTimeout()));
+            if (it != current->end() &&
+                it->second->isBadSocketCreationTime(conn->getSockCreationMicroSec())) {
                 return false;
             }
         }
@@ -459,15 +523,13 @@ namespace mongo {
         return true;
     }
 
-    void DBConnectionPool::taskDoWork() { 
+    void DBConnectionPool::taskDoWork() {
         vector<DBClientBase*> toDelete;
-        
+
         {
-            // we need to get the connections inside the lock
-            // but we can actually delete them outside
-            scoped_lock lk( _mutex );
-            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                i->second.getStaleConnections( toDelete );
+            const PoolMap* current = _currentPoolMap();
+            for ( PoolMap::const_iterator i=current->begin(); i!=current->end(); ++i ) {
+                i->second->getStaleConnections( toDelete );
             }
         }
 
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <stack>
+#include <vector>
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/client/export_macros.h"
@@ -43,31 +44,24 @@ namespace mongo {
     class DBConnectionPool;
 
     /**
-     * not thread safe
-     * thread safety is handled by DBConnectionPool
+     * thread safe
+     * each host's pool has its own lock, so checkout/checkin traffic to one
+     * host never contends with traffic to another
      */
-    class MONGO_CLIENT_API PoolForHost {
+    class MONGO_CLIENT_API PoolForHost : boost::noncopyable {
     public:
 
         // Sentinel value indicating pool has no cleanup limit
         static const int kPoolSizeUnlimited;
 
         PoolForHost() :
+            _lock("PoolForHost"),
             _created(0),
             _minValidCreationTimeMicroSec(0),
             _type(ConnectionString::INVALID),
             _maxPoolSize(kPoolSizeUnlimited) {
         }
 
-        PoolForHost(const PoolForHost& other) :
-            _created(other._created),
-            _minValidCreationTimeMicroSec(other._minValidCreationTimeMicroSec),
-            _type(other._type),
-            _maxPoolSize(other._maxPoolSize) {
-            verify(_created == 0);
-            verify(other._pool.size() == 0);
-        }
-
         ~PoolForHost();
 
         /**
@@ -80,12 +74,22 @@ namespace mongo {
          */
         void setMaxPoolSize( int maxPoolSize ) { _maxPoolSize = maxPoolSize; }
 
-        int numAvailable() const { return (int)_pool.size(); }
+        int numAvailable() const {
+            SimpleMutex::scoped_lock lk(_lock);
+            return (int)_pool.size();
+        }
 
         void createdOne( DBClientBase * base );
-        long long numCreated() const { return _created; }
+        long long numCreated() const {
+            SimpleMutex::scoped_lock lk(_lock);
+            return _created;
+        }
 
-        ConnectionString::ConnectionType type() const { verify(_created); return _type; }
+        ConnectionString::ConnectionType type() const {
+            SimpleMutex::scoped_lock lk(_lock);
+            verify(_created);
+            return _type;
+        }
 
         /**
          * gets a connection or return NULL
@@ -129,6 +133,11 @@ namespace mongo {
             time_t when;
         };
 
+        void _clear_inlock();
+        void _reportBadConnectionAt_inlock(uint64_t microSec);
+
+        mutable SimpleMutex _lock;
+
         std::string _hostName;
         std::stack<StoredConnection> _pool;
 
@@ -247,7 +256,18 @@ namespace mongo {
             bool operator()( const PoolKey& a , const PoolKey& b ) const;
         };
 
-        typedef std::map<PoolKey,PoolForHost,poolKeyCompare> PoolMap; // servername -> pool
+        typedef std::map<PoolKey,PoolForHost*,poolKeyCompare> PoolMap; // servername -> pool
+
+        /**
+         * Returns the pool for 'key', creating (and publishing) it on first
+         * use of the host.  Only creation takes _mutex; the common case is a
+         * lookup in the published snapshot without any global lock.
+         */
+        PoolForHost* _getPool( const PoolKey& key );
+
+        const PoolMap* _currentPoolMap() const {
+            return reinterpret_cast<const PoolMap*>( _currentPools.load() );
+        }
 
         mongo::mutex _mutex;
         std::string _name;
@@ -257,8 +277,18 @@ namespace mongo {
         // 0 effectively disables the pool
         int _maxPoolSize;
 
+        // master copy, guarded by _mutex; values are heap allocated, never erased
+        // and only freed on shutdown, so a PoolForHost* is safe to use unlocked
         PoolMap _pools;
 
+        // read-only snapshot of _pools; republished (copy on write, under _mutex)
+        // whenever a host is added
+        AtomicWord<uintptr_t> _currentPools;
+
+        // superseded snapshots; a reader may still hold one, so they are retired
+        // here and freed in the destructor rather than deleted on publish
+        std::vector<const PoolMap*> _retiredPools;
+
         // pointers owned by me, right now they leak on shutdown
         // _hooks itself also leaks because it creates a shutdown race condition
         std::list<DBConnectionHook*> * _hooks;
@@ -39,7 +39,9 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/wire_version.h"
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
+#include "mongo/s/write_ops/batched_command_request.h"  // for kMaxWriteBatchSize
 #include "mongo/util/assert_util.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
@@ -975,6 +977,17 @@ namespace mongo {
         return true;
     }
 
+    bool DBClientConnection::negotiateNetworkCompression() {
+        BSONObj info;
+        if ( !simpleCommand( "admin", &info, "networkCompress" ) ) {
+            LOG(1) << "networkCompress not accepted by " << toString() << endl;
+            return false;
+        }
+        // the server compresses its side as soon as it runs the command; turn on ours
+        port().enableCompression();
+        return true;
+    }
+
     void DBClientConnection::logout(const string& dbname, BSONObj& info){
         authCache.erase(dbname);
         runCommand(dbname, BSON("logout" << 1), info);
@@ -1177,6 +1190,14 @@ namespace mongo {
 
     // TODO: Merge with other insert implementation?
     void DBClientBase::insert( const string & ns , const vector< BSONObj > &v , int flags) {
+        if ( !( flags & WriteOption_FromWriteback ) && !v.empty() &&
+             getMaxWireVersion() >= BATCH_COMMANDS ) {
+            // frame the batch as native insert commands, which the server applies
+            // directly instead of parsing and upconverting a legacy OP_INSERT message
+            _insertAsWriteCommand( ns, v, flags );
+            return;
+        }
+
         Message toSend;
 
         BufBuilder b;
@@ -1200,6 +1221,52 @@ namespace mongo {
         say( toSend );
     }
 
+    void DBClientBase::_insertAsWriteCommand( const string& ns, const vector<BSONObj>& v,
+                                              int flags ) {
+        const bool ordered = !( flags & InsertOption_ContinueOnError );
+        const string coll = nsToCollectionSubstring( ns ).toString();
+
+        vector<BSONObj>::const_iterator doc = v.begin();
+        while ( doc != v.end() ) {
+            // Assemble one command frame.  Documents go into the array as raw bytes,
+            // with no per-document rebuild; we split when the next document would
+            // push the frame past the maximum user BSON size, or the batch past the
+            // server's write batch limit.
+            BSONObjBuilder cmd;
+            cmd.append( "insert", coll );
+            {
+                BSONArrayBuilder docs( cmd.subarrayStart( "documents" ) );
+                size_t batchDocs = 0;
+                int batchBytes = 0;
+                while ( doc != v.end() &&
+                        batchDocs < BatchedCommandRequest::kMaxWriteBatchSize &&
+                        ( batchDocs == 0 ||
+                          batchBytes + doc->objsize() <= BSONObjMaxUserSize ) ) {
+                    docs.append( *doc );
+                    batchBytes += doc->objsize();
+                    ++batchDocs;
+                    ++doc;
+                }
+                docs.done();
+            }
+            cmd.append( "ordered", ordered );
+
+            // Like the legacy message path, individual write errors are left for the
+            // caller's getLastError to report -- the server records them in the
+            // connection's last error state.  Only a failure of the command itself
+            // (which the legacy path could not even detect) asserts.
+            BSONObj result;
+            uassert( 18578,
+                     str::stream() << "insert write command failed: " << result.toString(),
+                     runCommand( nsToDatabase( ns ), cmd.obj(), result ) );
+
+            if ( ordered && result.hasField( "writeErrors" ) ) {
+                // an ordered batch stops applying at the first error; don't send the rest
+                return;
+            }
+        }
+    }
+
     void DBClientBase::remove( const string & ns , Query obj , bool justOne ) {
         int flags = 0;
         if( justOne ) flags |= RemoveOption_JustOne;
@@ -1424,6 +1491,10 @@ namespace mongo {
         return false;
     }
 
+    bool DBClientConnection::replyReady() {
+        return p ? p->isDataPending() : true;
+    }
+
     bool DBClientConnection::call( Message &toSend, Message &response, bool assertOk , string * actualServer ) {
         /* todo: this is very ugly messagingport::call returns an error code AND can throw
                  an exception.  we should make it return void and just throw an exception anytime
@@ -820,6 +820,12 @@ namespace {
         }
     }
 
+    bool DBClientReplicaSet::replyReady() {
+        if ( ! _lazyState._lastClient )
+            return true;
+        return _lazyState._lastClient->replyReady();
+    }
+
     void DBClientReplicaSet::checkResponse( const char* data, int nReturned, bool* retry, string* targetHost ){
 
         // For now, do exactly as we did before, so as not to break things.  In general though, we
@@ -121,6 +121,7 @@ namespace mongo {
 
         virtual void say( Message &toSend, bool isRetry = false , std::string* actualServer = 0);
         virtual bool recv( Message &toRecv );
+        virtual bool replyReady();
         virtual void checkResponse( const char* data, int nReturned, bool* retry = NULL, std::string* targetHost = NULL );
 
         /* this is the callback from our underlying connections to notify us that we got a "not master" error.
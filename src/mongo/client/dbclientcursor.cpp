@@ -144,9 +144,40 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::prefetchMore() {
+        verify( cursorId );
+        verify( !_prefetchSent );
+        verify( !haveLimit ); // nToReturn accounting happens in requestMore()
+        verify( _client );
+
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+
+        Message toSend;
+        toSend.setData(dbGetMore, b.buf(), b.len());
+        _client->say( toSend );
+        _prefetchSent = true;
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _prefetchSent ) {
+            // a pipelined getMore is already on the wire; just read its reply
+            verify( _client );
+            auto_ptr<Message> response(new Message());
+            if ( !_client->recv( *response ) ) {
+                uasserted( 18557, "recv failed while reading pipelined getMore reply" );
+            }
+            _prefetchSent = false;
+            batch.m = response;
+            dataReceived();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
@@ -342,6 +373,14 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchSent && _client ) {
+            // drain the pipelined getMore reply so a pooled connection isn't
+            // left with a stray response on it
+            Message response;
+            _client->recv( response );
+            _prefetchSent = false;
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -145,6 +145,18 @@ namespace mongo {
         /// Change batchSize after construction. Can change after requesting first batch.
         void setBatchSize(int newBatchSize) { batchSize = newBatchSize; }
 
+        /**
+         * Sends the next getMore request without waiting for its reply, so that
+         * the next batch is already crossing the wire while the current one is
+         * being consumed.  The reply is picked up by the next requestMore().
+         * Only one pipelined request may be outstanding, the cursor must be
+         * open, and this may not be combined with a limit.
+         */
+        void prefetchMore();
+
+        /** is a pipelined getMore reply outstanding? */
+        bool prefetchInFlight() const { return _prefetchSent; }
+
         DBClientCursor( DBClientBase* client, const std::string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -159,7 +171,8 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetchSent( false ) {
             _finishConsInit();
         }
 
@@ -175,7 +188,8 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetchSent(false) {
             _finishConsInit();
         }
 
@@ -249,6 +263,7 @@ namespace mongo {
         std::string _scopedHost;
         std::string _lazyHost;
         bool wasError;
+        bool _prefetchSent; // a pipelined getMore's reply has not been read yet
 
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
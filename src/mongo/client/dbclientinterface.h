@@ -97,7 +97,14 @@ namespace mongo {
          */
         QueryOption_PartialResults = 1 << 7 ,
 
-        QueryOption_AllSupported = QueryOption_CursorTailable | QueryOption_SlaveOk | QueryOption_OplogReplay | QueryOption_NoCursorTimeout | QueryOption_AwaitData | QueryOption_Exhaust | QueryOption_PartialResults
+        /** The operation is low priority: it takes admission tickets from the low
+            priority share of the pool and yields locks immediately when normal or
+            high priority operations are waiting.  For background/analytics scans
+            colocated with latency sensitive traffic.  Inherited by getMore.
+         */
+        QueryOption_LowPriority = 1 << 8 ,
+
+        QueryOption_AllSupported = QueryOption_CursorTailable | QueryOption_SlaveOk | QueryOption_OplogReplay | QueryOption_NoCursorTimeout | QueryOption_AwaitData | QueryOption_Exhaust | QueryOption_PartialResults | QueryOption_LowPriority
 
     };
 
@@ -556,6 +563,9 @@ namespace mongo {
         virtual void sayPiggyBack( Message &toSend ) = 0;
         /* used by QueryOption_Exhaust.  To use that your subclass must implement this. */
         virtual bool recv( Message& m ) { verify(false); return false; }
+        /** whether a reply to a say() can (probably) be recv()'d without blocking.
+            Conservative: returns true when readiness cannot be determined. */
+        virtual bool replyReady() { return true; }
         // In general, for lazy queries, we'll need to say, recv, then checkResponse
         virtual void checkResponse( const char* data, int nReturned, bool* retry = NULL, std::string* targetHost = NULL ) {
             if( retry ) *retry = false; if( targetHost ) *targetHost = "";
@@ -1096,6 +1106,12 @@ namespace mongo {
         int getMinWireVersion() { return _minWireVersion; }
         int getMaxWireVersion() { return _maxWireVersion; }
 
+        /** ask the server to snappy-compress messages on this connection (both
+            directions, payloads above a size threshold).  only direct connections
+            implement this; elsewhere it is a no-op.
+            @return true if compression was negotiated */
+        virtual bool negotiateNetworkCompression() { return false; }
+
         /** send a query to the database.
          @param ns namespace to query, format is <dbname>.<collectname>[.<collectname>]*
          @param query query to perform on the collection.  this is a BSONObj (binary JSON)
@@ -1148,7 +1164,10 @@ namespace mongo {
         virtual void insert( const std::string &ns , BSONObj obj , int flags=0);
 
         /**
-           insert a vector of objects into the database
+           insert a vector of objects into the database.  When the server speaks the
+           write command protocol, the batch is framed as native 'insert' commands
+           (split at the maximum BSON and batch sizes) instead of a legacy OP_INSERT
+           message that the server would have to upconvert.
          */
         virtual void insert( const std::string &ns, const std::vector< BSONObj >& v , int flags=0);
 
@@ -1190,6 +1209,13 @@ namespace mongo {
             return INVALID_SOCK_CREATION_TIME;
         }
 
+    private:
+        // Assembles native 'insert' write command frames for v and runs them,
+        // splitting at the server's batch size and BSON size limits.  Used by the
+        // vector insert path when the server speaks write commands.
+        void _insertAsWriteCommand( const std::string& ns, const std::vector<BSONObj>& v,
+                                    int flags );
+
     }; // DBClientBase
 
     class DBClientReplicaSet;
@@ -1298,6 +1324,8 @@ namespace mongo {
 
         bool isStillConnected() { return p ? p->isStillConnected() : true; }
 
+        virtual bool negotiateNetworkCompression();
+
         MessagingPort& port() { verify(p); return *p; }
 
         std::string toString() const {
@@ -1314,6 +1342,7 @@ namespace mongo {
         virtual bool callRead( Message& toSend , Message& response ) { return call( toSend , response ); }
         virtual void say( Message &toSend, bool isRetry = false , std::string * actualServer = 0 );
         virtual bool recv( Message& m );
+        virtual bool replyReady();
         virtual void checkResponse( const char *data, int nReturned, bool* retry = NULL, std::string* host = NULL );
         virtual bool call( Message &toSend, Message &response, bool assertOk = true , std::string * actualServer = 0 );
         virtual ConnectionString::ConnectionType type() const { return ConnectionString::MASTER; }
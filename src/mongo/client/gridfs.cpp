@@ -52,6 +52,11 @@ namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 255 * 1024;
 
+    // uploads buffer chunks and send them in multi-document inserts of up to
+    // this many bytes, so storing a large file costs a round trip per batch
+    // rather than per chunk
+    const unsigned MAX_PENDING_CHUNK_BYTES = 8 * 1024 * 1024;
+
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
     }
@@ -95,14 +100,24 @@ namespace mongo {
         BSONObj idObj = BSON("_id" << id);
 
         int chunkNumber = 0;
+        vector<BSONObj> pendingChunks;
+        unsigned pendingBytes = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            pendingChunks.push_back( c._data );
+            pendingBytes += c._data.objsize();
+            if ( pendingBytes >= MAX_PENDING_CHUNK_BYTES ) {
+                _client.insert( _chunksNS.c_str() , pendingChunks );
+                pendingChunks.clear();
+                pendingBytes = 0;
+            }
 
             chunkNumber++;
             data += chunkLen;
         }
+        if ( ! pendingChunks.empty() )
+            _client.insert( _chunksNS.c_str() , pendingChunks );
 
         return insertFile(remoteName, id, length, contentType);
     }
@@ -124,6 +139,8 @@ namespace mongo {
 
         int chunkNumber = 0;
         gridfs_offset length = 0;
+        vector<BSONObj> pendingChunks;
+        unsigned pendingBytes = 0;
         while (!feof(fd)) {
             //boost::scoped_array<char>buf (new char[_chunkSize+1]);
             char * buf = new char[_chunkSize+1];
@@ -138,12 +155,20 @@ namespace mongo {
             }
 
             GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            pendingChunks.push_back( c._data );
+            pendingBytes += c._data.objsize();
+            if ( pendingBytes >= MAX_PENDING_CHUNK_BYTES ) {
+                _client.insert( _chunksNS.c_str() , pendingChunks );
+                pendingChunks.clear();
+                pendingBytes = 0;
+            }
 
             length += chunkLen;
             chunkNumber++;
             delete[] buf;
         }
+        if ( ! pendingChunks.empty() )
+            _client.insert( _chunksNS.c_str() , pendingChunks );
 
         if (fd != stdin)
             fclose( fd );
@@ -239,13 +264,35 @@ namespace mongo {
         return GridFSChunk(o);
     }
 
+    auto_ptr<DBClientCursor> GridFile::getChunkCursor( int startingChunkNumber , int chunksPerBatch ) const {
+        _exists();
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        if ( startingChunkNumber > 0 )
+            b.append( "n" , BSON( "$gte" << startingChunkNumber ) );
+
+        return _grid->_client.query( _grid->_chunksNS.c_str() ,
+                                     Query( b.obj() ).sort( BSON( "n" << 1 ) ) ,
+                                     0 , 0 , 0 , 0 , chunksPerBatch );
+    }
+
     gridfs_offset GridFile::write( ostream & out ) const {
         _exists();
 
         const int num = getNumChunks();
 
+        // stream the chunks through one cursor, so consecutive chunks arrive
+        // in batched getMore responses instead of costing a round trip each
+        auto_ptr<DBClientCursor> cursor = getChunkCursor();
+
         for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+            uassert( 18551 , "chunk is empty!" , cursor->more() );
+
+            // the chunk aliases the cursor's current batch; we write it out
+            // before advancing, so no copy of the payload is ever made
+            BSONObj o = cursor->next();
+            uassert( 18552 , "chunks are out of order" , o["n"].numberInt() == i );
+            GridFSChunk c( o );
 
             int len;
             const char * data = c.data( len );
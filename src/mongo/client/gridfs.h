@@ -52,6 +52,12 @@ namespace mongo {
             return len;
         }
 
+        /**
+         * pointer to the chunk's payload.  The pointer aims into the chunk's
+         * BSON document, so no copy is made; it stays valid only as long as
+         * the underlying buffer does (for chunks read off a cursor, until the
+         * cursor advances to its next batch).
+         */
         const char * data( int & len ) const {
             return _data["data"].binDataClean( len );
         }
@@ -195,6 +201,16 @@ namespace mongo {
 
         GridFSChunk getChunk( int n ) const;
 
+        /**
+         * cursor over this file's chunks in order, starting at chunk
+         * 'startingChunkNumber'.  Consecutive chunks arrive in batched getMore
+         * responses, so streaming a large file costs a round trip per batch
+         * rather than per chunk (as repeated getChunk calls would).  Wrap each
+         * document the cursor returns in GridFSChunk to get at the payload.
+         * @param chunksPerBatch cursor batch size; 0 uses the server default
+         */
+        std::auto_ptr<DBClientCursor> getChunkCursor( int startingChunkNumber = 0 , int chunksPerBatch = 0 ) const;
+
         /**
            write the file to the output stream
          */
@@ -260,6 +260,123 @@ namespace mongo {
         _done = true;
     }
 
+    // --------  SortedMergeTree -----------
+
+    /**
+     * Tournament tree over the shard streams of a sorted cluster query.
+     * Picking the next document is O(log #shards) comparisons instead of a
+     * scan of every stream, and each document's sort key is decoded (dotted
+     * field extraction, missing -> null) exactly once when the document is
+     * peeked, not once per comparison.
+     *
+     * Layout: _node[_width + i] is the leaf for stream i and holds i while
+     * the stream has data, -1 once it is exhausted; internal node p holds the
+     * winner of its two children, so _node[1] is the overall winner.  After
+     * the winner's head is consumed only its root path is replayed.
+     *
+     * Comparison semantics match BSONObj::woSortOrder(..., useDotted=true) on
+     * the full documents; ties between streams go to the lower stream index.
+     */
+    class SortedMergeTree {
+    public:
+        SortedMergeTree( FilteringClientCursor* cursors, int n, const BSONObj& sortKey )
+            : _cursors( cursors ), _n( n ), _sortKey( sortKey ) {
+
+            _width = 1;
+            while ( _width < _n )
+                _width <<= 1;
+
+            _keys.resize( _n );
+            _node.resize( 2 * _width, -1 );
+
+            for ( int i = 0; i < _n; i++ ) {
+                _node[_width + i] = i;
+                _decodeKey( i );
+            }
+            for ( int p = _width - 1; p >= 1; p-- )
+                _node[p] = _better( _node[2 * p], _node[2 * p + 1] );
+        }
+
+        /**
+         * Stream holding the smallest current document, -1 when all streams
+         * are exhausted.
+         */
+        int winner() const { return _node[1]; }
+
+        /**
+         * Call after consuming the winner's head document: re-peeks that
+         * stream and replays its path to the root.
+         */
+        void advanceWinner() {
+            const int idx = _node[1];
+            verify( idx >= 0 );
+            _decodeKey( idx );
+            for ( int p = ( _width + idx ) / 2; p >= 1; p /= 2 )
+                _node[p] = _better( _node[2 * p], _node[2 * p + 1] );
+        }
+
+    private:
+        // Caches stream idx's decoded sort key, or retires its leaf when the
+        // stream is exhausted.
+        void _decodeKey( int idx ) {
+            if ( ! _cursors[idx].more() ) {
+                if ( _cursors[idx].rawMData() )
+                    _cursors[idx].rawMData()->pcState->done = true;
+                _keys[idx] = BSONObj();
+                _node[_width + idx] = -1;
+                return;
+            }
+
+            BSONObj doc = _cursors[idx].peek();
+            BSONObjBuilder b;
+            BSONObjIterator s( _sortKey );
+            while ( s.more() ) {
+                BSONElement f = s.next();
+                BSONElement e = doc.getFieldDotted( f.fieldName() );
+                if ( e.eoo() )
+                    b.appendNull( "" );
+                else
+                    b.appendAs( e, "" );
+            }
+            // owns its data, so it stays valid across the stream's batches
+            _keys[idx] = b.obj();
+        }
+
+        // one element per sort field, same order as _sortKey
+        int _compareKeys( const BSONObj& l, const BSONObj& r ) const {
+            BSONObjIterator li( l );
+            BSONObjIterator ri( r );
+            BSONObjIterator si( _sortKey );
+            while ( si.more() ) {
+                BSONElement f = si.next();
+                int x = li.next().woCompare( ri.next(), false );
+                if ( f.number() < 0 )
+                    x = -x;
+                if ( x != 0 )
+                    return x;
+            }
+            return 0;
+        }
+
+        int _better( int a, int b ) const {
+            if ( a < 0 )
+                return b;
+            if ( b < 0 )
+                return a;
+            const int x = _compareKeys( _keys[a], _keys[b] );
+            if ( x != 0 )
+                return x < 0 ? a : b;
+            return a < b ? a : b;
+        }
+
+        FilteringClientCursor* _cursors;  // not owned
+        int _n;
+        int _width;                       // #leaves, power of two >= _n
+        BSONObj _sortKey;
+        std::vector<BSONObj> _keys;       // decoded key of each stream's head
+        std::vector<int> _node;
+    };
+
     // --------  ParallelSortClusteredCursor -----------
 
     ParallelSortClusteredCursor::ParallelSortClusteredCursor( const QuerySpec& qSpec, const CommandInfo& cInfo )
@@ -916,7 +1033,31 @@ namespace mongo {
 
         LOG( pc ) << "finishing over " << _cursorMap.size() << " shards" << endl;
 
-        for( map< Shard, PCMData >::iterator i = _cursorMap.begin(), end = _cursorMap.end(); i != end; ++i ){
+        // Collect replies in readiness order: all the queries are already in flight from
+        // startInit(), so drain the shards that have responded before blocking on the slow
+        // ones.  A slow or hung shard then delays only its own recv, not our processing
+        // (and potential retrying) of every shard that sorts after it.
+        typedef map< Shard, PCMData >::iterator PCMDataIter;
+        vector<PCMDataIter> finishOrder;
+        {
+            vector<PCMDataIter> notReady;
+            for( PCMDataIter i = _cursorMap.begin(), end = _cursorMap.end(); i != end; ++i ){
+                PCMData& mdata = i->second;
+                if( mdata.pcState && ! mdata.finished && mdata.pcState->conn &&
+                    ! mdata.pcState->conn->get()->replyReady() ){
+                    notReady.push_back( i );
+                }
+                else {
+                    finishOrder.push_back( i );
+                }
+            }
+            finishOrder.insert( finishOrder.end(), notReady.begin(), notReady.end() );
+        }
+
+        for( vector<PCMDataIter>::const_iterator fi = finishOrder.begin(), fiEnd = finishOrder.end();
+             fi != fiEnd; ++fi ){
+
+            const map< Shard, PCMData >::iterator& i = *fi;
 
             const Shard& shard = i->first;
             PCMData& mdata = i->second;
@@ -1092,6 +1233,7 @@ namespace mongo {
 
         // LEGACY STUFF NOW
 
+        _mergeTree.reset();
         _cursors = new FilteringClientCursor[ _cursorMap.size() ];
 
         // Put the cursors in the legacy format
@@ -1191,6 +1333,7 @@ namespace mongo {
 
         // make sure we're not already initialized
         verify( ! _cursors );
+        _mergeTree.reset();
         _cursors = new FilteringClientCursor[_numServers];
 
         bool returnPartial = ( _options & QueryOption_PartialResults );
@@ -1454,6 +1597,7 @@ namespace mongo {
             for( int i = 0; i < _numServers; i++ ) _cursors[i].release();
         }
 
+        _mergeTree.reset();  // holds a pointer into _cursors
         delete [] _cursors;
         _cursors = 0;
 
@@ -1486,6 +1630,23 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+        if ( ! _sortKey.isEmpty() ) {
+            if ( ! _mergeTree )
+                _mergeTree.reset( new SortedMergeTree( _cursors, _numServers, _sortKey ) );
+
+            const int bestFrom = _mergeTree->winner();
+            uassert( 10019 ,  "no more elements" , bestFrom >= 0 );
+
+            BSONObj best = _cursors[bestFrom].next();
+
+            if( _cursors[bestFrom].rawMData() )
+                _cursors[bestFrom].rawMData()->pcState->count++;
+
+            _mergeTree->advanceWinner();
+            _lastFrom = bestFrom;
+            return best;
+        }
+
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
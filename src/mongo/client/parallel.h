@@ -80,6 +80,7 @@ namespace mongo {
 
     class ParallelConnectionMetadata;
     class FilteringClientCursor;
+    class SortedMergeTree;
 
     class MONGO_CLIENT_API CommandInfo {
     public:
@@ -263,6 +264,12 @@ namespace mongo {
         BSONObj _sortKey;
 
         FilteringClientCursor * _cursors;
+
+        // Tournament tree over _cursors for sorted queries; built lazily on
+        // the first next() and reset whenever _cursors is reallocated.
+        // See SortedMergeTree in parallel.cpp.
+        scoped_ptr<SortedMergeTree> _mergeTree;
+
         int _needToSkip;
 
         /**
@@ -96,7 +96,8 @@ namespace {
         ReplicaSetMonitorWatcher():
             _monitorMutex("ReplicaSetMonitorWatcher::_safego"),
             _started(false),
-            _stopRequested(false) {
+            _stopRequested(false),
+            _checkRequested(false) {
         }
 
         ~ReplicaSetMonitorWatcher() {
@@ -132,6 +133,20 @@ namespace {
             _stopRequestedCV.notify_one();
         }
 
+        /**
+         * Requests a scan of all sets now rather than waiting out the rest of the
+         * polling interval.  Called when a client reports the primary down, so a
+         * stepdown propagates to our view in milliseconds instead of up to a full
+         * polling interval.
+         */
+        void expediteCheck() {
+            scoped_lock sl( _monitorMutex );
+            if ( !_started )
+                return;
+            _checkRequested = true;
+            _stopRequestedCV.notify_one();
+        }
+
     protected:
         void run() {
             log() << "starting"; // includes thread name in output
@@ -169,7 +184,11 @@ namespace {
                     break;
                 }
 
-                _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
+                // an expedited check requested while we were scanning skips the wait
+                if (!_checkRequested) {
+                    _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
+                }
+                _checkRequested = false;
             }
         }
 
@@ -199,12 +218,13 @@ namespace {
             }
         }
 
-        // protects _started, _stopRequested
+        // protects _started, _stopRequested, _checkRequested
         mongo::mutex _monitorMutex;
         bool _started;
 
         boost::condition _stopRequestedCV;
         bool _stopRequested;
+        bool _checkRequested;
     } replicaSetMonitorWatcher;
 
     StaticObserver staticObserver;
@@ -308,11 +328,21 @@ namespace {
     }
 
     void ReplicaSetMonitor::failedHost(const HostAndPort& host) {
-        boost::mutex::scoped_lock lk(_state->mutex);
-        Node* node = _state->findNode(host);
-        if (node)
-            node->markFailed();
-        DEV _state->checkInvariants();
+        bool wasMaster = false;
+        {
+            boost::mutex::scoped_lock lk(_state->mutex);
+            Node* node = _state->findNode(host);
+            if (node) {
+                wasMaster = node->isMaster;
+                node->markFailed();
+            }
+            DEV _state->checkInvariants();
+        }
+
+        // A down primary blocks every write routed through us until a scan notices;
+        // don't sit out the rest of the polling interval.
+        if (wasMaster)
+            replicaSetMonitorWatcher.expediteCheck();
     }
 
     bool ReplicaSetMonitor::isPrimary(const HostAndPort& host) const {
@@ -0,0 +1,230 @@
+// btree_verify.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/btree_verify.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/index/btree_index_cursor.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/structure/btree/bucket_verification.h"
+#include "mongo/util/background.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER( btreeVerifySweepEnabled, bool, true );
+
+    // Pause between chunks; together with the chunk size this bounds how much
+    // foreground interference one index sweep can cause.
+    MONGO_EXPORT_SERVER_PARAMETER( btreeVerifySweepDelayMillis, int, 20 );
+
+    /**
+     * Completes the bucket verification that journal recovery armed (see
+     * db/structure/btree/bucket_verification.h).  Every bucket access already verifies
+     * lazily; this job simply walks each index with a cursor so that every bucket gets
+     * accessed -- and therefore checked -- soon after startup, instead of whenever the
+     * workload happens to touch it.  The walk is chunked: it holds the database read
+     * lock for a bounded number of entries at a time, at low admission priority, and
+     * resumes by key so nothing pins btree state across lock drops.
+     */
+    class BtreeVerifyJob : public BackgroundJob {
+    public:
+        BtreeVerifyJob() {}
+        virtual ~BtreeVerifyJob() {}
+
+        virtual string name() const { return "BtreeVerifyJob"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            // let the rest of startup (repl init, index builds in progress, ...) get
+            // going before generating background read load
+            sleepsecs( 10 );
+
+            while ( !inShutdown() && btreeVerificationActive() && !btreeVerifySweepEnabled ) {
+                sleepsecs( 10 );
+            }
+
+            if ( inShutdown() || !btreeVerificationActive() ) {
+                cc().shutdown();
+                return;
+            }
+
+            log() << "btree verify: starting post-recovery sweep" << endl;
+            Timer timer;
+
+            set<string> dbs;
+            {
+                OperationContextImpl txn;   // XXX?
+                Lock::DBRead lk(txn.lockState(), "local");
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            for ( set<string>::const_iterator i = dbs.begin();
+                  i != dbs.end() && !inShutdown(); ++i ) {
+                try {
+                    sweepDB( *i );
+                }
+                catch ( DBException& e ) {
+                    error() << "btree verify: error sweeping db: " << *i << " " << e << endl;
+                }
+            }
+
+            if ( !inShutdown() ) {
+                clearBtreeVerificationNeeded();
+                log() << "btree verify: sweep done in " << timer.seconds() << "s, "
+                      << btreeBucketsVerified.load() << " buckets verified, "
+                      << btreeBucketsCorrupt.load() << " corrupt" << endl;
+            }
+
+            cc().shutdown();
+        }
+
+    private:
+        void sweepDB( const string& dbName ) {
+            vector<BSONObj> indexes;
+            {
+                auto_ptr<DBClientCursor> cursor =
+                                db.query( dbName + ".system.indexes", BSONObj() );
+                if ( cursor.get() ) {
+                    while ( cursor->more() ) {
+                        indexes.push_back( cursor->next().getOwned() );
+                    }
+                }
+            }
+
+            for ( unsigned i = 0; i < indexes.size() && !inShutdown(); i++ ) {
+                try {
+                    sweepIndex( indexes[i]["ns"].String(), indexes[i]["name"].String() );
+                }
+                catch ( DBException& e ) {
+                    error() << "btree verify: error sweeping index: " << indexes[i]
+                            << " " << e << endl;
+                }
+            }
+        }
+
+        void sweepIndex( const string& ns, const string& indexName ) {
+            BSONObj resumeKey;
+            bool exhausted = false;
+
+            while ( !exhausted && !inShutdown() && btreeVerificationActive() ) {
+                {
+                    OperationContextImpl txn;
+
+                    // compete only for the low-priority slice of the read ticket pool
+                    Lock::ScopedAdmissionPriority lowPriority( txn.lockState(), -1 );
+
+                    Client::ReadContext ctx( &txn, ns );
+                    Collection* collection = ctx.ctx().db()->getCollection( &txn, ns );
+                    if ( !collection ) {
+                        // collection was dropped
+                        return;
+                    }
+
+                    IndexDescriptor* desc =
+                        collection->getIndexCatalog()->findIndexByName( indexName );
+                    if ( !desc ) {
+                        // index was dropped (or isn't finished; it'll be checked as
+                        // the build reads it)
+                        return;
+                    }
+                    IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( desc );
+
+                    CursorOptions opts;
+                    opts.direction = CursorOptions::INCREASING;
+                    opts.numWanted = 0;
+                    IndexCursor* rawCursor;
+                    if ( !iam->newCursor( opts, &rawCursor ).isOK() ) {
+                        return;
+                    }
+                    scoped_ptr<IndexCursor> cursor( rawCursor );
+
+                    // every access method in this tree is btree backed and hands out
+                    // BtreeIndexCursors, which is what gives us key-based resume
+                    BtreeIndexCursor* btreeCursor = static_cast<BtreeIndexCursor*>( cursor.get() );
+
+                    if ( resumeKey.isEmpty() ) {
+                        btreeCursor->seek( minKeyForPattern( desc->keyPattern() ), false );
+                    }
+                    else {
+                        // resuming after the last key seen skips any entries equal to
+                        // it that we hadn't reached yet; their buckets stay covered by
+                        // the lazy first-access check, so that only trims the sweep,
+                        // never correctness
+                        btreeCursor->seek( resumeKey, true );
+                    }
+
+                    // each bucket this walk touches goes through BtreeLogic::getBucket()
+                    // and is verified there
+                    for ( int k = 0; k < kEntriesPerChunk && !cursor->isEOF(); k++ ) {
+                        resumeKey = cursor->getKey().getOwned();
+                        cursor->next();
+                    }
+                    exhausted = cursor->isEOF();
+                }
+
+                if ( !exhausted ) {
+                    sleepmillis( btreeVerifySweepDelayMillis );
+                }
+            }
+        }
+
+        static BSONObj minKeyForPattern( const BSONObj& keyPattern ) {
+            BSONObjBuilder b;
+            BSONObjIterator it( keyPattern );
+            while ( it.more() ) {
+                it.next();
+                b.appendMinKey( "" );
+            }
+            return b.obj();
+        }
+
+        static const int kEntriesPerChunk = 1000;
+
+        DBDirectClient db;
+    };
+
+    void startBtreeVerifyJob() {
+        if ( !btreeVerificationActive() )
+            return;
+        BtreeVerifyJob* job = new BtreeVerifyJob();
+        job->go();
+    }
+}
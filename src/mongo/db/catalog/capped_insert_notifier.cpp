@@ -0,0 +1,114 @@
+// capped_insert_notifier.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/catalog/capped_insert_notifier.h"
+
+#include <boost/thread/condition.hpp>
+#include <map>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    namespace {
+
+        // How many namespaces have registered with the notifier.  Lets the insert path
+        // skip everything below when no getMore has ever consulted us, which is the
+        // common case and includes every oplog write on a non-tailed server.
+        AtomicWord<int> numRegistered(0);
+
+        // Guards the version map.  The condvar is broadcast on any notified insert and
+        // each waiter re-checks its own namespace's version; a broadcast waking the odd
+        // waiter on another capped collection is cheap, and a condvar per namespace isn't
+        // worth the lifetime bookkeeping for a few hundred tailers.
+        mutex cappedNotifierMutex("cappedInsertNotifier");
+        boost::condition cappedNotifierCondition;
+
+        // ns -> number of notified inserts.  Entries are created by insertVersion() and
+        // never removed; one small counter per namespace ever tailed.
+        typedef std::map<std::string, unsigned long long> VersionMap;
+        VersionMap& versions() {
+            static VersionMap map;
+            return map;
+        }
+
+    }  // namespace
+
+    unsigned long long CappedInsertNotifier::insertVersion(const std::string& ns) {
+        mutex::scoped_lock lk(cappedNotifierMutex);
+        VersionMap::iterator it = versions().find(ns);
+        if (it == versions().end()) {
+            it = versions().insert(std::make_pair(ns, 1ULL)).first;
+            numRegistered.fetchAndAdd(1);
+        }
+        return it->second;
+    }
+
+    bool CappedInsertNotifier::waitForInsert(const std::string& ns,
+                                             unsigned long long version,
+                                             unsigned timeoutMillis) {
+        mutex::scoped_lock lk(cappedNotifierMutex);
+        const unsigned long long& current = versions()[ns];
+
+        Timer t;
+        while (current == version) {
+            // Broadcasts for other namespaces wake us spuriously; wait only for the
+            // remainder of the timeout so the caller gets control back on schedule.
+            unsigned elapsed = static_cast<unsigned>(t.millis());
+            if (elapsed >= timeoutMillis) {
+                return false;
+            }
+            if (!cappedNotifierCondition.timed_wait(
+                    lk.boost(),
+                    boost::posix_time::milliseconds(timeoutMillis - elapsed))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void CappedInsertNotifier::notifyAll(const std::string& ns) {
+        if (0 == numRegistered.load()) {
+            return;
+        }
+
+        mutex::scoped_lock lk(cappedNotifierMutex);
+        VersionMap::iterator it = versions().find(ns);
+        if (it == versions().end()) {
+            // Nobody has ever tailed this namespace.
+            return;
+        }
+        it->second++;
+        cappedNotifierCondition.notify_all();
+    }
+
+}  // namespace mongo
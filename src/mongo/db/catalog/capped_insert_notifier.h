@@ -0,0 +1,72 @@
+// capped_insert_notifier.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+namespace mongo {
+
+    /**
+     * Lets awaitData getMores on tailable capped-collection cursors block until a new
+     * insert arrives instead of poll-sleeping.
+     *
+     * Usage on the cursor side: call insertVersion(ns) BEFORE running the query, then if
+     * the query came up empty, waitForInsert(ns, version, timeout).  Snapshotting first
+     * closes the race with an insert that lands between the empty read and the wait.
+     *
+     * Inserts into capped collections nobody has ever run a getMore against pay a single
+     * atomic load.
+     */
+    class CappedInsertNotifier {
+    public:
+        /**
+         * Returns the current insert version for 'ns', registering the namespace with the
+         * notifier if needed (after which inserts into it bump the version).
+         */
+        static unsigned long long insertVersion(const std::string& ns);
+
+        /**
+         * Blocks until the insert version for 'ns' differs from 'version' or
+         * 'timeoutMillis' elapses.  Returns true if an insert was signaled, false on
+         * timeout.  Must not be called while holding locks.
+         */
+        static bool waitForInsert(const std::string& ns,
+                                  unsigned long long version,
+                                  unsigned timeoutMillis);
+
+        /**
+         * Called by the inserting thread after a successful insert into the capped
+         * collection 'ns'.
+         */
+        static void notifyAll(const std::string& ns);
+    };
+
+}  // namespace mongo
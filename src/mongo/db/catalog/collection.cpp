@@ -32,16 +32,22 @@
 
 #include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_map.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/concurrency/lock_mgr.h"
+#include "mongo/db/d_concurrency.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/field_ref.h"
+#include "mongo/db/field_ref_set.h"
+#include "mongo/db/index_set.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/structure/record_store_v1_capped.h"
+#include "mongo/db/structure/record_store_v1_simple.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 
 #include "mongo/db/auth/user_document_parser.h" // XXX-ANDY
@@ -161,6 +167,9 @@ namespace mongo {
         if ( !loc.isOK() )
             return loc;
 
+        if ( isCapped() )
+            CappedInsertNotifier::notifyAll( _ns.ns() );
+
         return StatusWith<DiskLoc>( loc );
     }
 
@@ -242,21 +251,100 @@ namespace mongo {
             return StatusWith<DiskLoc>( e.toStatus( "insertDocument" ) );
         }
 
+        // Wake any tailable cursors blocked waiting for data.
+        if ( isCapped() )
+            CappedInsertNotifier::notifyAll( _ns.ns() );
+
         return loc;
     }
 
+    void Collection::insertDocuments( OperationContext* txn,
+                                      const std::vector<BSONObj>& docs,
+                                      bool enforceQuota,
+                                      std::vector< StatusWith<DiskLoc> >* results ) {
+        results->clear();
+
+        // Capped collections interleave deletes with inserts and check index conflicts up
+        // front, so they keep the document-at-a-time path; so does a batch of one.
+        if ( isCapped() || docs.size() == 1 ) {
+            for ( size_t i = 0; i < docs.size(); i++ ) {
+                results->push_back( insertDocument( txn, docs[i], enforceQuota ) );
+            }
+            return;
+        }
+
+        const bool hasIdIndex = _indexCatalog.findIdIndex() != NULL;
+
+        // Phase 1: place every document in the record store.
+        std::vector< std::pair<BSONObj, DiskLoc> > records;
+        std::vector<size_t> recordSlots; // index into 'results' for each entry of 'records'
+        for ( size_t i = 0; i < docs.size(); i++ ) {
+            const BSONObj& doc = docs[i];
+
+            if ( hasIdIndex && doc["_id"].eoo() ) {
+                results->push_back( StatusWith<DiskLoc>(
+                                        ErrorCodes::InternalError,
+                                        str::stream() << "Collection::insertDocuments got "
+                                        "document without _id for ns:" << _ns.ns() ) );
+                continue;
+            }
+
+            StatusWith<DiskLoc> loc = _recordStore->insertRecord(
+                txn, doc.objdata(), doc.objsize(),
+                enforceQuota ? largestFileNumberInQuota() : 0 );
+            results->push_back( loc );
+            if ( loc.isOK() ) {
+                records.push_back( std::make_pair( doc, loc.getValue() ) );
+                recordSlots.push_back( i );
+            }
+        }
+
+        _infoCache.notifyOfWriteOp();
+
+        if ( records.empty() )
+            return;
+
+        // Phase 2: maintain all indexes across the batch; any document whose keys could
+        // not all be added has already had its keys rolled back, we just delete its record.
+        std::vector<Status> indexStatuses;
+        _indexCatalog.indexRecords( txn, records, &indexStatuses );
+
+        for ( size_t i = 0; i < records.size(); i++ ) {
+            if ( indexStatuses[i].isOK() )
+                continue;
+            _recordStore->deleteRecord( txn, records[i].second );
+            (*results)[recordSlots[i]] = StatusWith<DiskLoc>( indexStatuses[i] );
+        }
+    }
+
     Status Collection::aboutToDeleteCapped( OperationContext* txn, const DiskLoc& loc ) {
 
         BSONObj doc = docFor( loc );
 
         /* check if any cursors point to us.  if so, advance them. */
-        _cursorCache.invalidateDocument(loc, INVALIDATION_DELETION);
+        if ( _cursorCache.hasRegistered() )
+            _cursorCache.invalidateDocument(loc, INVALIDATION_DELETION);
 
         _indexCatalog.unindexRecord(txn, doc, loc, false);
 
         return Status::OK();
     }
 
+    Status Collection::aboutToDeleteCappedBatch( OperationContext* txn,
+                                                 const std::vector<DiskLoc>& locs ) {
+
+        // one cursor-invalidation pass for the whole wraparound batch, skipped outright
+        // when nothing is registered to read us
+        if ( _cursorCache.hasRegistered() )
+            _cursorCache.invalidateDocuments( locs, INVALIDATION_DELETION );
+
+        for ( size_t i = 0; i < locs.size(); i++ ) {
+            _indexCatalog.unindexRecord( txn, docFor( locs[i] ), locs[i], false );
+        }
+
+        return Status::OK();
+    }
+
     void Collection::deleteDocument( OperationContext* txn,
                                      const DiskLoc& loc,
                                      bool cappedOK,
@@ -290,11 +378,36 @@ namespace mongo {
     Counter64 moveCounter;
     ServerStatusMetricField<Counter64> moveCounterDisplay( "record.moves", &moveCounter );
 
+    namespace {
+        /**
+         * Could an update restricted to 'updatedFields' change any key generated from
+         * 'keyPattern'?  Uses the same path canonicalization as
+         * CollectionInfoCache::indexKeys() and UpdateDriver::modsAffectIndices -- positional
+         * and numeric components are treated as array traversals, so a mod to "a.0.b"
+         * affects an index on "a.b".
+         */
+        bool updateAffectsIndex( const BSONObj& keyPattern, const FieldRefSet& updatedFields ) {
+            IndexPathSet indexPaths;
+            BSONObjIterator it( keyPattern );
+            while ( it.more() )
+                indexPaths.addPath( it.next().fieldName() );
+
+            for ( FieldRefSet::const_iterator i = updatedFields.begin();
+                  i != updatedFields.end();
+                  ++i ) {
+                if ( indexPaths.mightBeIndexed( (*i)->dottedField() ) )
+                    return true;
+            }
+            return false;
+        }
+    }
+
     StatusWith<DiskLoc> Collection::updateDocument( OperationContext* txn,
                                                     const DiskLoc& oldLocation,
                                                     const BSONObj& objNew,
                                                     bool enforceQuota,
-                                                    OpDebug* debug ) {
+                                                    OpDebug* debug,
+                                                    const FieldRefSet* updatedFields ) {
 
         BSONObj objOld = _recordStore->dataFor( oldLocation ).toBson();
 
@@ -322,6 +435,15 @@ namespace mongo {
         IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator( true );
         while ( ii.more() ) {
             IndexDescriptor* descriptor = ii.next();
+
+            if ( updatedFields && !updateAffectsIndex( descriptor->keyPattern(), *updatedFields ) ) {
+                // None of the modified paths can appear in this index's keys, so the old
+                // and new keys are identical -- skip key generation for it entirely.  If
+                // the document ends up moving, the move path below reindexes everything
+                // and never consults the tickets.
+                continue;
+            }
+
             IndexAccessMethod* iam = _indexCatalog.getIndex( descriptor );
 
             InsertDeleteOptions options;
@@ -371,10 +493,18 @@ namespace mongo {
         ii = _indexCatalog.getIndexIterator( true );
         while ( ii.more() ) {
             IndexDescriptor* descriptor = ii.next();
+
+            std::map<IndexDescriptor*,UpdateTicket*>::const_iterator ticket =
+                updateTickets.mutableMap().find( descriptor );
+            if ( ticket == updateTickets.mutableMap().end() ) {
+                // skipped above -- this index is unaffected by the update
+                continue;
+            }
+
             IndexAccessMethod* iam = _indexCatalog.getIndex( descriptor );
 
             int64_t updatedKeys;
-            Status ret = iam->update(txn, *updateTickets.mutableMap()[descriptor], &updatedKeys);
+            Status ret = iam->update(txn, *ticket->second, &updatedKeys);
             if ( !ret.isOK() )
                 return StatusWith<DiskLoc>( ret );
             if ( debug )
@@ -477,6 +607,127 @@ namespace mongo {
         return Status::OK();
     }
 
+    StatusWith<long long> Collection::truncateExpiredHeadExtent( OperationContext* txn,
+                                                                 Date_t cutoff ) {
+        if ( isCapped() )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "cannot expire extents of a capped collection" );
+
+        // freeing an extent does not touch indexes, so refuse if any exist
+        if ( _indexCatalog.numIndexesTotal() > 0 )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "cannot expire extents of an indexed collection" );
+
+        SimpleRecordStoreV1* rs = dynamic_cast<SimpleRecordStoreV1*>( _recordStore );
+        if ( !rs )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "record store does not support extent expiry" );
+
+        DiskLoc newest;
+        if ( !rs->headExtentNewestRecord( &newest ) )
+            return StatusWith<long long>( 0 ); // fewer than two extents, nothing to free
+
+        if ( !newest.isNull() ) {
+            // the head extent expires when its newest document does; documents are
+            // dated by their _id ObjectId, so insertion order is assumed
+            BSONElement id = docFor( newest )["_id"];
+            if ( id.type() != jstOID )
+                return StatusWith<long long>( ErrorCodes::BadValue,
+                                              "document without ObjectId _id in "
+                                              "time-partitioned collection" );
+            if ( id.OID().asDateT() >= cutoff )
+                return StatusWith<long long>( 0 ); // not expired yet
+        }
+
+        StatusWith<long long> res = rs->truncateHeadExtent( txn );
+        if ( res.isOK() ) {
+            _cursorCache.invalidateAll( false );
+            _infoCache.reset();
+        }
+        return res;
+    }
+
+    StatusWith<long long> Collection::compactHeadExtentStep( OperationContext* txn,
+                                                             long long maxMoves,
+                                                             bool* extentFreed,
+                                                             bool* done ) {
+        *extentFreed = false;
+        *done = false;
+
+        if ( isCapped() )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "cannot compact a capped collection" );
+
+        SimpleRecordStoreV1* rs = dynamic_cast<SimpleRecordStoreV1*>( _recordStore );
+        if ( !rs )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "record store does not support "
+                                          "incremental compaction" );
+
+        {
+            DiskLoc unused;
+            if ( !rs->headExtentNewestRecord( &unused ) ) {
+                // fewer than two extents; nothing left to reclaim
+                *done = true;
+                return StatusWith<long long>( 0 );
+            }
+        }
+
+        Status drainStatus = rs->beginHeadExtentDrain( txn );
+        if ( !drainStatus.isOK() )
+            return StatusWith<long long>( drainStatus );
+
+        long long moved = 0;
+        while ( moved < maxMoves ) {
+            const DiskLoc oldLoc = rs->drainExtentFirstRecord();
+            if ( oldLoc.isNull() )
+                break;
+
+            const BSONObj doc = docFor( oldLoc ).getOwned();
+
+            // same order as RecordStoreV1Base::updateRecord's move path: land the
+            // copy before unhooking the original, so a failure cannot lose the
+            // document; the drain state keeps the copy out of this extent
+            StatusWith<DiskLoc> newLoc = _recordStore->insertRecord( txn,
+                                                                     doc.objdata(),
+                                                                     doc.objsize(),
+                                                                     largestFileNumberInQuota() );
+            if ( !newLoc.isOK() )
+                return StatusWith<long long>( newLoc.getStatus() );
+
+            _cursorCache.invalidateDocument( oldLoc, INVALIDATION_DELETION );
+            _indexCatalog.unindexRecord( txn, doc, oldLoc, true );
+            _recordStore->deleteRecord( txn, oldLoc );
+            _indexCatalog.indexRecord( txn, doc, newLoc.getValue() );
+
+            moved++;
+
+            // cede the database lock promptly when someone is queued behind it
+            if ( Lock::othersWaitingForLocksHeld( txn->lockState() ) > 0 )
+                break;
+        }
+
+        if ( moved > 0 )
+            _infoCache.notifyOfWriteOp();
+
+        if ( rs->drainExtentFirstRecord().isNull() ) {
+            StatusWith<long long> res = rs->truncateHeadExtent( txn );
+            if ( !res.isOK() )
+                return res;
+            rs->endHeadExtentDrain();
+            *extentFreed = true;
+            _cursorCache.invalidateAll( false );
+            _infoCache.reset();
+
+            DiskLoc unused;
+            *done = !rs->headExtentNewestRecord( &unused );
+        }
+
+        txn->recoveryUnit()->commitIfNeeded();
+
+        return StatusWith<long long>( moved );
+    }
+
     void Collection::temp_cappedTruncateAfter(OperationContext* txn,
                                               DiskLoc end,
                                               bool inclusive) {
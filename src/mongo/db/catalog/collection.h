@@ -49,6 +49,7 @@ namespace mongo {
     class CollectionCatalogEntry;
     class Database;
     class ExtentManager;
+    class FieldRefSet;
     class IndexCatalog;
     class MultiIndexBlock;
     class OperationContext;
@@ -170,6 +171,17 @@ namespace mongo {
                                             const BSONObj& doc,
                                             bool enforceQuota );
 
+        /**
+         * Inserts a batch of documents, maintaining all indexes batch-at-a-time (see
+         * IndexCatalog::indexRecords()).  Like insertDocument, does NOT modify the docs.
+         * 'results' gets one entry per document; a document that fails is removed from
+         * the record store again and the remaining documents still get inserted.
+         */
+        void insertDocuments( OperationContext* txn,
+                              const std::vector<BSONObj>& docs,
+                              bool enforceQuota,
+                              std::vector< StatusWith<DiskLoc> >* results );
+
         StatusWith<DiskLoc> insertDocument( OperationContext* txn,
                                             const DocWriter* doc,
                                             bool enforceQuota );
@@ -182,13 +194,18 @@ namespace mongo {
          * updates the document @ oldLocation with newDoc
          * if the document fits in the old space, it is put there
          * if not, it is moved
+         * @param updatedFields if non-NULL, the complete set of dotted paths the update
+         *        modified; indexes whose key patterns cannot overlap those paths skip key
+         *        generation entirely.  Pass NULL for replacement-style updates (or whenever
+         *        the set of changed paths is unknown) to update every index.
          * @return the post update location of the doc (may or may not be the same as oldLocation)
          */
         StatusWith<DiskLoc> updateDocument( OperationContext* txn,
                                             const DiskLoc& oldLocation,
                                             const BSONObj& newDoc,
                                             bool enforceQuota,
-                                            OpDebug* debug );
+                                            OpDebug* debug,
+                                            const FieldRefSet* updatedFields = NULL );
 
         /**
          * right now not allowed to modify indexes
@@ -209,6 +226,35 @@ namespace mongo {
          */
         Status truncate(OperationContext* txn);
 
+        /**
+         * For collections created with timePartitionExpireSeconds: frees the
+         * oldest extent wholesale if every document in it is older than 'cutoff',
+         * judged by the _id ObjectId time of the extent's newest record.  Only
+         * valid on unindexed, uncapped collections backed by SimpleRecordStoreV1.
+         * @return the number of documents removed; 0 if the oldest extent has
+         *         not expired yet (call again after more data arrives)
+         */
+        StatusWith<long long> truncateExpiredHeadExtent( OperationContext* txn, Date_t cutoff );
+
+        /**
+         * One slice of online, incremental compaction: moves up to 'maxMoves'
+         * documents out of the oldest extent -- copy inserted first, original
+         * unindexed and deleted after, the same order as the update move path, so
+         * indexes and readers stay consistent at every step -- and frees the extent
+         * once it is empty.  Returns early when another operation queues behind the
+         * database lock.  Progress is structural (moved documents leave the head
+         * extent), so repeated calls resume automatically.  Only valid on uncapped
+         * collections backed by SimpleRecordStoreV1; unlike full compact, indexes
+         * remain online throughout.
+         * Sets 'extentFreed' if the head extent was handed back and 'done' when
+         * fewer than two extents remain.
+         * @return the number of documents moved this slice
+         */
+        StatusWith<long long> compactHeadExtentStep( OperationContext* txn,
+                                                     long long maxMoves,
+                                                     bool* extentFreed,
+                                                     bool* done );
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
@@ -266,6 +312,9 @@ namespace mongo {
 
         Status aboutToDeleteCapped( OperationContext* txn, const DiskLoc& loc );
 
+        Status aboutToDeleteCappedBatch( OperationContext* txn,
+                                         const std::vector<DiskLoc>& locs );
+
         /**
          * same semantics as insertDocument, but doesn't do:
          *  - some user error checks
@@ -30,6 +30,11 @@
 
 #include "mongo/db/catalog/collection_cursor_cache.h"
 
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <utility>
+
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
@@ -37,12 +42,18 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/client.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/runner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
 
+    MONGO_EXPORT_SERVER_PARAMETER( tailableCursorReadaheadDocs, int, 0 );
+
     namespace {
         unsigned idFromCursorId( CursorId id ) {
             uint64_t x = static_cast<uint64_t>(id);
@@ -108,7 +119,7 @@ namespace mongo {
         int64_t nextSeed();
 
     private:
-        SimpleMutex _mutex;
+        AdaptiveMutex _mutex;
 
         typedef unordered_map<unsigned,string> Map;
         Map _idToNS;
@@ -128,7 +139,7 @@ namespace mongo {
     }
 
     int64_t GlobalCursorIdCache::nextSeed() {
-        SimpleMutex::scoped_lock lk( _mutex );
+        AdaptiveMutex::scoped_lock lk( _mutex );
         if ( !_secureRandom )
             _secureRandom = SecureRandom::create();
         return _secureRandom->nextInt64();
@@ -137,7 +148,7 @@ namespace mongo {
     unsigned GlobalCursorIdCache::created( const std::string& ns ) {
         static const unsigned MAX_IDS = 1000 * 1000 * 1000;
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        AdaptiveMutex::scoped_lock lk( _mutex );
 
         fassert( 17359, _idToNS.size() < MAX_IDS );
 
@@ -155,7 +166,7 @@ namespace mongo {
     }
 
     void GlobalCursorIdCache::destroyed( unsigned id, const std::string& ns ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        AdaptiveMutex::scoped_lock lk( _mutex );
         invariant( ns == _idToNS[id] );
         _idToNS.erase( id );
     }
@@ -163,7 +174,7 @@ namespace mongo {
     bool GlobalCursorIdCache::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
         string ns;
         {
-            SimpleMutex::scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
             unsigned nsid = idFromCursorId( id );
             Map::const_iterator it = _idToNS.find( nsid );
             if ( it == _idToNS.end() ) {
@@ -208,7 +219,7 @@ namespace mongo {
     std::size_t GlobalCursorIdCache::timeoutCursors(OperationContext* txn, int millisSinceLastCall) {
         vector<string> todo;
         {
-            SimpleMutex::scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
             for ( Map::const_iterator i = _idToNS.begin(); i != _idToNS.end(); ++i )
                 todo.push_back( i->second );
         }
@@ -234,6 +245,108 @@ namespace mongo {
         return totalTimedOut;
     }
 
+    namespace {
+
+        // Work queue for the tailable-cursor readahead thread, which is started
+        // lazily by CollectionCursorCache::scheduleReadahead().
+        mongo::mutex readaheadMutex( "TailableReadahead" );
+        boost::condition readaheadCV;
+        std::deque< std::pair<std::string, CursorId> > readaheadQueue;
+        bool readaheadThreadStarted = false;
+
+        /**
+         * One staging attempt for a queued cursor.  Returns false only if the cursor
+         * exists but is pinned by a client, in which case the caller should retry
+         * shortly; anything else means we are done with the job.
+         */
+        bool tryStageReadahead( OperationContext* txn, const std::string& ns, CursorId id ) {
+            Lock::DBRead lock( txn->lockState(), ns );
+            Database* db = dbHolder().get( txn, ns );
+            if ( !db )
+                return true;
+            Client::Context context( ns, db );
+            Collection* collection = db->getCollection( txn, ns );
+            if ( !collection )
+                return true;
+
+            CollectionCursorCache* cache = collection->cursorCache();
+            bool busy = false;
+            ClientCursor* cc = cache->pinForReadahead( id, &busy );
+            if ( !cc )
+                return !busy;
+            ON_BLOCK_EXIT_OBJ( *cache, &CollectionCursorCache::unpinReadahead, cc );
+
+            Runner* runner = cc->getRunner();
+            if ( !runner || cc->isAggCursor )
+                return true;
+
+            const int limitDocs = tailableCursorReadaheadDocs;
+            if ( limitDocs <= 0 )
+                return true;
+
+            runner->restoreState( txn );
+
+            BSONObj obj;
+            while ( cc->stagedResultCount() < static_cast<size_t>( limitDocs ) &&
+                    cc->stagedResultBytes() <= static_cast<size_t>( MaxBytesToReturnToClientAtOnce ) &&
+                    Runner::RUNNER_ADVANCED == runner->getNext( &obj, NULL ) ) {
+                cc->stageResult( obj.getOwned() );
+            }
+
+            // Leave the runner the way a getMore would between batches; a dead or
+            // errored runner reports the same state to the next getMore.
+            runner->saveState();
+            return true;
+        }
+
+        void readaheadThread() {
+            Client::initThread( "tailableReadahead" );
+            while ( !inShutdown() ) {
+                std::pair<std::string, CursorId> job;
+                {
+                    scoped_lock lk( readaheadMutex );
+                    while ( readaheadQueue.empty() && !inShutdown() ) {
+                        boost::xtime xt;
+                        boost::xtime_get( &xt, MONGO_BOOST_TIME_UTC );
+                        xt.sec += 1;
+                        readaheadCV.timed_wait( lk.boost(), xt );
+                    }
+                    if ( readaheadQueue.empty() )
+                        break;
+                    job = readaheadQueue.front();
+                    readaheadQueue.pop_front();
+                }
+
+                try {
+                    OperationContextImpl txn;
+                    // The scheduling getMore usually still holds its pin for a moment
+                    // after queueing the job; retry briefly before giving up.
+                    for ( int attempt = 0; attempt < 10; attempt++ ) {
+                        if ( tryStageReadahead( &txn, job.first, job.second ) )
+                            break;
+                        sleepmillis( 2 );
+                    }
+                }
+                catch ( const DBException& e ) {
+                    LOG(1) << "tailable cursor readahead error on " << job.first
+                           << ": " << e.what() << endl;
+                }
+            }
+            cc().shutdown();
+        }
+    }
+
+    void CollectionCursorCache::scheduleReadahead( const std::string& ns, CursorId id ) {
+        scoped_lock lk( readaheadMutex );
+        if ( !readaheadThreadStarted ) {
+            boost::thread t( readaheadThread );
+            t.detach();
+            readaheadThreadStarted = true;
+        }
+        readaheadQueue.push_back( std::make_pair( ns, id ) );
+        readaheadCV.notify_one();
+    }
+
     // ---
 
     std::size_t CollectionCursorCache::timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall) {;
@@ -261,9 +374,18 @@ namespace mongo {
     // --------------------------
 
 
+    CollectionCursorCache::Stripe& CollectionCursorCache::_stripeForCursorId( CursorId id ) {
+        // the low 32 bits of a cursor id are random, so the low bits stripe evenly
+        return _stripes[ static_cast<uint64_t>( id ) & ( kNumStripes - 1 ) ];
+    }
+
+    CollectionCursorCache::Stripe& CollectionCursorCache::_stripeForRunner( Runner* runner ) {
+        return _stripes[ ( reinterpret_cast<uintptr_t>( runner ) >> 6 ) % kNumStripes ];
+    }
+
     CollectionCursorCache::CollectionCursorCache( const StringData& ns )
         : _nss( ns ),
-          _mutex( "CollectionCursorCache" ) {
+          _randomMutex( "CollectionCursorCache" ) {
         _collectionCacheRuntimeId = _globalCursorIdCache.created( _nss.ns() );
         _random.reset( new PseudoRandom( _globalCursorIdCache.nextSeed() ) );
     }
@@ -274,138 +396,204 @@ namespace mongo {
     }
 
     void CollectionCursorCache::invalidateAll( bool collectionGoingAway ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( RunnerSet::iterator it = _nonCachedRunners.begin();
-              it != _nonCachedRunners.end();
-              ++it ) {
+        // Stripes are swept one at a time.  Callers hold the collection lock in a mode
+        // that excludes registration, so nothing can slip into an already-swept stripe.
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+
+            for ( RunnerSet::iterator it = stripe.runners.begin();
+                  it != stripe.runners.end();
+                  ++it ) {
+
+                // we kill the runner, but it deletes itself
+                Runner* runner = *it;
+                runner->kill();
+                invariant( runner->collection() == NULL );
+            }
+            _numRegistered.fetchAndSubtract( stripe.runners.size() );
+            stripe.runners.clear();
 
-            // we kill the runner, but it deletes itself
-            Runner* runner = *it;
-            runner->kill();
-            invariant( runner->collection() == NULL );
-        }
-        _nonCachedRunners.clear();
+            if ( collectionGoingAway ) {
+                // we're going to wipe out the world
+                for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                      i != stripe.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
 
-        if ( collectionGoingAway ) {
-            // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
-
-                cc->kill();
+                    cc->kill();
 
-                invariant( cc->getRunner() == NULL || cc->getRunner()->collection() == NULL );
+                    invariant( cc->getRunner() == NULL || cc->getRunner()->collection() == NULL );
 
-                // If there is a pinValue >= 100, somebody is actively using the CC and we do
-                // not delete it.  Instead we notify the holder that we killed it.  The holder
-                // will then delete the CC.
-                // pinvalue is <100, so there is nobody actively holding the CC.  We can
-                // safely delete it as nobody is holding the CC.
+                    // If there is a pinValue >= 100, somebody is actively using the CC and we do
+                    // not delete it.  Instead we notify the holder that we killed it.  The holder
+                    // will then delete the CC.
+                    // pinvalue is <100, so there is nobody actively holding the CC.  We can
+                    // safely delete it as nobody is holding the CC.
 
-                if (cc->pinValue() < 100) {
-                    delete cc;
+                    if (cc->pinValue() < 100) {
+                        delete cc;
+                    }
                 }
+                _numRegistered.fetchAndSubtract( stripe.cursors.size() );
             }
-        }
-        else {
-            CursorMap newMap;
-
-            // collection will still be around, just all Runners are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+            else {
+                CursorMap newMap;
+
+                // collection will still be around, just all Runners are invalid
+                for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                      i != stripe.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
+
+                    if (cc->isAggCursor) {
+                        // Aggregation cursors don't have their lifetime bound to the underlying collection.
+                        newMap[i->first] = i->second;
+                        continue;
+                    }
+
+                    // Note that a valid ClientCursor state is "no cursor no runner."  This is because
+                    // the set of active cursor IDs in ClientCursor is used as representation of query
+                    // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
+                    if (NULL == cc->getRunner() ) {
+                        newMap.insert( *i );
+                        continue;
+                    }
+
+                    if (cc->pinValue() < 100) {
+                        cc->kill();
+                        delete cc;
+                    }
+                    else {
+                        // this is pinned, so still alive, so we leave around
+                        // we kill the Runner to signal
+                        if ( cc->getRunner() )
+                            cc->getRunner()->kill();
+                        newMap.insert( *i );
+                    }
 
-                if (cc->isAggCursor) {
-                    // Aggregation cursors don't have their lifetime bound to the underlying collection.
-                    newMap[i->first] = i->second;
-                    continue;
-                }
-
-                // Note that a valid ClientCursor state is "no cursor no runner."  This is because
-                // the set of active cursor IDs in ClientCursor is used as representation of query
-                // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-                if (NULL == cc->getRunner() ) {
-                    newMap.insert( *i );
-                    continue;
-                }
-
-                if (cc->pinValue() < 100) {
-                    cc->kill();
-                    delete cc;
-                }
-                else {
-                    // this is pinned, so still alive, so we leave around
-                    // we kill the Runner to signal
-                    if ( cc->getRunner() )
-                        cc->getRunner()->kill();
-                    newMap.insert( *i );
                 }
 
+                _numRegistered.fetchAndSubtract( stripe.cursors.size() - newMap.size() );
+                stripe.cursors = newMap;
             }
-
-            _cursors = newMap;
         }
     }
 
     void CollectionCursorCache::invalidateDocument( const DiskLoc& dl,
                                                     InvalidationType type ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        // The caller holds the collection lock in write mode, so the membership of every
+        // stripe is stable while we walk them.
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
 
-        for ( RunnerSet::iterator it = _nonCachedRunners.begin();
-              it != _nonCachedRunners.end();
-              ++it ) {
+            for ( RunnerSet::iterator it = stripe.runners.begin();
+                  it != stripe.runners.end();
+                  ++it ) {
 
-            Runner* runner = *it;
-            runner->invalidate(dl, type);
+                Runner* runner = *it;
+                runner->invalidate(dl, type);
+            }
+
+            for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                  i != stripe.cursors.end();
+                  ++i ) {
+                Runner* runner = i->second->getRunner();
+                if ( runner ) {
+                    runner->invalidate(dl, type);
+                }
+            }
         }
+    }
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            Runner* runner = i->second->getRunner();
-            if ( runner ) {
-                runner->invalidate(dl, type);
+    void CollectionCursorCache::invalidateDocuments( const std::vector<DiskLoc>& dls,
+                                                     InvalidationType type ) {
+        // The caller holds the collection lock in write mode, so the membership of every
+        // stripe is stable while we walk them.  One pass over the stripes for the whole
+        // batch: a capped wraparound can delete many documents per insert, and taking
+        // every stripe mutex once per document adds up.
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+
+            for ( RunnerSet::iterator it = stripe.runners.begin();
+                  it != stripe.runners.end();
+                  ++it ) {
+                for ( size_t d = 0; d < dls.size(); d++ ) {
+                    (*it)->invalidate(dls[d], type);
+                }
+            }
+
+            for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                  i != stripe.cursors.end();
+                  ++i ) {
+                Runner* runner = i->second->getRunner();
+                if ( runner ) {
+                    for ( size_t d = 0; d < dls.size(); d++ ) {
+                        runner->invalidate(dls[d], type);
+                    }
+                }
             }
         }
     }
 
     std::size_t CollectionCursorCache::timeoutCursors( int millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        size_t totalTimedOut = 0;
 
-        vector<ClientCursor*> toDelete;
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+            vector<ClientCursor*> toDelete;
+
+            for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                  i != stripe.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                if ( cc->shouldTimeout( millisSinceLastCall ) )
+                    toDelete.push_back( cc );
+            }
+
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                  i != toDelete.end();
+                  ++i ) {
+                ClientCursor* cc = *i;
+                _deregisterCursor_inlock( stripe, cc );
+                cc->kill();
+                delete cc;
+            }
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin(); i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            totalTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return totalTimedOut;
     }
 
     void CollectionCursorCache::registerRunner( Runner* runner ) {
         if (!useExperimentalDocLocking) {
-            SimpleMutex::scoped_lock lk(_mutex);
-            const std::pair<RunnerSet::iterator, bool> result = _nonCachedRunners.insert(runner);
+            Stripe& stripe = _stripeForRunner( runner );
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+            const std::pair<RunnerSet::iterator, bool> result = stripe.runners.insert(runner);
             invariant(result.second); // make sure this was inserted
+            _numRegistered.fetchAndAdd(1);
         }
     }
 
     void CollectionCursorCache::deregisterRunner( Runner* runner ) {
         if (!useExperimentalDocLocking) {
-            SimpleMutex::scoped_lock lk(_mutex);
-            _nonCachedRunners.erase(runner);
+            Stripe& stripe = _stripeForRunner( runner );
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+            if ( stripe.runners.erase(runner) )
+                _numRegistered.fetchAndSubtract(1);
         }
     }
 
     ClientCursor* CollectionCursorCache::find( CursorId id, bool pin ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        Stripe& stripe = _stripeForCursorId( id );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
+        CursorMap::const_iterator it = stripe.cursors.find( id );
+        if ( it == stripe.cursors.end() )
             return NULL;
 
         ClientCursor* cursor = it->second;
@@ -419,56 +607,127 @@ namespace mongo {
         return cursor;
     }
 
+    ClientCursor* CollectionCursorCache::findPinRetryable( CursorId id, bool* readaheadBusy ) {
+        *readaheadBusy = false;
+
+        Stripe& stripe = _stripeForCursorId( id );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
+        CursorMap::const_iterator it = stripe.cursors.find( id );
+        if ( it == stripe.cursors.end() )
+            return NULL;
+
+        ClientCursor* cursor = it->second;
+        if ( cursor->_pinValue >= 100 ) {
+            if ( cursor->_readaheadPinned ) {
+                // the readahead thread will unpin shortly; caller should retry
+                *readaheadBusy = true;
+                return NULL;
+            }
+            uasserted( 12051, "clientcursor already in use? driver problem?" );
+        }
+        cursor->_pinValue += 100;
+
+        return cursor;
+    }
+
+    ClientCursor* CollectionCursorCache::pinForReadahead( CursorId id, bool* busy ) {
+        *busy = false;
+
+        Stripe& stripe = _stripeForCursorId( id );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
+        CursorMap::const_iterator it = stripe.cursors.find( id );
+        if ( it == stripe.cursors.end() )
+            return NULL;
+
+        ClientCursor* cursor = it->second;
+        if ( cursor->_pinValue >= 100 ) {
+            *busy = true;
+            return NULL;
+        }
+        cursor->_pinValue += 100;
+        cursor->_readaheadPinned = true;
+
+        return cursor;
+    }
+
     void CollectionCursorCache::unpin( ClientCursor* cursor ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Stripe& stripe = _stripeForCursorId( cursor->cursorid() );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
 
         invariant( cursor->_pinValue >= 100 );
         cursor->_pinValue -= 100;
     }
 
+    void CollectionCursorCache::unpinReadahead( ClientCursor* cursor ) {
+        Stripe& stripe = _stripeForCursorId( cursor->cursorid() );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
+
+        invariant( cursor->_pinValue >= 100 && cursor->_readaheadPinned );
+        cursor->_readaheadPinned = false;
+        cursor->_pinValue -= 100;
+    }
+
     void CollectionCursorCache::getCursorIds( std::set<CursorId>* openCursors ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+            for ( CursorMap::const_iterator i = stripe.cursors.begin();
+                  i != stripe.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                openCursors->insert( cc->cursorid() );
+            }
         }
     }
 
     size_t CollectionCursorCache::numCursors(){
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t n = 0;
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+            n += stripe.cursors.size();
+        }
+        return n;
     }
 
-    CursorId CollectionCursorCache::_allocateCursorId_inlock() {
+    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
+        invariant( cc );
+
         for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
+            unsigned mypart;
+            {
+                SimpleMutex::scoped_lock lk( _randomMutex );
+                mypart = static_cast<unsigned>( _random->nextInt32() );
+            }
             CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
+
+            // an id collision can only live in the id's own stripe, so uniqueness
+            // only needs that one lock
+            Stripe& stripe = _stripeForCursorId( id );
+            AdaptiveMutex::scoped_lock lk( stripe.mutex );
+            if ( stripe.cursors.count( id ) == 0 ) {
+                stripe.cursors[id] = cc;
+                _numRegistered.fetchAndAdd(1);
                 return id;
+            }
         }
         fassertFailed( 17360 );
     }
 
-    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
-        invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
-        return id;
-    }
-
     void CollectionCursorCache::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
+        Stripe& stripe = _stripeForCursorId( cc->cursorid() );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
+        _deregisterCursor_inlock( stripe, cc );
     }
 
     bool CollectionCursorCache::eraseCursor( CursorId id, bool checkAuth ) {
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        Stripe& stripe = _stripeForCursorId( id );
+        AdaptiveMutex::scoped_lock lk( stripe.mutex );
 
-        CursorMap::iterator it = _cursors.find( id );
-        if ( it == _cursors.end() ) {
+        CursorMap::iterator it = stripe.cursors.find( id );
+        if ( it == stripe.cursors.end() ) {
             if ( checkAuth )
                 audit::logKillCursorsAuthzCheck( currentClient.get(),
                                                  _nss,
@@ -490,15 +749,16 @@ namespace mongo {
                  cursor->pinValue() < 100 );
 
         cursor->kill();
-        _deregisterCursor_inlock( cursor );
+        _deregisterCursor_inlock( stripe, cursor );
         delete cursor;
         return true;
     }
 
-    void CollectionCursorCache::_deregisterCursor_inlock( ClientCursor* cc ) {
+    void CollectionCursorCache::_deregisterCursor_inlock( Stripe& stripe, ClientCursor* cc ) {
         invariant( cc );
         CursorId id = cc->cursorid();
-        _cursors.erase( id );
+        if ( stripe.cursors.erase( id ) )
+            _numRegistered.fetchAndSubtract(1);
     }
 
 }
@@ -34,7 +34,9 @@
 #include "mongo/db/diskloc.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
@@ -43,6 +45,11 @@ namespace mongo {
     class PseudoRandom;
     class Runner;
 
+    // When > 0, after each getMore on a tailable cursor a background thread keeps
+    // pulling up to this many documents into the cursor's staged buffer so the next
+    // getMore can be answered from memory.  0 (the default) disables readahead.
+    extern int tailableCursorReadaheadDocs;
+
     class CollectionCursorCache {
     public:
         CollectionCursorCache( const StringData& ns );
@@ -68,6 +75,20 @@ namespace mongo {
         void invalidateDocument( const DiskLoc& dl,
                                  InvalidationType type );
 
+        /**
+         * Batch form of invalidateDocument() for capped wraparound reclamation: one pass
+         * over the stripes for the whole set of DiskLocs instead of a pass per document.
+         */
+        void invalidateDocuments( const std::vector<DiskLoc>& dls,
+                                  InvalidationType type );
+
+        /**
+         * @return true if any runner or cursor is currently registered.  one atomic
+         * read; the capped delete path checks this so wraparound reclamation can skip
+         * the invalidation walk entirely when nothing is reading the collection.
+         */
+        bool hasRegistered() const { return _numRegistered.load() > 0; }
+
         /*
          * timesout cursors that have been idle for too long
          * note: must have a readlock on the collection
@@ -106,8 +127,24 @@ namespace mongo {
          */
         ClientCursor* find( CursorId id, bool pin );
 
+        /**
+         * Like find( id, true ), but if the cursor is currently pinned by the
+         * background readahead thread this sets *readaheadBusy and returns NULL
+         * instead of asserting, so the caller can wait briefly and retry.
+         */
+        ClientCursor* findPinRetryable( CursorId id, bool* readaheadBusy );
+
+        /**
+         * Pins a cursor on behalf of the background readahead thread.  Returns NULL
+         * if the cursor is gone; returns NULL and sets *busy if it is pinned by
+         * someone else.
+         */
+        ClientCursor* pinForReadahead( CursorId id, bool* busy );
+
         void unpin( ClientCursor* cursor );
 
+        void unpinReadahead( ClientCursor* cursor );
+
         // ----------------------
 
         static int eraseCursorGlobalIfAuthorized(OperationContext* txn, int n, long long* ids);
@@ -120,21 +157,49 @@ namespace mongo {
          */
         static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
+        /**
+         * Queues the cursor for the background readahead thread, which pins it and
+         * pulls up to tailableCursorReadaheadDocs results into its staged buffer so
+         * the next getMore is served from memory.  Starts the thread on first use.
+         */
+        static void scheduleReadahead( const std::string& ns, CursorId id );
+
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        typedef unordered_set<Runner*> RunnerSet;
+        typedef std::map<CursorId,ClientCursor*> CursorMap;
+
+        /**
+         * Cursor and runner registration is striped so that registering a cursor (every
+         * query) does not contend with kill/timeout sweeps or with registrations of
+         * unrelated cursors.  A cursor id always maps to the same stripe, so point
+         * operations (find/pin/erase) lock exactly one stripe; sweeps visit the stripes
+         * one at a time.
+         */
+        struct Stripe {
+            Stripe() : mutex( "CollectionCursorCache::Stripe" ) {}
+
+            AdaptiveMutex mutex;
+            RunnerSet runners;
+            CursorMap cursors;
+        };
+
+        static const int kNumStripes = 16; // power of two; see _stripeForCursorId
+
+        Stripe& _stripeForCursorId( CursorId id );
+        Stripe& _stripeForRunner( Runner* runner );
+
+        void _deregisterCursor_inlock( Stripe& stripe, ClientCursor* cc );
 
         NamespaceString _nss;
         unsigned _collectionCacheRuntimeId;
-        scoped_ptr<PseudoRandom> _random;
 
-        SimpleMutex _mutex;
+        SimpleMutex _randomMutex; // guards _random only
+        scoped_ptr<PseudoRandom> _random;
 
-        typedef unordered_set<Runner*> RunnerSet;
-        RunnerSet _nonCachedRunners;
+        // runners + cursors registered across all stripes; see hasRegistered()
+        AtomicUInt32 _numRegistered;
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        Stripe _stripes[kNumStripes];
     };
 
 }
@@ -30,20 +30,39 @@
 
 #include "mongo/db/catalog/collection_info_cache.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/util/debug_util.h"
 
 
 namespace mongo {
 
+    namespace {
+
+        // Plan cache sidecar files live in a dedicated directory under the dbpath,
+        // one file per collection, named after the namespace. Each file is a plain
+        // concatenation of the BSON objects produced by PlanCache::getPersistedEntries().
+        boost::filesystem::path planCacheFilePath(const std::string& ns) {
+            boost::filesystem::path dir(storageGlobalParams.dbpath);
+            dir /= "_plan_cache";
+            return dir / (ns + ".bson");
+        }
+    }
+
     CollectionInfoCache::CollectionInfoCache( Collection* collection )
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()) {
+        loadPlanCacheFromDisk();
+    }
 
     void CollectionInfoCache::reset() {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
@@ -82,6 +101,104 @@ namespace mongo {
         }
     }
 
+    void CollectionInfoCache::savePlanCacheToDisk() const {
+        if (!internalQueryCachePersistenceEnabled || NULL == _planCache.get()) {
+            return;
+        }
+
+        const std::string ns = _collection->ns().ns();
+        std::vector<BSONObj> entries;
+        _planCache->getPersistedEntries(&entries);
+
+        try {
+            boost::filesystem::path path = planCacheFilePath(ns);
+
+            if (entries.empty()) {
+                // Nothing worth keeping; also drop any stale file from a previous run.
+                boost::filesystem::remove(path);
+                return;
+            }
+
+            boost::filesystem::create_directory(path.parent_path());
+
+            std::ofstream file(path.string().c_str(),
+                               std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file) {
+                warning() << ns << ": could not open plan cache file for writing: "
+                          << path.string();
+                return;
+            }
+
+            for (size_t i = 0; i < entries.size(); ++i) {
+                file.write(entries[i].objdata(), entries[i].objsize());
+            }
+
+            LOG(1) << ns << ": saved " << entries.size() << " plan cache entries to disk";
+        }
+        catch (const std::exception& e) {
+            warning() << ns << ": failed to save plan cache: " << e.what();
+        }
+    }
+
+    void CollectionInfoCache::loadPlanCacheFromDisk() {
+        if (!internalQueryCachePersistenceEnabled) {
+            return;
+        }
+
+        const std::string ns = _collection->ns().ns();
+
+        try {
+            boost::filesystem::path path = planCacheFilePath(ns);
+            if (!boost::filesystem::exists(path)) {
+                return;
+            }
+
+            std::ifstream file(path.string().c_str(), std::ios::in | std::ios::binary);
+            if (!file) {
+                warning() << ns << ": could not open plan cache file for reading: "
+                          << path.string();
+                return;
+            }
+
+            std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                                     std::istreambuf_iterator<char>());
+
+            size_t numLoaded = 0;
+            size_t offset = 0;
+            while (offset + sizeof(int) <= buffer.size()) {
+                BSONObj obj(&buffer[offset]);
+                int objSize = obj.objsize();
+                if (objSize < 5 || // empty object is 5 bytes
+                    static_cast<size_t>(objSize) > buffer.size() - offset ||
+                    !obj.valid()) {
+                    warning() << ns << ": plan cache file is corrupt, "
+                              << "ignoring remaining entries: " << path.string();
+                    break;
+                }
+
+                Status status = _planCache->loadPersistedEntry(obj);
+                if (status.isOK()) {
+                    ++numLoaded;
+                }
+                else {
+                    // Entries that no longer canonicalize (e.g. the query used a
+                    // feature that has been disabled) are skipped individually.
+                    LOG(1) << ns << ": skipping persisted plan cache entry: "
+                           << status.toString();
+                }
+
+                offset += objSize;
+            }
+
+            if (numLoaded > 0) {
+                LOG(1) << ns << ": loaded " << numLoaded << " plan cache entries from disk";
+            }
+        }
+        catch (const std::exception& e) {
+            warning() << ns << ": failed to load plan cache: " << e.what();
+        }
+    }
+
     PlanCache* CollectionInfoCache::getPlanCache() const {
         return _planCache.get();
     }
@@ -91,6 +91,13 @@ namespace mongo {
         /* you must notify the cache if you are doing writes, as query plan utility will change */
         void notifyOfWriteOp();
 
+        /**
+         * Writes the plan cache contents to this collection's sidecar file under the
+         * dbpath so they can be reloaded when the collection is next opened.  Called
+         * on clean shutdown.  No-op if plan cache persistence is disabled.
+         */
+        void savePlanCacheToDisk() const;
+
     private:
 
         Collection* _collection; // not owned
@@ -110,6 +117,14 @@ namespace mongo {
          * Must be called under exclusive DB lock.
          */
         void computeIndexKeys();
+
+        /**
+         * Loads any plan cache entries saved by a previous savePlanCacheToDisk()
+         * into _planCache.  Invoked once from the constructor; entries that no
+         * longer make sense (e.g. they reference a dropped index) are skipped or
+         * fall back to normal planning on first use.
+         */
+        void loadPlanCacheFromDisk();
     };
 
 }  // namespace mongo
@@ -57,6 +57,7 @@ namespace mongo {
         flags = 0;
         flagsSet = false;
         temp = false;
+        timePartitionExpireSeconds = 0;
     }
 
     Status CollectionOptions::parse( const BSONObj& options ) {
@@ -118,6 +119,25 @@ namespace mongo {
             else if ( fieldName == "temp" ) {
                 temp = e.trueValue();
             }
+            else if ( fieldName == "timePartitionExpireSeconds" ) {
+                if ( !e.isNumber() )
+                    return Status( ErrorCodes::BadValue,
+                                   "timePartitionExpireSeconds has to be a number" );
+                timePartitionExpireSeconds = e.numberLong();
+                if ( timePartitionExpireSeconds <= 0 )
+                    return Status( ErrorCodes::BadValue,
+                                   "timePartitionExpireSeconds has to be > 0" );
+            }
+        }
+
+        if ( timePartitionExpireSeconds ) {
+            if ( options["capped"].trueValue() )
+                return Status( ErrorCodes::BadValue,
+                               "timePartitionExpireSeconds cannot be used on a capped collection" );
+            if ( autoIndexId != NO )
+                return Status( ErrorCodes::BadValue,
+                               "timePartitionExpireSeconds requires autoIndexId:false, "
+                               "extent expiry does not maintain indexes" );
         }
 
         return Status::OK();
@@ -147,6 +167,9 @@ namespace mongo {
         if ( temp )
             b.appendBool( "temp", true );
 
+        if ( timePartitionExpireSeconds )
+            b.appendNumber( "timePartitionExpireSeconds", timePartitionExpireSeconds );
+
         return b.obj();
     }
 
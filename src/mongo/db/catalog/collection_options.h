@@ -72,6 +72,12 @@ namespace mongo {
         bool flagsSet;
 
         bool temp;
+
+        // > 0 enables time-partitioned expiry: the TTL monitor drops the
+        // collection's oldest extent wholesale once its newest document's _id
+        // ObjectId time is older than this many seconds.  Requires
+        // autoIndexId:false (expiry never touches indexes) and excludes capped.
+        long long timePartitionExpireSeconds;
     };
 
 }
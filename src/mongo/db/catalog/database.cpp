@@ -50,6 +50,7 @@
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/working_set_heat.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/catalog/collection.h"
@@ -66,6 +67,15 @@ namespace mongo {
     Database::~Database() {
         for (CollectionMap::const_iterator i = _collections.begin(); i != _collections.end(); ++i)
             delete i->second;
+        for ( size_t b = 0; b < kCacheBuckets; b++ ) {
+            CacheNode* node = reinterpret_cast<CacheNode*>(
+                    static_cast<uintptr_t>( _cacheBuckets[b].load() ) );
+            while ( node ) {
+                CacheNode* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
     }
 
     Status Database::validateDBName( const StringData& dbname ) {
@@ -344,6 +354,7 @@ namespace mongo {
         LOG(1) << "\t dropIndexes done" << endl;
 
         Top::global.collectionDropped( fullns );
+        WorkingSetHeat::global.collectionDropped( fullns );
 
         Status s = _dbEntry->dropCollection( txn, fullns );
 
@@ -371,6 +382,17 @@ namespace mongo {
         return Status::OK();
     }
 
+    void Database::savePlanCaches() {
+        scoped_lock lk( _collectionLock );
+        for ( CollectionMap::const_iterator i = _collections.begin();
+              i != _collections.end();
+              ++i ) {
+            if ( i->second ) {
+                i->second->infoCache()->savePlanCacheToDisk();
+            }
+        }
+    }
+
     void Database::_clearCollectionCache( const StringData& fullns ) {
         scoped_lock lk( _collectionLock );
         _clearCollectionCache_inlock( fullns );
@@ -378,6 +400,7 @@ namespace mongo {
 
     void Database::_clearCollectionCache_inlock( const StringData& fullns ) {
         verify( _name == nsToDatabaseSubstring( fullns ) );
+        _cacheRemove_inlock( fullns );
         CollectionMap::const_iterator it = _collections.find( fullns.toString() );
         if ( it == _collections.end() )
             return;
@@ -386,9 +409,55 @@ namespace mongo {
         _collections.erase( it );
     }
 
+    Collection* Database::_cacheProbe( const StringData& ns ) const {
+        const size_t bucket = StringData::Hasher()( ns ) & ( kCacheBuckets - 1 );
+        const CacheNode* node = reinterpret_cast<const CacheNode*>(
+                static_cast<uintptr_t>( _cacheBuckets[bucket].load() ) );
+        for ( ; node; node = node->next ) {
+            if ( ns == StringData( node->ns ) )
+                return node->coll;
+        }
+        return NULL;
+    }
+
+    void Database::_cacheInsert_inlock( const StringData& ns, Collection* c ) {
+        const size_t bucket = StringData::Hasher()( ns ) & ( kCacheBuckets - 1 );
+        CacheNode* head = reinterpret_cast<CacheNode*>(
+                static_cast<uintptr_t>( _cacheBuckets[bucket].load() ) );
+        CacheNode* node = new CacheNode( ns, c, head );
+        // publish only after the node is fully built; readers hold no mutex
+        _cacheBuckets[bucket].store( static_cast<uintptr_t>(
+                reinterpret_cast<uintptr_t>( node ) ) );
+    }
+
+    void Database::_cacheRemove_inlock( const StringData& ns ) {
+        // catalog changes run under an exclusive database lock, so no reader is
+        // traversing this chain concurrently and the node can be freed in place
+        const size_t bucket = StringData::Hasher()( ns ) & ( kCacheBuckets - 1 );
+        CacheNode* node = reinterpret_cast<CacheNode*>(
+                static_cast<uintptr_t>( _cacheBuckets[bucket].load() ) );
+        CacheNode* prev = NULL;
+        for ( ; node; prev = node, node = node->next ) {
+            if ( ns != StringData( node->ns ) )
+                continue;
+            if ( prev )
+                prev->next = node->next;
+            else
+                _cacheBuckets[bucket].store( static_cast<uintptr_t>(
+                        reinterpret_cast<uintptr_t>( node->next ) ) );
+            delete node;
+            return;
+        }
+    }
+
     Collection* Database::getCollection( OperationContext* txn, const StringData& ns ) {
         invariant( _name == nsToDatabaseSubstring( ns ) );
 
+        // fast path: one lock-free hash probe; hits need neither the mutex nor
+        // a trip through the .ns file machinery
+        if ( Collection* c = _cacheProbe( ns ) )
+            return c;
+
         scoped_lock lk( _collectionLock );
 
         CollectionMap::const_iterator it = _collections.find( ns );
@@ -405,6 +474,7 @@ namespace mongo {
 
         Collection* c = new Collection( txn, ns, catalogEntry.release(), rs.release(), this );
         _collections[ns] = c;
+        _cacheInsert_inlock( ns, c );
         return c;
     }
 
@@ -434,6 +504,7 @@ namespace mongo {
             }
 
             Top::global.collectionDropped( fromNS.toString() );
+            WorkingSetHeat::global.collectionDropped( fromNS.toString() );
         }
 
         return _dbEntry->renameCollection( txn, fromNS, toNS, stayTemp );
@@ -32,6 +32,8 @@
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/catalog/collection_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/concurrency/mutex.h"
@@ -136,6 +138,12 @@ namespace mongo {
         static Status validateDBName( const StringData& dbname );
 
         const std::string& getSystemIndexesName() const { return _indexesName; }
+
+        /**
+         * Writes the plan cache of every open collection to its sidecar file under
+         * the dbpath.  Called on clean shutdown so cached plans survive a restart.
+         */
+        void savePlanCaches();
     private:
 
         void _clearCollectionCache( const StringData& fullns );
@@ -159,6 +167,30 @@ namespace mongo {
         CollectionMap _collections;
         mongo::mutex _collectionLock;
 
+        /*
+          Lock-free read index over _collections, so the per-op namespace
+          lookup in getCollection() is one hash probe with no mutex.  Readers
+          hold at least a database read lock; insertions (cache fill-ins, which
+          can race between readers) publish a fully built node with an atomic
+          head store under _collectionLock; removals only happen during catalog
+          changes, which run under an exclusive database lock with no
+          concurrent readers, so chains may be unlinked and freed in place.
+        */
+        struct CacheNode {
+            CacheNode( const StringData& n, Collection* c, CacheNode* nx )
+                : ns( n.toString() ), coll( c ), next( nx ) {}
+            const std::string ns;
+            Collection* const coll;
+            CacheNode* next; // only changed while unlinking, under exclusive lock
+        };
+
+        Collection* _cacheProbe( const StringData& ns ) const; // lock-free
+        void _cacheInsert_inlock( const StringData& ns, Collection* c );
+        void _cacheRemove_inlock( const StringData& ns );
+
+        static const size_t kCacheBuckets = 1024; // power of two
+        AtomicUInt64 _cacheBuckets[kCacheBuckets]; // CacheNode* values; 0 = empty
+
         friend class Collection;
         friend class NamespaceDetails;
         friend class IndexCatalog;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/catalog/index_catalog.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/db/audit.h"
@@ -50,6 +51,7 @@
 #include "mongo/db/index_names.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
@@ -513,6 +515,47 @@ namespace mongo {
                                          << keyStatus.reason() );
         }
 
+        BSONElement hashVersionElt = spec["hashVersion"];
+        if ( !hashVersionElt.eoo() ) {
+            if ( !hashVersionElt.isNumber() ||
+                 ( hashVersionElt.numberInt() != 0 && hashVersionElt.numberInt() != 1 ) )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "hashVersion must be 0 (md5) or 1 (murmur3)" );
+        }
+
+        BSONElement fillFactorElt = spec["fillFactor"];
+        if ( !fillFactorElt.eoo() ) {
+            if ( !fillFactorElt.isNumber() ||
+                 fillFactorElt.numberInt() < 50 ||
+                 fillFactorElt.numberInt() > 99 )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "fillFactor must be a number between 50 and 99" );
+        }
+
+        BSONElement filterElement = spec["partialFilterExpression"];
+        if ( !filterElement.eoo() ) {
+            if ( filterElement.type() != Object )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "\"partialFilterExpression\" for an index must be a document" );
+
+            if ( spec["sparse"].trueValue() )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "cannot mix \"partialFilterExpression\" and \"sparse\" options" );
+
+            if ( IndexDescriptor::isIdIndexPattern( key ) )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "cannot create a partial index on _id" );
+
+            // parse the filter now so a bad expression fails index creation instead of
+            // every subsequent insert
+            StatusWithMatchExpression res = MatchExpressionParser::parse( filterElement.Obj() );
+            if ( !res.isOK() )
+                return Status( ErrorCodes::CannotCreateIndex,
+                               str::stream() << "failed to parse \"partialFilterExpression\": "
+                                             << res.getStatus().reason() );
+            delete res.getValue();
+        }
+
         if ( _collection->isCapped() && spec["dropDups"].trueValue() ) {
             return Status( ErrorCodes::CannotCreateIndex,
                            str::stream() << "Cannot create an index with dropDups=true on a "
@@ -975,20 +1018,28 @@ namespace mongo {
 
     // ---------------------------
 
+    namespace {
+        InsertDeleteOptions makeInsertDeleteOptions( IndexDescriptor* desc ) {
+            InsertDeleteOptions options;
+            options.logIfError = false;
+
+            bool isUnique =
+                KeyPattern::isIdKeyPattern(desc->keyPattern()) ||
+                desc->unique();
+
+            options.dupsAllowed =
+                repl::getGlobalReplicationCoordinator()->shouldIgnoreUniqueIndex(desc)
+                || !isUnique;
+
+            return options;
+        }
+    }
+
     Status IndexCatalog::_indexRecord(OperationContext* txn,
                                       IndexCatalogEntry* index,
                                       const BSONObj& obj,
                                       const DiskLoc &loc ) {
-        InsertDeleteOptions options;
-        options.logIfError = false;
-
-        bool isUnique =
-            KeyPattern::isIdKeyPattern(index->descriptor()->keyPattern()) ||
-            index->descriptor()->unique();
-
-        options.dupsAllowed =
-            repl::getGlobalReplicationCoordinator()->shouldIgnoreUniqueIndex(index->descriptor())
-            || !isUnique;
+        InsertDeleteOptions options = makeInsertDeleteOptions( index->descriptor() );
 
         int64_t inserted;
         return index->accessMethod()->insert(txn, obj, loc, options, &inserted);
@@ -1056,6 +1107,147 @@ namespace mongo {
 
     }
 
+    namespace {
+        // One key from one record in a batch, tagged with the record's slot so a failure
+        // can be mapped back to its document.
+        struct BatchedKey {
+            BSONObj key;
+            DiskLoc loc;
+            size_t record;
+        };
+
+        class BatchedKeyLess {
+        public:
+            explicit BatchedKeyLess( const Ordering& ordering ) : _ordering( ordering ) {}
+
+            bool operator()( const BatchedKey& l, const BatchedKey& r ) const {
+                int cmp = l.key.woCompare( r.key, _ordering, false );
+                if ( cmp )
+                    return cmp < 0;
+                return l.loc < r.loc;
+            }
+
+        private:
+            Ordering _ordering;
+        };
+    }
+
+    void IndexCatalog::indexRecords(OperationContext* txn,
+                                    const std::vector< std::pair<BSONObj, DiskLoc> >& records,
+                                    std::vector<Status>* statuses) {
+
+        statuses->assign( records.size(), Status::OK() );
+
+        // Records that have failed and been rolled back; their remaining keys are skipped.
+        std::vector<char> failed( records.size(), 0 );
+
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+
+            IndexCatalogEntry* entry = *i;
+            IndexAccessMethod* am = entry->accessMethod();
+
+            const InsertDeleteOptions options = makeInsertDeleteOptions( entry->descriptor() );
+
+            // Generate every record's keys for this index up front.
+            std::vector<BatchedKey> batch;
+            std::vector<char> manyKeys( records.size(), 0 );
+            bool batchable = true;
+
+            for ( size_t r = 0; r < records.size(); r++ ) {
+                if ( failed[r] )
+                    continue;
+
+                BSONObjSet keys;
+                if ( !am->getKeysForBatch( records[r].first, &keys ) ) {
+                    batchable = false;
+                    break;
+                }
+
+                if ( keys.size() > 1 )
+                    manyKeys[r] = 1;
+
+                for ( BSONObjSet::const_iterator k = keys.begin(); k != keys.end(); ++k ) {
+                    BatchedKey b;
+                    b.key = *k;
+                    b.loc = records[r].second;
+                    b.record = r;
+                    batch.push_back( b );
+                }
+            }
+
+            if ( !batchable ) {
+                // The access method cannot apply individual keys; maintain this index one
+                // document at a time.
+                for ( size_t r = 0; r < records.size(); r++ ) {
+                    if ( failed[r] )
+                        continue;
+
+                    Status s = _indexRecord( txn, entry, records[r].first, records[r].second );
+                    if ( !s.isOK() ) {
+                        LOG(2) << "IndexCatalog::indexRecords failed: " << s;
+                        (*statuses)[r] = s;
+                        failed[r] = 1;
+                        _rollbackRecord( txn, entry, records[r].first, records[r].second );
+                    }
+                }
+                continue;
+            }
+
+            // Applying in key order turns the batch's random btree descents into a
+            // near-sequential sweep, and the btree layer's sorted-insert leaf hint elides
+            // most of the remaining descents.
+            std::sort( batch.begin(), batch.end(),
+                       BatchedKeyLess( Ordering::make( entry->descriptor()->keyPattern() ) ) );
+
+            for ( size_t b = 0; b < batch.size(); b++ ) {
+                const size_t r = batch[b].record;
+                if ( failed[r] )
+                    continue;
+
+                int64_t numInserted = 0;
+                Status s = am->insertKey( txn, batch[b].key, batch[b].loc, options,
+                                          &numInserted );
+                if ( !s.isOK() ) {
+                    LOG(2) << "IndexCatalog::indexRecords failed: " << s;
+                    (*statuses)[r] = s;
+                    failed[r] = 1;
+                    _rollbackRecord( txn, entry, records[r].first, records[r].second );
+                }
+            }
+
+            for ( size_t r = 0; r < records.size(); r++ ) {
+                if ( manyKeys[r] && !failed[r] ) {
+                    entry->setMultikey( txn );
+                    break;
+                }
+            }
+        }
+    }
+
+    void IndexCatalog::_rollbackRecord( OperationContext* txn,
+                                        IndexCatalogEntry* upTo,
+                                        const BSONObj& obj,
+                                        const DiskLoc& loc ) {
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+
+            IndexCatalogEntry* entry = *i;
+
+            try {
+                _unindexRecord( txn, entry, obj, loc, false );
+            }
+            catch ( DBException& e ) {
+                LOG(1) << "IndexCatalog::indexRecords rollback failed: " << e;
+            }
+
+            if ( entry == upTo )
+                break;
+        }
+    }
+
     void IndexCatalog::unindexRecord(OperationContext* txn,
                                      const BSONObj& obj,
                                      const DiskLoc& loc,
@@ -238,6 +238,20 @@ namespace mongo {
         // this throws for now
         void indexRecord(OperationContext* txn, const BSONObj& obj, const DiskLoc &loc);
 
+        /**
+         * Batch-scoped index maintenance for 'records' (document, location pairs already in
+         * the record store).  Per index, every record's keys are generated up front, sorted
+         * in the index's key order, and applied in that order, so btree descents are
+         * near-sequential instead of random across the batch.
+         *
+         * Does not throw.  'statuses' gets one entry per record; a record that fails to
+         * index has all its keys removed again (its record is left for the caller to
+         * delete) and the remaining records proceed.
+         */
+        void indexRecords(OperationContext* txn,
+                          const std::vector< std::pair<BSONObj, DiskLoc> >& records,
+                          std::vector<Status>* statuses);
+
         void unindexRecord(OperationContext* txn,
                            const BSONObj& obj,
                            const DiskLoc& loc,
@@ -292,6 +306,15 @@ namespace mongo {
                               const DiskLoc &loc,
                               bool logIfError);
 
+        /**
+         * Removes whatever keys exist for 'obj' from every index up to and including 'upTo';
+         * used by indexRecords() to undo a record that failed partway through the batch.
+         */
+        void _rollbackRecord( OperationContext* txn,
+                              IndexCatalogEntry* upTo,
+                              const BSONObj& obj,
+                              const DiskLoc& loc );
+
         /**
          * this does no sanity checks
          */
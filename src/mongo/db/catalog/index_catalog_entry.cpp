@@ -33,8 +33,11 @@
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/structure/head_manager.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -69,6 +72,18 @@ namespace mongo {
           _ordering( Ordering::make( descriptor->keyPattern() ) ),
           _isReady( false ) {
         _descriptor->_cachedEntry = this;
+
+        if ( descriptor->isPartial() ) {
+            StatusWithMatchExpression res =
+                MatchExpressionParser::parse( descriptor->partialFilterExpression() );
+            // the filter was validated when the index was created
+            massert( 18550,
+                     str::stream() << "error parsing partialFilterExpression of index "
+                                   << descriptor->indexName() << ": "
+                                   << res.getStatus().reason(),
+                     res.isOK() );
+            _filterExpression.reset( res.getValue() );
+        }
     }
 
     IndexCatalogEntry::~IndexCatalogEntry() {
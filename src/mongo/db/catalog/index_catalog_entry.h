@@ -32,6 +32,8 @@
 
 #include <string>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/ordering.h"
 #include "mongo/db/diskloc.h"
@@ -43,6 +45,7 @@ namespace mongo {
     class HeadManager;
     class IndexAccessMethod;
     class IndexDescriptor;
+    class MatchExpression;
     class OperationContext;
 
     class IndexCatalogEntry {
@@ -67,6 +70,10 @@ namespace mongo {
 
         const Ordering& ordering() const { return _ordering; }
 
+        /// for a partial index, the parsed partialFilterExpression; NULL otherwise.
+        /// documents that do not match it get no keys in this index.
+        const MatchExpression* getFilterExpression() const { return _filterExpression.get(); }
+
         /// ---------------------
 
         const DiskLoc& head() const;
@@ -104,6 +111,9 @@ namespace mongo {
 
         IndexAccessMethod* _accessMethod; // owned here
 
+        // Owned here.  NULL unless _descriptor->isPartial().
+        boost::scoped_ptr<MatchExpression> _filterExpression;
+
         // Owned here.
         HeadManager* _headManager;
 
@@ -366,6 +366,7 @@ namespace mongo {
         scanAndOrder = false;
         nMatched = -1;
         nModified = -1;
+        nUpdateNoops = -1;
         ninserted = -1;
         ndeleted = -1;
         nmoved = -1;
@@ -373,6 +374,8 @@ namespace mongo {
         fastmodinsert = false;
         upsert = false;
         keyUpdates = 0;  // unsigned, so -1 not possible
+        minorFaults = -1;
+        majorFaults = -1;
         planSummary = "";
         execStats.reset();
         
@@ -437,13 +440,16 @@ namespace mongo {
         OPDEBUG_TOSTRING_HELP( nmoved );
         OPDEBUG_TOSTRING_HELP( nMatched );
         OPDEBUG_TOSTRING_HELP( nModified );
+        OPDEBUG_TOSTRING_HELP( nUpdateNoops );
         OPDEBUG_TOSTRING_HELP( ninserted );
         OPDEBUG_TOSTRING_HELP( ndeleted );
         OPDEBUG_TOSTRING_HELP_BOOL( fastmod );
         OPDEBUG_TOSTRING_HELP_BOOL( fastmodinsert );
         OPDEBUG_TOSTRING_HELP_BOOL( upsert );
         OPDEBUG_TOSTRING_HELP( keyUpdates );
-        
+        OPDEBUG_TOSTRING_HELP( minorFaults );
+        OPDEBUG_TOSTRING_HELP( majorFaults );
+
         if ( extra.len() )
             s << " " << extra.str();
 
@@ -531,12 +537,15 @@ namespace mongo {
         OPDEBUG_APPEND_NUMBER( nmoved );
         OPDEBUG_APPEND_NUMBER( nMatched );
         OPDEBUG_APPEND_NUMBER( nModified );
+        OPDEBUG_APPEND_NUMBER( nUpdateNoops );
         OPDEBUG_APPEND_NUMBER( ninserted );
         OPDEBUG_APPEND_NUMBER( ndeleted );
         OPDEBUG_APPEND_BOOL( fastmod );
         OPDEBUG_APPEND_BOOL( fastmodinsert );
         OPDEBUG_APPEND_BOOL( upsert );
         OPDEBUG_APPEND_NUMBER( keyUpdates );
+        OPDEBUG_APPEND_NUMBER( minorFaults );
+        OPDEBUG_APPEND_NUMBER( majorFaults );
 
         b.appendNumber( "numYield" , curop.numYields() );
         b.append( "lockStats" , curop.lockStat().report() );
@@ -42,6 +42,7 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/lockstate.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/stats/top.h"
 #include "mongo/db/storage_options.h"
@@ -119,6 +120,9 @@ namespace mongo {
 
         LockState& lockState() { return _ls; }
 
+        /** per-operation scratch memory; reset by assembleResponse between operations */
+        OperationArena& arena() { return _arena; }
+
     private:
         Client(const std::string& desc, AbstractMessagingPort *p = 0);
         friend class CurOp;
@@ -135,7 +139,9 @@ namespace mongo {
         bool _hasWrittenSinceCheckpoint;
 
         LockState _ls;
-        
+
+        OperationArena _arena;
+
     public:
 
         class Context;
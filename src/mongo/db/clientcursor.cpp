@@ -99,6 +99,8 @@ namespace mongo {
         _idleAgeMillis = 0;
         _leftoverMaxTimeMicros = 0;
         _pinValue = 0;
+        _readaheadPinned = false;
+        _stagedBytes = 0;
         _pos = 0;
 
         if (_queryOptions & QueryOption_NoCursorTimeout) {
@@ -189,6 +191,24 @@ namespace mongo {
 
     }
 
+    //
+    // Tailable-cursor readahead
+    //
+
+    void ClientCursor::stageResult( const BSONObj& obj ) {
+        invariant( obj.isOwned() );
+        _stagedResults.push_back( obj );
+        _stagedBytes += obj.objsize();
+    }
+
+    BSONObj ClientCursor::takeStagedResult() {
+        invariant( !_stagedResults.empty() );
+        BSONObj obj = _stagedResults.front();
+        _stagedResults.pop_front();
+        _stagedBytes -= obj.objsize();
+        return obj;
+    }
+
     //
     // Pin methods
     // TODO: Simplify when we kill Cursor.  In particular, once we've pinned a CC, it won't be
@@ -198,7 +218,17 @@ namespace mongo {
     ClientCursorPin::ClientCursorPin( const Collection* collection, long long cursorid )
         : _cursor( NULL ) {
         cursorStatsOpenPinned.increment();
-        _cursor = collection->cursorCache()->find( cursorid, true );
+
+        // The background readahead thread (see CollectionCursorCache::scheduleReadahead)
+        // may briefly hold this cursor's pin; wait it out rather than asserting the way
+        // we do for two concurrent getMores on one cursor.
+        for ( ;; ) {
+            bool readaheadBusy = false;
+            _cursor = collection->cursorCache()->findPinRetryable( cursorid, &readaheadBusy );
+            if ( !readaheadBusy )
+                break;
+            sleepmillis( 1 );
+        }
     }
 
     ClientCursorPin::~ClientCursorPin() {
@@ -236,23 +266,18 @@ namespace mongo {
     // ClientCursorMonitor
     //
 
-    void ClientCursorMonitor::run() {
-        Client::initThread("clientcursormon");
-        Client& client = cc();
-        Timer t;
-        const int Secs = 4;
-        while (!inShutdown()) {
-            OperationContextImpl txn;
-            cursorStatsTimedOut.increment(
-                        CollectionCursorCache::timeoutCursorsGlobal(&txn, t.millisReset()));
-            sleepsecs(Secs);
-        }
-        client.shutdown();
+    void ClientCursorMonitor::taskDoWork() {
+        // The scheduler thread is shared between tasks; whichever runs first sets up the
+        // thread's Client.
+        if (!haveClient())
+            Client::initThread("clientcursormon");
+        OperationContextImpl txn;
+        cursorStatsTimedOut.increment(
+                    CollectionCursorCache::timeoutCursorsGlobal(&txn, _t.millisReset()));
     }
 
     namespace {
-        ClientCursorMonitor clientCursorMonitor;
-        
+
         void _appendCursorStats( BSONObjBuilder& b ) {
             b.append( "note" , "deprecated, use server status metrics" );
             b.appendNumber("clientCursors_size", cursorStatsOpen.get() );
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/thread/recursive_mutex.hpp>
+#include <deque>
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
@@ -37,6 +38,7 @@
 #include "mongo/s/collection_metadata.h"
 #include "mongo/util/background.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -114,6 +116,26 @@ namespace mongo {
         /** Just for testing. */
         OpTime getSlaveReadTill() const { return _slaveReadTill; }
 
+        //
+        // Tailable-cursor readahead.  See CollectionCursorCache::scheduleReadahead.
+        //
+
+        /**
+         * Adds a result staged by the background readahead thread.  'obj' must be owned,
+         * as staged results outlive any document move or deletion.
+         */
+        void stageResult( const BSONObj& obj );
+
+        /**
+         * Removes and returns the oldest staged result.  Caller must check
+         * hasStagedResult() first.
+         */
+        BSONObj takeStagedResult();
+
+        bool hasStagedResult() const { return !_stagedResults.empty(); }
+        size_t stagedResultCount() const { return _stagedResults.size(); }
+        size_t stagedResultBytes() const { return _stagedBytes; }
+
         //
         // Query-specific functionality that may be adapted for the Runner.
         //
@@ -164,6 +186,18 @@ namespace mongo {
         // 100: Currently in use (via ClientCursorPin).
         unsigned _pinValue;
 
+        // True while the background readahead thread holds this cursor's pin.  Lets
+        // ClientCursorPin wait out the (short) readahead instead of asserting the way
+        // it does for two concurrent getMores.  Guarded by the CollectionCursorCache
+        // mutex.
+        bool _readaheadPinned;
+
+        // Results staged by the background readahead thread, oldest first, and their
+        // total size in bytes.  All objects are owned.  Only touched by whoever holds
+        // this cursor's pin.
+        std::deque<BSONObj> _stagedResults;
+        size_t _stagedBytes;
+
         // The namespace we're operating on.
         std::string _ns;
 
@@ -225,11 +259,15 @@ namespace mongo {
         ClientCursor* _cursor;
     };
 
-    /** thread for timing out old cursors */
-    class ClientCursorMonitor : public BackgroundJob {
+    /** periodic task for timing out old cursors */
+    class ClientCursorMonitor : public PeriodicTask {
     public:
-        std::string name() const { return "ClientCursorMonitor"; }
-        void run();
+        std::string taskName() const { return "ClientCursorMonitor"; }
+        int taskPeriodSeconds() const { return 4; }
+        void taskDoWork();
+
+    private:
+        Timer _t;
     };
 
 } // namespace mongo
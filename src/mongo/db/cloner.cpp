@@ -47,10 +47,14 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/isself.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/concurrency/mutex.h"
+
+#include <boost/thread/thread.hpp>
 
 
 namespace mongo {
@@ -164,6 +168,8 @@ namespace mongo {
                             << ' ' << loc.toString() << " obj:" << js;
                 }
                 uassertStatusOK( loc.getStatus() );
+                if (trackLastId)
+                    lastId = js["_id"].wrap().getOwned();
                 if (logForRepl)
                     repl::logOp(txn, "i", to_collection, js);
 
@@ -189,6 +195,11 @@ namespace mongo {
         bool logForRepl;
         bool _mayYield;
         bool _mayBeInterrupted;
+
+        // When set, the _id of each cloned document is remembered so an interrupted clone
+        // can resume past it.
+        bool trackLastId;
+        BSONObj lastId;
     };
 
     /* copy the specified collection
@@ -219,6 +230,7 @@ namespace mongo {
         f.logForRepl = logForRepl;
         f._mayYield = mayYield;
         f._mayBeInterrupted = mayBeInterrupted;
+        f.trackLastId = false;
 
         int options = QueryOption_NoCursorTimeout | ( slaveOk ? QueryOption_SlaveOk : 0 );
         {
@@ -264,6 +276,150 @@ namespace mongo {
         }
     }
 
+    void Cloner::copyCollectionData(OperationContext* txn,
+                                    const string& toDBName,
+                                    const char* from_collection,
+                                    const char* to_collection,
+                                    bool logForRepl,
+                                    bool slaveOk,
+                                    bool mayYield,
+                                    bool mayBeInterrupted,
+                                    bool resumable,
+                                    const string& masterHost) {
+
+        // Network errors early in a large clone are common enough (TCP keepalive
+        // timeouts, rolling restarts of the sync source) that restarting the whole
+        // collection is the dominant cost of an interrupted initial sync.
+        const int maxResumeAttempts = 10;
+
+        Fun f(txn, toDBName);
+        f.numSeen = 0;
+        f.isindex = false;
+        f.from_collection = from_collection;
+        f.to_collection = to_collection;
+        f.saveLast = time( 0 );
+        f.indexesToBuild = NULL;
+        f.logForRepl = logForRepl;
+        f._mayYield = mayYield;
+        f._mayBeInterrupted = mayBeInterrupted;
+        f.trackLastId = resumable;
+
+        Query query;
+        if ( resumable ) {
+            // Resuming by _id requires a stable _id order; capped collections (which may
+            // lack an _id index) pass resumable=false and clone in natural order.
+            query.sort( BSON( "_id" << 1 ) );
+        }
+
+        const int options = QueryOption_NoCursorTimeout | ( slaveOk ? QueryOption_SlaveOk : 0 );
+
+        int attempts = 0;
+        while ( true ) {
+            try {
+                _conn->query(stdx::function<void(DBClientCursorBatchIterator &)>(f),
+                             from_collection, query, 0, options);
+                return;
+            }
+            catch ( const DBException& e ) {
+                if ( !resumable || ++attempts >= maxResumeAttempts )
+                    throw;
+
+                log() << "clone of " << from_collection << " interrupted: " << e.what()
+                      << "; resuming"
+                      << ( f.lastId.isEmpty() ?
+                               string( " from the beginning" ) :
+                               str::stream() << " after _id " << f.lastId.firstElement() )
+                      << " (attempt " << attempts << " of " << maxResumeAttempts << ")";
+
+                // The old connection may be dead; reconnect before reissuing the query.
+                string errmsg;
+                ConnectionString cs = ConnectionString::parse( masterHost, errmsg );
+                auto_ptr<DBClientBase> con( cs.connect( errmsg ) );
+                uassert( 18560, str::stream() << "failed to reconnect to " << masterHost
+                         << " to resume clone of " << from_collection << ": " << errmsg,
+                         con.get() );
+                uassert( 18561, str::stream() << "failed to authenticate to " << masterHost
+                         << " to resume clone of " << from_collection,
+                         repl::replAuthenticate( con.get() ) );
+                _conn = con;
+
+                if ( !f.lastId.isEmpty() ) {
+                    BSONObjBuilder bound;
+                    bound.appendAs( f.lastId.firstElement(), "$gt" );
+                    query = Query( BSON( "_id" << bound.obj() ) ).sort( BSON( "_id" << 1 ) );
+                }
+            }
+        }
+    }
+
+    struct Cloner::ParallelCloneState {
+        ParallelCloneState() : next(0), failed(false), mutex("parallelClone") {}
+
+        struct Job {
+            string from_name;
+            string to_name;
+            bool resumable;
+        };
+
+        // Fixed before the workers start.
+        vector<Job> jobs;
+        string masterHost;
+        string toDBName;
+        bool logForRepl;
+        bool slaveOk;
+        bool mayYield;
+        bool mayBeInterrupted;
+
+        // Guarded by mutex.
+        size_t next;
+        bool failed;
+        string errmsg;
+        SimpleMutex mutex;
+    };
+
+    void Cloner::parallelCloneWorker(ParallelCloneState* state) {
+        Client::initThread("cloneCollection");
+        OperationContextImpl txn;
+
+        try {
+            // Each stream gets its own connection; the cloner's is not thread safe.
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse( state->masterHost, errmsg );
+            auto_ptr<DBClientBase> con( cs.connect( errmsg ) );
+            uassert( 18562, str::stream() << "clone worker couldn't connect to "
+                     << state->masterHost << ": " << errmsg, con.get() );
+            uassert( 18563, str::stream() << "clone worker couldn't authenticate to "
+                     << state->masterHost, repl::replAuthenticate( con.get() ) );
+
+            Cloner cloner;
+            cloner.setConnection( con.release() );
+
+            while ( true ) {
+                ParallelCloneState::Job job;
+                {
+                    SimpleMutex::scoped_lock lk(state->mutex);
+                    if ( state->failed || state->next == state->jobs.size() )
+                        break;
+                    job = state->jobs[state->next++];
+                }
+
+                cloner.copyCollectionData(&txn, state->toDBName,
+                                          job.from_name.c_str(), job.to_name.c_str(),
+                                          state->logForRepl, state->slaveOk,
+                                          state->mayYield, state->mayBeInterrupted,
+                                          job.resumable, state->masterHost);
+            }
+        }
+        catch ( const DBException& e ) {
+            SimpleMutex::scoped_lock lk(state->mutex);
+            state->failed = true;
+            if ( state->errmsg.empty() )
+                state->errmsg = e.toString();
+        }
+
+        cc().shutdown();
+    }
+
     /**
      * validate the cloner query was successful
      * @param cur   Cursor the query was executed on
@@ -466,6 +622,15 @@ namespace mongo {
             }
         }
 
+        // Each parallel stream needs its own connection, so this mode is only used for
+        // remote clones whose writes are not oplogged (replica set initial sync).
+        const bool parallel = opts.parallelCollectionStreams > 1 &&
+                              !masterSameProcess &&
+                              !opts.logForRepl &&
+                              toClone.size() > 1;
+
+        ParallelCloneState state;
+
         for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
             BSONObj collection = *i;
             LOG(2) << "  really will clone: " << collection << endl;
@@ -492,22 +657,45 @@ namespace mongo {
                 return false;
             }
 
+            // Capped collections may lack the _id index resuming sorts on.
+            const bool resumableColl = opts.resumable && !options["capped"].trueValue();
+
+            if ( parallel ) {
+                // Collections are all created (above) before the workers start; the
+                // data is streamed by the worker threads afterwards.
+                ParallelCloneState::Job job;
+                job.from_name = from_name;
+                job.to_name = to_name;
+                job.resumable = resumableColl;
+                state.jobs.push_back( job );
+                continue;
+            }
+
             LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( opts.snapshot )
-                q.snapshot();
-
-            copy(txn,
-                 toDBName,
-                 from_name,
-                 to_name.c_str(),
-                 false,
-                 opts.logForRepl,
-                 masterSameProcess,
-                 opts.slaveOk,
-                 opts.mayYield,
-                 opts.mayBeInterrupted,
-                 q);
+
+            if ( opts.resumable ) {
+                Lock::TempRelease tempRelease(txn->lockState());
+                copyCollectionData(txn, toDBName, from_name, to_name.c_str(),
+                                   opts.logForRepl, opts.slaveOk, opts.mayYield,
+                                   opts.mayBeInterrupted, resumableColl, masterHost);
+            }
+            else {
+                Query q;
+                if( opts.snapshot )
+                    q.snapshot();
+
+                copy(txn,
+                     toDBName,
+                     from_name,
+                     to_name.c_str(),
+                     false,
+                     opts.logForRepl,
+                     masterSameProcess,
+                     opts.slaveOk,
+                     opts.mayYield,
+                     opts.mayBeInterrupted,
+                     q);
+            }
 
             {
                 /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
@@ -528,6 +716,61 @@ namespace mongo {
             }
         }
 
+        if ( parallel && !state.jobs.empty() ) {
+            state.masterHost = masterHost;
+            state.toDBName = toDBName;
+            state.logForRepl = opts.logForRepl;
+            state.slaveOk = opts.slaveOk;
+            state.mayYield = opts.mayYield;
+            state.mayBeInterrupted = opts.mayBeInterrupted;
+
+            LOG(1) << "\t\t cloning " << state.jobs.size() << " collections with "
+                   << opts.parallelCollectionStreams << " streams" << endl;
+
+            {
+                // The workers take their own locks per batch.
+                Lock::TempRelease tempRelease(txn->lockState());
+
+                int nWorkers = opts.parallelCollectionStreams;
+                if ( nWorkers > static_cast<int>( state.jobs.size() ) )
+                    nWorkers = state.jobs.size();
+
+                vector< boost::shared_ptr<boost::thread> > workers;
+                for ( int i = 0; i < nWorkers; i++ ) {
+                    workers.push_back( boost::shared_ptr<boost::thread>(
+                            new boost::thread( &Cloner::parallelCloneWorker, &state ) ) );
+                }
+                for ( int i = 0; i < nWorkers; i++ ) {
+                    workers[i]->join();
+                }
+            }
+
+            if ( state.failed ) {
+                errmsg = state.errmsg.empty() ? "parallel collection clone failed"
+                                              : state.errmsg;
+                return false;
+            }
+
+            // Deferred _id index builds, as in the serial path above.
+            for ( size_t i = 0; i < state.jobs.size(); i++ ) {
+                bool unused;
+                Database* db = dbHolder().getOrCreate(txn, toDBName, unused);
+
+                bool old = inDBRepair;
+                try {
+                    inDBRepair = true;
+                    Collection* c = db->getCollection( txn, state.jobs[i].to_name );
+                    if ( c )
+                        c->getIndexCatalog()->ensureHaveIdIndex(txn);
+                    inDBRepair = old;
+                }
+                catch(...) {
+                    inDBRepair = old;
+                    throw;
+                }
+            }
+        }
+
         // now build the indexes
         
         if ( opts.syncIndexes ) {
@@ -81,6 +81,29 @@ namespace mongo {
                   bool mayBeInterrupted,
                   Query q);
 
+        /**
+         * Copies the data (not indexes) of one collection.  When 'resumable' is true the
+         * clone query is sorted by _id and, after a transient network error, reconnects
+         * to 'masterHost' and reissues the query from just past the last _id cloned
+         * rather than restarting the collection.
+         *
+         * Unlike copy(), expects no database lock to be held by the caller.
+         */
+        void copyCollectionData(OperationContext* txn,
+                                const std::string& toDBName,
+                                const char* from_collection,
+                                const char* to_collection,
+                                bool logForRepl,
+                                bool slaveOk,
+                                bool mayYield,
+                                bool mayBeInterrupted,
+                                bool resumable,
+                                const std::string& masterHost);
+
+        // Shared work queue for parallel collection cloning; defined in cloner.cpp.
+        struct ParallelCloneState;
+        static void parallelCloneWorker(ParallelCloneState* state);
+
         struct Fun;
         std::auto_ptr<DBClientBase> _conn;
     };
@@ -103,6 +126,9 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+
+            parallelCollectionStreams = 1;
+            resumable = false;
         }
 
         std::string fromDB;
@@ -117,6 +143,15 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // When > 1, collections are cloned by this many worker threads, each streaming a
+        // different collection over its own connection.  Only used when cloning from a
+        // remote host without oplogging the writes (e.g. replica set initial sync).
+        int parallelCollectionStreams;
+
+        // Clone each (non-capped) collection sorted by _id so a network error resumes
+        // from the last _id cloned instead of restarting the collection.
+        bool resumable;
     };
 
 } // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/db/commands/dbhash.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/matcher/matcher.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/operation_context_impl.h"
 
@@ -81,9 +82,52 @@ namespace mongo {
                 }
             }
 
-            // SERVER-4328 todo : is global ok or does this take a long time? i believe multiple 
+            // When every operation (and precondition) targets a single database,
+            // the batch can run under that database's write lock instead of
+            // stopping the whole server; the yield-prevention scheme below works
+            // the same way since the per-op DBWrite nests inside either lock.
+            // Commands ('c' ops) may touch state outside their database and drop
+            // namespaces out from under us, so they keep the global lock, as does
+            // anything we cannot cheaply pin to one database up front.
+            bool canUseDbLock = true;
+            string singleDb;
+            {
+                BSONObjIterator i( ops );
+                while ( canUseDbLock && i.more() ) {
+                    BSONObj op = i.next().Obj();
+                    if ( *op.getStringField( "op" ) == 'c' || op["ns"].type() != String ) {
+                        canUseDbLock = false;
+                        break;
+                    }
+                    const string db = nsToDatabase( op["ns"].String() );
+                    if ( singleDb.empty() )
+                        singleDb = db;
+                    else if ( singleDb != db )
+                        canUseDbLock = false;
+                }
+                if ( canUseDbLock && singleDb.empty() )
+                    canUseDbLock = false;
+                if ( canUseDbLock && cmdObj["preCondition"].type() == Array ) {
+                    BSONObjIterator pc( cmdObj["preCondition"].Obj() );
+                    while ( canUseDbLock && pc.more() ) {
+                        BSONObj f = pc.next().Obj();
+                        if ( f["ns"].type() != String ||
+                             nsToDatabase( f["ns"].String() ) != singleDb ) {
+                            canUseDbLock = false;
+                        }
+                    }
+                }
+            }
+
+            // SERVER-4328 todo : is global ok or does this take a long time? i believe multiple
             // ns used so locking individually requires more analysis
-            Lock::GlobalWrite globalWriteLock(txn->lockState());
+            scoped_ptr<Lock::ScopedLock> writeLock;
+            if ( canUseDbLock ) {
+                writeLock.reset( new Lock::DBWrite( txn->lockState(), singleDb ) );
+            }
+            else {
+                writeLock.reset( new Lock::GlobalWrite( txn->lockState() ) );
+            }
 
             DBDirectClient db(txn);
 
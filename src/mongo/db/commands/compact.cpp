@@ -66,7 +66,11 @@ namespace mongo {
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
                 "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "{ compact : <collection_name>, incremental: true, [maxMoves:<num>] }\n"
+                "  incremental - online mode: moves up to maxMoves (default 10000) documents out of\n"
+                "  the oldest extent in short write-lock slices and frees the extent once empty.\n"
+                "  indexes stay online; repeated (e.g. cron-driven) invocations resume automatically\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -81,6 +85,76 @@ namespace mongo {
             return IndexBuilder::killMatchingIndexBuilds(db->getCollection(opCtx, ns), criteria);
         }
 
+        /**
+         * Online mode: moves documents out of the collection's oldest extent through
+         * the normal unindex/reindex machinery and frees the extent once empty.  The
+         * database write lock is taken per small batch rather than for the whole run,
+         * each batch yields as soon as another operation queues behind the lock, and
+         * the whole invocation competes only for the low-priority share of the
+         * admission ticket pool, so foreground traffic keeps flowing.  Progress is
+         * structural -- moved documents are no longer in the head extent -- so
+         * repeated cron-driven invocations resume where the last one stopped without
+         * any persisted state.
+         */
+        bool runIncremental(OperationContext* txn,
+                            const NamespaceString& ns,
+                            const BSONObj& cmdObj,
+                            string& errmsg,
+                            BSONObjBuilder& result) {
+
+            long long maxMoves = 10000;
+            if ( cmdObj.hasElement( "maxMoves" ) ) {
+                maxMoves = cmdObj["maxMoves"].numberLong();
+                if ( maxMoves <= 0 ) {
+                    errmsg = "invalid maxMoves";
+                    return false;
+                }
+            }
+
+            // the I/O budget: only the low-priority slice of the write ticket pool
+            // (see admissionControlLowPriorityWeight), and immediate yielding to any
+            // normal-priority operation
+            Lock::ScopedAdmissionPriority lowPriority( txn->lockState(), -1 );
+
+            long long moved = 0;
+            long long extentsFreed = 0;
+            bool done = false;
+
+            while ( moved < maxMoves && !done ) {
+                Lock::DBWrite lk( txn->lockState(), ns.ns() );
+                Client::Context ctx( ns );
+
+                Collection* collection = ctx.db()->getCollection( txn, ns.ns() );
+                if ( !collection ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+
+                BackgroundOperation::assertNoBgOpInProgForNs( ns.ns() );
+
+                // the batch size caps how long one lock hold can run; the step also
+                // exits early when another operation queues behind the lock
+                long long batch = maxMoves - moved;
+                if ( batch > 256 )
+                    batch = 256;
+
+                bool extentFreed = false;
+                StatusWith<long long> res =
+                    collection->compactHeadExtentStep( txn, batch, &extentFreed, &done );
+                if ( !res.isOK() )
+                    return appendCommandStatus( result, res.getStatus() );
+
+                moved += res.getValue();
+                if ( extentFreed )
+                    extentsFreed++;
+            }
+
+            result.appendNumber( "movedRecords", moved );
+            result.appendNumber( "extentsFreed", extentsFreed );
+            result.appendBool( "done", done );
+            return true;
+        }
+
         virtual bool run(OperationContext* txn, const string& db, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
             string coll = cmdObj.firstElement().valuestr();
             if( coll.empty() || db.empty() ) {
@@ -88,7 +162,9 @@ namespace mongo {
                 return false;
             }
 
-            if (repl::isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue()) {
+            // incremental mode is bounded, online work - fine on a primary
+            if (repl::isCurrentlyAReplSetPrimary() && !cmdObj["incremental"].trueValue() &&
+                    !cmdObj["force"].trueValue()) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -106,6 +182,10 @@ namespace mongo {
                 return false;
             }
 
+            if ( cmdObj["incremental"].trueValue() ) {
+                return runIncremental( txn, ns, cmdObj, errmsg, result );
+            }
+
             CompactOptions compactOptions;
 
             if ( cmdObj["preservePadding"].trueValue() ) {
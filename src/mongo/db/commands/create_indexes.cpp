@@ -31,6 +31,7 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_create.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/ops/insert.h"
@@ -174,6 +175,64 @@ namespace mongo {
 
             result.append( "numIndexesBefore", collection->getIndexCatalog()->numIndexesTotal() );
 
+            // When several foreground, non-unique indexes are requested together, build
+            // them off a single scan of the collection, with each document feeding every
+            // key generator, rather than paying one full collection scan per index.
+            // Background builds have to yield and unique builds need per-index duplicate
+            // handling, so both keep using the one-at-a-time path below.
+            bool useSharedScan = specs.size() > 1 && collection->numRecords() > 0;
+            for ( size_t i = 0; i < specs.size() && useSharedScan; i++ ) {
+                if ( specs[i]["background"].trueValue() || specs[i]["unique"].trueValue() )
+                    useSharedScan = false;
+            }
+
+            if ( useSharedScan ) {
+                MultiIndexBlock indexer( txn, collection );
+                status = indexer.init( specs );
+                if ( status.isOK() ) {
+                    InsertDeleteOptions indexOptions;
+                    indexOptions.logIfError = false;
+                    indexOptions.dupsAllowed = true; // no unique indexes here, see above
+
+                    scoped_ptr<RecordIterator> iterator(
+                            collection->getIterator( DiskLoc(),
+                                                     false,
+                                                     CollectionScanParams::FORWARD ) );
+                    while ( !iterator->isEOF() ) {
+                        DiskLoc loc = iterator->getNext();
+                        BSONObj doc = collection->docFor( loc );
+
+                        status = indexer.insert( doc, loc, indexOptions );
+                        if ( !status.isOK() )
+                            return appendCommandStatus( result, status );
+
+                        txn->recoveryUnit()->commitIfNeeded();
+                        RARELY txn->checkForInterrupt();
+                    }
+
+                    status = indexer.commit();
+                    if ( !status.isOK() )
+                        return appendCommandStatus( result, status );
+
+                    if ( !fromRepl ) {
+                        std::string systemIndexes = ns.getSystemIndexesCollection();
+                        for ( size_t i = 0; i < specs.size(); i++ )
+                            repl::logOp( txn, "i", systemIndexes.c_str(), specs[i] );
+                    }
+
+                    result.append( "numIndexesAfter",
+                                   collection->getIndexCatalog()->numIndexesTotal() );
+                    return true;
+                }
+
+                if ( status.code() != ErrorCodes::IndexAlreadyExists )
+                    return appendCommandStatus( result, status );
+
+                // We raced with someone else creating one of these indexes since the
+                // check above; the indexer's cleanup runs here, and the loop below
+                // handles already-existing indexes gracefully.
+            }
+
             for ( size_t i = 0; i < specs.size(); i++ ) {
                 BSONObj spec = specs[i];
 
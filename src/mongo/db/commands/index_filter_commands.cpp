@@ -103,6 +103,9 @@ namespace {
         new ListFilters();
         new ClearFilters();
         new SetFilter();
+        new ListScanLimits();
+        new ClearScanLimits();
+        new SetScanLimits();
 
         return Status::OK();
     }
@@ -375,4 +378,171 @@ namespace mongo {
         return Status::OK();
     }
 
+    ListScanLimits::ListScanLimits() : IndexFilterCommand("planCacheListScanLimits",
+        "Displays scan limits for all query shapes in a collection.") { }
+
+    Status ListScanLimits::runIndexFilterCommand(OperationContext* txn,
+                                                 const string& ns,
+                                                 BSONObj& cmdObj,
+                                                 BSONObjBuilder* bob) {
+        // This is a read lock. The query settings is owned by the collection.
+        Client::ReadContext readCtx(txn, ns);
+        Client::Context& ctx = readCtx.ctx();
+        QuerySettings* querySettings;
+        PlanCache* unused;
+        Status status = getQuerySettingsAndPlanCache(txn, ctx.db(), ns, &querySettings, &unused);
+        if (!status.isOK()) {
+            // No collection - return empty array of limits.
+            BSONArrayBuilder limitsBuilder(bob->subarrayStart("scanLimits"));
+            limitsBuilder.doneFast();
+            return Status::OK();
+        }
+        return list(*querySettings, bob);
+    }
+
+    // static
+    Status ListScanLimits::list(const QuerySettings& querySettings, BSONObjBuilder* bob) {
+        invariant(bob);
+
+        // Format of BSON result:
+        //
+        // {
+        //     scanLimits: [
+        //         {
+        //             query: <query>,
+        //             sort: <sort>,
+        //             projection: <projection>,
+        //             maxDocsExamined: <n>,
+        //             maxKeysExamined: <n>
+        //         }
+        //  }
+        BSONArrayBuilder limitsBuilder(bob->subarrayStart("scanLimits"));
+        OwnedPointerVector<ScanLimitsEntry> entries;
+        entries.mutableVector() = querySettings.getAllScanLimits();
+        for (vector<ScanLimitsEntry*>::const_iterator i = entries.begin();
+             i != entries.end(); ++i) {
+            ScanLimitsEntry* entry = *i;
+            invariant(entry);
+
+            BSONObjBuilder limitBob(limitsBuilder.subobjStart());
+            limitBob.append("query", entry->query);
+            limitBob.append("sort", entry->sort);
+            limitBob.append("projection", entry->projection);
+            limitBob.append("maxDocsExamined", entry->limits.maxDocsExamined);
+            limitBob.append("maxKeysExamined", entry->limits.maxKeysExamined);
+        }
+        limitsBuilder.doneFast();
+        return Status::OK();
+    }
+
+    ClearScanLimits::ClearScanLimits() : IndexFilterCommand("planCacheClearScanLimits",
+        "Clears scan limits for a single query shape or, "
+        "if the query shape is omitted, all scan limits for the collection.") { }
+
+    Status ClearScanLimits::runIndexFilterCommand(OperationContext* txn,
+                                                  const std::string& ns,
+                                                  BSONObj& cmdObj,
+                                                  BSONObjBuilder* bob) {
+        // This is a read lock. The query settings is owned by the collection.
+        Client::ReadContext readCtx(txn, ns);
+        Client::Context& ctx = readCtx.ctx();
+        QuerySettings* querySettings;
+        PlanCache* unused;
+        Status status = getQuerySettingsAndPlanCache(txn, ctx.db(), ns, &querySettings, &unused);
+        if (!status.isOK()) {
+            // No collection - do nothing.
+            return Status::OK();
+        }
+        return clear(querySettings, ns, cmdObj);
+    }
+
+    // static
+    Status ClearScanLimits::clear(QuerySettings* querySettings, const std::string& ns,
+                                  const BSONObj& cmdObj) {
+        invariant(querySettings);
+
+        // Scan limits do not influence plan selection, so unlike ClearFilters
+        // there are no plan cache entries to invalidate here.
+        if (cmdObj.hasField("query")) {
+            CanonicalQuery* cqRaw;
+            Status status = PlanCacheCommand::canonicalize(ns, cmdObj, &cqRaw);
+            if (!status.isOK()) {
+                return status;
+            }
+
+            scoped_ptr<CanonicalQuery> cq(cqRaw);
+            querySettings->removeScanLimits(*cq);
+            return Status::OK();
+        }
+
+        // If query is not provided, make sure sort and projection are not in arguments.
+        // We do not want to clear all limits inadvertently when the user
+        // forgot to provide a value for "query".
+        if (cmdObj.hasField("sort") || cmdObj.hasField("projection")) {
+            return Status(ErrorCodes::BadValue, "sort or projection provided without query");
+        }
+
+        querySettings->clearScanLimits();
+        return Status::OK();
+    }
+
+    SetScanLimits::SetScanLimits() : IndexFilterCommand("planCacheSetScanLimits",
+        "Sets scan limits for a query shape. Overrides existing limits.") { }
+
+    Status SetScanLimits::runIndexFilterCommand(OperationContext* txn,
+                                                const std::string& ns,
+                                                BSONObj& cmdObj,
+                                                BSONObjBuilder* bob) {
+        // This is a read lock. The query settings is owned by the collection.
+        Client::ReadContext readCtx(txn, ns);
+        Client::Context& ctx = readCtx.ctx();
+        QuerySettings* querySettings;
+        PlanCache* unused;
+        Status status = getQuerySettingsAndPlanCache(txn, ctx.db(), ns, &querySettings, &unused);
+        if (!status.isOK()) {
+            return status;
+        }
+        return set(querySettings, ns, cmdObj);
+    }
+
+    // static
+    Status SetScanLimits::set(QuerySettings* querySettings, const string& ns,
+                              const BSONObj& cmdObj) {
+        ScanLimits limits;
+
+        BSONElement maxDocsElt = cmdObj.getField("maxDocsExamined");
+        if (!maxDocsElt.eoo()) {
+            if (!maxDocsElt.isNumber()) {
+                return Status(ErrorCodes::BadValue, "maxDocsExamined must be a number");
+            }
+            limits.maxDocsExamined = maxDocsElt.numberLong();
+        }
+
+        BSONElement maxKeysElt = cmdObj.getField("maxKeysExamined");
+        if (!maxKeysElt.eoo()) {
+            if (!maxKeysElt.isNumber()) {
+                return Status(ErrorCodes::BadValue, "maxKeysExamined must be a number");
+            }
+            limits.maxKeysExamined = maxKeysElt.numberLong();
+        }
+
+        if (limits.maxDocsExamined <= 0 && limits.maxKeysExamined <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "at least one of maxDocsExamined and maxKeysExamined "
+                          "must be a positive number");
+        }
+
+        CanonicalQuery* cqRaw;
+        Status status = PlanCacheCommand::canonicalize(ns, cmdObj, &cqRaw);
+        if (!status.isOK()) {
+            return status;
+        }
+        scoped_ptr<CanonicalQuery> cq(cqRaw);
+
+        // Add scan limits to query settings, overriding any previous entries.
+        querySettings->setScanLimits(*cq, limits);
+
+        return Status::OK();
+    }
+
 } // namespace mongo
@@ -35,11 +35,13 @@
 namespace mongo {
 
     /**
-     * DB commands for index filters.
+     * DB commands for index filters and per-shape scan limits.
      * Index filter commands work on a different data structure in the collection
      * info cache from the plan cache.
      * The user still thinks of index filter commands as part of the plan cache functionality
      * so the command name prefix is still "planCache".
+     * Scan limit commands store per-shape execution limits in the same query settings
+     * structure; see ScanLimits in query_settings.h.
      *
      * These are in a header to facilitate unit testing. See index_filter_commands_test.cpp.
      */
@@ -171,4 +173,81 @@ namespace mongo {
                           const BSONObj& cmdObj);
     };
 
+    /**
+     * ListScanLimits
+     *
+     * { planCacheListScanLimits: <collection> }
+     *
+     */
+    class ListScanLimits : public IndexFilterCommand {
+    public:
+        ListScanLimits();
+
+        virtual Status runIndexFilterCommand(OperationContext* txn,
+                                             const std::string& ns,
+                                             BSONObj& cmdObj,
+                                             BSONObjBuilder* bob);
+
+        /**
+         * Looks up scan limits from collection's query settings.
+         * Inserts scan limits into BSON builder.
+         */
+        static Status list(const QuerySettings& querySettings, BSONObjBuilder* bob);
+    };
+
+    /**
+     * ClearScanLimits
+     *
+     * { planCacheClearScanLimits: <collection>, query: <query>, sort: <sort>,
+     *   projection: <projection> }
+     *
+     */
+    class ClearScanLimits : public IndexFilterCommand {
+    public:
+        ClearScanLimits();
+
+        virtual Status runIndexFilterCommand(OperationContext* txn,
+                                             const std::string& ns,
+                                             BSONObj& cmdObj,
+                                             BSONObjBuilder* bob);
+
+        /**
+         * If query shape is provided, clears scan limits for that shape.
+         * Otherwise, clears the collection's scan limits.
+         * Unlike index filters, scan limits do not affect planning, so the
+         * plan cache is left alone.
+         */
+        static Status clear(QuerySettings* querySettings, const std::string& ns,
+                            const BSONObj& cmdObj);
+    };
+
+    /**
+     * SetScanLimits
+     *
+     * {
+     *     planCacheSetScanLimits: <collection>,
+     *     query: <query>,
+     *     sort: <sort>,
+     *     projection: <projection>,
+     *     maxDocsExamined: <n>,
+     *     maxKeysExamined: <n>
+     * }
+     *
+     */
+    class SetScanLimits : public IndexFilterCommand {
+    public:
+        SetScanLimits();
+
+        virtual Status runIndexFilterCommand(OperationContext* txn,
+                                             const std::string& ns,
+                                             BSONObj& cmdObj,
+                                             BSONObjBuilder* bob);
+
+        /**
+         * Sets scan limits for a query shape. Overrides existing limits.
+         */
+        static Status set(QuerySettings* querySettings, const std::string& ns,
+                          const BSONObj& cmdObj);
+    };
+
 }  // namespace mongo
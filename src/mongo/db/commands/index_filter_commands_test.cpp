@@ -317,4 +317,108 @@ namespace {
         ASSERT_FALSE(planCacheContains(planCache, "{b: 1}", "{}", "{}"));
     }
 
+    /**
+     * Utility function to get list of scan limits from the query settings.
+     */
+    vector<BSONObj> getScanLimits(const QuerySettings& querySettings) {
+        BSONObjBuilder bob;
+        ASSERT_OK(ListScanLimits::list(querySettings, &bob));
+        BSONObj resultObj = bob.obj();
+        BSONElement limitsElt = resultObj.getField("scanLimits");
+        ASSERT_EQUALS(limitsElt.type(), mongo::Array);
+        vector<BSONElement> limitsEltArray = limitsElt.Array();
+        vector<BSONObj> limits;
+        for (vector<BSONElement>::const_iterator i = limitsEltArray.begin();
+             i != limitsEltArray.end(); ++i) {
+            const BSONElement& elt = *i;
+            ASSERT_TRUE(elt.isABSONObj());
+            limits.push_back(elt.Obj().getOwned());
+        }
+        return limits;
+    }
+
+    /**
+     * Tests for scan limit commands
+     */
+
+    TEST(IndexFilterCommandsTest, ListScanLimitsEmpty) {
+        QuerySettings empty;
+        vector<BSONObj> limits = getScanLimits(empty);
+        ASSERT_TRUE(limits.empty());
+    }
+
+    TEST(IndexFilterCommandsTest, SetScanLimitsInvalidParameter) {
+        QuerySettings empty;
+        // Missing required query field.
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns, fromjson("{maxDocsExamined: 1000}")));
+        // At least one limit is required.
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns, fromjson("{query: {a: 1}}")));
+        // Limits must be numbers.
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns,
+            fromjson("{query: {a: 1}, maxDocsExamined: 'lots'}")));
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns,
+            fromjson("{query: {a: 1}, maxKeysExamined: [1]}")));
+        // A limit that is present must be positive.
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns,
+            fromjson("{query: {a: 1}, maxDocsExamined: 0, maxKeysExamined: -5}")));
+        // Query must pass canonicalization.
+        ASSERT_NOT_OK(SetScanLimits::set(&empty, ns,
+            fromjson("{query: {a: {$no_such_op: 1}}, maxDocsExamined: 1000}")));
+    }
+
+    TEST(IndexFilterCommandsTest, ClearScanLimitsInvalidParameter) {
+        QuerySettings empty;
+        // Sort present without query is an error.
+        ASSERT_NOT_OK(ClearScanLimits::clear(&empty, ns, fromjson("{sort: {a: 1}}")));
+        // Projection present without query is an error.
+        ASSERT_NOT_OK(ClearScanLimits::clear(&empty, ns,
+            fromjson("{projection: {_id: 0, a: 1}}")));
+    }
+
+    TEST(IndexFilterCommandsTest, SetAndClearScanLimits) {
+        QuerySettings querySettings;
+
+        ASSERT_OK(SetScanLimits::set(&querySettings, ns,
+            fromjson("{query: {a: 1, b: 1}, maxDocsExamined: 1000, maxKeysExamined: 5000}")));
+        vector<BSONObj> limits = getScanLimits(querySettings);
+        ASSERT_EQUALS(limits.size(), 1U);
+        ASSERT_EQUALS(limits[0].getObjectField("query"), fromjson("{a: 1, b: 1}"));
+        ASSERT_EQUALS(limits[0]["maxDocsExamined"].numberLong(), 1000);
+        ASSERT_EQUALS(limits[0]["maxKeysExamined"].numberLong(), 5000);
+
+        // Replacing limits for the same query shape ({a: 1, b: 1} and {b: 2, a: 3}
+        // share same shape) should not change the query settings size.
+        ASSERT_OK(SetScanLimits::set(&querySettings, ns,
+            fromjson("{query: {b: 2, a: 3}, maxDocsExamined: 200}")));
+        limits = getScanLimits(querySettings);
+        ASSERT_EQUALS(limits.size(), 1U);
+        ASSERT_EQUALS(limits[0]["maxDocsExamined"].numberLong(), 200);
+        ASSERT_EQUALS(limits[0]["maxKeysExamined"].numberLong(), 0);
+
+        // Limits for a different query shape get their own entry.
+        ASSERT_OK(SetScanLimits::set(&querySettings, ns,
+            fromjson("{query: {b: 1}, maxKeysExamined: 100}")));
+        limits = getScanLimits(querySettings);
+        ASSERT_EQUALS(limits.size(), 2U);
+
+        // Scan limits are stored separately from index filters.
+        vector<BSONObj> filters = getFilters(querySettings);
+        ASSERT_TRUE(filters.empty());
+
+        // Clearing a nonexistent shape succeeds and changes nothing.
+        ASSERT_OK(ClearScanLimits::clear(&querySettings, ns, fromjson("{query: {c: 1}}")));
+        limits = getScanLimits(querySettings);
+        ASSERT_EQUALS(limits.size(), 2U);
+
+        // Clear single shape.
+        ASSERT_OK(ClearScanLimits::clear(&querySettings, ns, fromjson("{query: {b: 1}}")));
+        limits = getScanLimits(querySettings);
+        ASSERT_EQUALS(limits.size(), 1U);
+
+        // Clear all limits.
+        ASSERT_OK(ClearScanLimits::clear(&querySettings, ns, fromjson("{}")));
+        limits = getScanLimits(querySettings);
+        ASSERT_TRUE(limits.empty());
+    }
+
 }  // namespace
@@ -1208,10 +1208,117 @@ namespace mongo {
                 addPrivilegesRequiredForMapReduce(this, dbname, cmdObj, out);
             }
 
+            /**
+             * Native execution for expression-based jobs: when 'map' is the object
+             * { key: <expression>, value: <expression> } and 'reduce' names an
+             * associative accumulator ("sum", "min", "max", "avg", "push",
+             * "addToSet"), the job is rewritten as
+             *
+             *   [ $match, $sort, $limit, { $group: { _id: key, value: { $op: value } } }, $out ]
+             *
+             * and run through the aggregation command.  The common "map emits one
+             * k/v per document, reduce is associative" shape thereby skips the JS
+             * engine and the temp-collection machinery entirely.
+             */
+            bool runExpressionJob( const string& dbname,
+                                   const BSONObj& cmd,
+                                   string& errmsg,
+                                   BSONObjBuilder& result ) {
+                Timer t;
+
+                uassert( 18567,
+                         "expression-based mapReduce does not support sharded input "
+                         "collections; use an aggregation pipeline",
+                         !cmd["shardedFirstPass"].trueValue() );
+
+                const BSONObj map = cmd["map"].embeddedObjectUserCheck();
+                uassert( 18568,
+                         "expression-based map must be { key: <expression>, value: <expression> }",
+                         map.nFields() == 2 && map.hasField( "key" ) && map.hasField( "value" ) );
+
+                uassert( 18569,
+                         "expression-based mapReduce does not support finalize, scope or mapparams",
+                         !cmd["finalize"].trueValue() && cmd["scope"].eoo() &&
+                            cmd["mapparams"].eoo() );
+
+                const string reduceName = cmd["reduce"].str();
+                string accumulator;
+                if ( reduceName == "sum" )            accumulator = "$sum";
+                else if ( reduceName == "min" )       accumulator = "$min";
+                else if ( reduceName == "max" )       accumulator = "$max";
+                else if ( reduceName == "avg" )       accumulator = "$avg";
+                else if ( reduceName == "push" )      accumulator = "$push";
+                else if ( reduceName == "addToSet" )  accumulator = "$addToSet";
+                uassert( 18570,
+                         str::stream() << "expression-based reduce must name an associative "
+                                       << "accumulator (sum, min, max, avg, push, addToSet): "
+                                       << reduceName,
+                         !accumulator.empty() );
+
+                Config::OutputOptions outputOptions = Config::parseOutputOptions( dbname, cmd );
+                uassert( 18571,
+                         "expression-based mapReduce output must be 'inline' or 'replace'",
+                         outputOptions.outType == Config::INMEMORY ||
+                            outputOptions.outType == Config::REPLACE );
+                uassert( 18572,
+                         "expression-based mapReduce cannot output to another database",
+                         outputOptions.outDB.empty() || outputOptions.outDB == dbname );
+
+                BSONArrayBuilder pipeline;
+                if ( cmd["query"].type() == Object )
+                    pipeline.append( BSON( "$match" << cmd["query"].Obj() ) );
+                if ( cmd["sort"].type() == Object )
+                    pipeline.append( BSON( "$sort" << cmd["sort"].Obj() ) );
+                if ( cmd["limit"].isNumber() )
+                    pipeline.append( BSON( "$limit" << cmd["limit"].numberLong() ) );
+                {
+                    BSONObjBuilder groupStage( pipeline.subobjStart() );
+                    BSONObjBuilder groupSpec( groupStage.subobjStart( "$group" ) );
+                    groupSpec.appendAs( map["key"], "_id" );
+                    BSONObjBuilder acc( groupSpec.subobjStart( "value" ) );
+                    acc.appendAs( map["value"], accumulator );
+                    acc.done();
+                    groupSpec.done();
+                    groupStage.done();
+                }
+                if ( outputOptions.outType == Config::REPLACE )
+                    pipeline.append( BSON( "$out" << outputOptions.collectionName ) );
+
+                const BSONObj aggCmd =
+                    BSON( "aggregate" << cmd.firstElement().valuestr()
+                                      << "pipeline" << pipeline.arr() );
+
+                DBDirectClient db;
+                BSONObj res;
+                if ( !db.runCommand( dbname, aggCmd, res ) ) {
+                    errmsg = res["errmsg"].str();
+                    return false;
+                }
+
+                long long outputCount;
+                if ( outputOptions.outType == Config::INMEMORY ) {
+                    const vector<BSONElement> docs = res["result"].Array();
+                    outputCount = docs.size();
+                    result.appendAs( res["result"], "results" );
+                }
+                else {
+                    outputCount = db.count( outputOptions.finalNamespace );
+                    result.append( "result", outputOptions.collectionName );
+                }
+                result.append( "timeMillis", t.millis() );
+                result.append( "counts", BSON( "output" << outputCount ) );
+                return true;
+            }
+
             bool run(OperationContext* txn, const string& dbname , BSONObj& cmd, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
                 Timer t;
                 CurOp* op = txn->getCurOp();
 
+                if ( cmd["map"].type() == Object ) {
+                    // not a JS function: the expression-based fast path
+                    return runExpressionJob( dbname, cmd, errmsg, result );
+                }
+
                 Config config( dbname , cmd );
 
                 LOG(1) << "mr ns: " << config.ns << endl;
@@ -0,0 +1,305 @@
+/**
+ * Copyright (C) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include <string>
+
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/auth/resource_pattern.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/oplogstart.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/find_constants.h"
+#include "mongo/db/query/internal_runner.h"
+#include "mongo/db/query/single_solution_runner.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+
+        /**
+         * Returns true if 'me' is a GT or GTE predicate over the "ts" field;
+         * such predicates can seed the oplog start-finding stage.
+         */
+        bool isOplogTsPred(const MatchExpression* me) {
+            if (MatchExpression::GT != me->matchType()
+                && MatchExpression::GTE != me->matchType()) {
+                return false;
+            }
+
+            return mongoutils::str::equals(me->path().rawData(), "ts");
+        }
+
+    }  // namespace
+
+    /**
+     * Change capture for downstream consumers: opens a tailable, awaitData cursor over the
+     * oplog with the namespace filter, any extra filter and the projection all applied
+     * server side, so consumers stop shipping and decoding entries they are going to
+     * discard.  Matching runs against the mapped oplog entry before anything is copied
+     * into the reply; only entries that pass the filter are projected and returned.
+     *
+     * {
+     *     oplogTail: 1,
+     *     ts: <Timestamp>,            // resume point, inclusive; required
+     *     ns: <string or array>,      // only return entries for these namespaces; optional
+     *     filter: <match expression>, // extra filter over entries (op, o, o2, ...); optional
+     *     projection: <projection>,   // applied to each returned entry; optional
+     *     cursor: { batchSize: <n> }  // optional
+     * }
+     *
+     * Returns { cursor: { id: <cursorid>, ns: <oplog ns>, firstBatch: [...] } }.
+     * Subsequent batches are fetched with normal getMore on the oplog namespace; the
+     * cursor blocks briefly for new entries (awaitData) like any oplog tail.
+     */
+    class OplogTailCmd : public Command {
+    public:
+        OplogTailCmd() : Command( "oplogTail" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help( stringstream &help ) const {
+            help << "Opens a tailable cursor over the oplog with server-side "
+                    "filtering and projection";
+        }
+        virtual Status checkAuthForCommand(ClientBasic* client,
+                                           const std::string& dbname,
+                                           const BSONObj& cmdObj) {
+            // The oplog lives in either local.oplog.rs (replica sets) or
+            // local.oplog.$main (master/slave); find access to either will do.
+            AuthorizationSession* authzSession = client->getAuthorizationSession();
+            if (authzSession->isAuthorizedForActionsOnResource(
+                    ResourcePattern::forExactNamespace(NamespaceString("local.oplog.rs")),
+                    ActionType::find) ||
+                authzSession->isAuthorizedForActionsOnResource(
+                    ResourcePattern::forExactNamespace(NamespaceString("local.oplog.$main")),
+                    ActionType::find)) {
+                return Status::OK();
+            }
+            return Status(ErrorCodes::Unauthorized, "Unauthorized");
+        }
+        virtual bool run(OperationContext* txn, const string& dbname,
+                         BSONObj& cmdObj,
+                         int,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            // Starting timestamp is required: consumers resume from where they left off.
+            BSONElement tsElt = cmdObj["ts"];
+            if (Timestamp != tsElt.type()) {
+                return appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                        "required field ts must be a Timestamp"));
+            }
+
+            // Build the oplog query. Repeated top-level fields are conjoined by the match
+            // expression parser, so the extra filter's clauses can be appended directly
+            // even if they also constrain ts or ns.
+            BSONObjBuilder queryBob;
+            {
+                BSONObjBuilder tsBob(queryBob.subobjStart("ts"));
+                tsBob.appendAs(tsElt, "$gte");
+                tsBob.doneFast();
+            }
+
+            BSONElement nsElt = cmdObj["ns"];
+            if (String == nsElt.type()) {
+                queryBob.append("ns", nsElt.String());
+            }
+            else if (mongo::Array == nsElt.type()) {
+                BSONObjBuilder nsBob(queryBob.subobjStart("ns"));
+                nsBob.appendAs(nsElt, "$in");
+                nsBob.doneFast();
+            }
+            else if (!nsElt.eoo()) {
+                return appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                        "ns must be a string or an array of strings"));
+            }
+
+            BSONElement filterElt = cmdObj["filter"];
+            if (Object == filterElt.type()) {
+                BSONObjIterator it(filterElt.Obj());
+                while (it.more()) {
+                    queryBob.append(it.next());
+                }
+            }
+            else if (!filterElt.eoo()) {
+                return appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                        "filter must be an object"));
+            }
+
+            BSONObj queryObj = queryBob.obj();
+
+            BSONObj projObj;
+            BSONElement projElt = cmdObj["projection"];
+            if (Object == projElt.type()) {
+                projObj = projElt.Obj();
+            }
+            else if (!projElt.eoo()) {
+                return appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                        "projection must be an object"));
+            }
+
+            // The cursor and runner must be created under the same lock acquisition.
+            Client::ReadContext ctx(txn, "local.oplog.rs");
+
+            // Resolve whichever oplog this node has.
+            string oplogNs = "local.oplog.rs";
+            Collection* collection = ctx.ctx().db()->getCollection(txn, oplogNs);
+            if (NULL == collection) {
+                oplogNs = "local.oplog.$main";
+                collection = ctx.ctx().db()->getCollection(txn, oplogNs);
+            }
+            if (NULL == collection) {
+                return appendCommandStatus(result, Status(ErrorCodes::NamespaceNotFound,
+                        "node does not have an oplog"));
+            }
+
+            CanonicalQuery* cqRaw;
+            Status canonStatus = CanonicalQuery::canonicalize(
+                    oplogNs, queryObj, BSONObj(), projObj, &cqRaw);
+            if (!canonStatus.isOK()) {
+                return appendCommandStatus(result, canonStatus);
+            }
+            auto_ptr<CanonicalQuery> cq(cqRaw);
+
+            // Find the ts predicate so the scan can start near the resume point instead of
+            // at the head of the oplog; same extraction as the OplogReplay start hack.
+            MatchExpression* tsExpr = NULL;
+            if (MatchExpression::AND == cq->root()->matchType()) {
+                for (size_t i = 0; i < cq->root()->numChildren(); ++i) {
+                    MatchExpression* me = cq->root()->getChild(i);
+                    if (isOplogTsPred(me)) {
+                        tsExpr = me;
+                        break;
+                    }
+                }
+            }
+            else if (isOplogTsPred(cq->root())) {
+                tsExpr = cq->root();
+            }
+            invariant(tsExpr);  // we put the ts predicate there ourselves
+
+            CollectionScanParams params;
+            params.collection = collection;
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = true;
+
+            {
+                // Use the oplog start-finding machinery to skip ahead to the resume point.
+                WorkingSet* oplogws = new WorkingSet();
+                OplogStart* stage = new OplogStart(collection, tsExpr, oplogws);
+                InternalRunner startRunner(collection, stage, oplogws);
+
+                DiskLoc startLoc;
+                Runner::RunnerState state = startRunner.getNext(NULL, &startLoc);
+                if (Runner::RUNNER_ADVANCED == state) {
+                    params.start = startLoc;
+                }
+                else if (Runner::RUNNER_EOF != state) {
+                    // EOF just means starting at the beginning of the collection.
+                    return appendCommandStatus(result, Status(ErrorCodes::InternalError,
+                            "error finding oplog start location"));
+                }
+            }
+
+            auto_ptr<WorkingSet> ws(new WorkingSet());
+            PlanStage* root = new CollectionScan(params, ws.get(), cq->root());
+            if (NULL != cq->getProj()) {
+                ProjectionStageParams projParams(WhereCallbackReal("local"));
+                projParams.projObj = cq->getParsed().getProj();
+                projParams.fullExpression = cq->root();
+                root = new ProjectionStage(projParams, ws.get(), root);
+            }
+
+            // Takes ownership of cq, root, ws.
+            auto_ptr<SingleSolutionRunner> runner(
+                new SingleSolutionRunner(collection, cq.release(), NULL, root, ws.release()));
+
+            BSONElement batchSizeElem = cmdObj.getFieldDotted("cursor.batchSize");
+            const long long batchSize = batchSizeElem.isNumber()
+                                        ? batchSizeElem.numberLong()
+                                        : 101; // same as query
+
+            BSONArrayBuilder firstBatch;
+            BSONObj obj;
+            Runner::RunnerState state = Runner::RUNNER_ADVANCED;
+            int numResults = 0;
+            for (long long objCount = 0; objCount < batchSize; objCount++) {
+                state = runner->getNext(&obj, NULL);
+                if (Runner::RUNNER_ADVANCED != state) {
+                    break;
+                }
+                firstBatch.append(obj);
+                numResults++;
+                if (firstBatch.len() >= MaxBytesToReturnToClientAtOnce) {
+                    break;
+                }
+            }
+
+            if (Runner::RUNNER_ERROR == state) {
+                return appendCommandStatus(result, Status(ErrorCodes::OperationFailed,
+                        "oplogTail runner error: " + WorkingSetCommon::toStatusString(obj)));
+            }
+            if (Runner::RUNNER_DEAD == state) {
+                return appendCommandStatus(result, Status(ErrorCodes::OperationFailed,
+                        "oplogTail runner killed during first batch"));
+            }
+
+            // Hand the runner to a tailable, awaitData client cursor; consumers pull
+            // further batches with plain getMore on the oplog namespace, blocking
+            // briefly for new entries when caught up.
+            runner->saveState();
+            ClientCursor* cc = new ClientCursor(collection, runner.get(),
+                                                QueryOption_CursorTailable |
+                                                QueryOption_AwaitData,
+                                                queryObj);
+            runner.release();
+            cc->setPos(numResults);
+
+            BSONObjBuilder cursorBob(result.subobjStart("cursor"));
+            cursorBob.append("id", cc->cursorid());
+            cursorBob.append("ns", oplogNs);
+            cursorBob.append("firstBatch", firstBatch.arr());
+            cursorBob.doneFast();
+
+            return true;
+        }
+
+    } oplogTailCmd;
+
+} // namespace mongo
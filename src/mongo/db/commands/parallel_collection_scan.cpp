@@ -33,6 +33,7 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/query/multi_iterator_runner.h"
 #include "mongo/util/touch_pages.h"
 
 namespace mongo {
@@ -49,98 +50,6 @@ namespace mongo {
             size_t size;
         };
 
-        class MultiIteratorRunner : public Runner {
-        public:
-            MultiIteratorRunner( const StringData& ns, Collection* collection )
-                : _ns( ns.toString() ),
-                  _collection( collection ) {
-            }
-            ~MultiIteratorRunner() {
-            }
-
-            // takes ownership of it
-            void addIterator(RecordIterator* it) {
-                _iterators.push_back(it);
-            }
-
-            virtual RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut) {
-                if ( _collection == NULL )
-                    return RUNNER_DEAD;
-
-                DiskLoc next = _advance();
-                if (next.isNull())
-                    return RUNNER_EOF;
-
-                if ( objOut )
-                    *objOut = _collection->docFor( next );
-                if ( dlOut )
-                    *dlOut = next;
-                return RUNNER_ADVANCED;
-            }
-
-            virtual bool isEOF() {
-                return _collection == NULL || _iterators.empty();
-            }
-            virtual void kill() {
-                _collection = NULL;
-                _iterators.clear();
-            }
-            virtual void saveState() {
-                for (size_t i = 0; i < _iterators.size(); i++) {
-                    _iterators[i]->prepareToYield();
-                }
-            }
-            virtual bool restoreState(OperationContext* opCtx) {
-                for (size_t i = 0; i < _iterators.size(); i++) {
-                    if (!_iterators[i]->recoverFromYield()) {
-                        kill();
-                        return false;
-                    }
-                }
-                return true;
-            }
-
-            virtual const string& ns() { return _ns; }
-            virtual void invalidate(const DiskLoc& dl, InvalidationType type) {
-                switch ( type ) {
-                case INVALIDATION_DELETION:
-                    for (size_t i = 0; i < _iterators.size(); i++) {
-                        _iterators[i]->invalidate(dl);
-                    }
-                    break;
-                case INVALIDATION_MUTATION:
-                    // no-op
-                    break;
-                }
-            }
-            virtual const Collection* collection() {
-                return _collection;
-            }
-            virtual Status getInfo(TypeExplain** explain, PlanInfo** planInfo) const {
-                return Status( ErrorCodes::InternalError, "no" );
-            }
-        private:
-
-            /**
-             * @return if more data
-             */
-            DiskLoc _advance() {
-                while (!_iterators.empty()) {
-                    DiskLoc out = _iterators.back()->getNext();
-                    if (!out.isNull())
-                        return out;
-
-                    _iterators.popAndDeleteBack();
-                }
-
-                return DiskLoc();
-            }
-
-            string _ns;
-            Collection* _collection;
-            OwnedPointerVector<RecordIterator> _iterators;
-        };
-
         // ------------------------------------------------
 
         ParallelCollectionScanCmd() : Command( "parallelCollectionScan" ){}
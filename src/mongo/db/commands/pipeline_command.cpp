@@ -246,6 +246,10 @@ namespace {
             cursor->setLeftoverMaxTimeMicros( txn->getCurOp()->getRemainingMaxTimeMicros() );
         }
 
+        // firstBatch's size is known; reserve the reply space up front rather than
+        // growing the command reply buffer through a chain of doubling copies
+        result.bb().reserveBytes(resultsArray.len() + 1024);
+
         BSONObjBuilder cursorObj(result.subobjStart("cursor"));
         cursorObj.append("id", cursor ? cursor->cursorid() : 0LL);
         cursorObj.append("ns", ns);
@@ -35,13 +35,18 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/client.h"
 #include "mongo/db/client_basic.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/exit.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
@@ -49,6 +54,46 @@
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * Latest completed snapshot of the expensive serverStatus sections, produced
+         * by the background thread started in startServerStatusSnapshotThread().
+         * Readers hold the mutex only while copying the requested section's bytes
+         * out, never while a section is being generated, so serving serverStatus
+         * from the snapshot cannot block on the hot locks those sections read.
+         */
+        class StatusSnapshot {
+        public:
+            StatusSnapshot() : _lock( "serverStatusSnapshot" ) {}
+
+            /** @return true if the snapshot holds data for the named section */
+            bool get( const string& sectionName, BSONObj* out ) const {
+                SimpleMutex::scoped_lock lk( _lock );
+                BSONElement e = _sections[sectionName];
+                if ( ! e.isABSONObj() )
+                    return false;
+                *out = e.Obj().getOwned();
+                return true;
+            }
+
+            void set( const BSONObj& sections ) {
+                SimpleMutex::scoped_lock lk( _lock );
+                _sections = sections.getOwned();
+            }
+
+            void clear() {
+                SimpleMutex::scoped_lock lk( _lock );
+                _sections = BSONObj();
+            }
+
+        private:
+            mutable SimpleMutex _lock;
+            BSONObj _sections; // { <sectionName> : <data>, ... }
+        } statusSnapshot;
+
+    }
+
     class CmdServerStatus : public Command {
     public:
 
@@ -114,7 +159,16 @@ namespace mongo {
                 if ( ! include )
                     continue;
                 
-                BSONObj data = section->generateSection(e);
+                BSONObj data;
+                if ( section->expensiveToGenerate() && ! e.isABSONObj() &&
+                     statusSnapshot.get( section->getSectionName(), &data ) ) {
+                    // served from the latest background snapshot; a section-specific
+                    // config object forces live generation because the snapshot is
+                    // built with default config
+                }
+                else {
+                    data = section->generateSection(e);
+                }
                 if ( data.isEmpty() )
                     continue;
 
@@ -163,6 +217,26 @@ namespace mongo {
             (*_sections)[section->getSectionName()] = section;
         }
 
+        /**
+         * generates every registered section with expensiveToGenerate() set, using
+         * default (empty) section config; used by the snapshot background thread
+         */
+        BSONObj generateExpensiveSections() const {
+            BSONObjBuilder b;
+            if ( _sections ) {
+                for ( SectionMap::const_iterator i = _sections->begin(); i != _sections->end(); ++i ) {
+                    ServerStatusSection* section = i->second;
+                    if ( ! section->expensiveToGenerate() )
+                        continue;
+                    BSONObj data = section->generateSection( BSONElement() );
+                    if ( data.isEmpty() )
+                        continue;
+                    b.append( section->getSectionName(), data );
+                }
+            }
+            return b.obj();
+        }
+
     private:
         const unsigned long long _started;
         bool _runCalled;
@@ -191,9 +265,22 @@ namespace mongo {
 
 
     namespace {
-        
+
         // some universal sections
-        
+
+        class OpLatencies : public ServerStatusSection {
+        public:
+            OpLatencies() : ServerStatusSection( "opLatencies" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder bb;
+                globalOpLatencyHistograms.append( bb );
+                return bb.obj();
+            }
+
+        } opLatencies;
+
         class Connections : public ServerStatusSection {
         public:
             Connections() : ServerStatusSection( "connections" ){}
@@ -280,5 +367,46 @@ namespace mongo {
         } memBase;
     }
 
+    // how often the background thread regenerates the expensive serverStatus
+    // sections; <= 0 disables the snapshot and those sections are generated
+    // inline by each serverStatus command again
+    MONGO_EXPORT_SERVER_PARAMETER( serverStatusSnapshotSecs, int, 10 );
+
+    namespace {
+
+        class StatusSnapshotJob : public BackgroundJob {
+        public:
+            virtual string name() const { return "StatusSnapshot"; }
+
+            virtual void run() {
+                Client::initThread( name().c_str() );
+
+                while ( ! inShutdown() ) {
+                    if ( serverStatusSnapshotSecs <= 0 ) {
+                        // disabled: drop any stale data so serverStatus generates live
+                        statusSnapshot.clear();
+                        sleepsecs( 1 );
+                        continue;
+                    }
+
+                    try {
+                        statusSnapshot.set( cmdServerStatus.generateExpensiveSections() );
+                    }
+                    catch ( DBException& e ) {
+                        warning() << "serverStatus snapshot failed: " << e.toString() << endl;
+                    }
+
+                    sleepsecs( serverStatusSnapshotSecs );
+                }
+            }
+        };
+
+    }
+
+    void startServerStatusSnapshotThread() {
+        StatusSnapshotJob* job = new StatusSnapshotJob();
+        job->go();
+    }
+
 }
 
@@ -69,6 +69,16 @@ namespace mongo {
          */
         virtual void addRequiredPrivileges(std::vector<Privilege>* out) {};
 
+        /**
+         * if this returns true, generating this section takes locks that contend
+         * with regular traffic (e.g. the per-db lock-stats registry).  Expensive
+         * sections are generated by a background thread every
+         * serverStatusSnapshotSecs and the serverStatus command serves the most
+         * recent completed snapshot, so frequent monitoring never touches the hot
+         * locks.  Sections that just read counters should leave this false.
+         */
+        virtual bool expensiveToGenerate() const { return false; }
+
         /**
          * actually generate the result
          * @param configElement the element from the actual command related to this section
@@ -91,5 +101,12 @@ namespace mongo {
         const OpCounters* _counters;
     };
 
+    /**
+     * Starts the background thread that periodically regenerates the expensive
+     * serverStatus sections (see ServerStatusSection::expensiveToGenerate).
+     * Called once during mongod startup.
+     */
+    void startServerStatusSnapshotThread();
+
 }
 
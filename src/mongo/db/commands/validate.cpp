@@ -33,6 +33,9 @@
 #include "mongo/db/query/runner.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/structure/record_store.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -45,7 +48,9 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check\n"
+                                                        "Add background:true to walk one extent per lock acquisition, throttled to\n"
+                                                        "ioBudgetPct (default 5) percent of I/O time; resumable via resumeToken"; }
 
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -69,6 +74,14 @@ namespace mongo {
                 return false;
             }
 
+            if ( cmdObj["background"].trueValue() ) {
+                if ( full || scanData ) {
+                    errmsg = "cannot combine background:true with full or scandata";
+                    return false;
+                }
+                return runBackground( txn, ns_string, cmdObj, errmsg, result );
+            }
+
             if (!serverGlobalParams.quiet) {
                 LOG(0) << "CMD: validate " << ns << endl;
             }
@@ -108,6 +121,107 @@ namespace mongo {
             return true;
         }
 
+    private:
+
+        /**
+         * Production-safe mode: validates the record store one extent per read lock
+         * acquisition, sleeping between extents so the walk consumes roughly
+         * 'ioBudgetPct' percent of wall time.  Stops cleanly when the operation is
+         * killed (or hits maxTimeMS) and returns a 'resumeToken' that a later
+         * invocation can pass as 'resumeFrom' to pick up where this one stopped.
+         *
+         * Checks the record data structures only; index (btree) validation still
+         * requires the foreground command.
+         */
+        bool runBackground( OperationContext* txn,
+                            const NamespaceString& ns_string,
+                            const BSONObj& cmdObj,
+                            string& errmsg,
+                            BSONObjBuilder& result ) {
+
+            int ioBudgetPct = 5;
+            if ( cmdObj["ioBudgetPct"].isNumber() ) {
+                ioBudgetPct = cmdObj["ioBudgetPct"].numberInt();
+                if ( ioBudgetPct < 1 || ioBudgetPct > 100 ) {
+                    errmsg = "ioBudgetPct must be between 1 and 100";
+                    return false;
+                }
+            }
+
+            DiskLoc token;
+            if ( cmdObj["resumeFrom"].isABSONObj() ) {
+                BSONObj t = cmdObj["resumeFrom"].Obj();
+                token = DiskLoc( t["file"].numberInt(), t["offset"].numberInt() );
+            }
+
+            result.append( "ns", ns_string.ns() );
+
+            ValidateResults results;
+            long long nRecords = 0;
+            int nExtents = 0;
+            bool partial = false;
+
+            while ( true ) {
+                Timer stepTimer;
+                {
+                    // The lock is reacquired for every extent, so writers only ever
+                    // wait for one extent's worth of work.
+                    Client::ReadContext ctx(txn, ns_string.ns());
+
+                    Database* db = ctx.ctx().db();
+                    Collection* collection = db ? db->getCollection( txn, ns_string.ns() ) : NULL;
+                    if ( !collection ) {
+                        errmsg = "collection dropped during background validate";
+                        return false;
+                    }
+
+                    DiskLoc next;
+                    long long extentRecords = 0;
+                    Status status = collection->getRecordStore()->validateOnlineStep(
+                            txn, token, &next, &extentRecords, &results );
+                    if ( !status.isOK() )
+                        return appendCommandStatus( result, status );
+
+                    nRecords += extentRecords;
+                    nExtents++;
+                    token = next;
+                }
+                const long long workMicros = stepTimer.micros();
+
+                if ( token.isNull() || !results.valid )
+                    break;
+
+                if ( !txn->checkForInterruptNoAssert().isOK() ) {
+                    // Killed (or out of time): report what was covered and where a
+                    // later run should resume.
+                    partial = true;
+                    break;
+                }
+
+                // Sleep off the rest of this extent's time slice so validation uses
+                // about ioBudgetPct percent of I/O time.
+                const long long sleepMicros = workMicros * ( 100 - ioBudgetPct ) / ioBudgetPct;
+                if ( sleepMicros > 0 )
+                    sleepmicros( sleepMicros );
+            }
+
+            result.append( "extentsChecked", nExtents );
+            result.appendNumber( "recordsChecked", nRecords );
+            if ( partial ) {
+                result.appendBool( "partial", true );
+                result.append( "resumeToken", token.toBSONObj() );
+            }
+            result.appendBool( "valid", results.valid );
+            result.append( "errors", results.errors );
+
+            if ( !results.valid ) {
+                result.append( "advice",
+                               "ns corrupt. See http://dochub.mongodb.org/core/data-recovery" );
+            }
+
+            return true;
+        }
+
     } validateCmd;
 
 }
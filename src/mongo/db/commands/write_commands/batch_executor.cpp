@@ -28,6 +28,8 @@
 
 #include "mongo/db/commands/write_commands/batch_executor.h"
 
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 #include <memory>
 
 #include "mongo/base/error_codes.h"
@@ -41,6 +43,7 @@
 #include "mongo/db/ops/delete_executor.h"
 #include "mongo/db/ops/delete_request.h"
 #include "mongo/db/ops/insert.h"
+#include "mongo/db/ops/update.h"
 #include "mongo/db/ops/update_executor.h"
 #include "mongo/db/ops/update_lifecycle_impl.h"
 #include "mongo/db/ops/update_request.h"
@@ -57,6 +60,7 @@
 #include "mongo/s/shard_key_pattern.h"
 #include "mongo/s/write_ops/batched_upsert_detail.h"
 #include "mongo/s/write_ops/write_error_detail.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -592,6 +596,7 @@ namespace mongo {
 
         currentOp->done();
         int executionTime = currentOp->debug().executionTime = currentOp->totalTimeMillis();
+        currentOp->recordFaults();
         currentOp->debug().recordStats();
 
         if ( opError ) {
@@ -627,6 +632,7 @@ namespace mongo {
     static void singleInsert( OperationContext* txn,
                               const BSONObj& docToInsert,
                               Collection* collection,
+                              std::vector<BSONObj>* pendingOplogEntries,
                               WriteOpResult* result );
 
     static void singleCreateIndex( OperationContext* txn,
@@ -662,6 +668,26 @@ namespace mongo {
         explicit ExecInsertsState(OperationContext* txn,
                                   const BatchedCommandRequest* aRequest);
 
+        /**
+         * Joins the normalization helper thread, if any, and flushes any deferred
+         * oplog entries; see pendingOplogEntries.
+         */
+        ~ExecInsertsState();
+
+        /**
+         * Begins filling normalizedInserts.  Large batches get a helper thread that
+         * runs fixDocumentForInsert for document N+1 while document N's btree and
+         * index work completes; small batches are normalized inline, as thread
+         * startup would dominate.
+         */
+        void startNormalization();
+
+        /**
+         * Returns the normalized form of the insert at 'idx', blocking until the
+         * helper thread has produced it when normalization is pipelined.
+         */
+        const StatusWith<BSONObj>& getNormalizedInsert(size_t idx);
+
         /**
          * Acquires the write lock and client context needed to perform the current write operation.
          * Returns true on success, after which it is safe to use the "context" and "collection"
@@ -703,12 +729,36 @@ namespace mongo {
 
         // Translation of insert documents in "request" into insert-ready forms.  This vector has a
         // correspondence with elements of the "request", and "currIndex" is used to
-        // index both.
+        // index both.  Filled by startNormalization(); when pipelined, read it only
+        // through getNormalizedInsert().  The vector is fully reserved up front, so
+        // references to produced elements stay valid while the helper appends.
         std::vector<StatusWith<BSONObj> > normalizedInserts;
 
+        // Documents successfully inserted since the write lock was acquired, whose
+        // oplog entries have not been written yet.  They are logged in one vectored
+        // logOps() call (with a single timestamp sequence) just before the lock is
+        // released, so per-document oplog overhead is paid once per batch.
+        std::vector<BSONObj> pendingOplogEntries;
+
     private:
         bool _lockAndCheckImpl(WriteOpResult* result);
 
+        // Body of the normalization helper thread.
+        void _normalizeTask();
+
+        // Writes the deferred oplog entries.  Must be called while the write lock
+        // is still held, so the data and its oplog entries land in the same
+        // journal commit.
+        void _flushPendingOplogEntries();
+
+        // Guard access to normalizedInserts while the helper thread appends to it;
+        // its size under the mutex is the count of documents ready for insertion.
+        mongo::mutex _normalizeMutex;
+        boost::condition _normalizeCV;
+
+        // Set only for pipelined normalization of large batches.
+        scoped_ptr<boost::thread> _normalizeThread;
+
         // Guard object for the write lock on the target database.
         scoped_ptr<Lock::DBWrite> _writeLock;
 
@@ -778,11 +828,17 @@ namespace mongo {
         }
     }
 
+    namespace {
+        // Batches at least this large get a helper thread that normalizes document
+        // N+1 while document N's insert completes; for smaller batches thread
+        // startup would dominate, so they are normalized inline.
+        const size_t kPipelinedNormalizeMinDocs = 64;
+    }
+
     // Goes over the request and preprocesses normalized versions of all the inserts in the request
     static void normalizeInserts( const BatchedCommandRequest& request,
                                   vector<StatusWith<BSONObj> >* normalizedInserts ) {
 
-        normalizedInserts->reserve(request.sizeWriteOps());
         for ( size_t i = 0; i < request.sizeWriteOps(); ++i ) {
             BSONObj insertDoc = request.getInsertRequest()->getDocumentsAt( i );
             StatusWith<BSONObj> normalInsert = fixDocumentForInsert( insertDoc );
@@ -815,7 +871,7 @@ namespace mongo {
         // further insertOne calls, and stop the batch.  As a result, the only expected source of
         // such exceptions are interruptions.
         ExecInsertsState state(_txn, &request);
-        normalizeInserts(request, &state.normalizedInserts);
+        state.startNormalization();
 
         ElapsedTracker elapsedTracker(128, 10); // 128 hits or 10 ms, matching RunnerYieldPolicy's
 
@@ -824,7 +880,15 @@ namespace mongo {
              ++state.currIndex) {
 
             if (elapsedTracker.intervalHasElapsed()) {
-                // Consider yielding between inserts.
+                // Consider yielding between inserts.  Only give up the write lock when
+                // another thread is actually blocked behind it (or behind the global
+                // lock); an uncontended unlock/relock round trip just costs restore
+                // overhead.  insertOne() reacquires via lockAndCheck().
+                if (state.hasLock() &&
+                    (Lock::othersWaitingForLocksHeld(_txn->lockState()) > 0 ||
+                     Lock::lowPriorityOpShouldYield(_txn->lockState()))) {
+                    state.unlock();
+                }
 
                 _txn->checkForInterrupt();
                 elapsedTracker.resetLastTime();
@@ -898,9 +962,73 @@ namespace mongo {
         txn(txn),
         request(aRequest),
         currIndex(0),
+        _normalizeMutex("ExecInsertsState::normalize"),
         _collection(NULL) {
     }
 
+    WriteBatchExecutor::ExecInsertsState::~ExecInsertsState() {
+        // The helper keeps normalizing even if the batch stops early; wait it out
+        // before the vector it appends to goes away.
+        if (_normalizeThread)
+            _normalizeThread->join();
+
+        // Normally a no-op; insertOne()/unlock() flush as the batch runs, but
+        // the last stretch of inserts ends with the state going out of scope.
+        unlock();
+    }
+
+    void WriteBatchExecutor::ExecInsertsState::startNormalization() {
+        // Reserving the full batch up front means the helper's push_backs never
+        // reallocate, so references handed out by getNormalizedInsert stay valid.
+        normalizedInserts.reserve(request->sizeWriteOps());
+
+        if (request->sizeWriteOps() < kPipelinedNormalizeMinDocs) {
+            normalizeInserts(*request, &normalizedInserts);
+            return;
+        }
+
+        _normalizeThread.reset(new boost::thread(
+                stdx::bind(&ExecInsertsState::_normalizeTask, this)));
+    }
+
+    void WriteBatchExecutor::ExecInsertsState::_normalizeTask() {
+        for (size_t i = 0; i < request->sizeWriteOps(); ++i) {
+            StatusWith<BSONObj> normalInsert((BSONObj()));
+            try {
+                normalInsert = fixDocumentForInsert(
+                        request->getInsertRequest()->getDocumentsAt(i));
+            }
+            catch (const DBException& ex) {
+                normalInsert = StatusWith<BSONObj>(ex.toStatus());
+            }
+
+            const bool stop = request->getOrdered() && !normalInsert.isOK();
+            {
+                scoped_lock lk(_normalizeMutex);
+                normalizedInserts.push_back(normalInsert);
+                _normalizeCV.notify_one();
+            }
+
+            // Mirrors normalizeInserts: an ordered batch ends at its first bad
+            // document, and the insert loop never asks past it.
+            if (stop)
+                break;
+        }
+    }
+
+    const StatusWith<BSONObj>& WriteBatchExecutor::ExecInsertsState::getNormalizedInsert(
+            size_t idx) {
+        if (!_normalizeThread) {
+            invariant(idx < normalizedInserts.size());
+            return normalizedInserts[idx];
+        }
+
+        scoped_lock lk(_normalizeMutex);
+        while (normalizedInserts.size() <= idx)
+            _normalizeCV.wait(lk.boost());
+        return normalizedInserts[idx];
+    }
+
     bool WriteBatchExecutor::ExecInsertsState::_lockAndCheckImpl(WriteOpResult* result) {
         if (hasLock()) {
             txn->getCurOp()->enter(_context.get());
@@ -945,14 +1073,27 @@ namespace mongo {
     }
 
     void WriteBatchExecutor::ExecInsertsState::unlock() {
+        _flushPendingOplogEntries();
         _collection = NULL;
         _context.reset();
         _writeLock.reset();
     }
 
+    void WriteBatchExecutor::ExecInsertsState::_flushPendingOplogEntries() {
+        if (pendingOplogEntries.empty())
+            return;
+
+        invariant(_collection);
+
+        const string& insertNS = _collection->ns().ns();
+        repl::logOps(txn, "i", insertNS.c_str(), pendingOplogEntries);
+        txn->recoveryUnit()->commitIfNeeded();
+        pendingOplogEntries.clear();
+    }
+
     static void insertOne(WriteBatchExecutor::ExecInsertsState* state, WriteOpResult* result) {
-        invariant(state->currIndex < state->normalizedInserts.size());
-        const StatusWith<BSONObj>& normalizedInsert(state->normalizedInserts[state->currIndex]);
+        const StatusWith<BSONObj>& normalizedInsert =
+            state->getNormalizedInsert(state->currIndex);
 
         if (!normalizedInsert.isOK()) {
             result->setError(toWriteError(normalizedInsert.getStatus()));
@@ -966,7 +1107,11 @@ namespace mongo {
         try {
             if (state->lockAndCheck(result)) {
                 if (!state->request->isInsertIndexRequest()) {
-                    singleInsert(state->txn, insertDoc, state->getCollection(), result);
+                    singleInsert(state->txn,
+                                 insertDoc,
+                                 state->getCollection(),
+                                 &state->pendingOplogEntries,
+                                 result);
                 }
                 else {
                     singleCreateIndex(state->txn, insertDoc, state->getCollection(), result);
@@ -1023,6 +1168,7 @@ namespace mongo {
     static void singleInsert( OperationContext* txn,
                               const BSONObj& docToInsert,
                               Collection* collection,
+                              std::vector<BSONObj>* pendingOplogEntries,
                               WriteOpResult* result ) {
 
         const string& insertNS = collection->ns().ns();
@@ -1035,8 +1181,10 @@ namespace mongo {
             result->setError(toWriteError(status.getStatus()));
         }
         else {
-            repl::logOp( txn, "i", insertNS.c_str(), docToInsert );
-            txn->recoveryUnit()->commitIfNeeded();
+            // The oplog entry is deferred and written in one vectored logOps()
+            // call (along with the commitIfNeeded) before the write lock is
+            // released; see ExecInsertsState::_flushPendingOplogEntries.
+            pendingOplogEntries->push_back( docToInsert );
             result->getStats().n = 1;
         }
     }
@@ -1091,35 +1239,47 @@ namespace mongo {
             return;
         }
 
-        ///////////////////////////////////////////
-        Lock::DBWrite writeLock(txn->lockState(), nsString.ns(), useExperimentalDocLocking);
-        ///////////////////////////////////////////
+        // with the experimental doc-locking mode we first try under an intent lock;
+        // updates that need a document move, index update or insert tell us to retry
+        // with the exclusive lock
+        bool intentLock = useExperimentalDocLocking;
+        while ( 1 ) {
+            ///////////////////////////////////////////
+            Lock::DBWrite writeLock(txn->lockState(), nsString.ns(), intentLock);
+            ///////////////////////////////////////////
 
-        if (!checkShardVersion(txn, &shardingState, *updateItem.getRequest(), result))
-            return;
+            if (!checkShardVersion(txn, &shardingState, *updateItem.getRequest(), result))
+                return;
 
-        Client::Context ctx(nsString.ns(), false /* don't check version */);
+            Client::Context ctx(nsString.ns(), false /* don't check version */);
 
-        try {
-            UpdateResult res = executor.execute(txn, ctx.db());
+            try {
+                UpdateResult res = executor.execute(txn, ctx.db());
 
-            const long long numDocsModified = res.numDocsModified;
-            const long long numMatched = res.numMatched;
-            const BSONObj resUpsertedID = res.upserted;
+                const long long numDocsModified = res.numDocsModified;
+                const long long numMatched = res.numMatched;
+                const BSONObj resUpsertedID = res.upserted;
 
-            // We have an _id from an insert
-            const bool didInsert = !resUpsertedID.isEmpty();
+                // We have an _id from an insert
+                const bool didInsert = !resUpsertedID.isEmpty();
 
-            result->getStats().nModified = didInsert ? 0 : numDocsModified;
-            result->getStats().n = didInsert ? 1 : numMatched;
-            result->getStats().upsertedID = resUpsertedID;
-        }
-        catch (const DBException& ex) {
-            status = ex.toStatus();
-            if (ErrorCodes::isInterruption(status.code())) {
-                throw;
+                result->getStats().nModified = didInsert ? 0 : numDocsModified;
+                result->getStats().n = didInsert ? 1 : numMatched;
+                result->getStats().upsertedID = resUpsertedID;
             }
-            result->setError(toWriteError(status));
+            catch (const UpdateNeedsExclusiveLockException&) {
+                dassert( intentLock );
+                intentLock = false;
+                continue;
+            }
+            catch (const DBException& ex) {
+                status = ex.toStatus();
+                if (ErrorCodes::isInterruption(status.code())) {
+                    throw;
+                }
+                result->setError(toWriteError(status));
+            }
+            break;
         }
     }
 
@@ -29,11 +29,17 @@
 #include "mongo/pch.h"
 
 #include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/platform/striped_counter.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/util/fail_point_service.h"
 
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
 
 namespace mongo {
 
@@ -52,6 +58,25 @@ namespace mongo {
 
     // todo : move more here
 
+    /**
+     * Samples the calling thread's cumulative minor/major page-fault counts.  An op runs
+     * on one thread for its whole life, so a start/finish delta attributes exactly the
+     * faults this operation caused - including those taken after yield restores, which
+     * is where cold-data queries fault the hardest.  Returns false where the platform
+     * offers no per-thread rusage.
+     */
+    static bool sampleThreadFaults( long long* minorOut, long long* majorOut ) {
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+        struct rusage ru;
+        if ( 0 == getrusage( RUSAGE_THREAD, &ru ) ) {
+            *minorOut = ru.ru_minflt;
+            *majorOut = ru.ru_majflt;
+            return true;
+        }
+#endif
+        return false;
+    }
+
     CurOp::CurOp( Client * client , CurOp * wrapped ) :
         _client(client),
         _wrapped(wrapped)
@@ -59,6 +84,8 @@ namespace mongo {
         if ( _wrapped )
             _client->_curOp = this;
         _start = 0;
+        _startMinorFaults = -1;
+        _startMajorFaults = -1;
         _active = false;
         _reset();
         _op = 0;
@@ -88,6 +115,8 @@ namespace mongo {
     void CurOp::reset() {
         _reset();
         _start = 0;
+        _startMinorFaults = -1;
+        _startMajorFaults = -1;
         _opNum = _nextOpNum++;
         _ns[0] = 0;
         _debug.reset();
@@ -138,7 +167,16 @@ namespace mongo {
 
     void CurOp::ensureStarted() {
         if ( _start == 0 ) {
-            _start = curTimeMicros64();
+            // Coarse (~1ms) stamps are plenty for operation timing, and this
+            // runs for every operation.  Time limit tracking below keeps using
+            // the precise clock internally; maxTimeMS granularity is already
+            // milliseconds.
+            _start = curTimeMicros64Fast();
+
+            if ( !sampleThreadFaults( &_startMinorFaults, &_startMajorFaults ) ) {
+                _startMinorFaults = -1;
+                _startMajorFaults = -1;
+            }
 
             // If ensureStarted() is invoked after setMaxTimeMicros(), then time limit tracking will
             // start here.  This is because time limit tracking can only commence after the
@@ -271,28 +309,125 @@ namespace mongo {
 
     AtomicUInt CurOp::_nextOpNum;
 
-    static Counter64 returnedCounter;
-    static Counter64 insertedCounter;
-    static Counter64 updatedCounter;
-    static Counter64 deletedCounter;
-    static Counter64 scannedCounter;
-    static Counter64 scannedObjectCounter;
-
-    static ServerStatusMetricField<Counter64> displayReturned( "document.returned", &returnedCounter );
-    static ServerStatusMetricField<Counter64> displayUpdated( "document.updated", &updatedCounter );
-    static ServerStatusMetricField<Counter64> displayInserted( "document.inserted", &insertedCounter );
-    static ServerStatusMetricField<Counter64> displayDeleted( "document.deleted", &deletedCounter );
-    static ServerStatusMetricField<Counter64> displayScanned( "queryExecutor.scanned", &scannedCounter );
-    static ServerStatusMetricField<Counter64> displayScannedObjects( "queryExecutor.scannedObjects",
+    static StripedCounter64 returnedCounter;
+    static StripedCounter64 insertedCounter;
+    static StripedCounter64 updatedCounter;
+    static StripedCounter64 deletedCounter;
+    static StripedCounter64 scannedCounter;
+    static StripedCounter64 scannedObjectCounter;
+
+    static ServerStatusMetricField<StripedCounter64> displayReturned( "document.returned", &returnedCounter );
+    static ServerStatusMetricField<StripedCounter64> displayUpdated( "document.updated", &updatedCounter );
+    static ServerStatusMetricField<StripedCounter64> displayInserted( "document.inserted", &insertedCounter );
+    static ServerStatusMetricField<StripedCounter64> displayDeleted( "document.deleted", &deletedCounter );
+    static ServerStatusMetricField<StripedCounter64> displayScanned( "queryExecutor.scanned", &scannedCounter );
+    static ServerStatusMetricField<StripedCounter64> displayScannedObjects( "queryExecutor.scannedObjects",
                                                                      &scannedObjectCounter );
 
-    static Counter64 idhackCounter;
-    static Counter64 scanAndOrderCounter;
-    static Counter64 fastmodCounter;
+    static StripedCounter64 idhackCounter;
+    static StripedCounter64 scanAndOrderCounter;
+    static StripedCounter64 fastmodCounter;
+    static StripedCounter64 updateNoopCounter;
+
+    static ServerStatusMetricField<StripedCounter64> displayIdhack( "operation.idhack", &idhackCounter );
+    static ServerStatusMetricField<StripedCounter64> displayScanAndOrder( "operation.scanAndOrder", &scanAndOrderCounter );
+    static ServerStatusMetricField<StripedCounter64> displayFastMod( "operation.fastmod", &fastmodCounter );
+    static ServerStatusMetricField<StripedCounter64> displayUpdateNoops( "operation.updateNoops",
+                                                                         &updateNoopCounter );
+
+    namespace {
+
+        // Cumulative fault tallies keyed by plan summary, so fault storms can be traced
+        // to the query shapes touching cold data without external tracing.  Bounded:
+        // once the table is full, new plan summaries collapse into a catch-all bucket.
+        struct PlanFaultStats {
+            PlanFaultStats() : ops(0), minorFaults(0), majorFaults(0) { }
+            long long ops;
+            long long minorFaults;
+            long long majorFaults;
+        };
+
+        const size_t kMaxFaultPlanSummaries = 128;
+
+        SimpleMutex faultsByPlanMutex( "faultsByPlan" );
+        std::map<std::string, PlanFaultStats> faultsByPlan;
+        PlanFaultStats overflowPlanFaults;
+
+        void appendPlanFaultStats( BSONObjBuilder* b,
+                                   const StringData& name,
+                                   const PlanFaultStats& stats ) {
+            BSONObjBuilder plan( b->subobjStart( name ) );
+            plan.appendNumber( "ops", stats.ops );
+            plan.appendNumber( "minorFaults", stats.minorFaults );
+            plan.appendNumber( "majorFaults", stats.majorFaults );
+            plan.done();
+        }
 
-    static ServerStatusMetricField<Counter64> displayIdhack( "operation.idhack", &idhackCounter );
-    static ServerStatusMetricField<Counter64> displayScanAndOrder( "operation.scanAndOrder", &scanAndOrderCounter );
-    static ServerStatusMetricField<Counter64> displayFastMod( "operation.fastmod", &fastmodCounter );
+        class FaultsByPlanSummary : public ServerStatusSection {
+        public:
+            FaultsByPlanSummary() : ServerStatusSection( "faultsByPlanSummary" ) { }
+
+            virtual bool includeByDefault() const { return false; }
+
+            virtual BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+                SimpleMutex::scoped_lock lk( faultsByPlanMutex );
+                for ( std::map<std::string, PlanFaultStats>::const_iterator it =
+                          faultsByPlan.begin();
+                      it != faultsByPlan.end();
+                      ++it ) {
+                    appendPlanFaultStats( &b, it->first, it->second );
+                }
+                if ( overflowPlanFaults.ops > 0 ) {
+                    appendPlanFaultStats( &b, "(other)", overflowPlanFaults );
+                }
+                return b.obj();
+            }
+        } faultsByPlanSummary;
+
+    }  // namespace
+
+    void CurOp::recordFaults() {
+        if ( _startMinorFaults < 0 )
+            return;
+
+        long long minor;
+        long long major;
+        if ( !sampleThreadFaults( &minor, &major ) )
+            return;
+
+        minor -= _startMinorFaults;
+        major -= _startMajorFaults;
+        if ( minor < 0 || major < 0 )
+            return;
+
+        _debug.minorFaults = minor;
+        _debug.majorFaults = major;
+
+        // Only ops that actually faulted pay for the table lock below.
+        if ( 0 == minor && 0 == major )
+            return;
+
+        std::string plan = _debug.planSummary.toString();
+        if ( plan.empty() )
+            plan = "(none)";
+
+        SimpleMutex::scoped_lock lk( faultsByPlanMutex );
+        PlanFaultStats* stats;
+        std::map<std::string, PlanFaultStats>::iterator it = faultsByPlan.find( plan );
+        if ( it != faultsByPlan.end() ) {
+            stats = &it->second;
+        }
+        else if ( faultsByPlan.size() < kMaxFaultPlanSummaries ) {
+            stats = &faultsByPlan[plan];
+        }
+        else {
+            stats = &overflowPlanFaults;
+        }
+        stats->ops++;
+        stats->minorFaults += minor;
+        stats->majorFaults += major;
+    }
 
     void OpDebug::recordStats() {
         if ( nreturned > 0 )
@@ -314,6 +449,8 @@ namespace mongo {
             scanAndOrderCounter.increment();
         if ( fastmod )
             fastmodCounter.increment();
+        if ( nUpdateNoops > 0 )
+            updateNoopCounter.increment( nUpdateNoops );
     }
 
     CurOp::MaxTimeTracker::MaxTimeTracker() {
@@ -164,6 +164,7 @@ namespace mongo {
         bool scanAndOrder;   // scanandorder query plan aspect was used
         long long  nMatched; // number of records that match the query
         long long  nModified; // number of records written (no no-ops)
+        long long  nUpdateNoops; // updates that left the document byte-identical; nothing written
         long long  nmoved;   // updates resulted in a move (moves are expensive)
         long long  ninserted;
         long long  ndeleted;
@@ -171,6 +172,8 @@ namespace mongo {
         bool fastmodinsert;  // upsert of an $operation. builds a default object
         bool upsert;         // true if the update actually did an insert
         int keyUpdates;
+        long long minorFaults; // page faults this op's thread took, serviced without I/O
+        long long majorFaults; // page faults this op's thread took that required I/O
         ThreadSafeString planSummary; // a brief std::string describing the query solution
 
         // New Query Framework debugging/profiling info
@@ -261,7 +264,7 @@ namespace mongo {
         }
         void done() {
             _active = false;
-            _end = curTimeMicros64();
+            _end = curTimeMicros64Fast();
         }
 
         long long totalTimeMicros() {
@@ -270,7 +273,7 @@ namespace mongo {
         }
         int totalTimeMillis() { return (int) (totalTimeMicros() / 1000); }
         long long elapsedMicros() {
-            return curTimeMicros64() - startTime();
+            return curTimeMicros64Fast() - startTime();
         }
         int elapsedMillis() {
             return (int) (elapsedMicros() / 1000);
@@ -306,6 +309,14 @@ namespace mongo {
         void setExpectedLatencyMs( long long latency ) { _expectedLatencyMs = latency; }
 
         void recordGlobalTime( long long micros ) const;
+
+        /**
+         * Computes the minor/major page-fault deltas for this operation from per-thread
+         * rusage (baseline taken in ensureStarted()), stores them in debug(), and
+         * tallies them against the operation's plan summary for serverStatus.  Call
+         * once, when the op finishes; a no-op on platforms without per-thread rusage.
+         */
+        void recordFaults();
         
         const LockStat& lockStat() const { return _lockStat; }
         LockStat& lockStat() { return _lockStat; }
@@ -327,6 +338,8 @@ namespace mongo {
         Command * _command;
         long long _start;
         long long _end;
+        long long _startMinorFaults;  // thread rusage baseline; -1 until sampled
+        long long _startMajorFaults;  // see recordFaults()
         bool _active;
         bool _suppressFromCurop; // unless $all is set
         int _op;
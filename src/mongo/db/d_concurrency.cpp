@@ -32,6 +32,7 @@
 
 #include "mongo/db/d_concurrency.h"
 
+#include "mongo/base/init.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
@@ -41,14 +42,17 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/server.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mapsf.h"
 #include "mongo/util/concurrency/qlock.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/stacktrace.h"
+#include "mongo/util/timer.h"
 
 // oplog locking
 // no top level read locks
@@ -66,13 +70,57 @@ namespace mongo {
 
     /* dbname->lock
        Currently these are never deleted - will linger if db was closed. (that should be fine.)
-       We don't put the lock inside the Database object as those can come and go with open and 
-       closes and that would just add complexity. 
-       Note there is no path concept for where the database is; if somehow you had two db's open 
-       in different directories with the same name, it will be ok but they are sharing a lock 
+       We don't put the lock inside the Database object as those can come and go with open and
+       closes and that would just add complexity.
+       Note there is no path concept for where the database is; if somehow you had two db's open
+       in different directories with the same name, it will be ok but they are sharing a lock
        then.
+
+       The table is striped by a hash of the database name.  A multi-tenant node with
+       hundreds of databases resolves lock objects from many threads at once, and a
+       single mutex over the whole table put every tenant's first acquisition on the
+       same cache line; with stripes, locks of unrelated databases only coordinate
+       within their stripe.
     */
-    typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
+    typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMapStripe;
+
+    class DBLocksMap : boost::noncopyable {
+    public:
+        /** @return the lock for 'db', creating it on first use */
+        WrapperForRWLock* getOrCreate(const StringData& db) {
+            DBLocksMapStripe::ref r(stripeFor(db));
+            WrapperForRWLock*& lock = r[db];
+            if (lock == NULL) {
+                lock = new WrapperForRWLock(db);
+            }
+            return lock;
+        }
+
+        /** @return the lock for 'db', or NULL if that db has never been locked */
+        WrapperForRWLock* get(const StringData& db) {
+            return stripeFor(db).get(db);
+        }
+
+        /** append each database's lock stats to 'b' (for serverStatus) */
+        void reportStats(BSONObjBuilder& b) {
+            for (int i = 0; i < NumStripes; i++) {
+                DBLocksMapStripe::ref r(_stripes[i]);
+                for (DBLocksMapStripe::const_iterator it = r.r.begin();
+                        it != r.r.end(); ++it) {
+                    b.append(it->first, it->second->getStats().report());
+                }
+            }
+        }
+
+    private:
+        enum { NumStripes = 16 }; // power of two
+
+        DBLocksMapStripe& stripeFor(const StringData& db) {
+            return _stripes[StringData::Hasher()(db) & (NumStripes - 1)];
+        }
+
+        DBLocksMapStripe _stripes[NumStripes];
+    };
     static DBLocksMap dblocks;
 
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
@@ -88,6 +136,175 @@ namespace mongo {
         return &nestableLocks[db]->getStats();
     }
 
+    /* admission control.  when enabled, DBRead/DBWrite acquire a ticket before
+       contending for the db locks, bounding the number of operations in the lock
+       scheduler at once.  under overload excess operations queue cheaply on the
+       TicketHolder condvar instead of piling onto the QLock fairness queues.
+       a ticket is held across yields (TempRelease) -- releasing it there would
+       just reintroduce the thundering herd we are trying to avoid.
+
+       ops carry a priority class (LockState::admissionPriority(), set from
+       QueryOption_LowPriority).  low priority ops must additionally hold a ticket
+       from a slice of the pool sized by admissionControlLowPriorityWeight percent,
+       so they can never occupy more than their weighted share of the regular
+       tickets while normal/high priority ops compete for the whole pool.
+    */
+    static TicketHolder* admissionReadTickets = NULL;
+    static TicketHolder* admissionWriteTickets = NULL;
+    static TicketHolder* admissionReadTicketsLowPriority = NULL;
+    static TicketHolder* admissionWriteTicketsLowPriority = NULL;
+
+    // 0 = admission control disabled (the default)
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlReadTickets, int, 0);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlWriteTickets, int, 0);
+
+    // percent of each ticket pool low priority ops may hold concurrently (1-100)
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlLowPriorityWeight, int, 25);
+
+    static int lowPrioritySliceSize( int tickets ) {
+        int weight = admissionControlLowPriorityWeight;
+        if( weight < 1 )
+            weight = 1;
+        if( weight > 100 )
+            weight = 100;
+        return std::max( 1, tickets * weight / 100 );
+    }
+
+    MONGO_INITIALIZER(AdmissionControlTickets)(InitializerContext* context) {
+        if( admissionControlReadTickets > 0 ) {
+            admissionReadTickets = new TicketHolder( admissionControlReadTickets );
+            admissionReadTicketsLowPriority =
+                new TicketHolder( lowPrioritySliceSize( admissionControlReadTickets ) );
+        }
+        if( admissionControlWriteTickets > 0 ) {
+            admissionWriteTickets = new TicketHolder( admissionControlWriteTickets );
+            admissionWriteTicketsLowPriority =
+                new TicketHolder( lowPrioritySliceSize( admissionControlWriteTickets ) );
+        }
+        return Status::OK();
+    }
+
+    namespace {
+        struct AdmissionMetrics {
+            AdmissionMetrics() : queued(0), totalQueued(0), totalWaitMicros(0) {}
+            AtomicUInt32 queued;         // threads waiting for a ticket right now
+            AtomicInt64 totalQueued;     // operations that ever had to wait
+            AtomicInt64 totalWaitMicros; // total time spent waiting for tickets
+        };
+        AdmissionMetrics readAdmissionMetrics;
+        AdmissionMetrics writeAdmissionMetrics;
+
+        struct AdmissionClassMetrics {
+            AdmissionClassMetrics() : admitted(0), totalQueued(0), totalWaitMicros(0) {}
+            AtomicInt64 admitted;        // ops of this class admitted (throughput)
+            AtomicInt64 totalQueued;     // ops of this class that had to wait
+            AtomicInt64 totalWaitMicros; // admission latency of this class
+        };
+        // indexed by priority class: [0] low, [1] normal, [2] high
+        const char* const kAdmissionClassNames[3] = { "low", "normal", "high" };
+        AdmissionClassMetrics readAdmissionClassMetrics[3];
+        AdmissionClassMetrics writeAdmissionClassMetrics[3];
+
+        // normal/high priority ops currently queued for any admission ticket;
+        // part of the signal telling low priority ops to yield (see
+        // Lock::lowPriorityOpShouldYield)
+        AtomicUInt32 nonLowPriorityTicketWaiters;
+
+        int admissionClassIndex( int priority ) {
+            return priority < 0 ? 0 : ( priority > 0 ? 2 : 1 );
+        }
+
+        /** take tickets for an op of the given priority class.  sets *ticketOut (and,
+            for low priority ops, *lowTicketOut) to the holders to release; leaves them
+            untouched when admission control is off for this kind of operation */
+        void admit( TicketHolder* holder,
+                    TicketHolder* lowPriorityHolder,
+                    AdmissionMetrics& metrics,
+                    AdmissionClassMetrics* classMetrics,
+                    int priority,
+                    TicketHolder** ticketOut,
+                    TicketHolder** lowTicketOut ) {
+            if( holder == NULL )
+                return;
+            AdmissionClassMetrics& cls = classMetrics[ admissionClassIndex( priority ) ];
+            cls.admitted.fetchAndAdd(1);
+            Timer t;
+            bool queued = false;
+            if( priority < 0 && lowPriorityHolder != NULL ) {
+                // the low priority slice caps this class at its weighted share of
+                // the pool before it competes for a regular ticket below
+                if( !lowPriorityHolder->tryAcquire() ) {
+                    queued = true;
+                    metrics.queued.fetchAndAdd(1);
+                    lowPriorityHolder->waitForTicket();
+                }
+                *lowTicketOut = lowPriorityHolder;
+            }
+            if( !holder->tryAcquire() ) {
+                if( !queued ) {
+                    queued = true;
+                    metrics.queued.fetchAndAdd(1);
+                }
+                if( priority >= 0 ) {
+                    nonLowPriorityTicketWaiters.fetchAndAdd(1);
+                    holder->waitForTicket();
+                    nonLowPriorityTicketWaiters.fetchAndSubtract(1);
+                }
+                else {
+                    holder->waitForTicket();
+                }
+            }
+            if( queued ) {
+                long long micros = t.micros();
+                metrics.queued.fetchAndSubtract(1);
+                metrics.totalQueued.fetchAndAdd(1);
+                metrics.totalWaitMicros.fetchAndAdd( micros );
+                cls.totalQueued.fetchAndAdd(1);
+                cls.totalWaitMicros.fetchAndAdd( micros );
+            }
+            *ticketOut = holder;
+        }
+
+        void appendAdmissionInfo( BSONObjBuilder& b,
+                                  StringData name,
+                                  TicketHolder* holder,
+                                  const AdmissionMetrics& metrics,
+                                  const AdmissionClassMetrics* classMetrics ) {
+            BSONObjBuilder sub( b.subobjStart( name ) );
+            sub.append( "out", holder->used() );
+            sub.append( "available", holder->available() );
+            sub.append( "totalTickets", holder->outof() );
+            sub.appendNumber( "queued", static_cast<long long>( metrics.queued.load() ) );
+            sub.appendNumber( "totalQueued", metrics.totalQueued.load() );
+            sub.appendNumber( "totalTimeQueuedMicros", metrics.totalWaitMicros.load() );
+            {
+                BSONObjBuilder classes( sub.subobjStart( "classes" ) );
+                for( int i = 0; i < 3; i++ ) {
+                    // only the default class is always shown; low/high appear once used
+                    if( i != 1 && classMetrics[i].admitted.load() == 0 )
+                        continue;
+                    BSONObjBuilder c( classes.subobjStart( kAdmissionClassNames[i] ) );
+                    c.appendNumber( "admitted", classMetrics[i].admitted.load() );
+                    c.appendNumber( "totalQueued", classMetrics[i].totalQueued.load() );
+                    c.appendNumber( "totalTimeQueuedMicros",
+                                    classMetrics[i].totalWaitMicros.load() );
+                    c.done();
+                }
+                classes.done();
+            }
+            sub.done();
+        }
+    }
+
+    unsigned Lock::writersWaitingOnLockedDB(LockState* lockState) {
+        // otherLock() is a cache that outlives the lock itself, so check the count
+        if( lockState->otherCount() && lockState->otherLock() )
+            return lockState->otherLock()->writersWaiting();
+        if( lockState->nestableCount() )
+            return nestableLocks[lockState->whichNestable()]->writersWaiting();
+        return 0;
+    }
+
     class WrapperForQLock { 
     public:
         QLock q;
@@ -155,6 +372,30 @@ namespace mongo {
         return &qlk.stats;
     }
 
+    unsigned Lock::othersWaitingForLocksHeld(LockState* lockState) {
+        return writersWaitingOnLockedDB(lockState) + qlk.q.exclusiveWaiting();
+    }
+
+    bool Lock::lowPriorityOpShouldYield(LockState* lockState) {
+        if( lockState->admissionPriority() >= 0 )
+            return false;
+        // a normal/high priority op queued for an admission ticket is as starved as
+        // one blocked on a lock we hold -- our ticket is what it is waiting for
+        if( nonLowPriorityTicketWaiters.load() > 0 )
+            return true;
+        return othersWaitingForLocksHeld(lockState) > 0;
+    }
+
+    Lock::ScopedAdmissionPriority::ScopedAdmissionPriority(LockState* lockState, int priority)
+        : _lockState(lockState),
+          _old(lockState->admissionPriority()) {
+        _lockState->setAdmissionPriority(priority);
+    }
+
+    Lock::ScopedAdmissionPriority::~ScopedAdmissionPriority() {
+        _lockState->setAdmissionPriority(_old);
+    }
+
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant(LockState* lockState) {
@@ -428,13 +669,7 @@ namespace mongo {
                 _lockState->nestableCount() == 0);
 
         if (db != _lockState->otherName()) {
-            DBLocksMap::ref r(dblocks);
-            WrapperForRWLock*& lock = r[db];
-            if (lock == NULL) {
-                lock = new WrapperForRWLock(db);
-            }
-
-            _lockState->lockedOther(db, -1, lock);
+            _lockState->lockedOther(db, -1, dblocks.getOrCreate(db));
         }
         else { 
             DEV OCCASIONALLY{ dassert(dblocks.get(db) == _lockState->otherLock()); }
@@ -467,13 +702,7 @@ namespace mongo {
                 _lockState->nestableCount() == 0);
 
         if (db != _lockState->otherName()) {
-            DBLocksMap::ref r(dblocks);
-            WrapperForRWLock*& lock = r[db];
-            if (lock == NULL) {
-                lock = new WrapperForRWLock(db);
-            }
-
-            _lockState->lockedOther(db, 1, lock);
+            _lockState->lockedOther(db, 1, dblocks.getOrCreate(db));
         }
         else { 
             DEV OCCASIONALLY{ dassert(dblocks.get(db) == _lockState->otherLock()); }
@@ -552,20 +781,41 @@ namespace mongo {
         : ScopedLock(lockState, 'w'),
           _isIntentWrite(intentWrite),
           _what(ns.toString()),
-          _nested(false) {
+          _nested(false),
+          _ticket(NULL),
+          _ticketLow(NULL) {
+        // only admit at the outermost lock; a nested acquisition already holds a
+        // ticket (or predates admission control) and waiting here could deadlock
+        if( !lockState->isLocked() )
+            admit( admissionWriteTickets, admissionWriteTicketsLowPriority,
+                   writeAdmissionMetrics, writeAdmissionClassMetrics,
+                   lockState->admissionPriority(), &_ticket, &_ticketLow );
         lockDB(_what);
     }
 
     Lock::DBRead::DBRead(LockState* lockState, const StringData& ns)
-        : ScopedLock(lockState, 'r' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock(lockState, 'r' ), _what(ns.toString()), _nested(false),
+          _ticket(NULL), _ticketLow(NULL) {
+        if( !lockState->isLocked() )
+            admit( admissionReadTickets, admissionReadTicketsLowPriority,
+                   readAdmissionMetrics, readAdmissionClassMetrics,
+                   lockState->admissionPriority(), &_ticket, &_ticketLow );
         lockDB( _what );
     }
 
     Lock::DBWrite::~DBWrite() {
         unlockDB();
+        if( _ticket )
+            _ticket->release();
+        if( _ticketLow )
+            _ticketLow->release();
     }
     Lock::DBRead::~DBRead() {
         unlockDB();
+        if( _ticket )
+            _ticket->release();
+        if( _ticketLow )
+            _ticketLow->release();
     }
 
     void Lock::DBWrite::unlockDB() {
@@ -663,13 +913,7 @@ namespace mongo {
                 _lockState->nestableCount() == 0);
 
         if (db != _lockState->otherName()) {
-            DBLocksMap::ref r(dblocks);
-            WrapperForRWLock*& lock = r[db];
-            if (lock == NULL) {
-                lock = new WrapperForRWLock(db);
-            }
-
-            _lockState->lockedOther(db, -1, lock);
+            _lockState->lockedOther(db, -1, dblocks.getOrCreate(db));
         }
         else { 
             DEV OCCASIONALLY{ dassert(dblocks.get(db) == _lockState->otherLock()); }
@@ -819,6 +1063,20 @@ namespace mongo {
                 ttt.done();
             }
 
+            // ticket admission control, when enabled (see admissionControl*Tickets)
+            if ( admissionReadTickets || admissionWriteTickets ) {
+                BSONObjBuilder ttt( t.subobjStart( "admission" ) );
+                if ( admissionReadTickets )
+                    appendAdmissionInfo( ttt, "readers", admissionReadTickets,
+                                         readAdmissionMetrics,
+                                         readAdmissionClassMetrics );
+                if ( admissionWriteTickets )
+                    appendAdmissionInfo( ttt, "writers", admissionWriteTickets,
+                                         writeAdmissionMetrics,
+                                         writeAdmissionClassMetrics );
+                ttt.done();
+            }
+
             return t.obj();
         }
 
@@ -832,17 +1090,16 @@ namespace mongo {
         LockStatsServerStatusSection() : ServerStatusSection( "locks" ){}
         virtual bool includeByDefault() const { return true; }
 
+        // iterating dblocks contends with every databases' lock traffic; serve
+        // this section from the background snapshot so monitoring stays cheap
+        virtual bool expensiveToGenerate() const { return true; }
+
         BSONObj generateSection( const BSONElement& configElement ) const {
             BSONObjBuilder b;
             b.append(".", qlk.stats.report());
             b.append("admin", nestableLocks[Lock::admin]->getStats().report());
             b.append("local", nestableLocks[Lock::local]->getStats().report());
-            {
-                DBLocksMap::ref r(dblocks);
-                for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
-                    b.append(i->first, i->second->getStats().report());
-                }
-            }
+            dblocks.reportStats(b);
             return b.obj();
         }
 
@@ -44,6 +44,7 @@ namespace mongo {
 
     class WrapperForRWLock;
     class LockState;
+    class TicketHolder;
 
     class Lock : boost::noncopyable { 
     public:
@@ -52,6 +53,38 @@ namespace mongo {
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
 
+        /** @return number of threads blocked waiting for exclusive access to the
+            database the caller currently has locked, 0 if none (or if the caller
+            holds no database lock).  cheap (one atomic read per call) -- long
+            read batches poll this so they can cut themselves short and hand the
+            lock to a waiting writer instead of convoying it behind a full scan. */
+        static unsigned writersWaitingOnLockedDB(LockState* lockState);
+
+        /** @return number of threads blocked either waiting to put the global lock in a
+            stop-the-world state (R/W/X) or waiting for exclusive access to the database
+            the caller has locked.  superset of writersWaitingOnLockedDB() at the same
+            cost (atomic reads only), so yield loops can poll it every few operations
+            and yield only when yielding actually lets someone run. */
+        static unsigned othersWaitingForLocksHeld(LockState* lockState);
+
+        /** @return true if the calling op is low priority and a normal or high priority
+            op is blocked behind a lock it holds or queued for an admission ticket.
+            always false for normal/high priority ops.  atomic reads only, so yield
+            loops can poll it; low priority ops should yield immediately when it fires
+            rather than waiting out their preemption quantum. */
+        static bool lowPriorityOpShouldYield(LockState* lockState);
+
+        /** Sets the admission priority class (see LockState::admissionPriority()) for
+            the enclosed scope, restoring the previous class on destruction. */
+        class ScopedAdmissionPriority : boost::noncopyable {
+        public:
+            ScopedAdmissionPriority(LockState* lockState, int priority);
+            ~ScopedAdmissionPriority();
+        private:
+            LockState* const _lockState;
+            const int _old;
+        };
+
         class ScopedLock;
 
         // note: avoid TempRelease when possible. not a good thing.
@@ -190,6 +223,8 @@ namespace mongo {
             WrapperForRWLock *_weLocked;
             const std::string _what;
             bool _nested;
+            TicketHolder *_ticket;    // admission control ticket held, if any
+            TicketHolder *_ticketLow; // low priority slice ticket held, if any
         };
 
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
@@ -213,7 +248,9 @@ namespace mongo {
             WrapperForRWLock *_weLocked;
             std::string _what;
             bool _nested;
-            
+            TicketHolder *_ticket;    // admission control ticket held, if any
+            TicketHolder *_ticketLow; // low priority slice ticket held, if any
+
         };
 
         /**
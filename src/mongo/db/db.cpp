@@ -41,6 +41,7 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/authz_manager_external_state_d.h"
+#include "mongo/db/btree_verify.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/index_key_validate.h"
@@ -56,6 +57,7 @@
 #include "mongo/db/global_environment_d.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/index_names.h"
+#include "mongo/db/index_pin.h"
 #include "mongo/db/index_rebuilder.h"
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/instance.h"
@@ -68,6 +70,7 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repair_database.h"
+#include "mongo/db/repl/heartbeat.h"
 #include "mongo/db/repl/network_interface_impl.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/repl/repl_coordinator_impl.h"
@@ -80,9 +83,11 @@
 #include "mongo/db/startup_warnings.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/snapshots.h"
+#include "mongo/db/stats/startup_readiness.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/db/structure/scan_readahead_worker.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_writeback.h"
@@ -95,6 +100,7 @@
 #include "mongo/util/exit.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/net/message_server.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/ntservice.h"
 #include "mongo/util/options_parser/startup_options.h"
@@ -183,7 +189,9 @@ namespace mongo {
         }
 
         virtual void process( Message& m , AbstractMessagingPort* port , LastError * le) {
-            OperationContextImpl txn;
+            // Checked out of the pool rather than constructed: this runs once per
+            // request, and recycling the context reuses its RecoveryUnit.
+            PooledOperationContext txn;
             while ( true ) {
                 if ( inShutdown() ) {
                     log() << "got request after shutdown()" << endl;
@@ -193,7 +201,7 @@ namespace mongo {
                 lastError.startRequest( m , le );
 
                 DbResponse dbresponse;
-                assembleResponse( &txn, m, dbresponse, port->remote() );
+                assembleResponse( txn.get(), m, dbresponse, port->remote() );
 
                 if ( dbresponse.response ) {
                     port->reply(m, *dbresponse.response, dbresponse.responseTo);
@@ -274,6 +282,23 @@ namespace mongo {
         // a file descriptor for our calls to select()
         server->setupSockets();
 
+        // Dedicated health channel for replica set heartbeats; see replHealthPort.
+        MessageServer* healthServer = NULL;
+        if (repl::replHealthPort != 0) {
+            if (repl::replHealthPort == port) {
+                warning() << "replHealthPort equals the data port (" << port
+                          << "); health channel disabled" << endl;
+            }
+            else {
+                MessageServer::Options healthOptions;
+                healthOptions.port = repl::replHealthPort;
+                healthOptions.ipList = serverGlobalParams.bind_ip;
+                healthOptions.connTickets = &repl::healthChannelTicketHolder;
+                healthServer = createServer( healthOptions , new MyMessageHandler() );
+                healthServer->setupSockets();
+            }
+        }
+
         logStartup();
         repl::getGlobalReplicationCoordinator()->startReplication(
                 new repl::TopologyCoordinatorImpl(), new repl::NetworkInterfaceImpl());
@@ -284,6 +309,8 @@ namespace mongo {
 #if(TESTEXHAUST)
         boost::thread thr(testExhaust);
 #endif
+        if (healthServer)
+            boost::thread healthThread(stdx::bind(&MessageServer::run, healthServer));
         server->run();
     }
 
@@ -321,34 +348,213 @@ namespace mongo {
         }
     }
 
+    // How many threads open and check databases at startup.  1 keeps the old
+    // serial behavior; deployments with very many databases can raise it so
+    // time-to-accepting-connections is bound by disk parallelism rather than
+    // one file open at a time.
+    MONGO_EXPORT_SERVER_PARAMETER(startupDatabaseOpenThreads, int, 1);
+
+    /**
+     * Startup pass for one database: _id index warnings, tmp collection
+     * cleanup, the datafile version check and the system.indexes key pattern
+     * scan.  Returns false if the database's files are too old to use without
+     * an upgrade; the caller decides how to exit, since this may run on a
+     * worker thread.  The database is left open either way -- closing it
+     * needs the global write lock, which workers do not hold.
+     */
+    static bool openAndCheckDatabase(OperationContext* txn,
+                                     Database* db,
+                                     const string& dbName,
+                                     bool shouldClearNonLocalTmpCollections) {
+        if (repl::replSettings.usingReplSets()) {
+            // we only care about the _id index if we are in a replset
+            checkForIdIndexes(txn, db);
+        }
+
+        if (shouldClearNonLocalTmpCollections || dbName == "local")
+            db->clearTmpCollections(txn);
+
+        if (!db->getDatabaseCatalogEntry()->currentFilesCompatible(txn)) {
+            return false;
+        }
+
+        // major versions match, check indexes
+
+        const string systemIndexes = db->name() + ".system.indexes";
+        Collection* coll = db->getCollection( txn, systemIndexes );
+        auto_ptr<Runner> runner(InternalPlanner::collectionScan(systemIndexes,coll));
+        BSONObj index;
+        Runner::RunnerState state;
+        while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&index, NULL))) {
+            const BSONObj key = index.getObjectField("key");
+            const string plugin = IndexNames::findPluginName(key);
+
+            if (db->getDatabaseCatalogEntry()->isOlderThan24(txn)) {
+                if (IndexNames::existedBefore24(plugin))
+                    continue;
+
+                log() << "Index " << index << " claims to be of type '" << plugin << "', "
+                      << "which is either invalid or did not exist before v2.4. "
+                      << "See the upgrade section: "
+                      << "http://dochub.mongodb.org/core/upgrade-2.4"
+                      << startupWarningsLog;
+            }
+
+            const Status keyStatus = validateKeyPattern(key);
+            if (!keyStatus.isOK()) {
+                log() << "Problem with index " << index << ": " << keyStatus.reason()
+                      << " This index can still be used however it cannot be rebuilt."
+                      << " For more info see"
+                      << " http://dochub.mongodb.org/core/index-validation"
+                      << startupWarningsLog;
+            }
+        }
+
+        if (Runner::RUNNER_EOF != state) {
+            warning() << "Internal error while reading collection " << systemIndexes;
+        }
+
+        return true;
+    }
+
+    /**
+     * Work queue shared by the startup database check threads.  Workers claim
+     * databases through 'nextIndex'.  Failures are only recorded here; the
+     * main thread acts on them after the workers drain, because dbexit and
+     * fassert must not fire on a worker while its siblings hold databases
+     * half open.
+     */
+    struct StartupDbCheckState {
+        StartupDbCheckState() : shouldClearNonLocalTmpCollections(false),
+                                nextIndex(0),
+                                mutex("startupDbCheck") {}
+
+        vector<string> dbNames;
+        bool shouldClearNonLocalTmpCollections;
+
+        AtomicUInt32 nextIndex;
+
+        SimpleMutex mutex;        // guards the fields below
+        string needsUpgradeDb;    // first database with too-old files
+        string firstErrorDb;
+        string firstError;        // first DBException hit by any worker
+    };
+
+    static void startupDbCheckWorker(StartupDbCheckState* state) {
+        Client::initThread("startupDbCheck");
+
+        while (true) {
+            const unsigned i = state->nextIndex.fetchAndAdd(1);
+            if (i >= state->dbNames.size())
+                break;
+            const string dbName = state->dbNames[i];
+            LOG(1) << "\t" << dbName << endl;
+
+            try {
+                OperationContextImpl txn;
+                Lock::DBWrite lk(txn.lockState(), dbName);
+                Client::Context ctx( dbName );
+
+                if (!openAndCheckDatabase(&txn, ctx.db(), dbName,
+                                          state->shouldClearNonLocalTmpCollections)) {
+                    SimpleMutex::scoped_lock sl(state->mutex);
+                    if (state->needsUpgradeDb.empty())
+                        state->needsUpgradeDb = dbName;
+                }
+            }
+            catch (const DBException& e) {
+                SimpleMutex::scoped_lock sl(state->mutex);
+                if (state->firstError.empty()) {
+                    state->firstErrorDb = dbName;
+                    state->firstError = e.toString();
+                }
+            }
+
+            StartupReadiness::noteDatabaseOpened();
+        }
+
+        cc().shutdown();
+    }
+
     // ran at startup.
     static void repairDatabasesAndCheckVersion(bool shouldClearNonLocalTmpCollections) {
         LOG(1) << "enter repairDatabases (to check pdfile version #)" << endl;
 
-        OperationContextImpl txn;
-        Lock::GlobalWrite lk(txn.lockState());
-
         vector< string > dbNames;
         globalStorageEngine->listDatabases( &dbNames );
 
-        for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
-            string dbName = *i;
-            LOG(1) << "\t" << dbName << endl;
+        StartupReadiness::setDatabasesToOpen( dbNames.size() );
+
+        int numThreads = startupDatabaseOpenThreads;
+        if ( numThreads < 1 )
+            numThreads = 1;
+        if ( numThreads > static_cast<int>( dbNames.size() ) )
+            numThreads = dbNames.size();
+
+        // --repair rewrites databases through paths that assume they have the
+        // server to themselves, so it always runs on one thread under the
+        // global lock.
+        if ( mongodGlobalParams.repair )
+            numThreads = 1;
+
+        if ( numThreads <= 1 ) {
+            OperationContextImpl txn;
+            Lock::GlobalWrite lk(txn.lockState());
+
+            for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
+                string dbName = *i;
+                LOG(1) << "\t" << dbName << endl;
+
+                Client::Context ctx( dbName );
+
+                if ( mongodGlobalParams.repair ) {
+                    if (repl::replSettings.usingReplSets()) {
+                        // we only care about the _id index if we are in a replset
+                        checkForIdIndexes(&txn, ctx.db());
+                    }
+
+                    if (shouldClearNonLocalTmpCollections || dbName == "local")
+                        ctx.db()->clearTmpCollections(&txn);
 
-            Client::Context ctx( dbName );
+                    fassert(18506, globalStorageEngine->repairDatabase(&txn, dbName));
+                }
+                else if (!openAndCheckDatabase(&txn, ctx.db(), dbName,
+                                               shouldClearNonLocalTmpCollections)) {
+                    log() << "****";
+                    log() << "cannot do this upgrade without an upgrade in the middle";
+                    log() << "please do a --repair with 2.6 and then start this version";
+                    dbexit( EXIT_NEED_UPGRADE );
+                    invariant( false );
+                    return;
+                }
+                else {
+                    Database::closeDatabase(&txn, dbName.c_str());
+                }
 
-            if (repl::replSettings.usingReplSets()) {
-                // we only care about the _id index if we are in a replset
-                checkForIdIndexes(&txn, ctx.db());
+                StartupReadiness::noteDatabaseOpened();
             }
+        }
+        else {
+            log() << "opening and checking " << dbNames.size() << " databases with "
+                  << numThreads << " threads" << endl;
 
-            if (shouldClearNonLocalTmpCollections || dbName == "local")
-                ctx.db()->clearTmpCollections(&txn);
+            StartupDbCheckState state;
+            state.dbNames = dbNames;
+            state.shouldClearNonLocalTmpCollections = shouldClearNonLocalTmpCollections;
 
-            if ( mongodGlobalParams.repair ) {
-                fassert(18506, globalStorageEngine->repairDatabase(&txn, dbName));
+            vector< boost::shared_ptr<boost::thread> > threads;
+            for ( int i = 0; i < numThreads; i++ ) {
+                threads.push_back( boost::shared_ptr<boost::thread>(
+                        new boost::thread( stdx::bind( &startupDbCheckWorker, &state ) ) ) );
             }
-            else if (!ctx.db()->getDatabaseCatalogEntry()->currentFilesCompatible(&txn)) {
+            for ( size_t i = 0; i < threads.size(); i++ ) {
+                threads[i]->join();
+            }
+
+            OperationContextImpl txn;
+            Lock::GlobalWrite lk(txn.lockState());
+
+            if ( !state.needsUpgradeDb.empty() ) {
                 log() << "****";
                 log() << "cannot do this upgrade without an upgrade in the middle";
                 log() << "please do a --repair with 2.6 and then start this version";
@@ -356,48 +562,23 @@ namespace mongo {
                 invariant( false );
                 return;
             }
-            else {
-                // major versions match, check indexes
-
-                const string systemIndexes = ctx.db()->name() + ".system.indexes";
-                Collection* coll = ctx.db()->getCollection( &txn, systemIndexes );
-                auto_ptr<Runner> runner(InternalPlanner::collectionScan(systemIndexes,coll));
-                BSONObj index;
-                Runner::RunnerState state;
-                while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&index, NULL))) {
-                    const BSONObj key = index.getObjectField("key");
-                    const string plugin = IndexNames::findPluginName(key);
-
-                    if (ctx.db()->getDatabaseCatalogEntry()->isOlderThan24(&txn)) {
-                        if (IndexNames::existedBefore24(plugin))
-                            continue;
-
-                        log() << "Index " << index << " claims to be of type '" << plugin << "', "
-                              << "which is either invalid or did not exist before v2.4. "
-                              << "See the upgrade section: "
-                              << "http://dochub.mongodb.org/core/upgrade-2.4"
-                              << startupWarningsLog;
-                    }
 
-                    const Status keyStatus = validateKeyPattern(key);
-                    if (!keyStatus.isOK()) {
-                        log() << "Problem with index " << index << ": " << keyStatus.reason()
-                              << " This index can still be used however it cannot be rebuilt."
-                              << " For more info see"
-                              << " http://dochub.mongodb.org/core/index-validation"
-                              << startupWarningsLog;
-                    }
-                }
-
-                if (Runner::RUNNER_EOF != state) {
-                    warning() << "Internal error while reading collection " << systemIndexes;
-                }
+            if ( !state.firstError.empty() ) {
+                log() << "exception opening database " << state.firstErrorDb
+                      << " at startup: " << state.firstError;
+                fassertFailed( 18558 );
+            }
 
-                Database::closeDatabase(&txn, dbName.c_str());
+            // The workers leave their databases open (closing needs the global
+            // write lock).  Closing is memory work, not I/O, so even hundreds
+            // of databases drop out quickly here.
+            for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
+                Database::closeDatabase(&txn, i->c_str());
             }
         }
 
         LOG(1) << "done repairDatabases" << endl;
+        StartupReadiness::noteStartupComplete();
     }
 
     void clearTmpFiles() {
@@ -430,6 +611,13 @@ namespace mongo {
         return 0;
     }
 
+    // NUMA node to pin the DataFileSync flusher thread to (-1 = don't pin).  With
+    // default first-touch placement the datafiles tend to live on one node, and
+    // pinning the flusher there keeps its page table walks local; with interleaved
+    // views (numaInterleaveDataFileViews) there is no good node and pinning buys
+    // nothing, so leave this off.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaDataFileSyncNode, int, -1);
+
     /**
      * does background async flushes of mmapped files
      */
@@ -448,6 +636,16 @@ namespace mongo {
 
         void run() {
             Client::initThread( name().c_str() );
+            if (numaDataFileSyncNode >= 0) {
+                if (numautil::bindThisThreadToNode(numaDataFileSyncNode)) {
+                    log() << name() << " thread bound to NUMA node "
+                          << numaDataFileSyncNode << endl;
+                }
+                else {
+                    warning() << "could not bind " << name() << " thread to NUMA node "
+                              << numaDataFileSyncNode << endl;
+                }
+            }
             if (storageGlobalParams.syncdelay == 0) {
                 log() << "warning: --syncdelay 0 is not recommended and can have strange performance" << endl;
             }
@@ -474,7 +672,7 @@ namespace mongo {
                 }
 
                 Date_t start = jsTime();
-                int numFiles = globalStorageEngine->flushAllFiles( true );
+                int numFiles = globalStorageEngine->flushDirtyFiles();
                 time_flushing = (int) (jsTime() - start);
 
                 _flushed(time_flushing);
@@ -686,13 +884,20 @@ namespace mongo {
         /* this is for security on certain platforms (nonce generation) */
         srand((unsigned) (curTimeMicros() ^ startupSrandTimer.micros()));
 
-        // The snapshot thread provides historical collection level and lock statistics for use
-        // by the web interface. Only needed when HTTP is enabled.
+        // The snapshot task provides historical collection level and lock statistics for use
+        // by the web interface. Only needed when HTTP is enabled.  Registers itself with the
+        // periodic task scheduler; never deleted.
         if (serverGlobalParams.isHttpInterfaceEnabled)
-            snapshotThread.go();
+            new StatsSnapshotTask();
 
-        d.clientCursorMonitor.go();
+        // The client cursor monitor and other periodic tasks run on one shared scheduler
+        // thread rather than a thread apiece.
         PeriodicTask::startRunningPeriodicTasks();
+        startFastClockThread();
+        startBtreeVerifyJob();
+        startServerStatusSnapshotThread();
+        startIndexPinJob();
+        scanReadaheadWorker.go();
         if (missingRepl) {
             // a warning was logged earlier
         }
@@ -51,8 +51,10 @@
 #include "mongo/db/commands/shutdown.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/stats/working_set_heat.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
+#include "mongo/db/index/btree_based_access_method.h"
 #include "mongo/db/index_builder.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
@@ -1000,6 +1002,28 @@ namespace mongo {
                                                                                   scale) / scale );
             result.append("indexSizes", indexSizes.obj());
 
+            // Only present once the collection has been sampled by the working set
+            // estimator.
+            {
+                BSONObjBuilder heat;
+                if ( WorkingSetHeat::global.appendForNamespace( ns, heat ) ) {
+                    result.append( "workingSetHeat", heat.obj() );
+                }
+            }
+
+            // Only present when the optional _id bloom filter is enabled.
+            IndexDescriptor* idDesc = collection->getIndexCatalog()->findIdIndex();
+            if ( idDesc ) {
+                // This may not be valid always.  See SERVER-12397.
+                const BtreeBasedAccessMethod* accessMethod =
+                    static_cast<const BtreeBasedAccessMethod*>(
+                            collection->getIndexCatalog()->getIndex( idDesc ) );
+                BSONObjBuilder bloomStats;
+                if ( accessMethod->appendIdBloomFilterStats( &bloomStats ) ) {
+                    result.append( "idBloomFilter", bloomStats.obj() );
+                }
+            }
+
             return true;
         }
 
@@ -160,6 +160,37 @@ namespace mongo {
         }
     } pingCmd;
 
+    /* negotiate snappy compression of message payloads on this connection.  issued by
+       secondaries against their sync source and by mongos against shards; once it
+       succeeds both ends compress what they send above a size threshold. */
+    class NetworkCompressCommand : public Command {
+    public:
+        NetworkCompressCommand() : Command( "networkCompress" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return false; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help( stringstream &help ) const {
+            help << "enable snappy compression of messages sent on this connection";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::internal);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(OperationContext* txn, const string& badns, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            AbstractMessagingPort* mp = cc().port();
+            if ( !mp ) {
+                errmsg = "no messaging port on this connection";
+                return false;
+            }
+            mp->enableCompression();
+            result.append( "algorithm", "snappy" );
+            return true;
+        }
+    } networkCompressCmd;
+
     class FeaturesCmd : public Command {
     public:
         FeaturesCmd() : Command( "features", true ) {}
@@ -56,6 +56,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
 
@@ -299,6 +300,38 @@ namespace mongo {
         return true;
     }
 
+    namespace {
+
+        // Pool of tickets governing how many documents range cleanup
+        // (Helpers::removeRange) may delete per write lock acquisition, across
+        // all deletions in flight.  One ticket buys one document.  After each
+        // batch the pool is resized based on how long the secondaries took to
+        // replicate it, so cleanup proceeds as fast as the secondaries can
+        // absorb without building up lag that foreground operations would
+        // later pay for.
+        TicketHolder rangeDeleterBatchTickets( 16 );
+
+        const int kMinRangeDeleteBatchTickets = 1;
+        const int kMaxRangeDeleteBatchTickets = 256;
+
+        // Replication wait per batch below which the pool grows and above
+        // which it shrinks.
+        const long long kReplFastMillis = 50;
+        const long long kReplSlowMillis = 1000;
+
+        void adjustRangeDeleteBatchTickets( long long replMillis ) {
+            const int outof = rangeDeleterBatchTickets.outof();
+            if ( replMillis <= kReplFastMillis && outof < kMaxRangeDeleteBatchTickets ) {
+                rangeDeleterBatchTickets.resize(
+                        std::min( outof * 2, kMaxRangeDeleteBatchTickets ) );
+            }
+            else if ( replMillis >= kReplSlowMillis && outof > kMinRangeDeleteBatchTickets ) {
+                rangeDeleterBatchTickets.resize(
+                        std::max( outof / 2, kMinRangeDeleteBatchTickets ) );
+            }
+        }
+    }
+
     long long Helpers::removeRange( OperationContext* txn,
                                     const KeyRange& range,
                                     bool maxInclusive,
@@ -345,91 +378,119 @@ namespace mongo {
         
         long long millisWaitingForReplication = 0;
 
-        while ( 1 ) {
+        bool done = false;
+        while ( !done ) {
+            // Size this batch from the adaptive ticket pool: always take one
+            // ticket, waiting if concurrent deletions hold them all, then
+            // greedily take whatever else is available.
+            rangeDeleterBatchTickets.waitForTicket();
+            int batchTickets = 1;
+            while ( rangeDeleterBatchTickets.tryAcquire() ) {
+                ++batchTickets;
+            }
+
+            long long batchDeleted = 0;
+
             // Scoping for write lock.
             {
                 Client::WriteContext ctx(txn, ns);
-                Collection* collection = ctx.ctx().db()->getCollection( txn, ns );
-                if ( !collection )
-                    break;
-
-                IndexDescriptor* desc =
-                    collection->getIndexCatalog()->findIndexByKeyPattern( indexKeyPattern.toBSON() );
-
-                auto_ptr<Runner> runner(InternalPlanner::indexScan(collection, desc, min, max,
-                                                                   maxInclusive,
-                                                                   InternalPlanner::FORWARD,
-                                                                   InternalPlanner::IXSCAN_FETCH));
-
-                DiskLoc rloc;
-                BSONObj obj;
-                Runner::RunnerState state;
-                // This may yield so we cannot touch nsd after this.
-                state = runner->getNext(&obj, &rloc);
-                runner.reset();
-                if (Runner::RUNNER_EOF == state) { break; }
-
-                if (Runner::RUNNER_DEAD == state) {
-                    warning() << "cursor died: aborting deletion for "
-                              << min << " to " << max << " in " << ns
-                              << endl;
-                    break;
-                }
-
-                if (Runner::RUNNER_ERROR == state) {
-                    warning() << "cursor error while trying to delete "
-                              << min << " to " << max
-                              << " in " << ns << ": "
-                              << WorkingSetCommon::toStatusString(obj) << endl;
-                    break;
-                }
 
-                verify(Runner::RUNNER_ADVANCED == state);
-
-                if ( onlyRemoveOrphanedDocs ) {
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
-
-                    // We should never be able to turn off the sharding state once enabled, but
-                    // in the future we might want to.
-                    verify(shardingState.enabled());
-
-                    // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
-
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        KeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractSingleKey( obj );
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
+                for ( int i = 0; i < batchTickets; i++ ) {
+                    Collection* collection = ctx.ctx().db()->getCollection( txn, ns );
+                    if ( !collection ) {
+                        done = true;
+                        break;
                     }
-                    else {
-                        docIsOrphan = false;
+
+                    IndexDescriptor* desc =
+                        collection->getIndexCatalog()->findIndexByKeyPattern(
+                                indexKeyPattern.toBSON() );
+
+                    auto_ptr<Runner> runner(InternalPlanner::indexScan(collection, desc, min, max,
+                                                                       maxInclusive,
+                                                                       InternalPlanner::FORWARD,
+                                                                       InternalPlanner::IXSCAN_FETCH));
+
+                    DiskLoc rloc;
+                    BSONObj obj;
+                    Runner::RunnerState state;
+                    // This may yield so we cannot touch nsd after this.
+                    state = runner->getNext(&obj, &rloc);
+                    runner.reset();
+                    if (Runner::RUNNER_EOF == state) { done = true; break; }
+
+                    if (Runner::RUNNER_DEAD == state) {
+                        warning() << "cursor died: aborting deletion for "
+                                  << min << " to " << max << " in " << ns
+                                  << endl;
+                        done = true;
+                        break;
                     }
 
-                    if ( !docIsOrphan ) {
-                        warning() << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
+                    if (Runner::RUNNER_ERROR == state) {
+                        warning() << "cursor error while trying to delete "
+                                  << min << " to " << max
+                                  << " in " << ns << ": "
+                                  << WorkingSetCommon::toStatusString(obj) << endl;
+                        done = true;
                         break;
                     }
+
+                    verify(Runner::RUNNER_ADVANCED == state);
+
+                    if ( onlyRemoveOrphanedDocs ) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our migration
+                        // cleanup.
+
+                        // We should never be able to turn off the sharding state once enabled, but
+                        // in the future we might want to.
+                        verify(shardingState.enabled());
+
+                        // In write lock, so will be the most up-to-date version
+                        CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            KeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractSingleKey( obj );
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning() << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + obj.toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
+                    }
+                    if ( callback )
+                        callback->goingToDelete( obj );
+
+                    BSONObj deletedId;
+                    collection->deleteDocument( txn, rloc, false, false, &deletedId );
+                    // The above throws on failure, and so is not logged
+                    repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
+                    numDeleted++;
+                    batchDeleted++;
                 }
-                if ( callback )
-                    callback->goingToDelete( obj );
-
-                BSONObj deletedId;
-                collection->deleteDocument( txn, rloc, false, false, &deletedId );
-                // The above throws on failure, and so is not logged
-                repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
-                numDeleted++;
+            }
+
+            // Hand the tickets back before (possibly) blocking on replication
+            // so concurrent deletions aren't serialized behind our wait.
+            for ( int i = 0; i < batchTickets; i++ ) {
+                rangeDeleterBatchTickets.release();
             }
 
             // TODO remove once the yielding below that references this timer has been removed
             Timer secondaryThrottleTime;
 
-            if ( secondaryThrottle && numDeleted > 0 ) {
+            if ( secondaryThrottle && batchDeleted > 0 ) {
                 WriteConcernOptions writeConcern;
                 writeConcern.wNumNodes = 2;
                 writeConcern.wTimeout = 60 * 1000;
@@ -445,6 +506,7 @@ namespace mongo {
                     massertStatusOK(replStatus.status);
                 }
                 millisWaitingForReplication += replStatus.duration.total_milliseconds();
+                adjustRangeDeleteBatchTickets( replStatus.duration.total_milliseconds() );
             }
         }
         
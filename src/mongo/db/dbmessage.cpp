@@ -66,6 +66,49 @@ namespace mongo {
     }
 
 
+    ChunkedReplyBuilder::ChunkedReplyBuilder() : _len( 0 ) {
+        _newSegment();
+        // reserve room for the reply header in the first segment
+        _segments.back().second = sizeof(QueryResult);
+        _len = sizeof(QueryResult);
+    }
+
+    ChunkedReplyBuilder::~ChunkedReplyBuilder() {
+        for ( size_t i = 0; i < _segments.size(); i++ )
+            free( _segments[i].first );
+    }
+
+    void ChunkedReplyBuilder::_newSegment() {
+        char* seg = static_cast<char*>( malloc( kSegmentBytes ) );
+        _segments.push_back( std::make_pair( seg, 0 ) );
+    }
+
+    void ChunkedReplyBuilder::appendBuf(const void* data, int len) {
+        const char* p = static_cast<const char*>( data );
+        while ( len > 0 ) {
+            int room = kSegmentBytes - _segments.back().second;
+            if ( room == 0 ) {
+                _newSegment();
+                room = kSegmentBytes;
+            }
+            int n = len < room ? len : room;
+            memcpy( _segments.back().first + _segments.back().second, p, n );
+            _segments.back().second += n;
+            p += n;
+            len -= n;
+            _len += n;
+        }
+    }
+
+    void ChunkedReplyBuilder::putInMessage(Message* out) {
+        // Message::appendData maintains the header's total len as each
+        // segment is added.
+        for ( size_t i = 0; i < _segments.size(); i++ )
+            out->appendData( _segments[i].first, _segments[i].second );
+        _segments.clear();
+        _len = 0;
+    }
+
     void replyToQuery(int queryResultFlags,
                       AbstractMessagingPort* p, Message& requestMsg,
                       void *data, int size,
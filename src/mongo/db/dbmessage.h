@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/client/constants.h"
 #include "mongo/db/jsobj.h"
@@ -294,6 +295,51 @@ namespace mongo {
         ~DbResponse() { delete response; }
     };
 
+    /**
+     * Builds a query reply (OP_REPLY) in fixed-size segments instead of one
+     * contiguous, growing buffer.  The segments are handed to the response
+     * Message, which the network layer writes to the socket as a vector of
+     * fragments, so peak contiguous reply memory is bounded by the segment
+     * size no matter how large the batch gets.  (The wire format carries the
+     * total message length up front, so the reply cannot start going out on
+     * the socket until the batch is complete.)
+     */
+    class ChunkedReplyBuilder {
+        MONGO_DISALLOW_COPYING(ChunkedReplyBuilder);
+    public:
+        static const int kSegmentBytes = 64 * 1024;
+
+        ChunkedReplyBuilder();
+        ~ChunkedReplyBuilder();
+
+        /** Appends bytes, spilling across segment boundaries as needed. */
+        void appendBuf(const void* data, int len);
+
+        /** Total reply bytes appended, including the QueryResult header. */
+        int len() const { return _len; }
+
+        /**
+         * The reply header, for filling in flags, cursor id, etc.  Lives at
+         * the front of the first segment and is stable across appends; the
+         * len field is maintained by putInMessage, not here.
+         */
+        QueryResult* header() { return reinterpret_cast<QueryResult*>(_segments[0].first); }
+
+        /**
+         * Moves the segments into 'out', which takes ownership and sends them
+         * with a single vectored write.  Leaves this builder empty.
+         */
+        void putInMessage(Message* out);
+
+    private:
+        void _newSegment();
+
+        // malloc'ed (segment, bytes used) pairs; ownership passes to the
+        // Message in putInMessage
+        std::vector< std::pair<char*, int> > _segments;
+        int _len;
+    };
+
     void replyToQuery(int queryResultFlags,
                       AbstractMessagingPort* p, Message& requestMsg,
                       void *data, int size,
@@ -28,29 +28,334 @@
 
 #include "mongo/db/exec/and_hash.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace {
 
     // Upper limit for buffered data.
-    // Stage execution will fail once size of all buffered data exceeds this threshold.
+    // Stage execution will fail once size of all buffered data exceeds this threshold,
+    // unless spilling to disk is enabled (see internalQueryHashIntersectionSpillToDisk).
     const size_t kDefaultMaxMemUsageBytes = 32 * 1024 * 1024;
 
+    // Used to make spill file names unique across concurrent spilled intersections.
+    mongo::AtomicUInt32 spillFileCounter;
+
 } // namespace
 
 namespace mongo {
 
     using std::auto_ptr;
 
+    namespace {
+        // Process-wide accounting for hash-intersection build tables
+        // (serverStatus memoryAccounting section).
+        MemoryAccount andHashMemoryAccount( "andHash" );
+    }
+
     const size_t AndHashStage::kLookAheadWorks = 10;
 
+    // With the default 32MB memory limit this supports build sides of roughly half a
+    // gigabyte before a loaded partition itself outgrows the limit; beyond that we
+    // keep going and simply use more memory per partition.
+    const size_t AndHashStage::kSpillPartitions = 16;
+
     // static
     const char* AndHashStage::kStageType = "AND_HASH";
 
+    /**
+     * Owns the temporary files backing a spilled hashed AND.
+     *
+     * Records are (DiskLoc, seen flag, index key data) tuples partitioned by a hash of
+     * the DiskLoc.  Two file sets exist per partition: 'acc' holds the accumulated
+     * intersection of the children consumed so far and 'cur' holds the output of the
+     * child currently being drained.  When that child hits EOF, each acc partition is
+     * loaded into an in-memory table and probed with the matching cur partition.
+     *
+     * Files live under <dbpath>/_tmp like the external sorter's and are removed on
+     * destruction.  Records are written in native byte order; they never outlive the
+     * stage, let alone the process.
+     */
+    class AndHashSpiller {
+        MONGO_DISALLOW_COPYING(AndHashSpiller);
+    public:
+        struct Record {
+            Record() : seen(false) {}
+
+            DiskLoc loc;
+
+            // Has some child already matched this record?  Set while probing, and
+            // persisted so that a mid-child spill does not forget earlier matches.
+            bool seen;
+
+            std::vector<IndexKeyDatum> keys;
+        };
+
+        AndHashSpiller(size_t numPartitions, const std::string& tempDir)
+            : _accRecords(0), _accRecordsNext(0), _spilledRecords(0) {
+            boost::filesystem::create_directories(tempDir);
+            const unsigned spillId = spillFileCounter.fetchAndAdd(1);
+            _partitions.resize(numPartitions);
+            for (size_t i = 0; i < numPartitions; ++i) {
+                mongoutils::str::stream prefix;
+                prefix << tempDir << "/and_hash." << spillId << "." << i;
+                const std::string prefixStr(prefix);
+                _partitions[i].accPath = prefixStr + ".acc";
+                _partitions[i].curPath = prefixStr + ".cur";
+            }
+        }
+
+        ~AndHashSpiller() {
+            for (size_t i = 0; i < _partitions.size(); ++i) {
+                _partitions[i].accOut.reset();
+                _partitions[i].curOut.reset();
+                removeQuietly(_partitions[i].accPath);
+                removeQuietly(_partitions[i].curPath);
+            }
+        }
+
+        size_t numPartitions() const { return _partitions.size(); }
+
+        // Number of records in the accumulated intersection as of the last completed
+        // child pass.
+        size_t accRecords() const { return _accRecords; }
+
+        // Total records ever written to spill files, for stats.
+        size_t spilledRecords() const { return _spilledRecords; }
+
+        void addAccRecord(const Record& rec) {
+            Partition& part = _partitions[partitionOf(rec.loc)];
+            if (!part.accOut) {
+                part.accOut.reset(openForAppend(part.accPath));
+            }
+            appendRecord(part.accOut.get(), part.accPath, rec);
+            ++_accRecords;
+        }
+
+        void addCurRecord(const Record& rec) {
+            Partition& part = _partitions[partitionOf(rec.loc)];
+            if (!part.curOut) {
+                part.curOut.reset(openForAppend(part.curPath));
+            }
+            appendRecord(part.curOut.get(), part.curPath, rec);
+        }
+
+        /**
+         * Loads acc partition 'p', probes it with cur partition 'p' and appends the
+         * matched records (preexisting seen flags count as matches, cleared on output)
+         * to 'survivors' in arbitrary order.  Key data from matching probe records is
+         * merged in, as AndCommon::mergeFrom does for the in-memory table.
+         */
+        void intersectPartition(size_t p, std::vector<Record>* survivors) {
+            Partition& part = _partitions[p];
+            part.accOut.reset();
+            part.curOut.reset();
+
+            std::vector<Record> accRecs;
+            readAll(part.accPath, &accRecs);
+
+            typedef unordered_map<DiskLoc, size_t, DiskLoc::Hasher> LocIndex;
+            LocIndex index;
+            for (size_t i = 0; i < accRecs.size(); ++i) {
+                index.insert(std::make_pair(accRecs[i].loc, i));
+            }
+
+            std::ifstream in(part.curPath.c_str(), std::ios::in | std::ios::binary);
+            if (in) {
+                Record rec;
+                while (readRecord(in, part.curPath, &rec)) {
+                    LocIndex::const_iterator it = index.find(rec.loc);
+                    if (index.end() == it) {
+                        continue;
+                    }
+                    Record& target = accRecs[it->second];
+                    target.seen = true;
+                    mergeKeys(&target, rec);
+                }
+            }
+
+            for (size_t i = 0; i < accRecs.size(); ++i) {
+                if (accRecs[i].seen) {
+                    accRecs[i].seen = false;
+                    survivors->push_back(accRecs[i]);
+                }
+            }
+        }
+
+        /**
+         * Replaces acc partition 'p' with 'records'.  Used after intersecting a
+         * non-final child.
+         */
+        void rewriteAccPartition(size_t p, const std::vector<Record>& records) {
+            Partition& part = _partitions[p];
+            removeQuietly(part.accPath);
+            part.accOut.reset(openForAppend(part.accPath));
+            for (size_t i = 0; i < records.size(); ++i) {
+                appendRecord(part.accOut.get(), part.accPath, records[i]);
+            }
+            part.accOut.reset();
+            _accRecordsNext += records.size();
+        }
+
+        /**
+         * Ends the current child's pass: discards the cur files and rolls the acc
+         * record count over to what the rewrites produced.
+         */
+        void finishChildPass() {
+            for (size_t i = 0; i < _partitions.size(); ++i) {
+                _partitions[i].curOut.reset();
+                removeQuietly(_partitions[i].curPath);
+            }
+            _accRecords = _accRecordsNext;
+            _accRecordsNext = 0;
+        }
+
+    private:
+        struct Partition {
+            std::string accPath;
+            std::string curPath;
+
+            // Open only while a drain or rewrite is appending, so that at most one
+            // partition set's worth of file handles is held at a time.
+            boost::shared_ptr<std::ofstream> accOut;
+            boost::shared_ptr<std::ofstream> curOut;
+        };
+
+        size_t partitionOf(const DiskLoc& loc) const {
+            DiskLoc::Hasher hasher;
+            return hasher(loc) % _partitions.size();
+        }
+
+        static void removeQuietly(const std::string& path) {
+            try {
+                boost::filesystem::remove(path);
+            }
+            catch (const std::exception& e) {
+                warning() << "error removing hashed AND spill file " << path
+                          << ": " << e.what();
+            }
+        }
+
+        static std::ofstream* openForAppend(const std::string& path) {
+            std::auto_ptr<std::ofstream> out(new std::ofstream(
+                path.c_str(), std::ios::out | std::ios::binary | std::ios::app));
+            massert(18531,
+                    mongoutils::str::stream() << "hashed AND stage failed to open "
+                                              << "spill file " << path,
+                    out->good());
+            return out.release();
+        }
+
+        void appendRecord(std::ofstream* out, const std::string& path, const Record& rec) {
+            const int a = rec.loc.a();
+            const int ofs = rec.loc.getOfs();
+            const char seen = rec.seen ? 1 : 0;
+            const unsigned numKeys = rec.keys.size();
+            out->write(reinterpret_cast<const char*>(&a), sizeof(a));
+            out->write(reinterpret_cast<const char*>(&ofs), sizeof(ofs));
+            out->write(&seen, 1);
+            out->write(reinterpret_cast<const char*>(&numKeys), sizeof(numKeys));
+            for (size_t i = 0; i < rec.keys.size(); ++i) {
+                const BSONObj& pattern = rec.keys[i].indexKeyPattern;
+                const BSONObj& key = rec.keys[i].keyData;
+                out->write(pattern.objdata(), pattern.objsize());
+                out->write(key.objdata(), key.objsize());
+            }
+            massert(18532,
+                    mongoutils::str::stream() << "hashed AND stage failed writing "
+                                              << "spill file " << path,
+                    out->good());
+            ++_spilledRecords;
+        }
+
+        static BSONObj readBSON(std::istream& in, const std::string& path) {
+            int size = 0;
+            in.read(reinterpret_cast<char*>(&size), sizeof(size));
+            massert(18533,
+                    mongoutils::str::stream() << "hashed AND stage read a corrupt "
+                                              << "spill record from " << path,
+                    in.good() && size >= 5 && size <= BSONObjMaxInternalSize);
+            std::vector<char> buf(size);
+            memcpy(&buf[0], &size, sizeof(size));
+            in.read(&buf[0] + sizeof(size), size - sizeof(size));
+            massert(18534,
+                    mongoutils::str::stream() << "hashed AND stage hit a truncated "
+                                              << "spill record in " << path,
+                    in.good());
+            return BSONObj(&buf[0]).getOwned();
+        }
+
+        // Returns false on a clean end-of-file.
+        static bool readRecord(std::istream& in, const std::string& path, Record* rec) {
+            int a = 0;
+            in.read(reinterpret_cast<char*>(&a), sizeof(a));
+            if (in.eof()) {
+                return false;
+            }
+            int ofs = 0;
+            char seen = 0;
+            unsigned numKeys = 0;
+            in.read(reinterpret_cast<char*>(&ofs), sizeof(ofs));
+            in.read(&seen, 1);
+            in.read(reinterpret_cast<char*>(&numKeys), sizeof(numKeys));
+            massert(18535,
+                    mongoutils::str::stream() << "hashed AND stage hit a truncated "
+                                              << "spill record in " << path,
+                    in.good());
+            rec->loc = DiskLoc(a, ofs);
+            rec->seen = (0 != seen);
+            rec->keys.clear();
+            for (unsigned i = 0; i < numKeys; ++i) {
+                BSONObj pattern = readBSON(in, path);
+                BSONObj key = readBSON(in, path);
+                rec->keys.push_back(IndexKeyDatum(pattern, key));
+            }
+            return true;
+        }
+
+        static void readAll(const std::string& path, std::vector<Record>* out) {
+            std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+            if (!in) {
+                // Nothing was ever written to this partition.
+                return;
+            }
+            Record rec;
+            while (readRecord(in, path, &rec)) {
+                out->push_back(rec);
+            }
+        }
+
+        // Merge 'src's keys into 'dest', first pattern wins, as AndCommon::mergeFrom.
+        static void mergeKeys(Record* dest, const Record& src) {
+            for (size_t i = 0; i < src.keys.size(); ++i) {
+                bool found = false;
+                for (size_t j = 0; j < dest->keys.size(); ++j) {
+                    if (dest->keys[j].indexKeyPattern == src.keys[i].indexKeyPattern) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) { dest->keys.push_back(src.keys[i]); }
+            }
+        }
+
+        std::vector<Partition> _partitions;
+        size_t _accRecords;
+        size_t _accRecordsNext;
+        size_t _spilledRecords;
+    };
+
     AndHashStage::AndHashStage(WorkingSet* ws, 
                                const MatchExpression* filter,
                                const Collection* collection)
@@ -61,7 +366,10 @@ namespace mongo {
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
-          _maxMemUsage(kDefaultMaxMemUsageBytes) {}
+          _maxMemUsage(kDefaultMaxMemUsageBytes),
+          _memTracker(andHashMemoryAccount),
+          _spillPhase(kSpillDrain),
+          _spillPartition(0) {}
 
     AndHashStage::AndHashStage(WorkingSet* ws, 
                                const MatchExpression* filter,
@@ -74,7 +382,10 @@ namespace mongo {
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
-          _maxMemUsage(maxMemUsage) {}
+          _maxMemUsage(maxMemUsage),
+          _memTracker(andHashMemoryAccount),
+          _spillPhase(kSpillDrain),
+          _spillPartition(0) {}
 
     AndHashStage::~AndHashStage() {
         for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
@@ -90,6 +401,12 @@ namespace mongo {
         // This is empty before calling work() and not-empty after.
         if (_lookAheadResults.empty()) { return false; }
 
+        // In spilled mode we're done once every child has been intersected and all
+        // surviving results have been returned.
+        if (_spiller) {
+            return (kSpillDone == _spillPhase) && _spillResults.empty();
+        }
+
         // Either we're busy hashing children, in which case we're not done yet.
         if (_hashingChildren) { return false; }
 
@@ -171,14 +488,32 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        // Once we've exceeded the memory limit we run the spilled (Grace hash) strategy
+        // until EOF.
+        if (_spiller) {
+            return workSpilled(out);
+        }
+
         // An AND is either reading the first child into the hash table, probing against the hash
         // table with subsequent children, or checking the last child's results to see if they're
         // in the hash table.
 
         // We read the first child into our hash table.
         if (_hashingChildren) {
-            // Check memory usage of previously hashed results.
-            if (_memUsage > _maxMemUsage) {
+            _memTracker.set(_memUsage);
+
+            // Check memory usage of previously hashed results.  The
+            // process-wide budget triggers the same spill-or-fail policy as
+            // the per-stage limit, so concurrent intersections degrade to
+            // disk together instead of stacking up in memory.
+            if (_memUsage > _maxMemUsage ||
+                (_memUsage > 0 && MemoryAccount::wouldExceedBudget(0))) {
+                if (internalQueryHashIntersectionSpillToDisk) {
+                    enterSpillMode();
+                    ++_commonStats.needTime;
+                    return PlanStage::NEED_TIME;
+                }
+
                 mongoutils::str::stream ss;
                 ss << "hashed AND stage buffered data usage of " << _memUsage
                    << " bytes exceeds internal limit of " << kDefaultMaxMemUsageBytes << " bytes";
@@ -432,6 +767,213 @@ namespace mongo {
         }
     }
 
+    void AndHashStage::enterSpillMode() {
+        verify(!_spiller);
+        _spiller.reset(new AndHashSpiller(kSpillPartitions,
+                                          storageGlobalParams.dbpath + "/_tmp"));
+
+        LOG(1) << "hashed AND stage spilling to disk: " << _memUsage
+               << " bytes buffered exceeds limit of " << _maxMemUsage << " bytes";
+
+        // Move the hash table, which holds the merged results of the children consumed
+        // so far, into the accumulated spill files.  For entries the current child has
+        // already matched we persist the seen flag, so the intersection with the rest
+        // of that child's output doesn't forget them.
+        for (DataMap::iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+            WorkingSetMember* member = _ws->get(it->second);
+
+            AndHashSpiller::Record rec;
+            rec.loc = it->first;
+            rec.seen = (_currentChild > 0) && (_seenMap.end() != _seenMap.find(it->first));
+            rec.keys = member->keyData;
+            _spiller->addAccRecord(rec);
+
+            _ws->free(it->second);
+        }
+        _dataMap.clear();
+        _seenMap.clear();
+        _memUsage = 0;
+        _memTracker.set(0);
+
+        _specificStats.spilledToDisk = true;
+        _spillPhase = kSpillDrain;
+        _spillPartition = 0;
+    }
+
+    PlanStage::StageState AndHashStage::workSpilled(WorkingSetID* out) {
+        // First hand out any results produced by an already-intersected partition of
+        // the final child.
+        if (!_spillResults.empty()) {
+            *out = _spillResults.back();
+            _spillResults.pop_back();
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        if (kSpillDrain == _spillPhase) {
+            return spillDrainChild(out);
+        }
+        if (kSpillIntersect == _spillPhase) {
+            return spillIntersectPartition(out);
+        }
+
+        verify(kSpillDone == _spillPhase);
+        return PlanStage::IS_EOF;
+    }
+
+    PlanStage::StageState AndHashStage::spillDrainChild(WorkingSetID* out) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState childStatus = workChild(_currentChild, &id);
+
+        if (PlanStage::ADVANCED == childStatus) {
+            WorkingSetMember* member = _ws->get(id);
+
+            // Maybe the child had an invalidation.  We intersect DiskLoc(s) so we can't do
+            // anything with this WSM.
+            if (!member->hasLoc()) {
+                _ws->flagForReview(id);
+                return PlanStage::NEED_TIME;
+            }
+
+            AndHashSpiller::Record rec;
+            rec.loc = member->loc;
+            rec.keys = member->keyData;
+
+            // The first child builds the accumulated set; every other child is probe
+            // input for its own pass.
+            if (0 == _currentChild) {
+                _spiller->addAccRecord(rec);
+            }
+            else {
+                _spiller->addCurRecord(rec);
+            }
+
+            _ws->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::IS_EOF == childStatus) {
+            if (0 == _currentChild) {
+                // Build side is fully on disk; drain the next child as probe input.
+                _specificStats.mapAfterChild.push_back(_spiller->accRecords());
+                _currentChild = 1;
+            }
+            else {
+                // Probe input complete; intersect it with the accumulated set one
+                // partition at a time.
+                _spillPhase = kSpillIntersect;
+                _spillPartition = 0;
+            }
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::FAILURE == childStatus) {
+            *out = id;
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "spilled hashed AND stage failed to read in results from child "
+                   << _currentChild;
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+            return childStatus;
+        }
+        else {
+            if (PlanStage::NEED_TIME == childStatus) {
+                ++_commonStats.needTime;
+            }
+
+            return childStatus;
+        }
+    }
+
+    PlanStage::StageState AndHashStage::spillIntersectPartition(WorkingSetID* out) {
+        const bool finalChild = (_currentChild == _children.size() - 1);
+
+        std::vector<AndHashSpiller::Record> survivors;
+        _spiller->intersectPartition(_spillPartition, &survivors);
+
+        // Apply invalidations that arrived while these records sat on disk, then either
+        // write the partition back (more children to go) or turn it into results.
+        std::vector<AndHashSpiller::Record> kept;
+        kept.reserve(survivors.size());
+        for (size_t i = 0; i < survivors.size(); ++i) {
+            if (flagIfSpillInvalidated(survivors[i].loc)) { continue; }
+            kept.push_back(survivors[i]);
+        }
+
+        if (finalChild) {
+            for (size_t i = 0; i < kept.size(); ++i) {
+                WorkingSetID id = _ws->allocate();
+                WorkingSetMember* member = _ws->get(id);
+                member->loc = kept[i].loc;
+                member->keyData = kept[i].keys;
+                member->state = WorkingSetMember::LOC_AND_IDX;
+
+                // We check for matching at the end so the matcher can use information in
+                // the indices of all our children.
+                if (Filter::passes(member, _filter)) {
+                    _spillResults.push_back(id);
+                }
+                else {
+                    _ws->free(id);
+                }
+            }
+        }
+        else {
+            _spiller->rewriteAccPartition(_spillPartition, kept);
+        }
+
+        ++_spillPartition;
+        if (_spillPartition == _spiller->numPartitions()) {
+            _spiller->finishChildPass();
+
+            if (finalChild) {
+                _spillPhase = kSpillDone;
+            }
+            else {
+                _specificStats.mapAfterChild.push_back(_spiller->accRecords());
+
+                // If we have nothing to AND with after finishing any child, stop.
+                if (0 == _spiller->accRecords()) {
+                    _spillPhase = kSpillDone;
+                    return PlanStage::IS_EOF;
+                }
+
+                ++_currentChild;
+                _spillPhase = kSpillDrain;
+            }
+        }
+
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    bool AndHashStage::flagIfSpillInvalidated(const DiskLoc& loc) {
+        std::map<DiskLoc, BSONObj>::iterator it = _spillInvalidated.find(loc);
+        if (_spillInvalidated.end() == it) { return false; }
+
+        // Resurrect the document contents captured when the loc was invalidated, as
+        // fetchAndInvalidateLoc would have done had the record been in memory.
+        WorkingSetID id = _ws->allocate();
+        WorkingSetMember* member = _ws->get(id);
+        member->obj = it->second;
+        member->state = WorkingSetMember::OWNED_OBJ;
+        _ws->flagForReview(id);
+        _spillInvalidated.erase(it);
+
+        if (_currentChild == _children.size() - 1) {
+            ++_specificStats.flaggedButPassed;
+        }
+        else {
+            ++_specificStats.flaggedInProgress;
+        }
+        return true;
+    }
+
     void AndHashStage::prepareToYield() {
         ++_commonStats.yields;
 
@@ -470,6 +1012,30 @@ namespace mongo {
             }
         }
 
+        if (_spiller) {
+            // Results already extracted from partitions hold locs just as the data map
+            // does; fetch and flag a hit.
+            for (size_t i = 0; i < _spillResults.size(); ++i) {
+                WorkingSetMember* member = _ws->get(_spillResults[i]);
+                if (member->hasLoc() && member->loc == dl) {
+                    ++_specificStats.flaggedButPassed;
+                    WorkingSetCommon::fetchAndInvalidateLoc(member, _collection);
+                    _ws->flagForReview(_spillResults[i]);
+                    _spillResults.erase(_spillResults.begin() + i);
+                    break;
+                }
+            }
+
+            // Records in the spill files can't be searched, so we don't know whether
+            // 'dl' is buffered.  Capture the document now, while the loc still refers
+            // to it, and flag it if it ever surfaces from a partition.  Locs that were
+            // never ours just cost us one stashed object until the stage dies.
+            if (0 == _spillInvalidated.count(dl)) {
+                _spillInvalidated[dl] = _collection->docFor(dl).getOwned();
+            }
+            return;
+        }
+
         // If it's a deletion, we have to forget about the DiskLoc, and since the AND-ing is by
         // DiskLoc we can't continue processing it even with the object.
         //
@@ -512,6 +1078,9 @@ namespace mongo {
 
         _specificStats.memLimit = _maxMemUsage;
         _specificStats.memUsage = _memUsage;
+        if (_spiller) {
+            _specificStats.spilledRecords = _spiller->spilledRecords();
+        }
 
         // Add a BSON representation of the filter to the stats tree, if there is one.
         if (NULL != _filter) {
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <map>
 #include <vector>
 
 #include "mongo/db/diskloc.h"
@@ -36,9 +37,12 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/memory_account.h"
 
 namespace mongo {
 
+    class AndHashSpiller;
+
     /**
      * Reads from N children, each of which must have a valid DiskLoc.  Uses a hash table to
      * intersect the outputs of the N children, and outputs the intersection.
@@ -49,6 +53,14 @@ namespace mongo {
      * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
      * operates with DiskLocs, we are unable to evaluate the AND for the invalidated DiskLoc, and it
      * must be fully matched later.
+     *
+     * If the in-memory hash table outgrows its memory limit and spilling is enabled (see
+     * internalQueryHashIntersectionSpillToDisk), the stage switches to a Grace hash strategy:
+     * each child's (DiskLoc, index key) records are partitioned by DiskLoc hash to temporary
+     * files and the intersection is computed partition-by-partition, so the plan stays viable
+     * at any cardinality.  In spilled mode results are emitted in partition order rather than
+     * in the last child's order (no order was promised either way), and an invalidated DiskLoc
+     * is flagged with the document contents captured at invalidation time.
      */
     class AndHashStage : public PlanStage {
     public:
@@ -89,11 +101,37 @@ namespace mongo {
 
     private:
         static const size_t kLookAheadWorks;
+        static const size_t kSpillPartitions;
+
+        // Phases of the spilled (Grace hash) strategy.
+        enum SpillPhase {
+            // Draining the current child into the spill files.
+            kSpillDrain,
+
+            // Intersecting the accumulated partitions with the current child's
+            // partitions, one partition per work() call.
+            kSpillIntersect,
+
+            // All children consumed; remaining results are in _spillResults.
+            kSpillDone,
+        };
 
         StageState readFirstChild(WorkingSetID* out);
         StageState hashOtherChildren(WorkingSetID* out);
         StageState workChild(size_t childNo, WorkingSetID* out);
 
+        // Move the contents of _dataMap to spill files and switch to the Grace hash
+        // strategy.  Called when _memUsage exceeds _maxMemUsage.
+        void enterSpillMode();
+
+        StageState workSpilled(WorkingSetID* out);
+        StageState spillDrainChild(WorkingSetID* out);
+        StageState spillIntersectPartition(WorkingSetID* out);
+
+        // If 'loc' was invalidated while spilled, flag the document captured at
+        // invalidation time and return true (the record must be dropped).
+        bool flagIfSpillInvalidated(const DiskLoc& loc);
+
         // Not owned by us.
         const Collection* _collection;
 
@@ -139,6 +177,30 @@ namespace mongo {
         // Upper limit for buffered data memory usage.
         // Defaults to 32 MB (See kMaxBytes in and_hash.cpp).
         size_t _maxMemUsage;
+
+        // Mirrors _memUsage into the process-wide "andHash" MemoryAccount.
+        ScopedMemoryTracker _memTracker;
+
+        //
+        // Grace hash spilling.  All of the below is used only after enterSpillMode().
+        //
+
+        // Non-NULL iff we have spilled.  Owns the partitioned temporary files.
+        boost::scoped_ptr<AndHashSpiller> _spiller;
+
+        SpillPhase _spillPhase;
+
+        // Next partition to intersect while in kSpillIntersect.
+        size_t _spillPartition;
+
+        // Results of already-intersected partitions of the final child, waiting to be
+        // returned from work().
+        std::vector<WorkingSetID> _spillResults;
+
+        // DiskLocs invalidated while their records were unreachable in spill files,
+        // mapped to the document contents fetched at invalidation time.  When such a
+        // loc surfaces from a partition it is flagged for review and dropped.
+        std::map<DiskLoc, BSONObj> _spillInvalidated;
     };
 
 }  // namespace mongo
@@ -49,7 +49,11 @@ namespace mongo {
           _filter(filter),
           _params(params),
           _nsDropped(false),
-          _commonStats(kStageType) { }
+          _commonStats(kStageType) {
+        if (NULL != filter) {
+            _flatFilter.reset(FlatMatcher::compile(filter));
+        }
+    }
 
     PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
         ++_commonStats.works;
@@ -103,7 +107,7 @@ namespace mongo {
 
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _flatFilter.get())) {
             *out = id;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -32,6 +32,7 @@
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/flat_matcher.h"
 
 namespace mongo {
 
@@ -77,6 +78,9 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // Flattened form of _filter if it was eligible, NULL otherwise.
+        scoped_ptr<FlatMatcher> _flatFilter;
+
         scoped_ptr<RecordIterator> _iter;
 
         CollectionScanParams _params;
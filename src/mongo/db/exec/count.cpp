@@ -44,6 +44,8 @@ namespace mongo {
           _params(params),
           _hitEnd(false),
           _shouldDedup(params.descriptor->isMultikey()),
+          _pendingCount(0),
+          _pendingReturned(0),
           _commonStats(kStageType) {
         _specificStats.keyPattern = _params.descriptor->keyPattern();
         _specificStats.isMultiKey = _params.descriptor->isMultikey();
@@ -113,13 +115,23 @@ namespace mongo {
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
-        DiskLoc loc = _btreeCursor->getValue();
-        _btreeCursor->next();
-        checkEnd();
-
-        ++_specificStats.keysExamined;
+        if (_pendingCount > 0) {
+            // Drain keys tallied by an earlier bucket-counting pass.
+            --_pendingCount;
+            ++_pendingReturned;
+            ++_specificStats.keysExamined;
+            *out = WorkingSet::INVALID_ID;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
 
         if (_shouldDedup) {
+            DiskLoc loc = _btreeCursor->getValue();
+            _btreeCursor->next();
+            checkEnd();
+
+            ++_specificStats.keysExamined;
+
             if (_returned.end() != _returned.find(loc)) {
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -127,11 +139,33 @@ namespace mongo {
             else {
                 _returned.insert(loc);
             }
+
+            *out = WorkingSet::INVALID_ID;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        // No dedup to do, so we never need to look at an individual key: let the cursor
+        // tally whole leaf buckets' worth of keys toward the end position in one shot.
+        // Remember where the batch starts in case a yield makes us rewind to the first
+        // key we haven't handed back.
+        _pendingStartKey = _btreeCursor->getKey().getOwned();
+        _pendingStartLoc = _btreeCursor->getValue();
+        _pendingReturned = 0;
+        _pendingCount = _btreeCursor->countAndAdvance(*_endCursor.get());
+        checkEnd();
+
+        if (_pendingCount > 0) {
+            --_pendingCount;
+            ++_pendingReturned;
+            ++_specificStats.keysExamined;
+            *out = WorkingSet::INVALID_ID;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
         }
 
-        *out = WorkingSet::INVALID_ID;
-        ++_commonStats.advanced;
-        return PlanStage::ADVANCED;
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
     }
 
     bool Count::isEOF() {
@@ -140,12 +174,36 @@ namespace mongo {
             return false;
         }
 
+        if (_pendingCount > 0) {
+            // Counted but not yet returned.
+            return false;
+        }
+
         return _hitEnd || _btreeCursor->isEOF();
     }
 
+    void Count::rewindPendingCount() {
+        // Reposition at the start of the tallied batch, then step over the keys we've
+        // already returned.  The remainder of the batch is re-tallied after the yield,
+        // against whatever the tree looks like by then.
+        _btreeCursor->seekExact(_pendingStartKey, _pendingStartLoc);
+        for (long long i = 0; i < _pendingReturned; i++) {
+            _btreeCursor->next();
+        }
+        _pendingCount = 0;
+        _hitEnd = false;
+        checkEnd();
+    }
+
     void Count::prepareToYield() {
         ++_commonStats.yields;
-        if (_hitEnd || (NULL == _btreeCursor.get())) { return; }
+        if (NULL == _btreeCursor.get()) { return; }
+
+        if (_pendingCount > 0) {
+            rewindPendingCount();
+        }
+
+        if (_hitEnd) { return; }
 
         _btreeCursor->savePosition();
         _endCursor->savePosition();
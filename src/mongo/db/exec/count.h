@@ -95,6 +95,13 @@ namespace mongo {
          */
         void checkEnd();
 
+        /**
+         * Discard keys tallied ahead by the bucket-counting fast path and reposition
+         * _btreeCursor at the first key we haven't returned yet, so that yields observe
+         * the same cursor position the one-key-at-a-time path would have.
+         */
+        void rewindPendingCount();
+
         // The WorkingSet we annotate with results.  Not owned by us.
         WorkingSet* _workingSet;
 
@@ -117,6 +124,17 @@ namespace mongo {
 
         bool _shouldDedup;
 
+        // Keys already tallied by the cursor's bucket-at-a-time counting fast path but not
+        // yet returned as ADVANCED.  Only non-zero when we don't have to dedup, and always
+        // zero across yields (see rewindPendingCount()).
+        long long _pendingCount;
+
+        // Where the current tallied batch began and how much of it we've returned, so
+        // rewindPendingCount() can reposition the cursor.
+        BSONObj _pendingStartKey;
+        DiskLoc _pendingStartLoc;
+        long long _pendingReturned;
+
         CommonStats _commonStats;
         CountStats _specificStats;
     };
@@ -0,0 +1,215 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/disk_loc_dedup.h"
+
+#include <algorithm>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+
+        // At roughly 32 bytes per hash set entry this caps the exact tier near
+        // 32MB; everything beyond it costs 8 bytes of disk plus ~10 bits of
+        // bloom filter per location.
+        const size_t kMaxMemoryEntries = 1024 * 1024;
+
+        // ~10 bits and 4 probes per spilled entry keep the false positive rate
+        // (and thus the rate of wasted binary searches) near 1%.
+        const size_t kBloomBitsPerEntry = 10;
+        const size_t kBloomProbes = 4;
+
+        AtomicUInt32 dedupFileCounter;
+
+        // 64-bit finalizer mix over the packed (file, offset) pair; DiskLoc's
+        // own hasher only feeds a 32-bit size_t on some platforms and we want
+        // independent bloom probes.
+        unsigned long long hashLoc(const DiskLoc& loc) {
+            unsigned long long h =
+                (static_cast<unsigned long long>(static_cast<unsigned>(loc.a())) << 32)
+                | static_cast<unsigned>(loc.getOfs());
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // The i'th probe's bit index, via double hashing.
+        inline unsigned long long bloomBit(unsigned long long h, size_t i,
+                                           unsigned long long nBits) {
+            const unsigned long long h2 = (h * 0x9e3779b97f4a7c15ULL) | 1;
+            return (h + i * h2) % nBits;
+        }
+    }  // namespace
+
+    DiskLocDedup::DiskLocDedup() : _spilledBytes(0) { }
+
+    DiskLocDedup::~DiskLocDedup() {
+        if (!_fileName.empty()) {
+            _file.reset(); // close before unlinking (Windows)
+            try {
+                boost::filesystem::remove(_fileName);
+            }
+            catch (const std::exception& e) {
+                warning() << "error removing dedup spill file " << _fileName
+                          << ": " << e.what();
+            }
+        }
+    }
+
+    bool DiskLocDedup::contains(const DiskLoc& loc) {
+        if (_returned.end() != _returned.find(loc)) {
+            return true;
+        }
+        if (_runs.empty()) {
+            return false;
+        }
+        if (_removed.end() != _removed.find(loc)) {
+            return false;
+        }
+        return _inSpilledRuns(loc);
+    }
+
+    void DiskLocDedup::insert(const DiskLoc& loc) {
+        unordered_set<DiskLoc, DiskLoc::Hasher>::iterator it = _removed.find(loc);
+        if (it != _removed.end()) {
+            // The spilled copy becomes visible again.
+            _removed.erase(it);
+            return;
+        }
+        _returned.insert(loc);
+        if (_returned.size() >= kMaxMemoryEntries) {
+            _spill();
+        }
+    }
+
+    bool DiskLocDedup::remove(const DiskLoc& loc) {
+        bool present = _returned.erase(loc) > 0;
+        if (!_runs.empty()
+                && _removed.end() == _removed.find(loc)
+                && _inSpilledRuns(loc)) {
+            _removed.insert(loc);
+            present = true;
+        }
+        return present;
+    }
+
+    void DiskLocDedup::_spill() {
+        std::vector<DiskLoc> locs(_returned.begin(), _returned.end());
+        std::sort(locs.begin(), locs.end());
+        _returned.clear();
+
+        if (!_file) {
+            std::string dir = storageGlobalParams.dbpath + "/_tmp";
+            boost::filesystem::create_directories(dir);
+            _fileName = str::stream() << dir << "/dedup."
+                                      << dedupFileCounter.fetchAndAdd(1);
+            _file.reset(new File());
+            _file->open(_fileName.c_str());
+            massert(18553,
+                    str::stream() << "couldn't open temp file " << _fileName,
+                    !_file->bad());
+        }
+
+        _runs.push_back(SpilledRun());
+        SpilledRun& run = _runs.back();
+        run.offset = _spilledBytes;
+        run.count = locs.size();
+        run.bloom.assign((locs.size() * kBloomBitsPerEntry + 63) / 64, 0);
+        const unsigned long long nBits = run.bloom.size() * 64;
+        for (size_t i = 0; i < locs.size(); i++) {
+            const unsigned long long h = hashLoc(locs[i]);
+            for (size_t p = 0; p < kBloomProbes; p++) {
+                const unsigned long long bit = bloomBit(h, p, nBits);
+                run.bloom[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+
+        _file->write(_spilledBytes,
+                     reinterpret_cast<const char*>(&locs[0]),
+                     locs.size() * sizeof(DiskLoc));
+        massert(18554,
+                str::stream() << "error writing to temp file " << _fileName,
+                !_file->bad());
+        _spilledBytes += locs.size() * sizeof(DiskLoc);
+    }
+
+    bool DiskLocDedup::_inSpilledRuns(const DiskLoc& loc) {
+        const unsigned long long h = hashLoc(loc);
+        for (size_t r = 0; r < _runs.size(); r++) {
+            const SpilledRun& run = _runs[r];
+
+            const unsigned long long nBits = run.bloom.size() * 64;
+            bool mayContain = true;
+            for (size_t p = 0; p < kBloomProbes; p++) {
+                const unsigned long long bit = bloomBit(h, p, nBits);
+                if (!(run.bloom[bit / 64] & (1ULL << (bit % 64)))) {
+                    mayContain = false;
+                    break;
+                }
+            }
+            if (!mayContain) {
+                continue;
+            }
+
+            // Binary search over the run's sorted fixed-width records; at most
+            // log2(count) 8-byte reads, typically served from the page cache.
+            size_t lo = 0;
+            size_t hi = run.count;
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                DiskLoc probe;
+                _file->read(run.offset + mid * sizeof(DiskLoc),
+                            reinterpret_cast<char*>(&probe),
+                            sizeof(DiskLoc));
+                const int cmp = probe.compare(loc);
+                if (0 == cmp) {
+                    return true;
+                }
+                else if (cmp < 0) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+        }
+        return false;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,105 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/platform/unordered_set.h"
+#include "mongo/util/file.h"
+
+namespace mongo {
+
+    /**
+     * A set of DiskLocs whose memory footprint stays bounded no matter how many
+     * locations it holds.  Intended for stages that dedup multikey index
+     * results, where the naive hash set grows with the number of distinct
+     * documents returned.
+     *
+     * Membership answers are always exact.  Up to a fixed entry budget the
+     * locations live in an ordinary hash set.  When the budget is reached the
+     * set is sorted and appended to a temp file as an immutable fixed-width
+     * run, and the in-memory set starts over.  Each run carries a bloom filter
+     * so that the common case -- a location we have never seen -- usually
+     * costs no I/O; a bloom hit falls through to a binary search over the
+     * run's records.  Removals of spilled locations are tracked in a
+     * (typically tiny) exception set, since the runs themselves cannot change.
+     *
+     * The temp file lives under dbpath/_tmp and is deleted on destruction.
+     */
+    class DiskLocDedup {
+        MONGO_DISALLOW_COPYING(DiskLocDedup);
+    public:
+        DiskLocDedup();
+        ~DiskLocDedup();
+
+        /** Is 'loc' in the set?  May read the spill file; never wrong. */
+        bool contains(const DiskLoc& loc);
+
+        /** Add 'loc' to the set, spilling to disk if the memory budget is hit. */
+        void insert(const DiskLoc& loc);
+
+        /**
+         * Remove 'loc' from the set.  Returns whether it was present.  Spilled
+         * locations are removed logically, via the exception set.
+         */
+        bool remove(const DiskLoc& loc);
+
+    private:
+        struct SpilledRun {
+            fileofs offset; // byte offset of the run's first record in _file
+            size_t count;   // number of sorted fixed-width DiskLoc records
+
+            // ~10 bits per record; consulted before any read of the run
+            std::vector<unsigned long long> bloom;
+        };
+
+        /** Sort the in-memory set into a new run on disk and clear it. */
+        void _spill();
+
+        /** Is 'loc' in any spilled run?  Ignores the exception set. */
+        bool _inSpilledRuns(const DiskLoc& loc);
+
+        // The exact in-memory tier.
+        unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
+
+        // Locations that are in a spilled run but have since been removed.
+        unordered_set<DiskLoc, DiskLoc::Hasher> _removed;
+
+        std::vector<SpilledRun> _runs;
+        std::string _fileName;          // empty until the first spill
+        boost::scoped_ptr<File> _file;  // NULL until the first spill
+        fileofs _spilledBytes;
+    };
+
+}  // namespace mongo
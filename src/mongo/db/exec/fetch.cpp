@@ -28,9 +28,12 @@
 
 #include "mongo/db/exec/fetch.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -39,19 +42,34 @@ namespace mongo {
     // static
     const char* FetchStage::kStageType = "FETCH";
 
+    namespace {
+
+        bool locLessThan(const std::pair<DiskLoc, WorkingSetID>& lhs,
+                         const std::pair<DiskLoc, WorkingSetID>& rhs) {
+            return lhs.first < rhs.first;
+        }
+
+    }  // namespace
+
     FetchStage::FetchStage(WorkingSet* ws,
                            PlanStage* child,
                            const MatchExpression* filter,
-                           const Collection* collection)
+                           const Collection* collection,
+                           bool reorderDocs)
         : _collection(collection),
           _ws(ws),
           _child(child),
           _filter(filter),
+          _reorderDocs(reorderDocs && internalQueryFetchReorderMaxDocs > 0),
+          _reorderPos(0),
+          _draining(false),
           _commonStats(kStageType) { }
 
     FetchStage::~FetchStage() { }
 
     bool FetchStage::isEOF() {
+        // Buffered results haven't been returned yet.
+        if (!_reorderBuffer.empty()) { return false; }
         return _child->isEOF();
     }
 
@@ -63,32 +81,86 @@ namespace mongo {
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
+        if (_reorderDocs) { return workReorder(out); }
+
         // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another to-be-fetched
         // result from our child.
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
 
+        if (PlanStage::ADVANCED == status) {
+            return fetchAndReturn(_ws->get(id), id, out);
+        }
+        else if (PlanStage::FAILURE == status) {
+            *out = id;
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "fetch stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+            return status;
+        }
+        else {
+            if (PlanStage::NEED_TIME == status) {
+                ++_commonStats.needTime;
+            }
+            return status;
+        }
+    }
+
+    PlanStage::StageState FetchStage::workReorder(WorkingSetID* out) {
+        if (_draining) {
+            // Return the buffered results, one per call, in DiskLoc order.
+            WorkingSetID id = _reorderBuffer[_reorderPos].second;
+            ++_reorderPos;
+            if (_reorderPos == _reorderBuffer.size()) {
+                _reorderBuffer.clear();
+                _reorderPos = 0;
+                _draining = false;
+            }
+            return fetchAndReturn(_ws->get(id), id, out);
+        }
+
+        // We're filling the buffer.
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->work(&id);
+
         if (PlanStage::ADVANCED == status) {
             WorkingSetMember* member = _ws->get(id);
 
-            // If there's an obj there, there is no fetching to perform.
+            // Results that already carry an object have nothing to defer; hand them
+            // through immediately.
             if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
+                return fetchAndReturn(member, id, out);
             }
-            else {
-                // We need a valid loc to fetch from and this is the only state that has one.
-                verify(WorkingSetMember::LOC_AND_IDX == member->state);
-                verify(member->hasLoc());
-
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = _collection->docFor(member->loc);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            _reorderBuffer.push_back(std::make_pair(member->loc, id));
+            if (_reorderBuffer.size() >=
+                static_cast<size_t>(internalQueryFetchReorderMaxDocs)) {
+                std::sort(_reorderBuffer.begin(), _reorderBuffer.end(), locLessThan);
+                _draining = true;
             }
 
-            ++_specificStats.docsExamined;
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::IS_EOF == status) {
+            if (_reorderBuffer.empty()) { return PlanStage::IS_EOF; }
+
+            // The child is exhausted; drain what we have.
+            std::sort(_reorderBuffer.begin(), _reorderBuffer.end(), locLessThan);
+            _draining = true;
 
-            return returnIfMatches(member, id, out);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
         }
         else if (PlanStage::FAILURE == status) {
             *out = id;
@@ -111,6 +183,29 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState FetchStage::fetchAndReturn(WorkingSetMember* member,
+                                                     WorkingSetID memberID,
+                                                     WorkingSetID* out) {
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        }
+        else {
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = _collection->docFor(member->loc);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        }
+
+        ++_specificStats.docsExamined;
+
+        return returnIfMatches(member, memberID, out);
+    }
+
     void FetchStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -125,6 +220,21 @@ namespace mongo {
         ++_commonStats.invalidates;
 
         _child->invalidate(dl, type);
+
+        // If we're buffering locs for a DiskLoc-ordered fetch, one of them may be going
+        // away.  As the sort stage does, fetch the doc now and keep it in play; the
+        // member then has an owned obj and the drain path skips the fetch.  The buffer
+        // entries themselves stay put -- the member is at the same spot in the working
+        // set, and a stale loc in the sort order is harmless.  Entries before _reorderPos
+        // were already returned; their members are no longer ours.
+        for (size_t i = _reorderPos; i < _reorderBuffer.size(); ++i) {
+            if (dl == _reorderBuffer[i].first) {
+                WorkingSetMember* member = _ws->get(_reorderBuffer[i].second);
+                verify(member->loc == dl);
+                WorkingSetCommon::fetchAndInvalidateLoc(member, _collection);
+                ++_specificStats.forcedFetches;
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
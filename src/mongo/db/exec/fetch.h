@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -41,14 +44,21 @@ namespace mongo {
      * In WorkingSetMember terms, it transitions from LOC_AND_IDX to LOC_AND_UNOWNED_OBJ by reading
      * the record at the provided loc.  Returns verbatim any data that already has an object.
      *
+     * When 'reorderDocs' is set, the stage instead buffers up to
+     * internalQueryFetchReorderMaxDocs locs from its child, sorts them by DiskLoc, and
+     * fetches the documents in physical order so cold-cache reads walk the data files
+     * sequentially.  Output order is then DiskLoc order; the planner only sets the flag
+     * when that's acceptable.
+     *
      * Preconditions: Valid DiskLoc.
      */
     class FetchStage : public PlanStage {
     public:
-        FetchStage(WorkingSet* ws, 
-                    PlanStage* child, 
-                    const MatchExpression* filter, 
-                    const Collection* collection);
+        FetchStage(WorkingSet* ws,
+                    PlanStage* child,
+                    const MatchExpression* filter,
+                    const Collection* collection,
+                    bool reorderDocs = false);
 
         virtual ~FetchStage();
 
@@ -76,6 +86,20 @@ namespace mongo {
         StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * work(...) delegates here when we're reordering.  Either buffers one result from
+         * our child or, once the buffer is full or the child is exhausted, fetches and
+         * returns the buffered results in DiskLoc order.
+         */
+        StageState workReorder(WorkingSetID* out);
+
+        /**
+         * Fetch the record at member's loc unless something (an invalidation, a covered
+         * child) already gave it an object, then hand it to returnIfMatches.
+         */
+        StageState fetchAndReturn(WorkingSetMember* member, WorkingSetID memberID,
+                                  WorkingSetID* out);
+
         // Collection which is used by this stage. Used to resolve record ids retrieved by child
         // stages. The lifetime of the collection must supersede that of the stage.
         const Collection* _collection;
@@ -87,6 +111,20 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // Do we buffer locs and fetch in DiskLoc order?  Set only when the planner has
+        // determined that our output order doesn't matter.
+        bool _reorderDocs;
+
+        // Locs buffered for a DiskLoc-ordered fetch pass, paired with the ids of their
+        // members in _ws.  Sorted by loc once we start draining.
+        std::vector< std::pair<DiskLoc, WorkingSetID> > _reorderBuffer;
+
+        // Next entry of _reorderBuffer to fetch and return.  Only valid while draining.
+        size_t _reorderPos;
+
+        // Are we draining _reorderBuffer (as opposed to filling it)?
+        bool _draining;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
@@ -29,6 +29,7 @@
 #pragma once
 
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/flat_matcher.h"
 #include "mongo/db/matcher/matchable.h"
 
 namespace mongo {
@@ -158,6 +159,19 @@ namespace mongo {
             return filter->matches(&doc, NULL);
         }
 
+        /**
+         * As above, but runs the precompiled flat form of the filter when one exists and the
+         * member carries the full document.  'flat' may be NULL (filter didn't compile).
+         */
+        static bool passes(WorkingSetMember* wsm,
+                           const MatchExpression* filter,
+                           const FlatMatcher* flat) {
+            if (NULL == filter) { return true; }
+            if (NULL != flat && wsm->hasObj()) { return flat->matches(wsm->obj); }
+            WorkingSetMatchableDocument doc(wsm);
+            return filter->matches(&doc, NULL);
+        }
+
         static bool passes(const BSONObj& keyData,
                            const BSONObj& keyPattern,
                            const MatchExpression* filter) {
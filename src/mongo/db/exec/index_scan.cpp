@@ -44,6 +44,23 @@ namespace {
         return i > 0 ? 1 : -1;
     }
 
+    // True if each field's bounds consist of exactly one point interval, which
+    // guarantees at most one distinct key in range (and thus one visit) per
+    // document.  A field with several point intervals (e.g. $in) does not
+    // qualify: an array document can match through more than one of them.
+    bool boundsVisitDocumentsOnce(const mongo::IndexBounds& bounds) {
+        if (bounds.isSimpleRange || bounds.fields.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i < bounds.fields.size(); ++i) {
+            const mongo::OrderedIntervalList& oil = bounds.fields[i];
+            if (1 != oil.intervals.size() || !oil.intervals[0].isPoint()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
 }  // namespace
 
 namespace mongo {
@@ -72,6 +89,14 @@ namespace mongo {
         }
         else {
             _shouldDedup = _params.descriptor->isMultikey();
+
+            // Even a multikey index visits each document at most once when every
+            // field's bounds are a single point interval: the keys generated for
+            // one document are deduped before insertion, so one distinct key in
+            // range means one visit per document.
+            if (_shouldDedup && boundsVisitDocumentsOnce(_params.bounds)) {
+                _shouldDedup = false;
+            }
         }
 
         // We can't always access the descriptor in the call to getStats() so we pull
@@ -160,7 +185,7 @@ namespace mongo {
 
         if (_shouldDedup) {
             ++_specificStats.dupsTested;
-            if (_returned.end() != _returned.find(loc)) {
+            if (_returned.contains(loc)) {
                 ++_specificStats.dupsDropped;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -264,10 +289,8 @@ namespace mongo {
 
         // If we see this DiskLoc again, it may not be the same document it was before, so we want
         // to return it if we see it again.
-        unordered_set<DiskLoc, DiskLoc::Hasher>::iterator it = _returned.find(dl);
-        if (it != _returned.end()) {
+        if (_returned.remove(dl)) {
             ++_specificStats.seenInvalidated;
-            _returned.erase(it);
         }
     }
 
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include "mongo/db/exec/disk_loc_dedup.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/index/btree_index_cursor.h"
@@ -126,7 +127,7 @@ namespace mongo {
 
         // Could our index have duplicates?  If so, we use _returned to dedup.
         bool _shouldDedup;
-        unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
+        DiskLocDedup _returned;
 
         // For yielding.
         BSONObj _savedKey;
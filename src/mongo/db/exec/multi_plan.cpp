@@ -28,7 +28,9 @@
 
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 
 #include <algorithm>
 
@@ -36,7 +38,9 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/query/explain_plan.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/qlog.h"
@@ -155,7 +159,104 @@ namespace mongo {
         return state;
     }
 
+    namespace {
+
+        void gatherLeafNodes(const QuerySolutionNode* node,
+                             std::vector<const QuerySolutionNode*>* leaves) {
+            if (node->children.empty()) {
+                leaves->push_back(node);
+                return;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                gatherLeafNodes(node->children[i], leaves);
+            }
+        }
+
+        /**
+         * Estimates what fraction of some index's keys a candidate plan would scan, or -1
+         * when no estimate is possible.  Only plans that read exactly one forward index
+         * interval are estimable; everything else (collscans, index intersection, complex
+         * bounds) reports -1 and is never pruned on the basis of an estimate.
+         */
+        double estimateKeysInBoundsFraction(const Collection* collection,
+                                            const CandidatePlan& candidate) {
+            std::vector<const QuerySolutionNode*> leaves;
+            gatherLeafNodes(candidate.solution->root.get(), &leaves);
+            if (1 != leaves.size() || STAGE_IXSCAN != leaves[0]->getType()) {
+                return -1;
+            }
+
+            const IndexScanNode* scan = static_cast<const IndexScanNode*>(leaves[0]);
+            if (1 != scan->direction) {
+                // Reversed scans carry reversed bounds; not worth handling here.
+                return -1;
+            }
+
+            BSONObj startKey;
+            BSONObj endKey;
+            bool startKeyInclusive;
+            bool endKeyInclusive;
+            if (!IndexBoundsBuilder::isSingleInterval(scan->bounds,
+                                                      &startKey,
+                                                      &startKeyInclusive,
+                                                      &endKey,
+                                                      &endKeyInclusive)) {
+                return -1;
+            }
+
+            const IndexDescriptor* desc =
+                collection->getIndexCatalog()->findIndexByKeyPattern(scan->indexKeyPattern);
+            if (NULL == desc) {
+                return -1;
+            }
+
+            return collection->getIndexCatalog()->getIndex(desc)->estimateRangeFraction(startKey,
+                                                                                        endKey);
+        }
+
+    }  // namespace
+
     void MultiPlanStage::pickBestPlan() {
+        // Cheap pre-ranking: when candidates boil down to single indexed intervals, a
+        // btree range-size estimate (O(depth) per edge, no scan) can discard plans that
+        // would visit orders of magnitude more keys than the best candidate, before any
+        // of the trial-execution budget is spent on them.
+        if (internalQueryPlanEvaluationPruneRatio > 0
+            && _candidates.size() > 1
+            && NULL != _collection) {
+
+            std::vector<double> fractions(_candidates.size(), -1);
+            double bestFraction = -1;
+            for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+                fractions[ix] = estimateKeysInBoundsFraction(_collection, _candidates[ix]);
+                if (fractions[ix] >= 0 && (bestFraction < 0 || fractions[ix] < bestFraction)) {
+                    bestFraction = fractions[ix];
+                }
+            }
+
+            if (bestFraction >= 0) {
+                // Floor the baseline so a near-empty best estimate can't prune merely
+                // average plans; estimates are only good to within a small factor.
+                const double threshold = std::max(bestFraction, 0.0001)
+                    * internalQueryPlanEvaluationPruneRatio;
+
+                size_t kept = 0;
+                for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+                    if (fractions[ix] > threshold) {
+                        QLOG() << "Pruning plan before trial period: estimated fraction of"
+                               << " index in bounds " << fractions[ix] << " vs best "
+                               << bestFraction << "\n"
+                               << _candidates[ix].solution->toString();
+                        delete _candidates[ix].solution;
+                        delete _candidates[ix].root;
+                        continue;
+                    }
+                    _candidates[kept++] = _candidates[ix];
+                }
+                _candidates.erase(_candidates.begin() + kept, _candidates.end());
+            }
+        }
+
         // Run each plan some number of times. This number is at least as great as
         // 'internalQueryPlanEvaluationWorks', but may be larger for big collections.
         size_t numWorks = internalQueryPlanEvaluationWorks;
@@ -183,9 +284,24 @@ namespace mongo {
 
         // Work the plans, stopping when a plan hits EOF or returns some
         // fixed number of results.
+        //
+        // The trial is also bounded by wall-clock time. It runs inside the triggering
+        // query, so an unbounded trial makes the first query after a plan cache flush
+        // pay for the full tournament even when every candidate is slow. When the
+        // budget runs out we rank on whatever the candidates have produced so far.
+        Timer evalTimer;
         for (size_t ix = 0; ix < numWorks; ++ix) {
             bool moreToDo = workAllPlans(numResults);
             if (!moreToDo) { break; }
+
+            // Checking the clock on every work() would be wasteful; every 64th is
+            // fine-grained enough against a budget measured in milliseconds.
+            if (0x3F == (ix & 0x3F) && evalTimer.millis() >= internalQueryPlanEvaluationMaxMillis) {
+                QLOG() << "Plan evaluation hit time budget of "
+                       << internalQueryPlanEvaluationMaxMillis
+                       << "ms, ranking on partial results\n";
+                break;
+            }
         }
 
         if (_failure) { return; }
@@ -55,37 +55,45 @@ namespace mongo {
     };
 
     // Every stage has CommonStats.
+    //
+    // The fields touched by every work() call (works, advanced, needTime,
+    // executionTimeMillis) are grouped at the front of the struct so the hot updates
+    // land on one cache line instead of straddling the BSONObj in the middle; these
+    // counters also feed plan ranking (see PlanRanker), so they are maintained
+    // whether or not anyone will explain the query.
     struct CommonStats {
         CommonStats(const char* type)
-                      : stageTypeStr(type),
-                        works(0),
-                        yields(0),
-                        unyields(0),
-                        invalidates(0),
+                      : works(0),
                         advanced(0),
                         needTime(0),
                         executionTimeMillis(0),
+                        stageTypeStr(type),
+                        yields(0),
+                        unyields(0),
+                        invalidates(0),
                         isEOF(false) { }
-        // String giving the type of the stage. Not owned.
-        const char* stageTypeStr;
 
         // Count calls into the stage.
         size_t works;
-        size_t yields;
-        size_t unyields;
-        size_t invalidates;
 
         // How many times was this state the return value of work(...)?
         size_t advanced;
         size_t needTime;
 
+        // Time elapsed while working inside this stage.
+        long long executionTimeMillis;
+
+        // String giving the type of the stage. Not owned.
+        const char* stageTypeStr;
+
+        size_t yields;
+        size_t unyields;
+        size_t invalidates;
+
         // BSON representation of a MatchExpression affixed to this node. If there
         // is no filter affixed, then 'filter' should be an empty BSONObj.
         BSONObj filter;
 
-        // Time elapsed while working inside this stage.
-        long long executionTimeMillis;
-
         // TODO: have some way of tracking WSM sizes (or really any series of #s).  We can measure
         // the size of our inputs and the size of our outputs.  We can do a lot with the WS here.
 
@@ -101,15 +109,20 @@ namespace mongo {
     /**
      * This class increments a counter by the time elapsed since its construction when
      * it goes out of scope.
+     *
+     * Reads the coarse cached clock (curTimeMillis64Fast): every work() call of every
+     * stage constructs one of these, and with the cached clock the cost is two atomic
+     * loads instead of two clock syscalls.  The counter is reported in milliseconds,
+     * which is exactly the granularity the cached clock provides.
      */
     class ScopedTimer {
     public:
         ScopedTimer(long long* counter) : _counter(counter) {
-            _start = curTimeMillis64();
+            _start = curTimeMillis64Fast();
         }
 
         ~ScopedTimer() {
-            long long elapsed = curTimeMillis64() - _start;
+            long long elapsed = curTimeMillis64Fast() - _start;
             *_counter += elapsed;
         }
 
@@ -171,7 +184,9 @@ namespace mongo {
         AndHashStats() : flaggedButPassed(0),
                          flaggedInProgress(0),
                          memUsage(0),
-                         memLimit(0) { }
+                         memLimit(0),
+                         spilledToDisk(false),
+                         spilledRecords(0) { }
 
         virtual ~AndHashStats() { }
 
@@ -200,6 +215,12 @@ namespace mongo {
 
         // What's our memory limit?
         size_t memLimit;
+
+        // Did we exceed the memory limit and fall back to Grace hash spill files?
+        bool spilledToDisk;
+
+        // How many records have we written to spill files?
+        size_t spilledRecords;
     };
 
     struct AndSortedStats : public SpecificStats {
@@ -149,8 +149,6 @@ namespace mongo {
             return _exec->transform(member);
         }
 
-        BSONObjBuilder bob;
-
         // Note that even if our fast path analysis is bug-free something that is
         // covered might be invalidated and just be an obj.  In this case we just go
         // through the SIMPLE_DOC path which is still correct if the covered data
@@ -162,31 +160,49 @@ namespace mongo {
             invariant(member->hasObj());
 
             // Apply the SIMPLE_DOC projection.
+            BSONObjBuilder bob;
             transformSimpleInclusion(member->obj, _includedFields, bob);
+
+            member->state = WorkingSetMember::OWNED_OBJ;
+            member->keyData.clear();
+            member->loc = DiskLoc();
+            member->obj = bob.obj();
+            return Status::OK();
         }
-        else {
-            invariant(ProjectionStageParams::COVERED_ONE_INDEX == _projImpl);
-            // We're pulling data out of the key.
-            invariant(1 == member->keyData.size());
-            size_t keyIndex = 0;
-
-            // Look at every key element...
-            BSONObjIterator keyIterator(member->keyData[0].keyData);
-            while (keyIterator.more()) {
-                BSONElement elt = keyIterator.next();
-                // If we're supposed to include it...
-                if (_includeKey[keyIndex]) {
-                    // Do so.
-                    bob.appendAs(elt, _keyFieldNames[keyIndex]);
-                }
-                ++keyIndex;
+
+        invariant(ProjectionStageParams::COVERED_ONE_INDEX == _projImpl);
+        // We're pulling data out of the key.  Assemble the result directly: the value
+        // bytes are copied straight out of the key elements and only the field names are
+        // rewritten (index keys don't carry usable ones).  The buffer is reused across
+        // documents, so in steady state the only allocation is the final owned copy.
+        invariant(1 == member->keyData.size());
+        size_t keyIndex = 0;
+
+        BufBuilder& bb = _coveredBuilder;
+        bb.reset();
+        bb.skip(sizeof(int)); // total size; filled in below
+
+        // Look at every key element...
+        BSONObjIterator keyIterator(member->keyData[0].keyData);
+        while (keyIterator.more()) {
+            BSONElement elt = keyIterator.next();
+            // If we're supposed to include it...
+            if (_includeKey[keyIndex]) {
+                // Do so.
+                bb.appendChar(elt.type());
+                bb.appendStr(_keyFieldNames[keyIndex], /*includeEndingNull*/true);
+                bb.appendBuf(elt.value(), elt.valuesize());
             }
+            ++keyIndex;
         }
 
+        bb.appendChar(EOO);
+        *reinterpret_cast<int*>(bb.buf()) = bb.len();
+
         member->state = WorkingSetMember::OWNED_OBJ;
         member->keyData.clear();
         member->loc = DiskLoc();
-        member->obj = bob.obj();
+        member->obj = BSONObj(bb.buf()).getOwned();
         return Status::OK();
     }
 
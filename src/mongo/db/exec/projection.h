@@ -149,6 +149,9 @@ namespace mongo {
 
         // If the i-th entry of _includeKey is true this is the field name for the i-th key field.
         std::vector<StringData> _keyFieldNames;
+
+        // Scratch buffer the covered path assembles results in, reused across documents.
+        BufBuilder _coveredBuilder;
     };
 
 }  // namespace mongo
@@ -36,10 +36,52 @@
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/geo/geoconstants.h"
 #include "mongo/db/index/expression_index.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "third_party/s2/s2regionintersection.h"
 
 namespace mongo {
 
+    namespace {
+
+        // Process-wide cache of annulus coverings.  Query centers cluster heavily in many
+        // near workloads, and a $near search with the same (center, radii) inputs computes
+        // exactly the same covering every time, so the index bounds built for one query are
+        // frequently rebuilt verbatim by the next.  Keyed on the exact covering inputs: a
+        // bucketed key could hand back a covering for a slightly different annulus, and a
+        // covering that doesn't cover means missed results.
+        const size_t kCoveringCacheSize = 256;
+
+        SimpleMutex coveringCacheLock("s2CoveringCache");
+        LRUKeyValue<string, OrderedIntervalList>& coveringCache() {
+            static LRUKeyValue<string, OrderedIntervalList> cache(kCoveringCacheSize);
+            return cache;
+        }
+
+        string coveringCacheKey(const S2Point& center,
+                                double innerRadius,
+                                double outerRadius,
+                                const BSONObj& indexInfoObj) {
+            double vals[5];
+            vals[0] = center.x();
+            vals[1] = center.y();
+            vals[2] = center.z();
+            vals[3] = innerRadius;
+            vals[4] = outerRadius;
+            string key(reinterpret_cast<const char*>(vals), sizeof(vals));
+
+            // The covering depends on the index's coarsest level too.
+            int coarsest = -1;
+            BSONElement ce = indexInfoObj["coarsestIndexedLevel"];
+            if (ce.isNumber()) {
+                coarsest = ce.numberInt();
+            }
+            key.append(reinterpret_cast<const char*>(&coarsest), sizeof(coarsest));
+            return key;
+        }
+
+    }  // namespace
+
     // static
     const char* S2NearStage::kStageType = "GEO_NEAR_2DSPHERE";
 
@@ -265,10 +307,31 @@ namespace mongo {
 
         IndexScanParams params;
         params.descriptor = _descriptor;
-        _params.baseBounds.fields[_nearFieldIndex].intervals.clear();
-        ExpressionMapping::cover2dsphere(_annulus,
-                                         params.descriptor->infoObj(),
-                                         &_params.baseBounds.fields[_nearFieldIndex]);
+        OrderedIntervalList* oil = &_params.baseBounds.fields[_nearFieldIndex];
+        oil->intervals.clear();
+
+        const string cacheKey = coveringCacheKey(_params.nearQuery.centroid.point,
+                                                 _innerRadius,
+                                                 _outerRadius,
+                                                 _descriptor->infoObj());
+        bool cacheHit = false;
+        {
+            SimpleMutex::scoped_lock lk(coveringCacheLock);
+            OrderedIntervalList* cached;
+            if (coveringCache().get(cacheKey, &cached).isOK()) {
+                oil->intervals = cached->intervals;
+                cacheHit = true;
+            }
+        }
+
+        if (!cacheHit) {
+            ExpressionMapping::cover2dsphere(_annulus, _descriptor->infoObj(), oil);
+
+            auto_ptr<OrderedIntervalList> entry(new OrderedIntervalList());
+            entry->intervals = oil->intervals;
+            SimpleMutex::scoped_lock lk(coveringCacheLock);
+            coveringCache().add(cacheKey, entry.release());
+        }
 
         params.bounds = _params.baseBounds;
         params.direction = 1;
@@ -323,12 +386,21 @@ namespace mongo {
             if (_seenInScan.end() != _seenInScan.find(member->loc)) {
                 return PlanStage::NEED_TIME;
             }
+            // Docs we dealt with for good in an earlier annulus come back from later rings'
+            // scans since the coverings overlap; drop them before doing any geometry work.
+            if (_handledLocs.end() != _handledLocs.find(member->loc)) {
+                return PlanStage::NEED_TIME;
+            }
         }
 
         // Get all the fields with that name from the document.
         BSONElementSet geom;
         member->obj.getFieldsDotted(_params.nearQuery.field, geom, false);
         if (geom.empty()) {
+            // No geometry means no distance; it'll never qualify in any annulus.
+            if (member->hasLoc()) {
+                _handledLocs.insert(member->loc);
+            }
             return PlanStage::NEED_TIME;
         }
 
@@ -361,6 +433,15 @@ namespace mongo {
         // ignore it if it pops up again in this annulus.
         if (member->hasLoc()) {
             _seenInScan.insert(member->loc);
+
+            // If its distance lands in this annulus or an earlier one, or past the max, we're
+            // done with this doc for the rest of the query.  Distances in a future annulus
+            // must be reconsidered when we get there, so those stay out of the set.
+            bool inPastOrCurrent = _outerRadiusInclusive ? minDistance <= _outerRadius
+                                                         : minDistance < _outerRadius;
+            if (inPastOrCurrent || minDistance > _maxDistance) {
+                _handledLocs.insert(member->loc);
+            }
         }
 
         // If the distance to the doc satisfies our distance criteria, add it to our buffered
@@ -420,6 +501,10 @@ namespace mongo {
             // Don't keep it around in the invalidation map since there's no valid DiskLoc anymore.
             _invalidationMap.erase(it);
         }
+
+        // The loc may be reused by another doc after this invalidation; that doc must not
+        // inherit our verdict on the old one.
+        _handledLocs.erase(dl);
     }
 
     bool S2NearStage::isEOF() {
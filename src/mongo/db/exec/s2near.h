@@ -127,6 +127,13 @@ namespace mongo {
         // annulus.
         unordered_set<DiskLoc, DiskLoc::Hasher> _seenInScan;
 
+        // Locs we've dealt with for good: returned from an earlier annulus, or rejected
+        // because their distance can never qualify (or they have no geometry).  Coverings of
+        // successive annuli overlap, so the same doc comes back from later rings' scans;
+        // this lets us drop it before re-extracting geometry and re-computing distances.
+        // Locs whose distance lands in a future annulus are deliberately not in here.
+        unordered_set<DiskLoc, DiskLoc::Hasher> _handledLocs;
+
         // We compute an annulus of results and cache it here.
         priority_queue<Result> _results;
 
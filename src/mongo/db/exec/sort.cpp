@@ -45,6 +45,12 @@ namespace mongo {
 
     const size_t kMaxBytes = 32 * 1024 * 1024;
 
+    namespace {
+        // Process-wide accounting for blocking-sort buffers (serverStatus
+        // memoryAccounting section).
+        MemoryAccount sortMemoryAccount( "sortStage" );
+    }
+
     // static
     const char* SortStage::kStageType = "SORT";
 
@@ -290,7 +296,8 @@ namespace mongo {
           _sorted(false),
           _resultIterator(_data.end()),
           _commonStats(kStageType),
-          _memUsage(0) {
+          _memUsage(0),
+          _memTracker(sortMemoryAccount) {
     }
 
     SortStage::~SortStage() { }
@@ -320,6 +327,8 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        _memTracker.set(_memUsage);
+
         if (_memUsage > kMaxBytes) {
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
@@ -329,6 +338,19 @@ namespace mongo {
             return PlanStage::FAILURE;
         }
 
+        // A sort that is already holding buffered data stops growing when the
+        // process-wide memory budget is exhausted; it cannot spill, so fail it.
+        if (_memUsage > 0 && MemoryAccount::wouldExceedBudget(0)) {
+            mongoutils::str::stream ss;
+            ss << "sort stage buffered data usage of " << _memUsage
+               << " bytes and the process-wide tracked memory usage of "
+               << MemoryAccount::totalBytes()
+               << " bytes exceed the memoryAccountingBudgetMB budget";
+            Status status(ErrorCodes::Overflow, ss);
+            *out = WorkingSetCommon::allocateStatusMember( _ws, status);
+            return PlanStage::FAILURE;
+        }
+
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         // Still reading in results to sort.
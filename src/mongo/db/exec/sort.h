@@ -38,6 +38,7 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/util/memory_account.h"
 
 
 namespace mongo {
@@ -265,6 +266,9 @@ namespace mongo {
 
         // The usage in bytes of all buffered data that we're sorting.
         size_t _memUsage;
+
+        // Mirrors _memUsage into the process-wide "sortStage" MemoryAccount.
+        ScopedMemoryTracker _memTracker;
     };
 
 }  // namespace mongo
@@ -28,6 +28,9 @@
 
 #include "mongo/db/exec/text.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set.h"
@@ -50,8 +53,18 @@ namespace mongo {
           _filter(filter),
           _commonStats(kStageType),
           _internalState(INIT_SCANS),
-          _currentIndexScanner(0) {
+          _currentIndexScanner(0),
+          _topK(params.topK),
+          _scannersDone(0),
+          _keysSinceBoundsCheck(0) {
         _scoreIterator = _scores.end();
+
+        // Phrases and negations are filtered after scoring (see returnResults()), so a
+        // candidate set cut off at k could deliver fewer than k matches.  The term masks
+        // are also only 32 bits wide.
+        if (_params.query.hasNonTermPieces() || _params.query.getTerms().size() > 31) {
+            _topK = 0;
+        }
     }
 
     TextStage::~TextStage() { }
@@ -135,6 +148,7 @@ namespace mongo {
             }
             _scores.erase(scoreIt);
         }
+        _seenTerms.erase(dl);
     }
 
     vector<PlanStage*> TextStage::getChildren() const {
@@ -183,6 +197,12 @@ namespace mongo {
             _scanners.mutableVector().push_back(new IndexScan(params, _ws, NULL));
         }
 
+        // The scans descend by score, so the score at each scanner's position bounds
+        // what any document it has not yet produced can still collect from that term.
+        // Until a scanner yields its first key, MAX_WEIGHT is the (coarse) bound.
+        _scannerFrontier.resize(_scanners.size(), MAX_WEIGHT);
+        _scannerDone.resize(_scanners.size(), false);
+
         // If we have no terms we go right to EOF.
         if (0 == _scanners.size()) {
             _internalState = DONE;
@@ -197,6 +217,7 @@ namespace mongo {
     PlanStage::StageState TextStage::readFromSubScanners(WorkingSetID* out) {
         // This should be checked before we get here.
         invariant(_currentIndexScanner < _scanners.size());
+        invariant(!_scannerDone[_currentIndexScanner]);
 
         // Read the next result from our current scanner.
         WorkingSetID id = WorkingSet::INVALID_ID;
@@ -207,26 +228,36 @@ namespace mongo {
             invariant(1 == wsm->keyData.size());
             invariant(wsm->hasLoc());
             IndexKeyDatum& keyDatum = wsm->keyData.back();
-            addTerm(keyDatum.keyData, wsm->loc);
+            addTerm(keyDatum.keyData, wsm->loc, _currentIndexScanner);
             _ws->free(id);
-            return PlanStage::NEED_TIME;
+
+            // Periodically see if the top k is already decided.  The check walks the
+            // whole candidate map, so don't pay for it on every key.
+            if (_topK > 0 && ++_keysSinceBoundsCheck >= 256) {
+                _keysSinceBoundsCheck = 0;
+                if (topKBoundsJustifyStopping()) {
+                    _scoreIterator = _scores.begin();
+                    _internalState = RETURNING_RESULTS;
+                    _scanners.clear();
+                    return PlanStage::NEED_TIME;
+                }
+            }
         }
         else if (PlanStage::IS_EOF == childState) {
             // Done with this scan.
-            ++_currentIndexScanner;
+            _scannerDone[_currentIndexScanner] = true;
+            _scannerFrontier[_currentIndexScanner] = 0;
+            ++_scannersDone;
 
-            if (_currentIndexScanner < _scanners.size()) {
-                // We have another scan to read from.
+            if (_scannersDone == _scanners.size()) {
+                // If we're here we are done reading results.  Move to the next state.
+                _scoreIterator = _scores.begin();
+                _internalState = RETURNING_RESULTS;
+
+                // Don't need to keep these around.
+                _scanners.clear();
                 return PlanStage::NEED_TIME;
             }
-
-            // If we're here we are done reading results.  Move to the next state.
-            _scoreIterator = _scores.begin();
-            _internalState = RETURNING_RESULTS;
-
-            // Don't need to keep these around.
-            _scanners.clear();
-            return PlanStage::NEED_TIME;
         }
         else {
             if (PlanStage::FAILURE == childState) {
@@ -244,6 +275,14 @@ namespace mongo {
             }
             return childState;
         }
+
+        // Round-robin over the live scanners so every term's frontier descends together;
+        // that keeps the top-k bounds tight.  (With _topK == 0 the read order makes no
+        // difference: scores aggregate the same however the keys interleave.)
+        do {
+            _currentIndexScanner = (_currentIndexScanner + 1) % _scanners.size();
+        } while (_scannerDone[_currentIndexScanner]);
+        return PlanStage::NEED_TIME;
     }
 
     PlanStage::StageState TextStage::returnResults(WorkingSetID* out) {
@@ -333,7 +372,7 @@ namespace mongo {
         bool* _fetched;
     };
 
-    void TextStage::addTerm(const BSONObj& key, const DiskLoc& loc) {
+    void TextStage::addTerm(const BSONObj& key, const DiskLoc& loc, size_t scannerIndex) {
         double *documentAggregateScore = &_scores[loc];
 
         ++_specificStats.keysExamined;
@@ -348,7 +387,14 @@ namespace mongo {
 
         BSONElement scoreElement = keyIt.next();
         double documentTermScore = scoreElement.number();
-        
+
+        // Keys arrive in descending score order, so this is the new bound on what the
+        // scan can add to any document it has not produced yet.
+        _scannerFrontier[scannerIndex] = documentTermScore;
+        if (_topK > 0) {
+            _seenTerms[loc] |= (1u << scannerIndex);
+        }
+
         // Handle filtering.
         if (*documentAggregateScore < 0) {
             // We have already rejected this document.
@@ -384,4 +430,73 @@ namespace mongo {
         *documentAggregateScore += documentTermScore;
     }
 
+    bool TextStage::topKBoundsJustifyStopping() const {
+        if (_scores.size() < _topK) {
+            return false;
+        }
+
+        // Which scans are still running, and how much can a document we have never
+        // seen still collect across all of them?
+        unsigned liveMask = 0;
+        double frontierSum = 0;
+        for (size_t i = 0; i < _scannerDone.size(); ++i) {
+            if (!_scannerDone[i]) {
+                liveMask |= (1u << i);
+                frontierSum += _scannerFrontier[i];
+            }
+        }
+
+        // A candidate's score is final once every still-running scan has already
+        // produced it.  Find the kth best final score.
+        std::vector<double> finalScores;
+        for (ScoreMap::const_iterator it = _scores.begin(); it != _scores.end(); ++it) {
+            if (it->second <= 0) {
+                continue;  // rejected by the filter
+            }
+            TermMaskMap::const_iterator mask = _seenTerms.find(it->first);
+            const unsigned seen = (mask == _seenTerms.end()) ? 0 : mask->second;
+            if (0 == (liveMask & ~seen)) {
+                finalScores.push_back(it->second);
+            }
+        }
+        if (finalScores.size() < _topK) {
+            return false;
+        }
+        std::nth_element(finalScores.begin(),
+                         finalScores.begin() + (_topK - 1),
+                         finalScores.end(),
+                         std::greater<double>());
+        const double kthScore = finalScores[_topK - 1];
+
+        // A document we have never seen could still tie or beat the kth result.
+        if (frontierSum >= kthScore) {
+            return false;
+        }
+
+        // Every candidate whose upper bound reaches the kth result must already be
+        // final (in which case it simply is one of the top k).
+        for (ScoreMap::const_iterator it = _scores.begin(); it != _scores.end(); ++it) {
+            if (it->second <= 0) {
+                continue;
+            }
+            TermMaskMap::const_iterator mask = _seenTerms.find(it->first);
+            const unsigned seen = (mask == _seenTerms.end()) ? 0 : mask->second;
+            const unsigned unseenLive = liveMask & ~seen;
+            if (0 == unseenLive) {
+                continue;  // final score; counted above
+            }
+            double upperBound = it->second;
+            for (size_t i = 0; i < _scannerFrontier.size(); ++i) {
+                if (unseenLive & (1u << i)) {
+                    upperBound += _scannerFrontier[i];
+                }
+            }
+            if (upperBound >= kthScore) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
 }  // namespace mongo
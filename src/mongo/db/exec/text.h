@@ -53,7 +53,7 @@ namespace mongo {
     using fts::MAX_WEIGHT;
 
     struct TextStageParams {
-        TextStageParams(const FTSSpec& s) : spec(s) {}
+        TextStageParams(const FTSSpec& s) : spec(s), topK(0) {}
 
         // Text index descriptor.  IndexCatalog owns this.
         IndexDescriptor* index;
@@ -66,6 +66,11 @@ namespace mongo {
 
         // The text query.
         FTSQuery query;
+
+        // If nonzero, the stage only needs to deliver the 'topK' highest-scoring matches
+        // and may stop scanning term postings once the score bounds prove no other
+        // document can reach the top k.  Zero means score everything (the default).
+        size_t topK;
     };
 
     /**
@@ -127,9 +132,16 @@ namespace mongo {
         /**
          * Helper called from readFromSubScanners to update aggregate score with a new-found (term,
          * score) pair for this document.  Also rejects documents that don't match this stage's
-         * filter.
+         * filter.  'scannerIndex' identifies which term scan produced the key.
          */
-        void addTerm(const BSONObj& key, const DiskLoc& loc);
+        void addTerm(const BSONObj& key, const DiskLoc& loc, size_t scannerIndex);
+
+        /**
+         * Used when '_topK' is nonzero.  Returns true if the accumulated scores and the
+         * per-term scan frontiers prove that no document outside the current top k can
+         * still reach it, so the remaining postings need not be scanned.
+         */
+        bool topKBoundsJustifyStopping() const;
 
         /**
          * Possibly return a result.  FYI, this may perform a fetch directly if it is needed to
@@ -169,6 +181,27 @@ namespace mongo {
         typedef unordered_map<DiskLoc, double, DiskLoc::Hasher> ScoreMap;
         ScoreMap _scores;
         ScoreMap::const_iterator _scoreIterator;
+
+        // Top-k early termination (see TextStageParams::topK).  Zero when disabled,
+        // which is also forced when the query has phrases or negations: those are
+        // filtered after scoring, so a truncated candidate set could come up short.
+        size_t _topK;
+
+        // Per-term scan state for the score bounds.  The text index orders each term's
+        // keys by descending score, so _scannerFrontier[i] -- the score at scanner i's
+        // current position -- is an upper bound on what any not-yet-seen document can
+        // still collect from term i.
+        std::vector<double> _scannerFrontier;
+        std::vector<bool> _scannerDone;
+        size_t _scannersDone;
+
+        // Maps from diskloc -> bitmask of which term scans have produced this doc.
+        // Only maintained when _topK is nonzero.
+        typedef unordered_map<DiskLoc, unsigned, DiskLoc::Hasher> TermMaskMap;
+        TermMaskMap _seenTerms;
+
+        // Keys read since the last (linear-time) bounds check.
+        size_t _keysSinceBoundsCheck;
     };
 
 } // namespace mongo
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <new>
+
 #include "mongo/db/index/index_descriptor.h"
 
 namespace mongo {
@@ -35,12 +37,25 @@ namespace mongo {
     WorkingSet::MemberHolder::MemberHolder() : member(NULL) { }
     WorkingSet::MemberHolder::~MemberHolder() {}
 
-    WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
+    WorkingSet::WorkingSet() : _freeList(INVALID_ID), _lastSlabUsed(kMembersPerSlab) { }
 
     WorkingSet::~WorkingSet() {
+        // Every _data entry has a member constructed in one of our slabs.
         for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+            _data[i].member->~WorkingSetMember();
+        }
+        for (size_t i = 0; i < _slabs.size(); i++) {
+            delete[] _slabs[i];
+        }
+    }
+
+    WorkingSetMember* WorkingSet::_allocateMember() {
+        if (_lastSlabUsed == kMembersPerSlab) {
+            _slabs.push_back(new char[sizeof(WorkingSetMember) * kMembersPerSlab]);
+            _lastSlabUsed = 0;
         }
+        WorkingSetMember* slab = reinterpret_cast<WorkingSetMember*>(_slabs.back());
+        return new (slab + _lastSlabUsed++) WorkingSetMember();
     }
 
     WorkingSetID WorkingSet::allocate() {
@@ -51,7 +66,7 @@ namespace mongo {
             WorkingSetID id = _data.size();
             _data.resize(_data.size() + 1);
             _data.back().nextFreeOrSelf = id;
-            _data.back().member = new WorkingSetMember();
+            _data.back().member = _allocateMember();
             return id;
         }
 
@@ -113,10 +113,24 @@ namespace mongo {
             WorkingSetMember* member;
         };
 
+        /**
+         * Construct a WorkingSetMember in the current slab, starting a new slab if full.
+         */
+        WorkingSetMember* _allocateMember();
+
         // All WorkingSetIDs are indexes into this, except for INVALID_ID.
         // Elements are added to _freeList rather than removed when freed.
         std::vector<MemberHolder> _data;
 
+        // Members are placement-constructed into fixed-size slabs instead of allocated
+        // one at a time, so growing the working set touches the global heap only once
+        // per kMembersPerSlab allocations and members end up contiguous in memory.
+        // Slab storage is never reused until the whole WorkingSet is destroyed, so
+        // member pointers stay valid for the lifetime of their ID.
+        static const size_t kMembersPerSlab = 128;
+        std::vector<char*> _slabs;
+        size_t _lastSlabUsed;
+
         // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
         // link. INVALID_ID is the list terminator since 0 is a valid index.
         // If _freeList == INVALID_ID, the free list is empty and all elements in _data are in use.
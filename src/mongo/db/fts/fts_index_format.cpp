@@ -57,16 +57,34 @@ namespace mongo {
             const size_t termKeySuffixLength = 32U;
             const size_t termKeyLength = termKeyPrefixLength + termKeySuffixLength;
 
+            // New in textIndexVersion 3 (the compact key format).
+            // Terms are hashed at a quarter of the version 2 threshold, and the
+            // suffix keeps only 64 bits of the hash, capping a term's key footprint
+            // at 32 characters instead of 64.  Since the term string is repeated in
+            // the index once per (term, document) pair, this is where most of a
+            // text index's size goes.
+            const size_t compactTermKeyPrefixLength = 16U;
+            // 64-bit hash value expressed in hex = 16 characters
+            const size_t compactTermKeySuffixLength = 16U;
+            const size_t compactTermKeyLength =
+                compactTermKeyPrefixLength + compactTermKeySuffixLength;
+
             /**
              * Returns size of buffer required to store term in index key.
              * In version 1, terms are stored verbatim in key.
-             * In version 2, terms longer than 32 characters are hashed and combined
-             * with a prefix.
+             * In versions 2 and 3, long terms are hashed and combined
+             * with a prefix; version 3 hashes at a shorter threshold.
              */
             int guessTermSize( const std::string& term, TextIndexVersion textIndexVersion ) {
                 if ( TEXT_INDEX_VERSION_1 == textIndexVersion ) {
                     return term.size();
                 }
+                else if ( TEXT_INDEX_VERSION_3 == textIndexVersion ) {
+                    if ( term.size() <= compactTermKeyPrefixLength ) {
+                        return term.size();
+                    }
+                    return compactTermKeyLength;
+                }
                 else {
                     invariant( TEXT_INDEX_VERSION_2 == textIndexVersion );
                     if ( term.size() <= termKeyPrefixLength ) {
@@ -187,6 +205,27 @@ namespace mongo {
                 b.append( "", term );
                 b.append( "", weight );
             }
+            // See comments at the top of file for compactTermKeyPrefixLength.
+            // The compact format of text index version 3 hashes terms longer than
+            // 16 characters, keeping 64 bits of the hash.
+            else if ( TEXT_INDEX_VERSION_3 == textIndexVersion ) {
+                if ( term.size() <= compactTermKeyPrefixLength ) {
+                    b.append( "", term );
+                }
+                else {
+                    union {
+                        uint64_t hash[2];
+                        char data[16];
+                    } t;
+                    uint32_t seed = 0;
+                    MurmurHash3_x64_128( term.data(), term.size(), seed, t.hash );
+                    string keySuffix = mongo::toHexLower( t.data, sizeof( t.data ) / 2 );
+                    invariant( compactTermKeySuffixLength == keySuffix.size() );
+                    b.append( "", term.substr( 0, compactTermKeyPrefixLength ) +
+                              keySuffix );
+                }
+                b.append( "", weight );
+            }
             // See comments at the top of file for termKeyPrefixLength.
             // Apply hash for text index version 2 to long terms (longer than 32 characters).
             else {
@@ -199,5 +199,49 @@ namespace mongo {
             assertEqualsIndexKeys( expectedKeys, keys);
         }
 
+        /**
+         * Tests keys for long terms using text index version 3 (compact keys).
+         * Terms longer than 16 characters are hashed, and the key keeps the
+         * first 16 characters of the term plus 64 bits of the murmur3 hash,
+         * capping the key at 32 characters.
+         */
+        TEST( FTSIndexFormat, LongWordTextIndexVersion3 ) {
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "data" << "text" ) <<
+                                                  "textIndexVersion" << 3 ) ) );
+            BSONObjSet keys;
+            string longPrefix( 1024U, 'a' );
+            // "aaa...aaacat"
+            string longWordCat = longPrefix + "cat";
+            // "aaa...aaasat"
+            string longWordSat = longPrefix + "sat";
+            string text = mongoutils::str::stream() << longWordCat << " " << longWordSat;
+            FTSIndexFormat::getKeys( spec, BSON( "data" << text  ), &keys );
+
+            // Hard-coded expected computed keys for future-proofing.
+            std::set<string> expectedKeys;
+            // cat
+            expectedKeys.insert( "aaaaaaaaaaaaaaaaf2d6f58bb3b81b97" );
+            // sat
+            expectedKeys.insert( "aaaaaaaaaaaaaaaab8e78455d827ebb8" );
+
+            assertEqualsIndexKeys( expectedKeys, keys);
+        }
+
+        /**
+         * Short terms are stored verbatim in version 3, same as version 2.
+         */
+        TEST( FTSIndexFormat, ShortWordTextIndexVersion3 ) {
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "data" << "text" ) <<
+                                                  "textIndexVersion" << 3 ) ) );
+            BSONObjSet keys;
+            FTSIndexFormat::getKeys( spec, BSON( "data" << "cat sat" ), &keys );
+
+            std::set<string> expectedKeys;
+            expectedKeys.insert( "cat" );
+            expectedKeys.insert( "sat" );
+
+            assertEqualsIndexKeys( expectedKeys, keys);
+        }
+
     }
 }
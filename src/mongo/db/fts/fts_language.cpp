@@ -232,6 +232,9 @@ namespace mongo {
         StatusWithFTSLanguage FTSLanguage::make( const StringData& langName,
                                                  TextIndexVersion textIndexVersion ) {
             switch ( textIndexVersion ) {
+                // TEXT_INDEX_VERSION_3 only changes the key format; languages are
+                // parsed exactly as for TEXT_INDEX_VERSION_2.
+                case TEXT_INDEX_VERSION_3:
                 case TEXT_INDEX_VERSION_2: {
                     LanguageMapV2::const_iterator it = languageMapV2.find( langName );
                     if ( it == languageMapV2.end() ) {
@@ -73,17 +73,18 @@ namespace mongo {
                      "found invalid spec for text index, expected number for textIndexVersion",
                      textIndexVersionElt.isNumber() );
 
-            // We currently support TEXT_INDEX_VERSION_1 (deprecated) and TEXT_INDEX_VERSION_2.
-            // Reject all other values.
+            // We currently support TEXT_INDEX_VERSION_1 (deprecated), TEXT_INDEX_VERSION_2 and
+            // TEXT_INDEX_VERSION_3 (compact keys).  Reject all other values.
             massert( 17364,
                      str::stream() << "attempt to use unsupported textIndexVersion " <<
                          textIndexVersionElt.numberInt() << "; versions supported: " <<
+                         TEXT_INDEX_VERSION_3 << ", " <<
                          TEXT_INDEX_VERSION_2 << ", " << TEXT_INDEX_VERSION_1,
-                     textIndexVersionElt.numberInt() == TEXT_INDEX_VERSION_2 ||
+                     textIndexVersionElt.numberInt() == TEXT_INDEX_VERSION_3 ||
+                         textIndexVersionElt.numberInt() == TEXT_INDEX_VERSION_2 ||
                          textIndexVersionElt.numberInt() == TEXT_INDEX_VERSION_1 );
 
-            _textIndexVersion = ( textIndexVersionElt.numberInt() == TEXT_INDEX_VERSION_2 ) ?
-                                TEXT_INDEX_VERSION_2 : TEXT_INDEX_VERSION_1;
+            _textIndexVersion = static_cast<TextIndexVersion>( textIndexVersionElt.numberInt() );
 
             // Initialize _defaultLanguage.  Note that the FTSLanguage constructor requires
             // textIndexVersion, since language parsing is version-specific.
@@ -180,18 +181,23 @@ namespace mongo {
 
             unsigned numTokens = 0;
 
+            // reused for every token so steady state does no per-term allocation
+            string termBuf;
+
             Tokenizer i( tools.language, raw );
             while ( i.more() ) {
                 Token t = i.next();
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
-                makeLower( &term );
-                if ( tools.stopwords->isStopWord( term ) ) {
+                termBuf.assign( t.data.rawData(), t.data.size() );
+                makeLower( &termBuf );
+                if ( tools.stopwords->isStopWord( termBuf ) ) {
                     continue;
                 }
-                term = tools.stemmer->stem( term );
+
+                // view into the stemmer's buffer; the map copies it only for new terms
+                StringData term = tools.stemmer->stemView( termBuf );
 
                 ScoreHelperStruct& data = terms[term];
 
@@ -466,7 +472,8 @@ namespace mongo {
                     textIndexVersion = e.numberInt();
                     uassert( 16730,
                              str::stream() << "bad textIndexVersion: " << textIndexVersion,
-                             textIndexVersion == TEXT_INDEX_VERSION_2 );
+                             textIndexVersion == TEXT_INDEX_VERSION_2 ||
+                                 textIndexVersion == TEXT_INDEX_VERSION_3 );
                 }
                 else {
                     b.append( e );
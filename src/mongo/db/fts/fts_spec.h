@@ -40,6 +40,7 @@
 #include "mongo/db/fts/stop_words.h"
 #include "mongo/db/fts/tokenizer.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -50,7 +51,9 @@ namespace mongo {
         extern const double DEFAULT_WEIGHT;
 
         typedef std::map<std::string,double> Weights; // TODO cool map
-        typedef unordered_map<std::string,double> TermFrequencyMap;
+        // StringMap so the scoring hot loop can probe with a StringData and only pay
+        // for a string copy when a term is seen for the first time.
+        typedef StringMap<double> TermFrequencyMap;
 
         struct ScoreHelperStruct {
             ScoreHelperStruct()
@@ -60,7 +63,7 @@ namespace mongo {
             double count;
             double exp;
         };
-        typedef unordered_map<std::string,ScoreHelperStruct> ScoreHelperMap;
+        typedef StringMap<ScoreHelperStruct> ScoreHelperMap;
 
         class FTSSpec {
 
@@ -52,6 +52,13 @@ namespace mongo {
             ~Stemmer();
 
             std::string stem( const StringData& word ) const;
+
+            /**
+             * Returns a view of the stemmed word without copying it; the view points
+             * into the stemmer's internal buffer (or 'word' itself) and is only valid
+             * until the next call on this Stemmer.
+             */
+            StringData stemView( const StringData& word ) const;
         private:
             struct sb_stemmer* _stemmer;
         };
@@ -69,11 +69,15 @@ namespace mongo {
         private:
             Token::Type _type( char c ) const;
             bool _skipWhitespace();
+            void _skipTextRun();
 
             unsigned _pos;
             bool _previousWhiteSpace;
             const StringData _raw;
             bool _english;
+
+            // 256-entry classification table for the current language.
+            const unsigned char* _typeTable;
         };
 
     }
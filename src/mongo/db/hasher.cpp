@@ -33,26 +33,59 @@
 */
 
 #include "mongo/db/hasher.h"
+
+#include <third_party/murmurhash3/MurmurHash3.h>
+
 #include "mongo/db/jsobj.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
 
-    Hasher::Hasher( HashSeed seed ) : _seed( seed ) {
+    Md5Hasher::Md5Hasher( HashSeed seed ) : _seed( seed ) {
         md5_init( &_md5State );
         md5_append( &_md5State , reinterpret_cast< const md5_byte_t * >( & _seed ) , sizeof( _seed ) );
     }
 
-    void Hasher::addData( const void * keyData , size_t numBytes ) {
+    void Md5Hasher::addData( const void * keyData , size_t numBytes ) {
         md5_append( &_md5State , static_cast< const md5_byte_t * >( keyData ), numBytes );
     }
 
-    void Hasher::finish( HashDigest out ) {
+    void Md5Hasher::finish( HashDigest out ) {
         md5_finish( &_md5State , out );
     }
 
+    Murmur3Hasher::Murmur3Hasher( HashSeed seed ) : _seed( seed ) {
+    }
+
+    void Murmur3Hasher::addData( const void * keyData , size_t numBytes ) {
+        _buf.appendBuf( keyData, numBytes );
+    }
+
+    void Murmur3Hasher::finish( HashDigest out ) {
+        MurmurHash3_x64_128( _buf.buf(), _buf.len(), static_cast<uint32_t>( _seed ), out );
+    }
+
+    Hasher* HasherFactory::createHasher( HashSeed seed, int hashVersion ) {
+        switch ( hashVersion ) {
+        case 0:
+            return new Md5Hasher( seed );
+        case 1:
+            return new Murmur3Hasher( seed );
+        default:
+            msgasserted( 18538, mongoutils::str::stream()
+                                << "unsupported hashVersion " << hashVersion );
+        }
+    }
+
     long long int BSONElementHasher::hash64( const BSONElement& e , HashSeed seed ){
-        scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
+        return hash64( e, seed, 0 );
+    }
+
+    long long int BSONElementHasher::hash64( const BSONElement& e ,
+                                             HashSeed seed ,
+                                             int hashVersion ){
+        scoped_ptr<Hasher> h( HasherFactory::createHasher( seed, hashVersion ) );
         recursiveHash( h.get() , e , false );
         HashDigest d;
         h->finish(d);
@@ -36,6 +36,7 @@
 
 #include "mongo/pch.h"
 #include "mongo/bson/bsonelement.h"
+#include "mongo/bson/util/builder.h"
 #include "mongo/util/md5.hpp"
 
 namespace mongo {
@@ -46,30 +47,62 @@ namespace mongo {
     class Hasher : private boost::noncopyable {
     public:
 
-        explicit Hasher( HashSeed seed );
-        ~Hasher() { };
+        virtual ~Hasher() { };
 
         //pointer to next part of input key, length in bytes to read
-        void addData( const void * keyData , size_t numBytes );
+        virtual void addData( const void * keyData , size_t numBytes ) = 0;
 
         //finish computing the hash, put the result in the digest
         //only call this once per Hasher
-        void finish( HashDigest out );
+        virtual void finish( HashDigest out ) = 0;
+    };
+
+    /* The original MD5-based hasher.  Used by hashVersion 0 indexes and by
+     * hashed sharding, whose chunk boundaries are expressed in its output.
+     */
+    class Md5Hasher : public Hasher {
+    public:
+
+        explicit Md5Hasher( HashSeed seed );
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
 
     private:
         md5_state_t _md5State;
         HashSeed _seed;
     };
 
+    /* MurmurHash3-based hasher, used by hashVersion 1 indexes.  Much cheaper
+     * than MD5 and not comparable with it: a hashVersion 1 index is a
+     * different index.  Buffers its input, as the vendored MurmurHash3 is
+     * one-shot rather than incremental.
+     */
+    class Murmur3Hasher : public Hasher {
+    public:
+
+        explicit Murmur3Hasher( HashSeed seed );
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
+
+    private:
+        BufBuilder _buf;
+        HashSeed _seed;
+    };
+
     class HasherFactory : private boost::noncopyable  {
     public:
-        /* Eventually this may be a more sophisticated factory
-         * for creating other hashers, but for now use MD5.
-         */
+        /* Creates the hashVersion 0 (MD5) hasher. */
         static Hasher* createHasher( HashSeed seed ) {
-            return new Hasher( seed );
+            return new Md5Hasher( seed );
         }
 
+        /* Creates the hasher for the given hashVersion: 0 is the original
+         * MD5-based hash, 1 is MurmurHash3.  Asserts on any other version.
+         */
+        static Hasher* createHasher( HashSeed seed, int hashVersion );
+
     private:
         HasherFactory();
     };
@@ -100,6 +133,13 @@ namespace mongo {
          */
         static long long int hash64( const BSONElement& e , HashSeed seed );
 
+        /* As above, but hashing with the function selected by "hashVersion"
+         * (see HasherFactory::createHasher).  Version 0 is identical to the
+         * two-argument form; the canonical-type squashing described above is
+         * shared by every version.
+         */
+        static long long int hash64( const BSONElement& e , HashSeed seed , int hashVersion );
+
         /* This incrementally computes the hash of BSONElement "e"
          * using hash function "h".  If "includeFieldName" is true,
          * then the name of the field is hashed in between the type of
@@ -37,6 +37,7 @@
 #include "mongo/db/index/btree_index_cursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/operation_context.h"
@@ -49,6 +50,12 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(failIndexKeyTooLong, bool, true);
 
+    // Opt-in bloom filter over _id index keys, consulted by findSingle so
+    // negative point lookups usually skip the btree descent.  One filter per
+    // collection (per _id index); size is per filter.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIdHackBloomFilterEnabled, bool, false);
+    MONGO_EXPORT_SERVER_PARAMETER(internalIdHackBloomFilterSizeKB, int, 256);
+
     void BtreeBasedAccessMethod::InvalidateCursorsNotification::aboutToDeleteBucket(
             const DiskLoc& bucket) {
         BtreeIndexCursor::aboutToDeleteBucket(bucket);
@@ -62,6 +69,70 @@ namespace mongo {
           _descriptor(btreeState->descriptor()),
           _newInterface(btree) {
         verify(0 == _descriptor->version() || 1 == _descriptor->version());
+
+        if (internalIdHackBloomFilterEnabled &&
+            KeyPattern::isIdKeyPattern(_descriptor->keyPattern())) {
+            // Starts unpopulated; it only becomes authoritative for indexes
+            // created empty in this process (see initializeAsEmpty).
+            _idBloomFilter.reset(
+                    new IdBloomFilter(Ordering::make(_descriptor->keyPattern()),
+                                      static_cast<size_t>(internalIdHackBloomFilterSizeKB) * 1024));
+        }
+    }
+
+    void BtreeBasedAccessMethod::getKeysForDocument(const BSONObj& obj, BSONObjSet* keys) {
+        const MatchExpression* filter = _btreeState->getFilterExpression();
+        if (filter && !filter->matchesBSON(obj)) {
+            // Documents outside a partial index's filter have no keys.
+            return;
+        }
+        getKeys(obj, keys);
+    }
+
+    bool BtreeBasedAccessMethod::getKeysForBatch(const BSONObj& obj, BSONObjSet* keys) {
+        getKeysForDocument(obj, keys);
+        return true;
+    }
+
+    // Insert one key pointing to loc, swallowing the error codes insert() swallows.
+    Status BtreeBasedAccessMethod::insertKey(OperationContext* txn,
+                                             const BSONObj& key,
+                                             const DiskLoc& loc,
+                                             const InsertDeleteOptions& options,
+                                             int64_t* numInserted) {
+        Status status = _newInterface->insert(txn, key, loc, options.dupsAllowed);
+
+        // Everything's OK, carry on.
+        if (status.isOK()) {
+            ++*numInserted;
+            if (_idBloomFilter)
+                _idBloomFilter->insert(key);
+            return status;
+        }
+
+        // Error cases.
+
+        if (ErrorCodes::KeyTooLong == status.code()) {
+            // Ignore this error if we're on a secondary.
+            if (!txn->isPrimaryFor(_btreeState->ns())) {
+                return Status::OK();
+            }
+
+            // The user set a parameter to ignore key too long errors.
+            if (!failIndexKeyTooLong) {
+                return Status::OK();
+            }
+        }
+
+        if (ErrorCodes::UniqueIndexViolation == status.code()) {
+            // We ignore it for some reason in BG indexing.
+            if (!_btreeState->isReady()) {
+                DEV log() << "info: key already in index during bg indexing (ok)\n";
+                return Status::OK();
+            }
+        }
+
+        return status;
     }
 
     // Find the keys for obj, put them in the tree pointing to loc
@@ -73,55 +144,28 @@ namespace mongo {
         *numInserted = 0;
 
         BSONObjSet keys;
-        // Delegate to the subclass.
-        getKeys(obj, &keys);
+        // Delegate to the subclass (unless a partial index filter excludes obj).
+        getKeysForDocument(obj, &keys);
 
-        Status ret = Status::OK();
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
-            Status status = _newInterface->insert(txn, *i, loc, options.dupsAllowed);
-
-            // Everything's OK, carry on.
-            if (status.isOK()) {
-                ++*numInserted;
-                continue;
-            }
-
-            // Error cases.
+            Status status = insertKey(txn, *i, loc, options, numInserted);
 
-            if (ErrorCodes::KeyTooLong == status.code()) {
-                // Ignore this error if we're on a secondary.
-                if (!txn->isPrimaryFor(_btreeState->ns())) {
-                    continue;
+            if (!status.isOK()) {
+                // Clean up after ourselves.
+                for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
+                    removeOneKey(txn, *j, loc);
+                    *numInserted = 0;
                 }
 
-                // The user set a parameter to ignore key too long errors.
-                if (!failIndexKeyTooLong) {
-                    continue;
-                }
-            }
-
-            if (ErrorCodes::UniqueIndexViolation == status.code()) {
-                // We ignore it for some reason in BG indexing.
-                if (!_btreeState->isReady()) {
-                    DEV log() << "info: key already in index during bg indexing (ok)\n";
-                    continue;
-                }
-            }
-
-            // Clean up after ourselves.
-            for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
-                removeOneKey(txn, *j, loc);
-                *numInserted = 0;
+                return status;
             }
-
-            return status;
         }
 
         if (*numInserted > 1) {
             _btreeState->setMultikey( txn );
         }
 
-        return ret;
+        return Status::OK();
     }
 
     bool BtreeBasedAccessMethod::removeOneKey(OperationContext* txn,
@@ -140,6 +184,9 @@ namespace mongo {
             logContext();
         }
 
+        if (ret && _idBloomFilter)
+            _idBloomFilter->remove(key);
+
         return ret;
     }
 
@@ -156,7 +203,7 @@ namespace mongo {
                                           int64_t* numDeleted) {
 
         BSONObjSet keys;
-        getKeys(obj, &keys);
+        getKeysForDocument(obj, &keys);
         *numDeleted = 0;
 
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
@@ -194,12 +241,19 @@ namespace mongo {
     }
 
     Status BtreeBasedAccessMethod::initializeAsEmpty(OperationContext* txn) {
-        return _newInterface->initAsEmpty(txn);
+        Status status = _newInterface->initAsEmpty(txn);
+
+        // An index that starts empty is fully covered by the filter from here
+        // on; insert/remove keep it that way.
+        if (status.isOK() && _idBloomFilter)
+            _idBloomFilter->markPopulated();
+
+        return status;
     }
 
     Status BtreeBasedAccessMethod::touch(const BSONObj& obj) {
         BSONObjSet keys;
-        getKeys(obj, &keys);
+        getKeysForDocument(obj, &keys);
 
         boost::scoped_ptr<BtreeInterface::Cursor> cursor(_newInterface->newCursor(1));
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
@@ -214,18 +268,37 @@ namespace mongo {
         return _newInterface->touch(txn);
     }
 
+    long long BtreeBasedAccessMethod::nonLeafRegions(
+            std::vector< std::pair<void*, unsigned> >* regions,
+            long long maxBytes) const {
+        return _newInterface->nonLeafRegions(regions, maxBytes);
+    }
+
     DiskLoc BtreeBasedAccessMethod::findSingle(const BSONObj& key) const {
+        bool filterConsulted = false;
+        if (_idBloomFilter) {
+            const IdBloomFilter::CheckResult answer = _idBloomFilter->check(key);
+            if (IdBloomFilter::DefinitelyAbsent == answer) {
+                return DiskLoc();
+            }
+            filterConsulted = (IdBloomFilter::MaybePresent == answer);
+        }
+
         boost::scoped_ptr<BtreeInterface::Cursor> cursor(_newInterface->newCursor(1));
         cursor->locate(key, minDiskLoc);
 
         // A null bucket means the key wasn't found (nor was anything found after it).
         if (cursor->isEOF()) {
+            if (filterConsulted)
+                _idBloomFilter->noteFalsePositive();
             return DiskLoc();
         }
 
         // We found something but it could be a key after 'key'.  Examine what we're pointing at.
         if (0 != key.woCompare(cursor->getKey(), BSONObj(), false)) {
             // If the keys don't match, return "not found."
+            if (filterConsulted)
+                _idBloomFilter->noteFalsePositive();
             return DiskLoc();
         }
 
@@ -241,6 +314,11 @@ namespace mongo {
         return Status::OK();
     }
 
+    double BtreeBasedAccessMethod::estimateRangeFraction(const BSONObj& startKey,
+                                                         const BSONObj& endKey) const {
+        return _newInterface->estimateRangeFraction(startKey, endKey);
+    }
+
     Status BtreeBasedAccessMethod::validateUpdate(const BSONObj &from,
                                                   const BSONObj &to,
                                                   const DiskLoc &record,
@@ -250,8 +328,8 @@ namespace mongo {
         BtreeBasedPrivateUpdateData *data = new BtreeBasedPrivateUpdateData();
         status->_indexSpecificUpdateData.reset(data);
 
-        getKeys(from, &data->oldKeys);
-        getKeys(to, &data->newKeys);
+        getKeysForDocument(from, &data->oldKeys);
+        getKeysForDocument(to, &data->newKeys);
         data->loc = record;
         data->dupsAllowed = options.dupsAllowed;
 
@@ -292,11 +370,15 @@ namespace mongo {
         }
 
         for (size_t i = 0; i < data->added.size(); ++i) {
-            _newInterface->insert(txn, *data->added[i], data->loc, data->dupsAllowed);
+            Status status = _newInterface->insert(txn, *data->added[i], data->loc,
+                                                  data->dupsAllowed);
+            if (status.isOK() && _idBloomFilter)
+                _idBloomFilter->insert(*data->added[i]);
         }
 
         for (size_t i = 0; i < data->removed.size(); ++i) {
-            _newInterface->unindex(txn, *data->removed[i], data->loc);
+            if (_newInterface->unindex(txn, *data->removed[i], data->loc) && _idBloomFilter)
+                _idBloomFilter->remove(*data->removed[i]);
         }
 
         *numUpdated = data->added.size();
@@ -324,7 +406,20 @@ namespace mongo {
         }
 
         BtreeBasedBulkAccessMethod* bulk = static_cast<BtreeBasedBulkAccessMethod*>(bulkRaw);
+
+        // Bulk-built keys bypass insert(), so the filter no longer covers the
+        // index; stop it from answering.
+        if (_idBloomFilter)
+            _idBloomFilter->invalidate();
+
         return bulk->commit(dupsToDrop, mayInterrupt);
     }
 
+    bool BtreeBasedAccessMethod::appendIdBloomFilterStats(BSONObjBuilder* b) const {
+        if (!_idBloomFilter)
+            return false;
+        _idBloomFilter->appendStats(*b);
+        return true;
+    }
+
 }  // namespace mongo
@@ -33,6 +33,7 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/index/id_bloom_filter.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -68,6 +69,14 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted);
 
+        virtual bool getKeysForBatch( const BSONObj& obj, BSONObjSet* keys );
+
+        virtual Status insertKey(OperationContext* txn,
+                                 const BSONObj& key,
+                                 const DiskLoc& loc,
+                                 const InsertDeleteOptions& options,
+                                 int64_t* numInserted);
+
         virtual Status remove(OperationContext* txn,
                               const BSONObj& obj,
                               const DiskLoc& loc,
@@ -98,11 +107,23 @@ namespace mongo {
 
         virtual Status touch(OperationContext* txn) const;
 
+        virtual long long nonLeafRegions(std::vector< std::pair<void*, unsigned> >* regions,
+                                         long long maxBytes) const;
+
         virtual Status validate(int64_t* numKeys);
 
+        virtual double estimateRangeFraction(const BSONObj& startKey,
+                                             const BSONObj& endKey) const;
+
         // XXX: consider migrating callers to use IndexCursor instead
         virtual DiskLoc findSingle( const BSONObj& key ) const;
 
+        /**
+         * Appends the _id bloom filter's stats to 'b' (surfaced by collStats).
+         * Returns false when this index carries no filter.
+         */
+        bool appendIdBloomFilterStats( BSONObjBuilder* b ) const;
+
         /**
          * Invalidates all active cursors, which point at the bucket being deleted.
          * TODO see if there is a better place to put this.
@@ -122,6 +143,13 @@ namespace mongo {
 
         virtual void getKeys(const BSONObj &obj, BSONObjSet *keys) = 0;
 
+        /**
+         * Calls getKeys, except that a document that does not match a partial index's
+         * filter expression gets no keys at all (it is simply absent from the index).
+         * All insert/remove/update paths generate keys through here.
+         */
+        void getKeysForDocument(const BSONObj& obj, BSONObjSet* keys);
+
         IndexCatalogEntry* _btreeState; // owned by IndexCatalogEntry
         const IndexDescriptor* _descriptor;
 
@@ -131,6 +159,9 @@ namespace mongo {
                           const DiskLoc& loc);
 
         scoped_ptr<BtreeInterface> _newInterface;
+
+        // Optional negative-lookup filter; only ever set for the _id index.
+        scoped_ptr<IdBloomFilter> _idBloomFilter;
     };
 
     /**
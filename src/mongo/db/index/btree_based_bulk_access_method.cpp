@@ -32,11 +32,30 @@
 #include "mongo/db/pdfile_private.h"  // This is for inDBRepair.
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
 
+    // Number of threads generating keys for a bulk index build.  0 (the
+    // default) keeps the historical behavior of generating keys inline on the
+    // scanning thread; >0 pipelines key generation and sorting onto that many
+    // background threads, with commit() merging the per-thread sorted runs.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBulkBuildKeyGenThreads, int, 0);
+
+    namespace {
+        // Docs handed to a key-generation worker at a time.
+        const size_t kKeyGenBatchSize = 1024;
+
+        // How many batches a worker may have queued before the scan blocks.
+        const int kMaxBatchesPerWorker = 4;
+
+        // All per-worker sorters plus the merge share the same budget the
+        // single sorter used to have.
+        const size_t kSortMaxMemoryBytes = 100 * 1024 * 1024;
+    }
+
     //
     // Comparison for external sorter interface
     //
@@ -53,12 +72,21 @@ namespace mongo {
             invariant(version == 1 || version == 0);
         }
 
-        typedef std::pair<BSONObj, DiskLoc> Data;
+        typedef std::pair<BulkSortKey, DiskLoc> Data;
 
         int operator() (const Data& l, const Data& r) const {
-            int x = (_version == 1
-                        ? l.first.woCompare(r.first, _ordering, /*considerfieldname*/false)
-                        : oldCompare(l.first, r.first, _ordering));
+            int x;
+            if (!l.first.encoded().empty() && !r.first.encoded().empty()) {
+                // Both sides carry the order-preserving encoding: one memcmp
+                // instead of the BSON type ladder.
+                x = l.first.encoded().compare(r.first.encoded());
+            }
+            else {
+                x = (_version == 1
+                        ? l.first.bson().woCompare(r.first.bson(), _ordering,
+                                                   /*considerfieldname*/false)
+                        : oldCompare(l.first.bson(), r.first.bson(), _ordering));
+            }
             if (x) { return x; }
             return l.second.compare(r.second);
         }
@@ -70,20 +98,41 @@ namespace mongo {
     BtreeBasedBulkAccessMethod::BtreeBasedBulkAccessMethod(OperationContext* txn,
                                                            BtreeBasedAccessMethod* real,
                                                            BtreeInterface* interface,
-                                                           const IndexDescriptor* descriptor) {
+                                                           const IndexDescriptor* descriptor)
+        : _ordering(Ordering::make(descriptor->keyPattern())),
+          _encodeKeys(descriptor->version() == 1) {
         _real = real;
         _interface = interface;
+        _descriptor = descriptor;
         _txn = txn;
 
         _docsInserted = 0;
         _keysInserted = 0;
         _isMultiKey = false;
-
-        _sorter.reset(BSONObjExternalSorter::make(
-                    SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
-                                 .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(100*1024*1024),
-                    BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
+        _nextWorker = 0;
+
+        const int nWorkers = internalIndexBulkBuildKeyGenThreads;
+        if (nWorkers > 0) {
+            for (int i = 0; i < nWorkers; i++) {
+                boost::shared_ptr<KeyGenWorker> w(new KeyGenWorker());
+                w->sorter.reset(BSONObjExternalSorter::make(
+                            SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                         .ExtSortAllowed()
+                                         .MaxMemoryUsageBytes(kSortMaxMemoryBytes / nWorkers),
+                            BtreeExternalSortComparison(descriptor->keyPattern(),
+                                                        descriptor->version())));
+                _workers.push_back(w);
+            }
+            _batch.reserve(kKeyGenBatchSize);
+        }
+        else {
+            _sorter.reset(BSONObjExternalSorter::make(
+                        SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                     .ExtSortAllowed()
+                                     .MaxMemoryUsageBytes(kSortMaxMemoryBytes),
+                        BtreeExternalSortComparison(descriptor->keyPattern(),
+                                                    descriptor->version())));
+        }
     }
 
     Status BtreeBasedBulkAccessMethod::insert(OperationContext* txn,
@@ -91,14 +140,27 @@ namespace mongo {
                                               const DiskLoc& loc,
                                               const InsertDeleteOptions& options,
                                               int64_t* numInserted) {
+        if (!_workers.empty()) {
+            // Key generation is pipelined.  The record may move once we yield,
+            // so hand the workers their own copy; keys.size() isn't known yet,
+            // so numInserted is left alone (the bulk caller ignores it) and
+            // _keysInserted is aggregated in commit().
+            _batch.push_back(std::make_pair(obj.getOwned(), loc));
+            if (_batch.size() >= kKeyGenBatchSize) {
+                _dispatchBatch();
+            }
+            _docsInserted++;
+            return Status::OK();
+        }
+
         BSONObjSet keys;
-        _real->getKeys(obj, &keys);
+        _real->getKeysForDocument(obj, &keys);
 
         _isMultiKey = _isMultiKey || (keys.size() > 1);
 
         for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
             // False is for mayInterrupt.
-            _sorter->add(*it, loc);
+            _sorter->add(_makeSortKey(*it), loc);
             _keysInserted++;
         }
 
@@ -111,8 +173,75 @@ namespace mongo {
         return Status::OK();
     }
 
+    void BtreeBasedBulkAccessMethod::_dispatchBatch() {
+        if (_batch.empty())
+            return;
+
+        boost::shared_ptr<KeyGenBatch> batch(new KeyGenBatch());
+        batch->swap(_batch);
+        _batch.reserve(kKeyGenBatchSize);
+
+        for (;;) {
+            for (size_t n = 0; n < _workers.size(); n++) {
+                KeyGenWorker* w = _workers[_nextWorker].get();
+                _nextWorker = (_nextWorker + 1) % _workers.size();
+                if (w->pool.tasks_remaining() < kMaxBatchesPerWorker) {
+                    w->pool.schedule(stdx::bind(&BtreeBasedBulkAccessMethod::_processBatch,
+                                                this,
+                                                w,
+                                                batch));
+                    return;
+                }
+            }
+            // Every worker is several batches behind; let them catch up.
+            sleepmillis(1);
+        }
+    }
+
+    void BtreeBasedBulkAccessMethod::_processBatch(KeyGenWorker* worker,
+                                                   boost::shared_ptr<KeyGenBatch> batch) {
+        if (!worker->status.isOK()) {
+            // A previous batch already failed; the build is doomed, don't waste
+            // cycles on the rest.
+            return;
+        }
+
+        try {
+            for (size_t i = 0; i < batch->size(); i++) {
+                BSONObjSet keys;
+                _real->getKeysForDocument((*batch)[i].first, &keys);
+
+                worker->isMultiKey = worker->isMultiKey || (keys.size() > 1);
+
+                for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
+                    worker->sorter->add(_makeSortKey(*it), (*batch)[i].second);
+                    worker->keysInserted++;
+                }
+            }
+        }
+        catch (const DBException& e) {
+            worker->status = e.toStatus();
+        }
+    }
+
     Status BtreeBasedBulkAccessMethod::commit(set<DiskLoc>* dupsToDrop,
                                               bool mayInterrupt) {
+        if (!_workers.empty()) {
+            // Drain the pipeline and fold the per-worker results back in before
+            // anything looks at _isMultiKey or _keysInserted.
+            _dispatchBatch();
+            for (size_t i = 0; i < _workers.size(); i++) {
+                _workers[i]->pool.join();
+            }
+            for (size_t i = 0; i < _workers.size(); i++) {
+                if (!_workers[i]->status.isOK()) {
+                    return _workers[i]->status;
+                }
+                _isMultiKey = _isMultiKey || _workers[i]->isMultiKey;
+                _keysInserted += _workers[i]->keysInserted;
+            }
+        }
+
         if (_isMultiKey) {
             _real->_btreeState->setMultikey( _txn );
         }
@@ -125,7 +254,26 @@ namespace mongo {
 
         bool dropDups = entry->descriptor()->dropDups() || inDBRepair;
 
-        scoped_ptr<BSONObjExternalSorter::Iterator> i(_sorter->done());
+        scoped_ptr<BSONObjExternalSorter::Iterator> i;
+        if (_workers.empty()) {
+            i.reset(_sorter->done());
+        }
+        else {
+            // Each worker produced an independently sorted run; merge them into
+            // the single ordered stream the bottom-up builder needs.
+            std::vector< boost::shared_ptr<BSONObjExternalSorter::Iterator> > runs;
+            for (size_t n = 0; n < _workers.size(); n++) {
+                runs.push_back(boost::shared_ptr<BSONObjExternalSorter::Iterator>(
+                            _workers[n]->sorter->done()));
+            }
+            i.reset(BSONObjExternalSorter::Iterator::merge(
+                        runs,
+                        SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                     .ExtSortAllowed()
+                                     .MaxMemoryUsageBytes(kSortMaxMemoryBytes),
+                        BtreeExternalSortComparison(_descriptor->keyPattern(),
+                                                    _descriptor->version())));
+        }
 
         // verifies that pm and op refer to the same ProgressMeter
         ProgressMeter& pm = _txn->getCurOp()->setMessage("Index Bulk Build: (2/3) btree bottom up",
@@ -140,7 +288,7 @@ namespace mongo {
         while (i->more()) {
             // Get the next datum and add it to the builder.
             BSONObjExternalSorter::Data d = i->next();
-            Status status = builder->addKey(d.first, d.second);
+            Status status = builder->addKey(d.first.bson(), d.second);
 
             if (!status.isOK()) {
                 if (ErrorCodes::DuplicateKey != status.code()) {
@@ -185,4 +333,4 @@ namespace mongo {
 }  // namespace mongo
 
 #include "mongo/db/sorter/sorter.cpp"
-MONGO_CREATE_SORTER(mongo::BSONObj, mongo::DiskLoc, mongo::BtreeExternalSortComparison);
+MONGO_CREATE_SORTER(mongo::BulkSortKey, mongo::DiskLoc, mongo::BtreeExternalSortComparison);
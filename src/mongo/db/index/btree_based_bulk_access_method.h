@@ -27,8 +27,11 @@
 */
 
 #include <set>
+#include <utility>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/status.h"
 #include "mongo/db/sorter/sorter.h"
@@ -37,9 +40,64 @@
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/structure/btree/btree_interface.h"
+#include "mongo/db/structure/btree/key_string.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
+    /**
+     * Key handed to the external sorter during a bulk build: the BSON index
+     * key plus, for v:1 indexes whose types allow it, the key's
+     * order-preserving KeyString encoding computed once at insert.  The sort
+     * comparator memcmp()s the encodings instead of re-walking the BSON type
+     * ladder on every comparison.  Keys with no encoding (unsupported type,
+     * or a v:0 index, whose legacy ordering KeyString does not model) fall
+     * back to the BSON comparison, which orders identically, so encoded and
+     * unencoded keys mix freely within one sort.
+     */
+    class BulkSortKey {
+    public:
+        BulkSortKey() {}
+
+        explicit BulkSortKey(const BSONObj& key) : _key(key) {}
+
+        BulkSortKey(const BSONObj& key, const Ordering& ordering) : _key(key) {
+            _encoded.reset(key, ordering); // left empty if not encodable
+        }
+
+        const BSONObj& bson() const { return _key; }
+        const KeyString& encoded() const { return _encoded; }
+
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const {
+            _key.serializeForSorter(buf);
+            buf.appendNum(static_cast<int>(_encoded.size()));
+            buf.appendBuf(_encoded.data(), _encoded.size());
+        }
+        static BulkSortKey deserializeForSorter(BufReader& buf,
+                                                const SorterDeserializeSettings&) {
+            BulkSortKey out(BSONObj::deserializeForSorter(buf,
+                                                          BSONObj::SorterDeserializeSettings()));
+            const int encodedSize = buf.read<int>();
+            out._encoded.resetFromBuffer(static_cast<const char*>(buf.skip(encodedSize)),
+                                         encodedSize);
+            return out;
+        }
+        int memUsageForSorter() const {
+            return sizeof(BulkSortKey) + _key.objsize() + _encoded.size();
+        }
+        BulkSortKey getOwned() const {
+            BulkSortKey out(_key.getOwned());
+            out._encoded = _encoded;
+            return out;
+        }
+
+    private:
+        BSONObj _key;
+        KeyString _encoded;
+    };
+
     class BtreeBasedBulkAccessMethod : public IndexAccessMethod {
     public:
         /**
@@ -122,21 +180,72 @@ namespace mongo {
         }
 
     private:
-        typedef Sorter<BSONObj, DiskLoc> BSONObjExternalSorter;
+        typedef Sorter<BulkSortKey, DiskLoc> BSONObjExternalSorter;
+        typedef std::vector< std::pair<BSONObj, DiskLoc> > KeyGenBatch;
+
+        // Wraps a generated key for the sorter, encoding it when the index
+        // version supports KeyString ordering.
+        BulkSortKey _makeSortKey(const BSONObj& key) const {
+            if (_encodeKeys) {
+                return BulkSortKey(key, _ordering);
+            }
+            return BulkSortKey(key);
+        }
+
+        /**
+         * One key-generation worker.  Each worker owns a single-threaded pool
+         * (so its sorter is only ever touched by one thread) and its own sorter,
+         * which produces a sorted run that commit() merges with the others.
+         */
+        struct KeyGenWorker {
+            KeyGenWorker() : pool(1), keysInserted(0), isMultiKey(false),
+                             status(Status::OK()) {}
+
+            ThreadPool pool;
+            boost::scoped_ptr<BSONObjExternalSorter> sorter;
+            unsigned long long keysInserted;
+            bool isMultiKey;
+            // first error hit by this worker; surfaced from commit()
+            Status status;
+        };
 
         Status _notAllowed() const {
             return Status(ErrorCodes::InternalError, "cannot use bulk for this yet");
         }
 
+        /**
+         * Hands the docs buffered in _batch to the least-backlogged worker.
+         * Blocks (briefly) if every worker is already several batches behind so
+         * memory stays bounded when key generation is the bottleneck.
+         */
+        void _dispatchBatch();
+
+        // Runs on a worker's thread.
+        void _processBatch(KeyGenWorker* worker, boost::shared_ptr<KeyGenBatch> batch);
+
         // Not owned here.
         BtreeBasedAccessMethod* _real;
 
         // Not owned here.
         BtreeInterface* _interface;
 
-        // The external sorter.
+        // Not owned here.
+        const IndexDescriptor* _descriptor;
+
+        // The index's key ordering, baked into the KeyString encodings.
+        const Ordering _ordering;
+
+        // Only v:1 indexes sort in the order KeyString models.
+        const bool _encodeKeys;
+
+        // The external sorter.  Only used when key generation is single threaded.
         boost::scoped_ptr<BSONObjExternalSorter> _sorter;
 
+        // Parallel key generation state; empty when single threaded.
+        std::vector< boost::shared_ptr<KeyGenWorker> > _workers;
+        KeyGenBatch _batch;
+        size_t _nextWorker;
+
         // How many docs are we indexing?
         unsigned long long _docsInserted;
 
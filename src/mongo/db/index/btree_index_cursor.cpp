@@ -80,10 +80,18 @@ namespace mongo {
                         afterKey ? maxDiskLoc : minDiskLoc);
     }
 
+    void BtreeIndexCursor::seekExact(const BSONObj& key, const DiskLoc& loc) {
+        _cursor->locate(key, loc);
+    }
+
     bool BtreeIndexCursor::pointsAt(const BtreeIndexCursor& other) {
         return _cursor->pointsToSamePlaceAs(*other._cursor);
     }
 
+    long long BtreeIndexCursor::countAndAdvance(const BtreeIndexCursor& end) {
+        return _cursor->countAndAdvance(*end._cursor);
+    }
+
     Status BtreeIndexCursor::seek(const vector<const BSONElement*>& position,
                                   const vector<bool>& inclusive) {
 
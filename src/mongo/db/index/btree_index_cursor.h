@@ -64,6 +64,14 @@ namespace mongo {
          */
         void seek(const BSONObj& position, bool afterKey);
 
+        /**
+         * Seek to the exact (key, loc) entry, or to the next entry in cursor order if
+         * that exact entry is not present.
+         *
+         * Btree-specific.
+         */
+        void seekExact(const BSONObj& key, const DiskLoc& loc);
+
         Status skip(const BSONObj& keyBegin,
                     int keyBeginLen,
                     bool afterKey,
@@ -81,6 +89,14 @@ namespace mongo {
          */
         bool pointsAt(const BtreeIndexCursor& other);
 
+        /**
+         * BtreeIndexCursor-only.  Counting fast path used by the Count stage.
+         * Counts index keys from this cursor's position (inclusive) toward 'end''s
+         * (exclusive), advancing this cursor by at least one key.  May return a partial
+         * tally before reaching 'end'; the caller loops until pointsAt(end) or isEOF().
+         */
+        long long countAndAdvance(const BtreeIndexCursor& end);
+
         virtual Status savePosition();
 
         virtual Status restorePosition();
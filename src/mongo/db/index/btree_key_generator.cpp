@@ -60,6 +60,34 @@ namespace mongo {
         }
     }
 
+    namespace {
+        // FNV-1a over the key bytes; only used to pick an intern cache slot.
+        unsigned hashKeyBytes( const char* data, int len ) {
+            unsigned h = 2166136261U;
+            for ( int i = 0; i < len; ++i ) {
+                h = ( h ^ static_cast<unsigned char>( data[i] ) ) * 16777619U;
+            }
+            return h;
+        }
+    }
+
+    BSONObj BtreeKeyGenerator::_internKey(BSONObjBuilder& b) const {
+        const BSONObj candidate = b.done();
+        if ( candidate.objsize() > kMaxInternedKeyLength ) {
+            return b.obj();
+        }
+
+        BSONObj& cached = _internedKeys[ hashKeyBytes( candidate.objdata(), candidate.objsize() )
+                                         % kInternedKeySlots ];
+        if ( cached.objsize() == candidate.objsize() &&
+             memcmp( cached.objdata(), candidate.objdata(), candidate.objsize() ) == 0 ) {
+            // same bytes generated recently: hand out the shared buffer
+            return cached;
+        }
+        cached = b.obj(); // takes ownership of the builder's buffer
+        return cached;
+    }
+
     static void assertParallelArrays( const char *first, const char *second ) {
         stringstream ss;
         ss << "cannot index parallel arrays [" << first << "] [" << second << "]";
@@ -129,7 +157,7 @@ namespace mongo {
                 BSONObjBuilder b(_sizeTracker);
                 for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i )
                     b.appendAs( *i, "" );
-                keys->insert( b.obj() );
+                keys->insert( _internKey( b ) );
             }
             else {
                 // terminal array element to expand, so generate all keys
@@ -143,7 +171,7 @@ namespace mongo {
                             else
                                 b.appendAs( fixed[ j ], "" );
                         }
-                        keys->insert( b.obj() );
+                        keys->insert( _internKey( b ) );
                     }
                 }
                 else if ( fixed.size() > 1 ) {
@@ -183,7 +211,7 @@ namespace mongo {
                         b.appendAs( e , "" );
                 }
             }
-            keys->insert( b.obj() );
+            keys->insert( _internKey( b ) );
         }
     }
 
@@ -306,7 +334,7 @@ namespace mongo {
             for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i ) {
                 b.appendAs( *i, "" );
             }
-            keys->insert( b.obj() );
+            keys->insert( _internKey( b ) );
         }
         else if ( arrElt.embeddedObject().firstElement().eoo() ) {
             // Empty array, so set matching fields to undefined.
@@ -55,11 +55,29 @@ namespace mongo {
         BSONObj _nullObj;     // only used for _nullElt
         BSONElement _nullElt; // jstNull
         BSONSizeTracker _sizeTracker;
+
+        /**
+         * Returns the completed key in 'b', reusing the buffer of an identical
+         * recently generated key when possible.  Low-cardinality indexes produce the
+         * same few key byte strings over and over; interning lets equal keys share
+         * one refcounted buffer instead of each insert allocating its own.
+         *
+         * Like _sizeTracker, the cache is mutated from const getKeys calls; key
+         * generation for a given index is serialized by the database write lock.
+         */
+        BSONObj _internKey(BSONObjBuilder& b) const;
     private:
         // We have V0 and V1.  Sigh.
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                  const BSONObj &obj, BSONObjSet *keys) const = 0;
         vector<BSONElement> _fixed;
+
+        // Small direct-mapped cache of recently generated keys, indexed by a hash of
+        // the key bytes.  Keys longer than kMaxInternedKeyLength (typically array
+        // expansions) are unlikely to repeat often enough to be worth caching.
+        static const unsigned kInternedKeySlots = 64;
+        static const int kMaxInternedKeyLength = 256;
+        mutable BSONObj _internedKeys[kInternedKeySlots];
     };
 
     class BtreeKeyGeneratorV0 : public BtreeKeyGenerator {
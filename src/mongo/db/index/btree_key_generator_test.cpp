@@ -586,4 +586,27 @@ namespace {
         ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
     }
 
+    TEST(BtreeKeyGeneratorTest, RepeatedKeysShareInternedBuffer) {
+        vector<const char*> fieldNames;
+        fieldNames.push_back("status");
+        vector<BSONElement> fixed;
+        fixed.push_back(BSONElement());
+        BtreeKeyGeneratorV1 keyGen(fieldNames, fixed, false);
+
+        // The same low-cardinality value generated twice should come back as the
+        // same shared buffer, not a fresh allocation.
+        BSONObjSet firstKeys, secondKeys;
+        keyGen.getKeys(fromjson("{status: 'open', payload: 1}"), &firstKeys);
+        keyGen.getKeys(fromjson("{status: 'open', payload: 2}"), &secondKeys);
+        ASSERT_EQUALS(1U, firstKeys.size());
+        ASSERT_EQUALS(1U, secondKeys.size());
+        ASSERT_EQUALS(firstKeys.begin()->objdata(), secondKeys.begin()->objdata());
+
+        // A different value must still produce a different key.
+        BSONObjSet otherKeys;
+        keyGen.getKeys(fromjson("{status: 'closed'}"), &otherKeys);
+        ASSERT_EQUALS(1U, otherKeys.size());
+        ASSERT_EQUALS(0, otherKeys.begin()->woCompare(fromjson("{'': 'closed'}"), BSONObj(), false));
+    }
+
 } // namespace
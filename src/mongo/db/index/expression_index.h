@@ -28,15 +28,66 @@
 
 #pragma once
 
+#include <map>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/geo/hash.h"
 #include "mongo/db/geo/geoquery.h"
 #include "mongo/db/geo/r2_region_coverer.h"
 #include "mongo/db/hasher.h"
 #include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
+    /**
+     * Cache of computed S2 coverings, as the index intervals they turn into.
+     *
+     * Geofence-style workloads run the same few thousand query regions all day, and
+     * computing a covering for a polygon is pure recomputation after the first
+     * time.  Entries are keyed by the exact bytes of the query geometry plus the
+     * index's cell level parameters, so a hit can only ever return the covering
+     * that would have been computed fresh.
+     */
+    class S2CoveringCache {
+        MONGO_DISALLOW_COPYING(S2CoveringCache);
+    public:
+        S2CoveringCache() : _lock("S2CoveringCache") {}
+
+        bool lookup(const std::string& key, std::vector<Interval>* out) {
+            SimpleMutex::scoped_lock lk(_lock);
+            CoveringMap::const_iterator it = _map.find(key);
+            if (it == _map.end()) {
+                return false;
+            }
+            *out = it->second;
+            return true;
+        }
+
+        void add(const std::string& key, const std::vector<Interval>& intervals) {
+            SimpleMutex::scoped_lock lk(_lock);
+            if (_map.size() >= kMaxEntries) {
+                // bounds the footprint.  dumping everything is crude but cheap, and
+                // steady-state workloads repopulate with one recomputation per region.
+                _map.clear();
+            }
+            _map[key] = intervals;
+        }
+
+    private:
+        static const size_t kMaxEntries = 5000;
+
+        typedef std::map<std::string, std::vector<Interval> > CoveringMap;
+
+        SimpleMutex _lock;
+        CoveringMap _map;
+    };
+
+    inline S2CoveringCache& s2CoveringCache() {
+        static S2CoveringCache cache;
+        return cache;
+    }
+
     /**
      * Functions that compute expression index mappings.
      *
@@ -81,6 +132,36 @@ namespace mongo {
             }
         }
 
+        /**
+         * Like cover2dsphere, but consults the process-wide covering cache first.
+         * 'queryGeometry' must be the raw query object the region was parsed from;
+         * callers that compute regions on the fly (e.g. the 2dsphere near stage's
+         * shrinking annulus) should keep calling cover2dsphere directly.
+         */
+        static void cover2dsphereWithCache(const S2Region& region,
+                                           const BSONObj& queryGeometry,
+                                           const BSONObj& indexInfoObj,
+                                           OrderedIntervalList* oilOut) {
+            // the covering depends on both the geometry and the index's cell levels
+            std::string key;
+            key.reserve(queryGeometry.objsize() + indexInfoObj.objsize());
+            key.append(queryGeometry.objdata(), queryGeometry.objsize());
+            key.append(indexInfoObj.objdata(), indexInfoObj.objsize());
+
+            std::vector<Interval> cached;
+            if (s2CoveringCache().lookup(key, &cached)) {
+                oilOut->intervals.insert(oilOut->intervals.end(),
+                                         cached.begin(), cached.end());
+                return;
+            }
+
+            const size_t oldSize = oilOut->intervals.size();
+            cover2dsphere(region, indexInfoObj, oilOut);
+            s2CoveringCache().add(key,
+                                  std::vector<Interval>(oilOut->intervals.begin() + oldSize,
+                                                        oilOut->intervals.end()));
+        }
+
         // TODO: what should we really pass in for indexInfoObj?
         static void cover2dsphere(const S2Region& region,
                                   const BSONObj& indexInfoObj,
@@ -334,8 +334,9 @@ namespace mongo {
     long long int ExpressionKeysPrivate::makeSingleHashKey(const BSONElement& e,
                                                            HashSeed seed,
                                                            int v) {
-        massert(16767, "Only HashVersion 0 has been defined" , v == 0 );
-        return BSONElementHasher::hash64(e, seed);
+        massert(16767, "Only hashVersion 0 (md5) and 1 (murmur3) are defined",
+                v == 0 || v == 1);
+        return BSONElementHasher::hash64(e, seed, v);
     }
 
     // static
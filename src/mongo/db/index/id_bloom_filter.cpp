@@ -0,0 +1,137 @@
+// id_bloom_filter.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/index/id_bloom_filter.h"
+
+#include <third_party/murmurhash3/MurmurHash3.h>
+
+#include "mongo/db/structure/btree/key_string.h"
+
+namespace mongo {
+
+    namespace {
+        size_t roundUpToPowerOfTwo( size_t n ) {
+            size_t result = 1024;  // keeps tiny configs from being all collisions
+            while ( result < n )
+                result <<= 1;
+            return result;
+        }
+    }
+
+    IdBloomFilter::IdBloomFilter(const Ordering& ordering, size_t sizeBytes)
+        : _ordering(ordering),
+          _counters(roundUpToPowerOfTwo(sizeBytes), 0),
+          _mask(_counters.size() - 1),
+          _populated(false) {
+    }
+
+    void IdBloomFilter::invalidate() {
+        _populated = false;
+        // free the table too; an invalidated filter never answers again
+        std::vector<unsigned char>().swap(_counters);
+        _mask = 0;
+    }
+
+    bool IdBloomFilter::_slotsForKey(const BSONObj& key, size_t* slots) const {
+        if (_counters.empty())
+            return false;
+
+        KeyString ks;
+        if (!ks.reset(key, _ordering))
+            return false;
+
+        uint64_t hash[2];
+        MurmurHash3_x64_128(ks.data(), ks.size(), 0, hash);
+
+        // standard double hashing: k probes from two 64-bit hashes
+        for (int i = 0; i < kNumProbes; i++) {
+            slots[i] = static_cast<size_t>(hash[0] + i * hash[1]) & _mask;
+        }
+        return true;
+    }
+
+    void IdBloomFilter::insert(const BSONObj& key) {
+        if (!_populated)
+            return;
+
+        size_t slots[kNumProbes];
+        if (!_slotsForKey(key, slots))
+            return;
+
+        for (int i = 0; i < kNumProbes; i++) {
+            if (_counters[slots[i]] != 0xff)
+                _counters[slots[i]]++;
+        }
+    }
+
+    void IdBloomFilter::remove(const BSONObj& key) {
+        if (!_populated)
+            return;
+
+        size_t slots[kNumProbes];
+        if (!_slotsForKey(key, slots))
+            return;
+
+        for (int i = 0; i < kNumProbes; i++) {
+            // saturated counters are sticky; see class comment
+            if (_counters[slots[i]] != 0 && _counters[slots[i]] != 0xff)
+                _counters[slots[i]]--;
+        }
+    }
+
+    IdBloomFilter::CheckResult IdBloomFilter::check(const BSONObj& key) const {
+        if (!_populated)
+            return NotChecked;
+
+        size_t slots[kNumProbes];
+        if (!_slotsForKey(key, slots))
+            return NotChecked;
+
+        _lookups.fetchAndAdd(1);
+
+        for (int i = 0; i < kNumProbes; i++) {
+            if (_counters[slots[i]] == 0) {
+                _shortCircuited.fetchAndAdd(1);
+                return DefinitelyAbsent;
+            }
+        }
+        return MaybePresent;
+    }
+
+    void IdBloomFilter::appendStats(BSONObjBuilder& b) const {
+        b.append("populated", _populated);
+        b.appendNumber("sizeBytes", static_cast<long long>(_counters.size()));
+        b.append("probesPerLookup", kNumProbes);
+        b.appendNumber("lookups", _lookups.load());
+        b.appendNumber("shortCircuited", _shortCircuited.load());
+        b.appendNumber("falsePositives", _falsePositives.load());
+    }
+
+}  // namespace mongo
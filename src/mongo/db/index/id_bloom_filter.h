@@ -0,0 +1,122 @@
+// id_bloom_filter.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/ordering.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Counting bloom filter over the keys of an _id index.  Consulted by
+     * BtreeBasedAccessMethod::findSingle so that most negative point lookups
+     * are answered by a few cache-resident probes instead of a btree descent;
+     * dedup-on-insert workloads issue mostly negative lookups.
+     *
+     * The filter only gives definite answers once it is "populated", i.e. it
+     * has seen every key currently in the index.  That is the case for
+     * indexes created empty in this process; a filter that never became
+     * populated (index opened with existing data, or filled by a bulk build)
+     * answers NotChecked and costs nothing but its memory.
+     *
+     * Keys are canonicalized through their KeyString encoding before hashing
+     * so that keys that are woCompare-equal (e.g. 42 and 42.0) hash
+     * identically.  Keys with no KeyString encoding are never filtered, in
+     * either direction, so they stay correct without being counted.
+     *
+     * Counters saturate at 255 and are then never decremented; a saturated
+     * counter can only cause false positives, never a false "absent".
+     *
+     * Mutation happens under the database write lock like the btree it
+     * shadows; only the statistics counters may be hit concurrently (by
+     * readers) and those are atomic.
+     */
+    class IdBloomFilter {
+        MONGO_DISALLOW_COPYING(IdBloomFilter);
+    public:
+        enum CheckResult {
+            NotChecked,        // filter can't speak for this key; descend
+            MaybePresent,      // probably there; descend
+            DefinitelyAbsent   // no descent needed
+        };
+
+        /**
+         * 'sizeBytes' is rounded up to a power of two; one byte per counter.
+         */
+        IdBloomFilter(const Ordering& ordering, size_t sizeBytes);
+
+        bool isPopulated() const { return _populated; }
+
+        /**
+         * Marks the filter as covering the index.  Only valid when the index
+         * is empty (e.g. right after initializeAsEmpty).
+         */
+        void markPopulated() { _populated = true; }
+
+        /**
+         * Permanently stops the filter from answering; used when keys enter
+         * the index through a path that does not maintain it (bulk build).
+         */
+        void invalidate();
+
+        void insert(const BSONObj& key);
+        void remove(const BSONObj& key);
+
+        CheckResult check(const BSONObj& key) const;
+
+        /**
+         * The caller descended after MaybePresent and found nothing.
+         */
+        void noteFalsePositive() const { _falsePositives.fetchAndAdd(1); }
+
+        void appendStats(BSONObjBuilder& b) const;
+
+    private:
+        static const int kNumProbes = 4;
+
+        // Returns false (and leaves 'slots' alone) for unencodable keys.
+        bool _slotsForKey(const BSONObj& key, size_t* slots) const;
+
+        const Ordering _ordering;
+        std::vector<unsigned char> _counters;
+        size_t _mask;
+        bool _populated;
+
+        mutable AtomicInt64 _lookups;         // check() calls that got a real answer
+        mutable AtomicInt64 _shortCircuited;  // of those, answered DefinitelyAbsent
+        mutable AtomicInt64 _falsePositives;
+    };
+
+}  // namespace mongo
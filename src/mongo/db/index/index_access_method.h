@@ -71,7 +71,31 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted) = 0;
 
-        /** 
+        /**
+         * Computes the keys 'obj' contributes to this index, for callers that batch and sort
+         * keys across documents before applying them (see IndexCatalog::indexRecords()).
+         * Returns false if this access method does not support per-key application; such
+         * indexes are maintained document-at-a-time through insert().
+         */
+        virtual bool getKeysForBatch( const BSONObj& obj, BSONObjSet* keys ) {
+            return false;
+        }
+
+        /**
+         * Inserts one key produced by getKeysForBatch().  Key-too-long and background-build
+         * duplicate handling matches insert(); '*numInserted' is incremented only when a key
+         * actually went into the tree.
+         */
+        virtual Status insertKey(OperationContext* txn,
+                                 const BSONObj& key,
+                                 const DiskLoc& loc,
+                                 const InsertDeleteOptions& options,
+                                 int64_t* numInserted) {
+            return Status( ErrorCodes::InternalError,
+                           "insertKey not supported by this access method" );
+        }
+
+        /**
          * Analogous to above, but remove the records instead of inserting them.  If not NULL,
          * numDeleted will be set to the number of keys removed from the index for the document.
          */
@@ -138,6 +162,17 @@ namespace mongo {
          */
         virtual Status touch( OperationContext* txn ) const = 0;
 
+        /**
+         * Appends the memory regions of the index's non-leaf btree levels to
+         * 'regions' as (address, length) pairs, up to 'maxBytes' in total, returning
+         * the number of bytes appended.  Used by the index pinning job (see
+         * db/index_pin.cpp); access methods without such a structure may return 0.
+         */
+        virtual long long nonLeafRegions(std::vector< std::pair<void*, unsigned> >* regions,
+                                         long long maxBytes) const {
+            return 0;
+        }
+
         /**
          * Walk the entire index, checking the internal structure for consistency.
          * Set numKeys to the number of keys in the index.
@@ -149,6 +184,17 @@ namespace mongo {
          */
         virtual Status validate(int64_t* numKeys) = 0;
 
+        /**
+         * Cheaply estimates what fraction of this index's keys lie between 'startKey'
+         * and 'endKey' (both full index keys).  Returns a value in [0, 1], or -1 when
+         * this access method cannot provide an estimate.  Used by plan ranking to
+         * discard obviously inferior candidates before any trial execution.
+         */
+        virtual double estimateRangeFraction(const BSONObj& startKey,
+                                             const BSONObj& endKey) const {
+            return -1;
+        }
+
         //
         // Bulk operations support
         //
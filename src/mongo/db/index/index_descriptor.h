@@ -69,6 +69,7 @@ namespace mongo {
               _sparse(infoObj["sparse"].trueValue()),
               _dropDups(infoObj["dropDups"].trueValue()),
               _unique( _isIdIndex || infoObj["unique"].trueValue() ),
+              _partial( !infoObj["partialFilterExpression"].eoo() ),
               _cachedEntry( NULL )
         {
             _indexNamespace = makeIndexNamespace( _parentNS, _indexName );
@@ -78,6 +79,17 @@ namespace mongo {
             if ( e.isNumber() ) {
                 _version = e.numberInt();
             }
+
+            // btree right-edge split behavior; see BtreeLogic::splitPos
+            _fillFactor = 90;
+            e = _infoObj["fillFactor"];
+            if ( e.isNumber() ) {
+                _fillFactor = e.numberInt();
+                if ( _fillFactor < 50 )
+                    _fillFactor = 50;
+                else if ( _fillFactor > 99 )
+                    _fillFactor = 99;
+            }
         }
 
         ~IndexDescriptor() {
@@ -130,11 +142,26 @@ namespace mongo {
         // Is this index sparse?
         bool isSparse() const { return _sparse; }
 
+        // Is this a partial index? (i.e. does it have a partialFilterExpression)
+        bool isPartial() const { return _partial; }
+
+        // The filter a document must match to be included in this index.  Only
+        // meaningful when isPartial().
+        BSONObj partialFilterExpression() const {
+            return _infoObj.getObjectField("partialFilterExpression");
+        }
+
         // Is this index multikey?
         bool isMultikey() const { _checkOk(); return _collection->getIndexCatalog()->isMultikey( this ); }
 
         bool isIdIndex() const { _checkOk(); return _isIdIndex; }
 
+        // Percentage of a btree bucket kept on the left when splitting at the high end
+        // of the key range.  Append-only workloads (ObjectId or timestamp keys) can
+        // raise this toward 99 so right-edge buckets are left nearly full.  Defaults
+        // to 90, the historical right-edge split.
+        int fillFactor() const { return _fillFactor; }
+
         //
         // Properties that are Index-specific.
         //
@@ -207,7 +234,9 @@ namespace mongo {
         bool _sparse;
         bool _dropDups;
         bool _unique;
+        bool _partial;
         int _version;
+        int _fillFactor;
 
         // only used by IndexCatalogEntryContainer to do caching for perf
         // users not allowed to touch, and not part of API
@@ -0,0 +1,254 @@
+// index_pin.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/index_pin.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
+#include "mongo/util/mmap.h"
+
+namespace mongo {
+
+    // total mlock budget for pinned index levels; 0 disables pinning entirely
+    MONGO_EXPORT_SERVER_PARAMETER( indexPinMaxMB, int, 0 );
+
+    // how often the pinning job re-walks the designated indexes so new buckets
+    // (splits, new collections) get covered and dropped ones released
+    MONGO_EXPORT_SERVER_PARAMETER( indexPinRefreshSecs, int, 300 );
+
+    // residency actually achieved by the last pass, for the serverStatus report
+    static AtomicInt64 indexPinPinnedBytes;
+    static AtomicInt64 indexPinPinnedBuckets;
+    static AtomicInt64 indexPinPinnedIndexes;
+    static AtomicInt64 indexPinFailedRegions;
+
+    class IndexPinServerStatusSection : public ServerStatusSection {
+    public:
+        IndexPinServerStatusSection() : ServerStatusSection( "indexPin" ){}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection( const BSONElement& configElement ) const {
+            if ( indexPinMaxMB <= 0 && indexPinPinnedBytes.load() == 0 ) {
+                // pinning disabled and nothing held: stay out of serverStatus
+                return BSONObj();
+            }
+            BSONObjBuilder b;
+            b.appendNumber( "pinnedBytes", indexPinPinnedBytes.load() );
+            b.appendNumber( "pinnedBuckets", indexPinPinnedBuckets.load() );
+            b.appendNumber( "pinnedIndexes", indexPinPinnedIndexes.load() );
+            b.appendNumber( "failedRegions", indexPinFailedRegions.load() );
+            return b.obj();
+        }
+
+    } indexPinServerStatusSection;
+
+    /**
+     * Keeps the non-leaf btree levels of designated indexes mlocked so that a point
+     * lookup faults at most once (on the leaf) no matter what scans push through the
+     * cache.  The _id index of every collection is always designated; other indexes
+     * opt in with { pinned: true } in their spec.  Each pass re-walks the designated
+     * indexes under a low-priority database read lock and replaces the previous
+     * pass's pins, so splits get covered and dropped indexes released within a
+     * refresh period.  Pinning is advisory: mlock failures are counted, not fatal.
+     */
+    class IndexPinJob : public BackgroundJob {
+    public:
+        IndexPinJob() : _budget(0), _bytes(0), _buckets(0), _indexes(0), _failed(0) {}
+        virtual ~IndexPinJob() {}
+
+        virtual string name() const { return "IndexPin"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            // let the rest of startup get going before taking read locks everywhere
+            sleepsecs( 10 );
+
+            while ( !inShutdown() ) {
+                try {
+                    pass();
+                }
+                catch ( DBException& e ) {
+                    error() << "index pin: error during pass: " << e << endl;
+                }
+
+                const int secs = indexPinRefreshSecs;
+                sleepsecs( secs < 1 ? 1 : secs );
+            }
+
+            cc().shutdown();
+        }
+
+    private:
+        void pass() {
+            if ( indexPinMaxMB <= 0 ) {
+                if ( !_pins.empty() ) {
+                    _pins.clear();
+                    publish( 0, 0, 0, 0 );
+                }
+                return;
+            }
+
+            // drop the previous pass's pins before re-pinning: mlock does not nest,
+            // so pinning a page again and then releasing the old pin would leave it
+            // unpinned.  the unpinned window is brief, and a pin gone stale (its
+            // file closed or remapped) is released here no more than a refresh
+            // period after it went stale.
+            _pins.clear();
+
+            _budget = static_cast<long long>( indexPinMaxMB ) * 1024 * 1024;
+            _bytes = _buckets = _indexes = _failed = 0;
+
+            set<string> dbs;
+            {
+                OperationContextImpl txn;   // XXX?
+                Lock::DBRead lk(txn.lockState(), "local");
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            for ( set<string>::const_iterator i = dbs.begin();
+                  i != dbs.end() && !inShutdown() && _budget > 0; ++i ) {
+                try {
+                    passDB( *i );
+                }
+                catch ( DBException& e ) {
+                    error() << "index pin: error pinning db: " << *i << " " << e << endl;
+                }
+            }
+
+            publish( _bytes, _buckets, _indexes, _failed );
+
+            LOG(1) << "index pin: pass done, " << _bytes << " bytes in " << _buckets
+                   << " buckets over " << _indexes << " indexes, "
+                   << _failed << " regions failed" << endl;
+        }
+
+        void passDB( const string& dbName ) {
+            vector<BSONObj> specs;
+            {
+                auto_ptr<DBClientCursor> cursor =
+                                db.query( dbName + ".system.indexes", BSONObj() );
+                if ( cursor.get() ) {
+                    while ( cursor->more() ) {
+                        specs.push_back( cursor->next().getOwned() );
+                    }
+                }
+            }
+
+            for ( unsigned i = 0;
+                  i < specs.size() && !inShutdown() && _budget > 0; i++ ) {
+                // the _id index is always designated; others opt in via their spec
+                if ( specs[i]["name"].String() != "_id_" &&
+                     !specs[i]["pinned"].trueValue() )
+                    continue;
+                try {
+                    pinIndex( specs[i]["ns"].String(), specs[i]["name"].String() );
+                }
+                catch ( DBException& e ) {
+                    error() << "index pin: error pinning index: " << specs[i]
+                            << " " << e << endl;
+                }
+            }
+        }
+
+        void pinIndex( const string& ns, const string& indexName ) {
+            OperationContextImpl txn;
+
+            // compete only for the low-priority slice of the read ticket pool
+            Lock::ScopedAdmissionPriority lowPriority( txn.lockState(), -1 );
+
+            Client::ReadContext ctx( &txn, ns );
+            Collection* collection = ctx.ctx().db()->getCollection( &txn, ns );
+            if ( !collection ) {
+                // collection was dropped
+                return;
+            }
+
+            IndexDescriptor* desc =
+                collection->getIndexCatalog()->findIndexByName( indexName );
+            if ( !desc ) {
+                // index was dropped or isn't finished yet
+                return;
+            }
+            IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( desc );
+
+            vector< std::pair<void*, unsigned> > regions;
+            iam->nonLeafRegions( &regions, _budget );
+
+            for ( unsigned i = 0; i < regions.size(); i++ ) {
+                boost::shared_ptr<MemoryPin> pin(
+                        new MemoryPin( regions[i].first, regions[i].second ) );
+                if ( pin->active() ) {
+                    _pins.push_back( pin );
+                    _budget -= regions[i].second;
+                    _bytes += regions[i].second;
+                    _buckets++;
+                }
+                else {
+                    _failed++;
+                }
+            }
+            _indexes++;
+        }
+
+        static void publish( long long bytes, long long buckets,
+                             long long indexes, long long failed ) {
+            indexPinPinnedBytes.store( bytes );
+            indexPinPinnedBuckets.store( buckets );
+            indexPinPinnedIndexes.store( indexes );
+            indexPinFailedRegions.store( failed );
+        }
+
+        DBDirectClient db;
+        std::vector< boost::shared_ptr<MemoryPin> > _pins;
+        long long _budget;
+        long long _bytes;
+        long long _buckets;
+        long long _indexes;
+        long long _failed;
+    };
+
+    void startIndexPinJob() {
+        IndexPinJob* job = new IndexPinJob();
+        job->go();
+    }
+}
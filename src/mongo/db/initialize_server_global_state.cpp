@@ -45,6 +45,7 @@
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/security_key.h"
 #include "mongo/db/server_options.h"
+#include "mongo/logger/async_message_appender.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/message_event.h"
@@ -272,10 +273,16 @@ namespace mongo {
 
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
-            manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+            MessageLogDomain::AppenderAutoPtr globalAppender(
+                    new RotatableFileAppender<MessageEventEphemeral>(
+                            new MessageEventDetailsEncoder, writer.getValue()));
+            if (serverGlobalParams.logAsync) {
+                // Move encoding and file writes off the logging threads onto a
+                // background drain thread.
+                globalAppender.reset(
+                        new logger::AsyncMessageAppender(globalAppender.release()));
+            }
+            manager->getGlobalDomain()->attachAppender(globalAppender);
             manager->getNamedDomain("javascriptOutput")->attachAppender(
                     MessageLogDomain::AppenderAutoPtr(
                             new RotatableFileAppender<MessageEventEphemeral>(
@@ -46,6 +46,9 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
@@ -70,11 +73,14 @@
 #include "mongo/db/ops/delete_executor.h"
 #include "mongo/db/ops/delete_request.h"
 #include "mongo/db/ops/insert.h"
+#include "mongo/db/ops/update.h"
 #include "mongo/db/ops/update_lifecycle_impl.h"
 #include "mongo/db/ops/update_driver.h"
 #include "mongo/db/ops/update_executor.h"
 #include "mongo/db/ops/update_request.h"
+#include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/new_find.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/stats/counters.h"
@@ -131,26 +137,29 @@ namespace mongo {
         }
         else {
             bool all = q.query["$all"].trueValue();
-            vector<BSONObj> vals;
+            BSONObj filter;
             {
-                BSONObj filter;
-                {
-                    BSONObjBuilder b;
-                    BSONObjIterator i( q.query );
-                    while ( i.more() ) {
-                        BSONElement e = i.next();
-                        if ( str::equals( "$all", e.fieldName() ) )
-                            continue;
-                        b.append( e );
-                    }
-                    filter = b.obj();
+                BSONObjBuilder b;
+                BSONObjIterator i( q.query );
+                while ( i.more() ) {
+                    BSONElement e = i.next();
+                    if ( str::equals( "$all", e.fieldName() ) )
+                        continue;
+                    b.append( e );
                 }
+                filter = b.obj();
+            }
 
-                const NamespaceString nss(d.getns());
+            const NamespaceString nss(d.getns());
 
+            // snapshot the ops while holding clientsMutex, but keep that critical
+            // section to plain in-memory serialization.  filter matching can run
+            // $where javascript and is done on the snapshots afterwards, so op
+            // transitions and new connections aren't stalled behind it.
+            vector<BSONObj> infos;
+            {
                 Client& me = cc();
                 scoped_lock bl(Client::clientsMutex);
-                Matcher m(filter, WhereCallbackReal(nss.db()));
                 for( set<Client*>::iterator i = Client::clients.begin(); i != Client::clients.end(); i++ ) {
                     Client *c = *i;
                     verify( c );
@@ -162,14 +171,18 @@ namespace mongo {
                     if( all || co->displayInCurop() ) {
                         BSONObjBuilder infoBuilder;
                         co->reportState(&infoBuilder);
-
-                        const BSONObj info = infoBuilder.obj();
-                        if ( all || m.matches( info )) {
-                            vals.push_back( info );
-                        }
+                        infos.push_back( infoBuilder.obj() );
                     }
                 }
             }
+
+            vector<BSONObj> vals;
+            Matcher matcher(filter, WhereCallbackReal(nss.db()));
+            for( size_t i = 0; i < infos.size(); i++ ) {
+                if ( all || matcher.matches( infos[i] ) ) {
+                    vals.push_back( infos[i] );
+                }
+            }
             b.append("inprog", vals);
             if( lockedForWriting() ) {
                 b.append("fsyncLock", true);
@@ -246,6 +259,13 @@ namespace mongo {
 
         CurOp& op = *(c.curop());
 
+        // The low priority flag covers the whole operation -- admission ticket,
+        // lock acquisition, and the priority-aware yield checks while it runs.
+        scoped_ptr<Lock::ScopedAdmissionPriority> admissionPriority;
+        if (q.queryOptions & QueryOption_LowPriority) {
+            admissionPriority.reset(new Lock::ScopedAdmissionPriority(txn->lockState(), -1));
+        }
+
         scoped_ptr<AssertionException> ex;
 
         try {
@@ -349,6 +369,11 @@ namespace mongo {
 
             // We should not be holding any locks at this point
             invariant(!txn->lockState()->isLocked());
+
+            // the previous operation's reply has been sent by now; reclaim its
+            // arena memory.  god (DBDirectClient) requests run inside another
+            // operation and must not reset that operation's arena.
+            c.arena().reset();
         }
 
         if ( op == dbQuery ) {
@@ -498,6 +523,7 @@ namespace mongo {
         currentOp.ensureStarted();
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
+        globalOpLatencyHistograms.record( op, debug.iscommand, currentOp.totalTimeMicros() );
 
         logThreshold += currentOp.getExpectedLatencyMs();
 
@@ -518,6 +544,7 @@ namespace mongo {
             }
         }
 
+        currentOp.recordFaults();
         debug.recordStats();
         debug.reset();
     } /* assembleResponse() */
@@ -608,19 +635,32 @@ namespace mongo {
         UpdateExecutor executor(&request, &op.debug());
         uassertStatusOK(executor.prepare());
 
-        Lock::DBWrite lk(txn->lockState(), ns.ns(), useExperimentalDocLocking);
+        // with the experimental doc-locking mode we first try under an intent lock;
+        // updates that need a document move, index update or insert tell us to retry
+        // with the exclusive lock
+        bool intentLock = useExperimentalDocLocking;
+        while ( 1 ) {
+            try {
+                Lock::DBWrite lk(txn->lockState(), ns.ns(), intentLock);
 
-        // if this ever moves to outside of lock, need to adjust check
-        // Client::Context::_finishInit
-        if ( ! broadcast && handlePossibleShardedMessage( m , 0 ) )
-            return;
+                // if this ever moves to outside of lock, need to adjust check
+                // Client::Context::_finishInit
+                if ( ! broadcast && handlePossibleShardedMessage( m , 0 ) )
+                    return;
 
-        Client::Context ctx( ns );
+                Client::Context ctx( ns );
 
-        UpdateResult res = executor.execute(txn, ctx.db());
+                UpdateResult res = executor.execute(txn, ctx.db());
 
-        // for getlasterror
-        lastError.getSafe()->recordUpdate( res.existing , res.numMatched , res.upserted );
+                // for getlasterror
+                lastError.getSafe()->recordUpdate( res.existing , res.numMatched , res.upserted );
+                break;
+            }
+            catch ( const UpdateNeedsExclusiveLockException& ) {
+                dassert( intentLock );
+                intentLock = false;
+            }
+        }
     }
 
     void receivedDelete(OperationContext* txn, Message& m, CurOp& op) {
@@ -680,8 +720,11 @@ namespace mongo {
         scoped_ptr<Timer> timer;
         int pass = 0;
         bool exhaust = false;
-        QueryResult* msgdata = 0;
+        bool hasReply = false;
+        auto_ptr<Message> resp(new Message());
         OpTime last;
+        const bool tailingOplog = str::startsWith(ns, "local.oplog.");
+        unsigned long long cappedInsertVersion = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -693,6 +736,13 @@ namespace mongo {
                 audit::logGetMoreAuthzCheck(&cc(), nsString, cursorid, status.code());
                 uassertStatusOK(status);
 
+                if (!tailingOplog) {
+                    // Snapshot the capped insert version before running the query so an
+                    // insert landing between an empty read and the wait below still wakes
+                    // us.  The oplog path has its own optime-based wait.
+                    cappedInsertVersion = CappedInsertNotifier::insertVersion(ns);
+                }
+
                 if (str::startsWith(ns, "local.oplog.")){
                     while (MONGO_FAIL_POINT(rsStopGetMore)) {
                         sleepmillis(0);
@@ -706,14 +756,15 @@ namespace mongo {
                     }
                 }
 
-                msgdata = newGetMore(txn,
-                                     ns,
-                                     ntoreturn,
-                                     cursorid,
-                                     curop,
-                                     pass,
-                                     exhaust,
-                                     &isCursorAuthorized);
+                hasReply = newGetMore(txn,
+                                      ns,
+                                      ntoreturn,
+                                      cursorid,
+                                      curop,
+                                      pass,
+                                      exhaust,
+                                      &isCursorAuthorized,
+                                      *resp);
             }
             catch ( AssertionException& e ) {
                 if ( isCursorAuthorized ) {
@@ -729,7 +780,7 @@ namespace mongo {
                 break;
             }
             
-            if (msgdata == 0) {
+            if (!hasReply) {
                 // this should only happen with QueryOption_AwaitData
                 exhaust = false;
                 massert(13073, "shutting down", !inShutdown() );
@@ -744,15 +795,24 @@ namespace mongo {
                     }
                 }
                 pass++;
-                if (debug)
-                    sleepmillis(20);
-                else
-                    sleepmillis(2);
-                
+                if (tailingOplog) {
+                    // The oplog path already blocked in waitForOptimeChange above.
+                    if (debug)
+                        sleepmillis(20);
+                    else
+                        sleepmillis(2);
+                }
+                else {
+                    // Block until the next insert into the capped collection (or a
+                    // timeout, so interrupt/shutdown still get noticed) instead of
+                    // poll-sleeping.  The inserting thread wakes us.
+                    CappedInsertNotifier::waitForInsert(ns, cappedInsertVersion, 1000);
+                }
+
                 // note: the 1100 is beacuse of the waitForDifferent above
                 // should eventually clean this up a bit
                 curop.setExpectedLatencyMs( 1100 + timer->millis() );
-                
+
                 continue;
             }
             break;
@@ -771,12 +831,10 @@ namespace mongo {
             return ok;
         }
 
-        Message *resp = new Message();
-        resp->setData(msgdata, true);
         curop.debug().responseLength = resp->header()->dataLen();
-        curop.debug().nreturned = msgdata->nReturned;
+        curop.debug().nreturned = static_cast<QueryResult*>(resp->header())->nReturned;
 
-        dbresponse.response = resp;
+        dbresponse.response = resp.release();
         dbresponse.responseTo = m.header()->id;
         
         if( exhaust ) {
@@ -842,22 +900,101 @@ namespace mongo {
                                    const char *ns,
                                    vector<BSONObj>& objs,
                                    CurOp& op) {
-        size_t i;
-        for (i=0; i<objs.size(); i++){
-            try {
-                checkAndInsert(txn, ctx, ns, objs[i]);
-                txn->recoveryUnit()->commitIfNeeded();
-            } catch (const UserException&) {
-                if (!keepGoing || i == objs.size()-1){
-                    globalOpCounters.incInsertInWriteLock(i);
-                    throw;
+        // system.indexes inserts are index builds, and capped collections interleave
+        // deletes with inserts; both stay on the document-at-a-time path.
+        Collection* collection = NULL;
+        if ( nsToCollectionSubstring( ns ) != "system.indexes" ) {
+            collection = ctx.db()->getCollection( txn, ns );
+            if ( !collection ) {
+                collection = ctx.db()->createCollection( txn, ns );
+                verify( collection );
+            }
+        }
+
+        if ( !collection || collection->isCapped() ) {
+            size_t i;
+            for (i=0; i<objs.size(); i++){
+                try {
+                    checkAndInsert(txn, ctx, ns, objs[i]);
+                    txn->recoveryUnit()->commitIfNeeded();
+                } catch (const UserException&) {
+                    if (!keepGoing || i == objs.size()-1){
+                        globalOpCounters.incInsertInWriteLock(i);
+                        throw;
+                    }
+                    // otherwise ignore and keep going
+                }
+            }
+
+            globalOpCounters.incInsertInWriteLock(i);
+            op.debug().ninserted = i;
+            return;
+        }
+
+        // Normalize the documents up front, then hand the whole batch to the collection
+        // so index maintenance can be done batch-at-a-time.
+        Status firstError = Status::OK();
+        size_t numBeforeError = objs.size(); // docs counted when we throw firstError
+
+        vector<BSONObj> docs;
+        docs.reserve( objs.size() );
+        bool lastObjInDocs = false;
+        for ( size_t i = 0; i < objs.size(); i++ ) {
+            StatusWith<BSONObj> fixed = fixDocumentForInsert( objs[i] );
+            if ( !fixed.getStatus().isOK() ) {
+                if ( !keepGoing ) {
+                    // docs before the bad one still get inserted, as before
+                    firstError = fixed.getStatus();
+                    numBeforeError = i;
+                    break;
                 }
-                // otherwise ignore and keep going
+                if ( i == objs.size() - 1 )
+                    firstError = fixed.getStatus();
+                continue;
             }
+            if ( !fixed.getValue().isEmpty() )
+                objs[i] = fixed.getValue();
+            docs.push_back( objs[i] );
+            lastObjInDocs = ( i == objs.size() - 1 );
         }
 
-        globalOpCounters.incInsertInWriteLock(i);
-        op.debug().ninserted = i;
+        if ( !docs.empty() ) {
+            vector< StatusWith<DiskLoc> > results;
+            collection->insertDocuments( txn, docs, true, &results );
+
+            for ( size_t i = 0; i < docs.size(); i++ ) {
+                if ( !results[i].isOK() ) {
+                    if ( !keepGoing ) {
+                        firstError = results[i].getStatus();
+                        numBeforeError = i;
+                        // stopping at the error means later documents come back out
+                        for ( size_t j = i + 1; j < docs.size(); j++ ) {
+                            if ( results[j].isOK() )
+                                collection->deleteDocument( txn, results[j].getValue(),
+                                                            false, true );
+                        }
+                        break;
+                    }
+                    if ( i == docs.size() - 1 && lastObjInDocs )
+                        firstError = results[i].getStatus();
+                    continue;
+                }
+                repl::logOp(txn, "i", ns, docs[i]);
+            }
+        }
+
+        txn->recoveryUnit()->commitIfNeeded();
+
+        if ( !firstError.isOK() ) {
+            // matches the single-document path: an error on the last document is
+            // reported even with ContinueOnError
+            globalOpCounters.incInsertInWriteLock(
+                keepGoing ? objs.size() - 1 : numBeforeError );
+            uassertStatusOK( firstError );
+        }
+
+        globalOpCounters.incInsertInWriteLock(objs.size());
+        op.debug().ninserted = objs.size();
     }
 
     void receivedInsert(OperationContext* txn, Message& m, CurOp& op) {
@@ -989,6 +1126,81 @@ namespace {
         //throw UserException( (string)"yay:" + ns );
     }
 
+    unsigned long long DBDirectClient::query( stdx::function<void(const BSONObj&)> f,
+                                              const string& ns,
+                                              Query query,
+                                              const BSONObj* fieldsToReturn,
+                                              int queryOptions ) {
+
+        // Options that change wire-protocol behavior, and the oplog start hack, only
+        // exist on the message path (exhaust is already masked off by
+        // _lookupAvailableOptions()).
+        const int unsupportedOptions = QueryOption_CursorTailable
+                                     | QueryOption_OplogReplay
+                                     | QueryOption_AwaitData
+                                     | QueryOption_PartialResults;
+
+        const NamespaceString nss( ns );
+
+        bool direct = nss.isValid() && !nss.isCommand() && !nss.isSpecial() &&
+                      !( queryOptions & unsupportedOptions );
+
+        // Of the wrapped forms we only execute {$query, $orderby} directly; $explain,
+        // $hint, $snapshot, $maxScan, ... keep the full runQuery treatment.
+        bool hasDollar = false;
+        if ( direct && query.isComplex( &hasDollar ) ) {
+            BSONObjIterator it( query.obj );
+            while ( it.more() ) {
+                const char* name = it.next().fieldName();
+                if ( !str::equals( name, hasDollar ? "$query" : "query" ) &&
+                     !str::equals( name, hasDollar ? "$orderby" : "orderby" ) ) {
+                    direct = false;
+                    break;
+                }
+            }
+        }
+
+        if ( !direct ) {
+            return DBClientBase::query( f, ns, query, fieldsToReturn, queryOptions );
+        }
+
+        GodScope gs;
+        Client::ReadContext ctx( _txn, ns );
+        Collection* collection = ctx.ctx().db()->getCollection( _txn, ns );
+        if ( !collection ) {
+            return 0;
+        }
+
+        CanonicalQuery* cq;
+        const WhereCallbackReal whereCallback( nss.db() );
+        if ( !CanonicalQuery::canonicalize( ns,
+                                            query.getFilter(),
+                                            query.getSort(),
+                                            fieldsToReturn ? *fieldsToReturn : BSONObj(),
+                                            &cq,
+                                            whereCallback ).isOK() ) {
+            // let the message path produce the error the caller expects
+            return DBClientBase::query( f, ns, query, fieldsToReturn, queryOptions );
+        }
+
+        Runner* rawRunner;
+        if ( !getRunner( collection, cq, &rawRunner ).isOK() ) {
+            return DBClientBase::query( f, ns, query, fieldsToReturn, queryOptions );
+        }
+        auto_ptr<Runner> runner( rawRunner );
+
+        unsigned long long n = 0;
+        BSONObj obj;
+        while ( Runner::RUNNER_ADVANCED == runner->getNext( &obj, NULL ) ) {
+            // as on the cursor path, the object is only valid for the duration of the
+            // callback; consumers that keep it call getOwned()
+            f( obj );
+            n++;
+        }
+
+        return n;
+    }
+
     void DBDirectClient::killCursor( long long id ) {
         // The killCursor command on the DB client is only used by sharding,
         // so no need to have it for MongoD.
@@ -1038,6 +1250,18 @@ namespace {
         log() << "shutdown: going to flush diaglog..." << endl;
         _diaglog.flush();
 
+        if (internalQueryCachePersistenceEnabled) {
+            log() << "shutdown: saving plan caches..." << endl;
+            set<string> dbNames;
+            dbHolder().getAllShortNames(dbNames);
+            for (set<string>::const_iterator it = dbNames.begin(); it != dbNames.end(); ++it) {
+                Database* db = dbHolder().get(txn, *it);
+                if (NULL != db) {
+                    db->savePlanCaches();
+                }
+            }
+        }
+
         /* must do this before unmapping mem or you may get a seg fault */
         log() << "shutdown: going to close sockets..." << endl;
         boost::thread close_socket_thread( stdx::bind(MessagingPort::closeAllSockets, 0) );
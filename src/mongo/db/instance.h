@@ -101,6 +101,22 @@ namespace mongo {
         virtual std::auto_ptr<DBClientCursor> query(const std::string &ns, Query query, int nToReturn = 0, int nToSkip = 0,
                                                const BSONObj *fieldsToReturn = 0, int queryOptions = 0, int batchSize = 0);
 
+        /**
+         * In-process fast path for the callback form of query(): parses the request
+         * into a CanonicalQuery and drains a Runner (see get_runner.h) directly,
+         * skipping the OP_QUERY Message encode / reply decode round-trip the cursor
+         * forms pay.  Shapes the direct path doesn't implement (commands, tailable /
+         * oplog-replay options, $-modifiers other than $orderby) transparently fall
+         * back to the message path, so callers see identical behavior.  Like other
+         * internal helpers, the direct path is not profiled and does not bump
+         * opcounters.
+         */
+        virtual unsigned long long query( stdx::function<void(const BSONObj&)> f,
+                                          const std::string& ns,
+                                          Query query,
+                                          const BSONObj *fieldsToReturn = 0,
+                                          int queryOptions = 0 );
+
         virtual bool isFailed() const {
             return false;
         }
@@ -30,16 +30,23 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_set.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
 #include "mongo/util/goodies.h"
 
 namespace {
@@ -78,14 +85,21 @@ namespace {
     }
 } // namespace
 
-    static void _profile(OperationContext* txn,
-                         const Client& c,
-                         Database* db,
-                         CurOp& currentOp,
-                         BufBuilder& profileBufBuilder) {
-        dassert( db );
-
-        // build object
+    // When set, profile documents are built on the op's path but handed to a
+    // background thread for the locked insert into system.profile.  Entries become
+    // visible slightly after the op finishes and may be shed under sustained
+    // overload, so this stays off by default.
+    MONGO_EXPORT_SERVER_PARAMETER(profileAsyncWrites, bool, false);
+
+    static Counter64 profileWritesDropped;
+    static ServerStatusMetricField<Counter64> displayProfileWritesDropped(
+            "profiler.writesDropped", &profileWritesDropped );
+
+    /** build the system.profile document for the op.  pure in-memory work; needs no
+        locks.  the returned object points into profileBufBuilder. */
+    static BSONObj _buildProfileDoc(const Client& c,
+                                    CurOp& currentOp,
+                                    BufBuilder& profileBufBuilder) {
         BSONObjBuilder b(profileBufBuilder);
 
         const bool isQueryObjTooBig = !currentOp.debug().append(currentOp, b,
@@ -120,32 +134,207 @@ namespace {
             p = b.done();
         }
 
-        // write: not replicated
-        // get or create the profiling collection
-        Collection* profileCollection = getOrCreateProfileCollection(txn, db);
-        if ( profileCollection ) {
-            profileCollection->insertDocument( txn, p, false );
+        return p;
+    }
+
+    /** take the locks and insert the already-built profile document.
+        write: not replicated */
+    static void _writeProfileDoc(OperationContext* txn, const string& ns, const BSONObj& p) {
+        Lock::DBWrite lk(txn->lockState(), ns);
+        if (dbHolder().get(txn, nsToDatabase(ns)) != NULL) {
+            Client::Context cx(ns, false);
+            Collection* profileCollection = getOrCreateProfileCollection(txn, cx.db());
+            if ( profileCollection ) {
+                profileCollection->insertDocument( txn, p, false );
+            }
+        }
+        else {
+            mongo::log() << "note: not profiling because db went away - probably a close on: "
+                         << ns << endl;
         }
     }
 
+namespace {
+
+    /** one queued profile document; allocated by the profiled op, freed by the
+        drain thread (or at the enqueue site when the entry is shed). */
+    struct ProfileEntry {
+        ProfileEntry( const string& n, const BSONObj& d ) : ns( n ), doc( d ) {}
+        string ns;
+        BSONObj doc;
+    };
+
+    /**
+     * Bounded lock-free ring of profile entries.  Each slot carries a sequence
+     * number, so a producer claims a slot with a single CAS and publishes it
+     * with a single store; a full ring fails the push immediately instead of
+     * blocking the profiled op.  Only the drain thread consumes.
+     */
+    class ProfileRing {
+    public:
+        ProfileRing() : _enqueuePos(0), _dequeuePos(0) {
+            for ( unsigned i = 0; i < kSize; i++ ) {
+                _slots[i].seq.store( i );
+                _slots[i].entry = NULL;
+            }
+        }
+
+        /** returns false, without blocking, when the ring is full */
+        bool push( ProfileEntry* e ) {
+            unsigned pos = _enqueuePos.load();
+            while ( true ) {
+                Slot& slot = _slots[pos & kMask];
+                const int dif = static_cast<int>( slot.seq.load() - pos );
+                if ( dif == 0 ) {
+                    if ( _enqueuePos.compareAndSwap( pos, pos + 1 ) == pos ) {
+                        slot.entry = e;
+                        slot.seq.store( pos + 1 ); // publish
+                        return true;
+                    }
+                    pos = _enqueuePos.load();
+                }
+                else if ( dif < 0 ) {
+                    return false; // full; the consumer hasn't recycled this slot
+                }
+                else {
+                    pos = _enqueuePos.load(); // another producer claimed this slot
+                }
+            }
+        }
+
+        /** single consumer only; NULL when empty */
+        ProfileEntry* pop() {
+            const unsigned pos = _dequeuePos;
+            Slot& slot = _slots[pos & kMask];
+            if ( static_cast<int>( slot.seq.load() - ( pos + 1 ) ) < 0 )
+                return NULL; // not yet published
+            ProfileEntry* e = slot.entry;
+            slot.entry = NULL;
+            slot.seq.store( pos + kSize ); // recycle the slot
+            _dequeuePos = pos + 1;
+            return e;
+        }
+
+    private:
+        static const unsigned kSize = 64; // power of two
+        static const unsigned kMask = kSize - 1;
+
+        struct Slot {
+            AtomicUInt32 seq;
+            ProfileEntry* entry;
+        };
+
+        AtomicUInt32 _enqueuePos;
+        unsigned _dequeuePos; // touched only by the drain thread
+        Slot _slots[kSize];
+    };
+
+#if defined(MONGO_HAVE___DECLSPEC_THREAD)
+    __declspec( thread ) int myProfileStripe;  // 0 = unassigned; stores stripe + 1
+#elif defined(MONGO_HAVE___THREAD)
+    __thread int myProfileStripe;              // 0 = unassigned; stores stripe + 1
+#endif
+
+    AtomicWord<unsigned> nextProfileStripe;
+
+    /** background thread that drains queued profile documents so the locked insert
+        into system.profile doesn't ride on the profiled op's critical path.  each
+        enqueue is a CAS plus a store into one of a few thread-striped rings, so
+        concurrent ops neither lock nor share a queue head; when the writer can't
+        keep up we shed entries rather than block or grow without limit. */
+    class ProfileWriter : public BackgroundJob {
+    public:
+        ProfileWriter() {}
+        virtual ~ProfileWriter() {}
+
+        virtual string name() const { return "ProfileWriter"; }
+
+        void enqueue(const string& ns, const BSONObj& doc) {
+            if ( _started.load() == 0 && _started.compareAndSwap( 0, 1 ) == 0 )
+                go();  // writer thread is started lazily, exactly once
+
+            ProfileEntry* e = new ProfileEntry( ns, doc );
+            if ( _rings[_threadStripe()].push( e ) )
+                return;
+
+            delete e;
+            profileWritesDropped.increment();
+            static time_t last = 0;  // occasional, not per drop
+            if ( time(0) > last + 10 ) {
+                last = time(0);
+                warning() << "profiler write queue full; dropping entries "
+                          << "(profiler.writesDropped: "
+                          << profileWritesDropped.get() << ")" << endl;
+            }
+        }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            while ( !inShutdown() ) {
+                bool got = false;
+                for ( int i = 0; i < kNumStripes; i++ ) {
+                    while ( ProfileEntry* e = _rings[i].pop() ) {
+                        got = true;
+                        try {
+                            OperationContextImpl txn;
+                            _writeProfileDoc( &txn, e->ns, e->doc );
+                        }
+                        catch (const AssertionException& assertionEx) {
+                            warning() << "Caught Assertion while writing profile entry for "
+                                      << e->ns << ": " << assertionEx.toString() << endl;
+                        }
+                        delete e;
+                    }
+                }
+                if ( !got )
+                    sleepmillis( 10 );  // poll; producers never have to signal us
+            }
+            cc().shutdown();
+        }
+
+    private:
+        static const int kNumStripes = 4;
+
+        /** stripe for the calling thread; the same thread-local round-robin
+            assignment StripedCounter64 uses, approximating one ring per core. */
+        static int _threadStripe() {
+#if defined(MONGO_HAVE___DECLSPEC_THREAD) || defined(MONGO_HAVE___THREAD)
+            int s = myProfileStripe;
+            if ( s == 0 ) {
+                s = static_cast<int>( nextProfileStripe.fetchAndAdd(1) % kNumStripes ) + 1;
+                myProfileStripe = s;
+            }
+            return s - 1;
+#else
+            return 0; // no cheap TLS; everyone shares a ring, which still never blocks
+#endif
+        }
+
+        AtomicUInt32 _started;
+        ProfileRing _rings[kNumStripes];
+    };
+
+    ProfileWriter profileWriter;
+
+}  // namespace
+
     void profile(OperationContext* txn, const Client& c, int op, CurOp& currentOp) {
         // initialize with 1kb to start, to avoid realloc later
         // doing this outside the dblock to improve performance
         BufBuilder profileBufBuilder(1024);
 
+        const BSONObj p = _buildProfileDoc(c, currentOp, profileBufBuilder);
+
+        if ( profileAsyncWrites ) {
+            // getOwned: p points into profileBufBuilder, which dies with this frame
+            profileWriter.enqueue( currentOp.getNS(), p.getOwned() );
+            return;
+        }
+
         try {
             // NOTE: It's kind of weird that we lock the op's namespace, but have to for now since
             // we're sometimes inside the lock already
-            Lock::DBWrite lk(txn->lockState(), currentOp.getNS() );
-            if (dbHolder().get(txn, nsToDatabase(currentOp.getNS())) != NULL) {
-
-                Client::Context cx(currentOp.getNS(), false);
-                _profile(txn, c, cx.db(), currentOp, profileBufBuilder);
-            }
-            else {
-                mongo::log() << "note: not profiling because db went away - probably a close on: "
-                             << currentOp.getNS() << endl;
-            }
+            _writeProfileDoc(txn, currentOp.getNS(), p);
         }
         catch (const AssertionException& assertionEx) {
             warning() << "Caught Assertion while trying to profile " << opToString(op)
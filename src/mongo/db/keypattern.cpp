@@ -49,6 +49,13 @@ namespace mongo {
             }
             _prefixes.insert( fieldName );
         }
+
+        // Precompute the single-pass extractor used by extractSingleKey().
+        std::vector<std::string> fields;
+        BSONForEach( field, _pattern ) {
+            fields.push_back( field.fieldName() );
+        }
+        _extractor.reset( new MultiPathExtractor( fields ) );
     }
 
     bool KeyPattern::isIdKeyPattern(const BSONObj& pattern) {
@@ -73,7 +80,21 @@ namespace mongo {
                                                     BSONElementHasher::DEFAULT_HASH_SEED ) );
         }
 
-        return doc.extractFields( _pattern );
+        // One walk of the document resolves every pattern field, where
+        // extractFields() would re-scan it with getFieldDotted() per field.
+        std::vector<BSONElement> elts;
+        _extractor->extract( doc, &elts );
+
+        BSONObjBuilder b(32);
+        BSONObjIterator pat( _pattern );
+        size_t i = 0;
+        while ( pat.more() ) {
+            BSONElement patElt = pat.next();
+            if ( !elts[i].eoo() )
+                b.appendAs( elts[i], patElt.fieldName() );
+            ++i;
+        }
+        return b.obj();
     }
 
     bool KeyPattern::isSpecial() const {
@@ -46,7 +46,8 @@ namespace mongo {
           _otherLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
-          _lockPendingParallelWriter(false)
+          _lockPendingParallelWriter(false),
+          _admissionPriority(0)
     {
     }
 
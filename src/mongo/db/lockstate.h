@@ -32,6 +32,7 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -72,6 +73,12 @@ namespace mongo {
         /** pending means we are currently trying to get a lock */
         bool hasLockPending() const { return _lockPending || _lockPendingParallelWriter; }
 
+        /** admission priority class of the op this thread is running: < 0 low,
+            0 normal (the default), > 0 high.  consumed by ticket admission and the
+            priority-aware yield signal; see admission control in d_concurrency.cpp. */
+        int admissionPriority() const { return _admissionPriority; }
+        void setAdmissionPriority(int priority) { _admissionPriority = priority; }
+
         // ----
 
 
@@ -127,6 +134,8 @@ namespace mongo {
         bool _lockPending;
         bool _lockPendingParallelWriter;
 
+        int _admissionPriority;
+
         friend class Acquiring;
         friend class AcquiringParallelWriter;
     };
@@ -136,10 +145,16 @@ namespace mongo {
         SimpleMutex m;
         bool sharedLatching;
         LockStat stats;
+        AtomicUInt32 exclusiveWaiters; // threads currently blocked in lock()
     public:
         std::string name() const { return rw.name; }
         LockStat& getStats() { return stats; }
 
+        /** @return number of threads currently blocked trying to take this lock
+            exclusively.  one atomic read; readers holding the lock poll this to
+            decide to get out of a waiting writer's way. */
+        unsigned writersWaiting() const { return exclusiveWaiters.load(); }
+
         WrapperForRWLock(const StringData& name)
             : rw(name), m(name) {
             // For the local datbase, all operations are short,
@@ -147,7 +162,11 @@ namespace mongo {
             // In tests, use a SimpleMutex is much faster for the local db.
             sharedLatching = name != "local";
         }
-        void lock()          { if ( sharedLatching ) { rw.lock(); } else { m.lock(); } }
+        void lock() {
+            exclusiveWaiters.fetchAndAdd(1);
+            if ( sharedLatching ) { rw.lock(); } else { m.lock(); }
+            exclusiveWaiters.fetchAndSubtract(1);
+        }
         void lock_shared()   { if ( sharedLatching ) { rw.lock_shared(); } else { m.lock(); } }
         void unlock()        { if ( sharedLatching ) { rw.unlock(); } else { m.unlock(); } }
         void unlock_shared() { if ( sharedLatching ) { rw.unlock_shared(); } else { m.unlock(); } }
@@ -30,6 +30,9 @@
 
 #include "mongo/db/matcher/expression.h"
 
+#include <boost/thread/tss.hpp>
+#include <cstdlib>
+
 #include "mongo/bson/bsonobjiterator.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
@@ -37,6 +40,80 @@
 
 namespace mongo {
 
+    namespace {
+
+        // Every MatchExpression subclass in the tree fits in one of these; anything
+        // bigger is served by malloc directly.  Each raw block is prefixed with a
+        // size_t holding its payload capacity, which doubles as the chain word while
+        // the block sits on the free list.
+        const size_t kNodePayloadBytes = 512;
+
+        // Per-thread cap; blocks beyond this go back to the heap so a parse-heavy
+        // burst doesn't pin memory forever.
+        const size_t kMaxFreeNodes = 256;
+
+        struct NodeFreeList {
+            NodeFreeList() : head( NULL ), size( 0 ) {}
+            ~NodeFreeList() {
+                while ( head ) {
+                    char* raw = head;
+                    head = *reinterpret_cast<char**>( raw );
+                    std::free( raw );
+                }
+            }
+            char* head;
+            size_t size;
+        };
+
+        boost::thread_specific_ptr<NodeFreeList> nodeFreeList;
+
+        NodeFreeList* myFreeList() {
+            NodeFreeList* fl = nodeFreeList.get();
+            if ( !fl ) {
+                fl = new NodeFreeList();
+                nodeFreeList.reset( fl );
+            }
+            return fl;
+        }
+
+    }  // namespace
+
+    void* MatchExpression::operator new( size_t sz ) {
+        if ( sz <= kNodePayloadBytes ) {
+            NodeFreeList* fl = myFreeList();
+            if ( fl->head ) {
+                char* raw = fl->head;
+                fl->head = *reinterpret_cast<char**>( raw );
+                fl->size--;
+                *reinterpret_cast<size_t*>( raw ) = kNodePayloadBytes;
+                return raw + sizeof( size_t );
+            }
+        }
+
+        const size_t payload = sz <= kNodePayloadBytes ? kNodePayloadBytes : sz;
+        char* raw = static_cast<char*>( std::malloc( sizeof( size_t ) + payload ) );
+        massert( 18543, "out of memory MatchExpression", raw != NULL );
+        *reinterpret_cast<size_t*>( raw ) = payload;
+        return raw + sizeof( size_t );
+    }
+
+    void MatchExpression::operator delete( void* p ) {
+        if ( !p )
+            return;
+
+        char* raw = static_cast<char*>( p ) - sizeof( size_t );
+        if ( *reinterpret_cast<size_t*>( raw ) == kNodePayloadBytes ) {
+            NodeFreeList* fl = myFreeList();
+            if ( fl->size < kMaxFreeNodes ) {
+                *reinterpret_cast<char**>( raw ) = fl->head;
+                fl->head = raw;
+                fl->size++;
+                return;
+            }
+        }
+        std::free( raw );
+    }
+
     MatchExpression::MatchExpression( MatchType type )
         : _matchType( type ) { }
 
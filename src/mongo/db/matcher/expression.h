@@ -72,6 +72,15 @@ namespace mongo {
         MatchExpression( MatchType type );
         virtual ~MatchExpression(){}
 
+        /**
+         * Trees are built a node at a time by the parser and torn down the same way by
+         * normalization and destruction, so node storage comes from a per-thread free
+         * list of uniform chunks instead of the general-purpose heap.  Oversize nodes
+         * fall back to malloc; a one-word prefix records which way each came.
+         */
+        void* operator new( size_t sz );
+        void operator delete( void* p );
+
         //
         // Structural/AST information
         //
@@ -30,6 +30,8 @@
 
 #include "mongo/db/matcher/expression_leaf.h"
 
+#include <algorithm>
+
 #include "mongo/bson/bsonobjiterator.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
@@ -461,6 +463,9 @@ namespace mongo {
             _hasEmptyArray = true;
 
         _equalities.insert( e );
+        // A stale flat copy would make contains() miss this element; drop it and fall
+        // back to the set until finalize() runs again.
+        _sortedEqualities.clear();
         return Status::OK();
     }
 
@@ -469,6 +474,28 @@ namespace mongo {
         return Status::OK();
     }
 
+    void ArrayFilterEntries::finalize() {
+        // The set iterates in comparator order, so the flat copy comes out sorted.
+        _sortedEqualities.assign( _equalities.begin(), _equalities.end() );
+    }
+
+    bool ArrayFilterEntries::contains( const BSONElement& elem ) const {
+        if ( _sortedEqualities.empty() )
+            return _equalities.count( elem ) > 0;
+
+        // woCompare orders by canonical type first, so entries of one type are
+        // contiguous and a probe whose canonical type lies outside the list's range
+        // can't match anything.  For the common homogeneous $in list this rejects
+        // mistyped probes with two integer compares.
+        int ct = elem.canonicalType();
+        if ( ct < _sortedEqualities.front().canonicalType() ||
+             ct > _sortedEqualities.back().canonicalType() )
+            return false;
+
+        return std::binary_search( _sortedEqualities.begin(), _sortedEqualities.end(),
+                                   elem, BSONElementCmpWithoutField() );
+    }
+
     bool ArrayFilterEntries::equivalent( const ArrayFilterEntries& other ) const {
         if ( _hasNull != other._hasNull )
             return false;
@@ -486,6 +513,7 @@ namespace mongo {
         toFillIn._hasNull = _hasNull;
         toFillIn._hasEmptyArray = _hasEmptyArray;
         toFillIn._equalities = _equalities;
+        toFillIn._sortedEqualities = _sortedEqualities;
         for ( unsigned i = 0; i < _regexes.size(); i++ )
             toFillIn._regexes.push_back( static_cast<RegexMatchExpression*>(_regexes[i]->shallowClone()) );
     }
@@ -291,8 +291,15 @@ namespace mongo {
         Status addEquality( const BSONElement& e );
         Status addRegex( RegexMatchExpression* expr );
 
+        /**
+         * Call once all equalities have been added.  Builds a flat, sorted copy of the
+         * equality set so contains() can binary search contiguous memory instead of
+         * chasing set nodes.  Optional; contains() falls back to the set until called.
+         */
+        void finalize();
+
         const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        bool contains( const BSONElement& elem ) const;
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -314,6 +321,7 @@ namespace mongo {
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
         BSONElementSet _equalities;
+        std::vector<BSONElement> _sortedEqualities; // flat copy of _equalities, see finalize()
         std::vector<RegexMatchExpression*> _regexes;
     };
 
@@ -638,6 +638,7 @@ namespace mongo {
                     return s;
             }
         }
+        entries->finalize();
         return Status::OK();
 
     }
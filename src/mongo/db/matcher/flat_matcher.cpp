@@ -0,0 +1,212 @@
+// flat_matcher.cpp
+
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/matcher/flat_matcher.h"
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    bool FlatMatcher::_eligibleLeaf( const MatchExpression* node ) {
+        switch( node->matchType() ) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            const ComparisonMatchExpression* cmp =
+                static_cast<const ComparisonMatchExpression*>( node );
+            switch( cmp->getData().type() ) {
+            // these make missing fields or whole arrays match; the element
+            // table below can't tell those cases apart, so don't compile them
+            case jstNULL:
+            case Undefined:
+            case EOO:
+            case Array:
+                return false;
+            default:
+                break;
+            }
+            break;
+        }
+        case MatchExpression::MATCH_IN: {
+            const InMatchExpression* in = static_cast<const InMatchExpression*>( node );
+            if ( in->getData().hasNull() || in->getData().hasEmptyArray() )
+                return false;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        const StringData path =
+            static_cast<const LeafMatchExpression*>( node )->path();
+        if ( path.size() == 0 )
+            return false;
+        // dotted paths need full ElementPath traversal semantics
+        return path.toString().find( '.' ) == std::string::npos;
+    }
+
+    bool FlatMatcher::_eligible( const MatchExpression* node, int* numLeaves ) {
+        switch( node->matchType() ) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+            // an empty connective would compile to an empty block that jump
+            // targets can't name, so leave those to the tree
+            if ( node->numChildren() == 0 )
+                return false;
+            for ( size_t i = 0; i < node->numChildren(); i++ ) {
+                if ( !_eligible( node->getChild( i ), numLeaves ) )
+                    return false;
+            }
+            return true;
+        default:
+            if ( !_eligibleLeaf( node ) )
+                return false;
+            return ++*numLeaves <= kMaxLeaves;
+        }
+    }
+
+    int FlatMatcher::_fieldIndex( const MatchExpression* leaf ) {
+        const std::string field =
+            static_cast<const LeafMatchExpression*>( leaf )->path().toString();
+        for ( size_t i = 0; i < _fields.size(); i++ ) {
+            if ( _fields[i] == field )
+                return static_cast<int>( i );
+        }
+        _fields.push_back( field );
+        return static_cast<int>( _fields.size() - 1 );
+    }
+
+    namespace {
+        // a connective's block is just its children's blocks concatenated, so a
+        // subtree's size -- and every forward jump target -- is its leaf count
+        int countLeaves( const MatchExpression* node ) {
+            if ( node->numChildren() == 0 )
+                return 1;
+            int n = 0;
+            for ( size_t i = 0; i < node->numChildren(); i++ )
+                n += countLeaves( node->getChild( i ) );
+            return n;
+        }
+    }
+
+    int FlatMatcher::_emit( const MatchExpression* node, int at, int onTrue, int onFalse ) {
+        switch( node->matchType() ) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+            for ( size_t i = 0; i < node->numChildren(); i++ ) {
+                const MatchExpression* child = node->getChild( i );
+                const bool last = ( i == node->numChildren() - 1 );
+                // a non-final child whose outcome doesn't decide the connective
+                // falls through to its next sibling's block
+                const int next = at + countLeaves( child );
+                switch( node->matchType() ) {
+                case MatchExpression::AND:
+                    at = _emit( child, at, last ? onTrue : next, onFalse );
+                    break;
+                case MatchExpression::OR:
+                    at = _emit( child, at, onTrue, last ? onFalse : next );
+                    break;
+                default: // NOR: a matching child rejects, all children failing accepts
+                    at = _emit( child, at, onFalse, last ? onTrue : next );
+                    break;
+                }
+            }
+            return at;
+        case MatchExpression::NOT:
+            return _emit( node->getChild( 0 ), at, onFalse, onTrue );
+        default: {
+            Instruction& i = _prog[at];
+            i.leaf = node;
+            i.field = _fieldIndex( node );
+            i.onTrue = onTrue;
+            i.onFalse = onFalse;
+            return at + 1;
+        }
+        }
+    }
+
+    FlatMatcher* FlatMatcher::compile( const MatchExpression* root ) {
+        int numLeaves = 0;
+        if ( !_eligible( root, &numLeaves ) || numLeaves == 0 )
+            return NULL;
+
+        std::auto_ptr<FlatMatcher> m( new FlatMatcher() );
+        m->_prog.resize( numLeaves );
+        int end = m->_emit( root, 0, kAccept, kReject );
+        verify( end == numLeaves );
+        return m.release();
+    }
+
+    bool FlatMatcher::_matchesLeaf( const Instruction& i, const BSONElement& e ) {
+        if ( e.type() == Array ) {
+            // same element stream ElementPath produces for a top-level array:
+            // each member, then the array itself
+            BSONObjIterator it( e.embeddedObject() );
+            while ( it.more() ) {
+                if ( i.leaf->matchesSingleElement( it.next() ) )
+                    return true;
+            }
+        }
+        return i.leaf->matchesSingleElement( e );
+    }
+
+    bool FlatMatcher::matches( const BSONObj& obj ) const {
+        // one pass over the document fills the element table; first occurrence
+        // of a field wins, matching BSONObj::getField
+        BSONElement elts[kMaxLeaves];
+        size_t remaining = _fields.size();
+        BSONObjIterator it( obj );
+        while ( remaining && it.more() ) {
+            BSONElement e = it.next();
+            for ( size_t i = 0; i < _fields.size(); i++ ) {
+                if ( elts[i].eoo() && str::equals( _fields[i].c_str(), e.fieldName() ) ) {
+                    elts[i] = e;
+                    remaining--;
+                    break;
+                }
+            }
+        }
+
+        int pc = 0;
+        while ( pc >= 0 ) {
+            const Instruction& i = _prog[pc];
+            pc = _matchesLeaf( i, elts[i.field] ) ? i.onTrue : i.onFalse;
+        }
+        return pc == kAccept;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+// flat_matcher.h
+
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    class MatchExpression;
+
+    /**
+     * A flattened, branch-program form of a MatchExpression tree.
+     *
+     * MatchExpression::matches walks the tree with a virtual call and an
+     * ElementIterator allocation per predicate per document.  For filters that
+     * are just boolean combinations of simple comparisons on top-level fields,
+     * that overhead dominates the actual comparisons.  A FlatMatcher compiles
+     * such a tree once into a flat instruction array: one document pass fills a
+     * table of field values, then a tight loop threads through the instructions
+     * (each leaf jumps directly to the next instruction its outcome selects, so
+     * short-circuiting is preserved).
+     *
+     * The tree is left untouched -- planning and index selection still use it.
+     * Compilation is deliberately conservative: anything with dotted paths,
+     * null/array/missing-sensitive operands or operators outside
+     * $eq/$lt/$lte/$gt/$gte/$in and and/or/nor/not makes compile() return NULL
+     * and callers fall back to the tree walk.
+     */
+    class FlatMatcher {
+    public:
+        /**
+         * Compiles 'root' if it is eligible, otherwise returns NULL.
+         * Caller owns the result, which keeps pointers into 'root' and so must
+         * not outlive it.
+         */
+        static FlatMatcher* compile( const MatchExpression* root );
+
+        /**
+         * Equivalent to root->matchesBSON( obj ) for eligible trees.
+         */
+        bool matches( const BSONObj& obj ) const;
+
+    private:
+        // program counters below this are final results, not instructions
+        static const int kAccept = -1;
+        static const int kReject = -2;
+
+        // keeps the per-document element table small and stack allocated
+        static const int kMaxLeaves = 64;
+
+        struct Instruction {
+            const MatchExpression* leaf; // evaluated via matchesSingleElement()
+            int field;                   // index into _fields / element table
+            int onTrue;                  // next pc, or kAccept / kReject
+            int onFalse;
+        };
+
+        FlatMatcher() {}
+
+        static bool _eligible( const MatchExpression* node, int* numLeaves );
+        static bool _eligibleLeaf( const MatchExpression* node );
+
+        /**
+         * Emits instructions for 'node' starting at slot 'at', jumping to
+         * 'onTrue' / 'onFalse' when the subtree's outcome is known.
+         * @return the slot just past the emitted block.
+         */
+        int _emit( const MatchExpression* node, int at, int onTrue, int onFalse );
+
+        int _fieldIndex( const MatchExpression* leaf );
+
+        static bool _matchesLeaf( const Instruction& i, const BSONElement& e );
+
+        std::vector<Instruction> _prog;
+        std::vector<std::string> _fields; // distinct top-level field names
+    };
+
+}  // namespace mongo
@@ -0,0 +1,112 @@
+// flat_matcher_test.cpp
+
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for FlatMatcher, the flattened MatchExpression form. */
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/flat_matcher.h"
+
+namespace mongo {
+
+    namespace {
+        /** Parses 'query', requires it to compile flat, and checks the flat and
+            tree forms agree on 'doc'. */
+        void assertAgrees( const char* query, const char* doc ) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse( fromjson( query ) );
+            ASSERT_TRUE( result.isOK() );
+            boost::scoped_ptr<MatchExpression> tree( result.getValue() );
+            boost::scoped_ptr<FlatMatcher> flat( FlatMatcher::compile( tree.get() ) );
+            ASSERT( flat );
+            BSONObj obj = fromjson( doc );
+            ASSERT_EQUALS( tree->matchesBSON( obj ), flat->matches( obj ) );
+        }
+
+        /** Parses 'query' and requires that it does not compile flat. */
+        void assertNotCompiled( const char* query ) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse( fromjson( query ) );
+            ASSERT_TRUE( result.isOK() );
+            boost::scoped_ptr<MatchExpression> tree( result.getValue() );
+            boost::scoped_ptr<FlatMatcher> flat( FlatMatcher::compile( tree.get() ) );
+            ASSERT( !flat );
+        }
+    }
+
+    TEST( FlatMatcherTest, SimpleConjunction ) {
+        const char* query = "{ a: 1, b: { $gt: 2 }, c: { $in: [ 1, 2 ] } }";
+        assertAgrees( query, "{ a: 1, b: 3, c: 2 }" );
+        assertAgrees( query, "{ a: 1, b: 3, c: 5 }" );
+        assertAgrees( query, "{ a: 2, b: 3, c: 2 }" );
+        assertAgrees( query, "{ b: 3, c: 2 }" );
+    }
+
+    TEST( FlatMatcherTest, NestedConnectives ) {
+        const char* query =
+            "{ $or: [ { a: 1 }, { $and: [ { b: 2 }, { c: { $gte: 3 } } ] } ] }";
+        assertAgrees( query, "{ a: 1 }" );
+        assertAgrees( query, "{ b: 2, c: 4 }" );
+        assertAgrees( query, "{ b: 2, c: 1 }" );
+        assertAgrees( query, "{}" );
+
+        const char* norQuery = "{ $nor: [ { a: 1 }, { b: { $lt: 5 } } ] }";
+        assertAgrees( norQuery, "{ a: 1 }" );
+        assertAgrees( norQuery, "{ b: 2 }" );
+        assertAgrees( norQuery, "{ a: 2, b: 9 }" );
+    }
+
+    TEST( FlatMatcherTest, ArrayAndNegationSemantics ) {
+        // a leaf matches if any array member (or the array itself) matches
+        assertAgrees( "{ a: { $lt: 5 } }", "{ a: [ 7, 3 ] }" );
+        assertAgrees( "{ a: { $lt: 5 } }", "{ a: [ 7, 9 ] }" );
+        assertAgrees( "{ a: 3 }", "{ a: [ 3, 4 ] }" );
+        // $ne parses to NOT over EQ
+        assertAgrees( "{ a: { $ne: 3 } }", "{ a: [ 3, 4 ] }" );
+        assertAgrees( "{ a: { $ne: 3 } }", "{ a: [ 4, 5 ] }" );
+        // missing fields never match a comparison with a concrete operand
+        assertAgrees( "{ a: { $gt: 1 } }", "{ b: 5 }" );
+        // first occurrence of a duplicated field name wins, as with getField
+        assertAgrees( "{ a: 1 }", "{ a: 1, a: 2 }" );
+    }
+
+    TEST( FlatMatcherTest, IneligibleShapesFallBack ) {
+        assertNotCompiled( "{ 'a.b': 1 }" );             // dotted path
+        assertNotCompiled( "{ a: null }" );              // null matches missing
+        assertNotCompiled( "{ a: [ 1, 2 ] }" );          // whole-array operand
+        assertNotCompiled( "{ a: { $in: [ null ] } }" ); // null inside $in
+        assertNotCompiled( "{ a: { $size: 2 } }" );      // unsupported operator
+        assertNotCompiled( "{ a: { $exists: true } }" ); // missing-sensitive
+        assertNotCompiled( "{}" );                       // nothing to compile
+    }
+
+}  // namespace mongo
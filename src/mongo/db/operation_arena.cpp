@@ -0,0 +1,145 @@
+// operation_arena.cpp
+
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/operation_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "mongo/db/client.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // size of the block each client retains for per-operation allocations.
+    // 0 sends everything to the (tracked) heap fallback.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(clientArenaBlockBytes, int, 64 * 1024);
+
+    OperationArena::OperationArena()
+        : _block(NULL), _capacity(0), _used(0), _lastAlloc(NULL) {
+    }
+
+    OperationArena::~OperationArena() {
+        reset();
+        free(_block);
+    }
+
+    char* OperationArena::alloc( size_t bytes ) {
+        const size_t needed = sizeof(size_t) + ((bytes + 7) & ~size_t(7));
+
+        if ( _block == NULL && clientArenaBlockBytes > 0 ) {
+            _capacity = clientArenaBlockBytes;
+            _block = static_cast<char*>( malloc( _capacity ) );
+            massert( 18536, "out of memory OperationArena", _block != NULL );
+        }
+
+        if ( _block != NULL && _used + needed <= _capacity ) {
+            char* raw = _block + _used;
+            _used += needed;
+            *reinterpret_cast<size_t*>( raw ) = bytes;
+            _lastAlloc = _userPtr( raw );
+            return _lastAlloc;
+        }
+
+        char* raw = static_cast<char*>( malloc( sizeof(size_t) + bytes ) );
+        massert( 18537, "out of memory OperationArena", raw != NULL );
+        *reinterpret_cast<size_t*>( raw ) = bytes;
+        _heapAllocs.push_back( raw );
+        return _userPtr( raw );
+    }
+
+    char* OperationArena::realloc( char* p, size_t bytes ) {
+        char* raw = p - sizeof(size_t);
+        const size_t oldSize = *reinterpret_cast<size_t*>( raw );
+        if ( bytes <= oldSize )
+            return p;
+
+        if ( p == _lastAlloc ) {
+            // the tail of the block is ours; grow in place if it fits
+            const size_t oldEnd = ( raw - _block ) + sizeof(size_t) + ((oldSize + 7) & ~size_t(7));
+            const size_t newEnd = ( raw - _block ) + sizeof(size_t) + ((bytes + 7) & ~size_t(7));
+            if ( newEnd <= _capacity ) {
+                _used = newEnd;
+                verify( oldEnd <= _used );
+                *reinterpret_cast<size_t*>( raw ) = bytes;
+                return p;
+            }
+        }
+
+        char* n = alloc( bytes );
+        memcpy( n, p, oldSize );
+        // old space is reclaimed at reset(), like everything else here
+        return n;
+    }
+
+    bool OperationArena::owns( const void* p ) const {
+        const char* c = static_cast<const char*>( p );
+        if ( _block != NULL && c >= _block && c < _block + _capacity )
+            return true;
+        for ( size_t i = 0; i < _heapAllocs.size(); i++ ) {
+            if ( _userPtr( _heapAllocs[i] ) == c )
+                return true;
+        }
+        return false;
+    }
+
+    void OperationArena::reset() {
+        _used = 0;
+        _lastAlloc = NULL;
+        for ( size_t i = 0; i < _heapAllocs.size(); i++ )
+            free( _heapAllocs[i] );
+        _heapAllocs.clear();
+    }
+
+    void* ClientArenaAllocator::Malloc( size_t sz ) {
+        Client* c = currentClient.get();
+        // god clients (DBDirectClient) build replies that outlive the operation
+        if ( c == NULL || c->isGod() )
+            return malloc( sz );
+        return c->arena().alloc( sz );
+    }
+
+    void* ClientArenaAllocator::Realloc( void* p, size_t sz ) {
+        Client* c = currentClient.get();
+        if ( c == NULL || !c->arena().owns( p ) )
+            return ::realloc( p, sz );
+        return c->arena().realloc( static_cast<char*>( p ), sz );
+    }
+
+    void ClientArenaAllocator::Free( void* p ) {
+        Client* c = currentClient.get();
+        if ( c == NULL || !c->arena().owns( p ) )
+            free( p );
+        // arena memory is reclaimed wholesale at the next reset
+    }
+
+}  // namespace mongo
@@ -0,0 +1,96 @@
+// operation_arena.h
+
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "mongo/bson/util/builder.h"
+
+namespace mongo {
+
+    /**
+     * Bump-pointer allocator for per-operation scratch memory, owned by Client.
+     *
+     * One block is retained across operations and handed out with a pointer
+     * bump; allocations that don't fit fall back to the heap and are tracked.
+     * Everything -- block space and tracked fallbacks -- stays valid until
+     * reset(), which assembleResponse calls at the start of each operation, so
+     * a reply buffer built here survives until the response has been sent.
+     * Not thread safe; a Client services one operation at a time.
+     */
+    class OperationArena : boost::noncopyable {
+    public:
+        OperationArena();
+        ~OperationArena();
+
+        /** never returns NULL (oversize requests go to the heap, tracked). */
+        char* alloc( size_t bytes );
+
+        /** 'p' must have come from alloc/realloc on this arena.  Grows in
+            place when p is the most recent allocation. */
+        char* realloc( char* p, size_t bytes );
+
+        /** @return true if 'p' came from this arena and must NOT be free()d */
+        bool owns( const void* p ) const;
+
+        /** invalidates all memory handed out since the last reset */
+        void reset();
+
+    private:
+        // every allocation is prefixed with its usable size, so realloc knows
+        // how much to copy and the prefix keeps 8 byte alignment
+        static char* _userPtr( char* raw ) { return raw + sizeof(size_t); }
+
+        char* _block;    // retained across resets; sized by clientArenaBlockBytes
+        size_t _capacity;
+        size_t _used;
+        char* _lastAlloc; // last pointer handed out of _block, for in-place growth
+
+        std::vector<char*> _heapAllocs; // fallbacks, freed at reset
+    };
+
+    /**
+     * BufBuilder allocator drawing from the current Client's OperationArena.
+     * Buffers decouple()d from an ArenaBufBuilder must be handed to Message
+     * with freeIt = !arena.owns(buf): god clients (DBDirectClient) bypass the
+     * arena because their replies are copied across operations.
+     */
+    class ClientArenaAllocator {
+    public:
+        void* Malloc( size_t sz );
+        void* Realloc( void* p, size_t sz );
+        void Free( void* p );
+    };
+
+    typedef _BufBuilder<ClientArenaAllocator> ArenaBufBuilder;
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #include "mongo/db/operation_context_impl.h"
 
+#include <vector>
+
 #include "mongo/db/client.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/global_environment_experiment.h"
@@ -35,11 +37,24 @@
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/fail_point_service.h"
 
 namespace mongo {
 
-    OperationContextImpl::OperationContextImpl() {
+namespace {
+
+    // Completed contexts are recycled here rather than freed, so the next request skips
+    // the RecoveryUnit allocation.  Bounded so a connection spike does not pin memory
+    // forever; overflow is simply deleted.
+    const size_t kMaxPooledOperationContexts = 256;
+
+    SimpleMutex operationContextPoolMutex("operationContextPool");
+    std::vector<OperationContextImpl*> operationContextPool;
+
+}  // namespace
+
+    OperationContextImpl::OperationContextImpl() : _registered(true) {
         invariant( globalStorageEngine );
         _recovery.reset(globalStorageEngine->newRecoveryUnit(this));
 
@@ -47,7 +62,54 @@ namespace mongo {
     }
 
     OperationContextImpl::~OperationContextImpl() {
-        getGlobalEnvironment()->unregisterOperationContext(this);
+        if ( _registered ) {
+            getGlobalEnvironment()->unregisterOperationContext(this);
+        }
+    }
+
+    OperationContextImpl* OperationContextImpl::acquireFromPool() {
+        OperationContextImpl* txn = NULL;
+        {
+            SimpleMutex::scoped_lock lk(operationContextPoolMutex);
+            if (!operationContextPool.empty()) {
+                txn = operationContextPool.back();
+                operationContextPool.pop_back();
+            }
+        }
+
+        if (!txn) {
+            return new OperationContextImpl();
+        }
+
+        txn->_resetForReuse();
+        getGlobalEnvironment()->registerOperationContext(txn);
+        txn->_registered = true;
+        return txn;
+    }
+
+    void OperationContextImpl::releaseToPool(OperationContextImpl* txn) {
+        // Unregister before the context becomes visible to other threads through the
+        // pool, so it cannot be registered twice.  Idle pooled contexts must not appear
+        // in the registry; its iterators report them as operations.
+        getGlobalEnvironment()->unregisterOperationContext(txn);
+        txn->_registered = false;
+
+        {
+            SimpleMutex::scoped_lock lk(operationContextPoolMutex);
+            if (operationContextPool.size() < kMaxPooledOperationContexts) {
+                operationContextPool.push_back(txn);
+                return;
+            }
+        }
+
+        delete txn;
+    }
+
+    void OperationContextImpl::_resetForReuse() {
+        // The recovery unit resets itself at the end of each unit of work and is reused
+        // as-is; the transaction identity must not leak between operations, so it is
+        // rebuilt and stamped from the next operation's opNum by getTransaction().
+        _tx = Transaction();
     }
 
     RecoveryUnit* OperationContextImpl::recoveryUnit() const {
@@ -64,9 +64,43 @@ namespace mongo {
 
         virtual Transaction* getTransaction();
 
+        /**
+         * Pooled access for hot request paths: returns a recycled instance when one is
+         * available rather than constructing a new one, so the RecoveryUnit is reset
+         * instead of reallocated.  Contexts handed back via releaseToPool() must have no
+         * unit of work in progress.
+         */
+        static OperationContextImpl* acquireFromPool();
+        static void releaseToPool(OperationContextImpl* txn);
+
     private:
+        // Re-initializes per-operation state when this context is checked out of the pool.
+        void _resetForReuse();
+
         boost::scoped_ptr<RecoveryUnit> _recovery;
         Transaction _tx;
+
+        // Whether this context is in the global operation context registry.  Pooled idle
+        // contexts are unregistered so they do not show up as operations.
+        bool _registered;
+    };
+
+    /**
+     * Checks an OperationContextImpl out of the pool for the life of the scope and returns
+     * it on destruction.  Use where a context would otherwise be constructed per request.
+     */
+    class PooledOperationContext {
+        MONGO_DISALLOW_COPYING(PooledOperationContext);
+    public:
+        PooledOperationContext() : _txn(OperationContextImpl::acquireFromPool()) { }
+        ~PooledOperationContext() { OperationContextImpl::releaseToPool(_txn); }
+
+        OperationContextImpl* get() const { return _txn; }
+        OperationContextImpl& operator*() const { return *_txn; }
+        OperationContextImpl* operator->() const { return _txn; }
+
+    private:
+        OperationContextImpl* const _txn;
     };
 
 }  // namespace mongo
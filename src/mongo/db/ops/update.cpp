@@ -498,6 +498,7 @@ namespace mongo {
         opDebug->nscanned = 0;
         opDebug->nscannedObjects = 0;
         opDebug->nModified = 0;
+        opDebug->nUpdateNoops = 0;
 
         // Get the cached document from the update driver.
         mutablebson::Document& doc = driver->getDocument();
@@ -604,6 +605,23 @@ namespace mongo {
             const char* source = NULL;
             bool inPlace = doc.getInPlaceUpdates(&damages, &source);
 
+            // Drop damage events that would write back exactly the bytes the document
+            // already holds.  Sync-style workloads re-apply identical values constantly,
+            // and once every event is dropped the update is recognized as a no-op below,
+            // skipping the journal intents, index maintenance, and the oplog entry.
+            if (inPlace && !damages.empty()) {
+                size_t kept = 0;
+                for (size_t i = 0; i < damages.size(); ++i) {
+                    const mutablebson::DamageEvent& event = damages[i];
+                    if (0 != memcmp(oldObj.objdata() + event.targetOffset,
+                                    source + event.sourceOffset,
+                                    event.size)) {
+                        damages[kept++] = damages[i];
+                    }
+                }
+                damages.resize(kept);
+            }
+
             // If something changed in the document, verify that no immutable fields were changed
             // and data is valid for storage.
             if ((!inPlace || !damages.empty()) ) {
@@ -623,7 +641,8 @@ namespace mongo {
             // Save state before making changes
             runner->saveState();
 
-            if (inPlace && !driver->modsAffectIndices()) {
+            if (inPlace && !driver->modsAffectIndices() &&
+                collection->getRecordStore()->updateWithDamagesSupported(loc)) {
                 // If a set of modifiers were all no-ops, we are still 'in place', but there is
                 // no work to do, in which case we want to consider the object unchanged.
                 if (!damages.empty() ) {
@@ -637,31 +656,48 @@ namespace mongo {
             else {
                 // The updates were not in place. Apply them through the file manager.
 
-                // XXX: With experimental document-level locking, we do not hold the sufficient
-                // locks, so this would cause corruption.
-                fassert(18516, !useExperimentalDocLocking);
-
                 newObj = doc.getObject();
                 uassert(17419,
                         str::stream() << "Resulting document after update is larger than "
                                       << BSONObjMaxUserSize,
                         newObj.objsize() <= BSONObjMaxUserSize);
-                StatusWith<DiskLoc> res = collection->updateDocument(txn,
-                                                                     loc,
-                                                                     newObj,
-                                                                     true,
-                                                                     opDebug);
-                uassertStatusOK(res.getStatus());
-                DiskLoc newLoc = res.getValue();
-                docWasModified = true;
-
-                // If the document moved, we might see it again in a collection scan (maybe it's
-                // a document after our current document).
-                //
-                // If the document is indexed and the mod changes an indexed value, we might see it
-                // again.  For an example, see the comment above near declaration of updatedLocs.
-                if (updatedLocs && (newLoc != loc || driver->modsAffectIndices())) {
-                    updatedLocs->insert(newLoc);
+
+                if (newObj.binaryEqual(oldObj)) {
+                    // The rebuilt document is byte-identical to what is already on disk
+                    // (e.g. a replacement-style update writing back an unchanged doc).
+                    // There is nothing to journal, index, or replicate.
+                }
+                else {
+                    // With experimental document-level locking, we only hold an intent lock
+                    // plus record locks, which is not sufficient for a document move or an
+                    // index update -- have the caller retry under the exclusive lock.
+                    if (useExperimentalDocLocking)
+                        throw UpdateNeedsExclusiveLockException();
+
+                    // For mod-style updates the driver reports exactly which paths changed;
+                    // hand them down so indexes that can't intersect them skip key
+                    // generation.  Replacement updates can change anything, so they update
+                    // every index.
+                    StatusWith<DiskLoc> res = collection->updateDocument(
+                            txn,
+                            loc,
+                            newObj,
+                            true,
+                            opDebug,
+                            driver->isDocReplacement() ? NULL : &updatedFields);
+                    uassertStatusOK(res.getStatus());
+                    DiskLoc newLoc = res.getValue();
+                    docWasModified = true;
+
+                    // If the document moved, we might see it again in a collection scan
+                    // (maybe it's a document after our current document).
+                    //
+                    // If the document is indexed and the mod changes an indexed value, we
+                    // might see it again.  For an example, see the comment above near
+                    // declaration of updatedLocs.
+                    if (updatedLocs && (newLoc != loc || driver->modsAffectIndices())) {
+                        updatedLocs->insert(newLoc);
+                    }
                 }
             }
 
@@ -670,8 +706,9 @@ namespace mongo {
                     "Update could not restore runner state after updating a document.",
                     runner->restoreState(txn));
 
-            // Call logOp if requested.
-            if (request.shouldCallLogOp() && !logObj.isEmpty()) {
+            // Call logOp if requested.  Detected no-ops left the document untouched, so
+            // there is nothing for secondaries to apply either.
+            if (request.shouldCallLogOp() && !logObj.isEmpty() && docWasModified) {
                 BSONObj idQuery = driver->makeOplogEntryQuery(newObj, request.isMulti());
                 repl::logOp(txn, "u", nsString.ns().c_str(), logObj , &idQuery,
                       NULL, request.isFromMigration());
@@ -680,6 +717,8 @@ namespace mongo {
             // Only record doc modifications if they wrote (exclude no-ops)
             if (docWasModified)
                 opDebug->nModified++;
+            else
+                opDebug->nUpdateNoops++;
 
             if (!request.isMulti()) {
                 break;
@@ -703,6 +742,12 @@ namespace mongo {
         // We haven't found any existing document so an insert is done
         // (upsert is true).
         //
+
+        // Inserting touches the freelists and indexes, which the intent lock does not
+        // protect -- have the caller retry the upsert under the exclusive lock.
+        if (useExperimentalDocLocking)
+            throw UpdateNeedsExclusiveLockException();
+
         opDebug->upsert = true;
 
         // Since this is an insert (no docs found and upsert:true), we will be logging it
@@ -41,6 +41,22 @@ namespace mongo {
     class OperationContext;
     class UpdateDriver;
 
+    /**
+     * Thrown by update() when an update running under the experimental document-level
+     * locking mode (intent DBWrite plus LockManager record locks) discovers it needs
+     * work that is only safe under the exclusive database lock: a document move, an
+     * index update, or an upsert that inserts.  Callers that took an intent lock catch
+     * this and retry the operation under a full Lock::DBWrite.
+     */
+    class UpdateNeedsExclusiveLockException : public std::exception {
+    public:
+        UpdateNeedsExclusiveLockException() {}
+        virtual ~UpdateNeedsExclusiveLockException() throw() {}
+        virtual const char* what() const throw() {
+            return "update requires the exclusive database lock";
+        }
+    };
+
     /**
      * Utility method to execute an update described by "request".
      *
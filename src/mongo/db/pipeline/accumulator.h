@@ -45,6 +45,15 @@ namespace mongo {
             processInternal(input, merging);
         }
 
+        /** Process a contiguous array of inputs in one call.
+         *  Equivalent to calling process() once per value, but accumulators with
+         *  cheap per-value work override processBatchInternal with tight loops
+         *  that avoid the per-value virtual dispatch.
+         */
+        void processBatch(const Value* input, size_t n, bool merging) {
+            processBatchInternal(input, n, merging);
+        }
+
         /** Marks the end of the evaluate() phase and return accumulated result.
          *  toBeMerged should be true when the outputs will be merged by process().
          */
@@ -67,6 +76,12 @@ namespace mongo {
         /// Update subclass's internal state based on input
         virtual void processInternal(const Value& input, bool merging) = 0;
 
+        /// Batched counterpart of processInternal; default just loops.
+        virtual void processBatchInternal(const Value* input, size_t n, bool merging) {
+            for (size_t i = 0; i < n; i++)
+                processInternal(input[i], merging);
+        }
+
         /// subclasses are expected to update this as necessary
         int _memUsageBytes;
     };
@@ -123,6 +138,7 @@ namespace mongo {
     class AccumulatorSum : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual void processBatchInternal(const Value* input, size_t n, bool merging);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
@@ -141,6 +157,7 @@ namespace mongo {
     class AccumulatorMinMax : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual void processBatchInternal(const Value* input, size_t n, bool merging);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
@@ -175,6 +192,7 @@ namespace mongo {
     class AccumulatorAvg : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual void processBatchInternal(const Value* input, size_t n, bool merging);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
@@ -58,6 +58,25 @@ namespace {
         }
     }
 
+    void AccumulatorAvg::processBatchInternal(const Value* input, size_t n, bool merging) {
+        if (merging) {
+            // merge inputs are objects; nothing to gain over the plain loop
+            Accumulator::processBatchInternal(input, n, merging);
+            return;
+        }
+
+        double total = 0;
+        long long count = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!input[i].numeric())
+                continue;
+            total += input[i].getDouble();
+            count += 1;
+        }
+        _total += total;
+        _count += count;
+    }
+
     intrusive_ptr<Accumulator> AccumulatorAvg::create() {
         return new AccumulatorAvg();
     }
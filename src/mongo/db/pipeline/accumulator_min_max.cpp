@@ -45,6 +45,20 @@ namespace mongo {
         }
     }
 
+    void AccumulatorMinMax::processBatchInternal(const Value* input, size_t n, bool merging) {
+        // find the batch's winner locally, then update the accumulator state
+        // (including _memUsageBytes) at most once
+        const Value* best = NULL;
+        for (size_t i = 0; i < n; i++) {
+            if (input[i].nullish())
+                continue;
+            if (!best || Value::compare(*best, input[i]) * _sense > 0)
+                best = &input[i];
+        }
+        if (best)
+            processInternal(*best, merging);
+    }
+
     Value AccumulatorMinMax::getValue(bool toBeMerged) const {
         return _val;
     }
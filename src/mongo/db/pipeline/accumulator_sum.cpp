@@ -56,6 +56,42 @@ namespace mongo {
         }
     }
 
+    void AccumulatorSum::processBatchInternal(const Value* input, size_t n, bool merging) {
+        size_t i = 0;
+
+        // integer phase: identical bookkeeping to processInternal, ends as soon
+        // as a double widens the total
+        while (i < n && totalType != NumberDouble) {
+            const Value& v = input[i];
+            if (v.numeric()) {
+                totalType = Value::getWidestNumeric(totalType, v.getType());
+                if (totalType == NumberDouble)
+                    break; // switch loops without consuming v
+
+                long long lv = v.coerceToLong();
+                longTotal += lv;
+                doubleTotal += lv;
+            }
+            i++;
+        }
+
+        // double phase: the integer total no longer matters, so runs of numeric
+        // values fold into a local accumulator the compiler can keep in a register
+        while (i < n) {
+            if (input[i].numeric()) {
+                double acc = 0;
+                do {
+                    acc += input[i].getDouble();
+                    i++;
+                } while (i < n && input[i].numeric());
+                doubleTotal += acc;
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
     intrusive_ptr<Accumulator> AccumulatorSum::create() {
         return new AccumulatorSum();
     }
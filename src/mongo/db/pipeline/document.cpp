@@ -220,7 +220,8 @@ namespace mongo {
         BSONObjIterator it(bson);
         while(it.more()) {
             BSONElement bsonElement(it.next());
-            md.addField(bsonElement.fieldNameStringData(), Value(bsonElement));
+            Value val(bsonElement);
+            md.addFieldConsume(bsonElement.fieldNameStringData(), val);
         }
 
         *this = md.freeze();
@@ -269,7 +270,8 @@ namespace mongo {
             }
 
             // Note: this will not parse out metadata in embedded documents.
-            md.addField(elem.fieldNameStringData(), Value(elem));
+            Value val(elem);
+            md.addFieldConsume(elem.fieldNameStringData(), val);
         }
 
         return md.freeze();
@@ -439,8 +441,8 @@ namespace mongo {
         MutableDocument doc(numElems);
         for (int i = 0; i < numElems; i++) {
             StringData name = buf.readCStr();
-            doc.addField(name, Value::deserializeForSorter(buf,
-                                                           Value::SorterDeserializeSettings()));
+            Value val = Value::deserializeForSorter(buf, Value::SorterDeserializeSettings());
+            doc.addFieldConsume(name, val);
         }
 
         if (buf.read<char>()) // hasTextScore
@@ -325,6 +325,14 @@ namespace mongo {
             storage().appendField(fieldName) = val;
         }
 
+        /** Same as addField() but takes over the contents of 'val' instead of copying
+         *  them, leaving 'val' empty.  A Value copy and destroy each touch an atomic
+         *  refcount, so prefer this on hot paths whenever the caller is done with 'val'.
+         */
+        void addFieldConsume(StringData fieldName, Value& val) {
+            storage().appendField(fieldName).swap(val);
+        }
+
         /** Update field by key. If there is no field with that key, add one.
          *
          *  If the new value is missing(), the field is logically removed.
@@ -39,6 +39,19 @@ namespace mongo {
         , pExpCtx(pCtx)
     {}
 
+    size_t DocumentSource::getNextBatch(vector<Document>* out, size_t maxDocs) {
+        size_t numAppended = 0;
+        while (numAppended < maxDocs) {
+            boost::optional<Document> next = getNext();
+            if (!next)
+                break;
+
+            out->push_back(*next);
+            numAppended++;
+        }
+        return numAppended;
+    }
+
     const char *DocumentSource::getSourceName() const {
         static const char unknown[] = "[UNKNOWN]";
         return unknown;
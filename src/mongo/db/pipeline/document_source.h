@@ -46,6 +46,7 @@
 #include "mongo/s/shard.h"
 #include "mongo/s/strategy.h"
 #include "mongo/util/intrusive_counter.h"
+#include "mongo/util/memory_account.h"
 
 
 namespace mongo {
@@ -66,6 +67,19 @@ namespace mongo {
          */
         virtual boost::optional<Document> getNext() = 0;
 
+        /// Number of Documents exchanged per getNextBatch() call by default.
+        static const size_t kBatchDocs = 256;
+
+        /** Appends up to 'maxDocs' Documents to 'out' and returns how many were appended.
+         *  Returns 0 only at EOF.
+         *
+         *  The default implementation just loops over getNext(). Sources that can produce
+         *  or transform documents more cheaply in bulk override this so that a pipeline
+         *  driven batch-at-a-time pays its virtual dispatch (and lock/yield bookkeeping)
+         *  once per batch rather than once per document.
+         */
+        virtual size_t getNextBatch(std::vector<Document>* out, size_t maxDocs);
+
         /**
          * Inform the source that it is no longer needed and may release its resources.  After
          * dispose() is called the source must still be able to handle iteration requests, but may
@@ -343,6 +357,7 @@ namespace mongo {
         // virtuals from DocumentSource
         virtual ~DocumentSourceCursor();
         virtual boost::optional<Document> getNext();
+        virtual size_t getNextBatch(std::vector<Document>* out, size_t maxDocs);
         virtual const char *getSourceName() const;
         virtual Value serialize(bool explain = false) const;
         virtual void setSource(DocumentSource *pSource);
@@ -461,6 +476,22 @@ namespace mongo {
         /// Tell this source if it is doing a merge from shards. Defaults to false.
         void setDoingMerge(bool doingMerge) { _doingMerge = doingMerge; }
 
+        /**
+         * Returns true and fills in 'path' when the group key is a single field
+         * path on the input documents (e.g. {_id: "$customer"}), the only shape
+         * an index-ordered cursor can feed in group key order.
+         */
+        bool getIdFieldPath(std::string* path) const;
+
+        /**
+         * Promises that input documents arrive with equal group keys adjacent
+         * (e.g. from an index-ordered cursor over the grouping field).  Each
+         * group is then emitted as soon as its key completes, keeping only the
+         * current group's accumulator state in memory instead of a hash table
+         * of every group.  Set by PipelineD when it can supply such a cursor.
+         */
+        void setInputSorted() { _inputSorted = true; }
+
         /**
           Create a grouping DocumentSource from BSON.
 
@@ -488,6 +519,10 @@ namespace mongo {
         /// Spill groups map to disk and returns an iterator to the file.
         shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+        /// Like spill() but keeps the sorted run in memory; used for the final batch
+        /// so it can join the external merge without being written out and read back.
+        shared_ptr<Sorter<Value, Value>::Iterator> makeSortedRunInMemory();
+
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
@@ -518,9 +553,35 @@ namespace mongo {
 
 
         typedef std::vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
+
+        /**
+         * Hash and equality for the groups map dispatch through function pointers so
+         * that common group-key shapes can use monomorphic fast paths instead of
+         * Value's generic per-type dispatch; see selectIdHashVariant().  The default
+         * constructed functors behave like Value::Hash and operator==.
+         */
+        struct KeyHasher : std::unary_function<const Value&, size_t> {
+            KeyHasher();
+            explicit KeyHasher(size_t (*f)(const Value&)) : fn(f) {}
+            size_t operator()(const Value& v) const { return fn(v); }
+            size_t (*fn)(const Value&);
+        };
+        struct KeyEqual : std::binary_function<const Value&, const Value&, bool> {
+            KeyEqual();
+            explicit KeyEqual(bool (*f)(const Value&, const Value&)) : fn(f) {}
+            bool operator()(const Value& l, const Value& r) const { return fn(l, r); }
+            bool (*fn)(const Value&, const Value&);
+        };
+
+        typedef boost::unordered_map<Value, Accumulators, KeyHasher, KeyEqual> GroupsMap;
         GroupsMap groups;
 
+        /**
+         * Installs scalar fast-path hash/equality functions in 'groups' when the
+         * group key is a single field path; called once the _id expression is known.
+         */
+        void selectIdHashVariant();
+
         /*
           The field names for the result documents and the accumulator
           factories for the result documents.  The Expressions are the
@@ -540,10 +601,54 @@ namespace mongo {
 
         Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
+        /**
+         * Switch to pulling directly from the merge cursors, if the source
+         * allows it.  Returns whether streaming started.
+         */
+        bool startStreamingMerge();
+
+        /// Produce the next group by merging the heads of the shard streams.
+        boost::optional<Document> getNextStreaming();
+
+        /// Produce the next group from key-ordered input (see setInputSorted()).
+        boost::optional<Document> getNextSortedInput();
+
+        /// Load cursor i's next document and group key into the head arrays.
+        void advanceMergeCursor(size_t i);
+
         bool _doingMerge;
+
+        // Set on the shard half of a split pipeline: emit groups in ascending
+        // group key order so the merging half can combine the shard streams
+        // without materializing every group.
+        bool _sortedOutputForMerge;
+
+        // Set on the merging half: combine the shards' sorted partial-state
+        // streams with a k-way merge, finalizing each group as soon as every
+        // stream has moved past it.
+        bool _streamingMerge;
+
+        // only used when _streamingMerge; the cursors are owned by the
+        // DocumentSourceMergeCursors we are downstream of
+        bool _streaming; // startStreamingMerge() succeeded
+
+        // Set when the source delivers documents with equal group keys
+        // adjacent; see setInputSorted().
+        bool _inputSorted;
+        bool _haveCurrentGroup; // _currentId/_currentAccumulators hold a group in progress
+        bool _sortedDone;       // sorted-input mode has emitted its last group
+
+        std::vector<DBClientCursor*> _mergeCursors;
+        std::vector<Document> _cursorHeads;
+        std::vector<Value> _cursorHeadIds;
+        std::vector<bool> _cursorHasHead;
         bool _spilled;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
+
+        // Mirrors this group's buffered bytes into the process-wide "group"
+        // MemoryAccount.
+        ScopedMemoryTracker _memTracker;
         boost::scoped_ptr<Variables> _variables;
         std::vector<std::string> _idFieldNames; // used when id is a document
         std::vector<intrusive_ptr<Expression> > _idExpressions;
@@ -563,6 +668,7 @@ namespace mongo {
     public:
         // virtuals from DocumentSource
         virtual boost::optional<Document> getNext();
+        virtual size_t getNextBatch(std::vector<Document>* out, size_t maxDocs);
         virtual const char *getSourceName() const;
         virtual bool coalesce(const intrusive_ptr<DocumentSource>& nextSource);
         virtual Value serialize(bool explain = false) const;
@@ -581,6 +687,9 @@ namespace mongo {
         /// Returns the query in Matcher syntax.
         BSONObj getQuery() const;
 
+        /// Returns true if 'doc' satisfies this stage's predicate.
+        bool matches(const BSONObj& doc) const;
+
         static const char matchName[];
 
         /** Returns the portion of the match that can safely be promoted to before a $redact.
@@ -717,11 +826,64 @@ namespace mongo {
         const NamespaceString _outputNs; // output will go here after all data is processed.
     };
 
-    
+
+    class DocumentSourceParallelScan : public DocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual ~DocumentSourceParallelScan();
+        virtual boost::optional<Document> getNext();
+        virtual size_t getNextBatch(std::vector<Document>* out, size_t maxDocs);
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual void setSource(DocumentSource *pSource);
+        virtual bool isValidInitialSource() const { return true; }
+        virtual void dispose();
+
+        /**
+         * Create a source that drains 'cursorIds' on a pool of 'numWorkers' threads and
+         * funnels the resulting documents, in no particular order, into the rest of the
+         * pipeline.  Each cursor id must refer to a ClientCursor over 'ns' wrapping a
+         * saved MultiIteratorRunner, as handed out by parallelCollectionScan.
+         *
+         * 'stageSpecs' is the serialized form of the order-insensitive stage prefix
+         * ($match/$project) removed from the pipeline; every worker parses its own copy
+         * and applies it to its documents before they are funneled, so those stages run
+         * on all workers at once.
+         */
+        static intrusive_ptr<DocumentSourceParallelScan> create(
+            const std::string& ns,
+            const std::vector<CursorId>& cursorIds,
+            const std::vector<BSONObj>& stageSpecs,
+            int numWorkers,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+    private:
+        DocumentSourceParallelScan(
+            const std::string& ns,
+            const std::vector<CursorId>& cursorIds,
+            const std::vector<BSONObj>& stageSpecs,
+            int numWorkers,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /** Spawns the workers on first call; subsequent calls are no-ops. */
+        void ensureStarted();
+
+        // All state the workers touch.  Shared (and kept alive) by the detached worker
+        // threads, which must never reference this DocumentSource directly -- dispose()
+        // can run while they are still draining their cursors.
+        struct SharedState;
+        boost::shared_ptr<SharedState> _state;
+
+        const int _numWorkers;
+        bool _started;
+    };
+
+
     class DocumentSourceProject : public DocumentSource {
     public:
         // virtuals from DocumentSource
         virtual boost::optional<Document> getNext();
+        virtual size_t getNextBatch(std::vector<Document>* out, size_t maxDocs);
         virtual const char *getSourceName() const;
         virtual void optimize();
         virtual Value serialize(bool explain = false) const;
@@ -755,6 +917,12 @@ namespace mongo {
         boost::scoped_ptr<Variables> _variables;
         intrusive_ptr<ExpressionObject> pEO;
         BSONObj _raw;
+
+        // Subtrees that appear in several output fields, computed once per input
+        // document into a variable slot referenced from the rewritten tree.
+        // Filled in by optimize(); see the common subexpression pass there.
+        std::vector<std::pair<Variables::Id, intrusive_ptr<Expression> > > _commonSubexpressions;
+        Variables::Id _numVariables;
     };
 
     class DocumentSourceRedact :
@@ -1017,7 +1185,9 @@ namespace mongo {
         // virtuals from DocumentSource
         virtual boost::optional<Document> getNext();
         virtual const char *getSourceName() const;
+        virtual bool coalesce(const intrusive_ptr<DocumentSource>& pNextSource);
         virtual Value serialize(bool explain = false) const;
+        virtual void serializeToArray(std::vector<Value>& array, bool explain = false) const;
 
         virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
 
@@ -1043,9 +1213,20 @@ namespace mongo {
         /** Specify the field to unwind. */
         void unwindPath(const FieldPath &fieldPath);
 
+        /**
+         * Builds a probe object holding only the unwind path set to 'elem', for evaluating
+         * an absorbed $match against one array element before any output document exists.
+         */
+        BSONObj matchTargetFor(const Value& elem) const;
+
         // Configuration state.
         scoped_ptr<FieldPath> _unwindPath;
 
+        // An absorbed following $match whose predicate examines only the unwound field.
+        // When set, each array element is tested before its output document is built and
+        // non-matching elements are skipped outright.
+        intrusive_ptr<DocumentSourceMatch> _match;
+
         // Iteration state.
         class Unwinder;
         scoped_ptr<Unwinder> _unwinder;
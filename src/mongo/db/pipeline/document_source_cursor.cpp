@@ -64,6 +64,27 @@ namespace mongo {
         return out;
     }
 
+    size_t DocumentSourceCursor::getNextBatch(std::vector<Document>* out, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+
+        size_t numAppended = 0;
+        while (numAppended < maxDocs) {
+            if (_currentBatch.empty()) {
+                loadBatch();
+
+                if (_currentBatch.empty()) // exhausted the cursor
+                    break;
+            }
+
+            // Swap rather than copy so we don't touch the refcount on DocumentStorage.
+            out->push_back(Document());
+            out->back().swap(_currentBatch.front());
+            _currentBatch.pop_front();
+            numAppended++;
+        }
+        return numAppended;
+    }
+
     void DocumentSourceCursor::dispose() {
         // Can't call in to Runner or ClientCursor registries from this function since it will be
         // called when an agg cursor is killed which would cause a deadlock.
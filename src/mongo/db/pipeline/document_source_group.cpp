@@ -36,8 +36,47 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
+
+    // Memory $group may use before it must spill (with allowDiskUse) or fail.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes,
+                                  int,
+                                  100*1024*1024);
+
+    namespace {
+        // Process-wide accounting for $group hash tables (serverStatus
+        // memoryAccounting section).
+        MemoryAccount groupMemoryAccount( "group" );
+
+        // Defaults for the groups map's function-pointer hash and equality; see
+        // selectIdHashVariant() for the monomorphic variants.
+        size_t groupKeyHashGeneric(const Value& v) {
+            return Value::Hash()(v);
+        }
+
+        bool groupKeyEqualGeneric(const Value& l, const Value& r) {
+            return l == r;
+        }
+    }
+
+    DocumentSourceGroup::KeyHasher::KeyHasher() : fn(groupKeyHashGeneric) {}
+    DocumentSourceGroup::KeyEqual::KeyEqual() : fn(groupKeyEqualGeneric) {}
+
+    void DocumentSourceGroup::selectIdHashVariant() {
+        if (_idExpressions.size() != 1)
+            return; // compound keys hash every part through the generic path
+
+        // A single field-path key is overwhelmingly a scalar (int, long or string),
+        // so rebuild the (still empty) map with fast paths keyed on the runtime
+        // type.  Array or document values fall back to the generic functions.
+        if (dynamic_cast<ExpressionFieldPath*>(_idExpressions[0].get())) {
+            GroupsMap(0, KeyHasher(&Value::hashScalar), KeyEqual(&Value::equalScalar))
+                .swap(groups);
+        }
+    }
+
     const char DocumentSourceGroup::groupName[] = "$group";
 
     const char *DocumentSourceGroup::getSourceName() const {
@@ -47,6 +86,15 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGroup::getNext() {
         pExpCtx->checkForInterrupt();
 
+        if (_inputSorted)
+            return getNextSortedInput();
+
+        if (!populated && _streamingMerge)
+            _streaming = startStreamingMerge();
+
+        if (_streaming)
+            return getNextStreaming();
+
         if (!populated)
             populate();
 
@@ -113,6 +161,7 @@ namespace mongo {
         // free our resources
         GroupsMap().swap(groups);
         _sorterIterator.reset();
+        _memTracker.set(0);
 
         // make us look done
         groupsIterator = groups.end();
@@ -167,6 +216,13 @@ namespace mongo {
             insides["$doingMerge"] = Value(true);
         }
 
+        if (_sortedOutputForMerge) {
+            // As with $doingMerge, shards that predate this flag error out on it, but it is only
+            // sent when the merging half of the pipeline relies on sorted shard output.
+
+            insides["$sortedMergeOutput"] = Value(true);
+        }
+
         return Value(DOC(getSourceName() << insides.freeze()));
     }
 
@@ -196,9 +252,16 @@ namespace mongo {
         : DocumentSource(pExpCtx)
         , populated(false)
         , _doingMerge(false)
+        , _sortedOutputForMerge(false)
+        , _streamingMerge(false)
+        , _streaming(false)
+        , _inputSorted(false)
+        , _haveCurrentGroup(false)
+        , _sortedDone(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
-        , _maxMemoryUsageBytes(100*1024*1024)
+        , _maxMemoryUsageBytes(internalDocumentSourceGroupMaxMemoryBytes)
+        , _memTracker(groupMemoryAccount)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -267,6 +330,12 @@ namespace mongo {
 
                 pGroup->setDoingMerge(true);
             }
+            else if (str::equals(pFieldName, "$sortedMergeOutput")) {
+                massert(18555, "$sortedMergeOutput should be true if present",
+                        groupField.Bool());
+
+                pGroup->_sortedOutputForMerge = true;
+            }
             else {
                 /*
                   Treat as a projection field with the additional ability to
@@ -332,6 +401,8 @@ namespace mongo {
         uassert(15955, "a group specification must include an _id",
                 !pGroup->_idExpressions.empty());
 
+        pGroup->selectIdHashVariant();
+
         pGroup->_variables.reset(new Variables(idGenerator.getIdCount()));
 
         return pGroup;
@@ -345,6 +416,24 @@ namespace mongo {
                 return Value::compare(lhs.first, rhs.first);
             }
         };
+
+        // Adapter allowing an already-sorted run to participate in the external merge
+        // without being written to disk and read back.
+        class InMemoryRunIterator : public Sorter<Value, Value>::Iterator {
+        public:
+            typedef pair<Value, Value> Data;
+
+            explicit InMemoryRunIterator(vector<Data>* data) : _pos(0) {
+                _data.swap(*data);
+            }
+
+            virtual bool more() { return _pos < _data.size(); }
+            virtual Data next() { return _data[_pos++]; }
+
+        private:
+            vector<Data> _data;
+            size_t _pos;
+        };
     }
 
     void DocumentSourceGroup::populate() {
@@ -355,66 +444,131 @@ namespace mongo {
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
         int memoryUsageBytes = 0;
 
-        // This loop consumes all input from pSource and buckets it based on pIdExpression.
-        while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
-                               " Pass allowDiskUse:true to opt in.",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
-            }
-
-            _variables->setRoot(*input);
-
-            /* get the _id value */
-            Value id = computeId(_variables.get());
-
-            /* treat missing values the same as NULL SERVER-4674 */
+        if (_idExpressions.size() == 1 &&
+                dynamic_cast<ExpressionConstant*>(_idExpressions[0].get())) {
+            // A constant _id (the {_id: null} totals case) puts every document in
+            // the same group, so there is no per-document key to compute or look
+            // up; pull input in batches and feed each accumulator a whole batch
+            // at a time (see Accumulator::processBatch).
+            Value id = _idExpressions[0]->evaluate(_variables.get());
             if (id.missing())
                 id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
-
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+            vector<Document> batch;
+            vector<Value> inputs;
+            while (size_t numDocs = pSource->getNextBatch(&batch, kBatchDocs)) {
+                // Checking the memory limit per batch rather than per document can
+                // overshoot by at most one batch of accumulated values.  The
+                // process-wide budget triggers the same spill-or-fail policy as
+                // the per-stage limit.
+                _memTracker.set(memoryUsageBytes);
+                if (memoryUsageBytes > _maxMemoryUsageBytes ||
+                        (memoryUsageBytes > 0 && MemoryAccount::wouldExceedBudget(0))) {
+                    uassert(16945,
+                            "Exceeded memory limit for $group, but didn't allow external sort."
+                            " Pass allowDiskUse:true to opt in.",
+                            _extSortAllowed);
+                    sortedFiles.push_back(spill());
+                    memoryUsageBytes = 0;
+                    _memTracker.set(0);
+                }
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
+                const size_t oldSize = groups.size();
+                vector<intrusive_ptr<Accumulator> >& group = groups[id];
+                if (groups.size() != oldSize) {
+                    memoryUsageBytes += id.getApproximateSize();
+                    group.reserve(numAccumulators);
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        group.push_back(vpAccumulatorFactory[i]());
+                    }
+                } else {
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        // subtract old mem usage. New usage added back after processing.
+                        memoryUsageBytes -= group[i]->memUsageForSorter();
+                    }
                 }
-            } else {
+
+                dassert(numAccumulators == group.size());
                 for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
+                    inputs.clear();
+                    inputs.reserve(numDocs);
+                    for (size_t j = 0; j < numDocs; j++) {
+                        _variables->setRoot(batch[j]);
+                        inputs.push_back(vpExpression[i]->evaluate(_variables.get()));
+                    }
+                    group[i]->processBatch(&inputs[0], numDocs, _doingMerge);
+                    memoryUsageBytes += group[i]->memUsageForSorter();
                 }
-            }
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
+                _variables->clearRoot();
+                batch.clear();
             }
+        }
+        else {
+            // This loop consumes all input from pSource and buckets it based on pIdExpression.
+            while (boost::optional<Document> input = pSource->getNext()) {
+                _memTracker.set(memoryUsageBytes);
+                if (memoryUsageBytes > _maxMemoryUsageBytes ||
+                        (memoryUsageBytes > 0 && MemoryAccount::wouldExceedBudget(0))) {
+                    uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
+                                   " Pass allowDiskUse:true to opt in.",
+                            _extSortAllowed);
+                    sortedFiles.push_back(spill());
+                    memoryUsageBytes = 0;
+                    _memTracker.set(0);
+                }
 
-            // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+                _variables->setRoot(*input);
 
-            DEV {
-                // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
-                        && !pExpCtx->inRouter // can't spill to disk in router
-                        && !_extSortAllowed // don't change behavior when testing external sort
-                        && sortedFiles.size() < 20 // don't open too many FDs
-                        ) {
-                    sortedFiles.push_back(spill());
+                /* get the _id value */
+                Value id = computeId(_variables.get());
+
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
+
+                /*
+                  Look for the _id value in the map; if it's not there, add a
+                  new entry with a blank accumulator.
+                */
+                const size_t oldSize = groups.size();
+                vector<intrusive_ptr<Accumulator> >& group = groups[id];
+                const bool inserted = groups.size() != oldSize;
+
+                if (inserted) {
+                    memoryUsageBytes += id.getApproximateSize();
+
+                    // Add the accumulators
+                    group.reserve(numAccumulators);
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        group.push_back(vpAccumulatorFactory[i]());
+                    }
+                } else {
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        // subtract old mem usage. New usage added back after processing.
+                        memoryUsageBytes -= group[i]->memUsageForSorter();
+                    }
+                }
+
+                /* tickle all the accumulators for the group we found */
+                dassert(numAccumulators == group.size());
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
+                    memoryUsageBytes += group[i]->memUsageForSorter();
+                }
+
+                // We are done with the ROOT document so release it.
+                _variables->clearRoot();
+
+                DEV {
+                    // In debug mode, spill every time we have a duplicate id to stress merge logic.
+                    if (!inserted // is a dup
+                            && !pExpCtx->inRouter // can't spill to disk in router
+                            && !_extSortAllowed // don't change behavior when testing external sort
+                            && sortedFiles.size() < 20 // don't open too many FDs
+                            ) {
+                        sortedFiles.push_back(spill());
+                    }
                 }
             }
         }
@@ -423,7 +577,8 @@ namespace mongo {
         if (!sortedFiles.empty()) {
             _spilled = true;
             if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+                // The final run doesn't need to touch disk; merge it from memory.
+                sortedFiles.push_back(makeSortedRunInMemory());
             }
 
             // We won't be using groups again so free its memory.
@@ -441,11 +596,33 @@ namespace mongo {
 
             verify(_sorterIterator->more()); // we put data in, we should get something out.
             _firstPartOfNextGroup = _sorterIterator->next();
+        } else if (_sortedOutputForMerge && !groups.empty()) {
+            // The merger combines our stream with the other shards' in group key
+            // order, so emit through the sorted-run machinery instead of in hash
+            // order.  (When we spilled, the output above is already sorted.)
+            _spilled = true;
+            sortedFiles.push_back(makeSortedRunInMemory());
+            _sorterIterator.reset(
+                    Sorter<Value,Value>::Iterator::merge(
+                        sortedFiles, SortOptions(), SorterComparator()));
+
+            // prepare current to accumulate data
+            _currentAccumulators.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            }
+
+            verify(_sorterIterator->more());
+            _firstPartOfNextGroup = _sorterIterator->next();
         } else {
             // start the group iterator
             groupsIterator = groups.begin();
         }
 
+        // Whatever is still buffered (the in-memory run or the hash table)
+        // stays charged until dispose() or destruction.
+        _memTracker.set(memoryUsageBytes);
+
         populated = true;
     }
 
@@ -496,6 +673,47 @@ namespace mongo {
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
 
+    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::makeSortedRunInMemory() {
+        vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
+        ptrs.reserve(groups.size());
+        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
+            ptrs.push_back(&*it);
+        }
+
+        stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
+
+        vector<pair<Value, Value> > run;
+        run.reserve(ptrs.size());
+        switch (vpAccumulatorFactory.size()) { // mirrors switch in spill()
+        case 0: // no values, essentially a distinct
+            for (size_t i=0; i < ptrs.size(); i++) {
+                run.push_back(make_pair(ptrs[i]->first, Value()));
+            }
+            break;
+
+        case 1: // just one value, use optimized serialization as single Value
+            for (size_t i=0; i < ptrs.size(); i++) {
+                run.push_back(make_pair(ptrs[i]->first,
+                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true)));
+            }
+            break;
+
+        default: // multiple values, serialize as array-typed Value
+            for (size_t i=0; i < ptrs.size(); i++) {
+                vector<Value> accums;
+                for (size_t j=0; j < ptrs[i]->second.size(); j++) {
+                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+                }
+                run.push_back(make_pair(ptrs[i]->first, Value::consume(accums)));
+            }
+            break;
+        }
+
+        groups.clear();
+
+        return shared_ptr<Sorter<Value, Value>::Iterator>(new InMemoryRunIterator(&run));
+    }
+
     void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
                                                 const VariablesParseState& vps) {
         if (groupField.type() == Object && !groupField.Obj().isEmpty()) {
@@ -570,7 +788,8 @@ namespace mongo {
         MutableDocument out (1 + n);
 
         /* add the _id field */
-        out.addField("_id", expandId(id));
+        Value expandedId = expandId(id);
+        out.addFieldConsume("_id", expandedId);
 
         /* add the rest of the fields */
         for(size_t i = 0; i < n; ++i) {
@@ -580,25 +799,185 @@ namespace mongo {
                 out.addField(vFieldName[i], Value(BSONNULL));
             }
             else {
-                out.addField(vFieldName[i], val);
+                out.addFieldConsume(vFieldName[i], val);
             }
         }
 
         return out.freeze();
     }
 
+    bool DocumentSourceGroup::startStreamingMerge() {
+        DocumentSourceMergeCursors* mergeCursors =
+            dynamic_cast<DocumentSourceMergeCursors*>(pSource);
+        if (!mergeCursors)
+            return false; // not directly downstream of shard cursors; group normally
+
+        _mergeCursors = mergeCursors->getCursors();
+        if (_mergeCursors.empty())
+            return false;
+
+        _cursorHeads.resize(_mergeCursors.size());
+        _cursorHeadIds.resize(_mergeCursors.size());
+        _cursorHasHead.resize(_mergeCursors.size(), false);
+        for (size_t i = 0; i < _mergeCursors.size(); i++) {
+            advanceMergeCursor(i);
+        }
+
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        _currentAccumulators.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+        }
+
+        populated = true; // we consume the cursors directly; there is nothing to populate
+        return true;
+    }
+
+    void DocumentSourceGroup::advanceMergeCursor(size_t i) {
+        if (!_mergeCursors[i]->more()) {
+            _cursorHasHead[i] = false;
+            return;
+        }
+
+        Document doc = DocumentSourceMergeCursors::nextSafeFrom(_mergeCursors[i]);
+        _variables->setRoot(doc);
+        Value id = computeId(_variables.get());
+        if (id.missing())
+            id = Value(BSONNULL);
+        _variables->clearRoot();
+
+        _cursorHeads[i] = doc;
+        _cursorHeadIds[i] = id;
+        _cursorHasHead[i] = true;
+    }
+
+    boost::optional<Document> DocumentSourceGroup::getNextStreaming() {
+        // Each shard's stream is sorted by group key, so the smallest pending
+        // key is complete once every stream has moved past it.
+        int min = -1;
+        for (size_t i = 0; i < _mergeCursors.size(); i++) {
+            if (!_cursorHasHead[i])
+                continue;
+            if (min < 0 || Value::compare(_cursorHeadIds[i], _cursorHeadIds[min]) < 0)
+                min = i;
+        }
+        if (min < 0) {
+            dispose();
+            return boost::none;
+        }
+
+        const Value id = _cursorHeadIds[min];
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _currentAccumulators[i]->reset();
+        }
+
+        for (size_t i = 0; i < _mergeCursors.size(); i++) {
+            while (_cursorHasHead[i] && Value::compare(_cursorHeadIds[i], id) == 0) {
+                _variables->setRoot(_cursorHeads[i]);
+                for (size_t j = 0; j < numAccumulators; j++) {
+                    _currentAccumulators[j]->process(
+                        vpExpression[j]->evaluate(_variables.get()), /*merging=*/true);
+                }
+                _variables->clearRoot();
+                advanceMergeCursor(i);
+            }
+        }
+
+        return makeDocument(id, _currentAccumulators, pExpCtx->inShard);
+    }
+
+    bool DocumentSourceGroup::getIdFieldPath(string* path) const {
+        if (_idExpressions.size() != 1)
+            return false;
+
+        const ExpressionFieldPath* idPath =
+            dynamic_cast<const ExpressionFieldPath*>(_idExpressions[0].get());
+        if (!idPath || !idPath->isRootFieldPath())
+            return false;
+
+        const FieldPath& fieldPath = idPath->getFieldPath();
+        if (fieldPath.getPathLength() < 2)
+            return false; // bare $$ROOT/$$CURRENT groups on the whole document
+
+        // element 0 is the variable name; the rest is the path into the document
+        *path = fieldPath.tail().getPath(false);
+        return true;
+    }
+
+    boost::optional<Document> DocumentSourceGroup::getNextSortedInput() {
+        if (_sortedDone)
+            return boost::none;
+
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        if (_currentAccumulators.empty()) {
+            _currentAccumulators.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            }
+        }
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            _variables->setRoot(*input);
+
+            Value id = computeId(_variables.get());
+
+            /* treat missing values the same as NULL SERVER-4674 */
+            if (id.missing())
+                id = Value(BSONNULL);
+
+            // Equal group keys arrive adjacent, so a key change means the group
+            // we were accumulating is complete; hand it out once this document
+            // has been folded into the next group's fresh accumulators.
+            boost::optional<Document> finished;
+            if (_haveCurrentGroup && Value::compare(id, _currentId) != 0) {
+                finished = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    _currentAccumulators[i]->reset();
+                }
+            }
+            _currentId = id;
+            _haveCurrentGroup = true;
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->process(vpExpression[i]->evaluate(_variables.get()),
+                                                 _doingMerge);
+            }
+            _variables->clearRoot();
+
+            if (finished)
+                return finished;
+        }
+
+        _sortedDone = true;
+        if (!_haveCurrentGroup) {
+            dispose();
+            return boost::none; // there was no input at all
+        }
+
+        _haveCurrentGroup = false;
+        Document out = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+        dispose();
+        return out;
+    }
+
     intrusive_ptr<DocumentSource> DocumentSourceGroup::getShardSource() {
-        return this; // No modifications necessary when on shard
+        // Ask the shard half to emit sorted, mergeable output so the merge half
+        // can combine the shard streams without materializing every group.
+        _sortedOutputForMerge = true;
+        return this;
     }
 
     intrusive_ptr<DocumentSource> DocumentSourceGroup::getMergeSource() {
         intrusive_ptr<DocumentSourceGroup> pMerger(DocumentSourceGroup::create(pExpCtx));
         pMerger->setDoingMerge(true);
+        pMerger->_streamingMerge = true;
 
         VariablesIdGenerator idGenerator;
         VariablesParseState vps(&idGenerator);
         /* the merger will use the same grouping key */
         pMerger->_idExpressions.push_back(ExpressionFieldPath::parse("$$ROOT._id", vps));
+        pMerger->selectIdHashVariant();
 
         const size_t n = vFieldName.size();
         for(size_t i = 0; i < n; ++i) {
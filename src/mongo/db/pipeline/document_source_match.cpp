@@ -66,6 +66,33 @@ namespace mongo {
         return boost::none;
     }
 
+    size_t DocumentSourceMatch::getNextBatch(std::vector<Document>* out, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+
+        // The user facing error should have been generated earlier.
+        massert(17309, "Should never call getNext on a $match stage with $text clause",
+                !_isTextQuery);
+
+        size_t numAppended = 0;
+        std::vector<Document> input;
+        while (numAppended < maxDocs) {
+            input.clear();
+            if (!pSource->getNextBatch(&input, maxDocs - numAppended))
+                break; // Nothing left upstream.
+
+            for (size_t i = 0; i < input.size(); i++) {
+                // The matcher only takes BSON documents, so we have to make one.
+                if (!matcher->matches(input[i].toBson()))
+                    continue;
+
+                out->push_back(Document());
+                out->back().swap(input[i]);
+                numAppended++;
+            }
+        }
+        return numAppended;
+    }
+
     bool DocumentSourceMatch::coalesce(const intrusive_ptr<DocumentSource>& nextSource) {
         DocumentSourceMatch* otherMatch = dynamic_cast<DocumentSourceMatch*>(nextSource.get());
         if (!otherMatch)
@@ -341,6 +368,10 @@ namespace {
         return *(matcher->getQuery());
     }
 
+    bool DocumentSourceMatch::matches(const BSONObj& doc) const {
+        return matcher->matches(doc);
+    }
+
     DocumentSourceMatch::DocumentSourceMatch(const BSONObj &query,
                                              const intrusive_ptr<ExpressionContext> &pExpCtx)
         : DocumentSource(pExpCtx),
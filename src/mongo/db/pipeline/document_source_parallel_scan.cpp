@@ -0,0 +1,423 @@
+/**
+ * Copyright 2014 (c) 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/query/runner.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+    // Documents fetched from a segment cursor per lock acquisition.
+    const size_t kChunkDocs = DocumentSource::kBatchDocs;
+
+    // Funnel backpressure: workers stall once this many documents are queued but not yet
+    // consumed by the rest of the pipeline.
+    const size_t kMaxQueuedDocs = 16 * DocumentSource::kBatchDocs;
+
+    /** Worker-local source that replays one chunk of scanned documents through the
+        worker's private copy of the $match/$project prefix.
+    */
+    class ChunkFeeder : public DocumentSource {
+    public:
+        static intrusive_ptr<ChunkFeeder> create(
+                const intrusive_ptr<ExpressionContext>& pExpCtx) {
+            return new ChunkFeeder(pExpCtx);
+        }
+
+        virtual boost::optional<Document> getNext() {
+            if (_docs.empty())
+                return boost::none;
+            Document out;
+            out.swap(_docs.front());
+            _docs.pop_front();
+            return out;
+        }
+
+        virtual const char* getSourceName() const { return "$parallelScanChunk"; }
+
+        virtual Value serialize(bool explain = false) const {
+            verify(false); // worker internal; never serialized
+            return Value();
+        }
+
+        virtual void setSource(DocumentSource* pSource) {
+            verify(false); // always the start of the worker's chain
+        }
+
+        virtual bool isValidInitialSource() const { return true; }
+
+        void add(const Document& doc) { _docs.push_back(doc); }
+
+    private:
+        ChunkFeeder(const intrusive_ptr<ExpressionContext>& pExpCtx)
+            : DocumentSource(pExpCtx)
+        {}
+
+        std::deque<Document> _docs;
+    };
+}
+
+    struct DocumentSourceParallelScan::SharedState {
+        SharedState()
+            : numWorkers(0)
+            , error(Status::OK())
+            , activeWorkers(0)
+            , shuttingDown(false)
+        {}
+
+        // immutable after construction
+        std::string ns;
+        std::vector<CursorId> cursorIds;
+        std::vector<BSONObj> stageSpecs;
+        int numWorkers;
+
+        // guards everything below
+        boost::mutex mutex;
+        boost::condition_variable notEmpty;
+        boost::condition_variable notFull;
+        std::deque<Document> queue;
+        Status error;
+        int activeWorkers;
+        bool shuttingDown;
+
+        static void run(boost::shared_ptr<SharedState> state, size_t workerId);
+
+    private:
+        static void scan(OperationContextImpl* txn,
+                         boost::shared_ptr<SharedState> state,
+                         size_t workerId);
+        static void setError(boost::shared_ptr<SharedState> state, const Status& status);
+    };
+
+    void DocumentSourceParallelScan::SharedState::run(boost::shared_ptr<SharedState> state,
+                                                      size_t workerId) {
+        Client::initThread("aggParallelScan");
+        try {
+            OperationContextImpl txn;
+            scan(&txn, state, workerId);
+        }
+        catch (const DBException& e) {
+            setError(state, e.toStatus());
+        }
+        catch (const std::exception& e) {
+            setError(state, Status(ErrorCodes::InternalError, e.what()));
+        }
+
+        {
+            boost::mutex::scoped_lock lk(state->mutex);
+            state->activeWorkers--;
+            state->notEmpty.notify_all();
+        }
+        cc().shutdown();
+    }
+
+    void DocumentSourceParallelScan::SharedState::scan(OperationContextImpl* txn,
+                                                       boost::shared_ptr<SharedState> state,
+                                                       size_t workerId) {
+        // Parse a private copy of the pushed down stages.  Stage implementations are not
+        // thread safe and ExpressionContext's refcount is not atomic, so nothing parsed
+        // on the consumer thread may be shared here.
+        intrusive_ptr<ExpressionContext> workerCtx =
+            new ExpressionContext(txn, NamespaceString(state->ns));
+        intrusive_ptr<ChunkFeeder> feeder = ChunkFeeder::create(workerCtx);
+        std::vector<intrusive_ptr<DocumentSource> > chain;
+        chain.push_back(feeder);
+        for (size_t i = 0; i < state->stageSpecs.size(); i++) {
+            BSONElement spec = state->stageSpecs[i].firstElement();
+            intrusive_ptr<DocumentSource> stage;
+            if (str::equals(spec.fieldName(), DocumentSourceMatch::matchName)) {
+                stage = DocumentSourceMatch::createFromBson(spec, workerCtx);
+            }
+            else if (str::equals(spec.fieldName(), DocumentSourceProject::projectName)) {
+                stage = DocumentSourceProject::createFromBson(spec, workerCtx);
+            }
+            else {
+                msgasserted(18526, str::stream() << "unexpected stage in parallel scan: "
+                                                 << spec.fieldName());
+            }
+            stage->setSource(chain.back().get());
+            chain.push_back(stage);
+        }
+        DocumentSource* const last = chain.back().get();
+
+        // This worker's share of the segment cursors.  Drain them a chunk at a time in
+        // round robin rather than one after another so that none of them sits idle long
+        // enough for the ClientCursorMonitor to time it out.
+        std::vector<CursorId> myCursors;
+        for (size_t i = workerId; i < state->cursorIds.size();
+             i += static_cast<size_t>(state->numWorkers)) {
+            myCursors.push_back(state->cursorIds[i]);
+        }
+        std::vector<bool> exhausted(myCursors.size(), false);
+        size_t remaining = myCursors.size();
+
+        while (remaining > 0) {
+            for (size_t i = 0; i < myCursors.size(); i++) {
+                if (exhausted[i])
+                    continue;
+
+                {
+                    boost::mutex::scoped_lock lk(state->mutex);
+                    if (state->shuttingDown || !state->error.isOK())
+                        return;
+                }
+
+                // Fetch one chunk while holding the collection lock.
+                {
+                    Lock::DBRead lock(txn->lockState(), state->ns);
+                    Client::Context ctx(state->ns, /*doVersion=*/false);
+                    Collection* collection = ctx.db()->getCollection(txn, state->ns);
+                    uassert(18527, "collection dropped during parallel scan", collection);
+
+                    ClientCursorPin pin(collection, myCursors[i]);
+                    ClientCursor* cursor = pin.c();
+                    uassert(18528, "parallel scan cursor no longer exists", cursor);
+
+                    Runner* runner = cursor->getRunner();
+                    uassert(18529,
+                            "could not restore parallel scan cursor",
+                            runner->restoreState(txn));
+
+                    BSONObj obj;
+                    Runner::RunnerState rstate = Runner::RUNNER_ADVANCED;
+                    for (size_t n = 0; n < kChunkDocs; n++) {
+                        rstate = runner->getNext(&obj, NULL);
+                        if (rstate != Runner::RUNNER_ADVANCED)
+                            break;
+                        feeder->add(Document(obj));
+                    }
+
+                    if (rstate == Runner::RUNNER_ADVANCED) {
+                        runner->saveState();
+                        pin.release();
+                    }
+                    else {
+                        const bool wasEOF = (rstate == Runner::RUNNER_EOF);
+                        exhausted[i] = true;
+                        remaining--;
+                        pin.deleteUnderlying();
+                        uassert(18530, "parallel scan cursor died", wasEOF);
+                    }
+                }
+
+                // Filter/transform outside the lock, then funnel the results.
+                std::vector<Document> results;
+                while (boost::optional<Document> next = last->getNext()) {
+                    results.push_back(Document());
+                    results.back().swap(*next);
+                }
+                if (results.empty())
+                    continue;
+
+                boost::mutex::scoped_lock lk(state->mutex);
+                while (state->queue.size() >= kMaxQueuedDocs && !state->shuttingDown) {
+                    state->notFull.wait(lk);
+                }
+                if (state->shuttingDown)
+                    return;
+                for (size_t j = 0; j < results.size(); j++) {
+                    state->queue.push_back(Document());
+                    state->queue.back().swap(results[j]);
+                }
+                state->notEmpty.notify_one();
+            }
+        }
+    }
+
+    void DocumentSourceParallelScan::SharedState::setError(boost::shared_ptr<SharedState> state,
+                                                           const Status& status) {
+        boost::mutex::scoped_lock lk(state->mutex);
+        if (state->error.isOK()) {
+            state->error = status;
+        }
+        state->notEmpty.notify_all();
+        state->notFull.notify_all();
+    }
+
+    // ----
+
+    DocumentSourceParallelScan::DocumentSourceParallelScan(
+            const std::string& ns,
+            const std::vector<CursorId>& cursorIds,
+            const std::vector<BSONObj>& stageSpecs,
+            int numWorkers,
+            const intrusive_ptr<ExpressionContext>& pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _state(new SharedState())
+        , _numWorkers(numWorkers)
+        , _started(false)
+    {
+        _state->ns = ns;
+        _state->cursorIds = cursorIds;
+        for (size_t i = 0; i < stageSpecs.size(); i++) {
+            _state->stageSpecs.push_back(stageSpecs[i].getOwned());
+        }
+        _state->numWorkers = numWorkers;
+    }
+
+    DocumentSourceParallelScan::~DocumentSourceParallelScan() {
+        dispose();
+    }
+
+    intrusive_ptr<DocumentSourceParallelScan> DocumentSourceParallelScan::create(
+            const std::string& ns,
+            const std::vector<CursorId>& cursorIds,
+            const std::vector<BSONObj>& stageSpecs,
+            int numWorkers,
+            const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        verify(!cursorIds.empty());
+        if (static_cast<size_t>(numWorkers) > cursorIds.size()) {
+            numWorkers = cursorIds.size(); // no point in idle workers
+        }
+        return new DocumentSourceParallelScan(ns, cursorIds, stageSpecs, numWorkers, pExpCtx);
+    }
+
+    const char* DocumentSourceParallelScan::getSourceName() const {
+        return "$parallelCollectionScan";
+    }
+
+    void DocumentSourceParallelScan::setSource(DocumentSource* pSource) {
+        /* this doesn't take a source */
+        verify(false);
+    }
+
+    Value DocumentSourceParallelScan::serialize(bool explain) const {
+        // This stage is created after any mongos-side split, so it only serializes for
+        // explain.
+        verify(explain);
+        std::vector<Value> stages;
+        for (size_t i = 0; i < _state->stageSpecs.size(); i++) {
+            stages.push_back(Value(Document(_state->stageSpecs[i])));
+        }
+        return Value(DOC(getSourceName() <<
+                         DOC("numCursors" << static_cast<int>(_state->cursorIds.size())
+                          << "numWorkers" << _numWorkers
+                          << "stages" << Value(stages))));
+    }
+
+    void DocumentSourceParallelScan::ensureStarted() {
+        if (_started)
+            return;
+        _started = true;
+
+        {
+            boost::mutex::scoped_lock lk(_state->mutex);
+            _state->activeWorkers = _numWorkers;
+        }
+        for (int i = 0; i < _numWorkers; i++) {
+            boost::thread worker(stdx::bind(&SharedState::run,
+                                            _state,
+                                            static_cast<size_t>(i)));
+            worker.detach();
+        }
+    }
+
+    boost::optional<Document> DocumentSourceParallelScan::getNext() {
+        pExpCtx->checkForInterrupt();
+        ensureStarted();
+
+        boost::mutex::scoped_lock lk(_state->mutex);
+        for (;;) {
+            if (!_state->queue.empty()) {
+                Document out;
+                out.swap(_state->queue.front());
+                _state->queue.pop_front();
+                _state->notFull.notify_one();
+                return out;
+            }
+
+            uassertStatusOK(_state->error);
+            if (_state->activeWorkers == 0)
+                return boost::none; // every segment fully drained
+
+            // Wake up periodically so killOp() on our operation is honored even while
+            // the workers are stalled.
+            _state->notEmpty.timed_wait(lk, boost::posix_time::milliseconds(100));
+            if (pExpCtx->opCtx) {
+                pExpCtx->opCtx->checkForInterrupt();
+            }
+        }
+    }
+
+    size_t DocumentSourceParallelScan::getNextBatch(std::vector<Document>* out, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+        ensureStarted();
+
+        boost::mutex::scoped_lock lk(_state->mutex);
+        for (;;) {
+            if (!_state->queue.empty()) {
+                size_t numAppended = 0;
+                while (numAppended < maxDocs && !_state->queue.empty()) {
+                    out->push_back(Document());
+                    out->back().swap(_state->queue.front());
+                    _state->queue.pop_front();
+                    numAppended++;
+                }
+                _state->notFull.notify_all();
+                return numAppended;
+            }
+
+            uassertStatusOK(_state->error);
+            if (_state->activeWorkers == 0)
+                return 0;
+
+            _state->notEmpty.timed_wait(lk, boost::posix_time::milliseconds(100));
+            if (pExpCtx->opCtx) {
+                pExpCtx->opCtx->checkForInterrupt();
+            }
+        }
+    }
+
+    void DocumentSourceParallelScan::dispose() {
+        // Workers are detached and share ownership of _state; flag them down and let
+        // them exit at their next chunk boundary.  We must not join them or touch the
+        // cursor registries here -- dispose() runs when our own cursor is killed (with
+        // registry locks held), and the segment cursors die with the collection or are
+        // reaped by the cursor monitor once idle.
+        boost::mutex::scoped_lock lk(_state->mutex);
+        _state->shuttingDown = true;
+        _state->queue.clear();
+        _state->notFull.notify_all();
+        _state->notEmpty.notify_all();
+    }
+
+}  // namespace mongo
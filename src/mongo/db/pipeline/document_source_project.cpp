@@ -42,6 +42,7 @@ namespace mongo {
                                                  const intrusive_ptr<ExpressionObject>& exprObj)
         : DocumentSource(pExpCtx)
         , pEO(exprObj)
+        , _numVariables(0)
     { }
 
     const char *DocumentSourceProject::getSourceName() const {
@@ -67,18 +68,180 @@ namespace mongo {
           it is found, because we took care of it above.
         */
         _variables->setRoot(*input);
+        for (size_t i = 0; i < _commonSubexpressions.size(); i++) {
+            _variables->setValue(_commonSubexpressions[i].first,
+                                 _commonSubexpressions[i].second->evaluate(_variables.get()));
+        }
         pEO->addToDocument(out, *input, _variables.get());
         _variables->clearRoot();
 
         return out.freeze();
     }
 
+    size_t DocumentSourceProject::getNextBatch(std::vector<Document>* out, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+
+        std::vector<Document> input;
+        if (!pSource->getNextBatch(&input, maxDocs))
+            return 0;
+
+        /* projection is 1:1, so one pass over the input batch produces the output batch */
+        const size_t sizeHint = pEO->getSizeHint();
+        for (size_t i = 0; i < input.size(); i++) {
+            MutableDocument projected (sizeHint);
+            projected.copyMetaDataFrom(input[i]);
+
+            _variables->setRoot(input[i]);
+            for (size_t n = 0; n < _commonSubexpressions.size(); n++) {
+                _variables->setValue(_commonSubexpressions[n].first,
+                                     _commonSubexpressions[n].second->evaluate(_variables.get()));
+            }
+            pEO->addToDocument(projected, input[i], _variables.get());
+            _variables->clearRoot();
+
+            out->push_back(Document());
+            Document result = projected.freeze();
+            out->back().swap(result);
+        }
+        return input.size();
+    }
+
+    namespace {
+
+        /**
+         * Common subexpression elimination over a $project expression tree.
+         *
+         * Operator subtrees are keyed by their serialized form.  A subtree that
+         * appears more than once is hoisted: it gets a variable slot that
+         * DocumentSourceProject computes once per input document, and every
+         * occurrence is replaced with a reference to the slot.
+         *
+         * Only occurrences in unconditionally evaluated positions may trigger
+         * hoisting.  An occurrence in a lazily evaluated position (a branch of
+         * $cond, the fallback of $ifNull, or an operand of $and/$or after the
+         * first) is still replaced once the subtree is hoisted anyway, but never
+         * forces evaluation of something the original expression might have
+         * skipped.  $let and $map bodies are opaque to this pass (they do not
+         * expose their children), since their subtrees may use variables that are
+         * not in scope at the stage level.
+         */
+        class CommonSubexpressionEliminator {
+        public:
+            explicit CommonSubexpressionEliminator(Variables::Id* nextVariableId)
+                : _nextVariableId(nextVariableId) {}
+
+            /** first pass: count the operator subtrees under 'expr' */
+            void countSubtrees(Expression* expr, bool guaranteed) {
+                if (!expr)
+                    return;
+                if (dynamic_cast<ExpressionNary*>(expr)) {
+                    SubtreeInfo& info = _subtrees[expr->serialize(false)];
+                    info.total++;
+                    if (guaranteed)
+                        info.guaranteed++;
+                }
+                for (size_t i = 0; i < expr->getChildCount(); i++) {
+                    countSubtrees(expr->getChildSlot(i)->get(),
+                                  guaranteed && !isLazyChild(expr, i));
+                }
+            }
+
+            /** second pass: hoist duplicated subtrees and rewrite 'slot' in place */
+            void replaceSubtrees(intrusive_ptr<Expression>* slot) {
+                Expression* expr = slot->get();
+                if (!expr)
+                    return;
+
+                if (dynamic_cast<ExpressionNary*>(expr)) {
+                    SubtreeMap::iterator it = _subtrees.find(expr->serialize(false));
+                    if (it != _subtrees.end()
+                            && it->second.total > 1
+                            && it->second.guaranteed > 0) {
+                        SubtreeInfo& info = it->second;
+                        if (info.varName.empty()) {
+                            info.varId = (*_nextVariableId)++;
+                            info.varName = str::stream() << "__commonExpr" << _commons.size();
+                            _commons.push_back(std::make_pair(info.varId, *slot));
+                        }
+                        *slot = ExpressionFieldPath::createVarReference(info.varName,
+                                                                        info.varId);
+                        return; // every occurrence collapses to the same reference
+                    }
+                }
+
+                for (size_t i = 0; i < expr->getChildCount(); i++) {
+                    replaceSubtrees(expr->getChildSlot(i));
+                }
+            }
+
+            const vector<pair<Variables::Id, intrusive_ptr<Expression> > >& commons() const {
+                return _commons;
+            }
+
+        private:
+            struct SubtreeInfo {
+                SubtreeInfo() : total(0), guaranteed(0), varId(0) {}
+
+                int total;      // occurrences anywhere in the tree
+                int guaranteed; // occurrences in unconditionally evaluated positions
+                Variables::Id varId;
+                string varName; // empty until the subtree is hoisted
+            };
+
+            struct ValueCmp {
+                bool operator()(const Value& l, const Value& r) const {
+                    return Value::compare(l, r) < 0;
+                }
+            };
+
+            typedef std::map<Value, SubtreeInfo, ValueCmp> SubtreeMap;
+
+            /** whether 'parent' may skip evaluating its i'th child */
+            static bool isLazyChild(Expression* parent, size_t i) {
+                ExpressionNary* nary = dynamic_cast<ExpressionNary*>(parent);
+                if (!nary)
+                    return false;
+                const char* op = nary->getOpName();
+                if (str::equals(op, "$and") || str::equals(op, "$or"))
+                    return i > 0;
+                if (str::equals(op, "$cond"))
+                    return i > 0; // only the condition is always evaluated
+                if (str::equals(op, "$ifNull"))
+                    return i == 1;
+                return false;
+            }
+
+            Variables::Id* _nextVariableId;
+            SubtreeMap _subtrees;
+            vector<pair<Variables::Id, intrusive_ptr<Expression> > > _commons;
+        };
+    }
+
     void DocumentSourceProject::optimize() {
         intrusive_ptr<Expression> pE(pEO->optimize());
         pEO = dynamic_pointer_cast<ExpressionObject>(pE);
+
+        if (!_commonSubexpressions.empty())
+            return; // already rewritten; the pass must not run twice
+
+        /* compute subtrees that several output fields share once per document */
+        CommonSubexpressionEliminator cse(&_numVariables);
+        cse.countSubtrees(pEO.get(), true);
+        for (size_t i = 0; i < pEO->getChildCount(); i++) {
+            cse.replaceSubtrees(pEO->getChildSlot(i));
+        }
+        _commonSubexpressions = cse.commons();
+        if (!_commonSubexpressions.empty()) {
+            _variables.reset(new Variables(_numVariables));
+        }
     }
 
     Value DocumentSourceProject::serialize(bool explain) const {
+        if (!explain && !_commonSubexpressions.empty()) {
+            // the optimized tree references variable slots that only exist in this
+            // process; send the user's specification and let the receiver optimize
+            return Value(DOC(getSourceName() << Value(Document(_raw))));
+        }
         return Value(DOC(getSourceName() << pEO->serialize(explain)));
     }
 
@@ -106,6 +269,7 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceProject> pProject(new DocumentSourceProject(pExpCtx, exprObj));
         pProject->_variables.reset(new Variables(idGenerator.getIdCount()));
+        pProject->_numVariables = idGenerator.getIdCount();
 
         BSONObj projectObj = elem.Obj();
         pProject->_raw = projectObj.getOwned();
@@ -116,6 +280,11 @@ namespace mongo {
     DocumentSource::GetDepsReturn DocumentSourceProject::getDependencies(DepsTracker* deps) const {
         vector<string> path; // empty == top-level
         pEO->addDependencies(deps, &path);
+        // hoisted common subexpressions keep their field dependencies even though
+        // the rewritten tree only sees variable references to them
+        for (size_t i = 0; i < _commonSubexpressions.size(); i++) {
+            _commonSubexpressions[i].second->addDependencies(deps);
+        }
         return EXHAUSTIVE_FIELDS;
     }
 }
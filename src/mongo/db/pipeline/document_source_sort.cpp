@@ -35,8 +35,17 @@
 #include "db/pipeline/expression.h"
 #include "db/pipeline/expression_context.h"
 #include "db/pipeline/value.h"
+#include "db/server_parameters.h"
 
 namespace mongo {
+
+    // Memory $sort may use before it must spill (with allowDiskUse) or fail.  A
+    // $sort with a coalesced $limit uses the top-k sorter and typically stays
+    // well under this bound.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceSortMaxMemoryBytes,
+                                  int,
+                                  100*1024*1024);
+
     const char DocumentSourceSort::sortName[] = "$sort";
 
     const char *DocumentSourceSort::getSourceName() const {
@@ -207,7 +216,7 @@ namespace mongo {
         if (limitSrc)
             opts.limit = limitSrc->getLimit();
 
-        opts.maxMemoryUsageBytes = 100*1024*1024;
+        opts.maxMemoryUsageBytes = internalDocumentSourceSortMaxMemoryBytes;
         if (pExpCtx->extSortAllowed && !pExpCtx->inRouter) {
             opts.extSortAllowed = true;
             opts.tempDir = pExpCtx->tempDir;
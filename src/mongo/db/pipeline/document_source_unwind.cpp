@@ -52,6 +52,15 @@ namespace mongo {
          */
         boost::optional<Document> getNext();
 
+        /** @return true if there are no array elements left in the current document. */
+        bool exhausted() const;
+
+        /** @return the array element getNext() would expand next. */
+        Value peekNextElement() const;
+
+        /** Skip the next array element without building an output document. */
+        void skipNextElement() { _index++; }
+
     private:
         // Path to the array to unwind.
         const FieldPath _unwindPath;
@@ -92,8 +101,17 @@ namespace mongo {
         _inputArray = pathValue;
     }
 
+    bool DocumentSourceUnwind::Unwinder::exhausted() const {
+        return _inputArray.missing() || _index == _inputArray.getArrayLength();
+    }
+
+    Value DocumentSourceUnwind::Unwinder::peekNextElement() const {
+        dassert(!exhausted());
+        return _inputArray[_index];
+    }
+
     boost::optional<Document> DocumentSourceUnwind::Unwinder::getNext() {
-        if (_inputArray.missing() || _index == _inputArray.getArrayLength())
+        if (exhausted())
             return boost::none;
 
         // If needed, this will automatically clone all the documents along the
@@ -110,6 +128,61 @@ namespace mongo {
 
     const char DocumentSourceUnwind::unwindName[] = "$unwind";
 
+    namespace {
+
+        /** @return true if 'field' is 'path' or a dotted descendant of it. */
+        bool fieldOnPath(const StringData& field, const StringData& path) {
+            if (!field.startsWith(path))
+                return false;
+            return field.size() == path.size() || field[path.size()] == '.';
+        }
+
+        /**
+         * @return true if every field 'query' examines lies on or under 'path', so the
+         * predicate's outcome depends only on the value at 'path'.  Conservative: any
+         * top-level operator other than $and/$or/$nor of such clauses disqualifies the
+         * query ($where and $text may inspect the whole document).
+         */
+        bool queryRestrictedToPath(const BSONObj& query, const StringData& path) {
+            BSONForEach(elem, query) {
+                const StringData fieldName = elem.fieldNameStringData();
+                if (fieldName.startsWith("$")) {
+                    if (fieldName == "$and" || fieldName == "$or" || fieldName == "$nor") {
+                        if (elem.type() != Array)
+                            return false;
+                        BSONForEach(clause, elem.embeddedObject()) {
+                            if (clause.type() != Object ||
+                                !queryRestrictedToPath(clause.Obj(), path))
+                                return false;
+                        }
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                else if (!fieldOnPath(fieldName, path)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /** Append 'elem' to 'bob' nested under the trailing components of 'path'. */
+        void appendElementOnPath(BSONObjBuilder* bob,
+                                 const FieldPath& path,
+                                 size_t pathIndex,
+                                 const Value& elem) {
+            if (pathIndex == path.getPathLength() - 1) {
+                elem.addToBsonObj(bob, path.getFieldName(pathIndex));
+                return;
+            }
+            BSONObjBuilder sub(bob->subobjStart(path.getFieldName(pathIndex)));
+            appendElementOnPath(&sub, path, pathIndex + 1, elem);
+            sub.done();
+        }
+
+    } // namespace
+
     DocumentSourceUnwind::DocumentSourceUnwind(
         const intrusive_ptr<ExpressionContext> &pExpCtx):
         DocumentSource(pExpCtx) {
@@ -122,6 +195,26 @@ namespace mongo {
     boost::optional<Document> DocumentSourceUnwind::getNext() {
         pExpCtx->checkForInterrupt();
 
+        if (_match) {
+            // Fused $unwind + $match: test each array element before its output document
+            // is built, so non-matching elements (the common case in filtering pipelines)
+            // never pay the partial deep clone an unwound document requires.
+            while (true) {
+                while (_unwinder->exhausted()) {
+                    boost::optional<Document> input = pSource->getNext();
+                    if (!input)
+                        return boost::none; // input exhausted
+
+                    _unwinder->resetDocument(*input);
+                }
+
+                if (_match->matches(matchTargetFor(_unwinder->peekNextElement())))
+                    return _unwinder->getNext();
+
+                _unwinder->skipNextElement();
+            }
+        }
+
         boost::optional<Document> out = _unwinder->getNext();
         while (!out) {
             // No more elements in array currently being unwound. This will loop if the input
@@ -138,11 +231,44 @@ namespace mongo {
         return out;
     }
 
+    bool DocumentSourceUnwind::coalesce(const intrusive_ptr<DocumentSource>& pNextSource) {
+        DocumentSourceMatch* match = dynamic_cast<DocumentSourceMatch*>(pNextSource.get());
+        if (!match || _match || match->isTextQuery())
+            return false;
+
+        // The predicate must depend only on the unwound field: across the elements of one
+        // input document the unwind path is the only value that changes, so such a
+        // predicate can be evaluated against each element in isolation.
+        if (!queryRestrictedToPath(match->getQuery(), _unwindPath->getPath(false)))
+            return false;
+
+        _match = match;
+        return true;
+    }
+
+    BSONObj DocumentSourceUnwind::matchTargetFor(const Value& elem) const {
+        // The probe holds only the unwind path: the absorbed predicate examines nothing
+        // else (checked in coalesce()), so it matches the probe exactly when it would
+        // match the full unwound document.
+        BSONObjBuilder bob;
+        appendElementOnPath(&bob, *_unwindPath, 0, elem);
+        return bob.obj();
+    }
+
     Value DocumentSourceUnwind::serialize(bool explain) const {
         verify(_unwindPath);
         return Value(DOC(getSourceName() << _unwindPath->getPath(true)));
     }
 
+    void DocumentSourceUnwind::serializeToArray(vector<Value>& array, bool explain) const {
+        array.push_back(serialize(explain));
+        if (_match) {
+            // The absorbed $match keeps its own stage in serialized form so the pipeline
+            // re-parses (and explains) as written.
+            _match->serializeToArray(array, explain);
+        }
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceUnwind::getDependencies(DepsTracker* deps) const {
         deps->fields.insert(_unwindPath->getPath(false));
         return SEE_NEXT;
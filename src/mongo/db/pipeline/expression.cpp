@@ -958,7 +958,7 @@ namespace {
                 if (!_excludeId && _atRoot && field.first == "_id") {
                     // _id from the root doc is always included (until exclusion is supported)
                     // not updating doneFields since "_id" isn't in _expressions
-                    out.addField(field.first, field.second);
+                    out.addFieldConsume(field.first, field.second);
                 }
                 continue;
             }
@@ -970,7 +970,7 @@ namespace {
 
             if (!expr) {
                 // This means pull the matching field from the input document
-                out.addField(field.first, field.second);
+                out.addFieldConsume(field.first, field.second);
                 continue;
             }
 
@@ -991,7 +991,7 @@ namespace {
                    force the appearance of non-existent fields.
                    */
                 if (!pValue.missing())
-                    out.addField(field.first, pValue);
+                    out.addFieldConsume(field.first, pValue);
 
                 continue;
             }
@@ -1004,7 +1004,8 @@ namespace {
             if (valueType == Object) {
                 MutableDocument sub (exprObj->getSizeHint());
                 exprObj->addToDocument(sub, field.second.getDocument(), vars);
-                out.addField(field.first, sub.freezeToValue());
+                Value subValue = sub.freezeToValue();
+                out.addFieldConsume(field.first, subValue);
             }
             else if (valueType == Array) {
                 /*
@@ -1024,7 +1025,8 @@ namespace {
                     result.push_back(doc.freezeToValue());
                 }
 
-                out.addField(field.first, Value::consume(result));
+                Value arrValue = Value::consume(result);
+                out.addFieldConsume(field.first, arrValue);
             }
             else {
                 verify( false );
@@ -1063,7 +1065,7 @@ namespace {
                 continue;
 
 
-            out.addField(fieldName, pValue);
+            out.addFieldConsume(fieldName, pValue);
         }
     }
 
@@ -1072,6 +1074,13 @@ namespace {
         return _expressions.size() + (_excludeId ? 0 : 1);
     }
 
+    intrusive_ptr<Expression>* ExpressionObject::getChildSlot(size_t i) {
+        dassert(i < _expressions.size());
+        FieldMap::iterator it = _expressions.begin();
+        std::advance(it, i);
+        return &it->second;
+    }
+
     Document ExpressionObject::evaluateDocument(Variables* vars) const {
         /* create and populate the result */
         MutableDocument out (getSizeHint());
@@ -1197,6 +1206,12 @@ namespace {
     }
 
 
+    intrusive_ptr<ExpressionFieldPath> ExpressionFieldPath::createVarReference(
+            const string& varName,
+            Variables::Id varId) {
+        return new ExpressionFieldPath(varName, varId);
+    }
+
     ExpressionFieldPath::ExpressionFieldPath(const string& theFieldPath, Variables::Id variable)
         : _fieldPath(theFieldPath)
         , _variable(variable)
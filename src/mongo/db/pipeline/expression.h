@@ -182,6 +182,17 @@ namespace mongo {
         /** simple expressions are just inclusion exclusion as supported by ExpressionObject */
         virtual bool isSimple() { return false; }
 
+        /**
+         * Tree-rewriting support.  A node that exposes its children here can have
+         * subtrees replaced in place by rewriting passes (see the common
+         * subexpression pass in DocumentSourceProject::optimize()).  Nodes that do
+         * not (the default) are treated as opaque leaves by such passes.
+         */
+        virtual size_t getChildCount() const { return 0; }
+
+        /** pointer to the i'th child's slot; only valid for i < getChildCount() */
+        virtual intrusive_ptr<Expression>* getChildSlot(size_t i) { return NULL; }
+
 
         /**
          * Serialize the Expression tree recursively.
@@ -302,6 +313,9 @@ namespace mongo {
         */
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
+        virtual size_t getChildCount() const { return vpOperand.size(); }
+        virtual intrusive_ptr<Expression>* getChildSlot(size_t i) { return &vpOperand[i]; }
+
         // TODO split this into two functions
         virtual bool isAssociativeAndCommutative() const { return false; }
 
@@ -555,8 +569,24 @@ namespace mongo {
             const std::string& raw,
             const VariablesParseState& vps);
 
+        /**
+         * Creates an expression that returns the value bound to 'varId'.  Used by
+         * rewriting passes that compute a subtree once into a variable slot and
+         * reference it from several places; 'varName' only affects serialization.
+         */
+        static intrusive_ptr<ExpressionFieldPath> createVarReference(
+            const std::string& varName,
+            Variables::Id varId);
+
         const FieldPath& getFieldPath() const { return _fieldPath; }
 
+        /**
+         * Returns true when this path reads directly from the input document
+         * ("$foo" rather than a user-defined variable).  CURRENT counts as long
+         * as it is still equivalent to ROOT.
+         */
+        bool isRootFieldPath() const { return _variable == Variables::ROOT_ID; }
+
     private:
         ExpressionFieldPath(const std::string& fieldPath, Variables::Id variable);
 
@@ -727,6 +757,10 @@ namespace mongo {
         virtual Value evaluateInternal(Variables* vars) const;
         virtual Value serialize(bool explain) const;
 
+        /** Note that a child slot holds NULL for an inclusion from the source document. */
+        virtual size_t getChildCount() const { return _expressions.size(); }
+        virtual intrusive_ptr<Expression>* getChildSlot(size_t i);
+
         /// like evaluate(), but return a Document instead of a Value-wrapped Document.
         Document evaluateDocument(Variables* vars) const;
 
@@ -498,19 +498,30 @@ namespace mongo {
         // cant use subArrayStart() due to error handling
         BSONArrayBuilder resultArray;
         DocumentSource* finalSource = sources.back().get();
-        while (boost::optional<Document> next = finalSource->getNext()) {
-            // add the document to the result set
-            BSONObjBuilder documentBuilder (resultArray.subobjStart());
-            next->toBson(&documentBuilder);
-            documentBuilder.doneFast();
-            // object will be too large, assert. the extra 1KB is for headers
-            uassert(16389,
-                    str::stream() << "aggregation result exceeds maximum document size ("
-                                  << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
-                    resultArray.len() < BSONObjMaxUserSize - 1024);
+        vector<Document> batch;
+        while (true) {
+            batch.clear();
+            if (!finalSource->getNextBatch(&batch, DocumentSource::kBatchDocs))
+                break;
+
+            for (size_t i = 0; i < batch.size(); i++) {
+                // add the document to the result set
+                BSONObjBuilder documentBuilder (resultArray.subobjStart());
+                batch[i].toBson(&documentBuilder);
+                documentBuilder.doneFast();
+                // object will be too large, assert. the extra 1KB is for headers
+                uassert(16389,
+                        str::stream() << "aggregation result exceeds maximum document size ("
+                                      << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
+                        resultArray.len() < BSONObjMaxUserSize - 1024);
+            }
         }
 
         resultArray.done();
+
+        // the result size is known now; reserve the reply space once instead of
+        // letting appendArray double-and-copy its way up to it
+        result.bb().reserveBytes(resultArray.len() + 64);
         result.appendArray("result", resultArray.arr());
     }
 
@@ -30,13 +30,19 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_runner.h"
+#include "mongo/db/query/multi_iterator_runner.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/s/d_logic.h"
 
@@ -72,8 +78,117 @@ namespace {
         intrusive_ptr<ExpressionContext> _ctx;
         DBDirectClient _client;
     };
+
+    bool hasWhereClause(const BSONObj& query) {
+        BSONForEach(elem, query) {
+            if (str::equals(elem.fieldName(), "$where"))
+                return true;
+            if (elem.isABSONObj() && hasWhereClause(elem.Obj()))
+                return true;
+        }
+        return false;
+    }
+
 }
 
+    /**
+     * Replaces the usual single-cursor source with a DocumentSourceParallelScan that
+     * drains disjoint segments of the collection (as handed out by
+     * Collection::getManyIterators, like the parallelCollectionScan command) on
+     * internalQueryParallelScanWorkers threads, running the leading $match/$project
+     * stages on each.
+     */
+    bool PipelineD::tryPrepareParallelScan(Collection* collection,
+                                           const intrusive_ptr<Pipeline>& pPipeline,
+                                           const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        const int numWorkers = internalQueryParallelScanWorkers;
+        if (numWorkers < 2 || !collection)
+            return false;
+
+        // Results come back in no particular order, so don't touch capped collections
+        // (insertion order is part of their contract).  Sharded collections need the
+        // shard filter that only the regular runner provides.
+        if (collection->isCapped() || pPipeline->isExplain())
+            return false;
+        if (pExpCtx->inShard || pExpCtx->inRouter)
+            return false;
+        const ChunkVersion unsharded(0, 0, OID());
+        if (!shardingState.getVersion(pExpCtx->ns.ns()).isWriteCompatibleWith(unsharded))
+            return false;
+
+        // Take the longest prefix of per-document, order-insensitive stages; the workers
+        // will each run a private copy of it.  $match with $text or $where stays on the
+        // regular path: $text needs a real query plan and $where must not run JS on
+        // several threads at once.
+        Pipeline::SourceContainer& sources = pPipeline->sources;
+        std::vector<BSONObj> stageSpecs;
+        size_t prefixLen = 0;
+        for (; prefixLen < sources.size(); prefixLen++) {
+            DocumentSource* ds = sources[prefixLen].get();
+            DocumentSourceMatch* match = dynamic_cast<DocumentSourceMatch*>(ds);
+            if (match) {
+                if (match->isTextQuery() || hasWhereClause(match->getQuery()))
+                    break;
+            }
+            else if (!dynamic_cast<DocumentSourceProject*>(ds)) {
+                break;
+            }
+
+            std::vector<Value> serialized;
+            ds->serializeToArray(serialized);
+            for (size_t i = 0; i < serialized.size(); i++) {
+                BSONObjBuilder bob;
+                serialized[i].getDocument().toBson(&bob);
+                stageSpecs.push_back(bob.obj());
+            }
+        }
+
+        if (prefixLen == 0 && !sources.empty()) {
+            // An initial $match we can't take needs the query planner, and an initial
+            // $sort may be answerable by an index; both beat a raw parallel scan.
+            if (dynamic_cast<DocumentSourceMatch*>(sources.front().get()) ||
+                dynamic_cast<DocumentSourceSort*>(sources.front().get()))
+                return false;
+        }
+
+        // Split the collection into segment cursors, mirroring parallelCollectionScan.
+        OwnedPointerVector<RecordIterator> iterators(collection->getManyIterators());
+        size_t numSegments = std::min(static_cast<size_t>(numWorkers), iterators.size());
+        if (numSegments < 2)
+            return false; // single extent (or empty); the regular cursor does fine
+
+        OwnedPointerVector<MultiIteratorRunner> runners;
+        for (size_t i = 0; i < numSegments; i++) {
+            runners.push_back(new MultiIteratorRunner(pExpCtx->ns.ns(), collection));
+        }
+        for (size_t i = 0; i < iterators.size(); i++) {
+            runners[i % numSegments]->addIterator(iterators.releaseAt(i));
+        }
+
+        std::vector<CursorId> cursorIds;
+        for (size_t i = 0; i < numSegments; i++) {
+            MultiIteratorRunner* runner = runners.releaseAt(i);
+            runner->saveState();
+            // The ClientCursor manages the runner's lifetime from here on; the workers
+            // pin it by id exactly as getMore would.
+            ClientCursor* cursor = new ClientCursor(collection, runner);
+            cursorIds.push_back(cursor->cursorid());
+        }
+
+        for (size_t i = 0; i < prefixLen; i++) {
+            sources.pop_front();
+        }
+
+        pPipeline->addInitialSource(DocumentSourceParallelScan::create(pExpCtx->ns.ns(),
+                                                                       cursorIds,
+                                                                       stageSpecs,
+                                                                       numWorkers,
+                                                                       pExpCtx));
+        LOG(1) << "aggregation using parallel collection scan over " << numSegments
+               << " segments with " << numWorkers << " workers";
+        return true;
+    }
+
     boost::shared_ptr<Runner> PipelineD::prepareCursorSource(
             Collection* collection,
             const intrusive_ptr<Pipeline>& pPipeline,
@@ -106,6 +221,12 @@ namespace {
             return boost::shared_ptr<Runner>(); // don't need a cursor
         }
 
+        // An eligible pipeline over an unsharded collection can scan segments of the
+        // collection on several threads, running its $match/$project prefix on each.
+        if (tryPrepareParallelScan(collection, pPipeline, pExpCtx)) {
+            return boost::shared_ptr<Runner>(); // the stage manages its own cursors
+        }
+
 
         // Look for an initial match. This works whether we got an initial query or not.
         // If not, it results in a "{}" query, which will be what we want in that case.
@@ -141,6 +262,44 @@ namespace {
             }
         }
 
+        /*
+          If instead the pipeline opens with a $group on a single field path,
+          feeding it from a cursor ordered on that field lets it emit each group
+          as its key completes, instead of building a hash table of every group
+          (see DocumentSourceGroup::setInputSorted()).  Only sound when no index
+          on the field is multikey: an array value would place its document at
+          several index positions, so equal group keys could arrive
+          non-adjacent.  The $group stays in the pipeline; we only ask the
+          runner for the ordering.
+        */
+        intrusive_ptr<DocumentSourceGroup> groupStage;
+        if (!sortStage && !sources.empty() && collection) {
+            groupStage = dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+            std::string groupPath;
+            if (groupStage && groupStage->getIdFieldPath(&groupPath)) {
+                bool indexed = false;
+                bool multikey = false;
+                IndexCatalog::IndexIterator ii =
+                    collection->getIndexCatalog()->getIndexIterator(false);
+                while (ii.more()) {
+                    IndexDescriptor* desc = ii.next();
+                    BSONElement firstKey = desc->keyPattern().firstElement();
+                    if (groupPath != firstKey.fieldName())
+                        continue;
+                    if (desc->isMultikey())
+                        multikey = true;
+                    // Only a plain, non-sparse btree component can hand every
+                    // document to the cursor in key order.
+                    if (firstKey.isNumber() && !desc->isSparse())
+                        indexed = true;
+                }
+                if (indexed && !multikey)
+                    sortObj = BSON(groupPath << 1);
+            }
+            if (sortObj.isEmpty())
+                groupStage = NULL;
+        }
+
         // Create the Runner.
         //
         // If we try to create a Runner that includes both the match and the
@@ -168,7 +327,7 @@ namespace {
 
         const WhereCallbackReal whereCallback(pExpCtx->ns.db());
 
-        if (sortStage) {
+        if (!sortObj.isEmpty()) {
             CanonicalQuery* cq;
             Status status =
                 CanonicalQuery::canonicalize(pExpCtx->ns,
@@ -183,10 +342,17 @@ namespace {
                 runner.reset(rawRunner);
                 sortInRunner = true;
 
-                sources.pop_front();
-                if (sortStage->getLimitSrc()) {
-                    // need to reinsert coalesced $limit after removing $sort
-                    sources.push_front(sortStage->getLimitSrc());
+                if (sortStage) {
+                    sources.pop_front();
+                    if (sortStage->getLimitSrc()) {
+                        // need to reinsert coalesced $limit after removing $sort
+                        sources.push_front(sortStage->getLimitSrc());
+                    }
+                }
+                else {
+                    // the ordering was requested for the leading $group, which
+                    // can now stream groups as their keys complete
+                    groupStage->setInputSorted();
                 }
             }
         }
@@ -77,6 +77,20 @@ namespace mongo {
 
     private:
         PipelineD(); // does not exist:  prevent instantiation
+
+        /**
+         * If the pipeline and collection are eligible, install a
+         * DocumentSourceParallelScan at the front of the pipeline in place of the usual
+         * single-cursor source, moving the leading $match/$project stages into it.
+         *
+         * Must be called while holding the collection read lock.
+         *
+         * @return true if the parallel source was installed
+         */
+        static bool tryPrepareParallelScan(
+            Collection* collection,
+            const intrusive_ptr<Pipeline> &pPipeline,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
     };
 
 } // namespace mongo
@@ -675,6 +675,56 @@ namespace mongo {
         verify(false);
     }
 
+    namespace {
+        // hashScalar's integer identity hash only applies where doubles are exact,
+        // so that equal numeric values hash equal whatever their representation.
+        const double kIdentityHashBound = 9007199254740992.0; // 2**53
+    }
+
+    size_t Value::hashScalar(const Value& v) {
+        switch (v.getType()) {
+        case NumberInt:
+            return static_cast<size_t>(v.getInt());
+
+        case NumberLong: {
+            const long long ll = v.getLong();
+            if (ll > -kIdentityHashBound && ll < kIdentityHashBound)
+                return static_cast<size_t>(ll);
+            break;
+        }
+
+        case NumberDouble: {
+            const double d = v.getDouble();
+            if (d > -kIdentityHashBound && d < kIdentityHashBound && d == floor(d))
+                return static_cast<size_t>(static_cast<long long>(d));
+            break;
+        }
+
+        case String:
+        case Symbol: { // same canonical type as String, must hash identically
+            StringData sd = v.getStringData();
+            unsigned out;
+            MurmurHash3_x86_32(sd.rawData(), sd.size(), 0, &out);
+            return out;
+        }
+
+        default:
+            break;
+        }
+        return Hash()(v); // anything else takes the generic per-type path
+    }
+
+    bool Value::equalScalar(const Value& l, const Value& r) {
+        if (l.getType() == String && r.getType() == String) {
+            // length first, so unequal-length keys never touch the bytes
+            StringData ls = l.getStringData();
+            StringData rs = r.getStringData();
+            return ls.size() == rs.size()
+                && memcmp(ls.rawData(), rs.rawData(), ls.size()) == 0;
+        }
+        return l == r;
+    }
+
     void Value::hash_combine(size_t &seed) const {
         BSONType type = getType();
 
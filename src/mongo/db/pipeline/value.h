@@ -247,6 +247,16 @@ namespace mongo {
             size_t operator()(const Value& rV) const;
         };
 
+        /**
+         * Monomorphic fast paths for hashing and equality of scalar (int, long,
+         * string) hash-map keys, skipping the generic per-type dispatch above.
+         * Values that compare equal hash equal, including across numeric
+         * representations, so these are safe for keys of any type; non-scalars
+         * simply fall through to the generic behavior.  See DocumentSourceGroup.
+         */
+        static size_t hashScalar(const Value& v);
+        static bool equalScalar(const Value& l, const Value& r);
+
         /// Call this after memcpying to update ref counts if needed
         void memcpyed() const { _storage.memcpyed(); }
 
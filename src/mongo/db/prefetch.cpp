@@ -56,7 +56,8 @@ namespace mongo {
                                                     &prefetchDocStats );
 
     void prefetchIndexPages(Collection* collection, const BSONObj& obj);
-    void prefetchRecordPages(OperationContext* txn, const char* ns, const BSONObj& obj);
+    bool prefetchRecordPages(OperationContext* txn, const char* ns, const BSONObj& obj,
+                             BSONObj* fetched = NULL);
 
 
     // prefetch for an oplog operation
@@ -98,10 +99,20 @@ namespace mongo {
         //     will be an insert. to do that we could do the prefetchRecordPage first and if DNE
         //     then we do #1.
         // 
-        // note that on deletes 'obj' does not have all the keys we would want to prefetch on.
-        // a way to achieve that would be to prefetch the record first, and then afterwards do 
-        // this part.
-        //
+        // on deletes 'obj' is just the delete criteria (normally only the _id), so it does
+        // not have the keys we would want to prefetch the secondary indexes on.  fetch the
+        // record first -- paging in the _id btree leaf and the document, both of which the
+        // applier touches anyway -- and then prefetch the indexes with the full document
+        // so we touch the leaf pages for the keys actually being removed.  delete-heavy
+        // replicated TTL workloads are the motivating case.
+        if (*opType == 'd' &&
+            // capped collections typically do not have an _id index for findById() to use
+            !collection->isCapped()) {
+            BSONObj fullDoc;
+            if (prefetchRecordPages(txn, ns, obj, &fullDoc))
+                obj = fullDoc;
+        }
+
         prefetchIndexPages(collection, obj);
 
         // do not prefetch the data for inserts; it doesn't exist yet
@@ -176,7 +187,10 @@ namespace mongo {
     }
 
     // page in the data pages for a record associated with an object
-    void prefetchRecordPages(OperationContext* txn, const char* ns, const BSONObj& obj) {
+    // @return true if the record was found; '*fetched' (when non-NULL) then holds an
+    //         owned copy of the document
+    bool prefetchRecordPages(OperationContext* txn, const char* ns, const BSONObj& obj,
+                             BSONObj* fetched) {
         BSONElement _id;
         if( obj.getObjectID(_id) ) {
             TimerHolder timer(&prefetchDocStats);
@@ -196,11 +210,15 @@ namespace mongo {
                     }
                     // hit the last page, in case we missed it above
                     _dummy_char += *(result.objdata() + result.objsize() - 1);
+                    if ( fetched )
+                        *fetched = result.getOwned();
+                    return true;
                 }
             }
             catch(const DBException& e) {
                 LOG(2) << "ignoring exception in prefetchRecordPages(): " << e.what() << endl;
             }
         }
+        return false;
     }
 }
@@ -306,6 +306,104 @@ namespace {
         }
     }
 
+    //
+    // Incremental 64-bit FNV-1a over the shape discriminators, fed during a single
+    // pre-order walk with no intermediate string.  Hashes the same information the
+    // string encoders above emit, so two queries with equal cache keys always have
+    // equal shape hashes.  See CanonicalQuery::getPlanCacheShapeHash().
+    //
+
+    const unsigned long long kShapeHashOffsetBasis = 14695981039346656037ULL;
+    const unsigned long long kShapeHashPrime = 1099511628211ULL;
+
+    inline void hashShapeByte(char c, unsigned long long* h) {
+        *h = (*h ^ static_cast<unsigned char>(c)) * kShapeHashPrime;
+    }
+
+    void hashShapeString(const StringData& s, unsigned long long* h) {
+        for (size_t i = 0; i < s.size(); ++i) {
+            hashShapeByte(s[i], h);
+        }
+        // Terminate each field so adjacent strings can't alias each other.
+        hashShapeByte('\0', h);
+    }
+
+    void hashShapeTree(const MatchExpression* tree, unsigned long long* h) {
+        hashShapeString(encodeMatchType(tree->matchType()), h);
+        hashShapeString(tree->path(), h);
+
+        // Geo predicates are rare enough that reusing the string encoders for their
+        // extra discriminators doesn't matter.
+        if (MatchExpression::GEO == tree->matchType()) {
+            mongoutils::str::stream os;
+            encodeGeoMatchExpression(static_cast<const GeoMatchExpression*>(tree), &os);
+            hashShapeString(string(os), h);
+        }
+        else if (MatchExpression::GEO_NEAR == tree->matchType()) {
+            mongoutils::str::stream os;
+            encodeGeoNearMatchExpression(static_cast<const GeoNearMatchExpression*>(tree), &os);
+            hashShapeString(string(os), h);
+        }
+
+        if (tree->numChildren() > 0) {
+            hashShapeByte(kEncodeChildrenBegin, h);
+            for (size_t i = 0; i < tree->numChildren(); ++i) {
+                if (i > 0) {
+                    hashShapeByte(kEncodeChildrenSeparator, h);
+                }
+                hashShapeTree(tree->getChild(i), h);
+            }
+            hashShapeByte(kEncodeChildrenEnd, h);
+        }
+    }
+
+    void hashShapeSort(const BSONObj& sortObj, unsigned long long* h) {
+        if (sortObj.isEmpty()) {
+            return;
+        }
+
+        hashShapeByte(kEncodeSortSection, h);
+
+        BSONObjIterator it(sortObj);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            if (LiteParsedQuery::isTextScoreMeta(elt)) {
+                hashShapeByte('t', h);
+            }
+            else if (elt.numberInt() == 1) {
+                hashShapeByte('a', h);
+            }
+            else {
+                hashShapeByte('d', h);
+            }
+            hashShapeString(elt.fieldName(), h);
+        }
+    }
+
+    void hashShapeProj(const BSONObj& projObj, unsigned long long* h) {
+        if (projObj.isEmpty()) {
+            return;
+        }
+
+        hashShapeByte(kEncodeProjectionSection, h);
+
+        // Same field-name ordering as the string encoder.
+        std::map<StringData, BSONElement> elements;
+
+        BSONObjIterator it(projObj);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            elements[elt.fieldNameStringData()] = elt;
+        }
+
+        for (std::map<StringData, BSONElement>::const_iterator i = elements.begin();
+             i != elements.end(); ++i) {
+            const BSONElement& elt = (*i).second;
+            hashShapeString(elt.toString(false, false), h);
+            hashShapeString(elt.fieldName(), h);
+        }
+    }
+
 } // namespace
 
 namespace mongo {
@@ -503,7 +601,7 @@ namespace mongo {
             return validStatus;
         }
 
-        this->generateCacheKey();
+        this->generateShapeHash();
 
         // Validate the projection if there is one.
         if (!_pq->getProj().isEmpty()) {
@@ -559,15 +657,27 @@ namespace mongo {
     }
 
     const PlanCacheKey& CanonicalQuery::getPlanCacheKey() const {
+        if (!_cacheKeyComputed) {
+            generateCacheKey();
+        }
         return _cacheKey;
     }
 
-    void CanonicalQuery::generateCacheKey(void) {
+    void CanonicalQuery::generateCacheKey() const {
         mongoutils::str::stream ss;
         encodePlanCacheKeyTree(_root.get(), &ss);
         encodePlanCacheKeySort(_pq->getSort(), &ss);
         encodePlanCacheKeyProj(_pq->getProj(), &ss);
         _cacheKey = ss;
+        _cacheKeyComputed = true;
+    }
+
+    void CanonicalQuery::generateShapeHash() {
+        unsigned long long h = kShapeHashOffsetBasis;
+        hashShapeTree(_root.get(), &h);
+        hashShapeSort(_pq->getSort(), &h);
+        hashShapeProj(_pq->getProj(), &h);
+        _shapeHash = h;
     }
 
     // static
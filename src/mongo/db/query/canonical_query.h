@@ -144,9 +144,19 @@ namespace mongo {
 
         /**
          * Get the cache key for this canonical query.
+         * Built lazily on first use: the fast path through the plan cache matches on
+         * the shape hash below and never needs the string form.
          */
         const PlanCacheKey& getPlanCacheKey() const;
 
+        /**
+         * 64-bit hash of this query's shape, computed incrementally over the match
+         * expression tree walk (plus sort and projection) with no intermediate
+         * string.  Hashes the same discriminators the string cache key encodes, so
+         * two queries with equal cache keys have equal shape hashes.
+         */
+        unsigned long long getPlanCacheShapeHash() const { return _shapeHash; }
+
         // Debugging
         std::string toString() const;
         std::string toStringShort() const;
@@ -192,13 +202,18 @@ namespace mongo {
 
     private:
         // You must go through canonicalize to create a CanonicalQuery.
-        CanonicalQuery() { }
+        CanonicalQuery() : _cacheKeyComputed(false), _shapeHash(0) { }
 
         /**
-         * Computes and stores the cache key / query shape
-         * for this query.
+         * Computes and stores the string cache key for this query.
+         * Called lazily by getPlanCacheKey().
          */
-        void generateCacheKey(void);
+        void generateCacheKey() const;
+
+        /**
+         * Computes and stores the incremental shape hash for this query.
+         */
+        void generateShapeHash();
 
         /**
          * Takes ownership of 'root' and 'lpq'.
@@ -217,8 +232,13 @@ namespace mongo {
         /**
          * Cache key is a string-ified combination of the query and sort obfuscated
          * for minimal user comprehension.
+         * Built on demand; see getPlanCacheKey().
          */
-        PlanCacheKey _cacheKey;
+        mutable PlanCacheKey _cacheKey;
+        mutable bool _cacheKeyComputed;
+
+        // See getPlanCacheShapeHash().
+        unsigned long long _shapeHash;
     };
 
 }  // namespace mongo
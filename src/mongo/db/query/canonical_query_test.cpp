@@ -606,6 +606,28 @@ namespace {
         testGetPlanCacheKey("{}", "{}", "{a: 'foo,[]~|'}", "an|\"foo\\,\\[\\]\\~\\|\"a");
     }
 
+    // The shape hash must agree with the string cache key: queries with equal keys
+    // have equal hashes, and shape differences the key encodes change the hash.
+    TEST(PlanCacheTest, GetPlanCacheShapeHash) {
+        // Same shape, different constants.
+        auto_ptr<CanonicalQuery> cqA(canonicalize("{a: 1, b: {$gt: 2}}"));
+        auto_ptr<CanonicalQuery> cqB(canonicalize("{a: 500, b: {$gt: -7}}"));
+        ASSERT_EQUALS(cqA->getPlanCacheShapeHash(), cqB->getPlanCacheShapeHash());
+
+        // Different match types and paths.
+        auto_ptr<CanonicalQuery> cqC(canonicalize("{a: 1, b: {$lt: 2}}"));
+        auto_ptr<CanonicalQuery> cqD(canonicalize("{a: 1, c: {$gt: 2}}"));
+        ASSERT_NOT_EQUALS(cqA->getPlanCacheShapeHash(), cqC->getPlanCacheShapeHash());
+        ASSERT_NOT_EQUALS(cqA->getPlanCacheShapeHash(), cqD->getPlanCacheShapeHash());
+
+        // Sort and projection are part of the shape.
+        auto_ptr<CanonicalQuery> cqSort(canonicalize("{a: 1}", "{b: 1}", "{}"));
+        auto_ptr<CanonicalQuery> cqNoSort(canonicalize("{a: 1}", "{}", "{}"));
+        auto_ptr<CanonicalQuery> cqProj(canonicalize("{a: 1}", "{}", "{b: 1}"));
+        ASSERT_NOT_EQUALS(cqSort->getPlanCacheShapeHash(), cqNoSort->getPlanCacheShapeHash());
+        ASSERT_NOT_EQUALS(cqProj->getPlanCacheShapeHash(), cqNoSort->getPlanCacheShapeHash());
+    }
+
     // Cache keys for $geoWithin queries with legacy and GeoJSON coordinates should
     // not be the same.
     TEST(PlanCacheTest, GetPlanCacheKeyGeoWithin) {
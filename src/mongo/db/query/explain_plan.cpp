@@ -459,6 +459,10 @@ namespace mongo {
             bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            if (spec->spilledToDisk) {
+                bob->appendBool("spilledToDisk", true);
+                bob->appendNumber("spilledRecords", spec->spilledRecords);
+            }
             for (size_t i = 0; i < spec->mapAfterChild.size(); ++i) {
                 bob->appendNumber(string(stream() << "mapAfterChild_" << i), spec->mapAfterChild[i]);
             }
@@ -465,11 +465,30 @@ namespace mongo {
             return true;
         }
 
+        /**
+         * Returns the position of 'field' in 'keyPattern', or -1 if it is not a
+         * component of the pattern.
+         */
+        int getDistinctFieldPosition(const BSONObj& keyPattern, const std::string& field) {
+            int position = 0;
+            BSONObjIterator it(keyPattern);
+            while (it.more()) {
+                if (field == it.next().fieldName()) {
+                    return position;
+                }
+                ++position;
+            }
+            return -1;
+        }
+
         /**
          * Returns true if indices contains an index that can be
          * used with DistinctNode. Sets indexOut to the array index
-         * of PlannerParams::indices.
-         * Look for the index for the fewest fields.
+         * of PlannerParams::indices and fieldNoOut to the position of
+         * the distinct-ed field in that index's key pattern.
+         * The distinct scan visits one key per distinct combination of the fields up
+         * to and including the distinct-ed one, so prefer the index where the field
+         * appears earliest; break ties on the fewest fields.
          * Criteria for suitable index is that the index cannot be special
          * (geo, hashed, text, ...).
          *
@@ -483,9 +502,11 @@ namespace mongo {
          * the projection stage cannot be covered with a dotted field.
          */
         bool getDistinctNodeIndex(const std::vector<IndexEntry>& indices,
-                                  const std::string& field, size_t* indexOut) {
+                                  const std::string& field, size_t* indexOut, int* fieldNoOut) {
             invariant(indexOut);
+            invariant(fieldNoOut);
             bool isDottedField = str::contains(field, '.');
+            int bestPosition = std::numeric_limits<int>::max();
             int minFields = std::numeric_limits<int>::max();
             for (size_t i = 0; i < indices.size(); ++i) {
                 // Skip special indices.
@@ -496,14 +517,20 @@ namespace mongo {
                 if (indices[i].multikey && isDottedField) {
                     continue;
                 }
+                int position = getDistinctFieldPosition(indices[i].keyPattern, field);
+                if (position < 0) {
+                    continue;
+                }
                 int nFields = indices[i].keyPattern.nFields();
-                // Pick the index with the lowest number of fields.
-                if (nFields < minFields) {
+                if (position < bestPosition ||
+                    (position == bestPosition && nFields < minFields)) {
+                    bestPosition = position;
                     minFields = nFields;
                     *indexOut = i;
+                    *fieldNoOut = position;
                 }
             }
-            return minFields != std::numeric_limits<int>::max();
+            return bestPosition != std::numeric_limits<int>::max();
         }
 
         /**
@@ -632,17 +659,16 @@ namespace mongo {
             dn->direction = isn->direction;
             dn->bounds = isn->bounds;
 
-            // Figure out which field we're skipping to the next value of.  TODO: We currently only
-            // try to distinct-hack when there is an index prefixed by the field we're distinct-ing
-            // over.  Consider removing this code if we stick with that policy.
-            dn->fieldNo = 0;
-            BSONObjIterator it(isn->indexKeyPattern);
-            while (it.more()) {
-                if (field == it.next().fieldName()) {
-                    break;
-                }
-                dn->fieldNo++;
+            // Figure out which field we're skipping to the next value of.  The field can sit
+            // anywhere in the key pattern: the skip scan then visits one key per distinct
+            // combination of the fields up to and including it, repositioning in O(tree depth)
+            // each time, which still beats examining every key when values repeat.
+            int fieldNo = getDistinctFieldPosition(isn->indexKeyPattern, field);
+            if (fieldNo < 0) {
+                delete dn;
+                return false;
             }
+            dn->fieldNo = fieldNo;
 
             // Delete the old index scan, set the child of project to the fast distinct scan.
             delete root->children[0];
@@ -664,8 +690,7 @@ namespace mongo {
 
         // When can we do a fast distinct hack?
         // 1. There is a plan with just one leaf and that leaf is an ixscan.
-        // 2. The ixscan indexes the field we're interested in.
-        // 2a: We are correct if the index contains the field but for now we look for prefix.
+        // 2. The ixscan indexes the field we're interested in, at any position in the key.
         // 3. The query is covered/no fetch.
         //
         // We go through normal planning (with limited parameters) to see if we can produce
@@ -677,9 +702,10 @@ namespace mongo {
         IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(false);
         while (ii.more()) {
             const IndexDescriptor* desc = ii.next();
-            // The distinct hack can work if any field is in the index but it's not always clear
-            // if it's a win unless it's the first field.
-            if (desc->keyPattern().firstElement().fieldName() == field) {
+            // Any index containing the field can drive the distinct scan; candidates where
+            // the field leads are preferred by getDistinctNodeIndex() and by the covered
+            // plans the restricted planning pass below produces.
+            if (getDistinctFieldPosition(desc->keyPattern(), field) >= 0) {
                 plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
                                                            desc->getAccessMethodName(),
                                                            desc->isMultikey(),
@@ -734,13 +760,15 @@ namespace mongo {
         // Not every index in plannerParams.indices may be suitable. Refer to
         // getDistinctNodeIndex().
         size_t distinctNodeIndex = 0;
+        int distinctFieldNo = 0;
         if (query.isEmpty() &&
-            getDistinctNodeIndex(plannerParams.indices, field, &distinctNodeIndex)) {
+            getDistinctNodeIndex(plannerParams.indices, field, &distinctNodeIndex,
+                                 &distinctFieldNo)) {
             DistinctNode* dn = new DistinctNode();
             dn->indexKeyPattern = plannerParams.indices[distinctNodeIndex].keyPattern;
             dn->direction = 1;
             IndexBoundsBuilder::allValuesBounds(dn->indexKeyPattern, &dn->bounds);
-            dn->fieldNo = 0;
+            dn->fieldNo = distinctFieldNo;
 
             QueryPlannerParams params;
 
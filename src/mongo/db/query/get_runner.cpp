@@ -100,6 +100,66 @@ namespace mongo {
     namespace {
         // The body is below in the "count hack" section but getRunner calls it.
         bool turnIxscanIntoCount(QuerySolution* soln);
+
+        /**
+         * Point-read fast path: a single-field equality over one simple btree index has
+         * exactly one reasonable plan, so there is nothing for the enumerator or the plan
+         * cache to decide.  Build the solution directly and skip both.
+         *
+         * Returns NULL if the query is not such a shape; the caller then falls through to
+         * the normal planning path.
+         */
+        QuerySolution* tryPointReadFastPath(const CanonicalQuery& query,
+                                            const QueryPlannerParams& params) {
+            const LiteParsedQuery& lpq = query.getParsed();
+            MatchExpression* root = query.root();
+
+            if (MatchExpression::EQ != root->matchType()) { return NULL; }
+
+            // Any of these change the shape of the solution or are handled specially
+            // elsewhere (e.g. turnIxscanIntoCount for counts).
+            if (!lpq.getSort().isEmpty()
+                || !lpq.getHint().isEmpty()
+                || !lpq.getMin().isEmpty()
+                || !lpq.getMax().isEmpty()
+                || lpq.isSnapshot()
+                || 0 != lpq.getMaxScan()
+                || lpq.hasOption(QueryOption_CursorTailable)
+                || (params.options & QueryPlannerParams::PRIVATE_IS_COUNT)) {
+                return NULL;
+            }
+
+            for (size_t i = 0; i < params.indices.size(); ++i) {
+                const IndexEntry& index = params.indices[i];
+                if (INDEX_BTREE != index.type || index.sparse) { continue; }
+                if (1 != index.keyPattern.nFields()) { continue; }
+
+                BSONElement keyElt = index.keyPattern.firstElement();
+                if (root->path() != keyElt.fieldName()) { continue; }
+
+                OrderedIntervalList oil;
+                IndexBoundsBuilder::BoundsTightness tightness;
+                IndexBoundsBuilder::translate(root, keyElt, index, &oil, &tightness);
+                if (IndexBoundsBuilder::EXACT != tightness) {
+                    // The bounds don't fully capture the predicate (null, arrays, ...);
+                    // a filter would be required, so let the planner handle it.
+                    return NULL;
+                }
+
+                auto_ptr<IndexScanNode> isn(new IndexScanNode());
+                isn->indexKeyPattern = index.keyPattern;
+                isn->indexIsMultiKey = index.multikey;
+                isn->direction = 1;
+                isn->bounds.isSimpleRange = false;
+                isn->bounds.fields.push_back(oil);
+
+                // Takes ownership of 'isn'; adds the fetch, projection and (if requested)
+                // shard filter on top, exactly as for an enumerated solution.
+                return QueryPlannerAnalysis::analyzeDataAccess(query, params, isn.release());
+            }
+
+            return NULL;
+        }
     }  // namespace
 
 
@@ -155,6 +215,22 @@ namespace mongo {
         plannerParams.options = plannerOptions;
         fillOutPlannerParams(collection, rawCanonicalQuery, &plannerParams);
 
+        // Single-field equality point reads skip planning altogether.
+        if (internalQueryPlanPointReadFastPath) {
+            QuerySolution* qs = tryPointReadFastPath(*canonicalQuery, plannerParams);
+            if (NULL != qs) {
+                LOG(2) << "Using point read fast path: " << canonicalQuery->toStringShort()
+                       << ", planSummary: " << getPlanSummary(*qs);
+
+                WorkingSet* ws = new WorkingSet();
+                PlanStage* root;
+                verify(StageBuilder::build(collection, *qs, ws, &root));
+                *out = new SingleSolutionRunner(collection, canonicalQuery.release(),
+                                                qs, root, ws);
+                return Status::OK();
+            }
+        }
+
         // Try to look up a cached solution for the query.
 
         CachedSolution* rawCS;
@@ -390,11 +466,30 @@ namespace mongo {
             return true;
         }
 
+        /**
+         * Returns the position of 'field' in 'keyPattern', or -1 if it is not a
+         * component of the pattern.
+         */
+        int getDistinctFieldPosition(const BSONObj& keyPattern, const std::string& field) {
+            int position = 0;
+            BSONObjIterator it(keyPattern);
+            while (it.more()) {
+                if (field == it.next().fieldName()) {
+                    return position;
+                }
+                ++position;
+            }
+            return -1;
+        }
+
         /**
          * Returns true if indices contains an index that can be
          * used with DistinctNode. Sets indexOut to the array index
-         * of PlannerParams::indices.
-         * Look for the index for the fewest fields.
+         * of PlannerParams::indices and fieldNoOut to the position of
+         * the distinct-ed field in that index's key pattern.
+         * The distinct scan visits one key per distinct combination of the fields up
+         * to and including the distinct-ed one, so prefer the index where the field
+         * appears earliest; break ties on the fewest fields.
          * Criteria for suitable index is that the index cannot be special
          * (geo, hashed, text, ...).
          *
@@ -408,9 +503,11 @@ namespace mongo {
          * the projection stage cannot be covered with a dotted field.
          */
         bool getDistinctNodeIndex(const std::vector<IndexEntry>& indices,
-                                  const std::string& field, size_t* indexOut) {
+                                  const std::string& field, size_t* indexOut, int* fieldNoOut) {
             invariant(indexOut);
+            invariant(fieldNoOut);
             bool isDottedField = str::contains(field, '.');
+            int bestPosition = std::numeric_limits<int>::max();
             int minFields = std::numeric_limits<int>::max();
             for (size_t i = 0; i < indices.size(); ++i) {
                 // Skip special indices.
@@ -421,14 +518,20 @@ namespace mongo {
                 if (indices[i].multikey && isDottedField) {
                     continue;
                 }
+                int position = getDistinctFieldPosition(indices[i].keyPattern, field);
+                if (position < 0) {
+                    continue;
+                }
                 int nFields = indices[i].keyPattern.nFields();
-                // Pick the index with the lowest number of fields.
-                if (nFields < minFields) {
+                if (position < bestPosition ||
+                    (position == bestPosition && nFields < minFields)) {
+                    bestPosition = position;
                     minFields = nFields;
                     *indexOut = i;
+                    *fieldNoOut = position;
                 }
             }
-            return minFields != std::numeric_limits<int>::max();
+            return bestPosition != std::numeric_limits<int>::max();
         }
 
         /**
@@ -538,8 +641,7 @@ namespace mongo {
 
         // When can we do a fast distinct hack?
         // 1. There is a plan with just one leaf and that leaf is an ixscan.
-        // 2. The ixscan indexes the field we're interested in.
-        // 2a: We are correct if the index contains the field but for now we look for prefix.
+        // 2. The ixscan indexes the field we're interested in, at any position in the key.
         // 3. The query is covered/no fetch.
         //
         // We go through normal planning (with limited parameters) to see if we can produce
@@ -551,9 +653,10 @@ namespace mongo {
         IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(false);
         while (ii.more()) {
             const IndexDescriptor* desc = ii.next();
-            // The distinct hack can work if any field is in the index but it's not always clear
-            // if it's a win unless it's the first field.
-            if (desc->keyPattern().firstElement().fieldName() == field) {
+            // Any index containing the field can drive the distinct scan; candidates where
+            // the field leads are preferred by getDistinctNodeIndex() and by the covered
+            // plans the restricted planning pass below produces.
+            if (getDistinctFieldPosition(desc->keyPattern(), field) >= 0) {
                 plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
                                                            desc->getAccessMethodName(),
                                                            desc->isMultikey(),
@@ -604,13 +707,15 @@ namespace mongo {
         // Not every index in plannerParams.indices may be suitable. Refer to
         // getDistinctNodeIndex().
         size_t distinctNodeIndex = 0;
+        int distinctFieldNo = 0;
         if (query.isEmpty() &&
-            getDistinctNodeIndex(plannerParams.indices, field, &distinctNodeIndex)) {
+            getDistinctNodeIndex(plannerParams.indices, field, &distinctNodeIndex,
+                                 &distinctFieldNo)) {
             DistinctNode* dn = new DistinctNode();
             dn->indexKeyPattern = plannerParams.indices[distinctNodeIndex].keyPattern;
             dn->direction = 1;
             IndexBoundsBuilder::allValuesBounds(dn->indexKeyPattern, &dn->bounds);
-            dn->fieldNo = 0;
+            dn->fieldNo = distinctFieldNo;
 
             QueryPlannerParams params;
 
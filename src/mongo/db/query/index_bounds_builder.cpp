@@ -578,7 +578,9 @@ namespace mongo {
             if (mongoutils::str::equals("2dsphere", elt.valuestrsafe())) {
                 verify(gme->getGeoQuery().getGeometry().hasS2Region());
                 const S2Region& region = gme->getGeoQuery().getGeometry().getS2Region();
-                ExpressionMapping::cover2dsphere(region, index.infoObj, oilOut);
+                // cached: geofence workloads pass the same query regions over and over
+                ExpressionMapping::cover2dsphereWithCache(region, gme->getRawObj(),
+                                                          index.infoObj, oilOut);
                 *tightnessOut = IndexBoundsBuilder::INEXACT_FETCH;
             }
             else if (mongoutils::str::equals("2d", elt.valuestrsafe())) {
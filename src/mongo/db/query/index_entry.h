@@ -52,6 +52,7 @@ namespace mongo {
             : keyPattern(kp),
               multikey(mk),
               sparse(sp),
+              partial(!io.getObjectField("partialFilterExpression").isEmpty()),
               name(n),
               infoObj(io) {
 
@@ -69,6 +70,7 @@ namespace mongo {
             : keyPattern(kp),
               multikey(mk),
               sparse(sp),
+              partial(!io.getObjectField("partialFilterExpression").isEmpty()),
               name(n),
               infoObj(io) {
 
@@ -82,6 +84,7 @@ namespace mongo {
             : keyPattern(kp),
               multikey(false),
               sparse(false),
+              partial(false),
               name("test_foo"),
               infoObj(BSONObj()) {
 
@@ -94,6 +97,10 @@ namespace mongo {
 
         bool sparse;
 
+        // Is this a partial index?  The filter itself is in
+        // infoObj["partialFilterExpression"].
+        bool partial;
+
         std::string name;
 
         // Geo indices have extra parameters.  We need those available to plan correctly.
@@ -115,6 +122,10 @@ namespace mongo {
                 ss << " sparse";
             }
 
+            if (partial) {
+                ss << " partial";
+            }
+
             if (!infoObj.isEmpty()) {
                 ss << " io: " << infoObj.toString();
             }
@@ -0,0 +1,126 @@
+// multi_iterator_runner.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/query/multi_iterator_runner.h"
+
+#include "mongo/db/catalog/collection.h"
+
+namespace mongo {
+
+    MultiIteratorRunner::MultiIteratorRunner(const StringData& ns, Collection* collection)
+        : _ns( ns.toString() ),
+          _collection( collection ) {
+    }
+
+    MultiIteratorRunner::~MultiIteratorRunner() {
+    }
+
+    void MultiIteratorRunner::addIterator(RecordIterator* it) {
+        _iterators.push_back(it);
+    }
+
+    Runner::RunnerState MultiIteratorRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
+        if ( _collection == NULL )
+            return RUNNER_DEAD;
+
+        DiskLoc next = _advance();
+        if (next.isNull())
+            return RUNNER_EOF;
+
+        if ( objOut )
+            *objOut = _collection->docFor( next );
+        if ( dlOut )
+            *dlOut = next;
+        return RUNNER_ADVANCED;
+    }
+
+    bool MultiIteratorRunner::isEOF() {
+        return _collection == NULL || _iterators.empty();
+    }
+
+    void MultiIteratorRunner::kill() {
+        _collection = NULL;
+        _iterators.clear();
+    }
+
+    void MultiIteratorRunner::saveState() {
+        for (size_t i = 0; i < _iterators.size(); i++) {
+            _iterators[i]->prepareToYield();
+        }
+    }
+
+    bool MultiIteratorRunner::restoreState(OperationContext* opCtx) {
+        for (size_t i = 0; i < _iterators.size(); i++) {
+            if (!_iterators[i]->recoverFromYield()) {
+                kill();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::string& MultiIteratorRunner::ns() {
+        return _ns;
+    }
+
+    void MultiIteratorRunner::invalidate(const DiskLoc& dl, InvalidationType type) {
+        switch ( type ) {
+        case INVALIDATION_DELETION:
+            for (size_t i = 0; i < _iterators.size(); i++) {
+                _iterators[i]->invalidate(dl);
+            }
+            break;
+        case INVALIDATION_MUTATION:
+            // no-op
+            break;
+        }
+    }
+
+    const Collection* MultiIteratorRunner::collection() {
+        return _collection;
+    }
+
+    Status MultiIteratorRunner::getInfo(TypeExplain** explain, PlanInfo** planInfo) const {
+        return Status( ErrorCodes::InternalError, "no" );
+    }
+
+    DiskLoc MultiIteratorRunner::_advance() {
+        while (!_iterators.empty()) {
+            DiskLoc out = _iterators.back()->getNext();
+            if (!out.isNull())
+                return out;
+
+            _iterators.popAndDeleteBack();
+        }
+
+        return DiskLoc();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,78 @@
+// multi_iterator_runner.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/query/runner.h"
+
+namespace mongo {
+
+    class Collection;
+    class RecordIterator;
+
+    /**
+     * A Runner that returns every record reachable from a set of RecordIterators, in
+     * iterator order, with no filtering or sorting.  Used to hand out disjoint slices of a
+     * collection: parallelCollectionScan gives each of its cursors one of these over a
+     * subset of the extents, and the aggregation parallel scan feeds one to each worker.
+     */
+    class MultiIteratorRunner : public Runner {
+    public:
+        MultiIteratorRunner(const StringData& ns, Collection* collection);
+        ~MultiIteratorRunner();
+
+        // takes ownership of it
+        void addIterator(RecordIterator* it);
+
+        virtual RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut);
+        virtual bool isEOF();
+        virtual void kill();
+        virtual void saveState();
+        virtual bool restoreState(OperationContext* opCtx);
+        virtual const std::string& ns();
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+        virtual const Collection* collection();
+        virtual Status getInfo(TypeExplain** explain, PlanInfo** planInfo) const;
+
+    private:
+        /**
+         * @return if more data
+         */
+        DiskLoc _advance();
+
+        std::string _ns;
+        Collection* _collection;
+        OwnedPointerVector<RecordIterator> _iterators;
+    };
+
+}  // namespace mongo
@@ -41,6 +41,7 @@
 #include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/query/single_solution_runner.h"
 #include "mongo/db/query/type_explain.h"
@@ -49,6 +50,7 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_cursor_cache.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h"
@@ -142,14 +144,15 @@ namespace mongo {
      *        when this method returns an empty result, incrementing pass on each call.  
      *        Thus, pass == 0 indicates this is the first "attempt" before any 'awaiting'.
      */
-    QueryResult* newGetMore(OperationContext* txn,
-                            const char* ns,
-                            int ntoreturn,
-                            long long cursorid,
-                            CurOp& curop,
-                            int pass,
-                            bool& exhaust,
-                            bool* isCursorAuthorized) {
+    bool newGetMore(OperationContext* txn,
+                    const char* ns,
+                    int ntoreturn,
+                    long long cursorid,
+                    CurOp& curop,
+                    int pass,
+                    bool& exhaust,
+                    bool* isCursorAuthorized,
+                    Message& result) {
         exhaust = false;
 
         // This is a read lock.
@@ -177,9 +180,10 @@ namespace mongo {
         int numResults = 0;
         int startingResult = 0;
 
-        const int InitialBufSize = 512 + sizeof(QueryResult) + MaxBytesToReturnToClientAtOnce;
-        BufBuilder bb(InitialBufSize);
-        bb.skip(sizeof(QueryResult));
+        // Results accumulate in fixed-size segments that are sent with one
+        // vectored write, so a big batch never needs one big contiguous
+        // buffer (or the copies to regrow it).
+        ChunkedReplyBuilder bb;
 
         if (NULL == cc) {
             cursorid = 0;
@@ -222,12 +226,41 @@ namespace mongo {
             Runner* runner = cc->getRunner();
             const int queryOptions = cc->queryOptions();
 
+            // The originating query's priority class carries over to every getMore on
+            // the cursor (the lock for this batch is already held, but the yield checks
+            // below consult it).
+            scoped_ptr<Lock::ScopedAdmissionPriority> admissionPriority;
+            if (queryOptions & QueryOption_LowPriority) {
+                admissionPriority.reset(
+                    new Lock::ScopedAdmissionPriority(txn->lockState(), -1));
+            }
+
             // Get results out of the runner.
             runner->restoreState(txn);
 
+            // First drain anything the background readahead thread staged for us; these
+            // are owned copies produced by this cursor's runner after the last getMore.
+            bool batchFull = false;
+            while (!batchFull && cc->hasStagedResult()) {
+                BSONObj staged = cc->takeStagedResult();
+                bb.appendBuf((void*)staged.objdata(), staged.objsize());
+                ++numResults;
+
+                // Possibly note slave's position in the oplog.
+                if (queryOptions & QueryOption_OplogReplay) {
+                    BSONElement e = staged["ts"];
+                    if (Date == e.type() || Timestamp == e.type()) {
+                        slaveReadTill = e._opTime();
+                    }
+                }
+
+                batchFull = (ntoreturn && numResults >= ntoreturn)
+                    || bb.len() > MaxBytesToReturnToClientAtOnce;
+            }
+
             BSONObj obj;
-            Runner::RunnerState state;
-            while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&obj, NULL))) {
+            Runner::RunnerState state = Runner::RUNNER_ADVANCED;
+            while (!batchFull && Runner::RUNNER_ADVANCED == (state = runner->getNext(&obj, NULL))) {
                 // Add result to output buffer.
                 bb.appendBuf((void*)obj.objdata(), obj.objsize());
 
@@ -246,6 +279,17 @@ namespace mongo {
                     || bb.len() > MaxBytesToReturnToClientAtOnce) {
                     break;
                 }
+
+                // A writer is blocked behind the read lock this batch holds; end the batch
+                // early (the cursor is saved below since we're RUNNER_ADVANCED) and let the
+                // writer in rather than convoying it behind the rest of the scan.  Low
+                // priority ops don't get to wait out their quantum first.
+                if ((internalQueryExecPreemptionQuantumMillis > 0
+                     && curop.elapsedMillis() >= internalQueryExecPreemptionQuantumMillis
+                     && Lock::othersWaitingForLocksHeld(txn->lockState()) > 0)
+                    || Lock::lowPriorityOpShouldYield(txn->lockState())) {
+                    break;
+                }
             }
 
             if (Runner::RUNNER_EOF == state && 0 == numResults
@@ -253,7 +297,7 @@ namespace mongo {
                 && (queryOptions & QueryOption_AwaitData) && (pass < 1000)) {
                 // If the cursor is tailable we don't kill it if it's eof.  We let it try to get
                 // data some # of times first.
-                return 0;
+                return false;
             }
 
             bool saveClientCursor = false;
@@ -323,19 +367,27 @@ namespace mongo {
                 // If the getmore had a time limit, remaining time is "rolled over" back to the
                 // cursor (for use by future getmore ops).
                 cc->setLeftoverMaxTimeMicros( curop.getRemainingMaxTimeMicros() );
+
+                // Ask the background thread to stage the next batch for tailable cursors
+                // so the next getMore can be answered from memory.  The thread pins the
+                // cursor itself once we release our pin.
+                if (tailableCursorReadaheadDocs > 0
+                    && (queryOptions & QueryOption_CursorTailable)
+                    && !cc->isAggCursor) {
+                    CollectionCursorCache::scheduleReadahead(cc->ns(), cursorid);
+                }
             }
         }
 
-        QueryResult* qr = reinterpret_cast<QueryResult*>(bb.buf());
-        qr->len = bb.len();
+        QueryResult* qr = bb.header();
         qr->setOperation(opReply);
         qr->_resultFlags() = resultFlags;
         qr->cursorId = cursorid;
         qr->startingFrom = startingResult;
         qr->nReturned = numResults;
-        bb.decouple();
+        bb.putInMessage(&result);
         QLOG() << "getMore returned " << numResults << " results\n";
-        return qr;
+        return true;
     }
 
     Status getOplogStartHack(Collection* collection, CanonicalQuery* cq, Runner** runnerOut) {
@@ -599,7 +651,7 @@ namespace mongo {
         // bb is used to hold query results
         // this buffer should contain either requested documents per query or
         // explain information, but not both
-        BufBuilder bb(32768);
+        ArenaBufBuilder bb(32768);
         bb.skip(sizeof(QueryResult));
 
         // How many results have we obtained from the runner?
@@ -684,6 +736,18 @@ namespace mongo {
                 }
                 break;
             }
+            else if (pq.wantMore() && 1 != pq.getNumToReturn()
+                     && ((internalQueryExecPreemptionQuantumMillis > 0
+                          && curop.elapsedMillis() >= internalQueryExecPreemptionQuantumMillis
+                          && Lock::othersWaitingForLocksHeld(txn->lockState()) > 0)
+                         || Lock::lowPriorityOpShouldYield(txn->lockState()))) {
+                // A writer is blocked behind the read lock this query holds; return what we
+                // have and let getMore resume the scan, rather than convoying the writer
+                // behind the full first batch.  Low priority queries cut their batch as
+                // soon as anyone of higher priority is waiting.
+                saveClientCursor = !runner->isEOF();
+                break;
+            }
         }
 
         // Try to get information about the plan which the runner
@@ -835,9 +899,14 @@ namespace mongo {
             QLOG() << "Not caching runner but returning " << numResults << " results.\n";
         }
 
-        // Add the results from the query into the output buffer.
-        result.appendData(bb.buf(), bb.len());
+        // Add the results from the query into the output buffer.  The buffer may
+        // belong to the client's operation arena; if so, the Message must not
+        // free it -- it is reclaimed at the next arena reset, after the reply
+        // has been sent.
+        QueryResult* qrBuf = reinterpret_cast<QueryResult*>(bb.buf());
+        qrBuf->len = bb.len();
         bb.decouple();
+        result.setData(qrBuf, !cc().arena().owns(qrBuf));
 
         // Fill out the output buffer's header.
         QueryResult* qr = static_cast<QueryResult*>(result.header());
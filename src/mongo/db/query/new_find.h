@@ -42,16 +42,20 @@ namespace mongo {
     class OperationContext;
 
     /**
-     * Called from the getMore entry point in ops/query.cpp.
+     * Called from the getMore entry point in instance.cpp.  On success fills
+     * 'result' with the reply message and returns true; returns false (with
+     * 'result' untouched) when an awaitData cursor produced nothing and the
+     * caller should retry.
      */
-    QueryResult* newGetMore(OperationContext* txn,
-                            const char* ns,
-                            int ntoreturn,
-                            long long cursorid,
-                            CurOp& curop,
-                            int pass,
-                            bool& exhaust,
-                            bool* isCursorAuthorized);
+    bool newGetMore(OperationContext* txn,
+                    const char* ns,
+                    int ntoreturn,
+                    long long cursorid,
+                    CurOp& curop,
+                    int pass,
+                    bool& exhaust,
+                    bool* isCursorAuthorized,
+                    Message& result);
 
     /**
      * Run the query 'q' and place the result in 'result'.
@@ -32,6 +32,7 @@
 #include <math.h>
 #include <memory>
 #include "boost/thread/locks.hpp"
+#include "boost/thread/tss.hpp"
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
 #include "mongo/db/query/plan_ranker.h"
@@ -42,6 +43,159 @@
 
 namespace mongo {
 
+    namespace {
+
+        // Every plan cache mutation advances the generation the cache stamps on
+        // shape MRU slots.  The counter is process wide so a newly constructed
+        // cache (even one reusing a just-freed address) can never match a slot
+        // recorded against a previous cache.
+        AtomicUInt64 planCacheGeneration;
+
+        unsigned long long nextPlanCacheGeneration() {
+            return planCacheGeneration.addAndFetch(1);
+        }
+
+        // One shape MRU per thread; with a thread per connection this gives each
+        // connection its own front cache, reached without any locking.
+        boost::thread_specific_ptr<PlanCacheShapeMRU> shapeMRUForThread;
+
+        PlanCacheShapeMRU* getShapeMRUForThread() {
+            PlanCacheShapeMRU* mru = shapeMRUForThread.get();
+            if (NULL == mru) {
+                mru = new PlanCacheShapeMRU();
+                shapeMRUForThread.reset(mru);
+            }
+            return mru;
+        }
+
+        // Bumped whenever the persisted entry layout changes; entries with any
+        // other version are silently discarded at load time.
+        const int kPersistedFormatVersion = 1;
+
+        // Placeholder stage type string for the synthesized ranking stats of a
+        // reloaded entry (the real trial-period stats are not persisted).
+        const char kReloadedPlanStatsType[] = "RELOADED_PLAN";
+
+        BSONObj indexTreeToBSON(const PlanCacheIndexTree& tree) {
+            BSONObjBuilder bob;
+            if (NULL != tree.entry.get()) {
+                BSONObjBuilder entryBob(bob.subobjStart("entry"));
+                entryBob.append("keyPattern", tree.entry->keyPattern);
+                entryBob.append("multikey", tree.entry->multikey);
+                entryBob.append("sparse", tree.entry->sparse);
+                entryBob.append("name", tree.entry->name);
+                entryBob.append("infoObj", tree.entry->infoObj);
+                entryBob.doneFast();
+                bob.appendNumber("indexPos", static_cast<long long>(tree.index_pos));
+            }
+            if (!tree.children.empty()) {
+                BSONArrayBuilder childrenBab(bob.subarrayStart("children"));
+                for (size_t i = 0; i < tree.children.size(); ++i) {
+                    childrenBab.append(indexTreeToBSON(*tree.children[i]));
+                }
+                childrenBab.doneFast();
+            }
+            return bob.obj();
+        }
+
+        /**
+         * Returns NULL if 'obj' is malformed. Caller owns the result.
+         */
+        PlanCacheIndexTree* indexTreeFromBSON(const BSONObj& obj) {
+            std::auto_ptr<PlanCacheIndexTree> tree(new PlanCacheIndexTree());
+
+            BSONElement entryElt = obj["entry"];
+            if (entryElt.isABSONObj()) {
+                BSONObj entryObj = entryElt.Obj();
+                if (!entryObj["keyPattern"].isABSONObj() ||
+                    mongo::String != entryObj["name"].type()) {
+                    return NULL;
+                }
+                BSONObj keyPattern = entryObj["keyPattern"].Obj().getOwned();
+                BSONObj infoObj;
+                if (entryObj["infoObj"].isABSONObj()) {
+                    infoObj = entryObj["infoObj"].Obj().getOwned();
+                }
+                // The access method is derived from the key pattern, the same way
+                // the index catalog derives it when filling out planner params.
+                IndexEntry ie(keyPattern,
+                              IndexNames::findPluginName(keyPattern),
+                              entryObj["multikey"].trueValue(),
+                              entryObj["sparse"].trueValue(),
+                              entryObj["name"].String(),
+                              infoObj);
+                tree->setIndexEntry(ie);
+                tree->index_pos = static_cast<size_t>(obj["indexPos"].numberLong());
+            }
+
+            BSONElement childrenElt = obj["children"];
+            if (mongo::Array == childrenElt.type()) {
+                BSONObjIterator it(childrenElt.Obj());
+                while (it.more()) {
+                    BSONElement childElt = it.next();
+                    if (!childElt.isABSONObj()) {
+                        return NULL;
+                    }
+                    PlanCacheIndexTree* child = indexTreeFromBSON(childElt.Obj());
+                    if (NULL == child) {
+                        return NULL;
+                    }
+                    tree->children.push_back(child);
+                }
+            }
+
+            return tree.release();
+        }
+
+        BSONObj solutionCacheDataToBSON(const SolutionCacheData& scd) {
+            BSONObjBuilder bob;
+            bob.append("solnType", static_cast<int>(scd.solnType));
+            bob.append("wholeIXSolnDir", scd.wholeIXSolnDir);
+            bob.append("indexFilterApplied", scd.indexFilterApplied);
+            if (NULL != scd.tree.get()) {
+                bob.append("tree", indexTreeToBSON(*scd.tree));
+            }
+            return bob.obj();
+        }
+
+        /**
+         * Returns NULL if 'obj' is malformed. Caller owns the result.
+         */
+        SolutionCacheData* solutionCacheDataFromBSON(const BSONObj& obj) {
+            std::auto_ptr<SolutionCacheData> scd(new SolutionCacheData());
+
+            int solnType = obj["solnType"].numberInt();
+            switch (solnType) {
+            case SolutionCacheData::WHOLE_IXSCAN_SOLN:
+            case SolutionCacheData::COLLSCAN_SOLN:
+            case SolutionCacheData::USE_INDEX_TAGS_SOLN:
+                scd->solnType = static_cast<SolutionCacheData::SolutionType>(solnType);
+                break;
+            default:
+                return NULL;
+            }
+
+            scd->wholeIXSolnDir = obj["wholeIXSolnDir"].numberInt();
+            scd->indexFilterApplied = obj["indexFilterApplied"].trueValue();
+
+            BSONElement treeElt = obj["tree"];
+            if (treeElt.isABSONObj()) {
+                PlanCacheIndexTree* tree = indexTreeFromBSON(treeElt.Obj());
+                if (NULL == tree) {
+                    return NULL;
+                }
+                scd->tree.reset(tree);
+            }
+            else if (SolutionCacheData::COLLSCAN_SOLN != scd->solnType) {
+                // Everything but a collection scan needs its index tree.
+                return NULL;
+            }
+
+            return scd.release();
+        }
+
+    }  // namespace
+
     //
     // Cache-related functions for CanonicalQuery
     //
@@ -144,6 +298,13 @@ namespace mongo {
         }
     }
 
+    PlanCacheEntry::PlanCacheEntry(const std::vector<SolutionCacheData*>& data,
+                                   PlanRankingDecision* why)
+        : plannerData(data),
+          decision(why) {
+        invariant(why);
+    }
+
     PlanCacheEntry::~PlanCacheEntry() {
         for (size_t i = 0; i < feedback.size(); ++i) {
             delete feedback[i];
@@ -181,6 +342,115 @@ namespace mongo {
         return entry;
     }
 
+    BSONObj PlanCacheEntry::toPersistedBSON() const {
+        BSONObjBuilder bob;
+        bob.append("version", kPersistedFormatVersion);
+        bob.append("query", query);
+        bob.append("sort", sort);
+        bob.append("projection", projection);
+        if (backupSoln) {
+            bob.appendNumber("backupSoln", static_cast<long long>(*backupSoln));
+        }
+
+        BSONArrayBuilder solutionsBab(bob.subarrayStart("solutions"));
+        for (size_t i = 0; i < plannerData.size(); ++i) {
+            solutionsBab.append(solutionCacheDataToBSON(*plannerData[i]));
+        }
+        solutionsBab.doneFast();
+
+        BSONArrayBuilder scoresBab(bob.subarrayStart("scores"));
+        for (size_t i = 0; i < decision->scores.size(); ++i) {
+            scoresBab.append(decision->scores[i]);
+        }
+        scoresBab.doneFast();
+
+        BSONArrayBuilder orderBab(bob.subarrayStart("candidateOrder"));
+        for (size_t i = 0; i < decision->candidateOrder.size(); ++i) {
+            orderBab.append(static_cast<long long>(decision->candidateOrder[i]));
+        }
+        orderBab.doneFast();
+
+        return bob.obj();
+    }
+
+    // static
+    PlanCacheEntry* PlanCacheEntry::parsePersisted(const BSONObj& obj) {
+        if (kPersistedFormatVersion != obj["version"].numberInt()) {
+            return NULL;
+        }
+
+        if (!obj["query"].isABSONObj() ||
+            !obj["sort"].isABSONObj() ||
+            !obj["projection"].isABSONObj() ||
+            mongo::Array != obj["solutions"].type() ||
+            mongo::Array != obj["scores"].type() ||
+            mongo::Array != obj["candidateOrder"].type()) {
+            return NULL;
+        }
+
+        OwnedPointerVector<SolutionCacheData> solutions;
+        BSONObjIterator solnIt(obj["solutions"].Obj());
+        while (solnIt.more()) {
+            BSONElement solnElt = solnIt.next();
+            if (!solnElt.isABSONObj()) {
+                return NULL;
+            }
+            SolutionCacheData* scd = solutionCacheDataFromBSON(solnElt.Obj());
+            if (NULL == scd) {
+                return NULL;
+            }
+            solutions.mutableVector().push_back(scd);
+        }
+
+        std::vector<double> scores;
+        BSONObjIterator scoreIt(obj["scores"].Obj());
+        while (scoreIt.more()) {
+            scores.push_back(scoreIt.next().numberDouble());
+        }
+
+        std::vector<size_t> candidateOrder;
+        BSONObjIterator orderIt(obj["candidateOrder"].Obj());
+        while (orderIt.more()) {
+            candidateOrder.push_back(static_cast<size_t>(orderIt.next().numberLong()));
+        }
+
+        if (solutions.vector().empty() ||
+            scores.size() != solutions.vector().size() ||
+            candidateOrder.size() != solutions.vector().size()) {
+            return NULL;
+        }
+
+        // The trial-period execution stats are not persisted. Synthesize a
+        // ranking decision holding the scores and candidate order plus empty
+        // placeholder stats, which is all the plan cache commands require.
+        std::auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        why->scores = scores;
+        why->candidateOrder = candidateOrder;
+        for (size_t i = 0; i < solutions.vector().size(); ++i) {
+            why->stats.mutableVector().push_back(
+                new PlanStageStats(CommonStats(kReloadedPlanStatsType), STAGE_CACHED_PLAN));
+        }
+
+        std::auto_ptr<PlanCacheEntry> entry(
+            new PlanCacheEntry(solutions.vector(), why.release()));
+        solutions.mutableVector().clear(); // ownership transferred to the entry
+
+        entry->query = obj["query"].Obj().getOwned();
+        entry->sort = obj["sort"].Obj().getOwned();
+        entry->projection = obj["projection"].Obj().getOwned();
+
+        BSONElement backupElt = obj["backupSoln"];
+        if (backupElt.isNumber()) {
+            size_t backupIx = static_cast<size_t>(backupElt.numberLong());
+            if (backupIx >= entry->plannerData.size()) {
+                return NULL;
+            }
+            entry->backupSoln.reset(backupIx);
+        }
+
+        return entry.release();
+    }
+
     string PlanCacheEntry::toString() const {
         mongoutils::str::stream ss;
         ss << "(query: " << query.toString()
@@ -288,9 +558,55 @@ namespace mongo {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    const size_t PlanCacheShapeMRU::kNumSlots;
+
+    PlanCacheShapeMRU::PlanCacheShapeMRU() { }
+
+    bool PlanCacheShapeMRU::get(const PlanCache* cache,
+                                unsigned long long generation,
+                                unsigned long long shapeHash,
+                                PlanCacheKey* keyOut,
+                                boost::shared_ptr<PlanCacheEntry>* entryOut) {
+        for (size_t i = 0; i < kNumSlots; ++i) {
+            Slot& slot = _slots[i];
+            if (slot.cache == cache &&
+                slot.generation == generation &&
+                slot.shapeHash == shapeHash &&
+                NULL != slot.entry.get()) {
+                *keyOut = slot.key;
+                *entryOut = slot.entry;
+                // Move the hit to the front.
+                for (; i > 0; --i) {
+                    std::swap(_slots[i], _slots[i - 1]);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    void PlanCacheShapeMRU::put(const PlanCache* cache,
+                                unsigned long long generation,
+                                unsigned long long shapeHash,
+                                const PlanCacheKey& key,
+                                const boost::shared_ptr<PlanCacheEntry>& entry) {
+        for (size_t i = kNumSlots - 1; i > 0; --i) {
+            _slots[i] = _slots[i - 1];
+        }
+        _slots[0].cache = cache;
+        _slots[0].generation = generation;
+        _slots[0].shapeHash = shapeHash;
+        _slots[0].key = key;
+        _slots[0].entry = entry;
+    }
+
+    PlanCache::PlanCache() : _cache(internalQueryCacheSize) {
+        _generation.store(nextPlanCacheGeneration());
+    }
+
+    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) {
+        _generation.store(nextPlanCacheGeneration());
+    }
 
     PlanCache::~PlanCache() { }
 
@@ -337,6 +653,7 @@ namespace mongo {
 
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        _generation.store(nextPlanCacheGeneration());
 
         if (NULL != evictedEntry.get()) {
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -348,9 +665,24 @@ namespace mongo {
     }
 
     Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
-        const PlanCacheKey& key = query.getPlanCacheKey();
         verify(crOut);
 
+        // First level: this thread's shape MRU, matched on the incrementally
+        // computed shape hash.  A hit takes no lock and never builds the string key.
+        PlanCacheShapeMRU* mru = getShapeMRUForThread();
+        const unsigned long long generation = _generation.load();
+        const unsigned long long shapeHash = query.getPlanCacheShapeHash();
+
+        PlanCacheKey mruKey;
+        boost::shared_ptr<PlanCacheEntry> mruEntry;
+        if (mru->get(this, generation, shapeHash, &mruKey, &mruEntry)) {
+            *crOut = new CachedSolution(mruKey, *mruEntry);
+            return Status::OK();
+        }
+
+        // Second level: the shared cache.
+        const PlanCacheKey& key = query.getPlanCacheKey();
+
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         PlanCacheEntry* entry;
         Status cacheStatus = _cache.get(key, &entry);
@@ -359,6 +691,12 @@ namespace mongo {
         }
         invariant(entry);
 
+        // Remember the shape so repeat queries on this connection skip the lock.
+        // The generation is re-read under the lock: a mutation between the load
+        // above and here would otherwise be stamped away.
+        mru->put(this, _generation.load(), shapeHash, key,
+                 boost::shared_ptr<PlanCacheEntry>(entry->clone()));
+
         *crOut = new CachedSolution(key, *entry);
 
         return Status::OK();
@@ -437,6 +775,7 @@ namespace mongo {
                 LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
                        << " - detected degradation in performance of cached solution.";
                 _cache.remove(ck);
+                _generation.store(nextPlanCacheGeneration());
             }
         }
         else {
@@ -449,6 +788,7 @@ namespace mongo {
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        _generation.store(nextPlanCacheGeneration());
         return _cache.remove(canonicalQuery.getPlanCacheKey());
     }
 
@@ -456,6 +796,7 @@ namespace mongo {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         _cache.clear();
         _writeOperations.store(0);
+        _generation.store(nextPlanCacheGeneration());
     }
 
     Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOut) const {
@@ -497,6 +838,49 @@ namespace mongo {
         return _cache.size();
     }
 
+    void PlanCache::getPersistedEntries(std::vector<BSONObj>* out) const {
+        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
+        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
+            out->push_back(i->second->toPersistedBSON());
+        }
+    }
+
+    Status PlanCache::loadPersistedEntry(const BSONObj& obj) {
+        std::auto_ptr<PlanCacheEntry> entry(PlanCacheEntry::parsePersisted(obj));
+        if (NULL == entry.get()) {
+            return Status(ErrorCodes::BadValue, "malformed persisted plan cache entry");
+        }
+
+        // Recompute the cache key from the stored query shape.
+        CanonicalQuery* rawCQ;
+        Status cqStatus = CanonicalQuery::canonicalize(_ns,
+                                                       entry->query,
+                                                       entry->sort,
+                                                       entry->projection,
+                                                       &rawCQ);
+        if (!cqStatus.isOK()) {
+            return cqStatus;
+        }
+        boost::scoped_ptr<CanonicalQuery> cq(rawCQ);
+
+        if (!shouldCacheQuery(*cq)) {
+            return Status(ErrorCodes::BadValue, "persisted query shape is not cacheable");
+        }
+
+        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        std::auto_ptr<PlanCacheEntry> evictedEntry =
+            _cache.add(cq->getPlanCacheKey(), entry.release());
+        _generation.store(nextPlanCacheGeneration());
+        if (NULL != evictedEntry.get()) {
+            LOG(1) << _ns << ": plan cache maximum size exceeded while loading persisted "
+                   << "entries - removed least recently used entry "
+                   << evictedEntry->toString();
+        }
+
+        return Status::OK();
+    }
+
     void PlanCache::notifyOfWriteOp() {
         // It's fine to clear the cache multiple times if multiple threads
         // increment the counter to kPlanCacheMaxWriteOperations or greater.
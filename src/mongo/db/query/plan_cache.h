@@ -30,6 +30,7 @@
 
 #include <set>
 #include <boost/optional/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/db/exec/plan_stats.h"
@@ -215,6 +216,20 @@ namespace mongo {
 
         ~PlanCacheEntry();
 
+        /**
+         * Serialize this entry to a BSON object suitable for writing to disk and
+         * reloading with parsePersisted(). Feedback and the trial-period stats are
+         * not persisted; a reloaded entry collects feedback from scratch.
+         */
+        BSONObj toPersistedBSON() const;
+
+        /**
+         * Rebuild an entry from the output of toPersistedBSON().
+         * Returns NULL if 'obj' is malformed or has an unrecognized format version.
+         * Caller owns the result.
+         */
+        static PlanCacheEntry* parsePersisted(const BSONObj& obj);
+
         /**
          * Make a deep copy.
          */
@@ -266,6 +281,73 @@ namespace mongo {
         // In order to justify eviction, the deviation from the mean must exceed a
         // minimum threshold.
         static const double kMinDeviation;
+
+    private:
+        /**
+         * Used by parsePersisted(). Takes ownership of the SolutionCacheData
+         * pointers in 'data' and of 'why'.
+         */
+        PlanCacheEntry(const std::vector<SolutionCacheData*>& data,
+                       PlanRankingDecision* why);
+    };
+
+    class PlanCache;
+
+    /**
+     * A tiny most-recently-used front cache for PlanCache, intended to be thread
+     * local (one per connection).  The last few query shapes served are matched by
+     * the canonical query's incrementally computed shape hash, so a hit costs
+     * neither the shared cache's mutex nor construction of the string cache key.
+     *
+     * Slots are tagged with the generation of the owning cache and every cache
+     * mutation moves the generation forward (from a process-wide counter, so a
+     * freshly constructed cache can never match a stale slot), which means a hit
+     * can never return a plan the shared cache no longer holds.  An accidental
+     * 64-bit hash collision between shapes live on one connection is accepted as
+     * negligible; a collision would serve the colliding shape's plan, not wrong
+     * query results.
+     */
+    class PlanCacheShapeMRU {
+    private:
+        MONGO_DISALLOW_COPYING(PlanCacheShapeMRU);
+    public:
+        PlanCacheShapeMRU();
+
+        /**
+         * Looks for a slot recorded against 'cache' at 'generation' with
+         * 'shapeHash'.  On a hit, moves the slot to the front and copies out the
+         * stored key and entry.
+         */
+        bool get(const PlanCache* cache,
+                 unsigned long long generation,
+                 unsigned long long shapeHash,
+                 PlanCacheKey* keyOut,
+                 boost::shared_ptr<PlanCacheEntry>* entryOut);
+
+        /**
+         * Records a shape in the front slot, evicting the least recently used one.
+         */
+        void put(const PlanCache* cache,
+                 unsigned long long generation,
+                 unsigned long long shapeHash,
+                 const PlanCacheKey& key,
+                 const boost::shared_ptr<PlanCacheEntry>& entry);
+
+    private:
+        struct Slot {
+            Slot() : cache(NULL), generation(0), shapeHash(0) { }
+
+            const PlanCache* cache;
+            unsigned long long generation;
+            unsigned long long shapeHash;
+            PlanCacheKey key;
+            boost::shared_ptr<PlanCacheEntry> entry;
+        };
+
+        static const size_t kNumSlots = 4;
+
+        // Most recently used first.
+        Slot _slots[kNumSlots];
     };
 
     /**
@@ -313,6 +395,10 @@ namespace mongo {
          * Look up the cached data access for the provided 'query'.  Used by the query planner
          * to shortcut planning.
          *
+         * Consults the calling thread's PlanCacheShapeMRU first; on an MRU hit the
+         * shared cache's mutex is never taken and the string cache key is never
+         * built.
+         *
          * If there is no entry in the cache for the 'query', returns an error Status.
          *
          * If there is an entry in the cache, populates 'crOut' and returns Status::OK().  Caller
@@ -386,6 +472,22 @@ namespace mongo {
          */
         void notifyOfWriteOp();
 
+        /**
+         * Appends a persistable BSON representation of every entry to 'out'.
+         * Together with loadPersistedEntry() this lets the cache contents be
+         * carried across a mongod restart.
+         */
+        void getPersistedEntries(std::vector<BSONObj>* out) const;
+
+        /**
+         * Re-inserts an entry previously produced by getPersistedEntries().  The
+         * stored query shape is re-canonicalized against this cache's namespace to
+         * compute the key.  Returns an error Status for malformed entries or query
+         * shapes that can no longer be canonicalized; the cache is unchanged in
+         * that case.
+         */
+        Status loadPersistedEntry(const BSONObj& obj);
+
     private:
 
         /**
@@ -408,6 +510,12 @@ namespace mongo {
          */
         AtomicInt32 _writeOperations;
 
+        /**
+         * Stamped on PlanCacheShapeMRU slots and advanced (under _cacheMutex) on
+         * every mutation, invalidating all MRU slots recorded against this cache.
+         */
+        AtomicUInt64 _generation;
+
         /**
          * Full namespace of collection.
          */
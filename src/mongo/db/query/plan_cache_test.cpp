@@ -378,6 +378,45 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    // A persisted entry can be reloaded into a fresh cache and looked up
+    // under the same query shape.
+    TEST(PlanCacheTest, PersistedEntryRoundTrip) {
+        PlanCache planCache(ns);
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        qs.cacheData->tree->setIndexEntry(IndexEntry(fromjson("{a: 1}")));
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+        std::vector<BSONObj> persisted;
+        planCache.getPersistedEntries(&persisted);
+        ASSERT_EQUALS(persisted.size(), 1U);
+
+        PlanCache reloadedCache(ns);
+        ASSERT_OK(reloadedCache.loadPersistedEntry(persisted[0]));
+        ASSERT_TRUE(reloadedCache.contains(*cq));
+
+        // The reloaded entry must produce a usable CachedSolution.
+        CachedSolution* rawCS;
+        ASSERT_OK(reloadedCache.get(*cq, &rawCS));
+        auto_ptr<CachedSolution> cs(rawCS);
+        ASSERT_EQUALS(cs->plannerData.size(), 1U);
+        ASSERT(NULL != cs->plannerData[0]->tree.get());
+        ASSERT(NULL != cs->plannerData[0]->tree->entry.get());
+        ASSERT_EQUALS(cs->plannerData[0]->tree->entry->name, std::string("test_foo"));
+    }
+
+    // Malformed persisted entries are rejected without changing the cache.
+    TEST(PlanCacheTest, LoadPersistedEntryRejectsMalformed) {
+        PlanCache planCache(ns);
+        ASSERT_NOT_OK(planCache.loadPersistedEntry(BSONObj()));
+        ASSERT_NOT_OK(planCache.loadPersistedEntry(fromjson("{version: 99}")));
+        ASSERT_EQUALS(planCache.size(), 0U);
+    }
+
     TEST(PlanCacheTest, NotifyOfWriteOp) {
         PlanCache planCache;
         auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/plan_enumerator.h"
 
+#include <algorithm>
 #include <set>
 
 #include "mongo/db/query/indexability.h"
@@ -56,6 +57,59 @@ namespace {
             || CanonicalQuery::countNodes(node, MatchExpression::TEXT) > 0;
     }
 
+    /**
+     * How selective does 'pred' look, based on shape alone?  We have no cardinality
+     * statistics, but an equality constrains an index scan far more than a bounded range,
+     * which in turn beats a match the index can barely help with.  Bigger is better.
+     */
+    int predSelectivityScore(const MatchExpression* pred) {
+        switch (pred->matchType()) {
+        case MatchExpression::EQ:
+            return 4;
+        case MatchExpression::MATCH_IN:
+            return 3;
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            return 2;
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::TYPE_OPERATOR:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * Score for a candidate one-index branch of an intersection: its most selective
+     * predicate dominates, with extra predicates on the same index as a tie-breaker.
+     */
+    int branchSelectivityScore(const std::vector<MatchExpression*>& preds) {
+        int best = 0;
+        for (size_t i = 0; i < preds.size(); ++i) {
+            best = std::max(best, predSelectivityScore(preds[i]));
+        }
+        return best * 8 + std::min(static_cast<int>(preds.size()), 7);
+    }
+
+    /**
+     * Orders (index, preds) map iterators so that branches with more selective-looking
+     * predicates come first, tie-broken by index id for determinism.
+     */
+    struct BranchSelectivityGreater {
+        template <typename MapIt>
+        bool operator()(const MapIt& lhs, const MapIt& rhs) const {
+            const int lhsScore = branchSelectivityScore(lhs->second);
+            const int rhsScore = branchSelectivityScore(rhs->second);
+            if (lhsScore != rhsScore) {
+                return lhsScore > rhsScore;
+            }
+            return lhs->first < rhs->first;
+        }
+    };
+
 } // namespace
 
 
@@ -68,12 +122,7 @@ namespace mongo {
           _orLimit(params.maxSolutionsPerOr),
           _intersectLimit(params.maxIntersectPerAnd) { }
 
-    PlanEnumerator::~PlanEnumerator() {
-        typedef unordered_map<MemoID, NodeAssignment*> MemoMap;
-        for (MemoMap::iterator it = _memo.begin(); it != _memo.end(); ++it) {
-            delete it->second;
-        }
-    }
+    PlanEnumerator::~PlanEnumerator() { }
 
     Status PlanEnumerator::init() {
         // Fill out our memo structure from the tagged _root.
@@ -90,32 +139,32 @@ namespace mongo {
 
         // Note that this needs to be kept in sync with allocateAssignment which assigns memo IDs.
         for (size_t i = 1; i < _memo.size(); ++i) {
-            ss << "[Node #" << i << "]: " << _memo[i]->toString() << "\n";
+            ss << "[Node #" << i << "]: " << _memo[i].toString() << "\n";
         }
         return ss;
     }
 
     string PlanEnumerator::NodeAssignment::toString() const {
-        if (NULL != pred) {
+        if (kPredicate == type) {
             mongoutils::str::stream ss;
             ss << "predicate\n";
             ss << "\tfirst indices: [";
-            for (size_t i = 0; i < pred->first.size(); ++i) {
-                ss << pred->first[i];
-                if (i < pred->first.size() - 1)
+            for (size_t i = 0; i < pred.first.size(); ++i) {
+                ss << pred.first[i];
+                if (i < pred.first.size() - 1)
                     ss << ", ";
             }
             ss << "]\n";
-            ss << "\tpred: " << pred->expr->toString();
-            ss << "\tindexToAssign: " << pred->indexToAssign;
+            ss << "\tpred: " << pred.expr->toString();
+            ss << "\tindexToAssign: " << pred.indexToAssign;
             return ss;
         }
-        else if (NULL != andAssignment) {
+        else if (kAnd == type) {
             mongoutils::str::stream ss;
-            ss << "AND enumstate counter " << andAssignment->counter;
-            for (size_t i = 0; i < andAssignment->choices.size(); ++i) {
+            ss << "AND enumstate counter " << andAssignment.counter;
+            for (size_t i = 0; i < andAssignment.choices.size(); ++i) {
                 ss << "\n\tchoice " << i << ":\n";
-                const AndEnumerableState& state = andAssignment->choices[i];
+                const AndEnumerableState& state = andAssignment.choices[i];
                 ss << "\t\tsubnodes: ";
                 for (size_t j = 0; j < state.subnodesToIndex.size(); ++j) {
                     ss << state.subnodesToIndex[j] << " ";
@@ -133,21 +182,21 @@ namespace mongo {
             }
             return ss;
         }
-        else if (NULL != arrayAssignment) {
+        else if (kArray == type) {
             mongoutils::str::stream ss;
-            ss << "ARRAY SUBNODES enumstate " << arrayAssignment->counter << "/ ONE OF: [ ";
-            for (size_t i = 0; i < arrayAssignment->subnodes.size(); ++i) {
-                ss << arrayAssignment->subnodes[i] << " ";
+            ss << "ARRAY SUBNODES enumstate " << arrayAssignment.counter << "/ ONE OF: [ ";
+            for (size_t i = 0; i < arrayAssignment.subnodes.size(); ++i) {
+                ss << arrayAssignment.subnodes[i] << " ";
             }
             ss << "]";
             return ss;
         }
         else {
-            verify(NULL != orAssignment);
+            verify(kOr == type);
             mongoutils::str::stream ss;
             ss << "ALL OF: [ ";
-            for (size_t i = 0; i < orAssignment->subnodes.size(); ++i) {
-                ss << orAssignment->subnodes[i] << " ";
+            for (size_t i = 0; i < orAssignment.subnodes.size(); ++i) {
+                ss << orAssignment.subnodes[i] << " ";
             }
             ss << "]";
             return ss;
@@ -189,16 +238,20 @@ namespace mongo {
                                             NodeAssignment** assign,
                                             MemoID* id) {
         // We start at 1 so that the lookup of any entries not explicitly allocated
-        // will refer to an invalid memo slot.
-        size_t newID = _memo.size() + 1;
+        // will refer to an invalid memo slot.  Slot 0 is a placeholder.
+        if (_memo.empty()) {
+            _memo.push_back(NodeAssignment());
+        }
+
+        size_t newID = _memo.size();
 
         // Shouldn't be anything there already.
         verify(_nodeToId.end() == _nodeToId.find(expr));
         _nodeToId[expr] = newID;
-        verify(_memo.end() == _memo.find(newID));
-        NodeAssignment* newAssignment = new NodeAssignment();
-        _memo[newID] = newAssignment;
-        *assign = newAssignment;
+        // A deque never relocates its elements, so '*assign' stays valid as later entries are
+        // added.
+        _memo.push_back(NodeAssignment());
+        *assign = &_memo[newID];
         *id = newID;
     }
 
@@ -223,9 +276,9 @@ namespace mongo {
             NodeAssignment* assign;
             allocateAssignment(node, &assign, &myMemoID);
 
-            assign->pred.reset(new PredicateAssignment());
-            assign->pred->expr = node;
-            assign->pred->first.swap(rt->first);
+            assign->type = NodeAssignment::kPredicate;
+            assign->pred.expr = node;
+            assign->pred.first.swap(rt->first);
             return true;
         }
         else if (Indexability::isBoundsGeneratingNot(node)) {
@@ -241,9 +294,8 @@ namespace mongo {
             size_t myMemoID;
             NodeAssignment* assign;
             allocateAssignment(node, &assign, &myMemoID);
-            OrAssignment* orAssignment = new OrAssignment();
-            orAssignment->subnodes.push_back(memoIDForNode(node->getChild(0)));
-            assign->orAssignment.reset(orAssignment);
+            assign->type = NodeAssignment::kOr;
+            assign->orAssignment.subnodes.push_back(memoIDForNode(node->getChild(0)));
             return true;
         }
         else if (MatchExpression::OR == node->matchType()) {
@@ -259,17 +311,16 @@ namespace mongo {
             NodeAssignment* assign;
             allocateAssignment(node, &assign, &myMemoID);
 
-            OrAssignment* orAssignment = new OrAssignment();
+            assign->type = NodeAssignment::kOr;
             for (size_t i = 0; i < node->numChildren(); ++i) {
-                orAssignment->subnodes.push_back(memoIDForNode(node->getChild(i)));
+                assign->orAssignment.subnodes.push_back(memoIDForNode(node->getChild(i)));
             }
-            assign->orAssignment.reset(orAssignment);
             return true;
         }
         else if (Indexability::arrayUsesIndexOnChildren(node)) {
             // Add each of our children as a subnode.  We enumerate through each subnode one at a
             // time until it's exhausted then we move on.
-            auto_ptr<ArrayAssignment> aa(new ArrayAssignment());
+            ArrayAssignment aa;
 
             if (MatchExpression::ELEM_MATCH_OBJECT == node->matchType()) {
                 childContext.elemMatchExpr = node;
@@ -278,17 +329,18 @@ namespace mongo {
             // For an OR to be indexed, all its children must be indexed.
             for (size_t i = 0; i < node->numChildren(); ++i) {
                 if (prepMemo(node->getChild(i), childContext)) {
-                    aa->subnodes.push_back(memoIDForNode(node->getChild(i)));
+                    aa.subnodes.push_back(memoIDForNode(node->getChild(i)));
                 }
             }
 
-            if (0 == aa->subnodes.size()) { return false; }
+            if (0 == aa.subnodes.size()) { return false; }
 
             size_t myMemoID;
             NodeAssignment* assign;
             allocateAssignment(node, &assign, &myMemoID);
 
-            assign->arrayAssignment.reset(aa.release());
+            assign->type = NodeAssignment::kArray;
+            assign->arrayAssignment.subnodes.swap(aa.subnodes);
             return true;
         }
         else if (MatchExpression::AND == node->matchType()) {
@@ -388,13 +440,11 @@ namespace mongo {
             }
 
             // At least one child can use an index, so we can create a memo entry.
-            AndAssignment* andAssignment = new AndAssignment();
-
             size_t myMemoID;
             NodeAssignment* nodeAssignment;
             allocateAssignment(node, &nodeAssignment, &myMemoID);
-            // Takes ownership.
-            nodeAssignment->andAssignment.reset(andAssignment);
+            nodeAssignment->type = NodeAssignment::kAnd;
+            AndAssignment* andAssignment = &nodeAssignment->andAssignment;
 
             // Predicates which must use an index might be buried inside
             // a subnode. Handle that case here.
@@ -676,8 +726,19 @@ namespace mongo {
 
         size_t sizeBefore = andAssignment->choices.size();
 
-        for (IndexToPredMap::const_iterator firstIt = idxToFirst.begin();
-                firstIt != idxToFirst.end(); ++firstIt) {
+        // We cut enumeration off at _intersectLimit below, and idxToFirst's hash order is
+        // arbitrary: the budget can go entirely to unpromising combinations while the pair
+        // of selective equalities never gets emitted.  Rank the one-index branches by how
+        // selective their predicates look so the cap keeps the plausible intersections.
+        vector<IndexToPredMap::const_iterator> ranked;
+        for (IndexToPredMap::const_iterator it = idxToFirst.begin();
+                it != idxToFirst.end(); ++it) {
+            ranked.push_back(it);
+        }
+        std::stable_sort(ranked.begin(), ranked.end(), BranchSelectivityGreater());
+
+        for (size_t firstRank = 0; firstRank < ranked.size(); ++firstRank) {
+            IndexToPredMap::const_iterator firstIt = ranked[firstRank];
 
             const IndexEntry& oneIndex = (*_indices)[firstIt->first];
 
@@ -723,10 +784,11 @@ namespace mongo {
             }
 
             // Start looking at all other indices to find one that we want to bundle
-            // with firstAssign.
-            IndexToPredMap::const_iterator secondIt = firstIt;
-            secondIt++;
-            for (; secondIt != idxToFirst.end(); secondIt++) {
+            // with firstAssign.  Later entries in 'ranked' look less selective, so the
+            // most promising pairs are emitted (and counted against the limit) first.
+            for (size_t secondRank = firstRank + 1; secondRank < ranked.size();
+                    ++secondRank) {
+                IndexToPredMap::const_iterator secondIt = ranked[secondRank];
                 const IndexEntry& firstIndex = (*_indices)[secondIt->first];
                 const IndexEntry& secondIndex = (*_indices)[secondIt->first];
 
@@ -1134,27 +1196,27 @@ namespace mongo {
 
     void PlanEnumerator::tagMemo(size_t id) {
         QLOG() << "Tagging memoID " << id << endl;
-        NodeAssignment* assign = _memo[id];
-        verify(NULL != assign);
+        verify(id > 0 && id < _memo.size());
+        NodeAssignment* assign = &_memo[id];
 
-        if (NULL != assign->pred) {
-            PredicateAssignment* pa = assign->pred.get();
+        if (NodeAssignment::kPredicate == assign->type) {
+            PredicateAssignment* pa = &assign->pred;
             verify(NULL == pa->expr->getTag());
             verify(pa->indexToAssign < pa->first.size());
             pa->expr->setTag(new IndexTag(pa->first[pa->indexToAssign]));
         }
-        else if (NULL != assign->orAssignment) {
-            OrAssignment* oa = assign->orAssignment.get();
+        else if (NodeAssignment::kOr == assign->type) {
+            OrAssignment* oa = &assign->orAssignment;
             for (size_t i = 0; i < oa->subnodes.size(); ++i) {
                 tagMemo(oa->subnodes[i]);
             }
         }
-        else if (NULL != assign->arrayAssignment) {
-            ArrayAssignment* aa = assign->arrayAssignment.get();
+        else if (NodeAssignment::kArray == assign->type) {
+            ArrayAssignment* aa = &assign->arrayAssignment;
             tagMemo(aa->subnodes[aa->counter]);
         }
-        else if (NULL != assign->andAssignment) {
-            AndAssignment* aa = assign->andAssignment.get();
+        else if (NodeAssignment::kAnd == assign->type) {
+            AndAssignment* aa = &assign->andAssignment;
             verify(aa->counter < aa->choices.size());
 
             const AndEnumerableState& aes = aa->choices[aa->counter];
@@ -1179,11 +1241,11 @@ namespace mongo {
     }
 
     bool PlanEnumerator::nextMemo(size_t id) {
-        NodeAssignment* assign = _memo[id];
-        verify(NULL != assign);
+        verify(id > 0 && id < _memo.size());
+        NodeAssignment* assign = &_memo[id];
 
-        if (NULL != assign->pred) {
-            PredicateAssignment* pa = assign->pred.get();
+        if (NodeAssignment::kPredicate == assign->type) {
+            PredicateAssignment* pa = &assign->pred;
             pa->indexToAssign++;
             if (pa->indexToAssign >= pa->first.size()) {
                 pa->indexToAssign = 0;
@@ -1191,8 +1253,8 @@ namespace mongo {
             }
             return false;
         }
-        else if (NULL != assign->orAssignment) {
-            OrAssignment* oa = assign->orAssignment.get();
+        else if (NodeAssignment::kOr == assign->type) {
+            OrAssignment* oa = &assign->orAssignment;
 
             // Limit the number of OR enumerations
             oa->counter++;
@@ -1212,8 +1274,8 @@ namespace mongo {
             // If we're here, the last subnode had a carry, therefore the OR has a carry.
             return true;
         }
-        else if (NULL != assign->arrayAssignment) {
-            ArrayAssignment* aa = assign->arrayAssignment.get();
+        else if (NodeAssignment::kArray == assign->type) {
+            ArrayAssignment* aa = &assign->arrayAssignment;
             // moving to next on current subnode is OK
             if (!nextMemo(aa->subnodes[aa->counter])) { return false; }
             // Move to next subnode.
@@ -1224,8 +1286,8 @@ namespace mongo {
             aa->counter = 0;
             return true;
         }
-        else if (NULL != assign->andAssignment) {
-            AndAssignment* aa = assign->andAssignment.get();
+        else if (NodeAssignment::kAnd == assign->type) {
+            AndAssignment* aa = &assign->andAssignment;
             ++aa->counter;
             if (aa->counter < aa->choices.size()) {
                 return false;
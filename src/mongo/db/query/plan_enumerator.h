@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -174,7 +175,7 @@ namespace mongo {
          */
 
         struct PredicateAssignment {
-            PredicateAssignment() : indexToAssign(0) { }
+            PredicateAssignment() : expr(NULL), indexToAssign(0) { }
 
             std::vector<IndexID> first;
             // Not owned here.
@@ -229,17 +230,35 @@ namespace mongo {
 
         /**
          * Associates indices with predicates.
+         *
+         * Memo entries live by value inside '_memo' below, so the sub-assignments are stored
+         * inline rather than as individually heap-allocated objects.  'type' says which member
+         * is in use; the unused members are default-constructed and their vectors stay empty,
+         * so they allocate nothing.
          */
         struct NodeAssignment {
-            scoped_ptr<PredicateAssignment> pred;
-            scoped_ptr<OrAssignment> orAssignment;
-            scoped_ptr<AndAssignment> andAssignment;
-            scoped_ptr<ArrayAssignment> arrayAssignment;
+            enum Type {
+                kNone,
+                kPredicate,
+                kOr,
+                kAnd,
+                kArray
+            };
+
+            NodeAssignment() : type(kNone) { }
+
+            Type type;
+
+            PredicateAssignment pred;
+            OrAssignment orAssignment;
+            AndAssignment andAssignment;
+            ArrayAssignment arrayAssignment;
+
             std::string toString() const;
         };
 
         /**
-         * Allocates a NodeAssignment and associates it with the provided 'expr'.
+         * Grabs a new memo slot for the provided 'expr'.
          *
          * The unique MemoID of the new assignment is outputted in '*id'.
          * The out parameter '*slot' points to the newly allocated NodeAssignment.
@@ -414,8 +433,12 @@ namespace mongo {
         // Map from expression to its MemoID.
         unordered_map<MatchExpression*, MemoID> _nodeToId;
 
-        // Map from MemoID to its precomputed solution info.
-        unordered_map<MemoID, NodeAssignment*> _memo;
+        // Memo entries indexed by MemoID.  Slot 0 is an unused placeholder so that valid IDs
+        // start at 1 (see allocateAssignment).  A deque rather than a vector because growth
+        // must not invalidate NodeAssignment pointers held across recursive prepMemo calls;
+        // its chunked allocation also replaces what used to be several heap allocations per
+        // memo entry with one amortized over many.
+        std::deque<NodeAssignment> _memo;
 
         // If true, there are no further enumeration states, and getNext should return false.
         // We could be _done immediately after init if we're unable to output an indexed plan.
@@ -32,11 +32,68 @@
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    namespace {
+
+        // How many work cycles may pass between scan limit checks. Each check clones the
+        // stats tree, so this bounds both the overhead and the slack past a limit.
+        const int kWorksPerScanLimitCheck = 256;
+
+        /**
+         * Sums documents and index keys examined over a stats tree.
+         */
+        void tallyScanStats(const PlanStageStats& stats, long long* docs, long long* keys) {
+            if (NULL != stats.specific.get()) {
+                switch (stats.stageType) {
+                case STAGE_COLLSCAN:
+                    *docs += static_cast<const CollectionScanStats*>(stats.specific.get())
+                                 ->docsTested;
+                    break;
+                case STAGE_FETCH:
+                    *docs += static_cast<const FetchStats*>(stats.specific.get())->docsExamined;
+                    break;
+                case STAGE_IDHACK: {
+                    const IDHackStats* idhack =
+                        static_cast<const IDHackStats*>(stats.specific.get());
+                    *docs += idhack->docsExamined;
+                    *keys += idhack->keysExamined;
+                    break;
+                }
+                case STAGE_IXSCAN:
+                    *keys += static_cast<const IndexScanStats*>(stats.specific.get())
+                                 ->keysExamined;
+                    break;
+                case STAGE_COUNT:
+                    *keys += static_cast<const CountStats*>(stats.specific.get())->keysExamined;
+                    break;
+                case STAGE_DISTINCT:
+                    *keys += static_cast<const DistinctScanStats*>(stats.specific.get())
+                                 ->keysExamined;
+                    break;
+                case STAGE_TEXT:
+                    *keys += static_cast<const TextStats*>(stats.specific.get())->keysExamined;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            for (size_t i = 0; i < stats.children.size(); ++i) {
+                tallyScanStats(*stats.children[i], docs, keys);
+            }
+        }
+
+    }  // namespace
+
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt, const Collection* collection)
         : _collection(collection),
+          _maxDocsExamined(0),
+          _maxKeysExamined(0),
+          _worksUntilScanLimitCheck(0),
           _workingSet(ws),
           _root(rt),
           _qs(NULL),
@@ -45,6 +102,9 @@ namespace mongo {
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt, QuerySolution* qs,
                                const Collection* collection)
         : _collection(collection),
+          _maxDocsExamined(0),
+          _maxKeysExamined(0),
+          _worksUntilScanLimitCheck(0),
           _workingSet(ws),
           _root(rt),
           _qs(qs),
@@ -75,10 +135,56 @@ namespace mongo {
         if (!_killed) { _root->invalidate(dl, type); }
     }
 
+    void PlanExecutor::setScanLimits(long long maxDocsExamined, long long maxKeysExamined) {
+        _maxDocsExamined = maxDocsExamined;
+        _maxKeysExamined = maxKeysExamined;
+        const bool limited = _maxDocsExamined > 0 || _maxKeysExamined > 0;
+        _worksUntilScanLimitCheck = limited ? kWorksPerScanLimitCheck : 0;
+    }
+
+    bool PlanExecutor::scanLimitExceeded(std::string* why) const {
+        boost::scoped_ptr<PlanStageStats> stats(_root->getStats());
+        long long docs = 0;
+        long long keys = 0;
+        tallyScanStats(*stats, &docs, &keys);
+
+        if (_maxDocsExamined > 0 && docs > _maxDocsExamined) {
+            mongoutils::str::stream ss;
+            ss << "query examined " << docs << " documents, exceeding the limit of "
+               << _maxDocsExamined << " configured for this query shape";
+            *why = ss;
+            return true;
+        }
+        if (_maxKeysExamined > 0 && keys > _maxKeysExamined) {
+            mongoutils::str::stream ss;
+            ss << "query examined " << keys << " index keys, exceeding the limit of "
+               << _maxKeysExamined << " configured for this query shape";
+            *why = ss;
+            return true;
+        }
+        return false;
+    }
+
     Runner::RunnerState PlanExecutor::getNext(BSONObj* objOut, DiskLoc* dlOut) {
         if (_killed) { return Runner::RUNNER_DEAD; }
 
         for (;;) {
+            // Amortized enforcement of any per-query-shape scan limits; see setScanLimits().
+            if (_worksUntilScanLimitCheck > 0 && 0 == --_worksUntilScanLimitCheck) {
+                _worksUntilScanLimitCheck = kWorksPerScanLimitCheck;
+                std::string why;
+                if (scanLimitExceeded(&why)) {
+                    warning() << "stopping query: " << why << endl;
+                    _killed = true;
+                    if (NULL != objOut) {
+                        WorkingSetID statusId = WorkingSetCommon::allocateStatusMember(
+                            _workingSet.get(), Status(ErrorCodes::OperationFailed, why));
+                        WorkingSetCommon::getStatusMemberObject(*_workingSet, statusId, objOut);
+                    }
+                    return Runner::RUNNER_ERROR;
+                }
+            }
+
             WorkingSetID id = WorkingSet::INVALID_ID;
             PlanStage::StageState code = _root->work(&id);
 
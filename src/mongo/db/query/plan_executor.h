@@ -84,6 +84,18 @@ namespace mongo {
         // Running Support
         //
 
+        /**
+         * Limit how many documents and index keys the stage tree may examine before the plan
+         * is killed.  A value that is zero or negative means no limit on that resource.
+         *
+         * The counters live in the per-stage execution stats, so rather than walking the
+         * stats tree on every work cycle, getNext() re-checks the totals every few hundred
+         * cycles: a runaway plan is stopped after bounded damage, not at exactly the limit.
+         * Once a limit is exceeded, getNext() returns RUNNER_ERROR (with a status member
+         * describing the limit) and the executor is dead.
+         */
+        void setScanLimits(long long maxDocsExamined, long long maxKeysExamined);
+
         /** TODO document me */
         Runner::RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut);
 
@@ -121,10 +133,24 @@ namespace mongo {
         Status executePlan();
 
     private:
+        /**
+         * Returns true if the stage tree has examined more documents or index keys than
+         * setScanLimits() allows, filling out 'why' with a description of the exceeded limit.
+         * Walks the execution stats tree; amortized by the caller.
+         */
+        bool scanLimitExceeded(std::string* why) const;
+
         // Collection over which this plan executor runs. Used to resolve record ids retrieved by
         // the plan stages. The collection must not be destroyed while there are active plans.
         const Collection* _collection;
 
+        // See setScanLimits(). Zero or negative means unlimited.
+        long long _maxDocsExamined;
+        long long _maxKeysExamined;
+
+        // Work cycles until the next scan limit check; stays at zero when no limits are set.
+        int _worksUntilScanLimitCheck;
+
         boost::scoped_ptr<WorkingSet> _workingSet;
         std::auto_ptr<PlanStage> _root;
         boost::scoped_ptr<QuerySolution> _qs;
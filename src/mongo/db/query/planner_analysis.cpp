@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "mongo/db/jsobj.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/qlog.h"
@@ -246,6 +247,21 @@ namespace mongo {
             return false;
         }
 
+        /**
+         * Walk the tree 'root' and mark every fetch node so that the corresponding stage
+         * buffers locs and fetches the documents in DiskLoc order.  Only called once the
+         * caller has established that the order of the fetched documents doesn't matter.
+         */
+        void flagFetchNodesForReorder(QuerySolutionNode* root) {
+            if (STAGE_FETCH == root->getType()) {
+                static_cast<FetchNode*>(root)->reorderDocs = true;
+            }
+
+            for (size_t i = 0; i < root->children.size(); ++i) {
+                flagFetchNodesForReorder(root->children[i]);
+            }
+        }
+
     }  // namespace
 
     bool QueryPlannerAnalysis::explodeForSort(const CanonicalQuery& query,
@@ -443,6 +459,17 @@ namespace mongo {
             sort->limit = size_t(query.getParsed().getNumToReturn()) +
                           size_t(query.getParsed().getSkip());
 
+            // A limited sort on text score alone only ever surfaces the 'limit'
+            // best-scoring documents, so tell the text stage it may stop scoring as
+            // soon as its bounds prove the top k is decided.  Only safe when the text
+            // stage feeds the sort directly: any stage in between could filter docs,
+            // and then a truncated candidate set might come up short.
+            if (1 == sortObj.nFields() &&
+                LiteParsedQuery::isTextScoreMeta(sortObj.firstElement()) &&
+                STAGE_TEXT == sort->children[0]->getType()) {
+                static_cast<TextNode*>(sort->children[0])->topK = sort->limit;
+            }
+
             // This is a SORT with a limit. The wire protocol has a single quantity
             // called "numToReturn" which could mean either limit or batchSize.
             // We have no idea what the client intended. One way to handle the ambiguity
@@ -689,6 +716,20 @@ namespace mongo {
             solnRoot = limit;
         }
 
+        // If the order in which documents come out of a fetch doesn't matter -- either no
+        // sort was requested, or a blocking sort above the fetch re-orders everything
+        // anyway -- the fetch stages may return documents in DiskLoc order, turning random
+        // data-file reads into sequential ones.  Geo-near and text trees imply an ordering
+        // of their own, and a merge-sort's order must be preserved, so leave those alone.
+        if (internalQueryFetchReorderMaxDocs > 0 &&
+            (query.getParsed().getSort().isEmpty() || hasSortStage) &&
+            !hasNode(solnRoot, STAGE_GEO_NEAR_2D) &&
+            !hasNode(solnRoot, STAGE_GEO_NEAR_2DSPHERE) &&
+            !hasNode(solnRoot, STAGE_TEXT) &&
+            !hasNode(solnRoot, STAGE_SORT_MERGE)) {
+            flagFetchNodesForReorder(solnRoot);
+        }
+
         soln->root.reset(solnRoot);
         return soln.release();
     }
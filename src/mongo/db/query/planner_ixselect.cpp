@@ -30,11 +30,15 @@
 
 #include <vector>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/geo/core.h"
 #include "mongo/db/geo/hash.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_tag.h"
@@ -120,6 +124,174 @@ namespace mongo {
         }
     }
 
+    namespace {
+
+        // Types whose ordering under woCompare is simple enough to reason about when
+        // proving range implication.  Arrays, objects, null and the like have matching
+        // semantics (type bracketing, null-matches-missing) we don't want to model here.
+        bool isSimpleComparableType(BSONType type) {
+            switch (type) {
+            case NumberInt:
+            case NumberLong:
+            case NumberDouble:
+            case String:
+            case Bool:
+            case Date:
+            case jstOID:
+            case Timestamp:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool isNaN(const BSONElement& e) {
+            return NumberDouble == e.type() && e.numberDouble() != e.numberDouble();
+        }
+
+        bool isComparisonMatchType(MatchExpression::MatchType type) {
+            return MatchExpression::EQ == type
+                || MatchExpression::LT == type
+                || MatchExpression::LTE == type
+                || MatchExpression::GT == type
+                || MatchExpression::GTE == type;
+        }
+
+        /**
+         * Does the single query predicate 'queryPred' imply the single partial index
+         * filter predicate 'filterPred'?
+         */
+        bool predicateImpliesPredicate(const MatchExpression* queryPred,
+                                       const MatchExpression* filterPred) {
+            if (queryPred->path() != filterPred->path()) {
+                return false;
+            }
+
+            const MatchExpression::MatchType queryType = queryPred->matchType();
+            const MatchExpression::MatchType filterType = filterPred->matchType();
+            const bool queryIsComparison = isComparisonMatchType(queryType);
+
+            if (MatchExpression::EXISTS == filterType) {
+                // {$exists: true} is implied by any comparison that cannot match a
+                // missing field; only equality to null can (missing matches as null).
+                if (MatchExpression::EXISTS == queryType) {
+                    return true;
+                }
+                if (queryIsComparison) {
+                    const BSONElement& rhs =
+                        static_cast<const ComparisonMatchExpression*>(queryPred)->getData();
+                    return jstNULL != rhs.type();
+                }
+                return false;
+            }
+
+            if (!queryIsComparison || !isComparisonMatchType(filterType)) {
+                return false;
+            }
+
+            const BSONElement& queryRhs =
+                static_cast<const ComparisonMatchExpression*>(queryPred)->getData();
+            const BSONElement& filterRhs =
+                static_cast<const ComparisonMatchExpression*>(filterPred)->getData();
+
+            // An equality filter is only implied by the identical equality; value
+            // equality is sound for any type since the predicates are then the same.
+            if (MatchExpression::EQ == filterType) {
+                return MatchExpression::EQ == queryType && queryRhs.valuesEqual(filterRhs);
+            }
+
+            // Range implication.  Comparisons only match values in the same canonical
+            // type bracket as their bound, so the bounds must live in the same bracket
+            // and be of types whose ordering we trust.
+            if (!isSimpleComparableType(queryRhs.type())
+                || !isSimpleComparableType(filterRhs.type())
+                || queryRhs.canonicalType() != filterRhs.canonicalType()
+                || isNaN(queryRhs)
+                || isNaN(filterRhs)) {
+                return false;
+            }
+
+            const int cmp = queryRhs.woCompare(filterRhs, false);
+
+            switch (filterType) {
+            case MatchExpression::GT:
+                if (MatchExpression::GT == queryType) {
+                    return cmp >= 0;
+                }
+                return (MatchExpression::EQ == queryType || MatchExpression::GTE == queryType)
+                    && cmp > 0;
+            case MatchExpression::GTE:
+                return (MatchExpression::EQ == queryType
+                        || MatchExpression::GT == queryType
+                        || MatchExpression::GTE == queryType)
+                    && cmp >= 0;
+            case MatchExpression::LT:
+                if (MatchExpression::LT == queryType) {
+                    return cmp <= 0;
+                }
+                return (MatchExpression::EQ == queryType || MatchExpression::LTE == queryType)
+                    && cmp < 0;
+            case MatchExpression::LTE:
+                return (MatchExpression::EQ == queryType
+                        || MatchExpression::LT == queryType
+                        || MatchExpression::LTE == queryType)
+                    && cmp <= 0;
+            default:
+                return false;
+            }
+        }
+
+        // The root if it is usable on its own, or the direct children of a root $and.
+        // Predicates nested under $or/$nor/$not can't prove anything by themselves.
+        void getTopLevelPredicates(const MatchExpression* root,
+                                   vector<const MatchExpression*>* out) {
+            if (MatchExpression::AND == root->matchType()) {
+                for (size_t i = 0; i < root->numChildren(); ++i) {
+                    out->push_back(root->getChild(i));
+                }
+            }
+            else {
+                out->push_back(root);
+            }
+        }
+
+    } // namespace
+
+    // static
+    bool QueryPlannerIXSelect::canUsePartialIndex(const IndexEntry& index,
+                                                  const MatchExpression* queryExpr) {
+        if (!index.partial) {
+            return true;
+        }
+
+        StatusWithMatchExpression parsed =
+            MatchExpressionParser::parse(index.infoObj.getObjectField("partialFilterExpression"));
+        if (!parsed.isOK()) {
+            // Can't reason about a filter we can't parse; don't use the index.
+            return false;
+        }
+        boost::scoped_ptr<MatchExpression> filterExpr(parsed.getValue());
+
+        vector<const MatchExpression*> queryPreds;
+        getTopLevelPredicates(queryExpr, &queryPreds);
+
+        // Every predicate of the filter must be implied by some predicate of the query.
+        vector<const MatchExpression*> filterPreds;
+        getTopLevelPredicates(filterExpr.get(), &filterPreds);
+
+        for (size_t i = 0; i < filterPreds.size(); ++i) {
+            bool implied = false;
+            for (size_t j = 0; j < queryPreds.size() && !implied; ++j) {
+                implied = predicateImpliesPredicate(queryPreds[j], filterPreds[i]);
+            }
+            if (!implied) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     // static
     bool QueryPlannerIXSelect::compatible(const BSONElement& elt,
                                           const IndexEntry& index,
@@ -56,6 +56,17 @@ namespace mongo {
                                         const std::vector<IndexEntry>& indices,
                                         std::vector<IndexEntry>* out);
 
+        /**
+         * Return true if the partial index described by 'index' can be used to answer 'queryExpr':
+         * that is, if every document matching the query provably matches the index's
+         * partialFilterExpression and is therefore present in the index.
+         *
+         * The check is deliberately conservative.  It proves implication predicate-by-predicate
+         * for filters that are (conjunctions of) equality, range and $exists predicates; anything
+         * it cannot prove returns false, which only costs us the index, never correctness.
+         */
+        static bool canUsePartialIndex(const IndexEntry& index, const MatchExpression* queryExpr);
+
         /**
          * Return true if the index key pattern field 'elt' (which belongs to 'index') can be used
          * to answer the predicate 'node'.
@@ -38,6 +38,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxMillis, int, 100);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationPruneRatio, double, 100.0);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
@@ -46,6 +50,8 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCachePersistenceEnabled, bool, true);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -60,4 +66,14 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanPointReadFastPath, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelScanWorkers, int, 0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryHashIntersectionSpillToDisk, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecPreemptionQuantumMillis, int, 0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryFetchReorderMaxDocs, int, 0);
+
 }  // namespace mongo
@@ -45,6 +45,17 @@ namespace mongo {
     // Stop working plans once a plan returns this many results.
     extern int internalQueryPlanEvaluationMaxResults;
 
+    // Stop working plans once the trial period has consumed this much wall-clock time,
+    // even if no plan has hit EOF or produced enough results yet. The trial runs inside
+    // the triggering query, so this bounds the latency penalty paid by the first query
+    // after a plan cache flush.
+    extern int internalQueryPlanEvaluationMaxMillis;
+
+    // Before trial execution, discard a candidate plan whose btree-estimated
+    // keys-in-bounds fraction is more than this many times the best candidate's.
+    // Zero or negative disables the pre-ranking prune.
+    extern double internalQueryPlanEvaluationPruneRatio;
+
     // Do we give a big ranking bonus to intersection plans?
     extern bool internalQueryForceIntersectionPlans;
 
@@ -69,6 +80,10 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    // Do we save each collection's plan cache to a sidecar file under the dbpath on clean
+    // shutdown and reload it when the collection is next opened?
+    extern bool internalQueryCachePersistenceEnabled;
+
     //
     // Planning and enumeration.
     //
@@ -89,4 +104,29 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    // Do we build the solution for a single-field equality query over a simple btree
+    // index directly, skipping plan enumeration and the plan cache?
+    extern bool internalQueryPlanPointReadFastPath;
+
+    // How many worker threads may an unsharded aggregation use to scan the collection in
+    // parallel and run its leading $match/$project stages?  0 or 1 disables the parallel
+    // scan and the pipeline consumes a single cursor as usual.
+    extern int internalQueryParallelScanWorkers;
+
+    // When the hashed AND stage exceeds its memory limit, does it partition its buffered
+    // DiskLocs to temporary spill files and intersect partition-by-partition (Grace hash)
+    // instead of failing the plan?
+    extern bool internalQueryHashIntersectionSpillToDisk;
+
+    // When > 0, a read batch that has run for at least this many milliseconds while a
+    // writer is blocked on the database lock it holds ends the batch early, releasing the
+    // lock to the writer; the client resumes via getMore. 0 disables the preemption check.
+    extern int internalQueryExecPreemptionQuantumMillis;
+
+    // When > 0 and the planner decides a fetch stage's output order doesn't matter, the
+    // stage buffers up to this many index entries, sorts them by DiskLoc, and fetches the
+    // documents in physical order so cold-cache reads walk the data files sequentially.
+    // 0 disables the reordering.
+    extern int internalQueryFetchReorderMaxDocs;
+
 }  // namespace mongo
@@ -515,6 +515,22 @@ namespace mongo {
             }
         }
 
+        // A partial index may only be used if the query provably matches the index's filter;
+        // otherwise documents the query should return may be missing from the index.
+        for (size_t i = 0; i < relevantIndices.size();) {
+            if (QueryPlannerIXSelect::canUsePartialIndex(relevantIndices[i], query.root())) {
+                ++i;
+                continue;
+            }
+            if (!hintIndex.isEmpty()) {
+                return Status(ErrorCodes::BadValue,
+                              "hinted index is partial and does not cover the query");
+            }
+            QLOG() << "Partial index " << relevantIndices[i].toString()
+                   << " not applicable to this query" << endl;
+            relevantIndices.erase(relevantIndices.begin() + i);
+        }
+
         // Deal with the .min() and .max() query options.  If either exist we can only use an index
         // that matches the object inside.
         if (!query.getParsed().getMin().isEmpty() || !query.getParsed().getMax().isEmpty()) {
@@ -546,6 +562,11 @@ namespace mongo {
                 for (size_t i = 0; i < params.indices.size(); ++i) {
                     const BSONObj& kp = params.indices[i].keyPattern;
 
+                    // min/max scan arbitrary key ranges, which a partial index can't serve.
+                    if (params.indices[i].partial) {
+                        continue;
+                    }
+
                     BSONObj toUse = minObj.isEmpty() ? maxObj : minObj;
                     if (indexCompatibleMaxMin(toUse, kp)) {
                         idxNo = i;
@@ -2791,6 +2791,55 @@ namespace {
                                 "{filter: null, pattern: {a: 1}}}}}");
     }
 
+    //
+    // Partial indices
+    //
+
+    TEST_F(QueryPlannerTest, PartialIndexQueryImpliesRangeFilter) {
+        addIndex(fromjson("{a: 1}"),
+                 fromjson("{partialFilterExpression: {a: {$gt: 0}}}"));
+        runQuery(fromjson("{a: {$gt: 5}}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: "
+                                "{filter: null, pattern: {a: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, PartialIndexQueryWeakerThanRangeFilter) {
+        addIndex(fromjson("{a: 1}"),
+                 fromjson("{partialFilterExpression: {a: {$gt: 0}}}"));
+        runQuery(fromjson("{a: {$gt: -5}}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
+    TEST_F(QueryPlannerTest, PartialIndexQueryImpliesEqualityFilter) {
+        addIndex(fromjson("{a: 1}"),
+                 fromjson("{partialFilterExpression: {status: 'active'}}"));
+        runQuery(fromjson("{a: {$gt: 5}, status: 'active'}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, PartialIndexQueryMissingFilterPredicate) {
+        addIndex(fromjson("{a: 1}"),
+                 fromjson("{partialFilterExpression: {status: 'active'}}"));
+        runQuery(fromjson("{a: {$gt: 5}}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
+    TEST_F(QueryPlannerTest, PartialIndexHintedButNotUsable) {
+        addIndex(fromjson("{a: 1}"),
+                 fromjson("{partialFilterExpression: {status: 'active'}}"));
+        runInvalidQueryHint(fromjson("{a: {$gt: 5}}"), fromjson("{a: 1}"));
+    }
+
     //
     // Regex
     //
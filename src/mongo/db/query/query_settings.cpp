@@ -72,6 +72,23 @@ namespace mongo {
         return entry;
     }
 
+    //
+    // ScanLimitsEntry
+    //
+
+    ScanLimitsEntry::ScanLimitsEntry(const BSONObj& query, const BSONObj& sort,
+                                     const BSONObj& projection,
+                                     const ScanLimits& limits)
+        : query(query.getOwned()),
+          sort(sort.getOwned()),
+          projection(projection.getOwned()),
+          limits(limits) { }
+
+    ScanLimitsEntry* ScanLimitsEntry::clone() const {
+        ScanLimitsEntry* entry = new ScanLimitsEntry(query, sort, projection, limits);
+        return entry;
+    }
+
     //
     // QuerySettings
     //
@@ -86,9 +103,15 @@ namespace mongo {
                                           AllowedIndices** allowedIndicesOut) const {
         invariant(allowedIndicesOut);
 
-        const PlanCacheKey& key = query.getPlanCacheKey();
-
         boost::lock_guard<boost::mutex> cacheLock(_mutex);
+
+        // Common case: no index filters set. Avoids building the query's cache key.
+        if (_allowedIndexEntryMap.empty()) {
+            *allowedIndicesOut = NULL;
+            return false;
+        }
+
+        const PlanCacheKey& key = query.getPlanCacheKey();
         AllowedIndexEntryMap::const_iterator cacheIter = _allowedIndexEntryMap.find(key);
 
         // Nothing to do if key does not exist in query settings.
@@ -152,7 +175,87 @@ namespace mongo {
 
     void QuerySettings::clearAllowedIndices() {
         boost::lock_guard<boost::mutex> cacheLock(_mutex);
-        _clear();
+        for (AllowedIndexEntryMap::const_iterator i = _allowedIndexEntryMap.begin(); i != _allowedIndexEntryMap.end(); ++i) {
+            AllowedIndexEntry* entry = i->second;
+            delete entry;
+        }
+        _allowedIndexEntryMap.clear();
+    }
+
+    bool QuerySettings::getScanLimits(const CanonicalQuery& query, ScanLimits* limitsOut) const {
+        invariant(limitsOut);
+
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+
+        // Common case: no scan limits set. Avoids building the query's cache key.
+        if (_scanLimitsEntryMap.empty()) {
+            return false;
+        }
+
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        ScanLimitsEntryMap::const_iterator cacheIter = _scanLimitsEntryMap.find(key);
+
+        // Nothing to do if key does not exist in query settings.
+        if (cacheIter == _scanLimitsEntryMap.end()) {
+            return false;
+        }
+
+        *limitsOut = cacheIter->second->limits;
+        return true;
+    }
+
+    std::vector<ScanLimitsEntry*> QuerySettings::getAllScanLimits() const {
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        vector<ScanLimitsEntry*> entries;
+        for (ScanLimitsEntryMap::const_iterator i = _scanLimitsEntryMap.begin(); i != _scanLimitsEntryMap.end(); ++i) {
+            ScanLimitsEntry* entry = i->second;
+            entries.push_back(entry->clone());
+        }
+        return entries;
+    }
+
+    void QuerySettings::setScanLimits(const CanonicalQuery& canonicalQuery,
+                                      const ScanLimits& limits) {
+        const LiteParsedQuery& lpq = canonicalQuery.getParsed();
+        const BSONObj& query = lpq.getFilter();
+        const BSONObj& sort = lpq.getSort();
+        const BSONObj& projection = lpq.getProj();
+        ScanLimitsEntry* entry = new ScanLimitsEntry(query, sort, projection, limits);
+
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        ScanLimitsEntryMap::iterator i = _scanLimitsEntryMap.find(key);
+        // Replace existing entry.
+        if (i != _scanLimitsEntryMap.end()) {
+            ScanLimitsEntry* entry = i->second;
+            delete entry;
+        }
+        _scanLimitsEntryMap[key] = entry;
+    }
+
+    void QuerySettings::removeScanLimits(const CanonicalQuery& canonicalQuery) {
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        ScanLimitsEntryMap::iterator i = _scanLimitsEntryMap.find(key);
+
+        // Nothing to do if key does not exist in query settings.
+        if (i == _scanLimitsEntryMap.end()) {
+            return;
+        }
+
+        // Free up resources and delete entry.
+        ScanLimitsEntry* entry = i->second;
+        _scanLimitsEntryMap.erase(i);
+        delete entry;
+    }
+
+    void QuerySettings::clearScanLimits() {
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        for (ScanLimitsEntryMap::const_iterator i = _scanLimitsEntryMap.begin(); i != _scanLimitsEntryMap.end(); ++i) {
+            ScanLimitsEntry* entry = i->second;
+            delete entry;
+        }
+        _scanLimitsEntryMap.clear();
     }
 
     void QuerySettings::_clear() {
@@ -161,6 +264,12 @@ namespace mongo {
             delete entry;
         }
         _allowedIndexEntryMap.clear();
+
+        for (ScanLimitsEntryMap::const_iterator i = _scanLimitsEntryMap.begin(); i != _scanLimitsEntryMap.end(); ++i) {
+            ScanLimitsEntry* entry = i->second;
+            delete entry;
+        }
+        _scanLimitsEntryMap.clear();
     }
 
 }  // namespace mongo
@@ -84,7 +84,44 @@ namespace mongo {
     };
 
     /**
-     * Holds the index filters in a collection.
+     * Limits on the resources a single execution of a query shape may consume.
+     * A value that is zero or negative means no limit on that resource.
+     * Enforced by PlanExecutor, which kills the plan once a limit is exceeded,
+     * so a bad query's damage is bounded by pages touched rather than time.
+     */
+    struct ScanLimits {
+        ScanLimits() : maxDocsExamined(0), maxKeysExamined(0) { }
+
+        long long maxDocsExamined;
+        long long maxKeysExamined;
+    };
+
+    /**
+     * Value type for stored scan limits.
+     * Holds:
+     *     query shape (query, sort, projection)
+     *     limits for the shape
+     */
+    class ScanLimitsEntry {
+    private:
+        MONGO_DISALLOW_COPYING(ScanLimitsEntry);
+    public:
+        ScanLimitsEntry(const BSONObj& query, const BSONObj& sort,
+                        const BSONObj& projection,
+                        const ScanLimits& limits);
+        ScanLimitsEntry* clone() const;
+
+        // query, sort and projection collectively
+        // represent the query shape that we are storing limits for.
+        BSONObj query;
+        BSONObj sort;
+        BSONObj projection;
+
+        ScanLimits limits;
+    };
+
+    /**
+     * Holds the index filters and scan limits in a collection.
      */
     class QuerySettings {
     private:
@@ -127,6 +164,33 @@ namespace mongo {
          */
         void clearAllowedIndices();
 
+        /**
+         * Returns true and fills out limitsOut if scan limits are set in the query settings
+         * for the query. Returns false and leaves limitsOut untouched otherwise.
+         */
+        bool getScanLimits(const CanonicalQuery& query, ScanLimits* limitsOut) const;
+
+        /**
+         * Returns copies of all scan limit entries for the collection.
+         * Caller owns entries in vector.
+         */
+        std::vector<ScanLimitsEntry*> getAllScanLimits() const;
+
+        /**
+         * Adds or replaces scan limits for a query shape.
+         */
+        void setScanLimits(const CanonicalQuery& canonicalQuery, const ScanLimits& limits);
+
+        /**
+         * Removes scan limits for a single query shape. No effect if shape is not found.
+         */
+        void removeScanLimits(const CanonicalQuery& canonicalQuery);
+
+        /**
+         * Clears all scan limits from query settings.
+         */
+        void clearScanLimits();
+
     private:
         /**
          * Clears entries without acquiring mutex.
@@ -136,6 +200,9 @@ namespace mongo {
         typedef unordered_map<PlanCacheKey, AllowedIndexEntry*> AllowedIndexEntryMap;
         AllowedIndexEntryMap _allowedIndexEntryMap;
 
+        typedef unordered_map<PlanCacheKey, ScanLimitsEntry*> ScanLimitsEntryMap;
+        ScanLimitsEntryMap _scanLimitsEntryMap;
+
         /**
          * Protects data in query settings.
          */
@@ -87,6 +87,7 @@ namespace mongo {
         copy->indexKeyPattern = this->indexKeyPattern;
         copy->query = this->query;
         copy->language = this->language;
+        copy->topK = this->topK;
         copy->indexPrefix = this->indexPrefix;
 
         return copy;
@@ -356,7 +357,7 @@ namespace mongo {
     // FetchNode
     //
 
-    FetchNode::FetchNode() { }
+    FetchNode::FetchNode() : reorderDocs(false) { }
 
     void FetchNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -368,6 +369,10 @@ namespace mongo {
             filter->debugString(sb, indent + 2);
             *ss << sb.str();
         }
+        if (reorderDocs) {
+            addIndent(ss, indent + 1);
+            *ss << "reorderDocs = 1\n";
+        }
         addCommon(ss, indent);
         addIndent(ss, indent + 1);
         *ss << "Child:" << '\n';
@@ -379,6 +384,7 @@ namespace mongo {
         cloneBaseData(copy);
 
         copy->_sorts = this->_sorts;
+        copy->reorderDocs = this->reorderDocs;
 
         return copy;
     }
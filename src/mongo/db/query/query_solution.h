@@ -215,7 +215,7 @@ namespace mongo {
     };
 
     struct TextNode : public QuerySolutionNode {
-        TextNode() { }
+        TextNode() : topK(0) { }
         virtual ~TextNode() { }
 
         virtual StageType getType() const { return STAGE_TEXT; }
@@ -236,6 +236,10 @@ namespace mongo {
         std::string query;
         std::string language;
 
+        // If nonzero, only the 'topK' best-scoring matches are needed (the query sorts
+        // by text score with a limit), so the stage may terminate scoring early.
+        size_t topK;
+
         // "Prefix" fields of a text index can handle equality predicates.  We group them with the
         // text node while creating the text leaf node and convert them into a BSONObj index prefix
         // when we finish the text leaf node.
@@ -377,6 +381,11 @@ namespace mongo {
         QuerySolutionNode* clone() const;
 
         BSONObjSet _sorts;
+
+        // Set by the planner when our output order doesn't matter (no requested sort, or a
+        // blocking sort above us re-orders everything anyway).  The fetch stage may then
+        // buffer locs and fetch the documents in DiskLoc order for sequential I/O.
+        bool reorderDocs;
     };
 
     struct IndexScanNode : public QuerySolutionNode {
@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/single_solution_runner.h"
 
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
@@ -48,7 +49,16 @@ namespace mongo {
         : _collection( collection ),
           _canonicalQuery(canonicalQuery),
           _solution(soln),
-          _exec(new PlanExecutor(ws, root, collection)) { }
+          _exec(new PlanExecutor(ws, root, collection)) {
+        // Apply any scan limits configured for this query's shape.
+        if (NULL != collection && NULL != _canonicalQuery.get()) {
+            ScanLimits limits;
+            if (collection->infoCache()->getQuerySettings()->getScanLimits(*_canonicalQuery,
+                                                                           &limits)) {
+                _exec->setScanLimits(limits.maxDocsExamined, limits.maxKeysExamined);
+            }
+        }
+    }
 
     SingleSolutionRunner::~SingleSolutionRunner() { }
 
@@ -95,7 +95,8 @@ namespace mongo {
             const FetchNode* fn = static_cast<const FetchNode*>(root);
             PlanStage* childStage = buildStages(collection, qsol, fn->children[0], ws);
             if (NULL == childStage) { return NULL; }
-            return new FetchStage(ws, childStage, fn->filter.get(), collection);
+            return new FetchStage(ws, childStage, fn->filter.get(), collection,
+                                  fn->reorderDocs);
         }
         else if (STAGE_SORT == root->getType()) {
             const SortNode* sn = static_cast<const SortNode*>(root);
@@ -234,6 +235,7 @@ namespace mongo {
             params.index = index;
             params.spec = fam->getSpec();
             params.indexPrefix = node->indexPrefix;
+            params.topK = node->topK;
 
             const std::string& language = ("" == node->language
                                            ? fam->getSpec().defaultLanguage().str()
@@ -45,6 +45,16 @@ namespace repl {
     int SleepToAllowBatchingMillis = 2;
     const int BatchIsSmallish = 40000; // bytes
 
+    // Throughput-based sync source re-evaluation.  The fetch rate is folded into a
+    // per-source EWMA once per sample's worth of bytes; a source is abandoned (and
+    // vetoed for a while) when its link demonstrably cannot carry the write rate.
+    const int ThroughputSampleBytes = 1024 * 1024;
+    const double ThroughputSmoothingFactor = 0.3;
+    const int ThroughputMaxAgeSecs = 600; // sync source selection ignores older samples
+    const int LagCheckIntervalSecs = 30;
+    const int MinGrowingLagSecs = 10;     // below this, lag growth is just jitter
+    const int DegradedSourceVetoSecs = 120;
+
     MONGO_FP_DECLARE(rsBgSyncProduce);
 
     BackgroundSync* BackgroundSync::s_instance = 0;
@@ -91,7 +101,10 @@ namespace repl {
                                        _pause(true),
                                        _appliedBuffer(true),
                                        _assumingPrimary(false),
-                                       _currentSyncTarget(NULL) {
+                                       _currentSyncTarget(NULL),
+                                       _throughputAccumBytes(0),
+                                       _lastLagCheck(0),
+                                       _lastLagSecs(0) {
     }
 
     BackgroundSync* BackgroundSync::get() {
@@ -214,6 +227,15 @@ namespace repl {
         }
 
         while (!inShutdown()) {
+            if (r.moreInCurrentBatch() && r.currentBatchMessageSize() >= BatchIsSmallish) {
+                // sustained catch-up traffic: keep the next getMore in flight while
+                // we drain this batch, so the sync source round trip is hidden
+                // instead of stalling the buffer once per batch.  small batches
+                // mean we're caught up; they skip this so the batching heuristic
+                // below still applies.  idempotent per batch (prefetchInFlight).
+                r.prefetchNextBatch();
+            }
+
             if (!r.moreInCurrentBatch()) {
                 // Check some things periodically
                 // (whenever we run out of items in the
@@ -250,12 +272,13 @@ namespace repl {
                 {
                     //record time for each getmore
                     TimerHolder batchTimer(&getmoreReplStats);
-                    
+
                     // This calls receiveMore() on the oplogreader cursor.
                     // It can wait up to five seconds for more data.
                     r.more();
                 }
                 networkByteStats.increment(r.currentBatchMessageSize());
+                noteFetchedBytes(r.currentBatchMessageSize());
 
                 if (!r.moreInCurrentBatch()) {
                     // If there is still no data from upstream, check a few more things
@@ -308,16 +331,114 @@ namespace repl {
     }
 
     bool BackgroundSync::shouldChangeSyncTarget() {
-        boost::unique_lock<boost::mutex> lock(_mutex);
+        string degradedSource;
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+
+            // is it even still around?
+            if (!_currentSyncTarget || !_currentSyncTarget->hbinfo().hbstate.readable()) {
+                return true;
+            }
+
+            // check other members: is any member's optime more than 30 seconds ahead of the guy
+            // we're syncing from?
+            if (theReplSet->shouldChangeSyncTarget(_currentSyncTarget->hbinfo().opTime)) {
+                return true;
+            }
 
-        // is it even still around?
-        if (!_currentSyncTarget || !_currentSyncTarget->hbinfo().hbstate.readable()) {
+            // Catch a thin link before our source hits the hard lag cutoff above: if our
+            // fetch point keeps falling further behind the freshest member while the
+            // applier still has buffer headroom, fetching -- not applying -- is the
+            // bottleneck, so the link to this source cannot carry the write rate.
+            time_t now = time(0);
+            if (now - _lastLagCheck >= LagCheckIntervalSecs) {
+                int lagSecs = 0;
+                OpTime freshest = theReplSet->freshestSyncableOpTime();
+                if (_lastOpTimeFetched < freshest) {
+                    lagSecs = freshest.getSecs() - _lastOpTimeFetched.getSecs();
+                }
+
+                bool applierHasHeadroom =
+                    _buffer.size() < static_cast<size_t>(bufferMaxSizeGauge) / 2;
+                if (_lastLagCheck != 0 &&
+                    applierHasHeadroom &&
+                    lagSecs >= MinGrowingLagSecs &&
+                    lagSecs > _lastLagSecs) {
+                    degradedSource = _currentSyncTarget->fullName();
+                    log() << "replSet sync source " << degradedSource << " can't keep up: we are "
+                          << lagSecs << " seconds behind it and falling despite applier headroom"
+                          << " (measured "
+                          << (long long)_sourceThroughput[degradedSource].ewmaBytesPerSec
+                          << " bytes/sec from it); re-evaluating sync source" << rsLog;
+                    _lastLagSecs = 0;
+                }
+                else {
+                    _lastLagSecs = lagSecs;
+                }
+                _lastLagCheck = now;
+            }
+        }
+
+        if (!degradedSource.empty()) {
+            // steer getMemberToSyncTo() away from the thin link for a while.  veto()
+            // takes the rs lock, which must be acquired before our _mutex, so this
+            // happens after the block above.
+            theReplSet->veto(degradedSource, DegradedSourceVetoSecs);
             return true;
         }
 
-        // check other members: is any member's optime more than 30 seconds ahead of the guy we're
-        // syncing from?
-        return theReplSet->shouldChangeSyncTarget(_currentSyncTarget->hbinfo().opTime);
+        return false;
+    }
+
+    void BackgroundSync::noteFetchedBytes(int bytes) {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+
+        if (bytes < BatchIsSmallish) {
+            // caught up: the fetch rate is bounded by the upstream write rate, not the
+            // link, and would drag the measurement down.  start the next sample over.
+            _throughputAccumBytes = 0;
+            return;
+        }
+
+        if (_throughputAccumBytes == 0) {
+            _throughputTimer.reset();
+        }
+        _throughputAccumBytes += bytes;
+        if (_throughputAccumBytes < ThroughputSampleBytes) {
+            return;
+        }
+
+        long long micros = _throughputTimer.micros();
+        if (micros <= 0 || !_currentSyncTarget) {
+            _throughputAccumBytes = 0;
+            return;
+        }
+
+        double bytesPerSec = _throughputAccumBytes * 1000000.0 / micros;
+        SourceThroughput& t = _sourceThroughput[_currentSyncTarget->fullName()];
+        if (t.ewmaBytesPerSec == 0) {
+            t.ewmaBytesPerSec = bytesPerSec;
+        }
+        else {
+            t.ewmaBytesPerSec += ThroughputSmoothingFactor * (bytesPerSec - t.ewmaBytesPerSec);
+        }
+        t.lastSample = time(0);
+        _throughputAccumBytes = 0;
+
+        LOG(2) << "replSet fetched " << ThroughputSampleBytes << " oplog bytes from "
+               << _currentSyncTarget->fullName() << " at " << (long long)bytesPerSec
+               << " bytes/sec, ewma now " << (long long)t.ewmaBytesPerSec << rsLog;
+    }
+
+    double BackgroundSync::getSyncSourceThroughput(const std::string& host) {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+
+        map<string, SourceThroughput>::const_iterator it = _sourceThroughput.find(host);
+        if (it == _sourceThroughput.end() ||
+            it->second.lastSample + ThroughputMaxAgeSecs < time(0)) {
+            return 0;
+        }
+        return it->second.ewmaBytesPerSec;
     }
 
 
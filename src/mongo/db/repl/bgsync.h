@@ -31,6 +31,7 @@
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/util/queue.h"
+#include "mongo/util/timer.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/jsobj.h"
@@ -91,6 +92,23 @@ namespace repl {
 
         const Member* _currentSyncTarget;
 
+        // Measured oplog-fetch throughput for each source we have synced from,
+        // as an EWMA of the effective transfer rate in bytes/sec.
+        struct SourceThroughput {
+            SourceThroughput() : ewmaBytesPerSec(0), lastSample(0) {}
+            double ewmaBytesPerSec;
+            time_t lastSample;
+        };
+        std::map<std::string, SourceThroughput> _sourceThroughput;
+        // Bytes fetched since _throughputTimer was reset.  Only accumulated while
+        // batches are large (sustained catch-up), where the fetch rate reflects the
+        // link rather than the trickle of new upstream writes.
+        long long _throughputAccumBytes;
+        Timer _throughputTimer;
+        // Fetch lag observed at the last throughput re-evaluation.
+        time_t _lastLagCheck;
+        int _lastLagSecs;
+
         BackgroundSync();
         BackgroundSync(const BackgroundSync& s);
         BackgroundSync operator=(const BackgroundSync& s);
@@ -104,6 +122,8 @@ namespace repl {
         void getOplogReader(OplogReader& r);
         // Evaluate if the current sync target is still good
         bool shouldChangeSyncTarget();
+        // Fold a fetched batch into the current sync source's throughput EWMA
+        void noteFetchedBytes(int bytes);
         // check lastOpTimeWritten against the remote's earliest op, filling in remoteOldestOp.
         bool isStale(OplogReader& r, BSONObj& remoteOldestOp);
         // stop syncing when this becomes a primary
@@ -135,6 +155,11 @@ namespace repl {
         // For monitoring
         BSONObj getCounters();
 
+        // Measured oplog-fetch throughput for 'host' in bytes/sec, or 0 if we have
+        // no recent measurement.  Used by ReplSetImpl::getMemberToSyncTo to prefer
+        // sources on fatter links.
+        double getSyncSourceThroughput(const std::string& host);
+
         // Wait for replication to finish and buffer to be applied so that the member can become
         // primary.
         void stopReplicationAndFlushBuffer();
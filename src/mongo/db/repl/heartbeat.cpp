@@ -34,6 +34,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/connections.h"
+#include "mongo/db/repl/heartbeat.h"
 #include "mongo/db/repl/heartbeat_info.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/repl/repl_set_health_poll_task.h"
@@ -41,10 +42,13 @@
 #include "mongo/db/repl/replset_commands.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/server.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/task.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/goodies.h"
+#include "mongo/util/net/hostandport.h"
 #include "mongo/util/ramlog.h"
 
 namespace mongo {
@@ -54,6 +58,26 @@ namespace repl {
 
     using namespace bson;
 
+    /**
+     * Port for the dedicated health channel listener; 0 (the default) disables it.
+     * Heartbeats share the data port with client traffic, so when the server is
+     * saturated or out of connection tickets they time out and trigger spurious
+     * elections.  Setting this (to the same value on every member) gives cluster
+     * health sensing its own listener and connection budget.
+     */
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replHealthPort, int, 0);
+
+    // Heartbeat traffic is a handful of connections per peer; a small dedicated pool
+    // is plenty and bounds the threads the health channel can consume.
+    TicketHolder healthChannelTicketHolder(128);
+
+    std::string healthChannelTarget(const std::string& memberFullName) {
+        if (0 == replHealthPort) {
+            return memberFullName;
+        }
+        return HostAndPort(HostAndPort(memberFullName).host(), replHealthPort).toString();
+    }
+
     /* { replSetHeartbeat : <setname> } */
     class CmdReplSetHeartbeat : public ReplSetCommand {
     public:
@@ -140,8 +164,24 @@ namespace repl {
             cmdBuilder.append("fromId", me);
         }
 
+        const BSONObj cmd = cmdBuilder.done();
+
+        const std::string healthTarget = healthChannelTarget(memberFullName);
+        if (healthTarget != memberFullName) {
+            try {
+                ScopedConn conn(healthTarget);
+                return conn.runCommand("admin", cmd, result, 0);
+            }
+            catch (const DBException& e) {
+                // The peer may not have its health channel up yet (rolling restart
+                // while the parameter is being deployed); fall back to the data port.
+                LOG(1) << "replSet health channel " << healthTarget << " unavailable: "
+                       << e.what() << ", falling back to " << memberFullName << rsLog;
+            }
+        }
+
         ScopedConn conn(memberFullName);
-        return conn.runCommand("admin", cmdBuilder.done(), result, 0);
+        return conn.runCommand("admin", cmd, result, 0);
     }
 
     void ReplSetImpl::endOldHealthTasks() {
@@ -32,9 +32,29 @@
 
 namespace mongo {
     class BSONObj;
+    class TicketHolder;
 
 namespace repl {
 
+    /**
+     * When nonzero, every member of the set also listens on this port and heartbeats
+     * are sent to it instead of the data port.  The health channel has its own small
+     * connection budget, so heartbeats keep flowing when the data port is saturated
+     * or out of connection tickets.  Must be set to the same value on all members.
+     * Startup parameter: replHealthPort.
+     */
+    extern int replHealthPort;
+
+    /** Connection tickets for the health channel listener. */
+    extern TicketHolder healthChannelTicketHolder;
+
+    /**
+     * Returns the host:port heartbeats should dial for the member at 'memberFullName':
+     * the member's host paired with replHealthPort when the health channel is
+     * configured, 'memberFullName' unchanged otherwise.
+     */
+    std::string healthChannelTarget(const std::string& memberFullName);
+
     /* throws */
     bool requestHeartbeat(const std::string& setname,
                           const std::string& fromHost,
@@ -33,11 +33,26 @@
 #include "mongo/client/connpool.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/lockstate.h"
+#include "mongo/db/repl/heartbeat.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
 namespace repl {
 
+namespace {
+
+    StatusWith<BSONObj> runCommandOnHost(
+            const std::string& target,
+            const ReplicationExecutor::RemoteCommandRequest& request) {
+        BSONObj output;
+        ScopedDbConnection conn(target);
+        conn->runCommand(request.dbname, request.cmdObj, output);
+        conn.done();
+        return StatusWith<BSONObj>(output);
+    }
+
+}  // namespace
+
     NetworkInterfaceImpl::NetworkInterfaceImpl() {}
     NetworkInterfaceImpl::~NetworkInterfaceImpl() {}
 
@@ -48,12 +63,26 @@ namespace repl {
     StatusWith<BSONObj> NetworkInterfaceImpl::runCommand(
             const ReplicationExecutor::RemoteCommandRequest& request) {
 
+        const std::string target = request.target.toString();
+
+        // Heartbeats go over the dedicated health channel when one is configured, so
+        // cluster health sensing doesn't queue behind data traffic; see replHealthPort.
+        const bool isHeartbeat =
+            mongoutils::str::equals(request.cmdObj.firstElementFieldName(), "replSetHeartbeat");
+        const std::string healthTarget =
+            isHeartbeat ? healthChannelTarget(target) : target;
+
         try {
-            BSONObj output;
-            ScopedDbConnection conn(request.target.toString());
-            conn->runCommand(request.dbname, request.cmdObj, output);
-            conn.done();
-            return StatusWith<BSONObj>(output);
+            if (healthTarget != target) {
+                try {
+                    return runCommandOnHost(healthTarget, request);
+                }
+                catch (const DBException&) {
+                    // Peer's health channel isn't up (e.g. rolling deploy of the
+                    // parameter); fall back to the data port.
+                }
+            }
+            return runCommandOnHost(target, request);
         }
         catch (const DBException& ex) {
             return StatusWith<BSONObj>(ex.toStatus());
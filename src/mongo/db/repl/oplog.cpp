@@ -34,6 +34,7 @@
 
 #include <vector>
 
+#include "mongo/bson/bson_literal_builder.h"
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
@@ -267,17 +268,18 @@ namespace repl {
 
         logopbufbuilder.reset();
         BSONObjBuilder b(logopbufbuilder);
-        b.appendTimestamp("ts", ts.asDate());
-        b.append("h", hashNew);
-        b.append("v", OPLOG_VERSION);
-        b.append("op", opstr);
-        b.append("ns", ns);
-        if (fromMigrate) 
-            b.appendBool("fromMigrate", true);
+        BSONLiteralBuilder fast(b); // field names below are literals; skip the strlens
+        fast.appendTimestamp("ts", ts.asDate());
+        fast.append("h", hashNew);
+        fast.append("v", OPLOG_VERSION);
+        fast.append("op", StringData(opstr));
+        fast.append("ns", StringData(ns));
+        if (fromMigrate)
+            fast.appendBool("fromMigrate", true);
         if ( bb )
-            b.appendBool("b", *bb);
+            fast.appendBool("b", *bb);
         if ( o2 )
-            b.append("o2", *o2);
+            fast.append("o2", *o2);
         BSONObj partial = b.done();
 
         DEV verify( logNS == 0 ); // check this was never a master/slave master
@@ -316,6 +318,88 @@ namespace repl {
 
     }
 
+    /**
+     * Vectored version of _logOpRS.  Takes the "local" lock and the optime
+     * mutex once for the whole batch, then writes one entry per object with
+     * consecutive timestamps, updating lastOpTimeWritten/lastH a single time
+     * at the end.  The entries still go through the record store one at a
+     * time (there is no multi-record reservation in the collection API), but
+     * the per-op locking, hashing setup and builder allocation are amortized.
+     */
+    static void _logOpsRS(OperationContext* txn,
+                          const char *opstr,
+                          const char *ns,
+                          const std::vector<BSONObj>& objs,
+                          bool fromMigrate ) {
+        Lock::DBWrite lk1(txn->lockState(), "local");
+
+        if ( strncmp(ns, "local.", 6) == 0 ) {
+            if ( strncmp(ns, "local.slaves", 12) == 0 )
+                resetSlaveCache();
+            return;
+        }
+
+        mutex::scoped_lock lk2(newOpMutex);
+
+        if ( theReplSet && !theReplSet->box.getState().primary() ) {
+            log() << "replSet error : logOp() but not primary";
+            fassertFailed(18522);
+        }
+
+        if ( localOplogRSCollection == 0 ) {
+            Client::Context ctx(rsoplog);
+            localDB = ctx.db();
+            verify( localDB );
+            localOplogRSCollection = localDB->getCollection( txn, rsoplog );
+            massert(18523, "local.oplog.rs missing. did you drop it? if so restart server", localOplogRSCollection);
+        }
+
+        Client::Context ctx(rsoplog, localDB);
+
+        OpTime ts;
+        long long hashNew = theReplSet ? theReplSet->lastH : 0;
+
+        for (size_t i = 0; i < objs.size(); i++) {
+            ts = getNextGlobalOptime();
+            if ( theReplSet )
+                hashNew = (hashNew * 131 + ts.asLL()) * 17 + theReplSet->selfId();
+
+            logopbufbuilder.reset();
+            BSONObjBuilder b(logopbufbuilder);
+            BSONLiteralBuilder fast(b);
+            fast.appendTimestamp("ts", ts.asDate());
+            fast.append("h", hashNew);
+            fast.append("v", OPLOG_VERSION);
+            fast.append("op", StringData(opstr));
+            fast.append("ns", StringData(ns));
+            if (fromMigrate)
+                fast.appendBool("fromMigrate", true);
+            BSONObj partial = b.done();
+
+            OplogDocWriter writer( partial, objs[i] );
+            checkOplogInsert( localOplogRSCollection->insertDocument( txn, &writer, false ) );
+        }
+
+        newOptimeNotifier.notify_all();
+
+        if( theReplSet ) {
+            if( !(theReplSet->lastOpTimeWritten<ts) ) {
+                log() << "replication oplog stream went back in time. previous timestamp: "
+                      << theReplSet->lastOpTimeWritten << " newest timestamp: " << ts
+                      << ". attempting to sync directly from primary." << endl;
+                BSONObjBuilder result;
+                Status status = theReplSet->forceSyncFrom(theReplSet->box.getPrimary()->fullName(),
+                                                          &result);
+                if (!status.isOK()) {
+                    log() << "Can't sync from primary: " << status;
+                }
+            }
+            theReplSet->lastOpTimeWritten = ts;
+            theReplSet->lastH = hashNew;
+            ctx.getClient()->setLastOp( ts );
+        }
+    }
+
     static void _logOpOld(OperationContext* txn,
                           const char *opstr,
                           const char *ns,
@@ -345,15 +429,16 @@ namespace repl {
 
         bufbuilder.reset();
         BSONObjBuilder b(bufbuilder);
-        b.appendTimestamp("ts", ts.asDate());
-        b.append("op", opstr);
-        b.append("ns", ns);
-        if (fromMigrate) 
-            b.appendBool("fromMigrate", true);
+        BSONLiteralBuilder fast(b);
+        fast.appendTimestamp("ts", ts.asDate());
+        fast.append("op", StringData(opstr));
+        fast.append("ns", StringData(ns));
+        if (fromMigrate)
+            fast.appendBool("fromMigrate", true);
         if ( bb )
-            b.appendBool("b", *bb);
+            fast.appendBool("b", *bb);
         if ( o2 )
-            b.append("o2", *o2);
+            fast.append("o2", *o2);
         BSONObj partial = b.done(); // partial is everything except the o:... part.
 
         if( logNS == 0 ) {
@@ -444,6 +529,52 @@ namespace repl {
         }
     }
 
+    void logOps(OperationContext* txn,
+                const char* opstr,
+                const char* ns,
+                const std::vector<BSONObj>& objs,
+                bool fromMigrate) {
+        if (objs.empty())
+            return;
+
+        try {
+            if ( replSettings.master ) {
+                if ( _logOp == _logOpRS ) {
+                    _logOpsRS(txn, opstr, ns, objs, fromMigrate);
+                }
+                else {
+                    // master/slave and uninitialized replsets have no vectored
+                    // path; fall back to one entry at a time
+                    for (size_t i = 0; i < objs.size(); i++) {
+                        _logOp(txn, opstr, ns, 0, objs[i], 0, 0, fromMigrate);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < objs.size(); i++) {
+                logOpForSharding(txn, opstr, ns, objs[i], NULL, fromMigrate);
+                getGlobalAuthorizationManager()->logOp(opstr, ns, objs[i], NULL, NULL);
+            }
+            logOpForDbHash(ns);
+
+            if ( strstr( ns, ".system.js" ) ) {
+                Scope::storedFuncMod(); // this is terrible
+            }
+        }
+        catch (const DBException& ex) {
+            severe() << "Fatal DBException in logOps(): " << ex.toString();
+            std::terminate();
+        }
+        catch (const std::exception& ex) {
+            severe() << "Fatal std::exception in logOps(): " << ex.what();
+            std::terminate();
+        }
+        catch (...) {
+            severe() << "Fatal error in logOps()";
+            std::terminate();
+        }
+    }
+
     void createOplog() {
         OperationContextImpl txn;
         Lock::GlobalWrite lk(txn.lockState());
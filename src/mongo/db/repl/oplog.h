@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 namespace mongo {
     class BSONObj;
     class Database;
@@ -77,6 +79,17 @@ namespace repl {
                 bool *b = NULL,
                 bool fromMigrate = false);
 
+    /** Vectored form of logOp() for callers that apply a whole batch of
+        operations under one lock hold (e.g. bulk inserts).  Writes one entry
+        per object with consecutive timestamps, taking the oplog locks and
+        optime mutex once for the batch instead of once per document.
+    */
+    void logOps( OperationContext* txn,
+                 const char *opstr,
+                 const char *ns,
+                 const std::vector<BSONObj>& objs,
+                 bool fromMigrate = false);
+
     // Log an empty no-op operation to the local oplog
     void logKeepalive(OperationContext* txn);
 
@@ -41,6 +41,7 @@
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/rs.h"  // theReplSet
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -93,6 +94,10 @@ namespace repl {
         readersCreatedStats.increment();
     }
 
+    // compress oplog traffic from the sync source; entries are repetitive BSON and
+    // typically shrink several fold, which matters on metered cross-DC links
+    MONGO_EXPORT_SERVER_PARAMETER( replNetworkCompression, bool, false );
+
     bool OplogReader::commonConnect(const string& hostName) {
         if( conn() == 0 ) {
             _conn = shared_ptr<DBClientConnection>(new DBClientConnection(false,
@@ -107,6 +112,11 @@ namespace repl {
                 log() << "repl: " << errmsg << endl;
                 return false;
             }
+
+            if ( replNetworkCompression && !_conn->negotiateNetworkCompression() ) {
+                // older sync source; carry on uncompressed
+                LOG(1) << "repl: " << hostName << " does not support networkCompress" << endl;
+            }
         }
         return true;
     }
@@ -137,6 +137,14 @@ namespace repl {
             return cursor->moreInCurrentBatch();
         }
 
+        /** pipeline the next getMore so the next batch is in flight while the
+            current one is consumed; hides the sync source round trip during
+            sustained tailing.  no-op if one is already outstanding. */
+        void prefetchNextBatch() {
+            if( cursor.get() && cursor->getCursorId() && !cursor->prefetchInFlight() )
+                cursor->prefetchMore();
+        }
+
         int currentBatchMessageSize() {
             if( NULL == cursor->getMessage() )
                 return 0;
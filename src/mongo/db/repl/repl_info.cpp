@@ -185,7 +185,17 @@ namespace repl {
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out) {} // No auth required
-        CmdIsMaster() : Command("isMaster", true, "ismaster") { }
+        CmdIsMaster() : Command("isMaster", true, "ismaster") {
+            // These fields never change for the life of the process.  Every new connection
+            // asks isMaster, so build them once instead of on each handshake.
+            BSONObjBuilder b;
+            b.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
+            b.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
+            b.appendNumber("maxWriteBatchSize", BatchedCommandRequest::kMaxWriteBatchSize);
+            b.append("maxWireVersion", maxWireVersion);
+            b.append("minWireVersion", minWireVersion);
+            _constants = b.obj();
+        }
         virtual bool run(OperationContext* txn, const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool /*fromRepl*/) {
             /* currently request to arbiter is (somewhat arbitrarily) an ismaster request that is not
                authenticated.
@@ -195,14 +205,12 @@ namespace repl {
 
             appendReplicationInfo(txn, result, 0);
 
-            result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
-            result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
-            result.appendNumber("maxWriteBatchSize", BatchedCommandRequest::kMaxWriteBatchSize);
+            result.appendElements(_constants);
             result.appendDate("localTime", jsTime());
-            result.append("maxWireVersion", maxWireVersion);
-            result.append("minWireVersion", minWireVersion);
             return true;
         }
+    private:
+        BSONObj _constants;
     } cmdismaster;
 
     OpCounterServerStatusSection replOpCounterServerStatusSection( "opcountersRepl", &replOpCounters );
@@ -318,8 +318,29 @@ namespace {
 
     void ReplSetImpl::_fillIsMaster(BSONObjBuilder& b) {
         lock lk(this);
-        
+
         const StateBox::SP sp = box.get();
+        const string primary = sp.primary ? sp.primary->fullName() : "";
+
+        // Nothing below depends on anything but the config, our state and the primary;
+        // serve the cached copy when none of those have changed.
+        if (version() == _isMasterCacheVersion &&
+            sp.state.s == _isMasterCacheState &&
+            primary == _isMasterCachePrimary) {
+            b.appendElements(_isMasterCache);
+            return;
+        }
+
+        BSONObjBuilder cached;
+        _buildIsMaster(cached, sp);
+        _isMasterCache = cached.obj();
+        _isMasterCacheVersion = version();
+        _isMasterCacheState = sp.state.s;
+        _isMasterCachePrimary = primary;
+        b.appendElements(_isMasterCache);
+    }
+
+    void ReplSetImpl::_buildIsMaster(BSONObjBuilder& b, const StateBox::SP& sp) {
         bool isp = sp.state.primary();
         b.append("setName", name());
         b.append("setVersion", version());
@@ -432,6 +453,8 @@ namespace {
         _blockSync(false),
         _hbmsgTime(0),
         _self(0),
+        _isMasterCacheVersion(-1),
+        _isMasterCacheState(-1),
         _maintenanceMode(0),
         mgr(0),
         _writerPool(replWriterThreadCount),
@@ -106,8 +106,14 @@ namespace repl {
         // that prevents the sync source from changing.
         bool shouldChangeSyncTarget(const OpTime& target) const;
 
+        // Latest optime among the members we could sync from; used by bgsync to
+        // measure how far its fetching has fallen behind.
+        OpTime freshestSyncableOpTime() const;
+
         /**
-         * Find the closest member (using ping time) with a higher latest optime.
+         * Find the best member with a higher latest optime: by measured oplog-fetch
+         * throughput where we have recent measurements for both candidates, by ping
+         * time otherwise.
          */
         const Member* getMemberToSyncTo();
         void veto(const string& host, unsigned secs=10);
@@ -201,7 +207,16 @@ namespace repl {
          */
         bool initFromConfig(ReplSetConfig& c, bool reconf=false); 
         void _fillIsMaster(BSONObjBuilder&);
+        void _buildIsMaster(BSONObjBuilder&, const StateBox::SP&);
         void _fillIsMasterHost(const Member*, vector<string>&, vector<string>&, vector<string>&);
+
+        /* cached _fillIsMaster reply.  the reply only changes on reconfig, on a state
+           change, or when the primary changes, and connection setup is hot -- every new
+           connection asks isMaster.  protected by the ReplSetImpl lock. */
+        BSONObj _isMasterCache;
+        int _isMasterCacheVersion;
+        int _isMasterCacheState;
+        string _isMasterCachePrimary;
         const ReplSetConfig& config() { return *_cfg; }
         string name() const { return _name; } /* @return replica set's logical name */
         int version() const { return _cfg->version; } /* @return replica set's config version */
@@ -42,10 +42,20 @@ namespace {
     stdx::function<void ()> makeNoExcept(const stdx::function<void ()> &fn);
 }  // namespace
 
+namespace {
+    // Workers in this pool block synchronously on the network for the duration of
+    // a remote command, so the pool must be deep enough for a heartbeat to every
+    // peer of the largest replica set (12 members) to be in flight at once, plus
+    // headroom for global-exclusive-lock operations.  An undersized pool queues
+    // heartbeats behind each other, which reads as scheduling jitter upstream.
+    const int kNetworkWorkerCount = 16;
+}  // namespace
+
     ReplicationExecutor::ReplicationExecutor(NetworkInterface* netInterface) :
         _networkInterface(netInterface),
         _totalEventWaiters(0),
-        _inShutdown(false) {
+        _inShutdown(false),
+        _networkWorkers(kNetworkWorkerCount) {
     }
 
     ReplicationExecutor::~ReplicationExecutor() {}
@@ -296,9 +306,18 @@ namespace {
         if (!cbHandle.isOK())
             return cbHandle;
         cbHandle.getValue()._iter->readyDate = when;
-        WorkQueue::iterator insertBefore = _sleepersQueue.begin();
-        while (insertBefore != _sleepersQueue.end() && insertBefore->readyDate <= when)
-            ++insertBefore;
+        // Insertion sort from the back: deadlines are nearly always scheduled in
+        // increasing order (periodic work like heartbeats re-arms for now + delay),
+        // so the common case is an O(1) append rather than a scan of every pending
+        // timer from the front.
+        WorkQueue::iterator insertBefore = _sleepersQueue.end();
+        while (insertBefore != _sleepersQueue.begin()) {
+            WorkQueue::iterator prev = insertBefore;
+            --prev;
+            if (prev->readyDate <= when)
+                break;
+            insertBefore = prev;
+        }
         _sleepersQueue.splice(insertBefore, temp, temp.begin());
         return cbHandle;
     }
@@ -384,8 +403,9 @@ namespace {
         while ((iter != _sleepersQueue.end()) && (iter->readyDate <= now)) {
             ++iter;
         }
+        // No notification is needed here: only the run loop consumes _readyQueue,
+        // and it is the sole caller of this method.
         _readyQueue.splice(_readyQueue.end(), _sleepersQueue, _sleepersQueue.begin(), iter);
-        _workAvailable.notify_all();
         if (iter == _sleepersQueue.end()) {
             //return milliseconds::max();
             return Milliseconds(std::numeric_limits<boost::int64_t>::max());
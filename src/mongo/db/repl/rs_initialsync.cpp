@@ -45,6 +45,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/repl_settings.h"  // replSettings
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -55,6 +56,10 @@ namespace repl {
 
     // add try/catch with sleep
 
+    // Number of collections cloned concurrently (each over its own connection) during the
+    // data pass of initial sync.  1 restores the serial clone.
+    MONGO_EXPORT_SERVER_PARAMETER(replInitialSyncCloneStreams, int, 4);
+
     void isyncassert(const string& msg, bool expr) {
         if( !expr ) {
             string m = str::stream() << "initial sync " << msg;
@@ -112,6 +117,13 @@ namespace repl {
             options.mayBeInterrupted = false;
             options.syncData = dataPass;
             options.syncIndexes = ! dataPass;
+            if ( dataPass ) {
+                // Clone collections on parallel streams, each resuming from the last _id
+                // cloned after a network blip instead of failing the whole sync attempt.
+                options.parallelCollectionStreams =
+                    std::max(1, static_cast<int>(replInitialSyncCloneStreams));
+                options.resumable = true;
+            }
 
             // Make database stable
             Lock::DBWrite dbWrite(txn->lockState(), db);
@@ -144,6 +156,31 @@ namespace repl {
         uassertStatusOK( collection->truncate(&txn) );
     }
 
+    /**
+     * Returns true if 'candidate' looks like a better sync source than 'best'.
+     * When we have recent oplog-fetch throughput measurements for both (we have
+     * synced from them lately), the fatter link wins -- with some slack so that
+     * noisy measurements don't flap the sync chain.  Otherwise fall back to
+     * heartbeat ping: an unmeasured candidate may sit on a fat link we simply
+     * have not tried yet, and a measured-thin one that lagged us is vetoed for
+     * a while anyway.
+     */
+    static bool isBetterSyncCandidate(const Member* candidate, const Member* best) {
+        BackgroundSync* bgsync = BackgroundSync::get();
+        if (bgsync) {
+            const double candidateBps = bgsync->getSyncSourceThroughput(candidate->fullName());
+            const double bestBps = bgsync->getSyncSourceThroughput(best->fullName());
+            if (candidateBps > 0 && bestBps > 0) {
+                if (candidateBps > 1.25 * bestBps)
+                    return true;
+                if (bestBps > 1.25 * candidateBps)
+                    return false;
+                // within noise of each other; decide by ping below
+            }
+        }
+        return candidate->hbinfo().ping <= best->hbinfo().ping;
+    }
+
     const Member* ReplSetImpl::getMemberToSyncTo() {
         lock lk(this);
 
@@ -174,7 +211,7 @@ namespace repl {
             }
         }
 
-        // find the member with the lowest ping time that has more data than me
+        // find the best-scoring member that has more data than me
 
         // Find primary's oplog time. Reject sync candidates that are more than
         // maxSyncSourceLagSecs seconds behind.
@@ -215,9 +252,8 @@ namespace repl {
                         continue;
                 }
 
-                // omit nodes that are more latent than anything we've already considered
-                if (closest &&
-                    (m->hbinfo().ping > closest->hbinfo().ping))
+                // omit nodes that score worse than anything we've already considered
+                if (closest && !isBetterSyncCandidate(m, closest))
                     continue;
 
                 if (attempts == 0 &&
@@ -195,6 +195,16 @@ namespace repl {
         return false;
     }
 
+    OpTime ReplSetImpl::freshestSyncableOpTime() const {
+        OpTime freshest;
+        for (Member *m = _members.head(); m; m = m->next()) {
+            if (m->syncable() && freshest < m->hbinfo().opTime) {
+                freshest = m->hbinfo().opTime;
+            }
+        }
+        return freshest;
+    }
+
     void ReplSetImpl::_syncThread() {
         StateBox::SP sp = box.get();
         if( sp.state.primary() ) {
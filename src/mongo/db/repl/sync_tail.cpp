@@ -36,12 +36,16 @@
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/prefetch.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/platform/unordered_set.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 namespace repl {
@@ -54,11 +58,51 @@ namespace repl {
 
     MONGO_FP_DECLARE(rsSyncApplyStop);
 
+    // When set, fillWriterVectors shards oplog entries to writer threads by
+    // (namespace, _id) instead of namespace alone, so a single hot collection can
+    // apply on all writer threads.  Not suitable when strict insertion order within
+    // a capped collection must be preserved on secondaries.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replWriterShardByDocument, bool, false);
+
+    // Target for how long the applier may block secondary reads per acquisition of the
+    // batch writer lock, in milliseconds.  When > 0, large batches are applied in slices
+    // and the lock is released between slices so queued readers can interleave.  0 keeps
+    // the historical behavior of one lock hold for the whole batch.
+    MONGO_EXPORT_SERVER_PARAMETER(replBatchApplyLockTargetMillis, int, 0);
+
     // Number and time of each ApplyOps worker pool round
     static TimerStats applyBatchStats;
     static ServerStatusMetricField<TimerStats> displayOpBatchesApplied(
                                                     "repl.apply.batches",
                                                     &applyBatchStats );
+
+    // Number and duration of the applier's batch writer lock holds, during which
+    // secondary reads are blocked.  Used to tune replBatchApplyLockTargetMillis.
+    static TimerStats applyLockHoldStats;
+    static ServerStatusMetricField<TimerStats> displayApplyLockHolds(
+                                                    "repl.apply.lockHold",
+                                                    &applyLockHoldStats );
+
+    // Running estimate of how many ops the writer pool applies per millisecond, used to
+    // size slices toward the lock hold target.  Only the single applier thread reads or
+    // writes this, so no synchronization is needed.
+    static double applyOpsPerMillisEstimate = 8.0;
+
+    // Never slice finer than this many ops, no matter how pessimistic the rate estimate
+    // gets; smaller slices waste more time on lock churn than they save readers.
+    static const size_t kMinApplySliceOps = 64;
+
+    // Running estimate of how long one prefetch takes, used to size the groups of ops
+    // handed to each pool task.  When the working set is resident a prefetch is only a
+    // few microseconds of btree walking, so big groups amortize the scheduling and read
+    // lock cost; when we are faulting to disk each op can take milliseconds, so one op
+    // per task keeps all the pool threads issuing I/O in parallel.  Only the single
+    // applier thread reads or writes this, so no synchronization is needed.
+    static double prefetchMicrosPerOpEstimate = 1000.0;
+
+    // Aim each pool task at roughly this much work.
+    static const double kPrefetchTaskTargetMicros = 1000.0;
+    static const size_t kMaxPrefetchOpsPerTask = 64;
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
@@ -140,15 +184,86 @@ namespace repl {
         }
     }
 
+    // The pool threads call this to prefetch a group of ops on one thread, paying the
+    // scheduling overhead once per group instead of once per op
+    void SyncTail::prefetchOpGroup(const std::vector<BSONObj>& ops) {
+        for (std::vector<BSONObj>::const_iterator it = ops.begin();
+             it != ops.end();
+             ++it) {
+            prefetchOp(*it);
+        }
+    }
+
     // Doles out all the work to the reader pool threads and waits for them to complete
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
         threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
+
+        // Ops per pool task, sized so each task lands near the work target at the
+        // measured prefetch rate.
+        size_t opsPerTask = 1;
+        if (prefetchMicrosPerOpEstimate > 0) {
+            opsPerTask = std::max(
+                    std::min(static_cast<size_t>(kPrefetchTaskTargetMicros /
+                                                 prefetchMicrosPerOpEstimate),
+                             kMaxPrefetchOpsPerTask),
+                    static_cast<size_t>(1));
+        }
+
+        // A batch often carries several ops against one document (e.g. a counter being
+        // $inc'd in a tight loop); they fault in the same record and btree pages, so
+        // prefetching the document once is enough.  Dedupe on the raw (ns, _id) bytes --
+        // a miss on a type-mismatched numeric _id just costs a redundant prefetch.
+        unordered_set<std::string> seen;
+
+        // Groups must outlive the tasks; they are freed after the join below.
+        std::vector< std::vector<BSONObj> > groups;
+        groups.push_back(std::vector<BSONObj>());
+        size_t scheduled = 0;
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
-            prefetcherPool.schedule(&prefetchOp, *it);
+            BSONElement idElem;
+            switch (it->getField("op").valuestrsafe()[0]) {
+            case 'i':
+            case 'd':
+                idElem = it->getFieldDotted("o._id");
+                break;
+            case 'u':
+                idElem = it->getFieldDotted("o2._id");
+                break;
+            default:
+                // the prefetcher ignores other ops; don't bother scheduling them
+                continue;
+            }
+            if (!idElem.eoo()) {
+                const BSONElement nsElem = it->getField("ns");
+                std::string key(nsElem.valuestr(), nsElem.valuestrsize());
+                key.append(idElem.value(), idElem.valuesize());
+                if (!seen.insert(key).second)
+                    continue;
+            }
+            if (groups.back().size() >= opsPerTask)
+                groups.push_back(std::vector<BSONObj>());
+            groups.back().push_back(*it);
+            ++scheduled;
+        }
+
+        Timer prefetchTimer;
+        for (size_t i = 0; i < groups.size(); ++i) {
+            if (!groups[i].empty()) {
+                prefetcherPool.schedule(&prefetchOpGroup, boost::cref(groups[i]));
+            }
         }
         prefetcherPool.join();
+
+        if (scheduled > 0) {
+            // Exponentially weighted average of the per-op prefetch cost, for sizing
+            // the next batch's groups.  This tracks the fault rate: it climbs as soon
+            // as the batch falls out of memory and decays once the pages are warm.
+            const double perOp = static_cast<double>(prefetchTimer.micros()) / scheduled;
+            prefetchMicrosPerOpEstimate = 0.7 * prefetchMicrosPerOpEstimate + 0.3 * perOp;
+        }
     }
     
     // Doles out all the work to the writer pool threads and waits for them to complete
@@ -171,23 +286,60 @@ namespace repl {
 
         // Use a ThreadPool to prefetch all the operations in a batch.
         prefetchOps(ops);
-        
-        std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
-        fillWriterVectors(ops, &writerVectors);
+
         LOG(2) << "replication batch size is " << ops.size() << endl;
-        // We must grab this because we're going to grab write locks later.
-        // We hold this mutex the entire time we're writing; it doesn't matter
-        // because all readers are blocked anyway.
-        SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
 
-        // stop all readers until we're done
-        Lock::ParallelBatchWriterMode pbwm;
+        const int lockTargetMillis = replBatchApplyLockTargetMillis;
+
+        size_t applied = 0;
+        while (applied < ops.size()) {
+            size_t sliceSize = ops.size() - applied;
+            if (lockTargetMillis > 0) {
+                // Size the slice from the measured apply rate so each lock hold lands
+                // near the target.  Slices are taken in oplog order, so applying them
+                // one at a time preserves the same per-namespace ordering as applying
+                // the whole batch at once.
+                const size_t target = std::max(
+                        static_cast<size_t>(applyOpsPerMillisEstimate * lockTargetMillis),
+                        kMinApplySliceOps);
+                sliceSize = std::min(sliceSize, target);
+            }
+
+            std::deque<BSONObj> slice(ops.begin() + applied,
+                                      ops.begin() + applied + sliceSize);
+
+            std::vector< std::vector<BSONObj> > writerVectors(
+                    theReplSet->replWriterThreadCount);
+            fillWriterVectors(slice, &writerVectors);
+
+            int holdMillis = 0;
+            {
+                // We must grab this because we're going to grab write locks later.
+                // We hold this mutex the entire time we're writing; it doesn't matter
+                // because all readers are blocked anyway.
+                SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
+
+                // stop all readers until this slice is done
+                Lock::ParallelBatchWriterMode pbwm;
+                TimerHolder holdTimer(&applyLockHoldStats);
+
+                applyOps(writerVectors, applyFunc);
+                holdMillis = holdTimer.millis();
+            }
 
-        applyOps(writerVectors, applyFunc);
+            if (lockTargetMillis > 0 && holdMillis > 0) {
+                // Exponentially weighted average of the apply rate, for sizing the
+                // next slice.
+                const double rate = static_cast<double>(sliceSize) / holdMillis;
+                applyOpsPerMillisEstimate = 0.7 * applyOpsPerMillisEstimate + 0.3 * rate;
+            }
+
+            applied += sliceSize;
+        }
     }
 
 
-    void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
+    void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops,
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
@@ -199,6 +351,29 @@ namespace repl {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            if (replWriterShardByDocument) {
+                // Refine the hash with the document _id so that ops against different
+                // documents of one hot collection spread over the writer pool.  Ops with
+                // equal _ids hash identically, so per-document order is preserved.
+                // Commands and index builds never share a batch with CRUD ops (see
+                // tryPopAndWaitForMore), so only i/u/d entries get here.
+                BSONElement idElem;
+                switch (it->getField("op").valuestrsafe()[0]) {
+                case 'i':
+                case 'd':
+                    idElem = it->getFieldDotted("o._id");
+                    break;
+                case 'u':
+                    idElem = it->getFieldDotted("o2._id");
+                    break;
+                }
+                if (!idElem.eoo()) {
+                    // hash64 canonicalizes numeric types, like the _id index does
+                    const long long idHash = BSONElementHasher::hash64(idElem, hash);
+                    hash = static_cast<uint32_t>(idHash) ^ static_cast<uint32_t>(idHash >> 32);
+                }
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
@@ -128,6 +128,8 @@ namespace repl {
         void prefetchOps(const std::deque<BSONObj>& ops);
         // Used by the thread pool readers to prefetch an op
         static void prefetchOp(const BSONObj& op);
+        // Used by the thread pool readers to prefetch a group of ops on one thread
+        static void prefetchOpGroup(const std::vector<BSONObj>& ops);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
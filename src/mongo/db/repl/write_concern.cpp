@@ -30,6 +30,9 @@
 
 #include "mongo/db/repl/write_concern.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/client.h"
@@ -114,8 +117,6 @@ namespace repl {
                     db.update("local.slaves", i->first, i->second, true);
                 }
                 _currentlyUpdatingCache = false;
-
-                _threadsWaitingForReplication.notify_all();
             }
         }
 
@@ -153,7 +154,7 @@ namespace repl {
                     go();
                 }
 
-                _threadsWaitingForReplication.notify_all();
+                _wakeSatisfiedWaiters_inlock( last );
             }
             return true;
         }
@@ -225,22 +226,69 @@ namespace repl {
             
             ReplicationCoordinator* replCoord = getGlobalReplicationCoordinator();
             scoped_lock mylk(_mutex);
-            while ( ! _replicatedToNum_slaves_locked( op, w ) ) {
-                if ( ! _threadsWaitingForReplication.timed_wait( mylk.boost() , xt ) ) {
+
+            if ( _replicatedToNum_slaves_locked( op, w ) )
+                return true;
+
+            // park in the optime-ordered queue; update() wakes exactly this waiter
+            // (via its own condvar) once w slaves have reached op
+            Waiter waiter( op, w );
+            WaiterQueue::iterator pos = _waiters.insert( std::make_pair( op, &waiter ) );
+
+            while ( !waiter.satisfied ) {
+                const bool timedOut = !waiter.cond.timed_wait( mylk.boost(), xt );
+
+                const bool stillMaster =
+                    replCoord->getReplicationMode() != ReplicationCoordinator::modeReplSet
+                        || replCoord->getCurrentMemberState().primary();
+
+                if ( waiter.satisfied )
+                    return true;
+
+                if ( timedOut || !stillMaster ) {
+                    _waiters.erase( pos );
                     massert(noLongerMasterAssertCode,
                             "waitForReplication called but not master anymore",
-                            replCoord->getReplicationMode() != ReplicationCoordinator::modeReplSet
-                                    || replCoord->getCurrentMemberState().primary());
+                            stillMaster);
                     return false;
                 }
-                massert(noLongerMasterAssertCode, 
-                        "waitForReplication called but not master anymore",
-                        replCoord->getReplicationMode() != ReplicationCoordinator::modeReplSet
-                                || replCoord->getCurrentMemberState().primary());
             }
             return true;
         }
 
+        /**
+         * Wakes exactly the waiters whose write concern became satisfiable now that a
+         * slave has advanced to 'advancedTo'.  Only waiters at optimes <= advancedTo can
+         * have been affected, and the queue is optime-ordered, so one pass over that
+         * prefix suffices.  _mutex must be held.
+         */
+        void _wakeSatisfiedWaiters_inlock( OpTime advancedTo ) {
+            if ( _waiters.empty() )
+                return;
+
+            // optimes of all tracked slaves, most advanced first; the w'th entry is
+            // the watermark that w slaves have replicated past
+            vector<OpTime> watermarks;
+            watermarks.reserve( _slaves.size() );
+            for ( map<Ident,OpTime>::iterator i = _slaves.begin(); i != _slaves.end(); ++i )
+                watermarks.push_back( i->second );
+            std::sort( watermarks.begin(), watermarks.end(), std::greater<OpTime>() );
+
+            WaiterQueue::iterator it = _waiters.begin();
+            while ( it != _waiters.end() && it->first <= advancedTo ) {
+                Waiter* waiter = it->second;
+                const size_t w = static_cast<size_t>( waiter->w );
+                if ( w <= watermarks.size() && watermarks[w - 1] >= waiter->op ) {
+                    waiter->satisfied = true;
+                    waiter->cond.notify_one();
+                    _waiters.erase( it++ );
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
         bool _replicatedToNum_slaves_locked(OpTime& op, int numSlaves ) {
             for ( map<Ident,OpTime>::iterator i=_slaves.begin(); i!=_slaves.end(); i++) {
                 OpTime s = i->second;
@@ -276,9 +324,27 @@ namespace repl {
             return _slaves.size();
         }
 
+        /**
+         * A client blocked in waitForReplication.  Each waiter has its own condvar so
+         * progress updates wake only the waiters they actually satisfy instead of
+         * broadcasting to every blocked client.
+         */
+        struct Waiter {
+            Waiter( OpTime o, int numSlaves ) : op(o), w(numSlaves), satisfied(false) {}
+
+            const OpTime op;
+            const int w; // number of slaves that must reach op
+            bool satisfied;
+            boost::condition cond;
+        };
+
         // need to be careful not to deadlock with this
         mutable mongo::mutex _mutex;
-        boost::condition _threadsWaitingForReplication;
+
+        // ordered by optime so _wakeSatisfiedWaiters_inlock can stop at the first
+        // waiter past the new watermark
+        typedef multimap<OpTime, Waiter*> WaiterQueue;
+        WaiterQueue _waiters;
 
         map<Ident,OpTime> _slaves;
         bool _dirty;
@@ -198,6 +198,9 @@ namespace {
         options->addOptionChaining("systemLog.logAppend", "logappend", moe::Switch,
                 "append to logpath instead of over-writing");
 
+        options->addOptionChaining("systemLog.logAsync", "logAsync", moe::Switch,
+                "encode and write log messages to logpath on a background thread");
+
         options->addOptionChaining("systemLog.logRotate", "logRotate", moe::String,
                 "set the log rotation behavior (rename|reopen)");
 
@@ -817,6 +820,11 @@ namespace {
             serverGlobalParams.logAppend = true;
         }
 
+        if (params.count("systemLog.logAsync") &&
+            params["systemLog.logAsync"].as<bool>() == true) {
+            serverGlobalParams.logAsync = true;
+        }
+
         if (params.count("systemLog.logRotate")) {
             std::string logRotateParam = params["systemLog.logRotate"].as<string>();
             if (logRotateParam == "reopen") {
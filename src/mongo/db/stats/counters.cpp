@@ -33,43 +33,44 @@
 #include "mongo/db/stats/counters.h"
 
 #include "mongo/db/jsobj.h"
+#include "mongo/util/net/message_port.h"
 
 namespace mongo {
     OpCounters::OpCounters() {}
 
     void OpCounters::incInsertInWriteLock(int n) {
         RARELY _checkWrap();
-        _insert.x += n;
+        _insert.increment(n);
     }
 
     void OpCounters::gotInsert() {
         RARELY _checkWrap();
-        _insert++;
+        _insert.increment();
     }
 
     void OpCounters::gotQuery() {
         RARELY _checkWrap();
-        _query++;
+        _query.increment();
     }
 
     void OpCounters::gotUpdate() {
         RARELY _checkWrap();
-        _update++;
+        _update.increment();
     }
 
     void OpCounters::gotDelete() {
         RARELY _checkWrap();
-        _delete++;
+        _delete.increment();
     }
 
     void OpCounters::gotGetMore() {
         RARELY _checkWrap();
-        _getmore++;
+        _getmore.increment();
     }
 
     void OpCounters::gotCommand() {
         RARELY _checkWrap();
-        _command++;
+        _command.increment();
     }
 
     void OpCounters::gotOp( int op , bool isCommand ) {
@@ -94,8 +95,10 @@ namespace mongo {
     }
 
     void OpCounters::_checkWrap() {
-        const unsigned MAX = 1 << 30;
-        
+        // the 32-bit consumers of the accessors above (snmp, etc.) expect the
+        // counters to wrap before they lose precision
+        const long long MAX = 1LL << 30;
+
         bool wrap =
             _insert.get() > MAX ||
             _query.get() > MAX ||
@@ -103,62 +106,136 @@ namespace mongo {
             _delete.get() > MAX ||
             _getmore.get() > MAX ||
             _command.get() > MAX;
-        
+
         if ( wrap ) {
-            _insert.zero();
-            _query.zero();
-            _update.zero();
-            _delete.zero();
-            _getmore.zero();
-            _command.zero();
+            _insert.setToZero();
+            _query.setToZero();
+            _update.setToZero();
+            _delete.setToZero();
+            _getmore.setToZero();
+            _command.setToZero();
         }
     }
 
     BSONObj OpCounters::getObj() const {
         BSONObjBuilder b;
-        b.append( "insert" , _insert.get() );
-        b.append( "query" , _query.get() );
-        b.append( "update" , _update.get() );
-        b.append( "delete" , _delete.get() );
-        b.append( "getmore" , _getmore.get() );
-        b.append( "command" , _command.get() );
+        b.appendNumber( "insert" , _insert.get() );
+        b.appendNumber( "query" , _query.get() );
+        b.appendNumber( "update" , _update.get() );
+        b.appendNumber( "delete" , _delete.get() );
+        b.appendNumber( "getmore" , _getmore.get() );
+        b.appendNumber( "command" , _command.get() );
         return b.obj();
     }
 
     void NetworkCounter::hit( long long bytesIn , long long bytesOut ) {
-        const long long MAX = 1ULL << 60;
-
-        // don't care about the race as its just a counter
-        bool overflow = _bytesIn > MAX || _bytesOut > MAX;
-
-        if ( overflow ) {
-            _lock.lock();
-            _overflows++;
-            _bytesIn = bytesIn;
-            _bytesOut = bytesOut;
-            _requests = 1;
-            _lock.unlock();
+        _bytesIn.increment( bytesIn );
+        _bytesOut.increment( bytesOut );
+        _requests.increment();
+    }
+
+    void NetworkCounter::append( BSONObjBuilder& b ) {
+        b.appendNumber( "bytesIn" , _bytesIn.get() );
+        b.appendNumber( "bytesOut" , _bytesOut.get() );
+        b.appendNumber( "numRequests" , _requests.get() );
+        // wire bytes saved by negotiated message compression (see networkCompress)
+        b.appendNumber( "compressionBytesSavedIn" , MessagingPort::compressionBytesSavedIn() );
+        b.appendNumber( "compressionBytesSavedOut" , MessagingPort::compressionBytesSavedOut() );
+    }
+
+
+    namespace {
+        const char* const opLatencyNames[OpLatencyHistograms::numOpTypes] = {
+            "insert", "query", "update", "delete", "getmore", "command"
+        };
+    }
+
+    int OpLatencyHistograms::_stripe() {
+        int s = _myStripe.get();
+        if ( s == 0 ) {
+            s = static_cast<int>( _stripeAllocator.fetchAndAdd(1) % kNumStripes ) + 1;
+            _myStripe.set( s );
+        }
+        return s - 1;
+    }
+
+    int OpLatencyHistograms::_bucket( long long micros ) {
+        int b = 0;
+        while ( micros > 1 && b < kNumBuckets - 1 ) {
+            micros >>= 1;
+            b++;
+        }
+        return b;
+    }
+
+    void OpLatencyHistograms::record( int op, bool isCommand, long long micros ) {
+        int type;
+        switch ( op ) {
+        case dbInsert:  type = opInsert; break;
+        case dbQuery:   type = isCommand ? opCommand : opQuery; break;
+        case dbUpdate:  type = opUpdate; break;
+        case dbDelete:  type = opDelete; break;
+        case dbGetMore: type = opGetMore; break;
+        default:        return; // killCursors, dbMsg, etc.
         }
-        else {
-            _lock.lock();
-            _bytesIn += bytesIn;
-            _bytesOut += bytesOut;
-            _requests++;
-            _lock.unlock();
+
+        Stripe& stripe = _stripes[_stripe()];
+        stripe.counts[type][_bucket( micros )].fetchAndAdd( 1 );
+
+        if ( type != opCommand ) {
+            stripe.crudOps.fetchAndAdd( 1 );
+            stripe.crudMicros.fetchAndAdd( micros );
         }
     }
 
-    void NetworkCounter::append( BSONObjBuilder& b ) {
-        _lock.lock();
-        b.appendNumber( "bytesIn" , _bytesIn );
-        b.appendNumber( "bytesOut" , _bytesOut );
-        b.appendNumber( "numRequests" , _requests );
-        _lock.unlock();
+    void OpLatencyHistograms::getCrudTotals( long long* ops, long long* micros ) const {
+        *ops = 0;
+        *micros = 0;
+        for ( int s = 0; s < kNumStripes; s++ ) {
+            *ops += _stripes[s].crudOps.load();
+            *micros += _stripes[s].crudMicros.load();
+        }
     }
 
+    void OpLatencyHistograms::append( BSONObjBuilder& b ) const {
+        for ( int t = 0; t < numOpTypes; t++ ) {
+            BSONObjBuilder sub( b.subobjStart( opLatencyNames[t] ) );
+            BSONArrayBuilder buckets( sub.subarrayStart( "histogram" ) );
+
+            long long ops = 0;
+            for ( int i = 0; i < kNumBuckets; i++ ) {
+                long long n = 0;
+                for ( int s = 0; s < kNumStripes; s++ ) {
+                    n += _stripes[s].counts[t][i].load();
+                }
+                if ( n == 0 )
+                    continue;
+
+                BSONObjBuilder bucket( buckets.subobjStart() );
+                // lower bound of the bucket, in microseconds
+                bucket.appendNumber( "micros", static_cast<long long>( 1LL << i ) );
+                bucket.appendNumber( "count", n );
+                bucket.done();
+
+                ops += n;
+            }
+
+            buckets.done();
+            sub.appendNumber( "ops", ops );
+            sub.done();
+        }
+
+        // cumulative CRUD totals, sampled by the balancer as a load signal
+        long long crudOps;
+        long long crudMicros;
+        getCrudTotals( &crudOps, &crudMicros );
+        b.appendNumber( "crudOps", crudOps );
+        b.appendNumber( "crudMicros", crudMicros );
+    }
 
     OpCounters globalOpCounters;
     OpCounters replOpCounters;
     NetworkCounter networkCounter;
+    OpLatencyHistograms globalOpLatencyHistograms;
 
 }
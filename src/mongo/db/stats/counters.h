@@ -32,9 +32,12 @@
 #include "mongo/pch.h"
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/striped_counter.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/concurrency/threadlocal.h"
 
 namespace mongo {
 
@@ -59,43 +62,99 @@ namespace mongo {
         BSONObj getObj() const;
         
         // thse are used by snmp, and other things, do not remove
-        const AtomicUInt * getInsert() const { return &_insert; }
-        const AtomicUInt * getQuery() const { return &_query; }
-        const AtomicUInt * getUpdate() const { return &_update; }
-        const AtomicUInt * getDelete() const { return &_delete; }
-        const AtomicUInt * getGetMore() const { return &_getmore; }
-        const AtomicUInt * getCommand() const { return &_command; }
+        const StripedCounter64 * getInsert() const { return &_insert; }
+        const StripedCounter64 * getQuery() const { return &_query; }
+        const StripedCounter64 * getUpdate() const { return &_update; }
+        const StripedCounter64 * getDelete() const { return &_delete; }
+        const StripedCounter64 * getGetMore() const { return &_getmore; }
+        const StripedCounter64 * getCommand() const { return &_command; }
 
 
     private:
         void _checkWrap();
-        
-        // todo: there will be a lot of cache line contention on these.  need to do something 
-        //       else eventually.
-        AtomicUInt _insert;
-        AtomicUInt _query;
-        AtomicUInt _update;
-        AtomicUInt _delete;
-        AtomicUInt _getmore;
-        AtomicUInt _command;
+
+        // striped so that every operation bumping a counter doesn't bounce the
+        // same cache line between cores
+        StripedCounter64 _insert;
+        StripedCounter64 _query;
+        StripedCounter64 _update;
+        StripedCounter64 _delete;
+        StripedCounter64 _getmore;
+        StripedCounter64 _command;
     };
 
     extern OpCounters globalOpCounters;
     extern OpCounters replOpCounters;
 
+    /**
+     * Always-on log2 latency histograms, one per operation type.  Recording is
+     * a single atomic increment into a thread-striped bucket, so it is cheap
+     * enough to leave enabled in production; serverStatus sums the stripes.
+     */
+    class OpLatencyHistograms {
+    public:
+        enum OpType {
+            opInsert = 0,
+            opQuery,
+            opUpdate,
+            opDelete,
+            opGetMore,
+            opCommand,
+            numOpTypes
+        };
+
+        // log2 buckets of microseconds; the last bucket catches everything
+        // from ~36 minutes up
+        static const int kNumBuckets = 32;
+
+        /**
+         * Records one completed operation.  'op' is the opcode from the
+         * message header; query ops that were commands are binned as commands.
+         */
+        void record( int op, bool isCommand, long long micros );
+
+        /** Appends one subobject per op type holding the non-empty buckets. */
+        void append( BSONObjBuilder& b ) const;
+
+        /**
+         * Returns cumulative op count and latency for the CRUD op types (commands
+         * excluded).  Monotonic, so callers can sample twice and compute the
+         * average latency over the interval; the balancer and the migration
+         * throttle use this as a shard load signal.
+         */
+        void getCrudTotals( long long* ops, long long* micros ) const;
+
+    private:
+        // Striped by thread so concurrent increments don't all hit the same
+        // cache line (the known problem with the plain OpCounters members).
+        static const int kNumStripes = 16;
+
+        struct Stripe {
+            AtomicInt64 counts[numOpTypes][kNumBuckets];
+
+            // running totals for the CRUD op types, for getCrudTotals()
+            AtomicInt64 crudOps;
+            AtomicInt64 crudMicros;
+        };
+
+        int _stripe();
+        static int _bucket( long long micros );
+
+        Stripe _stripes[kNumStripes];
+        ThreadLocalValue<int> _myStripe;   // 0 = unassigned; stores stripe + 1
+        AtomicWord<unsigned> _stripeAllocator;
+    };
+
+    extern OpLatencyHistograms globalOpLatencyHistograms;
+
     class NetworkCounter {
     public:
-        NetworkCounter() : _bytesIn(0), _bytesOut(0), _requests(0), _overflows(0) {}
         void hit( long long bytesIn , long long bytesOut );
         void append( BSONObjBuilder& b );
     private:
-        long long _bytesIn;
-        long long _bytesOut;
-        long long _requests;
-
-        long long _overflows;
-
-        SpinLock _lock;
+        StripedCounter64 _bytesIn;
+        StripedCounter64 _bytesOut;
+        StripedCounter64 _requests;
     };
 
     extern NetworkCounter networkCounter;
@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/memory_account.h"
+
+namespace mongo {
+
+    /**
+     * Server status section for subsystem memory accounting.
+     *
+     * Sample format:
+     *
+     * memoryAccounting: {
+     *   sortStage: NumberLong(0),
+     *   andHash: NumberLong(0),
+     *   group: NumberLong(1048576),
+     *   total: NumberLong(1048576),
+     *   budgetBytes: NumberLong(0)
+     * }
+     */
+    class MemoryAccountingServerStatusSection : public ServerStatusSection {
+    public:
+        MemoryAccountingServerStatusSection() : ServerStatusSection( "memoryAccounting" ){}
+        bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder result;
+            MemoryAccount::appendInfo( result );
+            return result.obj();
+        }
+
+    } memoryAccountingServerStatusSection;
+
+    /**
+     * Process-wide budget for the tracked subsystems, in megabytes.
+     * 0 (the default) disables enforcement; accounting still runs.
+     */
+    class MemoryAccountingBudgetMB : public ServerParameter {
+    public:
+        MemoryAccountingBudgetMB()
+            : ServerParameter( ServerParameterSet::getGlobal(), "memoryAccountingBudgetMB" ) {
+        }
+
+        virtual void append(OperationContext* txn, BSONObjBuilder& b, const string& name) {
+            b.append( name, MemoryAccount::getBudgetBytes() / ( 1024 * 1024 ) );
+        }
+
+        virtual Status set( const BSONElement& newValueElement ) {
+            return set( newValueElement.numberLong() );
+        }
+
+        virtual Status set( long long mb ) {
+            if ( mb < 0 ) {
+                return Status( ErrorCodes::BadValue,
+                               "memoryAccountingBudgetMB has to be >= 0" );
+            }
+            MemoryAccount::setBudgetBytes( mb * 1024 * 1024 );
+            return Status::OK();
+        }
+
+        virtual Status setFromString( const string& str ) {
+            return set( atoll( str.c_str() ) );
+        }
+
+    } memoryAccountingBudgetMB;
+
+} // namespace mongo
@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    /**
+     * Server status section reporting every task registered with the shared periodic
+     * task scheduler, so all background cadences are visible in one place.
+     *
+     * Sample format:
+     *
+     * periodicTasks: {
+     *   ClientCursorMonitor: {
+     *     periodSecs: 4,
+     *     runs: NumberLong(120),
+     *     totalTimeMillis: NumberLong(35),
+     *     lastTimeMillis: 0
+     *   },
+     *   ...
+     * }
+     */
+    class PeriodicTaskServerStatusSection : public ServerStatusSection {
+    public:
+        PeriodicTaskServerStatusSection() : ServerStatusSection( "periodicTasks" ) {}
+        bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            std::vector<PeriodicTaskStats> statsList;
+            PeriodicTask::getTaskStats( &statsList );
+
+            BSONObjBuilder result;
+            for ( size_t i = 0; i < statsList.size(); i++ ) {
+                const PeriodicTaskStats& stats = statsList[i];
+
+                BSONObjBuilder taskBuilder( result.subobjStart( stats.name ) );
+                taskBuilder.append( "periodSecs", stats.periodSeconds );
+                taskBuilder.appendNumber( "runs",
+                                          static_cast<long long>( stats.runs ) );
+                taskBuilder.appendNumber( "totalTimeMillis", stats.totalTimeMillis );
+                taskBuilder.append( "lastTimeMillis", stats.lastTimeMillis );
+                taskBuilder.doneFast();
+            }
+
+            return result.obj();
+        }
+    } periodicTaskServerStatusSection;
+
+} // namespace mongo
@@ -115,37 +115,22 @@ namespace mongo {
         ss << "</div>\n";
     }
 
-    void SnapshotThread::run() {
-        Client::initThread("snapshotthread");
-        Client& client = cc();
-
-        long long numLoops = 0;
-
-        const SnapshotData* prev = 0;
-
-        while ( ! inShutdown() ) {
-            try {
-                const SnapshotData* s = statsSnapshots.takeSnapshot();
-
-                if (prev && serverGlobalParams.cpu) {
-                    unsigned long long elapsed = s->_created - prev->_created;
-                    SnapshotDelta d( *prev , *s );
-                    log() << "cpu: elapsed:" << (elapsed/1000) <<"  writelock: " << (int)(100*d.percentWriteLocked()) << "%" << endl;
-                }
-
-                prev = s;
-            }
-            catch ( std::exception& e ) {
-                log() << "ERROR in SnapshotThread: " << e.what() << endl;
-            }
-
-            numLoops++;
-            sleepsecs(4);
+    void StatsSnapshotTask::taskDoWork() {
+        // The scheduler thread is shared between tasks; whichever runs first sets up the
+        // thread's Client.
+        if ( ! haveClient() )
+            Client::initThread("snapshot");
+
+        const SnapshotData* s = statsSnapshots.takeSnapshot();
+
+        if (_prev && serverGlobalParams.cpu) {
+            unsigned long long elapsed = s->_created - _prev->_created;
+            SnapshotDelta d( *_prev , *s );
+            log() << "cpu: elapsed:" << (elapsed/1000) <<"  writelock: " << (int)(100*d.percentWriteLocked()) << "%" << endl;
         }
 
-        client.shutdown();
+        _prev = s;
     }
 
     Snapshots statsSnapshots;
-    SnapshotThread snapshotThread;
 }
@@ -39,7 +39,7 @@
  */
 namespace mongo {
 
-    class SnapshotThread;
+    class StatsSnapshotTask;
 
     /**
      * stores a point in time snapshot
@@ -53,7 +53,7 @@ namespace mongo {
         unsigned long long _totalWriteLockedTime; // micros of total time locked
         Top::UsageMap _usage;
 
-        friend class SnapshotThread;
+        friend class StatsSnapshotTask;
         friend class SnapshotDelta;
         friend class Snapshots;
     };
@@ -113,14 +113,23 @@ namespace mongo {
         int _stored;
     };
 
-    class SnapshotThread : public BackgroundJob {
+    /**
+     * Takes a statistics snapshot every few seconds on the shared PeriodicTask
+     * scheduler.  Instantiated at startup only when the HTTP interface needs the
+     * history.
+     */
+    class StatsSnapshotTask : public PeriodicTask {
     public:
-        virtual std::string name() const { return "snapshot"; }
-        void run();
+        StatsSnapshotTask() : _prev( NULL ) {}
+        virtual std::string taskName() const { return "snapshot"; }
+        virtual int taskPeriodSeconds() const { return 4; }
+        virtual void taskDoWork();
+
+    private:
+        const SnapshotData* _prev;
     };
 
     extern Snapshots statsSnapshots;
-    extern SnapshotThread snapshotThread;
 
 
 }
@@ -0,0 +1,101 @@
+// startup_readiness.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/stats/startup_readiness.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    namespace {
+        AtomicUInt32 databasesTotal;
+        AtomicUInt32 databasesOpened;
+        AtomicUInt32 startupComplete;
+        AtomicUInt64 openPassStartMillis;
+        AtomicUInt64 openPassMillis;
+    }
+
+    void StartupReadiness::setDatabasesToOpen( unsigned total ) {
+        databasesTotal.store( total );
+        openPassStartMillis.store( curTimeMillis64() );
+    }
+
+    void StartupReadiness::noteDatabaseOpened() {
+        databasesOpened.fetchAndAdd( 1 );
+    }
+
+    void StartupReadiness::noteStartupComplete() {
+        openPassMillis.store( curTimeMillis64() - openPassStartMillis.load() );
+        startupComplete.store( 1 );
+    }
+
+    void StartupReadiness::appendInfo( BSONObjBuilder& b ) {
+        const bool ready = startupComplete.load() != 0;
+        b.append( "ready", ready );
+        b.append( "databasesOpened", static_cast<int>( databasesOpened.load() ) );
+        b.append( "databasesTotal", static_cast<int>( databasesTotal.load() ) );
+
+        long long millis = 0;
+        if ( ready ) {
+            millis = static_cast<long long>( openPassMillis.load() );
+        }
+        else if ( openPassStartMillis.load() > 0 ) {
+            millis = static_cast<long long>( curTimeMillis64() - openPassStartMillis.load() );
+        }
+        b.appendNumber( "openPassMillis", millis );
+    }
+
+    /**
+     * 'startupReadiness' serverStatus section.
+     *
+     * Sample format:
+     *
+     * startupReadiness: {
+     *   ready: true,
+     *   databasesOpened: 600,
+     *   databasesTotal: 600,
+     *   openPassMillis: NumberLong(73210)
+     * }
+     */
+    class StartupReadinessServerStatusSection : public ServerStatusSection {
+    public:
+        StartupReadinessServerStatusSection() : ServerStatusSection( "startupReadiness" ) {}
+        bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder result;
+            StartupReadiness::appendInfo( result );
+            return result.obj();
+        }
+    } startupReadinessServerStatusSection;
+}
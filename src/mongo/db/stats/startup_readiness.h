@@ -0,0 +1,56 @@
+// startup_readiness.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Tracks how far startup has progressed through opening and checking the
+     * node's databases.  Exposed through the 'startupReadiness' serverStatus
+     * section so operators of many-database deployments can see how long the
+     * warm-up pass took (or, via the web interface, how far along it is)
+     * instead of guessing from the log.
+     *
+     * The mutating methods are called only from the startup path; reads may
+     * come from any thread.
+     */
+    class StartupReadiness {
+    public:
+        static void setDatabasesToOpen( unsigned total );
+        static void noteDatabaseOpened();
+        static void noteStartupComplete();
+
+        static void appendInfo( BSONObjBuilder& b );
+    };
+
+}  // namespace mongo
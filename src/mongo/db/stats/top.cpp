@@ -60,24 +60,75 @@ namespace mongo {
 
     }
 
+    Top::~Top() {
+        const CounterMap* map = _currentMap();
+        for ( CounterMap::const_iterator i = map->begin(); i != map->end(); ++i )
+            delete i->second;
+        delete map;
+
+        for ( size_t i = 0; i < _retiredMaps.size(); i++ )
+            delete _retiredMaps[i];
+        for ( size_t i = 0; i < _retiredCounters.size(); i++ )
+            delete _retiredCounters[i];
+    }
+
     void Top::record( const StringData& ns , int op , int lockType , long long micros , bool command ) {
         if ( ns[0] == '?' )
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
+        const CounterMap* map = _currentMap();
+        CounterMap::const_iterator it = map->find( ns );
+
+        CollectionCounters* coll;
+        if ( it != map->end() ) {
+            coll = it->second;
+        }
+        else {
+            coll = _getOrCreate( ns , op , command );
+            if ( !coll )
+                return;
+        }
+
+        int slot = _slot();
+        coll->record( slot , op , lockType , micros , command );
+        _global.record( slot , op , lockType , micros , command );
+    }
+
+    Top::CollectionCounters* Top::_getOrCreate( const StringData& ns , int op , bool command ) {
         SimpleMutex::scoped_lock lk(_lock);
 
         if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
             _lastDropped = "";
-            return;
+            return NULL;
         }
 
-        CollectionData& coll = _usage[ns];
-        _record( coll , op , lockType , micros , command );
-        _record( _global , op , lockType , micros , command );
+        const CounterMap* current = _currentMap();
+        CounterMap::const_iterator it = current->find( ns );
+        if ( it != current->end() )
+            return it->second;
+
+        auto_ptr<CounterMap> next( new CounterMap( *current ) );
+        CollectionCounters* coll = new CollectionCounters();
+        (*next)[ns] = coll;
+
+        _retiredMaps.push_back( current );
+        _setCurrentMap( next.release() );
+        return coll;
     }
 
-    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
+    int Top::_slot() {
+        int s = _mySlot.get();
+        if ( !s ) {
+            s = static_cast<int>( _slotAllocator.fetchAndAdd( 1 ) % kNumSlots ) + 1;
+            _mySlot.set( s );
+        }
+        return s - 1;
+    }
+
+    void Top::CollectionCounters::record( int slot , int op , int lockType , long long micros , bool command ) {
+        CounterSlot& c = slots[slot];
+
         c.total.inc( micros );
 
         if ( lockType > 0 )
@@ -119,20 +170,61 @@ namespace mongo {
 
     }
 
+    void Top::CollectionCounters::aggregate( CollectionData* out ) const {
+        for ( int i = 0; i < kNumSlots; i++ ) {
+            const CounterSlot& c = slots[i];
+
+            c.total.addTo( &out->total );
+
+            c.readLock.addTo( &out->readLock );
+            c.writeLock.addTo( &out->writeLock );
+
+            c.queries.addTo( &out->queries );
+            c.getmore.addTo( &out->getmore );
+            c.insert.addTo( &out->insert );
+            c.update.addTo( &out->update );
+            c.remove.addTo( &out->remove );
+            c.commands.addTo( &out->commands );
+        }
+    }
+
     void Top::collectionDropped( const StringData& ns ) {
         SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
+
+        const CounterMap* current = _currentMap();
+        CounterMap::const_iterator it = current->find( ns );
+        if ( it != current->end() ) {
+            auto_ptr<CounterMap> next( new CounterMap( *current ) );
+            next->erase( ns );
+
+            _retiredCounters.push_back( it->second );
+            _retiredMaps.push_back( current );
+            _setCurrentMap( next.release() );
+        }
+
         _lastDropped = ns.toString();
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
         SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+
+        const CounterMap* map = _currentMap();
+        for ( CounterMap::const_iterator i = map->begin(); i != map->end(); ++i ) {
+            i->second->aggregate( &out[i->first] );
+        }
+    }
+
+    Top::CollectionData Top::getGlobalData() const {
+        CollectionData result;
+        _global.aggregate( &result );
+        return result;
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b , _usage );
+        UsageMap usage;
+        cloneMap( usage );
+        _appendToUsageMap( b , usage );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
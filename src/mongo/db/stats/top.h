@@ -30,19 +30,32 @@
 #pragma once
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <vector>
 
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * The record() hot path is lock free.  Each namespace owns an array of
+     * cache-line-sized counter slots; a thread draws a slot once and afterwards only
+     * does atomic increments into it, so operations on different cores don't fight
+     * over a mutex or a single set of counters.  The namespace map itself is
+     * published copy-on-write: _lock is only taken to add or drop a namespace and by
+     * readers (the top command, serverStatus, the snapshot thread), which aggregate
+     * the slots on demand.
      */
     class Top {
 
     public:
-        Top() : _lock("Top") { }
+        Top() : _lock("Top") { _setCurrentMap( new CounterMap() ); }
+        ~Top();
 
         struct UsageData {
             UsageData() : time(0) , count(0) {}
@@ -82,21 +95,95 @@ namespace mongo {
         void record( const StringData& ns , int op , int lockType , long long micros , bool command );
         void append( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
-        CollectionData getGlobalData() const { return _global; }
+        CollectionData getGlobalData() const;
         void collectionDropped( const StringData& ns );
 
     public: // static stuff
         static Top global;
 
     private:
+        // How many slots each namespace's counters are sharded over.  Sized for the
+        // biggest boxes we run on; a thread keeps the slot it draws first.
+        static const int kNumSlots = 32;
+
+        // An atomic (time, count) pair.
+        struct AtomicUsage {
+            AtomicInt64 time;
+            AtomicInt64 count;
+
+            void inc( long long micros ) {
+                time.fetchAndAdd( micros );
+                count.fetchAndAdd( 1 );
+            }
+
+            void addTo( UsageData* out ) const {
+                out->time += time.load();
+                out->count += count.load();
+            }
+        };
+
+        // One slot is written only by the threads that drew it; the padding keeps
+        // neighbouring slots from sharing a cache line.
+        struct CounterSlot {
+            AtomicUsage total;
+
+            AtomicUsage readLock;
+            AtomicUsage writeLock;
+
+            AtomicUsage queries;
+            AtomicUsage getmore;
+            AtomicUsage insert;
+            AtomicUsage update;
+            AtomicUsage remove;
+            AtomicUsage commands;
+
+            char _pad[48];
+        };
+
+        struct CollectionCounters {
+            CounterSlot slots[kNumSlots];
+
+            void record( int slot , int op , int lockType , long long micros , bool command );
+            void aggregate( CollectionData* out ) const;
+        };
+
+        typedef StringMap<CollectionCounters*> CounterMap;
+
+        const CounterMap* _currentMap() const {
+            return reinterpret_cast<const CounterMap*>( _current.load() );
+        }
+
+        void _setCurrentMap( const CounterMap* map ) {
+            _current.store( reinterpret_cast<uintptr_t>( map ) );
+        }
+
+        /**
+         * Slow path of record(): publishes a new map version containing 'ns'.
+         * Returns NULL if 'ns' was just dropped and this op shouldn't resurrect it.
+         */
+        CollectionCounters* _getOrCreate( const StringData& ns , int op , bool command );
+
+        int _slot();
+
         void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
-        void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
 
+        // Guards map publication, _lastDropped and the retired lists.  Not taken by
+        // the record() hot path once a namespace exists.
         mutable SimpleMutex _lock;
-        CollectionData _global;
-        UsageMap _usage;
+
+        AtomicWord<uintptr_t> _current; // const CounterMap*, read lock free
+
+        CollectionCounters _global;
         std::string _lastDropped;
+
+        // Superseded map versions and counters of dropped namespaces.  A racing
+        // record() may still be reading them, so they are only reclaimed here.
+        std::vector<const CounterMap*> _retiredMaps;
+        std::vector<CollectionCounters*> _retiredCounters;
+
+        AtomicWord<unsigned> _slotAllocator;
+        ThreadLocalValue<int> _mySlot; // 1 + slot index; 0 means not drawn yet
     };
 
 } // namespace mongo
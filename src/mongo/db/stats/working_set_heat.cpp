@@ -0,0 +1,130 @@
+// working_set_heat.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/stats/working_set_heat.h"
+
+#include <cmath>
+
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    WorkingSetHeat WorkingSetHeat::global;
+
+    WorkingSetHeat::WorkingSetHeat() : _lock("WorkingSetHeat") {
+    }
+
+    void WorkingSetHeat::NsHeat::decayTo( time_t now ) {
+        if ( lastDecay == 0 ) {
+            lastDecay = now;
+            return;
+        }
+        if ( now <= lastDecay )
+            return;
+        const double factor = std::pow( 0.5, double( now - lastDecay ) / kHalfLifeSecs );
+        heat *= factor;
+        resident *= factor;
+        lastDecay = now;
+    }
+
+    void WorkingSetHeat::_recordSample( const StringData& ns, const void* addr ) {
+        // the mincore probe is the expensive part; do it outside the lock
+        const bool inCore = ProcessInfo::blockInMemory( addr );
+        const time_t now = time( 0 );
+
+        SimpleMutex::scoped_lock lk( _lock );
+        NsHeat& h = _map[ ns ];
+        h.decayTo( now );
+        h.heat += 1;
+        if ( inCore )
+            h.resident += 1;
+        h.lastAccess = now;
+    }
+
+    void WorkingSetHeat::collectionDropped( const StringData& ns ) {
+        const std::string prefix = ns.toString() + ".$";
+
+        SimpleMutex::scoped_lock lk( _lock );
+        std::vector<std::string> doomed;
+        for ( HeatMap::const_iterator it = _map.begin(); it != _map.end(); ++it ) {
+            // drop the collection itself and its "db.coll.$index" namespaces
+            if ( it->first == ns ||
+                 it->first.compare( 0, prefix.size(), prefix ) == 0 ) {
+                doomed.push_back( it->first );
+            }
+        }
+        for ( size_t i = 0; i < doomed.size(); ++i ) {
+            _map.erase( doomed[i] );
+        }
+    }
+
+    bool WorkingSetHeat::appendForNamespace( const StringData& ns, BSONObjBuilder& b ) const {
+        SimpleMutex::scoped_lock lk( _lock );
+        HeatMap::const_iterator it = _map.find( ns );
+        if ( it == _map.end() )
+            return false;
+
+        NsHeat h = it->second;
+        h.decayTo( time( 0 ) );
+        if ( h.heat <= 0 )
+            return false;
+
+        b.append( "heat", h.heat );
+        b.append( "residentFraction", h.resident / h.heat );
+        b.appendTimeT( "lastAccess", h.lastAccess );
+        return true;
+    }
+
+    void WorkingSetHeat::append( BSONObjBuilder& b ) {
+        const time_t now = time( 0 );
+        std::vector<std::string> cold;
+
+        SimpleMutex::scoped_lock lk( _lock );
+        for ( HeatMap::const_iterator it = _map.begin(); it != _map.end(); ++it ) {
+            NsHeat h = it->second;
+            h.decayTo( now );
+            if ( h.heat < 0.5 ) {
+                // decayed to nothing: forget the namespace rather than reporting
+                // (and holding) noise forever
+                cold.push_back( it->first );
+                continue;
+            }
+            BSONObjBuilder nsBuilder( b.subobjStart( it->first ) );
+            nsBuilder.append( "heat", h.heat );
+            nsBuilder.append( "residentFraction", h.resident / h.heat );
+            nsBuilder.appendTimeT( "lastAccess", h.lastAccess );
+            nsBuilder.done();
+        }
+
+        for ( size_t i = 0; i < cold.size(); ++i ) {
+            _map.erase( cold[i] );
+        }
+    }
+
+}  // namespace mongo
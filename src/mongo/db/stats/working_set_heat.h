@@ -0,0 +1,113 @@
+// working_set_heat.h : sampled page-residency working set estimation.
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * Estimates the hot working set by sampling page residency during normal record
+     * access.
+     *
+     * Every kSampleEvery-th record access probes the touched address with mincore
+     * (ProcessInfo::blockInMemory) and folds the outcome into a per-namespace
+     * accumulator.  The accumulators decay exponentially, so a collection that goes
+     * cold fades out of the picture instead of being counted forever.  Index extents
+     * are tracked under their own "db.coll.$index" namespaces, the same way the
+     * catalog names them.
+     *
+     * The results appear in the serverStatus 'workingSetHeat' section and in the
+     * collStats 'workingSetHeat' detail.
+     */
+    class WorkingSetHeat {
+        MONGO_DISALLOW_COPYING(WorkingSetHeat);
+    public:
+        WorkingSetHeat();
+
+        /**
+         * Called from the record access path.  Cheap (one relaxed atomic add)
+         * except on the sampled accesses that actually probe residency.
+         */
+        void noteAccess( const StringData& ns, const void* addr ) {
+            if ( ( _clock.fetchAndAdd( 1 ) & ( kSampleEvery - 1 ) ) != 0 )
+                return;
+            _recordSample( ns, addr );
+        }
+
+        /** drops the accumulators for a namespace and its indexes */
+        void collectionDropped( const StringData& ns );
+
+        /**
+         * Appends { heat, residentFraction, lastAccess } for one namespace.
+         * Returns false (appending nothing) if the namespace has never been sampled.
+         */
+        bool appendForNamespace( const StringData& ns, BSONObjBuilder& b ) const;
+
+        /** appends a per-namespace heat map of everything we have sampled */
+        void append( BSONObjBuilder& b );
+
+    public: // static stuff
+        static WorkingSetHeat global;
+
+    private:
+        // Sample one access in 256; must be a power of two.
+        static const unsigned kSampleEvery = 256;
+        // Accumulator half life.  Collections untouched for a few multiples of this
+        // are dropped from the map entirely.
+        static const int kHalfLifeSecs = 900;
+
+        struct NsHeat {
+            NsHeat() : heat(0), resident(0), lastAccess(0), lastDecay(0) {}
+
+            // decayed count of sampled accesses, and of those found in core
+            double heat;
+            double resident;
+            time_t lastAccess;
+            time_t lastDecay;
+
+            void decayTo( time_t now );
+        };
+
+        typedef StringMap<NsHeat> HeatMap;
+
+        void _recordSample( const StringData& ns, const void* addr );
+
+        AtomicUInt32 _clock;
+        mutable SimpleMutex _lock;
+        HeatMap _map;
+    };
+
+}  // namespace mongo
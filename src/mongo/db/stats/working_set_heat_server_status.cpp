@@ -0,0 +1,61 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/stats/working_set_heat.h"
+
+namespace mongo {
+
+    /**
+     * Server status section for the sampled working set estimator.
+     *
+     * Sample format:
+     *
+     * workingSetHeat: {
+     *   "test.orders": { heat: 812.4, residentFraction: 0.97, lastAccess: ... },
+     *   "test.orders.$status_1": { heat: 340.1, residentFraction: 1.0, lastAccess: ... }
+     * }
+     *
+     * 'heat' is an exponentially decayed count of sampled accesses;
+     * 'residentFraction' is the decayed share of those samples that found the
+     * touched page in physical memory.
+     */
+    class WorkingSetHeatServerStatusSection : public ServerStatusSection {
+    public:
+        WorkingSetHeatServerStatusSection() : ServerStatusSection( "workingSetHeat" ){}
+        bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder result;
+            WorkingSetHeat::global.append( result );
+            return result.obj();
+        }
+
+    } workingSetHeatServerStatusSection;
+
+}  // namespace mongo
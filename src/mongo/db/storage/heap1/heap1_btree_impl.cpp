@@ -367,6 +367,13 @@ namespace {
                     ++_it;
             }
 
+            virtual long long countAndAdvance(const BtreeInterface::Cursor& end) {
+                // A tally of one per call is a valid partial result; this in-memory
+                // engine has no bucket structure to exploit for bulk counting.
+                advance();
+                return 1;
+            }
+
             virtual void savePosition() {
                 if (_it == _data.end()) {
                     _savedAtEnd = true;
@@ -464,6 +471,13 @@ namespace {
                     ++_it;
             }
 
+            virtual long long countAndAdvance(const BtreeInterface::Cursor& end) {
+                // Only ever called on forward cursors, but keep the same one-at-a-time
+                // behavior rather than leave this unimplemented.
+                advance();
+                return 1;
+            }
+
             virtual void savePosition() {
                 if (_it == _data.rend()) {
                     _savedAtEnd = true;
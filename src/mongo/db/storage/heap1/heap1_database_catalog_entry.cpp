@@ -30,6 +30,8 @@
 
 #include "mongo/db/storage/heap1/heap1_database_catalog_entry.h"
 
+#include <ostream>
+
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/index/2d_access_method.h"
 #include "mongo/db/index/btree_access_method.h"
@@ -48,20 +50,35 @@
 namespace mongo {
 
     Heap1DatabaseCatalogEntry::Heap1DatabaseCatalogEntry( const StringData& name )
-        : DatabaseCatalogEntry( name ) {
-        _everHadACollection = false;
+        : DatabaseCatalogEntry( name ),
+          _shared( new SharedState() ) {
+    }
+
+    Heap1DatabaseCatalogEntry::Heap1DatabaseCatalogEntry(
+            const StringData& name,
+            const boost::shared_ptr<SharedState>& shared )
+        : DatabaseCatalogEntry( name ),
+          _shared( shared ) {
     }
 
     Heap1DatabaseCatalogEntry::~Heap1DatabaseCatalogEntry() {
-        for ( EntryMap::const_iterator i = _entryMap.begin(); i != _entryMap.end(); ++i ) {
+        // the data lives in _shared, which the engine may keep alive
+    }
+
+    Heap1DatabaseCatalogEntry::SharedState::~SharedState() {
+        for ( EntryMap::const_iterator i = entryMap.begin(); i != entryMap.end(); ++i ) {
             delete i->second;
         }
-        _entryMap.clear();
+        entryMap.clear();
+    }
+
+    bool Heap1DatabaseCatalogEntry::exists() const {
+        return _shared->everHadACollection;
     }
 
     bool Heap1DatabaseCatalogEntry::isEmpty() const {
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        return _entryMap.empty();
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        return _shared->entryMap.empty();
     }
 
     void Heap1DatabaseCatalogEntry::appendExtraStats( OperationContext* opCtx,
@@ -71,41 +88,36 @@ namespace mongo {
 
     CollectionCatalogEntry* Heap1DatabaseCatalogEntry::getCollectionCatalogEntry( OperationContext* opCtx,
                                                                                   const StringData& ns ) {
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        EntryMap::iterator i = _entryMap.find( ns.toString() );
-        if ( i == _entryMap.end() )
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        EntryMap::iterator i = _shared->entryMap.find( ns.toString() );
+        if ( i == _shared->entryMap.end() )
             return NULL;
         return i->second;
     }
 
     RecordStore* Heap1DatabaseCatalogEntry::getRecordStore( OperationContext* opCtx,
                                                             const StringData& ns ) {
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        EntryMap::iterator i = _entryMap.find( ns.toString() );
-        if ( i == _entryMap.end() )
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        EntryMap::iterator i = _shared->entryMap.find( ns.toString() );
+        if ( i == _shared->entryMap.end() )
             return NULL;
         return i->second->rs.get();
     }
 
     void Heap1DatabaseCatalogEntry::getCollectionNamespaces( std::list<std::string>* out ) const {
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        for ( EntryMap::const_iterator i = _entryMap.begin(); i != _entryMap.end(); ++i ) {
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        for ( EntryMap::const_iterator i = _shared->entryMap.begin();
+              i != _shared->entryMap.end();
+              ++i ) {
             out->push_back( i->first );
         }
     }
 
-    Status Heap1DatabaseCatalogEntry::createCollection( OperationContext* opCtx,
-                                                        const StringData& ns,
-                                                        const CollectionOptions& options,
-                                                        bool allocateDefaultSpace ) {
-        dynamic_cast<Heap1RecoveryUnit*>( opCtx->recoveryUnit() )->rollbackPossible = false;
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        Entry*& entry = _entryMap[ ns.toString() ];
-        if ( entry )
-            return Status( ErrorCodes::NamespaceExists,
-                           "cannot create collection, already exists" );
-
-        entry = new Entry( ns );
+    Heap1DatabaseCatalogEntry::Entry* Heap1DatabaseCatalogEntry::_createEntry_inlock(
+            const StringData& ns,
+            const CollectionOptions& options ) {
+        Entry* entry = new Entry( ns );
+        entry->options = options;
 
         if ( options.capped ) {
             entry->rs.reset(new HeapRecordStore(ns,
@@ -119,26 +131,95 @@ namespace mongo {
             entry->rs.reset( new HeapRecordStore( ns ) );
         }
 
+        _shared->everHadACollection = true;
+        return entry;
+    }
+
+    Status Heap1DatabaseCatalogEntry::createCollection( OperationContext* opCtx,
+                                                        const StringData& ns,
+                                                        const CollectionOptions& options,
+                                                        bool allocateDefaultSpace ) {
+        dynamic_cast<Heap1RecoveryUnit*>( opCtx->recoveryUnit() )->rollbackPossible = false;
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        Entry*& entry = _shared->entryMap[ ns.toString() ];
+        if ( entry )
+            return Status( ErrorCodes::NamespaceExists,
+                           "cannot create collection, already exists" );
+
+        entry = _createEntry_inlock( ns, options );
+
         return Status::OK();
     }
 
+    HeapRecordStore* Heap1DatabaseCatalogEntry::createCollectionForLoad(
+            const std::string& ns,
+            const CollectionOptions& options ) {
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        Entry*& entry = _shared->entryMap[ ns ];
+        if ( entry )
+            return NULL;
+
+        entry = _createEntry_inlock( ns, options );
+        return entry->rs.get();
+    }
+
     Status Heap1DatabaseCatalogEntry::dropCollection( OperationContext* opCtx,
                                                       const StringData& ns ) {
         //TODO: invariant( opCtx->lockState()->isWriteLocked( ns ) );
 
         dynamic_cast<Heap1RecoveryUnit*>( opCtx->recoveryUnit() )->rollbackPossible = false;
-        boost::mutex::scoped_lock lk( _entryMapLock );
-        EntryMap::iterator i = _entryMap.find( ns.toString() );
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        EntryMap::iterator i = _shared->entryMap.find( ns.toString() );
 
-        if ( i == _entryMap.end() )
+        if ( i == _shared->entryMap.end() )
             return Status( ErrorCodes::NamespaceNotFound, "namespace not found" );
 
         delete i->second;
-        _entryMap.erase( i );
+        _shared->entryMap.erase( i );
 
         return Status::OK();
     }
 
+    long long Heap1DatabaseCatalogEntry::dataSize() const {
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        long long total = 0;
+        for ( EntryMap::const_iterator i = _shared->entryMap.begin();
+              i != _shared->entryMap.end();
+              ++i ) {
+            total += i->second->rs->dataSize();
+        }
+        return total;
+    }
+
+    void Heap1DatabaseCatalogEntry::writeSnapshot( std::ostream& out ) const {
+        boost::mutex::scoped_lock lk( _shared->entryMapLock );
+        for ( EntryMap::const_iterator i = _shared->entryMap.begin();
+              i != _shared->entryMap.end();
+              ++i ) {
+            const Entry* entry = i->second;
+
+            BSONObjBuilder headerBuilder;
+            headerBuilder.append( "$inMemoryNs", i->first );
+            headerBuilder.append( "options", entry->options.toBSON() );
+            const BSONObj header = headerBuilder.obj();
+            out.write( header.objdata(), header.objsize() );
+
+            long long n = 0;
+            scoped_ptr<RecordIterator> it(
+                    entry->rs->getIterator( DiskLoc(), false, CollectionScanParams::FORWARD ) );
+            while ( !it->isEOF() ) {
+                const DiskLoc loc = it->getNext();
+                const RecordData rd = entry->rs->dataFor( loc );
+                out.write( rd.data(), rd.size() );
+                n++;
+            }
+
+            // per-collection record count doubles as a corruption check on load
+            const BSONObj footer = BSON( "$inMemoryDone" << n );
+            out.write( footer.objdata(), footer.objsize() );
+        }
+    }
+
 
     IndexAccessMethod* Heap1DatabaseCatalogEntry::getIndex( OperationContext* txn,
                                                             const CollectionCatalogEntry* collection,
@@ -171,7 +252,8 @@ namespace mongo {
                                          index->ordering(),
                                          index->descriptor()->indexNamespace(),
                                          index->descriptor()->version(),
-                                         &BtreeBasedAccessMethod::invalidateCursors));
+                                         &BtreeBasedAccessMethod::invalidateCursors,
+                                         index->descriptor()->fillFactor()));
 #endif
 
         if ("" == type)
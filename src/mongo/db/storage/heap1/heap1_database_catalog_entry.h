@@ -30,13 +30,16 @@
 
 #pragma once
 
+#include <iosfwd>
 #include <list>
 #include <map>
 #include <string>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/db/catalog/collection_catalog_entry.h"
+#include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
 
 namespace mongo {
@@ -45,11 +48,20 @@ namespace mongo {
 
     class Heap1DatabaseCatalogEntry : public DatabaseCatalogEntry {
     public:
+        class SharedState;
+
+        /** standalone entry owning its own state.  used by tests. */
         Heap1DatabaseCatalogEntry( const StringData& name );
 
+        /** entry sharing state owned by the engine.  Database deletes the entry it
+            is handed on close, so the data has to live elsewhere to survive an
+            open/close cycle. */
+        Heap1DatabaseCatalogEntry( const StringData& name,
+                                   const boost::shared_ptr<SharedState>& shared );
+
         virtual ~Heap1DatabaseCatalogEntry();
 
-        virtual bool exists() const { return _everHadACollection; }
+        virtual bool exists() const;
         virtual bool isEmpty() const;
 
         virtual void appendExtraStats( OperationContext* opCtx,
@@ -94,6 +106,22 @@ namespace mongo {
         virtual Status dropCollection( OperationContext* opCtx,
                                        const StringData& ns );
 
+        // ---- not part of the DatabaseCatalogEntry interface ----
+
+        /** total bytes of record data across all collections.  threadsafe */
+        long long dataSize() const;
+
+        /** serialize every collection (options + records) to the stream in the
+            snapshot format read back by loadCollection().  threadsafe, but callers
+            wanting a consistent image must hold the global read lock */
+        void writeSnapshot( std::ostream& out ) const;
+
+        /** create a collection and return its record store, bypassing the recovery
+            unit plumbing.  only for snapshot loading at startup, before any
+            operation context exists */
+        HeapRecordStore* createCollectionForLoad( const std::string& ns,
+                                                  const CollectionOptions& options );
+
     private:
 
         struct IndexEntry {
@@ -153,13 +181,29 @@ namespace mongo {
             scoped_ptr<HeapRecordStore> rs;
             typedef std::map<std::string,IndexEntry*> Indexes;
             Indexes indexes;
-        };
 
-        bool _everHadACollection;
+            CollectionOptions options; // as passed to createCollection
+        };
 
-        mutable boost::mutex _entryMapLock;
         typedef std::map<std::string,Entry*> EntryMap;
-        EntryMap _entryMap;
 
+        Entry* _createEntry_inlock( const StringData& ns, const CollectionOptions& options );
+
+        boost::shared_ptr<SharedState> _shared;
+
+    public:
+        /** the actual database contents.  every catalog entry handle for a database
+            points at one of these; the engine owns it, so the data outlives any
+            individual handle. */
+        class SharedState {
+        public:
+            SharedState() : everHadACollection( false ) {}
+            ~SharedState();
+
+            bool everHadACollection;
+
+            mutable boost::mutex entryMapLock;
+            EntryMap entryMap;
+        };
     };
 }
@@ -30,11 +30,91 @@
 
 #include "mongo/db/storage/heap1/heap1_engine.h"
 
+#include <fstream>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/heap1/heap1_database_catalog_entry.h"
 #include "mongo/db/storage/heap1/heap1_recovery_unit.h"
+#include "mongo/db/structure/record_store_heap.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+using namespace mongoutils;
 
 namespace mongo {
 
+    // Soft cap on total record bytes held by the in-memory engine; 0 means
+    // unlimited.  Enforcement is advisory: when exceeded, the over-budget hook
+    // runs (or we warn) from the snapshot thread.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(inMemoryMemoryBudgetMB, int, 0);
+
+    // How often the background thread rewrites the snapshot file used for warm
+    // restart.  <= 0 disables the thread; explicit fsync still writes one.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(inMemorySnapshotSecs, int, 60);
+
+    namespace {
+
+        const char kSnapshotFileName[] = "inmemory.snapshot";
+
+        // snapshot stream markers.  $-prefixed field names can't appear at the top
+        // level of stored documents, so headers and footers can't collide with data.
+        const char kSnapshotNsField[] = "$inMemoryNs";
+        const char kSnapshotDoneField[] = "$inMemoryDone";
+
+        // sanity cap when reading back a snapshot; way above the 16MB document limit
+        const int kMaxSnapshotDocBytes = 64 * 1024 * 1024;
+
+        class InMemorySnapshotThread : public BackgroundJob {
+        public:
+            explicit InMemorySnapshotThread( Heap1Engine* engine ) : _engine( engine ) {}
+            virtual ~InMemorySnapshotThread() {}
+
+            virtual std::string name() const { return "InMemorySnapshot"; }
+
+            virtual void run() {
+                Client::initThread( name().c_str() );
+                while ( !inShutdown() ) {
+                    sleepsecs( inMemorySnapshotSecs );
+                    if ( inShutdown() )
+                        break;
+                    try {
+                        _engine->snapshotNow();
+                        _engine->checkMemoryBudget();
+                    }
+                    catch ( const DBException& e ) {
+                        warning() << "in-memory snapshot failed: " << e.toString();
+                    }
+                }
+                cc().shutdown();
+            }
+
+        private:
+            Heap1Engine* _engine; // not owned
+        };
+    }
+
+    Heap1Engine::Heap1Engine( const std::string& dbpath )
+        : _overBudgetHook( NULL ) {
+        _snapshotPath = ( boost::filesystem::path( dbpath ) / kSnapshotFileName ).string();
+        _loadSnapshot();
+        if ( inMemorySnapshotSecs > 0 ) {
+            // engine and thread both live until shutdown
+            ( new InMemorySnapshotThread( this ) )->go();
+        }
+    }
+
     RecoveryUnit* Heap1Engine::newRecoveryUnit( OperationContext* opCtx ) {
         return new Heap1RecoveryUnit();
     }
@@ -42,7 +122,7 @@ namespace mongo {
     void Heap1Engine::listDatabases( std::vector<std::string>* out ) const {
         boost::mutex::scoped_lock lk( _dbLock );
         for ( DBMap::const_iterator i = _dbs.begin(); i != _dbs.end(); ++i ) {
-            out->push_back( *i );
+            out->push_back( i->first );
         }
     }
 
@@ -50,15 +130,178 @@ namespace mongo {
                                                                 const StringData& dbName ) {
         boost::mutex::scoped_lock lk( _dbLock );
 
-        // THIS is temporary I think
-        _dbs.insert( dbName.toString() );
-        return new Heap1DatabaseCatalogEntry( dbName );
-        /*
-        Heap1DatabaseCatalogEntry*& db = _dbs[dbName.toString()];
-        if ( !db )
-            db = new Heap1DatabaseCatalogEntry( dbName );
-        return db;
-        */
+        // Database deletes the entry it is handed when the db is closed, so we hand
+        // out a fresh handle onto state we keep owning.
+        boost::shared_ptr<Heap1DatabaseCatalogEntry::SharedState>& shared =
+            _dbs[ dbName.toString() ];
+        if ( !shared )
+            shared.reset( new Heap1DatabaseCatalogEntry::SharedState() );
+        return new Heap1DatabaseCatalogEntry( dbName, shared );
+    }
+
+    int Heap1Engine::flushAllFiles( bool sync ) {
+        if ( !sync )
+            return 0;
+        return snapshotNow();
+    }
+
+    long long Heap1Engine::dataSize() const {
+        boost::mutex::scoped_lock lk( _dbLock );
+        long long total = 0;
+        for ( DBMap::const_iterator i = _dbs.begin(); i != _dbs.end(); ++i ) {
+            Heap1DatabaseCatalogEntry handle( i->first, i->second );
+            total += handle.dataSize();
+        }
+        return total;
+    }
+
+    void Heap1Engine::checkMemoryBudget() {
+        if ( inMemoryMemoryBudgetMB <= 0 )
+            return;
+        const long long budget = static_cast<long long>( inMemoryMemoryBudgetMB ) * 1024 * 1024;
+        const long long size = dataSize();
+        if ( size <= budget )
+            return;
+        if ( _overBudgetHook ) {
+            _overBudgetHook( size - budget );
+        }
+        else {
+            warning() << "in-memory storage engine is over its memory budget: "
+                      << size << " bytes held, budget is " << budget
+                      << " bytes and no eviction hook is installed";
+        }
+    }
+
+    int Heap1Engine::snapshotNow() {
+        if ( _snapshotPath.empty() )
+            return 0;
+
+        // the record stores have no internal synchronization, so quiesce writers.
+        // GlobalRead is recursive; callers already holding a lock are fine.
+        OperationContextImpl txn;
+        Lock::GlobalRead lk( txn.lockState() );
+        _writeSnapshotFile();
+        return 1;
+    }
+
+    void Heap1Engine::_writeSnapshotFile() {
+        const std::string tmpPath = _snapshotPath + ".tmp";
+
+        {
+            std::ofstream out( tmpPath.c_str(),
+                               std::ios_base::out | std::ios_base::binary | std::ios_base::trunc );
+            if ( !out.is_open() ) {
+                warning() << "could not open in-memory snapshot file for writing: " << tmpPath;
+                return;
+            }
+
+            boost::mutex::scoped_lock lk( _dbLock );
+            for ( DBMap::const_iterator i = _dbs.begin(); i != _dbs.end(); ++i ) {
+                Heap1DatabaseCatalogEntry handle( i->first, i->second );
+                handle.writeSnapshot( out );
+            }
+
+            out.flush();
+            if ( !out.good() ) {
+                warning() << "error writing in-memory snapshot file: " << tmpPath;
+                return;
+            }
+        }
+
+        // replace the old snapshot only once the new one is fully on disk
+        try {
+            if ( boost::filesystem::exists( _snapshotPath ) )
+                boost::filesystem::remove( _snapshotPath );
+            boost::filesystem::rename( tmpPath, _snapshotPath );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "could not install in-memory snapshot file "
+                      << _snapshotPath << ": " << e.what();
+        }
+    }
+
+    void Heap1Engine::_loadSnapshot() {
+        if ( !boost::filesystem::exists( _snapshotPath ) )
+            return;
+
+        log() << "loading in-memory storage engine snapshot: " << _snapshotPath;
+
+        std::ifstream in( _snapshotPath.c_str(), std::ios_base::in | std::ios_base::binary );
+        if ( !in.is_open() ) {
+            warning() << "could not open in-memory snapshot file: " << _snapshotPath;
+            return;
+        }
+
+        HeapRecordStore* currentRs = NULL;
+        long long currentCount = 0;
+        long long totalDocs = 0;
+
+        try {
+            while ( true ) {
+                char lenBuf[4];
+                in.read( lenBuf, 4 );
+                if ( in.gcount() == 0 && in.eof() )
+                    break; // clean end of stream
+                uassert( 18544, "truncated in-memory snapshot", in.gcount() == 4 );
+
+                int len;
+                memcpy( &len, lenBuf, 4 );
+                uassert( 18545, "corrupt length in in-memory snapshot",
+                         len >= 5 && len <= kMaxSnapshotDocBytes );
+
+                boost::scoped_array<char> buf( new char[len] );
+                memcpy( buf.get(), lenBuf, 4 );
+                in.read( buf.get() + 4, len - 4 );
+                uassert( 18546, "truncated document in in-memory snapshot",
+                         in.gcount() == len - 4 );
+
+                BSONObj obj( buf.get() );
+
+                if ( str::equals( obj.firstElementFieldName(), kSnapshotNsField ) ) {
+                    const std::string ns = obj[kSnapshotNsField].String();
+                    CollectionOptions options;
+                    uassertStatusOK( options.parse( obj["options"].Obj() ) );
+
+                    const std::string dbName = nsToDatabase( ns );
+                    boost::shared_ptr<Heap1DatabaseCatalogEntry::SharedState>& shared =
+                        _dbs[ dbName ];
+                    if ( !shared )
+                        shared.reset( new Heap1DatabaseCatalogEntry::SharedState() );
+                    Heap1DatabaseCatalogEntry handle( dbName, shared );
+                    currentRs = handle.createCollectionForLoad( ns, options );
+                    uassert( 18547,
+                             str::stream() << "duplicate collection in in-memory snapshot: "
+                                           << ns,
+                             currentRs );
+                    currentCount = 0;
+                }
+                else if ( str::equals( obj.firstElementFieldName(), kSnapshotDoneField ) ) {
+                    uassert( 18548, "record count mismatch in in-memory snapshot",
+                             currentRs && currentCount == obj[kSnapshotDoneField].numberLong() );
+                    currentRs = NULL;
+                }
+                else {
+                    uassert( 18549, "record outside any collection in in-memory snapshot",
+                             currentRs );
+                    // no operation context exists this early; the heap record store
+                    // only consults it for capped deletes, which can't trigger here
+                    uassertStatusOK( currentRs->insertRecord( NULL,
+                                                              obj.objdata(),
+                                                              obj.objsize(),
+                                                              -1 ).getStatus() );
+                    currentCount++;
+                    totalDocs++;
+                }
+            }
+        }
+        catch ( const DBException& e ) {
+            // start empty-ish rather than refuse to start; this is a cache
+            warning() << "giving up on in-memory snapshot " << _snapshotPath
+                      << ": " << e.toString();
+            return;
+        }
+
+        log() << "in-memory snapshot loaded, " << totalDocs << " documents";
     }
 
 }
@@ -30,20 +30,28 @@
 
 #pragma once
 
-#include <set>
 #include <string>
 #include <map>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/db/storage/heap1/heap1_database_catalog_entry.h"
 #include "mongo/db/storage/storage_engine.h"
 
 namespace mongo {
 
-    class Heap1DatabaseCatalogEntry;
-
     class Heap1Engine : public StorageEngine {
     public:
+        /** in-memory only; nothing survives a restart.  used by tests. */
+        Heap1Engine() : _overBudgetHook( NULL ) {}
+
+        /** in-memory engine with anti-entropy persistence: on construction reloads
+            the snapshot file from dbpath if present; a background thread rewrites
+            it periodically (see the inMemorySnapshotSecs parameter) so a restart
+            starts warm.  registered as --storageEngine=inMemory. */
+        explicit Heap1Engine( const std::string& dbpath );
+
         virtual ~Heap1Engine() {}
 
         virtual RecoveryUnit* newRecoveryUnit( OperationContext* opCtx );
@@ -54,19 +62,45 @@ namespace mongo {
                                                                const StringData& db );
 
         /**
+         * with persistence configured a sync flush rewrites the snapshot file
          * @return number of files flushed
          */
-        virtual int flushAllFiles( bool sync ) { return 0; }
+        virtual int flushAllFiles( bool sync );
 
         virtual Status repairDatabase( OperationContext* tnx,
                                        const std::string& dbName,
                                        bool preserveClonedFilesOnFailure = false,
                                        bool backupOriginalFiles = false ) { return Status::OK(); }
 
+        // ---- not part of the StorageEngine interface ----
+
+        /** total bytes of record data across all databases.  threadsafe */
+        long long dataSize() const;
+
+        /** called (from the snapshot thread) when dataSize() exceeds the budget set
+            by inMemoryMemoryBudgetMB; the hook is expected to expire documents.
+            without one we just log.  the session-cache layer installs its own. */
+        typedef void (*OverBudgetHook)( long long excessBytes );
+        void setOverBudgetHook( OverBudgetHook hook ) { _overBudgetHook = hook; }
+
+        /** write the snapshot file now (no-op without persistence).
+            @return number of files written (0 or 1) */
+        int snapshotNow();
+
+        /** log or dispatch to the over-budget hook if dataSize() is over budget */
+        void checkMemoryBudget();
+
     private:
+        void _loadSnapshot();
+        void _writeSnapshotFile();
+
+        std::string _snapshotPath; // empty = no persistence
+
         mutable boost::mutex _dbLock;
-        typedef std::set<std::string> DBMap;
+        typedef std::map<std::string, boost::shared_ptr<Heap1DatabaseCatalogEntry::SharedState> > DBMap;
         DBMap _dbs;
+
+        OverBudgetHook _overBudgetHook;
     };
 
 }
@@ -83,6 +83,9 @@
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_recover.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/server.h"
 #include "mongo/util/concurrency/race.h"
@@ -112,6 +115,23 @@ namespace mongo {
 
         Stats stats;
 
+        // when enabled, the journal thread sizes its commit window from the recent
+        // number of j:true waiters per commit: the first waiter triggers the commit
+        // when load is light, while under heavy load the window stretches (up to
+        // journalCommitInterval) so one journal sync acknowledges many waiters
+        MONGO_EXPORT_SERVER_PARAMETER( journalAdaptiveCommitBatching, bool, true );
+
+        // cumulative j:true waiter counts and wait time, for watching the
+        // latency side of the batching tradeoff
+        static Counter64 commitWaiters;
+        static Counter64 commitWaitMicros;
+        static ServerStatusMetricField<Counter64> displayCommitWaiters(
+                                                        "dur.commitWaiters",
+                                                        &commitWaiters );
+        static ServerStatusMetricField<Counter64> displayCommitWaitMicros(
+                                                        "dur.commitWaitTimeMicros",
+                                                        &commitWaitMicros );
+
         void Stats::S::reset() {
             memset(this, 0, sizeof(*this));
         }
@@ -156,8 +176,16 @@ namespace mongo {
                        "journaledMB" << _journaledBytes / 1000000.0 <<
                        "writeToDataFilesMB" << _writeToDataFilesBytes / 1000000.0 <<
                        "compression" << _journaledBytes / (_uncompressedBytes+1.0) <<
+                       "intentsCoalescedMB" << _intentsCoalescedBytes / 1000000.0 <<
                        "commitsInWriteLock" << _commitsInWriteLock <<
-                       "earlyCommits" << _earlyCommits << 
+                       "earlyCommits" << _earlyCommits <<
+                       "commitBatches" <<
+                       BSON( "0" << _commitBatchHisto[0] <<
+                             "1" << _commitBatchHisto[1] <<
+                             "2-3" << _commitBatchHisto[2] <<
+                             "4-7" << _commitBatchHisto[3] <<
+                             "8-15" << _commitBatchHisto[4] <<
+                             "16+" << _commitBatchHisto[5] ) <<
                        "timeMs" <<
                        BSON( "dt" << _dtMillis <<
                              "prepLogBuffer" << (unsigned) (_prepLogBufferMicros/1000) <<
@@ -228,7 +256,10 @@ namespace mongo {
         }
 
         bool DurableImpl::awaitCommit() {
+            Timer t;
             commitJob._notify.awaitBeyondNow();
+            commitWaiters.increment();
+            commitWaitMicros.increment( t.micros() );
             return true;
         }
 
@@ -467,6 +498,19 @@ namespace mongo {
 
         extern size_t privateMapBytes;
 
+        /** Incremental REMAPPRIVATEVIEW tuning.  The remap pass holds the global W lock,
+            so it stops after this many microseconds and resumes where it left off on a
+            later commit (0 = no budget, finish the whole window in one pass).
+        */
+        MONGO_EXPORT_SERVER_PARAMETER(journalRemapBudgetMicros, int, 2000);
+
+        /** A view with fewer journaled bytes than this since its last remap is passed
+            over (a bounded number of times) rather than remapped: lightly written files
+            cost more in post-remap copy-on-write faults than the private pages they
+            would give back.
+        */
+        MONGO_EXPORT_SERVER_PARAMETER(journalRemapDirtyBytesThreshold, int, 1024 * 1024);
+
         static void _REMAPPRIVATEVIEW(OperationContext* txn) {
             // todo: Consider using ProcessInfo herein and watching for getResidentSize to drop.  that could be a way 
             //       to assure very good behavior here.
@@ -529,22 +573,39 @@ namespace mongo {
                 if( i == e ) i = b;
             }
             unsigned startedAt = startAt;
-            startAt = (startAt + ntodo) % sz; // mark where to start next time
 
             Timer t;
-            for( unsigned x = 0; x < ntodo; x++ ) {
+            unsigned x = 0;
+            for( ; x < ntodo; x++ ) {
+                if( journalRemapBudgetMicros > 0 &&
+                    t.micros() > (unsigned long long)journalRemapBudgetMicros ) {
+                    // Over budget for this pass; we hold the W lock here, so stop and let
+                    // the rest of the window be picked up by later commits.
+                    break;
+                }
                 dassert( i != e );
                 if( (*i)->isDurableMappedFile() ) {
                     DurableMappedFile *mmf = (DurableMappedFile*) *i;
                     verify(mmf);
                     if( mmf->willNeedRemap() ) {
-                        mmf->remapThePrivateView();
+                        if( mmf->dirtyPrivateViewBytes() <
+                                (unsigned long long)journalRemapDirtyBytesThreshold &&
+                            mmf->remapSkips() < 3 ) {
+                            // Barely written since its last remap; remapping now costs
+                            // more in copy-on-write faults than it reclaims.  Skip it, but
+                            // only a few times so the private view still gets trimmed.
+                            mmf->noteRemapSkip();
+                        }
+                        else {
+                            mmf->remapThePrivateView();
+                        }
                     }
                     i++;
                     if( i == e ) i = b;
                 }
             }
-            LOG(2) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << ntodo << ' ' << t.millis() << "ms" << endl;
+            startAt = (startedAt + x) % sz; // mark where to start next time
+            LOG(2) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << x << " of " << ntodo << ' ' << t.millis() << "ms" << endl;
         }
 
         /** We need to remap the private views periodically. otherwise they would become very large.
@@ -556,13 +617,146 @@ namespace mongo {
             stats.curr->_remapPrivateViewMicros += t.micros();
         }
 
-        // this is a pseudo-local variable in the groupcommit functions 
-        // below.  however we don't truly do that so that we don't have to 
+        // this is a pseudo-local variable in the groupcommit functions
+        // below.  however we don't truly do that so that we don't have to
         // reallocate, and more importantly regrow it, on every single commit.
         static AlignedBuilder __theBuilder(4 * 1024 * 1024);
 
+        /** When true, the limited-locks group commit path hands the prepared log buffer
+            to a dedicated journal writer thread instead of writing it inline.  With two
+            AlignedBuilders alternating, PREPLOGBUFFER for commit N+1 overlaps with
+            WRITETOJOURNAL/WRITETODATAFILES for commit N.  See JournalPipeline below.
+        */
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalPipelinedCommits, bool, false);
+
+        /** Double-buffered handoff between the group commit code (producer) and the
+            journal writer thread (consumer).  Depth is one: the producer can gather and
+            PREPLOGBUFFER the next commit while the previous one is being compressed and
+            written, but never gets more than one commit ahead, which bounds memory and
+            keeps journal sections strictly ordered on disk.
+
+            The full-lock commit path (_groupCommit) and anything about to remap or close
+            private views must drain() first -- WRITETODATAFILES may still be copying
+            into the shared views until then.
+        */
+        class JournalPipeline : boost::noncopyable {
+        public:
+            JournalPipeline()
+                : _mutex("JournalPipeline"),
+                  _a(4 * 1024 * 1024), _b(4 * 1024 * 1024),
+                  _gather(&_a),
+                  _pending(false), _writing(false) {
+            }
+
+            /** the builder the next commit should PREPLOGBUFFER into */
+            AlignedBuilder& gatherBuffer() { return *_gather; }
+
+            /** hand the gathered buffer to the writer thread and flip buffers.
+                blocks while the previous commit is still being written (depth one).
+                @param commitNumber epoch to acknowledge once the data is in the journal
+            */
+            void submit(const JSectHeader& h, NotifyAll::When commitNumber) {
+                scoped_lock lk(_mutex);
+                while( _pending || _writing )
+                    _done.timed_wait(lk.boost(), boost::posix_time::milliseconds(100));
+                _h = h;
+                _when = commitNumber;
+                _buf = _gather;
+                _gather = (_gather == &_a) ? &_b : &_a;
+                _pending = true;
+                _work.notify_one();
+            }
+
+            /** wait until no commit is queued or being written */
+            void drain() {
+                scoped_lock lk(_mutex);
+                while( _pending || _writing )
+                    _done.timed_wait(lk.boost(), boost::posix_time::milliseconds(100));
+            }
+
+            void start() { boost::thread t(stdx::bind(&JournalPipeline::_run, this)); }
+
+        private:
+            void _run() {
+                Client::initThread("journalWriter");
+                while( !inShutdown() ) {
+                    JSectHeader h;
+                    NotifyAll::When when;
+                    AlignedBuilder* buf;
+                    {
+                        scoped_lock lk(_mutex);
+                        while( !_pending ) {
+                            _work.timed_wait(lk.boost(),
+                                             boost::posix_time::milliseconds(100));
+                            if( inShutdown() ) {
+                                cc().shutdown();
+                                return;
+                            }
+                        }
+                        h = _h;
+                        when = _when;
+                        buf = _buf;
+                        _pending = false;
+                        _writing = true;
+                    }
+
+                    try {
+                        _write(h, *buf, when);
+                    }
+                    catch(std::exception& e) {
+                        log() << "exception in journal writer thread causing immediate "
+                                 "shutdown: " << e.what() << endl;
+                        mongoAbort("durjw");
+                    }
+
+                    {
+                        scoped_lock lk(_mutex);
+                        _writing = false;
+                        _done.notify_all();
+                    }
+                }
+                cc().shutdown();
+            }
+
+            void _write(const JSectHeader& h, AlignedBuilder& ab, NotifyAll::When when) {
+                // same scope the inline path holds lk3 over -- a file cannot be closed
+                // or remapped while we are still copying into its shared view
+                LockMongoFilesShared lk;
+
+                const unsigned abLen = ab.len();
+
+                WRITETOJOURNAL(h, ab);
+                verify( abLen == ab.len() );
+
+                // data is now in the journal, which is sufficient for acknowledging
+                // getLastError. (ok to crash after that)
+                commitJob._notify.notifyAll(when);
+
+                WRITETODATAFILES(h, ab);
+                verify( abLen == ab.len() );
+                ab.reset();
+            }
+
+            mongo::mutex _mutex;
+            boost::condition _work;
+            boost::condition _done;
+
+            AlignedBuilder _a, _b;
+            AlignedBuilder* _gather;    // builder the next commit gathers into
+
+            // the queued commit (valid while _pending)
+            JSectHeader _h;
+            NotifyAll::When _when;
+            AlignedBuilder* _buf;
+            bool _pending;              // a commit is queued for the writer
+            bool _writing;              // the writer is working on a commit
+        };
+
+        static JournalPipeline journalPipeline;
+
         static bool _groupCommitWithLimitedLocks(OperationContext* txn) {
-            AlignedBuilder &ab = __theBuilder;
+            AlignedBuilder &ab = journalPipelinedCommits ? journalPipeline.gatherBuffer()
+                                                         : __theBuilder;
 
             invariant(!txn->lockState()->isLocked());
 
@@ -587,7 +781,22 @@ namespace mongo {
             // the private mmap for their actual data.  i suppose we could lock individual databases 
             // and do them one at a time or in parallel (surely the latter would make sense if one went 
             // that route...)
-            PREPLOGBUFFER(h,ab); 
+            PREPLOGBUFFER(h,ab);
+
+            if( journalPipelinedCommits ) {
+                const NotifyAll::When commitNumber = commitJob.commitNumber();
+                commitJob.committingReset(); // must be reset before allowing anyone to write
+                DEV verify( !commitJob.hasWritten() );
+
+                // release the readlock -- others can write while the journal writer
+                // thread compresses and writes this buffer.  the next commit will
+                // gather into the other builder; submit() blocks if the writer is
+                // still on the previous one.
+                lk1.reset();
+
+                journalPipeline.submit(h, commitNumber);
+                return true;
+            }
 
             LockMongoFilesShared lk3;
 
@@ -655,10 +864,15 @@ namespace mongo {
                 AlignedBuilder &ab = __theBuilder;
 
                 // we need to make sure two group commits aren't running at the same time
-                // (and we are only read locked in the dbMutex, so it could happen -- while 
+                // (and we are only read locked in the dbMutex, so it could happen -- while
                 // there is only one dur thread, "early commits" can be done by other threads)
                 SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
 
+                // a pipelined commit may still be writing to the data files; we are about
+                // to write inline and possibly remap private views, so wait it out
+                if( journalPipelinedCommits )
+                    journalPipeline.drain();
+
                 commitJob.commitingBegin();
 
                 if( !commitJob.hasWritten() ) {
@@ -783,6 +997,9 @@ namespace mongo {
             if (!storageGlobalParams.dur)
                 return;
 
+            if (journalPipelinedCommits)
+                journalPipeline.drain();
+
             if (commitJob.hasWritten()) {
                 if (inShutdown()) {
                     log() << "journal warning files are closing outside locks with writes pending"
@@ -797,6 +1014,23 @@ namespace mongo {
         extern int groupCommitIntervalMs;
         boost::filesystem::path getJournalDir();
 
+        // recent average number of j:true waiters acknowledged per commit; drives
+        // the adaptive commit window.  only the journal thread touches it.
+        static double waitersPerCommitEstimate = 0.0;
+
+        static void recordCommitBatch( unsigned waiters ) {
+            waitersPerCommitEstimate = 0.8 * waitersPerCommitEstimate + 0.2 * waiters;
+
+            int bucket;
+            if( waiters == 0 )       bucket = 0;
+            else if( waiters == 1 )  bucket = 1;
+            else if( waiters < 4 )   bucket = 2;
+            else if( waiters < 8 )   bucket = 3;
+            else if( waiters < 16 )  bucket = 4;
+            else                     bucket = 5;
+            stats.curr->_commitBatchHisto[bucket]++;
+        }
+
         void durThread() {
             Client::initThread("journal");
 
@@ -823,19 +1057,33 @@ namespace mongo {
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
+                    // commit sooner if one or more getLastError j:true is pending.
+                    // with adaptive batching the window only closes early once about
+                    // as many waiters as recent commits averaged have gathered, so
+                    // under heavy j:true load one journal sync acknowledges many
+                    // waiters while a lone waiter still commits after one slice.
+                    unsigned target = 1;
+                    if( journalAdaptiveCommitBatching ) {
+                        target = static_cast<unsigned>( waitersPerCommitEstimate );
+                        if( target < 1 )
+                            target = 1;
+                        else if( target > 64 )
+                            target = 64;
+                    }
                     sleepmillis(oneThird);
                     for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
+                        if( commitJob._notify.nWaiting() >= target )
                             break;
                         if( commitJob.bytes() > UncommittedBytesLimit / 2  )
                             break;
                         sleepmillis(oneThird);
                     }
-                                        
+
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
 
+                    const unsigned waiters = commitJob._notify.nWaiting();
                     durThreadGroupCommit();
+                    recordCommitBatch( waiters );
                 }
                 catch(std::exception& e) {
                     log() << "exception in durThread causing immediate shutdown: " << e.what() << endl;
@@ -889,6 +1137,9 @@ namespace mongo {
 
             preallocateFiles();
 
+            if (journalPipelinedCommits)
+                journalPipeline.start();
+
             boost::thread t(durThread);
         }
 
@@ -113,6 +113,37 @@ namespace mongo {
             _bytes = 0;
         }
 
+        const std::vector<WriteIntent>& CommitJob::getIntentsCoalesced() {
+            groupCommitMutex.dassertLocked();
+
+            vector<WriteIntent>& intents = _intentsAndDurOps._intents;
+            sort(intents.begin(), intents.end());
+
+            if( intents.size() > 1 ) {
+                unsigned long long rawBytes = 0;
+                for( size_t i = 0; i < intents.size(); i++ )
+                    rawBytes += intents[i].length();
+
+                // merge in place.  WriteIntent::overlaps is inclusive of the
+                // endpoints so exactly adjacent ranges coalesce too.
+                size_t out = 0;
+                for( size_t in = 1; in < intents.size(); in++ ) {
+                    if( intents[in].start() <= intents[out].end() )
+                        intents[out].absorb(intents[in]);
+                    else
+                        intents[++out] = intents[in];
+                }
+                intents.resize(out + 1);
+
+                unsigned long long mergedBytes = 0;
+                for( size_t i = 0; i < intents.size(); i++ )
+                    mergedBytes += intents[i].length();
+                stats.curr->_intentsCoalescedBytes += rawBytes - mergedBytes;
+            }
+
+            return intents;
+        }
+
         void CommitJob::note(void* p, int len) {
             SimpleMutex::scoped_lock lk(groupCommitMutex);
             _hasWritten = true;
@@ -154,6 +154,10 @@ namespace mongo {
         public:
             /** these called by the groupCommit code as it goes along */
             void commitingBegin();
+            /** the epoch recorded by the last commitingBegin().  the pipelined journal
+                writer captures this so it can acknowledge the right commit even if a
+                subsequent commitingBegin() has already bumped the member. */
+            NotifyAll::When commitNumber() const { return _commitNumber; }
             /** the commit code calls this when data reaches the journal (on disk) */
             void committingNotifyCommitted() { 
                 groupCommitMutex.dassertLocked();
@@ -169,14 +173,13 @@ namespace mongo {
             /** we check how much written and if it is getting to be a lot, we commit sooner. */
             size_t bytes() const { return _bytes; }
 
-            /** used in prepbasicwrites. sorted so that overlapping and duplicate items 
-             * can be merged.  we sort here so the caller receives something they must 
-             * keep const from their pov. */
-            const std::vector<WriteIntent>& getIntentsSorted() {
-                groupCommitMutex.dassertLocked();
-                sort(_intentsAndDurOps._intents.begin(), _intentsAndDurOps._intents.end());
-                return _intentsAndDurOps._intents;
-            }
+            /** used in prepbasicwrites. sorted by memory location, with overlapping,
+             * duplicate and adjacent intents merged into single ranges so PREPLOGBUFFER
+             * copies each byte once.  repeated writes to the same document in a group
+             * commit window otherwise journal the same region several times over.
+             * bytes saved by the merge are recorded in stats (intentsCoalescedMB).
+             * the caller must keep the result const from their pov. */
+            const std::vector<WriteIntent>& getIntentsCoalesced();
 
             bool _hasWritten;
 
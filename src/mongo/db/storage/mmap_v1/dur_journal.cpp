@@ -38,16 +38,20 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/storage/mmap_v1/dur_journalcodec.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cpu_features.h"
 #include "mongo/platform/random.h"
 #include "mongo/server.h"
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
 #include "mongo/util/logfile.h"
@@ -99,6 +103,18 @@ namespace mongo {
 
         bool usingPreallocate = false;
 
+        // incremented for the duration of a hot backup; while nonzero, rotation keeps
+        // old journal files around so the backup can copy the whole sequence
+        AtomicUInt32 oldJournalFilePins;
+
+        void pinOldJournalFiles() {
+            oldJournalFilePins.fetchAndAdd(1);
+        }
+
+        void unpinOldJournalFiles() {
+            oldJournalFilePins.fetchAndSubtract(1);
+        }
+
         void removeOldJournalFile(boost::filesystem::path p);
 
         boost::filesystem::path getJournalDir() {
@@ -134,19 +150,39 @@ namespace mongo {
             magic[0] = magic[1] = magic[2] = magic[3] = '\n';
 
             Checksum c;
-            c.gen(begin, (unsigned) len);
+            if( ProcessorFeatures::hasSse42() )
+                c.genCrc32c(begin, (unsigned) len); // hardware crc32 instruction
+            else
+                c.gen(begin, (unsigned) len);
             memcpy(hash, c.bytes, sizeof(hash));
         }
 
         bool JSectFooter::checkHash(const void* begin, int len) const {
-            if( !magicOk() ) { 
+            if( !magicOk() ) {
                 log() << "journal footer not valid" << endl;
                 return false;
             }
+            // the footer carries whichever checksum format the writing process chose
+            // (see JSectFooter constructor); a journal file may have been written on a
+            // different machine than the one recovering it, so accept either format.
+            // the format tag tells us which to try first; on a mismatch we fall back
+            // to the other before declaring the section bad.
+            unsigned long long storedTag;
+            memcpy(&storedTag, hash + 8, sizeof(storedTag));
+            const bool crcFirst = storedTag == Checksum::crc32cFormatTag;
             Checksum c;
-            c.gen(begin, len);
+            if( crcFirst )
+                c.genCrc32c(begin, (unsigned) len);
+            else
+                c.gen(begin, (unsigned) len);
             DEV log() << "checkHash len:" << len << " hash:" << toHex(hash, 16) << " current:" << toHex(c.bytes, 16) << endl;
-            if( memcmp(hash, c.bytes, sizeof(hash)) == 0 ) 
+            if( memcmp(hash, c.bytes, sizeof(hash)) == 0 )
+                return true;
+            if( crcFirst )
+                c.gen(begin, (unsigned) len);
+            else
+                c.genCrc32c(begin, (unsigned) len);
+            if( memcmp(hash, c.bytes, sizeof(hash)) == 0 )
                 return true;
             log() << "journal checkHash mismatch, got: " << toHex(c.bytes, 16) << " expected: " << toHex(hash,16) << endl;
             return false;
@@ -669,6 +705,10 @@ namespace mongo {
             be in _curLogFileMutex but not dbMutex when calling
         */
         void Journal::removeUnneededJournalFiles() {
+            if( oldJournalFilePins.load() > 0 ) {
+                // a hot backup is copying the journal sequence; keep everything
+                return;
+            }
             while( !_oldJournalFiles.empty() ) {
                 JFile f = _oldJournalFiles.front();
 
@@ -730,16 +770,38 @@ namespace mongo {
             j.journal(h, uncompressed);
             stats.curr->_writeToJournalMicros += t.micros();
         }
+        // Pieces of the uncompressed commit buffer this large are compressed as
+        // independent blocks, so a big group commit can use all the compression
+        // workers at once.  Must not change without bumping JHeader::CurrentVersion.
+        const unsigned JournalBlockSize = 4 * 1024 * 1024;
+
+        // Number of threads compressing journal blocks.  Only the durability thread
+        // schedules work here, one section at a time.
+        const int NumJournalCompressionWorkers = 3;
+
+        static void compressJournalBlock(const JournalCodec* codec,
+                                         const char* in,
+                                         size_t inLen,
+                                         char* out,
+                                         size_t* outLen) {
+            codec->compress(in, inLen, out, outLen);
+        }
+
         void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             RACECHECK
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
                JSectHeader
-               compressed operations
+               compressed operations, framed into blocks (see dur_journalformat.h)
                JSectFooter
             */
+            const JournalCodec* codec = journalCodec();
+            const unsigned numBlocks =
+                (uncompressed.len() + JournalBlockSize - 1) / JournalBlockSize;
             const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
-            const unsigned max = maxCompressedLength(uncompressed.len()) + headTailSize;
+            const unsigned frameSize = (2 + 2 * numBlocks) * sizeof(unsigned);
+            const unsigned max =
+                numBlocks * codec->maxCompressedLength(JournalBlockSize) + frameSize + headTailSize;
             b.reset(max);
 
             {
@@ -747,11 +809,49 @@ namespace mongo {
                 b.appendStruct(h);
             }
 
-            size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
-            verify( compressedLength < 0xffffffff );
-            verify( compressedLength < max );
-            b.skip(compressedLength);
+            b.appendNum( (unsigned) codec->id() );
+            b.appendNum( numBlocks );
+
+            // scratch space for the compressed blocks, reused across commits
+            static vector<string> blockScratch;
+            if( blockScratch.size() < numBlocks )
+                blockScratch.resize(numBlocks);
+            static vector<size_t> blockCompressedLens;
+            blockCompressedLens.resize(numBlocks);
+
+            if( numBlocks <= 1 ) {
+                // not worth a trip through the worker pool
+                for( unsigned i = 0; i < numBlocks; i++ ) {
+                    blockScratch[i].resize( codec->maxCompressedLength(uncompressed.len()) );
+                    codec->compress(uncompressed.buf(), uncompressed.len(),
+                                    &blockScratch[i][0], &blockCompressedLens[i]);
+                }
+            }
+            else {
+                static ThreadPool compressionPool(NumJournalCompressionWorkers);
+                for( unsigned i = 0; i < numBlocks; i++ ) {
+                    const unsigned ofs = i * JournalBlockSize;
+                    const unsigned blockLen = std::min(JournalBlockSize, uncompressed.len() - ofs);
+                    blockScratch[i].resize( codec->maxCompressedLength(blockLen) );
+                    compressionPool.schedule(compressJournalBlock,
+                                             codec,
+                                             uncompressed.buf() + ofs,
+                                             (size_t) blockLen,
+                                             &blockScratch[i][0],
+                                             &blockCompressedLens[i]);
+                }
+                compressionPool.join();
+            }
+
+            for( unsigned i = 0; i < numBlocks; i++ ) {
+                const unsigned ofs = i * JournalBlockSize;
+                const unsigned blockLen = std::min(JournalBlockSize, uncompressed.len() - ofs);
+                verify( blockCompressedLens[i] <= blockScratch[i].size() );
+                b.appendNum( blockLen );
+                b.appendNum( (unsigned) blockCompressedLens[i] );
+                b.appendBuf( blockScratch[i].data(), blockCompressedLens[i] );
+            }
+            verify( b.len() < max );
 
             // footer
             unsigned L = 0xffffffff;
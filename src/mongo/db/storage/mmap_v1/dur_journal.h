@@ -46,6 +46,13 @@ namespace mongo {
         */
         void journalCleanup(bool log = false);
 
+        /** while pinned, journal files are retained at rotation instead of being removed,
+            so a hot backup can copy a journal sequence that covers the whole window in
+            which it read the data files.  counted; pins may nest.
+        */
+        void pinOldJournalFiles();
+        void unpinOldJournalFiles();
+
         /** assure journal/ dir exists. throws */
         void journalMakeDir();
 
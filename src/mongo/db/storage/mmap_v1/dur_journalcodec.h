@@ -0,0 +1,124 @@
+// @file dur_journalcodec.h compression codecs for journal section payloads
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "mongo/util/compress.h"
+
+namespace mongo {
+
+    namespace dur {
+
+        /** A compression codec for the blocks inside a journal section.
+
+            The id of the codec that compressed a section is recorded at the front
+            of the section payload (see the journal file version notes in
+            dur_journalformat.h), so recovery can pick the matching codec even if
+            the server default changes between runs.  Implementations must be
+            stateless and callable from several threads at once -- the journal
+            writer compresses the blocks of a large section on a worker pool.
+        */
+        class JournalCodec {
+        public:
+            virtual ~JournalCodec() { }
+
+            /** Stable identifier written into the journal.  Never reuse a retired id. */
+            virtual unsigned id() const = 0;
+
+            /** Human readable name, for log messages. */
+            virtual const char* name() const = 0;
+
+            /** An upper bound on the compressed size of 'sourceLen' input bytes. */
+            virtual size_t maxCompressedLength(size_t sourceLen) const = 0;
+
+            /** Compress [input, input+inputLen) into 'compressed', which must have room
+                for maxCompressedLength(inputLen) bytes.  Sets *compressedLength.
+            */
+            virtual void compress(const char* input,
+                                  size_t inputLen,
+                                  char* compressed,
+                                  size_t* compressedLength) const = 0;
+
+            /** @return false if 'compressed' does not decode cleanly. */
+            virtual bool uncompress(const char* compressed,
+                                    size_t compressedLen,
+                                    std::string* uncompressed) const = 0;
+        };
+
+        class SnappyJournalCodec : public JournalCodec {
+        public:
+            enum { Id = 0 };
+
+            virtual unsigned id() const { return Id; }
+
+            virtual const char* name() const { return "snappy"; }
+
+            virtual size_t maxCompressedLength(size_t sourceLen) const {
+                return mongo::maxCompressedLength(sourceLen);
+            }
+
+            virtual void compress(const char* input,
+                                  size_t inputLen,
+                                  char* compressed,
+                                  size_t* compressedLength) const {
+                rawCompress(input, inputLen, compressed, compressedLength);
+            }
+
+            virtual bool uncompress(const char* compressed,
+                                    size_t compressedLen,
+                                    std::string* uncompressed) const {
+                return mongo::uncompress(compressed, compressedLen, uncompressed);
+            }
+        };
+
+        /** Look up a codec by the id recorded in a journal section.
+            @return NULL if the id is unknown to this build.
+        */
+        inline JournalCodec* journalCodecById(unsigned id) {
+            static SnappyJournalCodec snappy;
+            switch (id) {
+            case SnappyJournalCodec::Id:
+                return &snappy;
+            default:
+                return NULL;
+            }
+        }
+
+        /** The codec new journal sections are written with. */
+        inline JournalCodec* journalCodec() {
+            return journalCodecById(SnappyJournalCodec::Id);
+        }
+
+    }
+
+}
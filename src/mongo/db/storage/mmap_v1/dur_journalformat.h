@@ -53,10 +53,26 @@ namespace mongo {
 
             // x4142 is asci--readable if you look at the file with head/less -- thus the starting values were near
             // that.  simply incrementing the version # is safe on a fwd basis.
+            //
+            // 0x4149 : the section payload is a single compressed (snappy) stream.
+            // 0x414a : the payload is framed into independently compressed blocks so they can be
+            //          compressed in parallel:
+            //            unsigned codecId     which JournalCodec compressed the blocks
+            //            unsigned numBlocks
+            //            numBlocks * { unsigned uncompressedLen;
+            //                          unsigned compressedLen;
+            //                          <compressedLen bytes> }
+            //          recovery concatenates the uncompressed blocks to rebuild the section.
+            // 0x414b : (and 0x414c for _NOCOMPRESS builds) section footers may carry the
+            //          crc32c-based checksum format instead of the legacy one, depending on
+            //          the cpu of the writing process -- see util/checksum.h.  layout is
+            //          otherwise unchanged from 0x4148/0x414a; the bump is so that older
+            //          binaries, which would report the new footers as corruption, refuse
+            //          the file with a clear version message instead.
 #if defined(_NOCOMPRESS)
-            enum { CurrentVersion = 0x4148 };
+            enum { CurrentVersion = 0x414c };
 #else
-            enum { CurrentVersion = 0x4149 };
+            enum { CurrentVersion = 0x414b };
 #endif
             unsigned short _version;
 
@@ -108,6 +124,7 @@ namespace mongo {
                 OpCode_DbContext   = 0xfffffffe,
                 OpCode_FileCreated = 0xfffffffd,
                 OpCode_DropDb      = 0xfffffffc,
+                OpCode_MicroWrites = 0xfffffffb,
                 OpCode_Min         = 0xfffff000
             };
             union {
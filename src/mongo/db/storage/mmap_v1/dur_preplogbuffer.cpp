@@ -38,11 +38,15 @@
 
 #include "mongo/pch.h"
 
+#include <map>
+
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
+#include "mongo/db/storage/mmap_v1/durop.h"
 #include "mongo/server.h"
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/mongoutils/str.h"
@@ -58,6 +62,16 @@ namespace mongo {
 
         RelativePath local = RelativePath::fromRelativePath("local");
 
+        // when set, sub-page write intents are batched per data file into MicroWritesOp
+        // journal records (5 bytes of header per write vs 12 for a JEntry).  off by
+        // default: journals containing OpCode_MicroWrites sections cannot be read by
+        // older builds.
+        MONGO_EXPORT_SERVER_PARAMETER(internalDurMicroWriteOps, bool, false);
+
+        // largest intent we divert into a MicroWritesOp.  counter and flag updates are
+        // far below this; beyond it the JEntry header overhead stops mattering.
+        static const unsigned kMicroWriteMaxBytes = 64;
+
         static DurableMappedFile* findMMF_inlock(void *ptr, size_t &ofs) {
             DurableMappedFile *f = privateViews.find_inlock(ptr, ofs);
             if( f == 0 ) {
@@ -94,6 +108,7 @@ namespace mongo {
 
             JEntry e;
             e.len = min(i->length(), (unsigned)(mmf->length() - ofs)); //don't write past end of file
+            mmf->noteDirtyPrivateBytes(e.len); // density signal for the incremental remap
             verify( ofs <= 0x80000000 );
             e.ofs = (unsigned) ofs;
             e.setFileNo( mmf->fileSuffixNo() );
@@ -125,9 +140,9 @@ namespace mongo {
             }
         }
 
-        /** basic write ops / write intents.  note there is no particular order to these : if we have
-            two writes to the same location during the group commit interval, it is likely
-            (although not assured) that it is journaled here once.
+        /** basic write ops / write intents.  the commit job hands us the intents
+            already sorted by memory location and coalesced, so two writes to the same
+            location during the group commit interval are journaled here once.
         */
         static void prepBasicWrites(AlignedBuilder& bb) {
             scoped_lock lk(privateViews._mutex());
@@ -136,7 +151,7 @@ namespace mongo {
             // switches will be rare as we sort by memory location first and we batch commit.
             RelativePath lastDbPath;
 
-            const vector<WriteIntent>& _intents = commitJob.getIntentsSorted();
+            const vector<WriteIntent>& _intents = commitJob.getIntentsCoalesced();
 
             // right now the durability code assumes there is at least one write intent
             // this does not have to be true in theory as i could just add or delete a file
@@ -144,20 +159,45 @@ namespace mongo {
             // until this can be addressed
             fassert( 17388, !_intents.empty() );
 
-            WriteIntent last;
-            for( vector<WriteIntent>::const_iterator i = _intents.begin(); i != _intents.end(); i++ ) { 
-                if( i->start() < last.end() ) { 
-                    // overlaps
-                    last.absorb(*i);
-                }
-                else { 
-                    // discontinuous
-                    if( i != _intents.begin() )
-                        prepBasicWrite_inlock(bb, &last, lastDbPath);
-                    last = *i;
+            // tiny intents are batched per data file into MicroWritesOp's, which journal
+            // just (ofs, len, bytes) instead of a full JEntry per write.  the intents are
+            // coalesced and non-overlapping, so segregating them from the basic writes
+            // does not reorder conflicting writes.
+            typedef map< pair<string,int>, shared_ptr<MicroWritesOp> > MicroBatches;
+            MicroBatches microBatches;
+            const bool micro = internalDurMicroWriteOps;
+
+            for( vector<WriteIntent>::const_iterator i = _intents.begin(); i != _intents.end(); i++ ) {
+                if( micro && (unsigned)i->length() <= kMicroWriteMaxBytes ) {
+                    size_t ofs = 1;
+                    DurableMappedFile *mmf = findMMF_inlock( i->start(), /*out*/ofs );
+                    if( ofs + i->length() <= mmf->length() ) {
+                        verify( ofs <= 0x80000000 );
+
+                        // the same bookkeeping prepBasicWrite_inlock would have done
+                        if( unlikely(!mmf->willNeedRemap()) ) {
+                            mmf->setWillNeedRemap();
+                        }
+                        mmf->noteDirtyPrivateBytes( i->length() );
+
+                        shared_ptr<MicroWritesOp>& op =
+                            microBatches[ make_pair( mmf->relativePath().toString(),
+                                                     mmf->fileSuffixNo() ) ];
+                        if( !op ) {
+                            op.reset( new MicroWritesOp( mmf->relativePath().toString(),
+                                                         mmf->fileSuffixNo() ) );
+                        }
+                        op->append( (unsigned) ofs, i->start(), i->length() );
+                        continue;
+                    }
+                    // straddles the end of the file -- let the basic path split it
                 }
+                prepBasicWrite_inlock(bb, &*i, lastDbPath);
+            }
+
+            for( MicroBatches::const_iterator i = microBatches.begin(); i != microBatches.end(); ++i ) {
+                i->second->serialize(bb);
             }
-            prepBasicWrite_inlock(bb, &last, lastDbPath);
         }
 
         static void resetLogBuffer(/*out*/JSectHeader& h, AlignedBuilder& bb) {
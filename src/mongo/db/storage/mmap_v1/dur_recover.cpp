@@ -43,16 +43,19 @@
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
+#include "mongo/db/storage/mmap_v1/dur_journalcodec.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/durop.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/db/structure/btree/bucket_verification.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
@@ -120,15 +123,41 @@ namespace mongo {
                 , _doDurOps(doDurOpsRecovering)
             {
                 verify( doDurOpsRecovering );
-                bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
-                if( !ok ) { 
-                    // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
-                    log() << "couldn't uncompress journal section" << endl;
-                    msgasserted(15874, "couldn't uncompress journal section");
-                }
-                const char *p = _uncompressed.c_str();
                 verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
-                _entries = auto_ptr<BufReader>( new BufReader(p, _uncompressed.size()) );
+
+                // the payload is framed into independently compressed blocks -- see the
+                // journal file version notes in dur_journalformat.h
+                BufReader br(compressed, compressedLen);
+                unsigned codecId;
+                br.read(codecId);
+                JournalCodec* codec = journalCodecById(codecId);
+                if( NULL == codec ) {
+                    log() << "unknown journal compression codec id " << codecId << endl;
+                    msgasserted(18524, "unknown journal compression codec id");
+                }
+
+                unsigned numBlocks;
+                br.read(numBlocks);
+                string block;
+                for( unsigned i = 0; i < numBlocks; i++ ) {
+                    unsigned rawLen;
+                    unsigned blockCompressedLen;
+                    br.read(rawLen);
+                    br.read(blockCompressedLen);
+                    massert(18525, "invalid journal block length",
+                            blockCompressedLen <= br.remaining());
+                    const char *data = (const char *) br.skip(blockCompressedLen);
+                    bool ok = codec->uncompress(data, blockCompressedLen, &block);
+                    if( !ok || block.size() != rawLen ) {
+                        // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
+                        log() << "couldn't uncompress journal section" << endl;
+                        msgasserted(15874, "couldn't uncompress journal section");
+                    }
+                    _uncompressed.append(block);
+                }
+
+                _entries = auto_ptr<BufReader>( new BufReader(_uncompressed.c_str(),
+                                                              _uncompressed.size()) );
             }
 
             // we work with the uncompressed buffer when doing a WRITETODATAFILES (for speed)
@@ -168,6 +197,15 @@ namespace mongo {
                         return;
                     }
 
+                    case JEntry::OpCode_MicroWrites: {
+                        e.dbName = 0;
+                        // micro writes carry data-file bytes, so unlike the ops above they
+                        // are applied during WRITETODATAFILES too, not just recovery --
+                        // no _doDurOps check here
+                        e.op = DurOp::read(lenOrOpCode, *_entries);
+                        return;
+                    }
+
                     case JEntry::OpCode_DbContext: {
                         _lastDbName = (const char*) _entries->pos();
                         const unsigned limit = std::min((unsigned)Namespace::MaxNsLenWithNUL,
@@ -281,12 +319,65 @@ namespace mongo {
                 void* dest = (char*)mmf->view_write() + entry.e->ofs;
                 memcpy(dest, entry.e->srcData(), entry.e->len);
                 stats.curr->_writeToDataFilesBytes += entry.e->len;
+                if (!_recovering) {
+                    // let the background flusher sync just this region later
+                    mmf->noteWriteToDataFile(entry.e->ofs, entry.e->len);
+                }
             }
             else {
                 massert(13622, "Trying to write past end of file in WRITETODATAFILES", _recovering);
             }
         }
 
+        void RecoveryJob::applyMicroWrites(const std::string& dbPath, int fileNo,
+                                           const vector< pair<unsigned, string> >& records) {
+            // processSection() holds _mx and LockMongoFilesShared for us
+            verify( !dbPath.empty() );
+            verify( dbPath.size() < MaxDatabaseNameLen );
+
+            const string fn = fileName(dbPath.c_str(), fileNo);
+            MongoFile* file;
+            {
+                MongoFileFinder finder; // must release lock before creating new DurableMappedFile
+                file = finder.findByPath(fn);
+            }
+
+            DurableMappedFile* mmf;
+            if (file) {
+                verify(file->isDurableMappedFile());
+                mmf = (DurableMappedFile*)file;
+            }
+            else {
+                if( !_recovering ) {
+                    log() << "journal error applying micro writes, file " << fn << " is not open" << endl;
+                    verify(false);
+                }
+                boost::shared_ptr<DurableMappedFile> sp (new DurableMappedFile);
+                verify(sp->open(fn, false));
+                _mmfs.push_back(sp);
+                mmf = sp.get();
+            }
+
+            verify(mmf->view_write());
+            for( vector< pair<unsigned, string> >::const_iterator i = records.begin();
+                    i != records.end(); ++i ) {
+                const unsigned ofs = i->first;
+                const string& data = i->second;
+
+                if (ofs + data.size() <= mmf->length()) {
+                    memcpy((char*)mmf->view_write() + ofs, data.data(), data.size());
+                    stats.curr->_writeToDataFilesBytes += data.size();
+                    if (!_recovering) {
+                        // let the background flusher sync just this region later
+                        mmf->noteWriteToDataFile(ofs, data.size());
+                    }
+                }
+                else {
+                    massert(18559, "Trying to write micro record past end of file in WRITETODATAFILES", _recovering);
+                }
+            }
+        }
+
         void RecoveryJob::applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump) {
             if( entry.e ) {
                 if( dump ) {
@@ -348,6 +439,35 @@ namespace mongo {
             return mmf;
         }
 
+        /** shard worker task -- just the copy.  the target pointer was fully resolved
+            and bounds checked on the parsing thread, so the workers never touch file
+            lookup or locking. */
+        static void applyShardWrite(char* dest, const char* src, unsigned len) {
+            memcpy(dest, src, len);
+        }
+
+        void RecoveryJob::startApplyShards() {
+            unsigned n = ProcessInfo().getNumCores();
+            if( n > 8 )
+                n = 8; // recovery is disk bound well before this
+            if( n < 2 )
+                return; // applyEntries falls back to serial application
+            for( unsigned i = 0; i < n; i++ ) {
+                _applyShards.push_back(boost::shared_ptr<ThreadPool>(new ThreadPool(1)));
+            }
+        }
+
+        void RecoveryJob::drainApplyShards() {
+            for( unsigned i = 0; i < _applyShards.size(); i++ ) {
+                _applyShards[i]->join();
+            }
+        }
+
+        void RecoveryJob::stopApplyShards() {
+            drainApplyShards();
+            _applyShards.clear();
+        }
+
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (storageGlobalParams.durOptions &
                           StorageGlobalParams::DurScanOnly) == 0;
@@ -356,9 +476,53 @@ namespace mongo {
             if( dump )
                 log() << "BEGIN section" << endl;
 
+            // during recovery we shard basic writes over the worker pools by target
+            // datafile; writes to distinct datafiles are independent, and per-file
+            // ordering holds because a given mapped file always hashes to the same
+            // shard and each shard queue is FIFO
+            const bool parallel = _recovering && apply && !dump && !_applyShards.empty();
+
             Last last;
             for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
-                applyEntry(last, *i, apply, dump);
+                if( parallel && i->e ) {
+                    const ParsedJournalEntry& entry = *i;
+                    verify(entry.dbName);
+                    verify((size_t)strnlen(entry.dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+
+                    // resolve the target file here on the parsing thread (may open it,
+                    // which mutates _mmfs); the worker only gets a memcpy
+                    DurableMappedFile *mmf = last.newEntry(entry, *this);
+                    if ((entry.e->ofs + entry.e->len) <= mmf->length()) {
+                        verify(mmf->view_write());
+                        verify(entry.e->srcData());
+                        char* dest = (char*)mmf->view_write() + entry.e->ofs;
+                        stats.curr->_writeToDataFilesBytes += entry.e->len;
+                        const size_t shard = (size_t(mmf) >> 4) % _applyShards.size();
+                        _applyShards[shard]->schedule(applyShardWrite,
+                                                      dest,
+                                                      (const char*) entry.e->srcData(),
+                                                      (unsigned) entry.e->len);
+                    }
+                    else {
+                        massert(18574, "Trying to write past end of file in WRITETODATAFILES", _recovering);
+                    }
+                }
+                else {
+                    if( parallel && i->op ) {
+                        // DurOps (file create, drop db, micro writes) touch files
+                        // themselves; all outstanding shard writes must land first
+                        drainApplyShards();
+                    }
+                    applyEntry(last, *i, apply, dump);
+                }
+            }
+
+            if( parallel ) {
+                // the queued writes point into this section's (decompressed) buffers,
+                // which the caller releases when it moves on; they must all land now.
+                // this is also what keeps successive sections ordered per file even if
+                // a datafile is closed and remapped in between.
+                drainApplyShards();
             }
 
             if( dump )
@@ -483,6 +647,7 @@ namespace mongo {
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
                     processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+                    noteSectionProgress(h.sectionLenWithPadding());
 
                     // ctrl c check
                     uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
@@ -497,6 +662,29 @@ namespace mongo {
             return false; // non-abrupt end
         }
 
+        /** log how far along recovery is, with a rough time remaining estimate, so ops
+            watching a long recovery can see that it is making headway */
+        void RecoveryJob::noteSectionProgress(unsigned bytes) {
+            _recoverDoneBytes += bytes;
+            if( _recoverTotalBytes == 0 )
+                return;
+            int pct = (int)(_recoverDoneBytes * 100 / _recoverTotalBytes);
+            if( pct > 100 )
+                pct = 100;
+            if( pct / 10 <= _lastProgressPct / 10 ) // one line per 10%
+                return;
+            _lastProgressPct = pct;
+            stringstream ss;
+            ss << "recover progress: " << pct << "% ("
+               << (_recoverDoneBytes / 1024 / 1024) << "MB/"
+               << (_recoverTotalBytes / 1024 / 1024) << "MB journal)";
+            const int secs = _recoverTimer.seconds();
+            if( secs > 0 && pct > 0 && pct < 100 ) {
+                ss << ", " << (long long) secs * (100 - pct) / pct << " secs remaining (est)";
+            }
+            log() << ss.str() << endl;
+        }
+
         /** apply a specific journal file */
         bool RecoveryJob::processFile(boost::filesystem::path journalfile) {
             log() << "recover " << journalfile.string() << endl;
@@ -527,15 +715,37 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+            // total journal size, for progress reporting as sections are replayed
+            _recoverTotalBytes = 0;
+            for( unsigned i = 0; i != files.size(); ++i ) {
+                try {
+                    _recoverTotalBytes += boost::filesystem::file_size(files[i].string());
+                }
+                catch(...) {
+                    // processFile will complain about this file; don't also fail here
+                }
+            }
+            _recoverDoneBytes = 0;
+            _lastProgressPct = 0;
+            _recoverTimer.reset();
+
+            startApplyShards();
+            if( !_applyShards.empty() ) {
+                log() << "recover applying writes with " << _applyShards.size()
+                      << " threads" << endl;
+            }
+
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
                 if( abruptEnd && i+1 < files.size() ) {
                     log() << "recover error: abrupt end to file " << files[i].string() << ", yet it isn't the last journal file" << endl;
+                    stopApplyShards();
                     close();
                     uasserted(13535, "recover abrupt journal file end");
                 }
             }
 
+            stopApplyShards();
             close();
 
             if (storageGlobalParams.durOptions & StorageGlobalParams::DurScanOnly) {
@@ -547,6 +757,17 @@ namespace mongo {
             log() << "recover cleaning up" << endl;
             removeJournalFiles();
             log() << "recover done" << endl;
+
+            // Replay makes the files consistent with everything the journal knew about,
+            // but the crash may also have damaged something the journal never saw (a
+            // torn write that had already synced, a failing disk, ...).  Rather than
+            // asking operators to run a full offline validate out of paranoia, arm
+            // lazy bucket verification: every btree bucket is structurally checked on
+            // its first access, and a background sweep (db/btree_verify.cpp) finishes
+            // the job shortly after startup.
+            setBtreeVerificationNeeded();
+            log() << "recover btree bucket verification armed" << endl;
+
             okToCleanUp = true;
             _recovering = false;
         }
@@ -32,10 +32,15 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <list>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     class DurableMappedFile;
@@ -56,14 +61,24 @@ namespace mongo {
                 int fileNo;
             } last;        
         public:
-            RecoveryJob() : _lastDataSyncedFromLastRun(0), 
-                _mx("recovery"), _recovering(false) { _lastSeqMentionedInConsoleLog = 1; }
+            RecoveryJob() : _lastDataSyncedFromLastRun(0),
+                _mx("recovery"), _recovering(false),
+                _recoverTotalBytes(0), _recoverDoneBytes(0),
+                _lastProgressPct(0) { _lastSeqMentionedInConsoleLog = 1; }
             void go(std::vector<boost::filesystem::path>& files);
             ~RecoveryJob();
 
             /** @param data data between header and footer. compressed if recovering. */
             void processSection(const JSectHeader *h, const void *data, unsigned len, const JSectFooter *f);
 
+            /** apply one MicroWritesOp batch to a data file.  records are
+                (offset in file, bytes) pairs -- see MicroWritesOp in durop.h.
+                called from MicroWritesOp::replay() during both recovery and
+                WRITETODATAFILES, i.e. with _mx and LockMongoFilesShared held
+                by processSection(). */
+            void applyMicroWrites(const std::string& dbPath, int fileNo,
+                                  const std::vector< std::pair<unsigned, std::string> >& records);
+
             void close(); // locks and calls _close()
 
             static RecoveryJob & get() { return _instance; }
@@ -85,6 +100,21 @@ namespace mongo {
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
 
+            /** write application during recovery is sharded over single threaded pools,
+                one per shard; writes to the same datafile always go to the same shard
+                so per-file ordering is preserved.  see applyEntries(). */
+            std::vector<boost::shared_ptr<ThreadPool> > _applyShards;
+            void startApplyShards();
+            void drainApplyShards(); // barrier: blocks until all queued writes land
+            void stopApplyShards();
+
+            // progress reporting for the recovery log
+            unsigned long long _recoverTotalBytes;
+            unsigned long long _recoverDoneBytes;
+            int _lastProgressPct;
+            Timer _recoverTimer;
+            void noteSectionProgress(unsigned bytes);
+
             static RecoveryJob &_instance;
         };
     }
@@ -49,6 +49,9 @@ namespace mongo {
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
                 unsigned long long _journaledBytes;
                 unsigned long long _uncompressedBytes;
+                // bytes of overlapping/duplicate/adjacent write intent ranges merged
+                // away before journaling (see CommitJob::getIntentsCoalesced)
+                unsigned long long _intentsCoalescedBytes;
                 unsigned long long _writeToDataFilesBytes;
 
                 long long _prepLogBufferMicros;
@@ -63,6 +66,11 @@ namespace mongo {
                 // - data being written faster than the normal group commit interval
                 unsigned _commitsInWriteLock;
 
+                // histogram of j:true waiters acknowledged per group commit;
+                // buckets are 0, 1, 2-3, 4-7, 8-15 and 16+ waiters.  shows how
+                // well the adaptive commit window batches journal syncs.
+                unsigned _commitBatchHisto[6];
+
                 int _dtMillis;
             };
             S *curr;
@@ -37,10 +37,17 @@
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 
 
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/log.h"
 
 using namespace mongoutils;
@@ -49,10 +56,134 @@ namespace mongo {
 
     MONGO_LOG_DEFAULT_TAG_FILE(::mongo::logger::LogTag::kStorage);
 
+    // When set, newly mapped datafile views get an MPOL_INTERLEAVE policy so their
+    // pages fault in round robin across NUMA nodes instead of piling up on whichever
+    // node first touches them.  An in-process alternative to running the whole
+    // server under numactl --interleave=all.  Linux only; elsewhere it warns once
+    // and is otherwise a no-op.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaInterleaveDataFileViews, bool, false);
+
+    namespace {
+        void interleaveView(void* view, unsigned long long len, const std::string& filename) {
+            if (numautil::interleaveMemory(view, (size_t)len)) {
+                LOG(2) << "numa: interleaved mapped view of " << filename << endl;
+                return;
+            }
+            static bool warned = false;
+            if (!warned) {
+                warned = true;
+                warning() << "numaInterleaveDataFileViews: could not set interleave policy "
+                          << "on mapped view of " << filename
+                          << " (no NUMA support on this platform?)" << endl;
+            }
+        }
+
+        /** cross-node page residency for this process, from /proc/self/numa_maps.
+            off by default -- reading numa_maps walks our page tables, which with
+            large datafile views is too expensive for every serverStatus call.
+        */
+        class NumaSSS : public ServerStatusSection {
+        public:
+            NumaSSS() : ServerStatusSection( "numa" ){}
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                std::map<int, long long> pagesPerNode;
+                if (!numautil::pageResidencyByNode(&pagesPerNode))
+                    return BSONObj();
+                BSONObjBuilder b;
+                b.appendBool("interleavedViews", numaInterleaveDataFileViews);
+                long long total = 0;
+                BSONObjBuilder nodes(b.subobjStart("pagesPerNode"));
+                for (std::map<int, long long>::const_iterator it = pagesPerNode.begin();
+                     it != pagesPerNode.end(); ++it) {
+                    const std::string fieldName = str::stream() << "node" << it->first;
+                    nodes.appendNumber(fieldName, it->second);
+                    total += it->second;
+                }
+                nodes.done();
+                b.appendNumber("totalPages", total);
+                return b.obj();
+            }
+        } numaSSS;
+    }
+
+    namespace {
+        // granularity of the shared-view dirty bookkeeping.  coarse on purpose:
+        // the set stays tiny and adjacent writes coalesce into one msync.
+        const unsigned long long kDirtyChunkBytes = 2 * 1024 * 1024;
+
+        class NullFlushable : public MongoFile::Flushable {
+        public:
+            void flush() { }
+        };
+    }
+
+    void DurableMappedFile::noteWriteToDataFile(unsigned long long ofs, unsigned len) {
+        if( len == 0 )
+            return;
+        const unsigned first = (unsigned)(ofs / kDirtyChunkBytes);
+        const unsigned last = (unsigned)((ofs + len - 1) / kDirtyChunkBytes);
+        SimpleMutex::scoped_lock lk(_dirtyWriteChunksMutex);
+        for( unsigned c = first; c <= last; c++ )
+            _dirtyWriteChunks.insert(c);
+    }
+
+    MongoFile::Flushable* DurableMappedFile::prepareDirtyFlush() {
+#if defined(_WIN32)
+        // the windows flushable has its own view/remap machinery; not worth forking it
+        return prepareFlush();
+#else
+        if( !storageGlobalParams.dur ) {
+            // without journaling there is no WRITETODATAFILES feeding the bookkeeping,
+            // so the only safe answer is everything
+            return prepareFlush();
+        }
+
+        std::set<unsigned> chunks;
+        {
+            SimpleMutex::scoped_lock lk(_dirtyWriteChunksMutex);
+            chunks.swap(_dirtyWriteChunks);
+        }
+
+        if( chunks.empty() )
+            return new NullFlushable();
+
+        const unsigned long long fileLen = length();
+        if( chunks.size() * kDirtyChunkBytes * 2 >= fileLen ) {
+            // mostly dirty - one big msync beats many small ones
+            return prepareFlush();
+        }
+
+        // coalesce consecutive chunks into ascending (offset, length) ranges
+        std::vector< std::pair<size_t, size_t> > ranges;
+        std::set<unsigned>::const_iterator it = chunks.begin();
+        while( it != chunks.end() ) {
+            unsigned start = *it;
+            unsigned end = start;
+            ++it;
+            while( it != chunks.end() && *it == end + 1 ) {
+                end = *it;
+                ++it;
+            }
+            unsigned long long ofs = (unsigned long long)start * kDirtyChunkBytes;
+            if( ofs >= fileLen )
+                continue;
+            unsigned long long len = (unsigned long long)(end - start + 1) * kDirtyChunkBytes;
+            if( ofs + len > fileLen )
+                len = fileLen - ofs;
+            ranges.push_back( std::make_pair( (size_t)ofs, (size_t)len ) );
+        }
+        return prepareRangesFlush( ranges );
+#endif
+    }
+
     void DurableMappedFile::remapThePrivateView() {
         verify(storageGlobalParams.dur);
 
         _willNeedRemap = false;
+        _dirtyPrivateViewBytes = 0;
+        _remapSkips = 0;
 
         // todo 1.9 : it turns out we require that we always remap to the same address.
         // so the remove / add isn't necessary and can be removed?
@@ -159,6 +290,10 @@ namespace mongo {
     bool DurableMappedFile::finishOpening() {
         LOG(3) << "mmf finishOpening " << (void*) _view_write << ' ' << filename() << " len:" << length() << endl;
         if( _view_write ) {
+            // apply placement policy before anything faults the view in
+            if (numaInterleaveDataFileViews) {
+                interleaveView(_view_write, length(), filename());
+            }
             if (storageGlobalParams.dur) {
                 _view_private = createPrivateMap();
                 if( _view_private == 0 ) {
@@ -174,7 +309,9 @@ namespace mongo {
         return false;
     }
 
-    DurableMappedFile::DurableMappedFile() : _willNeedRemap(false) {
+    DurableMappedFile::DurableMappedFile()
+        : _willNeedRemap(false), _dirtyPrivateViewBytes(0), _remapSkips(0),
+          _dirtyWriteChunksMutex("dirtyWriteChunks") {
         _view_write = _view_private = 0;
     }
 
@@ -31,6 +31,9 @@
 
 #pragma once
 
+#include <set>
+
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/paths.h"
 
@@ -95,18 +98,44 @@ namespace mongo {
         bool willNeedRemap() { return _willNeedRemap; }
         void setWillNeedRemap() { _willNeedRemap = true; }
 
+        /** bytes journaled against our private view since the last remap.  a cheap
+            write-density signal for the incremental remap policy in dur.cpp.  bumped in
+            PREPLOGBUFFER and reset in REMAPPRIVATEVIEW, both inside the commit machinery,
+            so no synchronization needed. */
+        unsigned long long dirtyPrivateViewBytes() const { return _dirtyPrivateViewBytes; }
+        void noteDirtyPrivateBytes(unsigned long long bytes) { _dirtyPrivateViewBytes += bytes; }
+
+        /** how many times REMAPPRIVATEVIEW has passed us over for being barely dirty */
+        int remapSkips() const { return _remapSkips; }
+        void noteRemapSkip() { _remapSkips++; }
+
+        /** record that WRITETODATAFILES wrote [ofs, ofs+len) of our shared view, so
+            the background flusher can sync only the dirty regions.  called from the
+            journal write-back path; threadsafe. */
+        void noteWriteToDataFile(unsigned long long ofs, unsigned len);
+
         void remapThePrivateView();
 
         virtual bool isDurableMappedFile() { return true; }
 
+    protected:
+        /** flush only the chunks noted by noteWriteToDataFile(); falls back to a full
+            flush when the bookkeeping can't be trusted (journaling off, windows) */
+        virtual Flushable* prepareDirtyFlush();
+
     private:
 
         void *_view_write;
         void *_view_private;
         bool _willNeedRemap;
+        unsigned long long _dirtyPrivateViewBytes;
+        int _remapSkips;
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
+        SimpleMutex _dirtyWriteChunksMutex;
+        std::set<unsigned> _dirtyWriteChunks; // 2MB chunks of the shared view written since the last dirty flush
+
         void setPath(const std::string& pathAndFileName);
         bool finishOpening();
     };
@@ -34,6 +34,7 @@
 
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/repair_database.h"
+#include "mongo/db/storage/mmap_v1/dur_recover.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/file.h"
@@ -63,6 +64,9 @@ namespace mongo {
             case JEntry::OpCode_DropDb:
                 op = shared_ptr<DurOp>( new DropDbOp(br) );
                 break;
+            case JEntry::OpCode_MicroWrites:
+                op = shared_ptr<DurOp>( new MicroWritesOp(br) );
+                break;
             default:
                 massert(13546, (str::stream() << "journal recover: unrecognized opcode in journal " << opcode), false);
             }
@@ -96,6 +100,53 @@ namespace mongo {
             _deleteDataFiles(_db);
         }
 
+        MicroWritesOp::MicroWritesOp(BufReader& log) : DurOp(JEntry::OpCode_MicroWrites) {
+            unsigned long long reserved;
+            log.read(reserved);
+            log.read(reserved);
+            log.readStr(_dbPath);
+            log.read(_fileNo);
+            unsigned n;
+            log.read(n);
+            _records.reserve(n);
+            for( unsigned i = 0; i < n; i++ ) {
+                unsigned ofs;
+                log.read(ofs);
+                unsigned char len;
+                log.read(len);
+                const char *data = (const char *) log.skip(len);
+                _records.push_back( Record(ofs, string(data, len)) );
+            }
+        }
+
+        void MicroWritesOp::append(unsigned ofs, const void* src, unsigned len) {
+            dassert( len <= 255 ); // len is journaled as a single byte
+            _records.push_back( Record(ofs, string((const char *) src, len)) );
+        }
+
+        void MicroWritesOp::_serialize(AlignedBuilder& ab) {
+            ab.appendNum((unsigned long long) 0); // reserved for future use
+            ab.appendNum((unsigned long long) 0); // reserved for future use
+            ab.appendStr(_dbPath);
+            ab.appendNum(_fileNo);
+            ab.appendNum((unsigned) _records.size());
+            for( Records::const_iterator i = _records.begin(); i != _records.end(); ++i ) {
+                ab.appendNum(i->first);
+                ab.appendChar((char) i->second.size());
+                ab.appendBuf(i->second.data(), i->second.size());
+            }
+        }
+
+        /** throws */
+        void MicroWritesOp::replay() {
+            RecoveryJob::get().applyMicroWrites(_dbPath, _fileNo, _records);
+        }
+
+        string MicroWritesOp::toString() {
+            return str::stream() << "MicroWritesOp " << _dbPath << '.' << _fileNo
+                                 << " records:" << _records.size();
+        }
+
         FileCreatedOp::FileCreatedOp(const std::string& f, unsigned long long l) :
             DurOp(JEntry::OpCode_FileCreated) {
             _p = RelativePath::fromFullPath(f);
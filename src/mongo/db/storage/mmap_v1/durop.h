@@ -30,6 +30,10 @@
 
 #pragma once
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/paths.h"
@@ -101,6 +105,35 @@ namespace mongo {
             unsigned long long _len; // size of file, not length of name
         };
 
+        /** a batch of tiny data-file writes for one file, journaled without a full JEntry
+            header per write.  each record is just (ofs, len, bytes) -- 5 bytes of header
+            instead of JEntry's 12 -- so counter/flag updates journal close to the number
+            of bytes they actually change.
+
+            unlike the file ops above, this op carries data-file bytes, so it IS replayed
+            during the WRITETODATAFILES phase as well as during recovery.
+            @see JournalSectionIterator::next() in dur_recover.cpp
+        */
+        class MicroWritesOp : public DurOp {
+        public:
+            typedef std::pair<unsigned, std::string> Record; // (offset in file, bytes)
+            typedef std::vector<Record> Records;
+
+            MicroWritesOp(BufReader& log);
+            /** @param dbPath relative db path, same form JDbContext journals (no .suffix) */
+            MicroWritesOp(const std::string& dbPath, int fileNo) :
+                DurOp(JEntry::OpCode_MicroWrites), _dbPath(dbPath), _fileNo(fileNo) { }
+            void append(unsigned ofs, const void* src, unsigned len);
+            virtual void replay();
+            virtual std::string toString();
+        protected:
+            virtual void _serialize(AlignedBuilder& ab);
+        private:
+            std::string _dbPath;
+            int _fileNo;
+            Records _records;
+        };
+
         /** record drop of a database */
         class DropDbOp : public DurOp {
         public:
@@ -688,7 +688,8 @@ namespace mongo {
                                          entry->ordering(),
                                          entry->descriptor()->indexNamespace(),
                                          entry->descriptor()->version(),
-                                         &BtreeBasedAccessMethod::invalidateCursors));
+                                         &BtreeBasedAccessMethod::invalidateCursors,
+                                         entry->descriptor()->fillFactor()));
 
         if (IndexNames::HASHED == type)
             return new HashAccessMethod( entry, btree.release() );
@@ -34,9 +34,12 @@
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/db/storage_options.h"
+#include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_database_catalog_entry.h"
 #include "mongo/db/storage/mmap_v1/dur_recovery_unit.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -85,4 +88,110 @@ namespace mongo {
         return MongoFile::flushAll( sync );
     }
 
+    int MMAPV1Engine::flushDirtyFiles() {
+        return MongoFile::flushAllDirty();
+    }
+
+    namespace {
+
+        // at most one hot backup may be in progress at a time
+        SimpleMutex backupMutex( "MMAPV1Engine::backup" );
+        bool backupInProgress = false;
+
+        /**
+         * Backup cursor over a journaled mmapv1 dbpath.  Data files are listed
+         * first; the journal directory is enumerated only once the caller has
+         * consumed every data file, so the journal sequence copied last covers the
+         * entire window in which the data files were read.  Old journal files are
+         * pinned (retained at rotation) for the life of the cursor, and the lsn
+         * marker file is deliberately not listed: without it, startup recovery on
+         * the restored copy replays the whole retained journal sequence, which
+         * makes the fuzzy data file copies consistent again.
+         */
+        class MMAPV1BackupCursor : public StorageEngine::BackupCursor {
+        public:
+            MMAPV1BackupCursor( const std::vector<std::string>& dataFiles )
+                : _files( dataFiles ), _nextFile( 0 ), _journalListed( false ) {
+                dur::pinOldJournalFiles();
+            }
+
+            virtual ~MMAPV1BackupCursor() {
+                dur::unpinOldJournalFiles();
+                SimpleMutex::scoped_lock lk( backupMutex );
+                backupInProgress = false;
+            }
+
+            virtual bool more() {
+                if ( _nextFile < _files.size() )
+                    return true;
+                if ( !_journalListed ) {
+                    _listJournalFiles();
+                    _journalListed = true;
+                }
+                return _nextFile < _files.size();
+            }
+
+            virtual std::string next() {
+                invariant( more() );
+                return _files[_nextFile++];
+            }
+
+        private:
+            void _listJournalFiles() {
+                boost::filesystem::path journalDir( storageGlobalParams.dbpath );
+                journalDir /= "journal";
+                if ( !boost::filesystem::exists( journalDir ) )
+                    return;
+                for ( boost::filesystem::directory_iterator i( journalDir );
+                      i != boost::filesystem::directory_iterator();
+                      ++i ) {
+                    string fileName = boost::filesystem::path(*i).leaf().string();
+                    if ( fileName.compare( 0, 3, "j._" ) == 0 )
+                        _files.push_back( boost::filesystem::path(*i).string() );
+                }
+            }
+
+            std::vector<std::string> _files;
+            size_t _nextFile;
+            bool _journalListed;
+        };
+    }
+
+    StatusWith<StorageEngine::BackupCursor*> MMAPV1Engine::beginBackup() {
+        if ( !storageGlobalParams.dur ) {
+            return StatusWith<BackupCursor*>( ErrorCodes::IllegalOperation,
+                                              "hot backup requires journaling; "
+                                              "use fsync+lock instead" );
+        }
+
+        {
+            SimpleMutex::scoped_lock lk( backupMutex );
+            if ( backupInProgress ) {
+                return StatusWith<BackupCursor*>( ErrorCodes::LockBusy,
+                                                  "a hot backup is already in progress" );
+            }
+            backupInProgress = true;
+        }
+
+        // each database contributes its .ns file and its numbered data files
+        std::vector<std::string> dataFiles;
+        std::vector<std::string> dbs;
+        _listDatabases( storageGlobalParams.dbpath, &dbs );
+        for ( size_t i = 0; i < dbs.size(); i++ ) {
+            boost::filesystem::path dbDir( storageGlobalParams.dbpath );
+            if ( storageGlobalParams.directoryperdb )
+                dbDir /= dbs[i];
+            dataFiles.push_back( ( dbDir / ( dbs[i] + ".ns" ) ).string() );
+            for ( int n = 0; ; n++ ) {
+                std::string fileName = mongoutils::str::stream() << dbs[i] << "." << n;
+                boost::filesystem::path f = dbDir / fileName;
+                if ( !boost::filesystem::exists( f ) )
+                    break;
+                dataFiles.push_back( f.string() );
+            }
+        }
+
+        return StatusWith<BackupCursor*>( new MMAPV1BackupCursor( dataFiles ) );
+    }
+
 }
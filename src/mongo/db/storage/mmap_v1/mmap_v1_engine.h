@@ -41,12 +41,15 @@ namespace mongo {
         RecoveryUnit* newRecoveryUnit( OperationContext* opCtx );
         void listDatabases( std::vector<std::string>* out ) const;
         int flushAllFiles( bool sync );
+        int flushDirtyFiles();
 
         Status repairDatabase( OperationContext* tnx,
                                const std::string& dbName,
                                bool preserveClonedFilesOnFailure,
                                bool backupOriginalFiles );
 
+        StatusWith<BackupCursor*> beginBackup();
+
         DatabaseCatalogEntry* getDatabaseCatalogEntry( OperationContext* opCtx,
                                                        const StringData& db );
 
@@ -41,6 +41,8 @@
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/file_allocator.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -179,14 +181,32 @@ namespace mongo {
         return preallocateOnly ? 0 : p;
     }
 
+    // keep this many pre-zeroed spare files per database directory so that adding the
+    // next datafile is a rename instead of a synchronous zero-fill.  spares are sized
+    // from the last file added, which tracks the doubling growth progression.
+    // 0 (default) disables the pool.
+    MONGO_EXPORT_SERVER_PARAMETER( dataFileWarmPoolSize, int, 0 );
+
     DataFile* MmapV1ExtentManager::_addAFile( OperationContext* txn,
                                         int sizeNeeded,
                                         bool preallocateNextFile ) {
         DEV txn->lockState()->assertWriteLocked(_dbname);
         int n = (int) _files.size();
         DataFile *ret = getFile( txn, n, sizeNeeded );
-        if ( preallocateNextFile )
+        if ( preallocateNextFile ) {
             getFile( txn, numFiles() , 0, true ); // preallocate a file
+        }
+        else if ( dataFileWarmPoolSize > 0 && storageGlobalParams.prealloc ) {
+            // predict the next file's size the way DataFile::open will: double the
+            // file we just added, up to the cap
+            long nextSize = ret->getHeader()->fileLength;
+            if ( nextSize <= DataFile::maxSize() / 2 )
+                nextSize *= 2;
+            else
+                nextSize = DataFile::maxSize();
+            const string directory = fileName( n ).branch_path().string();
+            FileAllocator::get()->requestWarmSpare( directory, nextSize, dataFileWarmPoolSize );
+        }
         return ret;
     }
 
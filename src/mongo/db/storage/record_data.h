@@ -47,6 +47,14 @@ namespace mongo {
         RecordData(const char* data, int size, const boost::shared_array<char>& dataPtr)
             : _data(data), _size(size), _dataPtr(dataPtr) { }
 
+        /**
+         * Takes shared ownership of 'data' and points directly into it, so storage engines
+         * that already have the record bytes in a string can hand them over without an
+         * extra copy.
+         */
+        explicit RecordData(const boost::shared_ptr<std::string>& data)
+            : _data(data->data()), _size(data->size()), _dataPtr(), _dataStr(data) { }
+
         const char* data() const { return _data; }
 
         int size() const { return _size; }
@@ -54,7 +62,7 @@ namespace mongo {
         /**
          * Returns true if this owns its own memory, and false otherwise
          */
-        bool isOwned() const { return _dataPtr; }
+        bool isOwned() const { return _dataPtr || _dataStr; }
 
         // TODO eliminate double-copying
         BSONObj toBson() const { return isOwned() ? BSONObj(_data).getOwned() : BSONObj(_data); }
@@ -63,6 +71,7 @@ namespace mongo {
         const char* _data;
         int _size;
         const boost::shared_array<char> _dataPtr;
+        const boost::shared_ptr<std::string> _dataStr;
     };
 
 } // namespace mongo
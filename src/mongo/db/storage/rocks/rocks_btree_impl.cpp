@@ -176,6 +176,13 @@ namespace mongo {
                 _cached = false;
             }
 
+            long long countAndAdvance(const Cursor& end) {
+                // A tally of one per call is a valid partial result; rocksdb offers no
+                // bucket structure to count in bulk.
+                advance();
+                return 1;
+            }
+
             void savePosition() {
                 invariant( !"rocksdb cursor doesn't do saving yet" );
             }
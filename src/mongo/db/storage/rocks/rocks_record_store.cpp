@@ -73,12 +73,14 @@ namespace mongo {
     }
 
     RecordData RocksRecordStore::dataFor( const DiskLoc& loc) const {
-        std::string value;
+        // Get copies the value out of the block cache once; hand that buffer to the
+        // RecordData instead of copying it a second time.
+        boost::shared_ptr<std::string> value( new std::string() );
         rocksdb::Status status;
         status = _db->Get( rocksdb::ReadOptions(),
                            _columnFamily,
                            _makeKey( loc ),
-                           &value );
+                           value.get() );
 
         if ( !status.ok() ) {
             if ( status.IsNotFound() )
@@ -88,12 +90,7 @@ namespace mongo {
             invariant( false );
         }
 
-        // TODO(XXX) this is a double copy :(
-
-        boost::shared_array<char> data( new char[value.size()] );
-        memcpy( data.get(), value.c_str(), value.size() );
-
-        return RecordData( data.get(), value.size(), data );
+        return RecordData( value );
     }
 
     void RocksRecordStore::deleteRecord( OperationContext* txn, const DiskLoc& dl ) {
@@ -306,7 +303,16 @@ namespace mongo {
     }
 
     RecordData RocksRecordStore::Iterator::dataFor( const DiskLoc& loc ) const {
-        // XXX: use the iterator value
+        // If the iterator is still positioned on this record its value slice is pinned in
+        // the block cache, so we can copy it out directly and skip a point lookup.
+        if ( _iterator && _iterator->Valid() &&
+             reinterpret_cast<const DiskLoc*>( _iterator->key().data() )[0] == loc ) {
+            rocksdb::Slice value = _iterator->value();
+            boost::shared_ptr<std::string> data(
+                    new std::string( value.data(), value.size() ) );
+            return RecordData( data );
+        }
+
         return _rs->dataFor( loc );
     }
 
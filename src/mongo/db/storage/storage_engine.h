@@ -34,6 +34,7 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/base/status_with.h"
 
 namespace mongo {
 
@@ -61,11 +62,46 @@ namespace mongo {
          */
         virtual int flushAllFiles( bool sync ) = 0;
 
+        /**
+         * like flushAllFiles(true), but engines that track dirty regions may flush
+         * only those.  used by the periodic data file flusher; explicit fsync paths
+         * call flushAllFiles.
+         * @return number of files flushed
+         */
+        virtual int flushDirtyFiles() { return flushAllFiles( true ); }
+
         virtual Status repairDatabase( OperationContext* tnx,
                                        const std::string& dbName,
                                        bool preserveClonedFilesOnFailure = false,
                                        bool backupOriginalFiles = false ) = 0;
 
+        /**
+         * Streams the names of the files a hot backup must copy, in copy order.
+         * Obtained from beginBackup(); deleting the cursor ends the backup.
+         */
+        class BackupCursor {
+        public:
+            virtual ~BackupCursor() {}
+
+            virtual bool more() = 0;
+
+            /** absolute path of the next file to copy */
+            virtual std::string next() = 0;
+        };
+
+        /**
+         * Starts a hot backup and returns a cursor over the files to copy.
+         * Copying the files in cursor order while the cursor is open yields a
+         * backup that recovers to a consistent point in time, without blocking
+         * writes.  Engines that cannot provide such a view return a non-OK
+         * status, and callers fall back to fsync+lock.  Caller owns the
+         * returned cursor; at most one backup may be in progress at a time.
+         */
+        virtual StatusWith<BackupCursor*> beginBackup() {
+            return StatusWith<BackupCursor*>( ErrorCodes::IllegalOperation,
+                                              "this storage engine does not support hot backup" );
+        }
+
         class Factory {
         public:
             virtual ~Factory(){}
@@ -65,13 +65,15 @@ namespace mongo {
                            RecordStore* recordStore,
                            const Ordering& ordering,
                            const string& indexName,
-                           BucketDeletionNotification* bucketDeletionNotification) {
+                           BucketDeletionNotification* bucketDeletionNotification,
+                           int fillFactorPct) {
 
             _btree.reset(new BtreeLogic<OnDiskFormat>(headManager,
                                                       recordStore,
                                                       ordering,
                                                       indexName,
-                                                      bucketDeletionNotification));
+                                                      bucketDeletionNotification,
+                                                      fillFactorPct));
         }
 
         virtual ~BtreeInterfaceImpl() { }
@@ -110,10 +112,20 @@ namespace mongo {
             return _btree->isEmpty();
         }
 
+        virtual double estimateRangeFraction(const BSONObj& startKey,
+                                             const BSONObj& endKey) const {
+            return _btree->estimateRangeFraction(startKey, endKey);
+        }
+
         virtual Status touch(OperationContext* txn) const{
             return _btree->touch(txn);
         }
 
+        virtual long long nonLeafRegions(std::vector< std::pair<void*, unsigned> >* regions,
+                                         long long maxBytes) const {
+            return _btree->nonLeafRegions(regions, maxBytes);
+        }
+
         class Cursor : public BtreeInterface::Cursor {
         public:
             Cursor(const BtreeLogic<OnDiskFormat>* btree, int direction)
@@ -189,6 +201,12 @@ namespace mongo {
                 _btree->advance(&_bucket, &_ofs, _direction);
             }
 
+            virtual long long countAndAdvance(const BtreeInterface::Cursor& endBase) {
+                const Cursor& end = static_cast<const Cursor&>(endBase);
+                invariant(1 == _direction);
+                return _btree->countAndAdvance(&_bucket, &_ofs, end._bucket, end._ofs);
+            }
+
             virtual void savePosition() {
                 if (!_bucket.isNull()) {
                     _savedKey = getKey().getOwned();
@@ -236,14 +254,16 @@ namespace mongo {
                                                  const Ordering& ordering,
                                                  const string& indexName,
                                                  int version,
-                                                 BucketDeletionNotification* bucketDeletion) {
+                                                 BucketDeletionNotification* bucketDeletion,
+                                                 int fillFactorPct) {
 
         if (0 == version) {
             return new BtreeInterfaceImpl<BtreeLayoutV0>(headManager,
                                                          recordStore,
                                                          ordering,
                                                          indexName,
-                                                         bucketDeletion);
+                                                         bucketDeletion,
+                                                         fillFactorPct);
         }
         else {
             invariant(1 == version);
@@ -251,7 +271,8 @@ namespace mongo {
                                                          recordStore,
                                                          ordering,
                                                          indexName,
-                                                         bucketDeletion);
+                                                         bucketDeletion,
+                                                         fillFactorPct);
         }
     }
 
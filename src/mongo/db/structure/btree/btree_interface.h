@@ -84,7 +84,8 @@ namespace mongo {
                                             const Ordering& ordering,
                                             const string& indexName,
                                             int version,
-                                            BucketDeletionNotification* bucketDeletion);
+                                            BucketDeletionNotification* bucketDeletion,
+                                            int fillFactorPct = 90);
 
         //
         // Data changes
@@ -117,12 +118,35 @@ namespace mongo {
         virtual void fullValidate(long long* numKeysOut) = 0;
 
         virtual bool isEmpty() = 0;
+
+        /**
+         * Estimates what fraction of the index's keys lie between 'startKey' and
+         * 'endKey' by descending both edges of the range and diffing the positional
+         * paths - O(depth), no scan.  Only accurate to within a small factor; intended
+         * for comparing candidate plans against each other, not for exact counting.
+         * Returns a value in [0, 1], or -1 when this implementation has no estimate.
+         */
+        virtual double estimateRangeFraction(const BSONObj& startKey,
+                                             const BSONObj& endKey) const {
+            return -1;
+        }
         
         /**
          * Attempt to bring whole index into memory. No-op is ok if not supported.
          */
         virtual Status touch(OperationContext* txn) const = 0;
 
+        /**
+         * Appends the memory regions of the non-leaf bucket levels to 'regions' as
+         * (address, length) pairs, up to 'maxBytes' in total, returning the number of
+         * bytes appended.  Used by the index pinning job (see db/index_pin.cpp) to
+         * mlock the upper levels of hot indexes.  Returning 0 is ok if not supported.
+         */
+        virtual long long nonLeafRegions(std::vector< std::pair<void*, unsigned> >* regions,
+                                         long long maxBytes) const {
+            return 0;
+        }
+
         //
         // Navigation
         //
@@ -176,6 +200,17 @@ namespace mongo {
 
             virtual void advance() = 0;
 
+            /**
+             * Counting fast path.  Counts keys from this cursor's position (inclusive)
+             * toward 'end''s (exclusive), advancing this cursor by at least one key.  May
+             * stop and return a partial tally before reaching 'end'; the caller loops
+             * until the cursors point at the same place or this one hits EOF.
+             *
+             * Both cursors must be forward cursors over the same index, with this one at
+             * or before 'end' in tree order.
+             */
+            virtual long long countAndAdvance(const Cursor& end) = 0;
+
             //
             // Saving and restoring state
             //
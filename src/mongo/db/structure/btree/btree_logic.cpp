@@ -26,10 +26,12 @@
  *    it in the license file.
  */
 
+#include "mongo/bson/inline_decls.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/structure/btree/btree_logic.h"
+#include "mongo/db/structure/btree/bucket_verification.h"
 #include "mongo/db/structure/btree/key.h"
 #include "mongo/db/structure/record_store.h"
 
@@ -62,6 +64,7 @@ namespace mongo {
         if (!oldHead.isNull()) {
             _logic->_headManager->setHead(_txn, DiskLoc());
             _logic->_recordStore->deleteRecord(_txn, oldHead);
+            _logic->_lastInsertLoc = DiskLoc();
         }
 
         _first = _cur = _logic->_addBucket(txn);
@@ -595,16 +598,21 @@ namespace mongo {
      * This function is expected to be called on a packed bucket.
      */
     template <class BtreeLayout>
-    int BtreeLogic<BtreeLayout>::splitPos(BucketType* bucket, int keypos) {
+    int BtreeLogic<BtreeLayout>::splitPos(BucketType* bucket, int keypos) const {
         invariant(bucket->n > 2);
         int split = 0;
         int rightSize = 0;
 
-        // When splitting a btree node, if the new key is greater than all the other keys, we should
-        // not do an even split, but a 90/10 split.  see SERVER-983.  TODO I think we only want to
-        // do the 90% split on the rhs node of the tree.
-        int rightSizeLimit = (bucket->topSize + sizeof(KeyHeaderType) * bucket->n)
-                           / (keypos == bucket->n ? 10 : 2);
+        // When splitting a btree node, if the new key is greater than all the other keys, we
+        // should not do an even split but leave the left side as full as the index's fill
+        // factor allows (90% unless the index was created with a fillFactor option), so
+        // monotonically increasing keys don't strand half-empty right-edge buckets.  see
+        // SERVER-983.  TODO I think we only want to do the fillFactor split on the rhs node
+        // of the tree.
+        const int totalSize = bucket->topSize + sizeof(KeyHeaderType) * bucket->n;
+        int rightSizeLimit = keypos == bucket->n
+                           ? totalSize * (100 - _fillFactorPct) / 100
+                           : totalSize / 2;
 
         for (int i = bucket->n - 1; i > -1; --i) {
             rightSize += getFullKey(bucket, i).data.dataSize() + sizeof(KeyHeaderType);
@@ -1006,19 +1014,160 @@ namespace mongo {
         }
     }
 
-    /**
-     * NOTE: Currently the Ordering implementation assumes a compound index will not have more keys
-     * than an unsigned variable has bits.  The same assumption is used in the implementation below
-     * with respect to the 'mask' variable.
-     *
-     * 'l' is a regular bsonobj
-     *
-     * 'rBegin' is composed partly of an existing bsonobj, and the remaining keys are taken from a
-     * vector of elements that frequently changes 
-     *
-     * see https://jira.mongodb.org/browse/SERVER-371
-     */
+    namespace {
+
+        /**
+         * Straight-line comparisons for the element type pairs that dominate index keys.
+         * BSONElement::woCompare translates both sides to canonical types and walks the generic
+         * type ladder in compareElementValues on every call; when both sides already have the
+         * same type that work is pure overhead on the btree descent path.  Returns false for any
+         * pair it does not handle, in which case the caller falls back to woCompare.  For every
+         * pair it accepts the result agrees with woCompare( rhs, false ).
+         */
+        inline bool fastKeyElementCompare(const BSONElement& l, const BSONElement& r, int* out) {
+            if ( l.type() != r.type() )
+                return false;
+
+            switch ( l.type() ) {
+            case NumberInt: {
+                int L = l._numberInt();
+                int R = r._numberInt();
+                *out = L < R ? -1 : ( L == R ? 0 : 1 );
+                return true;
+            }
+            case NumberLong: {
+                long long L = l._numberLong();
+                long long R = r._numberLong();
+                *out = L < R ? -1 : ( L == R ? 0 : 1 );
+                return true;
+            }
+            case NumberDouble: {
+                double L = l._numberDouble();
+                double R = r._numberDouble();
+                if ( L < R )
+                    *out = -1;
+                else if ( L == R )
+                    *out = 0;
+                else if ( L > R )
+                    *out = 1;
+                else // at least one NaN; NaN sorts below all other doubles
+                    *out = L != L ? ( R != R ? 0 : -1 ) : 1;
+                return true;
+            }
+            case String: {
+                // memcmp, not strcmp: UTF8 strings may contain embedded zeros
+                int lsz = l.valuestrsize();
+                int rsz = r.valuestrsize();
+                int common = std::min( lsz, rsz );
+                int res = memcmp( l.valuestr(), r.valuestr(), common );
+                *out = res ? res : lsz - rsz;
+                return true;
+            }
+            case jstOID:
+                *out = memcmp( l.value(), r.value(), 12 );
+                return true;
+            case Date: {
+                long long L = (long long)l.date().millis;
+                long long R = (long long)r.date().millis;
+                *out = L < R ? -1 : ( L == R ? 0 : 1 );
+                return true;
+            }
+            case Timestamp: {
+                // unsigned compare for timestamps - note they are not really dates but
+                // (ordinal + time_t)
+                unsigned long long L = l.date().millis;
+                unsigned long long R = r.date().millis;
+                *out = L < R ? -1 : ( L == R ? 0 : 1 );
+                return true;
+            }
+            case Bool:
+                *out = *l.value() - *r.value();
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * The comparison loop behind BtreeLogic::customBSONCmp, specialized on whether the index
+         * ordering has any descending fields.  For an all-ascending ordering (the _id index and
+         * most secondary indexes) the descending test and the mask bookkeeping drop out of the
+         * inner loop at compile time.
+         *
+         * NOTE: Currently the Ordering implementation assumes a compound index will not have more
+         * keys than an unsigned variable has bits.  The same assumption is used in the
+         * implementation below with respect to the 'mask' variable.
+         *
+         * 'l' is a regular bsonobj
+         *
+         * 'rBegin' is composed partly of an existing bsonobj, and the remaining keys are taken
+         * from a vector of elements that frequently changes
+         *
+         * see https://jira.mongodb.org/browse/SERVER-371
+         */
+        template <bool AnyDescending>
+        int customBSONCmpImpl(const BSONObj& l,
+                              const BSONObj& rBegin,
+                              int rBeginLen,
+                              bool rSup,
+                              const vector<const BSONElement*>& rEnd,
+                              const vector<bool>& rEndInclusive,
+                              const Ordering& o,
+                              int direction) {
+            // XXX: make this readable
+            BSONObjIterator ll( l );
+            BSONObjIterator rr( rBegin );
+            vector< const BSONElement * >::const_iterator rr2 = rEnd.begin();
+            vector< bool >::const_iterator inc = rEndInclusive.begin();
+            unsigned mask = 1;
+            for( int i = 0; i < rBeginLen; ++i, mask <<= 1 ) {
+                BSONElement lll = ll.next();
+                BSONElement rrr = rr.next();
+                ++rr2;
+                ++inc;
+
+                int x;
+                if ( !fastKeyElementCompare( lll, rrr, &x ) )
+                    x = lll.woCompare( rrr, false );
+                if ( AnyDescending && o.descending( mask ) )
+                    x = -x;
+                if ( x != 0 )
+                    return x;
+            }
+            if ( rSup ) {
+                return -direction;
+            }
+            for( ; ll.more(); mask <<= 1 ) {
+                BSONElement lll = ll.next();
+                BSONElement rrr = **rr2;
+                ++rr2;
+                int x;
+                if ( !fastKeyElementCompare( lll, rrr, &x ) )
+                    x = lll.woCompare( rrr, false );
+                if ( AnyDescending && o.descending( mask ) )
+                    x = -x;
+                if ( x != 0 )
+                    return x;
+                if ( !*inc ) {
+                    return -direction;
+                }
+                ++inc;
+            }
+            return 0;
+        }
+
+    }  // namespace
+
     // static
+    template <class BtreeLayout>
+    typename BtreeLogic<BtreeLayout>::CustomCmpFn
+    BtreeLogic<BtreeLayout>::_chooseCustomCmp(const Ordering& ordering) {
+        if (ordering.descending(0xFFFFFFFFU)) {
+            return &customBSONCmpImpl<true>;
+        }
+        return &customBSONCmpImpl<false>;
+    }
+
     template <class BtreeLayout>
     int BtreeLogic<BtreeLayout>::customBSONCmp(const BSONObj& l,
                                                const BSONObj& rBegin,
@@ -1028,42 +1177,7 @@ namespace mongo {
                                                const vector<bool>& rEndInclusive,
                                                const Ordering& o,
                                                int direction) const {
-        // XXX: make this readable
-        BSONObjIterator ll( l );
-        BSONObjIterator rr( rBegin );
-        vector< const BSONElement * >::const_iterator rr2 = rEnd.begin();
-        vector< bool >::const_iterator inc = rEndInclusive.begin();
-        unsigned mask = 1;
-        for( int i = 0; i < rBeginLen; ++i, mask <<= 1 ) {
-            BSONElement lll = ll.next();
-            BSONElement rrr = rr.next();
-            ++rr2;
-            ++inc;
-
-            int x = lll.woCompare( rrr, false );
-            if ( o.descending( mask ) )
-                x = -x;
-            if ( x != 0 )
-                return x;
-        }
-        if ( rSup ) {
-            return -direction;
-        }
-        for( ; ll.more(); mask <<= 1 ) {
-            BSONElement lll = ll.next();
-            BSONElement rrr = **rr2;
-            ++rr2;
-            int x = lll.woCompare( rrr, false );
-            if ( o.descending( mask ) )
-                x = -x;
-            if ( x != 0 )
-                return x;
-            if ( !*inc ) {
-                return -direction;
-            }
-            ++inc;
-        }
-        return 0;
+        return _customCmpFn(l, rBegin, rBeginLen, rSup, rEnd, rEndInclusive, o, direction);
     }
 
     template <class BtreeLayout>
@@ -1159,9 +1273,21 @@ namespace mongo {
         int high = bucket->n - 1;
         int middle = (low + high) / 2;
 
+        // Adjacent keys in a bucket often share a long prefix (e.g. compound
+        // keys on (tenantId, timestamp, ...)).  Once the search key is known to
+        // share its first N fields with both the left and the right boundary of
+        // the remaining range, every key in between must share them too, so
+        // each probe can skip re-comparing those fields.
+        unsigned lowMatched = 0;
+        unsigned highMatched = 0;
+
         while (low <= high) {
             FullKey fullKey = getFullKey(bucket, middle);
-            int cmp = key.woCompare(fullKey.data, _ordering);
+            unsigned matched = 0;
+            int cmp = key.woCompare(fullKey.data,
+                                    _ordering,
+                                    std::min(lowMatched, highMatched),
+                                    &matched);
 
             // The key data is the same.
             if (0 == cmp) {
@@ -1210,9 +1336,11 @@ namespace mongo {
 
             if (cmp < 0) {
                 high = middle - 1;
+                highMatched = matched;
             }
             else if (cmp > 0) {
                 low = middle + 1;
+                lowMatched = matched;
             }
             else {
                 // Found it!
@@ -1267,6 +1395,9 @@ namespace mongo {
         bucket->n = BtreeLayout::INVALID_N_SENTINEL;
         bucket->parent.Null();
         _recordStore->deleteRecord(txn, bucketLoc);
+
+        // The sorted-insert hint may point at this bucket; never leave it dangling.
+        _lastInsertLoc = DiskLoc();
     }
 
     template <class BtreeLayout>
@@ -1862,6 +1993,12 @@ namespace mongo {
 
         BucketType* bucket = getBucket(bucketLoc);
 
+        // Remember where plain leaf inserts land (promotions of split keys pass
+        // children and may target internal buckets, which make poor hints).
+        if (leftChildLoc.isNull() && rightChildLoc.isNull()) {
+            _lastInsertLoc = bucketLoc;
+        }
+
         if (!basicInsert(txn, bucket, bucketLoc, pos, key, recordLoc)) {
             // If basicInsert() fails, the bucket will be packed as required by split().
             split(txn, btreemod(txn, bucket), bucketLoc, pos, recordLoc, key, leftChildLoc, rightChildLoc);
@@ -2054,6 +2191,62 @@ namespace mongo {
         return _recordStore->touch( txn, NULL );
     }
 
+    template <class BtreeLayout>
+    long long BtreeLogic<BtreeLayout>::nonLeafRegions(
+            std::vector< std::pair<void*, unsigned> >* regions,
+            long long maxBytes) const {
+
+        const DiskLoc rootLoc = getRootLoc();
+        if (rootLoc.isNull()) {
+            return 0;
+        }
+
+        // every leaf is at the same depth; find it by walking the leftmost edge
+        int leafDepth = 0;
+        DiskLoc loc = rootLoc;
+        while (!loc.isNull()) {
+            BucketType* bucket = getBucket(loc);
+            DiskLoc next;
+            for (int pos = 0; pos <= bucket->n && next.isNull(); pos++) {
+                next = childLocForPos(bucket, pos);
+            }
+            loc = next;
+            leafDepth++;
+        }
+
+        long long totalBytes = 0;
+        _nonLeafRegions(rootLoc, 0, leafDepth - 1, regions, maxBytes, &totalBytes);
+        return totalBytes;
+    }
+
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_nonLeafRegions(
+            const DiskLoc bucketLoc,
+            int depth,
+            int leafDepth,
+            std::vector< std::pair<void*, unsigned> >* regions,
+            long long maxBytes,
+            long long* totalBytes) const {
+
+        // buckets at leafDepth are leaves; they are the bulk of the index and are
+        // neither read nor collected here
+        if (depth >= leafDepth || *totalBytes >= maxBytes) {
+            return;
+        }
+
+        BucketType* bucket = getBucket(bucketLoc);
+        regions->push_back(std::make_pair(static_cast<void*>(bucket),
+                                          static_cast<unsigned>(BtreeLayout::BucketSize)));
+        *totalBytes += BtreeLayout::BucketSize;
+
+        for (int pos = 0; pos <= bucket->n; pos++) {
+            const DiskLoc childLoc = childLocForPos(bucket, pos);
+            if (!childLoc.isNull()) {
+                _nonLeafRegions(childLoc, depth + 1, leafDepth, regions, maxBytes, totalBytes);
+            }
+        }
+    }
+
     template <class BtreeLayout>
     long long BtreeLogic<BtreeLayout>::fullValidate(long long *unusedCount,
                                                      bool strict,
@@ -2186,6 +2379,75 @@ namespace mongo {
         }
     }
 
+    // The checks mirror the invariants maintained by init(), _alloc() and
+    // _delKeyAtPos(): key headers grow from the front of the body, key data grows from
+    // the back, and emptySize tracks the gap between them exactly.
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::verifyBucket(BucketType* bucket) const {
+        if (BtreeLayout::INVALID_N_SENTINEL == bucket->n) {
+            // Deallocated bucket; there is nothing to check.
+            return true;
+        }
+
+        const int tdz = totalDataSize(bucket);
+        const int n = bucket->n;
+        const int emptySize = bucket->emptySize;
+        const int topSize = bucket->topSize;
+
+        if (n < 0 || n > tdz / static_cast<int>(sizeof(KeyHeaderType))) {
+            log() << "ERROR: btree bucket corrupt in " << _indexName
+                  << ": bad key count " << n << endl;
+            return false;
+        }
+
+        if (emptySize < 0 || topSize < 0 || topSize > tdz ||
+            n * static_cast<int>(sizeof(KeyHeaderType)) + emptySize + topSize != tdz) {
+            log() << "ERROR: btree bucket corrupt in " << _indexName
+                  << ": sizes don't tile the body; n:" << n
+                  << " emptySize:" << emptySize
+                  << " topSize:" << topSize << endl;
+            return false;
+        }
+
+        for (int i = 0; i < n; i++) {
+            const int kdo = getKeyHeader(bucket, i).keyDataOfs();
+
+            // The key data must lie past the key header array and inside the bucket;
+            // check that before letting the key code parse anything at that offset.
+            if (kdo < n * static_cast<int>(sizeof(KeyHeaderType)) || kdo >= tdz) {
+                log() << "ERROR: btree bucket corrupt in " << _indexName
+                      << ": bad keyDataOfs " << kdo << " for key " << i << endl;
+                return false;
+            }
+
+            const int keySize = getFullKey(bucket, i).data.dataSize();
+            if (keySize <= 0 || kdo + keySize > tdz) {
+                log() << "ERROR: btree bucket corrupt in " << _indexName
+                      << ": key " << i << " of size " << keySize
+                      << " at ofs " << kdo << " overruns the bucket" << endl;
+                return false;
+            }
+        }
+
+        for (int i = 0; i < n - 1; i++) {
+            FullKey firstKey = getFullKey(bucket, i);
+            FullKey secondKey = getFullKey(bucket, i + 1);
+            int z = firstKey.data.woCompare(secondKey.data, _ordering);
+            if (z > 0 ||
+                (z == 0 && !(firstKey.header.recordLoc < secondKey.header.recordLoc))) {
+                log() << "ERROR: btree bucket corrupt in " << _indexName
+                      << ": keys " << i << " and " << i + 1 << " out of order:" << endl;
+                log() << " k(" << i << ")" << firstKey.data.toString()
+                      << " RL:" << firstKey.header.recordLoc.toString() << endl;
+                log() << " k(" << i + 1 << ")" << secondKey.data.toString()
+                      << " RL:" << secondKey.header.recordLoc.toString() << endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     template <class BtreeLayout>
     Status BtreeLogic<BtreeLayout>::insert(OperationContext* txn,
                                            const BSONObj& rawKey,
@@ -2200,6 +2462,45 @@ namespace mongo {
             return Status(ErrorCodes::KeyTooLong, msg);
         }
 
+        // Fast path for sorted input: if the key compares strictly between the first and
+        // the last key of the leaf that took the previous insert, that leaf is still the
+        // unique bucket a root-to-leaf descent would reach (every key equal to ours, and
+        // every separator in our ancestors, lies outside that open interval), so the
+        // descent can be skipped.  Append workloads hit this on nearly every insert.
+        if (!_lastInsertLoc.isNull()) {
+            BucketType* bucket = getBucket(_lastInsertLoc);
+            if (bucket->n >= 2 &&
+                key.woCompare(getFullKey(bucket, 0).data, _ordering) > 0 &&
+                key.woCompare(getFullKey(bucket, bucket->n - 1).data, _ordering) < 0) {
+
+                int pos;
+                bool found;
+                Status findStatus = _find(bucket, key, value, !dupsAllowed, &pos, &found);
+                if (!findStatus.isOK()) {
+                    return findStatus;
+                }
+
+                if (found) {
+                    KeyHeaderType& header = getKeyHeader(bucket, pos);
+                    if (header.isUnused()) {
+                        LOG(4) << "btree insert: reusing unused key" << endl;
+                        txn->recoveryUnit()->writing(&header)->setUsed();
+                        return Status::OK();
+                    }
+                    return Status(ErrorCodes::UniqueIndexViolation, "FIXME");
+                }
+
+                if (childLocForPos(bucket, pos).isNull()) {
+                    insertHere(txn, _lastInsertLoc, pos, key, value, DiskLoc(), DiskLoc());
+                    assertValid(_indexName, getRoot(), _ordering);
+                    return Status::OK();
+                }
+
+                // The hinted bucket is internal and the key belongs below it; descend
+                // from the root as usual.
+            }
+        }
+
         Status status = _insert(txn,
                                 getRoot(),
                                 getRootLoc(),
@@ -2213,6 +2514,65 @@ namespace mongo {
         return status;
     }
 
+    /**
+     * Walks one root-to-leaf descent toward <key, recordLoc> and folds the binary-search
+     * position at each level into a cumulative fraction, treating a bucket with n keys as
+     * n + 1 equally weighted child subtrees.  The leaf levels dominate the total key
+     * count, so the positional path approximates the key's rank in the whole index.
+     */
+    template <class BtreeLayout>
+    double BtreeLogic<BtreeLayout>::_estimatePositionFraction(const KeyDataType& key,
+                                                              const DiskLoc& recordLoc) const {
+        double fraction = 0;
+        double scale = 1;
+
+        DiskLoc bucketLoc = getRootLoc();
+        while (!bucketLoc.isNull()) {
+            BucketType* bucket = getBucket(bucketLoc);
+            if (0 == bucket->n) {
+                break;
+            }
+
+            int pos;
+            bool found;
+            Status status = _find(bucket, key, recordLoc, false, &pos, &found);
+            if (!status.isOK()) {
+                break;
+            }
+
+            fraction += scale * (static_cast<double>(pos) / (bucket->n + 1));
+            if (found) {
+                break;
+            }
+
+            scale /= bucket->n + 1;
+            bucketLoc = childLocForPos(bucket, pos);
+        }
+
+        return fraction;
+    }
+
+    template <class BtreeLayout>
+    double BtreeLogic<BtreeLayout>::estimateRangeFraction(const BSONObj& startKey,
+                                                          const BSONObj& endKey) const {
+        KeyDataOwnedType start(startKey);
+        KeyDataOwnedType end(endKey);
+
+        // The record locs push the two descents to the outer edges of any runs of keys
+        // equal to the bounds, so duplicate-heavy ranges are measured, not skipped.
+        const double lower = _estimatePositionFraction(start, minDiskLoc);
+        const double upper = _estimatePositionFraction(end, maxDiskLoc);
+
+        const double fraction = upper - lower;
+        if (fraction < 0) {
+            return 0;
+        }
+        if (fraction > 1) {
+            return 1;
+        }
+        return fraction;
+    }
+
     template <class BtreeLayout>
     Status BtreeLogic<BtreeLayout>::_insert(OperationContext* txn,
                                             BucketType* bucket,
@@ -2333,6 +2693,47 @@ namespace mongo {
         return DiskLoc();
     }
 
+    template <class BtreeLayout>
+    long long BtreeLogic<BtreeLayout>::countAndAdvance(DiskLoc* bucketLocInOut,
+                                                       int* posInOut,
+                                                       const DiskLoc& endBucketLoc,
+                                                       int endKeyOffset) const {
+        BucketType* bucket = getBucket(*bucketLocInOut);
+        invariant(*posInOut >= 0 && *posInOut < bucket->n);
+
+        // Only in a leaf bucket are the keys consecutive in tree order, which is what lets
+        // us tally a stretch of them without navigating between each pair.  Interior
+        // buckets take the one-key-at-a-time path below.
+        if (bucket->nextChild.isNull()) {
+            const bool endsHere = (*bucketLocInOut == endBucketLoc);
+            const int limit = endsHere ? endKeyOffset : bucket->n;
+
+            long long count = 0;
+            for (int i = *posInOut; i < limit; i++) {
+                if (getKeyHeader(bucket, i).isUsed()) {
+                    count++;
+                }
+            }
+
+            if (endsHere) {
+                // Land exactly on the end position so the caller sees the cursors meet.
+                *posInOut = endKeyOffset;
+                return count;
+            }
+
+            // Step off the bucket's last key; advance() takes us up and over to the next
+            // key in tree order.
+            *posInOut = bucket->n - 1;
+            *bucketLocInOut = advance(*bucketLocInOut, posInOut, 1);
+            skipUnusedKeys(bucketLocInOut, posInOut, 1);
+            return count;
+        }
+
+        *bucketLocInOut = advance(*bucketLocInOut, posInOut, 1);
+        skipUnusedKeys(bucketLocInOut, posInOut, 1);
+        return 1;
+    }
+
     template <class BtreeLayout>
     bool BtreeLogic<BtreeLayout>::keyIsUsed(const DiskLoc& loc, const int& pos) const {
         return getKeyHeader(getBucket(loc), pos).isUsed();
@@ -2421,6 +2822,45 @@ namespace mongo {
         return bucket->parent.isNull();
     }
 
+    /**
+     * First-access verification after crash recovery; see bucket_verification.h.  Only
+     * reached while verification is armed.  Two threads can race to verify the same
+     * bucket, which just means the (idempotent) check runs twice.
+     */
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::lazyVerifyBucket(BucketType* bucket, const DiskLoc dl) const {
+        const unsigned long long id =
+            (static_cast<unsigned long long>(dl.a()) << 32) |
+            static_cast<unsigned>(dl.getOfs());
+
+        {
+            scoped_spinlock lk(_verifiedBucketsLock);
+            if (_verifiedBuckets && _verifiedBuckets->count(id)) {
+                return;
+            }
+        }
+
+        if (!verifyBucket(bucket)) {
+            btreeBucketsCorrupt.fetchAndAdd(1);
+            msgasserted(18564, str::stream() << "btree bucket " << dl.toString()
+                                             << " in index " << _indexName
+                                             << " failed post-recovery verification;"
+                                             << " run validate or repair");
+        }
+
+        btreeBucketsVerified.fetchAndAdd(1);
+
+        // Only mark the bucket verified once it has passed, so a corrupt bucket keeps
+        // failing rather than sliding through on the second access.
+        {
+            scoped_spinlock lk(_verifiedBucketsLock);
+            if (!_verifiedBuckets) {
+                _verifiedBuckets.reset(new unordered_set<unsigned long long>());
+            }
+            _verifiedBuckets->insert(id);
+        }
+    }
+
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::BucketType*
     BtreeLogic<BtreeLayout>::getBucket(const DiskLoc dl) const {
@@ -2433,7 +2873,13 @@ namespace mongo {
         // we need to be working on the raw bytes, not a transient copy
         invariant(!recordData.isOwned());
 
-        return reinterpret_cast<BucketType*>(const_cast<char*>(recordData.data()));
+        BucketType* bucket = reinterpret_cast<BucketType*>(const_cast<char*>(recordData.data()));
+
+        if (MONGO_unlikely(btreeVerificationActive())) {
+            lazyVerifyBucket(bucket, dl);
+        }
+
+        return bucket;
     }
 
     template <class BtreeLayout>
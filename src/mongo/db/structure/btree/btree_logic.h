@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
@@ -36,6 +38,8 @@
 #include "mongo/db/structure/btree/key.h"
 #include "mongo/db/structure/btree/bucket_deletion_notification.h"
 #include "mongo/db/structure/head_manager.h"
+#include "mongo/platform/unordered_set.h"
+#include "mongo/util/concurrency/spin_lock.h"
 
 
 namespace mongo {
@@ -74,18 +78,24 @@ namespace mongo {
          * 'store' allocates and frees buckets.
          * 'ordering' is meta-information we store in the catalog.
          * 'indexName' is a string identifying the index that we use to print errors with.
+         * 'fillFactorPct' is the percentage of a bucket kept on the left when splitting
+         *  at the high end of the key range; see splitPos().
          */
         BtreeLogic(HeadManager* head,
                    RecordStore* store,
                    const Ordering& ordering,
                    const string& indexName,
-                   BucketDeletionNotification* bucketDeletion)
+                   BucketDeletionNotification* bucketDeletion,
+                   int fillFactorPct = 90)
             : _headManager(head),
               _recordStore(store),
               _ordering(ordering),
+              _customCmpFn(_chooseCustomCmp(ordering)),
               _indexName(indexName),
-              _bucketDeletion(bucketDeletion) { 
-        
+              _bucketDeletion(bucketDeletion),
+              _fillFactorPct(fillFactorPct),
+              _lastInsertLoc() {
+
         }
 
         //
@@ -160,6 +170,34 @@ namespace mongo {
 
         void advance(DiskLoc* bucketLocInOut, int* posInOut, int direction) const;
 
+        /**
+         * Counting fast path used by the Count stage (see exec/count.cpp).
+         *
+         * Counts used keys from the current position (inclusive) toward the position
+         * described by 'endBucketLoc'/'endKeyOffset' (exclusive), advancing the current
+         * position to wherever the tally stopped.  When the current bucket is a leaf, its
+         * whole remainder is tallied with one pass over the key headers instead of a full
+         * cursor advance per key.  Always advances by at least one key, but may stop (and
+         * return the partial tally) before reaching the end position; the caller loops.
+         *
+         * The current position must be a used key at or before the end position in tree
+         * order.  'endBucketLoc' may be null, meaning "count through the last key".
+         */
+        long long countAndAdvance(DiskLoc* bucketLocInOut,
+                                  int* posInOut,
+                                  const DiskLoc& endBucketLoc,
+                                  int endKeyOffset) const;
+
+        /**
+         * Estimates what fraction of the index's keys lie between 'startKey' and
+         * 'endKey' by descending both edges of the range and diffing the positional
+         * paths - O(depth), no scan.  Assumes sibling subtrees hold roughly equal key
+         * counts, so the answer is only good to within a small factor; useful for
+         * ranking plans against each other, not for exact counting.  Returns a value
+         * in [0, 1].
+         */
+        double estimateRangeFraction(const BSONObj& startKey, const BSONObj& endKey) const;
+
         bool exists(const KeyDataType& key) const;
 
         bool unindex(OperationContext* txn,
@@ -173,6 +211,15 @@ namespace mongo {
                                bool dumpBuckets,
                                unsigned depth);
 
+        /**
+         * Structurally checks one bucket: the header bounds, each key slot's data
+         * offset, and the key ordering.  Unlike assertValid() this looks at every key
+         * on every call, so it is only used from explicit verification paths (see
+         * bucket_verification.h).  Deallocated buckets trivially pass.  Returns false
+         * (after logging the details) if the bucket is corrupt.
+         */
+        bool verifyBucket(BucketType* bucket) const;
+
         DiskLoc getDiskLoc(const DiskLoc& bucketLoc, const int keyOffset) const;
 
         BSONObj getKey(const DiskLoc& bucketLoc, const int keyOffset) const;
@@ -181,6 +228,17 @@ namespace mongo {
 
         Status touch(OperationContext* txn) const;
 
+        /**
+         * Appends the memory regions of the non-leaf buckets -- every level above the
+         * leaves -- to 'regions' as (address, length) pairs, stopping once 'maxBytes'
+         * worth have been appended.  The leaf depth is found by descending the
+         * leftmost edge first, so apart from one leftmost leaf the walk only reads
+         * non-leaf buckets and does not fault in the leaf level.  Returns the number
+         * of bytes appended.  Caller must hold at least a read lock on the database.
+         */
+        long long nonLeafRegions(std::vector< std::pair<void*, unsigned> >* regions,
+                                 long long maxBytes) const;
+
         //
         // Composite key navigation methods
         //
@@ -295,8 +353,6 @@ namespace mongo {
 
         static BucketType* btreemod(OperationContext* txn, BucketType* bucket);
 
-        static int splitPos(BucketType* bucket, int keypos);
-
         static void reserveKeysFront(BucketType* bucket, int nAdd);
 
         static void setKey(BucketType* bucket,
@@ -319,6 +375,8 @@ namespace mongo {
         // information).
         //
 
+        int splitPos(BucketType* bucket, int keypos) const;
+
         bool basicInsert(OperationContext* txn,
                          BucketType* bucket,
                          const DiskLoc bucketLoc,
@@ -369,6 +427,9 @@ namespace mongo {
                            const vector<bool>& keyEndInclusive,
                            int direction) const;
 
+        // see estimateRangeFraction()
+        double _estimatePositionFraction(const KeyDataType& key, const DiskLoc& recordLoc) const;
+
         bool wouldCreateDup(const KeyDataType& key, const DiskLoc self) const;
 
         bool keyIsUsed(const DiskLoc& loc, const int& pos) const;
@@ -390,6 +451,13 @@ namespace mongo {
                                bool dumpBuckets,
                                unsigned depth);
 
+        void _nonLeafRegions(const DiskLoc bucketLoc,
+                             int depth,
+                             int leafDepth,
+                             std::vector< std::pair<void*, unsigned> >* regions,
+                             long long maxBytes,
+                             long long* totalBytes) const;
+
         DiskLoc _addBucket(OperationContext* txn);
 
         bool canMergeChildren(BucketType* bucket,
@@ -513,6 +581,23 @@ namespace mongo {
                      BucketType* bucket,
                      int keyPos) const;
 
+        /**
+         * Signature of the comparison routine behind customBSONCmp.  A
+         * specialization is picked once at construction from the index
+         * ordering, so the per-call cost is one indirect call into
+         * straight-line comparison code; see _chooseCustomCmp.
+         */
+        typedef int (*CustomCmpFn)(const BSONObj& l,
+                                   const BSONObj& rBegin,
+                                   int rBeginLen,
+                                   bool rSup,
+                                   const std::vector<const BSONElement*>& rEnd,
+                                   const std::vector<bool>& rEndInclusive,
+                                   const Ordering& o,
+                                   int direction);
+
+        static CustomCmpFn _chooseCustomCmp(const Ordering& ordering);
+
         // TODO 'this' for _ordering(?)
         int customBSONCmp(const BSONObj& l,
                           const BSONObj& rBegin,
@@ -538,6 +623,8 @@ namespace mongo {
 
         BucketType* childForPos(BucketType* bucket, int pos) const;
 
+        void lazyVerifyBucket(BucketType* bucket, const DiskLoc dl) const;
+
         BucketType* getBucket(const DiskLoc dl) const;
 
         BucketType* getRoot() const;
@@ -556,10 +643,39 @@ namespace mongo {
 
         Ordering _ordering;
 
+        // Comparison specialization selected from _ordering at construction.
+        CustomCmpFn _customCmpFn;
+
         string _indexName;
 
         // Not owned here
         BucketDeletionNotification* _bucketDeletion;
+
+        // see splitPos()
+        int _fillFactorPct;
+
+        /**
+         * The leaf that took the most recent insert, or null.  When the next key to
+         * insert compares strictly between that leaf's first and last keys, the
+         * root-to-leaf descent can be skipped and the key inserted directly there,
+         * which amortizes the O(log n) walk across sorted insert batches; see insert().
+         * Cleared whenever a bucket is deallocated, since the hint could otherwise
+         * point at freed space.  Writes to an index are serialized by the database
+         * lock, so no extra synchronization is needed.
+         */
+        DiskLoc _lastInsertLoc;
+
+        /**
+         * Which buckets have already passed post-recovery verification, so each one is
+         * checked at most once; see lazyVerifyBucket().  Only touched while
+         * verification is armed (bucket_verification.h), so there is no steady-state
+         * cost, but once the sweep finishes the set lingers until the BtreeLogic is
+         * destroyed -- at 8 bytes per bucket that is a few MB for a very large index.
+         * getBucket() runs under the database lock in either mode, so readers can race
+         * here; _verifiedBucketsLock guards the set.
+         */
+        mutable SpinLock _verifiedBucketsLock;
+        mutable boost::scoped_ptr<unordered_set<unsigned long long> > _verifiedBuckets;
     };
 
 }  // namespace mongo
@@ -200,6 +200,72 @@ namespace mongo {
         }
     };
 
+    template<class OnDiskFormat>
+    class SortedInsertBatch : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            // Ascending inserts repeatedly hit the last-insert leaf hint; large keys
+            // force several splits along the way.
+            for (int i = 0; i < 26; ++i) {
+                this->insert(simpleKey(static_cast<char>('a' + i), 800),
+                             this->_helper.dummyDiskLoc);
+            }
+            this->checkValidNumKeys(26);
+
+            // An out-of-order insert misses the hint and must fall back to a root
+            // descent, still landing in the right bucket.
+            this->insert(simpleKey('a', 799), this->_helper.dummyDiskLoc);
+            this->checkValidNumKeys(27);
+
+            for (int i = 0; i < 26; ++i) {
+                int pos;
+                DiskLoc loc;
+                ASSERT(this->_helper.btree.locate(simpleKey(static_cast<char>('a' + i), 800),
+                                                  this->_helper.dummyDiskLoc,
+                                                  1,
+                                                  &pos,
+                                                  &loc));
+            }
+        }
+    };
+
+    template<class OnDiskFormat>
+    class NonLeafRegions : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            std::vector< std::pair<void*, unsigned> > regions;
+
+            // a single-bucket tree is all leaf; nothing to collect
+            this->insert(simpleKey('a', 800), this->_helper.dummyDiskLoc);
+            ASSERT_EQUALS(0, this->_helper.btree.nonLeafRegions(&regions, 1024 * 1024));
+            ASSERT(regions.empty());
+
+            // large keys force splits, creating a non-leaf level above the leaves
+            for (int i = 1; i < 26; ++i) {
+                this->insert(simpleKey(static_cast<char>('a' + i), 800),
+                             this->_helper.dummyDiskLoc);
+            }
+
+            const long long bytes =
+                this->_helper.btree.nonLeafRegions(&regions, 1024 * 1024);
+            ASSERT_GREATER_THAN(bytes, 0);
+            ASSERT_EQUALS(bytes,
+                          static_cast<long long>(regions.size()) * OnDiskFormat::BucketSize);
+
+            // the byte budget caps collection after the first bucket
+            regions.clear();
+            ASSERT_EQUALS(static_cast<long long>(OnDiskFormat::BucketSize),
+                          this->_helper.btree.nonLeafRegions(&regions, 1));
+            ASSERT_EQUALS(1U, regions.size());
+        }
+    };
+
     template<class OnDiskFormat>
     class SplitUnevenBucketBase : public BtreeLogicTestBase<OnDiskFormat> {
     public:
@@ -2117,6 +2183,8 @@ namespace mongo {
         void setupTests() {
             add< SimpleCreate<OnDiskFormat> >();
             add< SimpleInsertDelete<OnDiskFormat> >();
+            add< SortedInsertBatch<OnDiskFormat> >();
+            add< NonLeafRegions<OnDiskFormat> >();
             add< SplitRightHeavyBucket<OnDiskFormat> >();
             add< SplitLeftHeavyBucket<OnDiskFormat> >();
             add< MissingLocate<OnDiskFormat> >();
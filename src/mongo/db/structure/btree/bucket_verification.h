@@ -0,0 +1,70 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Post-crash-recovery btree bucket verification.
+     *
+     * Journal replay makes the data files consistent with everything the journal knows
+     * about, but an unclean shutdown can still leave damage the journal never saw (a torn
+     * write that was already synced, a bad sector, ...), and the traditional answer -- a
+     * full offline validate -- can take hours on a large install.  Instead, recovery
+     * (dur_recover.cpp) arms the flag below and every btree bucket is structurally
+     * verified the first time it is read (see BtreeLogic::getBucket()).  A background
+     * sweeper (db/btree_verify.cpp) walks the remaining buckets at low admission priority
+     * and disarms the flag once everything has been seen, so the whole data set is
+     * checked shortly after startup rather than only as it happens to be touched.
+     *
+     * While the flag is off -- the steady state -- the only cost is one predicted-not-
+     * taken branch per bucket access.
+     */
+
+    // Implementation detail of btreeVerificationActive(); use the functions below.
+    extern AtomicUInt32 _btreeVerificationArmed;
+
+    /** True while first-access bucket verification is armed. */
+    inline bool btreeVerificationActive() {
+        return _btreeVerificationArmed.loadRelaxed() != 0;
+    }
+
+    /** Called by journal recovery after replaying an unclean shutdown. */
+    void setBtreeVerificationNeeded();
+
+    /** Called by the background sweeper once every index has been walked. */
+    void clearBtreeVerificationNeeded();
+
+    // Tallies kept across all indexes, for the sweeper's completion log line.
+    extern AtomicInt64 btreeBucketsVerified;
+    extern AtomicInt64 btreeBucketsCorrupt;
+
+}  // namespace mongo
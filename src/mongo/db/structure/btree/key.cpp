@@ -601,7 +601,61 @@ namespace mongo {
         return sz;
     }
 
-    int KeyV1::dataSize() const { 
+    int KeyV1::woCompare(const KeyV1& right, const Ordering& order,
+                         unsigned skipFields, unsigned* commonFields) const {
+        const unsigned char *l = _keyData;
+        const unsigned char *r = right._keyData;
+
+        if( (*l|*r) == IsBSON ) {
+            // old-style key(s); can't skip into a BSON comparison, so compare
+            // in full and report no shareable prefix
+            *commonFields = 0;
+            return compareHybrid(right, order);
+        }
+
+        // the caller guarantees the first skipFields fields compare equal and
+        // that both keys have more fields after them
+        for( unsigned i = 0; i < skipFields; i++ ) {
+            dassert( (*l & cHASMORE) && (*r & cHASMORE) );
+            l += sizeOfElement(l);
+            r += sizeOfElement(r);
+        }
+
+        unsigned matched = skipFields;
+        unsigned mask = 1u << skipFields;
+        while( 1 ) {
+            char lval = *l;
+            char rval = *r;
+            {
+                int x = compare(l, r); // updates l and r pointers
+                if( x ) {
+                    if( order.descending(mask) )
+                        x = -x;
+                    *commonFields = matched;
+                    return x;
+                }
+            }
+
+            {
+                int x = ((int)(lval & cHASMORE)) - ((int)(rval & cHASMORE));
+                if( x ) {
+                    *commonFields = matched;
+                    return x;
+                }
+                if( (lval & cHASMORE) == 0 )
+                    break;
+            }
+
+            // this field compared equal and both keys continue past it
+            matched++;
+            mask <<= 1;
+        }
+
+        *commonFields = matched;
+        return 0;
+    }
+
+    int KeyV1::dataSize() const {
         const unsigned char *p = _keyData;
         if( !isCompactFormat() ) {
             return bson().objsize() + 1;
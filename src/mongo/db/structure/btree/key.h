@@ -46,6 +46,15 @@ namespace mongo {
         explicit KeyBson(const char *keyData) : _o(keyData) { }
         explicit KeyBson(const BSONObj& obj) : _o(obj) { }
         int woCompare(const KeyBson& r, const Ordering &o) const;
+
+        // prefix-skip variant (see KeyV1); v:0 keys never share a skippable
+        // prefix, so this just compares in full
+        int woCompare(const KeyBson& r, const Ordering& o,
+                      unsigned skipFields, unsigned* commonFields) const {
+            *commonFields = 0;
+            return woCompare(r, o);
+        }
+
         BSONObj toBson() const { return _o; }
         std::string toString() const { return _o.toString(); }
         int dataSize() const { return _o.objsize(); }
@@ -84,6 +93,22 @@ namespace mongo {
         explicit KeyV1(const char *keyData) : _keyData((unsigned char *) keyData) { }
 
         int woCompare(const KeyV1& r, const Ordering &o) const;
+
+        /**
+         * Same ordering as woCompare() above, but skips the first 'skipFields'
+         * fields of both keys -- the caller guarantees they compare equal --
+         * and on return sets '*commonFields' to the number of leading fields
+         * that compared equal and are followed by more fields in both keys
+         * (i.e. the count that is safe to pass back in as 'skipFields').
+         * Falls back to a full comparison, reporting no common fields, when
+         * either key is in the old BSON format.
+         *
+         * Used by the btree binary search to avoid re-comparing the long
+         * prefixes that adjacent keys in a bucket tend to share.
+         */
+        int woCompare(const KeyV1& r, const Ordering& o,
+                      unsigned skipFields, unsigned* commonFields) const;
+
         bool woEqual(const KeyV1& r) const;
         BSONObj toBson() const;
         std::string toString() const { return toBson().toString(); }
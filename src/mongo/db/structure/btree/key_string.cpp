@@ -0,0 +1,179 @@
+// @file key_string.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/structure/btree/key_string.h"
+
+#include <cstring>
+
+namespace mongo {
+
+    namespace {
+
+        void append64BE(std::string& buf, unsigned long long v) {
+            for (int shift = 56; shift >= 0; shift -= 8)
+                buf.push_back(static_cast<char>((v >> shift) & 0xFF));
+        }
+
+        /**
+         * IEEE 754 doubles of the same sign compare like their bit patterns;
+         * flipping the sign bit of positives and all bits of negatives makes
+         * the full range compare correctly as unsigned bytes.  NaN has no
+         * place in that order, so the caller falls back to BSON compare.
+         */
+        bool appendDouble(std::string& buf, double d) {
+            if (d != d)
+                return false; // NaN
+            unsigned long long bits;
+            memcpy(&bits, &d, sizeof(bits));
+            if (bits & (1ULL << 63))
+                bits = ~bits;
+            else
+                bits |= (1ULL << 63);
+            append64BE(buf, bits);
+            return true;
+        }
+
+    } // namespace
+
+    bool KeyString::reset(const BSONObj& key, const Ordering& ordering) {
+        _buf.clear();
+
+        unsigned mask = 1;
+        BSONObjIterator it(key);
+        while (it.more()) {
+            BSONElement e = it.next();
+            const size_t start = _buf.size();
+
+            // Discriminator in canonical type order, so cross-type comparisons
+            // (e.g. int vs string) come out the same way woCompare orders them.
+            _buf.push_back(static_cast<char>(canonicalizeBSONType(e.type()) + 1));
+
+            switch (e.type()) {
+            case MinKey:
+            case MaxKey:
+            case jstNULL:
+            case Undefined:
+                // the discriminator is the whole encoding
+                break;
+
+            case NumberInt:
+                appendDouble(_buf, e._numberInt()); // ints are never NaN
+                break;
+
+            case NumberDouble:
+                if (!appendDouble(_buf, e._numberDouble())) {
+                    _buf.clear();
+                    return false;
+                }
+                break;
+
+            case NumberLong: {
+                // All numeric types share a discriminator and encode as
+                // doubles so int/long/double mix the way woCompare mixes
+                // them; a long the double can't represent exactly would
+                // encode out of order, so bail on those.
+                long long v = e._numberLong();
+                double d = static_cast<double>(v);
+                if (static_cast<long long>(d) != v) {
+                    _buf.clear();
+                    return false;
+                }
+                appendDouble(_buf, d);
+                break;
+            }
+
+            case mongo::String:
+            case Symbol: {
+                // NUL-terminated so a prefix sorts before its extensions; a
+                // string containing NUL would terminate early and compare
+                // wrong, so bail on those (they are vanishingly rare in keys).
+                const int sz = e.valuestrsize() - 1; // excludes trailing NUL
+                const char* s = e.valuestr();
+                if (memchr(s, 0, sz)) {
+                    _buf.clear();
+                    return false;
+                }
+                _buf.append(s, sz);
+                _buf.push_back('\0');
+                break;
+            }
+
+            case jstOID:
+                _buf.append(e.value(), 12); // already big-endian-comparable
+                break;
+
+            case mongo::Bool:
+                _buf.push_back(*e.value() ? 1 : 0);
+                break;
+
+            case mongo::Date:
+                // signed millis; flipping the sign bit order-preserves
+                // two's complement as unsigned bytes
+                append64BE(_buf,
+                           static_cast<unsigned long long>(
+                                   static_cast<long long>(e.date().millis)) ^ (1ULL << 63));
+                break;
+
+            case Timestamp:
+                // unsigned compare for timestamps - note they are not really
+                // dates but (ordinal + time_t)
+                append64BE(_buf, e.date().millis);
+                break;
+
+            default:
+                // Object, Array, BinData, RegEx, DBRef, Code, CodeWScope:
+                // no order-preserving flat encoding; use BSON compare.
+                _buf.clear();
+                return false;
+            }
+
+            if (ordering.descending(mask)) {
+                // Inverting every byte of the field (discriminator included)
+                // reverses its contribution to the memcmp order.
+                for (size_t i = start; i < _buf.size(); i++)
+                    _buf[i] = ~_buf[i];
+            }
+            mask <<= 1;
+        }
+
+        return !_buf.empty();
+    }
+
+    int KeyString::compare(const KeyString& r) const {
+        const size_t common = _buf.size() < r._buf.size() ? _buf.size() : r._buf.size();
+        int x = memcmp(_buf.data(), r._buf.data(), common);
+        if (x)
+            return x < 0 ? -1 : 1;
+        if (_buf.size() == r._buf.size())
+            return 0;
+        return _buf.size() < r._buf.size() ? -1 : 1;
+    }
+
+} // namespace mongo
@@ -0,0 +1,89 @@
+// @file key_string.h order-preserving binary encoding of index keys
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/bson/ordering.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * An order-preserving binary encoding of an index key: for any two keys
+     * whose types are encodable, memcmp() of their encodings (with the size
+     * as tiebreaker, see compare()) yields the same ordering as
+     * BSONObj::woCompare() with considerFieldNames=false and the same
+     * Ordering.  The Ordering is baked in at encode time by inverting the
+     * bytes of descending fields, so the comparison itself needs no
+     * per-field bookkeeping.
+     *
+     * This is an encode-once / compare-many structure: encoding walks the key
+     * once (about the cost of a single woCompare), after which every
+     * comparison is a memcmp.  Not every BSON type has an order-preserving
+     * byte encoding here; reset() returns false and leaves the encoding
+     * empty for keys it cannot handle (objects, arrays, bindata, regex,
+     * NaN doubles, NumberLongs beyond double precision, strings with
+     * embedded NUL bytes), and callers fall back to woCompare for those.
+     * Because the encodings order identically to woCompare, encoded and
+     * unencoded keys can be mixed in one sort as long as mixed pairs use
+     * the fallback.
+     */
+    class KeyString {
+    public:
+        KeyString() {}
+
+        /**
+         * Encodes 'key' under 'ordering'.  Returns false and leaves the
+         * encoding empty when the key contains a type or value with no
+         * order-preserving encoding.
+         */
+        bool reset(const BSONObj& key, const Ordering& ordering);
+
+        /** Adopts previously encoded bytes (e.g. read back from a spill file). */
+        void resetFromBuffer(const char* data, size_t len) { _buf.assign(data, len); }
+
+        void clear() { _buf.clear(); }
+
+        /** true when there is no usable encoding (never reset, or reset failed) */
+        bool empty() const { return _buf.empty(); }
+
+        const char* data() const { return _buf.data(); }
+        size_t size() const { return _buf.size(); }
+
+        /** memcmp semantics; only meaningful when both sides are non-empty. */
+        int compare(const KeyString& r) const;
+
+    private:
+        std::string _buf;
+    };
+
+} // namespace mongo
@@ -0,0 +1,143 @@
+// key_string_test.cpp : KeyString unit tests
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/structure/btree/key_string.h"
+
+#include <limits>
+
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    int sign(int x) {
+        return x < 0 ? -1 : (x == 0 ? 0 : 1);
+    }
+
+    /**
+     * Asserts that both keys encode under 'ordering' and that comparing the
+     * encodings agrees with woCompare (considerFieldNames=false).
+     */
+    void assertSameOrder(const BSONObj& l, const BSONObj& r, const BSONObj& orderingPattern) {
+        const Ordering ordering = Ordering::make(orderingPattern);
+
+        KeyString lks;
+        KeyString rks;
+        ASSERT(lks.reset(l, ordering));
+        ASSERT(rks.reset(r, ordering));
+
+        const int expected = sign(l.woCompare(r, ordering, false));
+        ASSERT_EQUALS(expected, sign(lks.compare(rks)));
+        ASSERT_EQUALS(-expected, sign(rks.compare(lks)));
+    }
+
+    TEST(KeyString, NumericOrdering) {
+        const BSONObj asc = BSON("" << 1);
+        assertSameOrder(BSON("" << 1), BSON("" << 2), asc);
+        assertSameOrder(BSON("" << -1), BSON("" << 1), asc);
+        assertSameOrder(BSON("" << 0), BSON("" << 0.0), asc);
+        assertSameOrder(BSON("" << -0.0), BSON("" << 0), asc);
+        assertSameOrder(BSON("" << 1.5), BSON("" << 2), asc);
+        assertSameOrder(BSON("" << -1000000), BSON("" << 3.14), asc);
+        assertSameOrder(BSON("" << 5), BSON("" << 5LL), asc);
+        assertSameOrder(BSON("" << 1LL << "" << 2), BSON("" << 1 << "" << 3LL), asc);
+        assertSameOrder(BSON("" << std::numeric_limits<double>::infinity()),
+                        BSON("" << std::numeric_limits<double>::max()), asc);
+        assertSameOrder(BSON("" << -std::numeric_limits<double>::infinity()),
+                        BSON("" << -std::numeric_limits<double>::max()), asc);
+    }
+
+    TEST(KeyString, StringAndMixedTypeOrdering) {
+        const BSONObj asc = BSON("" << 1);
+        assertSameOrder(BSON("" << "abc"), BSON("" << "abd"), asc);
+        // a prefix sorts before its extensions
+        assertSameOrder(BSON("" << "ab"), BSON("" << "abc"), asc);
+        assertSameOrder(BSON("" << ""), BSON("" << "a"), asc);
+        // cross-type: null < number < string < oid < bool < date
+        assertSameOrder(BSON("" << BSONNULL), BSON("" << 5), asc);
+        assertSameOrder(BSON("" << 5), BSON("" << "5"), asc);
+        assertSameOrder(BSON("" << "zzz"), BSON("" << OID("497ce96f395f2f052a494fd4")), asc);
+        assertSameOrder(BSON("" << OID("497ce96f395f2f052a494fd4")), BSON("" << true), asc);
+        assertSameOrder(BSON("" << false), BSON("" << true), asc);
+        assertSameOrder(BSON("" << true), BSON("" << Date_t(0)), asc);
+        assertSameOrder(BSON("" << MINKEY), BSON("" << BSONNULL), asc);
+        assertSameOrder(BSON("" << Date_t(0)), BSON("" << MAXKEY), asc);
+    }
+
+    TEST(KeyString, DatesAndOIDs) {
+        const BSONObj asc = BSON("" << 1);
+        assertSameOrder(BSON("" << Date_t(1000)), BSON("" << Date_t(2000)), asc);
+        assertSameOrder(BSON("" << OID("000000000000000000000000")),
+                        BSON("" << OID("497ce96f395f2f052a494fd4")), asc);
+    }
+
+    TEST(KeyString, DescendingAndCompound) {
+        const BSONObj desc = BSON("" << -1);
+        assertSameOrder(BSON("" << 1), BSON("" << 2), desc);
+        assertSameOrder(BSON("" << "ab"), BSON("" << "abc"), desc);
+        assertSameOrder(BSON("" << BSONNULL), BSON("" << "x"), desc);
+
+        const BSONObj mixed = BSON("" << 1 << "" << -1);
+        assertSameOrder(BSON("" << 1 << "" << 1), BSON("" << 1 << "" << 2), mixed);
+        assertSameOrder(BSON("" << 1 << "" << "b"), BSON("" << 1 << "" << "a"), mixed);
+        assertSameOrder(BSON("" << 1 << "" << "x"), BSON("" << 2 << "" << "a"), mixed);
+    }
+
+    TEST(KeyString, Equality) {
+        const Ordering ordering = Ordering::make(BSON("" << 1));
+        KeyString a;
+        KeyString b;
+        ASSERT(a.reset(BSON("" << "abc" << "" << 42), ordering));
+        ASSERT(b.reset(BSON("" << "abc" << "" << 42.0), ordering));
+        ASSERT_EQUALS(0, a.compare(b));
+    }
+
+    TEST(KeyString, Unencodable) {
+        const Ordering ordering = Ordering::make(BSON("" << 1));
+        KeyString ks;
+
+        // no flat order-preserving encoding for these
+        ASSERT(!ks.reset(BSON("" << BSON("a" << 1)), ordering));
+        ASSERT(ks.empty());
+        ASSERT(!ks.reset(BSON("" << BSON_ARRAY(1 << 2)), ordering));
+        ASSERT(!ks.reset(BSON("" << std::numeric_limits<double>::quiet_NaN()), ordering));
+
+        // a long the double can't represent exactly would encode out of order
+        ASSERT(!ks.reset(BSON("" << ((1LL << 60) + 1)), ordering));
+        // ... but representable longs are fine
+        ASSERT(ks.reset(BSON("" << (1LL << 60)), ordering));
+
+        // embedded NUL would terminate the string encoding early
+        ASSERT(!ks.reset(BSON("" << std::string("a\0b", 3)), ordering));
+    }
+
+}  // namespace
+}  // namespace mongo
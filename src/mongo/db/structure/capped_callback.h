@@ -30,6 +30,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 
 namespace mongo {
@@ -49,6 +51,22 @@ namespace mongo {
          * This will be called right before loc is deleted when wrapping.
          */
         virtual Status aboutToDeleteCapped( OperationContext* txn, const DiskLoc& loc ) = 0;
+
+        /**
+         * Batch form of the above for wraparound reclamation: called once with every
+         * record the store is about to delete, before any of them is.  Implementations
+         * can amortize cursor invalidation over the batch; the default just forwards
+         * to the per-record hook.
+         */
+        virtual Status aboutToDeleteCappedBatch( OperationContext* txn,
+                                                 const std::vector<DiskLoc>& locs ) {
+            for ( size_t i = 0; i < locs.size(); i++ ) {
+                Status status = aboutToDeleteCapped( txn, locs[i] );
+                if ( !status.isOK() )
+                    return status;
+            }
+            return Status::OK();
+        }
     };
 
 }
@@ -167,6 +167,13 @@ namespace mongo {
                                           const DiskLoc& loc,
                                           const char* damangeSource,
                                           const mutablebson::DamageVector& damages ) = 0;
+
+        /**
+         * Damage offsets refer to the raw document bytes, so a store that does not
+         * keep the record at 'loc' as raw bytes (e.g. a compressed record) cannot
+         * apply them; callers must check before choosing the in-place update path.
+         */
+        virtual bool updateWithDamagesSupported( const DiskLoc& loc ) const { return true; }
         /**
          * returned iterator owned by caller
          * canonical to get all would be
@@ -229,6 +236,23 @@ namespace mongo {
                                  ValidateAdaptor* adaptor,
                                  ValidateResults* results, BSONObjBuilder* output ) const = 0;
 
+        /**
+         * Validates one allocation region of the store (an extent for mmapv1) so a
+         * caller can spread a whole-store check over many short lock acquisitions.
+         * Pass a null 'startToken' to begin at the first region; '*nextToken' is set
+         * to the token for the following region, or null once the store has been
+         * covered.  Corruption is reported through 'results' as with validate().
+         * Storage engines without an incremental walk return InvalidOptions.
+         */
+        virtual Status validateOnlineStep( OperationContext* txn,
+                                           const DiskLoc& startToken,
+                                           DiskLoc* nextToken,
+                                           long long* nRecords,
+                                           ValidateResults* results ) const {
+            return Status( ErrorCodes::InvalidOptions,
+                           "storage engine does not support online validation" );
+        }
+
         /**
          * @param scaleSize - amount by which to scale size metrics
          * appends any custom stats from the RecordStore or other unique stats
@@ -242,6 +266,18 @@ namespace mongo {
          */
         virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const = 0;
 
+        /**
+         * Pages in up to 'numExtents' extents of record data starting with the extent at
+         * 'firstExtentLoc', following the extent chain forward or backward.  Best effort
+         * hint used by background scan readahead; stores without a physical extent layout
+         * may ignore it.
+         */
+        virtual Status touchExtents( const DiskLoc& firstExtentLoc,
+                                     int numExtents,
+                                     bool forward ) const {
+            return Status::OK();
+        }
+
         /**
          * @return Status::OK() if option hanlded
          *         InvalidOptions is option not supported
@@ -30,12 +30,21 @@
 
 #include "mongo/db/structure/record_store_v1_base.h"
 
+#ifdef __linux__
+#include <sys/mman.h>  // madvise
+#endif
+
+#include <boost/static_assert.hpp>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
+#include "mongo/db/stats/working_set_heat.h"
 #include "mongo/db/structure/record_store_v1_repair_iterator.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/touch_pages.h"
@@ -56,6 +65,51 @@ namespace mongo {
         0x200000, 0x400000, 0x1000000,            // 2M,   4M,   16M (see above)
      };
 
+    BOOST_STATIC_ASSERT( RecordStoreV1Base::PaddingProfile::NumBuckets == 19 );
+
+    namespace {
+        /**
+         * A compressed record replaces the raw document bytes with a small frame:
+         *     int32  magic (negative, so it can never read as a BSON length)
+         *     int32  uncompressed document length
+         *     int32  compressed length
+         *     snappy-compressed document bytes
+         * Record allocations are padded and quantized, so the compressed length is
+         * stored explicitly rather than derived from the record's net length.
+         */
+        const int kCompressedRecordMagic = -1698889547;
+        const int kCompressedRecordHeaderSize = 12;
+
+        bool isCompressedRecData( const char* data, int len ) {
+            return len >= kCompressedRecordHeaderSize &&
+                   *reinterpret_cast<const int*>( data ) == kCompressedRecordMagic;
+        }
+    }
+
+    // A padding profile bucket is only trusted once this many updates have been seen in it.
+    static const long long kPaddingProfileMinSamples = 256;
+
+    RecordStoreV1Base::PaddingProfile::PaddingProfile() {
+        memset( fits, 0, sizeof( fits ) );
+        memset( grows, 0, sizeof( grows ) );
+        paddedBytes = 0;
+    }
+
+    bool RecordStoreV1Base::PaddingProfile::isStable( int bucketIdx ) const {
+        const long long samples = fits[bucketIdx] + grows[bucketIdx];
+        if ( samples < kPaddingProfileMinSamples )
+            return false; // not enough data; keep padding conservatively
+        // stable if fewer than 0.5% of observed updates outgrew their allocation
+        return grows[bucketIdx] * 200 < samples;
+    }
+
+
+    RecordStoreV1Base::CompressionStats::CompressionStats() {
+        rawBytesWritten = 0;
+        storedBytesWritten = 0;
+        recordsCompressed = 0;
+        recordsStoredRaw = 0;
+    }
 
     RecordStoreV1Base::RecordStoreV1Base( const StringData& ns,
                                           RecordStoreV1MetaData* details,
@@ -101,7 +155,76 @@ namespace mongo {
     }
 
     RecordData RecordStoreV1Base::dataFor( const DiskLoc& loc ) const {
-        return recordFor(loc)->toRecordData();
+        Record* rec = recordFor(loc);
+        // sampled page-residency probe; covers documents and btree buckets alike
+        WorkingSetHeat::global.noteAccess( _ns, rec->data() );
+        if ( _isCompressedRecord( rec ) )
+            return _decompressRecordData( rec );
+        return rec->toRecordData();
+    }
+
+    bool RecordStoreV1Base::_compressionEnabled() const {
+        // IndexDetails points at system.indexes records by disk location; keep those raw
+        return !_isSystemIndexes && _details->isUserFlagSet( Flag_CompressRecords );
+    }
+
+    bool RecordStoreV1Base::_isCompressedRecord( const Record* rec ) {
+        return isCompressedRecData( rec->data(), rec->netLength() );
+    }
+
+    int RecordStoreV1Base::_compressedFrameLength( const Record* rec ) {
+        dassert( _isCompressedRecord( rec ) );
+        return kCompressedRecordHeaderSize +
+               reinterpret_cast<const int*>( rec->data() )[2];
+    }
+
+    bool RecordStoreV1Base::_maybeCompress( const char* data, int len, std::string* out ) {
+        if ( !_compressionEnabled() )
+            return false;
+
+        std::string body;
+        compress( data, len, &body );
+
+        const int compressedLen = static_cast<int>( body.size() );
+        if ( kCompressedRecordHeaderSize + compressedLen >= len ) {
+            // incompressible document; store the raw bytes
+            _compressionStats.recordsStoredRaw++;
+            _compressionStats.rawBytesWritten += len;
+            _compressionStats.storedBytesWritten += len;
+            return false;
+        }
+
+        out->clear();
+        out->reserve( kCompressedRecordHeaderSize + compressedLen );
+        out->append( reinterpret_cast<const char*>( &kCompressedRecordMagic ), 4 );
+        out->append( reinterpret_cast<const char*>( &len ), 4 );
+        out->append( reinterpret_cast<const char*>( &compressedLen ), 4 );
+        out->append( body );
+
+        _compressionStats.recordsCompressed++;
+        _compressionStats.rawBytesWritten += len;
+        _compressionStats.storedBytesWritten += out->size();
+        return true;
+    }
+
+    RecordData RecordStoreV1Base::_decompressRecordData( const Record* rec ) const {
+        const char* frame = rec->data();
+        const int uncompressedLen = reinterpret_cast<const int*>( frame )[1];
+        const int compressedLen = reinterpret_cast<const int*>( frame )[2];
+        massert( 18575, "corrupt compressed record header",
+                 uncompressedLen >= 5 &&
+                 uncompressedLen <= BSONObjMaxInternalSize &&
+                 compressedLen > 0 &&
+                 kCompressedRecordHeaderSize + compressedLen <= rec->netLength() );
+
+        boost::shared_ptr<std::string> doc( new std::string() );
+        massert( 18576, "unable to decompress record",
+                 uncompress( frame + kCompressedRecordHeaderSize,
+                             compressedLen,
+                             doc.get() ) );
+        massert( 18577, "decompressed record has unexpected length",
+                 static_cast<int>( doc->size() ) == uncompressedLen );
+        return RecordData( doc );
     }
 
     Record* RecordStoreV1Base::recordFor( const DiskLoc& loc ) const {
@@ -251,6 +374,12 @@ namespace mongo {
                                         "record has to be >= 4 bytes" );
         }
 
+        std::string compressed;
+        if ( _maybeCompress( data, len, &compressed ) ) {
+            data = compressed.data();
+            len = compressed.size();
+        }
+
         StatusWith<DiskLoc> status = _insertRecord( txn, data, len, quotaMax );
         if ( status.isOK() )
             _paddingFits( txn );
@@ -291,8 +420,16 @@ namespace mongo {
                                                          int quotaMax,
                                                          UpdateMoveNotifier* notifier ) {
         Record* oldRecord = recordFor( oldLocation );
+
+        std::string compressed;
+        if ( _maybeCompress( data, dataSize, &compressed ) ) {
+            data = compressed.data();
+            dataSize = compressed.size();
+        }
+
         if ( oldRecord->netLength() >= dataSize ) {
             // we fit
+            _paddingProfile.fits[ bucket( oldRecord->lengthWithHeaders() ) ]++;
             _paddingFits( txn );
             memcpy( txn->recoveryUnit()->writingPtr( oldRecord->data(), dataSize ), data, dataSize );
             return StatusWith<DiskLoc>( oldLocation );
@@ -305,6 +442,7 @@ namespace mongo {
 
         // we have to move
 
+        _paddingProfile.grows[ bucket( oldRecord->lengthWithHeaders() ) ]++;
         _paddingTooSmall( txn );
 
         StatusWith<DiskLoc> newLocation = _insertRecord( txn, data, dataSize, quotaMax );
@@ -313,10 +451,13 @@ namespace mongo {
 
         // insert worked, so we delete old record
         if ( notifier ) {
+            // the notifier interprets the old record as a document, so hand it
+            // decompressed bytes when the old record was written compressed
+            RecordData oldData = dataFor( oldLocation );
             Status moveStatus = notifier->recordStoreGoingToMove( txn,
                                                                   oldLocation,
-                                                                  oldRecord->data(),
-                                                                  oldRecord->netLength() );
+                                                                  oldData.data(),
+                                                                  oldData.size() );
             if ( !moveStatus.isOK() )
                 return StatusWith<DiskLoc>( moveStatus );
         }
@@ -334,6 +475,11 @@ namespace mongo {
         _paddingFits( txn );
 
         Record* rec = recordFor( loc );
+
+        // damage offsets refer to the raw document; callers must have checked
+        // updateWithDamagesSupported() before taking the in-place path
+        invariant( !_isCompressedRecord( rec ) );
+
         char* root = rec->data();
 
         // All updates were in place. Apply them via durability and writing pointer.
@@ -348,6 +494,12 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool RecordStoreV1Base::updateWithDamagesSupported( const DiskLoc& loc ) const {
+        // the record check covers compressed records that survive collMod turning
+        // compression back off
+        return !_compressionEnabled() && !_isCompressedRecord( recordFor( loc ) );
+    }
+
     void RecordStoreV1Base::deleteRecord( OperationContext* txn, const DiskLoc& dl ) {
 
         Record* todelete = recordFor( dl );
@@ -661,7 +813,8 @@ namespace mongo {
 
                     if (full){
                         size_t dataSize = 0;
-                        const Status status = adaptor->validate( r->toRecordData(), &dataSize );
+                        // dataFor() decompresses, so the adaptor always sees a document
+                        const Status status = adaptor->validate( dataFor( cl ), &dataSize );
                         if (!status.isOK()) {
                             results->valid = false;
                             if (nInvalid == 0) // only log once;
@@ -771,11 +924,149 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status RecordStoreV1Base::validateOnlineStep( OperationContext* txn,
+                                                  const DiskLoc& startToken,
+                                                  DiskLoc* nextToken,
+                                                  long long* nRecords,
+                                                  ValidateResults* results ) const {
+        *nextToken = DiskLoc();
+        *nRecords = 0;
+
+        const DiskLoc extLoc = startToken.isNull() ? _details->firstExtent() : startToken;
+        if ( extLoc.isNull() )
+            return Status::OK(); // empty collection; nothing left to check
+
+        try {
+            Extent* ext = _getExtent( extLoc );
+
+            if ( !ext->validates( extLoc, &results->errors ) ) {
+                // Don't walk the record chain of an extent whose header is bad.
+                results->valid = false;
+                return Status::OK();
+            }
+
+            *nextToken = ext->xnext;
+
+            if ( !ext->xnext.isNull() && _getExtent( ext->xnext )->xprev != extLoc ) {
+                StringBuilder sb;
+                sb << "'xprev' pointer " << _getExtent( ext->xnext )->xprev.toString()
+                   << " in extent " << ext->xnext.toString()
+                   << " does not point to extent " << extLoc.toString();
+                results->errors.push_back( sb.str() );
+                results->valid = false;
+            }
+
+            // A cycle in the record chain would otherwise walk forever; no intact
+            // extent can hold more records than this.
+            const long long maxRecords = ext->length / Record::HeaderSize;
+
+            int prevOfs = DiskLoc::NullOfs;
+            DiskLoc recLoc = ext->firstRecord;
+            while ( !recLoc.isNull() ) {
+                if ( recLoc.a() != extLoc.a() ||
+                     recLoc.getOfs() < extLoc.getOfs() + Extent::HeaderSize() ||
+                     recLoc.getOfs() + Record::HeaderSize > extLoc.getOfs() + ext->length ) {
+                    StringBuilder sb;
+                    sb << "record " << recLoc.toString()
+                       << " is outside extent " << extLoc.toString();
+                    results->errors.push_back( sb.str() );
+                    results->valid = false;
+                    break;
+                }
+
+                Record* r = recordFor( recLoc );
+
+                if ( r->lengthWithHeaders() < Record::HeaderSize ||
+                     recLoc.getOfs() + r->lengthWithHeaders() >
+                         extLoc.getOfs() + ext->length ) {
+                    StringBuilder sb;
+                    sb << "record " << recLoc.toString()
+                       << " has invalid length " << r->lengthWithHeaders();
+                    results->errors.push_back( sb.str() );
+                    results->valid = false;
+                    break;
+                }
+
+                if ( r->prevOfs() != prevOfs ) {
+                    StringBuilder sb;
+                    sb << "record " << recLoc.toString()
+                       << " 'prevOfs' is " << r->prevOfs()
+                       << ", expected " << prevOfs;
+                    results->errors.push_back( sb.str() );
+                    results->valid = false;
+                    break;
+                }
+
+                if ( ++(*nRecords) > maxRecords ) {
+                    StringBuilder sb;
+                    sb << "record chain in extent " << extLoc.toString()
+                       << " does not terminate (cycle?)";
+                    results->errors.push_back( sb.str() );
+                    results->valid = false;
+                    break;
+                }
+
+                prevOfs = recLoc.getOfs();
+                recLoc = r->nextOfs() == DiskLoc::NullOfs
+                       ? DiskLoc()
+                       : DiskLoc( recLoc.a(), r->nextOfs() );
+            }
+        }
+        catch ( const DBException& e ) {
+            StringBuilder sb;
+            sb << "exception validating extent " << extLoc.toString() << ": " << e.what();
+            results->errors.push_back( sb.str() );
+            results->valid = false;
+        }
+
+        return Status::OK();
+    }
+
     void RecordStoreV1Base::appendCustomStats( BSONObjBuilder* result, double scale ) const {
         result->append( "lastExtentSize", _details->lastExtentSize() / scale );
         result->append( "paddingFactor", _details->paddingFactor() );
         result->append( "userFlags", _details->userFlags() );
 
+        {
+            // move rate vs padding overhead, so the padding profile's effect is observable
+            BSONObjBuilder pad( result->subobjStart( "paddingStats" ) );
+            long long fits = 0;
+            long long grows = 0;
+            BSONArrayBuilder stable( pad.subarrayStart( "unpaddedBuckets" ) );
+            for ( int i = 0; i < Buckets; i++ ) {
+                fits += _paddingProfile.fits[i];
+                grows += _paddingProfile.grows[i];
+                if ( _paddingProfile.isStable( i ) )
+                    stable.append( bucketSizes[i] );
+            }
+            stable.done();
+            pad.appendNumber( "updatesFitInPlace", fits );
+            pad.appendNumber( "updatesMoved", grows );
+            pad.append( "moveFraction",
+                        fits + grows > 0 ? static_cast<double>( grows ) / ( fits + grows ) : 0 );
+            pad.append( "paddingAllocatedBytes", _paddingProfile.paddedBytes / scale );
+            pad.done();
+        }
+
+        if ( _details->isUserFlagSet( Flag_CompressRecords ) ||
+             _compressionStats.recordsCompressed > 0 ) {
+            // 'size' above reflects stored (compressed) bytes; report the logical
+            // document bytes beside them.  Counters cover writes since startup.
+            BSONObjBuilder comp( result->subobjStart( "recordCompression" ) );
+            comp.append( "codec", "snappy" );
+            comp.appendBool( "enabled", _details->isUserFlagSet( Flag_CompressRecords ) );
+            comp.append( "rawBytesWritten", _compressionStats.rawBytesWritten / scale );
+            comp.append( "storedBytesWritten", _compressionStats.storedBytesWritten / scale );
+            comp.appendNumber( "recordsCompressed", _compressionStats.recordsCompressed );
+            comp.appendNumber( "recordsStoredRaw", _compressionStats.recordsStoredRaw );
+            comp.append( "effectiveRatio",
+                         _compressionStats.storedBytesWritten > 0
+                             ? static_cast<double>( _compressionStats.rawBytesWritten ) /
+                                   _compressionStats.storedBytesWritten
+                             : 1.0 );
+            comp.done();
+        }
+
         if ( isCapped() ) {
             result->appendBool( "capped", true );
             result->appendNumber( "max", _details->maxCappedDocs() );
@@ -831,6 +1122,35 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status RecordStoreV1Base::touchExtents( const DiskLoc& firstExtentLoc,
+                                            int numExtents,
+                                            bool forward ) const {
+        DiskLoc extLoc = firstExtentLoc;
+        for ( int i = 0; i < numExtents && !extLoc.isNull(); i++ ) {
+            // The extent chain may have changed since the caller looked at it (it is a
+            // readahead hint, not a snapshot); a file that has gone away means the rest
+            // of the request is stale.
+            if ( static_cast<size_t>( extLoc.a() ) >= _extentManager->numFiles() )
+                break;
+
+            Extent* ext = _getExtent( extLoc );
+
+#ifdef __linux__
+            // Hint the whole range first so the kernel can batch the disk reads while
+            // touch_pages faults the pages in order below.
+            char* aligned = static_cast<char*>( const_cast<void*>(
+                ProcessInfo::alignToStartOfPage( ext ) ) );
+            size_t advLength = ext->length + ( reinterpret_cast<char*>( ext ) - aligned );
+            madvise( aligned, advLength, MADV_WILLNEED );
+#endif
+
+            touch_pages( reinterpret_cast<const char*>( ext ), ext->length );
+
+            extLoc = forward ? ext->xnext : ext->xprev;
+        }
+        return Status::OK();
+    }
+
     int RecordStoreV1Base::getRecordAllocationSize( int minRecordSize ) const {
 
         if ( isCapped() )
@@ -843,8 +1163,15 @@ namespace mongo {
             return quantizePowerOf2AllocationSpace(minRecordSize);
         }
 
+        // skip the padding factor for size classes whose documents have been observed
+        // not to grow; see PaddingProfile
+        if ( _paddingProfile.isStable( bucket( minRecordSize ) ) )
+            return minRecordSize;
+
         // adjust for padding factor
-        return static_cast<int>(minRecordSize * _details->paddingFactor());
+        const int allocSize = static_cast<int>(minRecordSize * _details->paddingFactor());
+        _paddingProfile.paddedBytes += allocSize - minRecordSize;
+        return allocSize;
     }
 
     DiskLoc RecordStoreV1Base::IntraExtentIterator::getNext() {
@@ -952,6 +1279,26 @@ namespace mongo {
             return Status::OK();
         }
 
+        if ( str::equals( "compressRecords", option.fieldName() ) ) {
+            // takes effect for records written from here on; existing records are
+            // left as they are and stay readable either way
+            bool oldCompress = _details->isUserFlagSet( Flag_CompressRecords );
+            bool newCompress = option.trueValue();
+
+            if ( oldCompress != newCompress ) {
+                info->appendBool( "compressRecords_old", oldCompress );
+
+                if ( newCompress )
+                    _details->setUserFlag( txn, Flag_CompressRecords );
+                else
+                    _details->clearUserFlag( txn, Flag_CompressRecords );
+
+                info->appendBool( "compressRecords_new", newCompress );
+            }
+
+            return Status::OK();
+        }
+
         return Status( ErrorCodes::InvalidOptions,
                        str::stream() << "no such option: " << option.fieldName() );
     }
@@ -106,7 +106,48 @@ namespace mongo {
         static const int bucketSizes[];
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_CompressRecords = 1 << 1
+        };
+
+        /**
+         * Compact per-size-bucket growth profile for one collection.  Updates that fit in
+         * place and updates that outgrew their allocation are counted against the
+         * deleted-record bucket of the old record; once a bucket has enough samples and
+         * essentially none of them grew, new allocations in that size class skip the
+         * padding factor entirely.  Kept in memory on the record store (NamespaceDetails
+         * has a fixed on-disk layout), so the profile rebuilds from live traffic after
+         * startup.
+         */
+        struct PaddingProfile {
+            static const int NumBuckets = 19; // == Buckets, enforced in the .cpp
+
+            PaddingProfile();
+
+            /**
+             * True if enough updates in 'bucketIdx' have been observed and essentially
+             * none of them outgrew their allocation, i.e. padding there is only waste.
+             */
+            bool isStable( int bucketIdx ) const;
+
+            long long fits[NumBuckets];   // in-place updates per bucket
+            long long grows[NumBuckets];  // updates per bucket that had to move
+            long long paddedBytes;        // bytes allocated beyond the minimum record size
+        };
+
+        /**
+         * Write counters for record compression (Flag_CompressRecords), so collStats
+         * can report logical document bytes next to what was actually stored.  Like
+         * PaddingProfile, kept in memory on the record store and rebuilt from live
+         * traffic after startup.
+         */
+        struct CompressionStats {
+            CompressionStats();
+
+            long long rawBytesWritten;    // document bytes handed to the store
+            long long storedBytesWritten; // bytes actually placed in records
+            long long recordsCompressed;
+            long long recordsStoredRaw;   // compression enabled but not worthwhile
         };
 
         // ------------
@@ -155,6 +196,12 @@ namespace mongo {
                                           const char* damangeSource,
                                           const mutablebson::DamageVector& damages );
 
+        /**
+         * False when record compression is enabled or the record at 'loc' was
+         * written compressed, since damages target raw document offsets.
+         */
+        virtual bool updateWithDamagesSupported( const DiskLoc& loc ) const;
+
         virtual RecordIterator* getIteratorForRepair() const;
 
         void increaseStorageSize( OperationContext* txn, int size, int quotaMax );
@@ -164,10 +211,25 @@ namespace mongo {
                                  ValidateAdaptor* adaptor,
                                  ValidateResults* results, BSONObjBuilder* output ) const;
 
+        /**
+         * One extent's worth of validation: extent header and linkage checks plus a
+         * bounds- and link-checked walk of its record chain.  The token is the
+         * extent's DiskLoc.
+         */
+        virtual Status validateOnlineStep( OperationContext* txn,
+                                           const DiskLoc& startToken,
+                                           DiskLoc* nextToken,
+                                           long long* nRecords,
+                                           ValidateResults* results ) const;
+
         virtual void appendCustomStats( BSONObjBuilder* result, double scale ) const;
 
         virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
 
+        virtual Status touchExtents( const DiskLoc& firstExtentLoc,
+                                     int numExtents,
+                                     bool forward ) const;
+
         const RecordStoreV1MetaData* details() const { return _details.get(); }
 
         /**
@@ -245,6 +307,29 @@ namespace mongo {
         void _paddingTooSmall( OperationContext* txn );
         void _paddingFits( OperationContext* txn );
 
+        // true if new records for this store should be written through the codec
+        bool _compressionEnabled() const;
+
+        /**
+         * True if the record at 'rec' holds a compressed frame rather than raw
+         * document bytes.  Each record is self-describing, so collections where
+         * compression was toggled by collMod read back correctly record by record.
+         */
+        static bool _isCompressedRecord( const Record* rec );
+
+        // exact frame size of a compressed record, excluding allocation padding
+        static int _compressedFrameLength( const Record* rec );
+
+        /**
+         * Compresses 'data' into a framed buffer in 'out' when compression is
+         * enabled and actually shrinks the document.  Returns false (leaving the
+         * caller to store the raw bytes) otherwise.
+         */
+        bool _maybeCompress( const char* data, int len, std::string* out );
+
+        // decompresses into a buffer owned by the returned RecordData
+        RecordData _decompressRecordData( const Record* rec ) const;
+
         /**
          * internal
          * doesn't check inputs or change padding
@@ -258,6 +343,11 @@ namespace mongo {
         ExtentManager* _extentManager;
         bool _isSystemIndexes;
 
+        // mutable so the const allocation-size path can account the padding it hands out
+        mutable PaddingProfile _paddingProfile;
+
+        CompressionStats _compressionStats;
+
         friend class RecordStoreV1RepairIterator;
     };
 
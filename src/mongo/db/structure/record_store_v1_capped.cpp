@@ -30,6 +30,7 @@
 
 #include "mongo/db/structure/record_store_v1_capped.h"
 
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
@@ -58,6 +59,11 @@
 
 namespace mongo {
 
+    // When the oplog's write head has to reclaim space, free at least this many
+    // bytes at once so the delete path runs for occasional batches rather than
+    // on every insert.  See allocRecord().
+    static const int kOplogReclaimAheadBytes = 256 * 1024;
+
     CappedRecordStoreV1::CappedRecordStoreV1( OperationContext* txn,
                                               CappedDocumentDeleteCallback* collection,
                                               const StringData& ns,
@@ -162,24 +168,63 @@ namespace mongo {
                     continue;
                 }
 
+                // For the oplog, batch the tail reclamation: free a run of
+                // records ahead of the immediate need and compact the extent's
+                // deleted list once, instead of paying a compact() per deleted
+                // record.  Most subsequent writes then find room on the deleted
+                // list without entering the delete path at all.  User capped
+                // collections keep the one-record-at-a-time behavior, where
+                // retaining fewer documents than capacity would be visible.
+                int reclaimTarget = 0;
+                if ( NamespaceString::oplog( _ns ) ) {
+                    reclaimTarget = lenToAlloc > kOplogReclaimAheadBytes
+                                  ? lenToAlloc
+                                  : kOplogReclaimAheadBytes;
+                }
+
+                // Gather the whole batch of victims before deleting any of them, so
+                // readers are invalidated with a single pass over the cursor cache
+                // (aboutToDeleteCappedBatch) instead of a pass per record.
+                int reclaimed = 0;
+                vector<DiskLoc> toDelete;
                 DiskLoc fr = theCapExtent()->firstRecord;
-                Status status = _deleteCallback->aboutToDeleteCapped( txn, fr );
-                if ( !status.isOK() )
-                    return StatusWith<DiskLoc>( status );
-                deleteRecord( txn, fr );
+                do {
+                    if ( fr.isNull() )
+                        break; // extent drained; the outer loop advances it
+
+                    if ( !_details->capFirstNewRecord().isNull() &&
+                         fr == _details->capFirstNewRecord() )
+                        break; // caught up to this iteration's write head
+
+                    toDelete.push_back( fr );
+                    reclaimed += recordFor( fr )->lengthWithHeaders();
+
+                    if( ++passes > maxPasses ) {
+                        StringBuilder sb;
+                        sb << "passes >= maxPasses in CappedRecordStoreV1::cappedAlloc: ns: "
+                           << _ns
+                           << ", lenToAlloc: " << lenToAlloc
+                           << ", maxPasses: " << maxPasses
+                           << ", _maxDocsInCapped: " << _details->maxCappedDocs()
+                           << ", nrecords: " << _details->numRecords()
+                           << ", datasize: " << _details->dataSize();
+
+                        return StatusWith<DiskLoc>( ErrorCodes::InternalError, sb.str() );
+                    }
 
-                compact(txn);
-                if( ++passes > maxPasses ) {
-                    StringBuilder sb;
-                    sb << "passes >= maxPasses in CappedRecordStoreV1::cappedAlloc: ns: " << _ns
-                       << ", lenToAlloc: " << lenToAlloc
-                       << ", maxPasses: " << maxPasses
-                       << ", _maxDocsInCapped: " << _details->maxCappedDocs()
-                       << ", nrecords: " << _details->numRecords()
-                       << ", datasize: " << _details->dataSize();
-
-                    return StatusWith<DiskLoc>( ErrorCodes::InternalError, sb.str() );
+                    fr = getNextRecordInExtent( fr );
+                } while ( reclaimed < reclaimTarget );
+
+                if ( !toDelete.empty() ) {
+                    Status status = _deleteCallback->aboutToDeleteCappedBatch( txn, toDelete );
+                    if ( !status.isOK() )
+                        return StatusWith<DiskLoc>( status );
+                    for ( size_t d = 0; d < toDelete.size(); d++ ) {
+                        deleteRecord( txn, toDelete[d] );
+                    }
                 }
+
+                compact(txn);
             }
 
             // Remember first record allocated on this iteration through capExtent.
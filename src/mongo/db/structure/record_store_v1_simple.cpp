@@ -40,6 +40,7 @@
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/structure/record_store_v1_simple_iterator.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -63,6 +64,52 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> dFreelist3( "storage.freelist.search.scanned",
                                                           &freelistIterations );
 
+    /** When set, SimpleRecordStoreV1 keeps per-bucket lock-free stacks of deleted
+        records, populated lazily from the on-disk chains, so allocation is an O(1) pop
+        instead of a chain scan under the database lock.  Records sitting in the cache
+        are already unlinked on disk, so a hard crash can orphan up to a refill batch
+        per bucket; compact reclaims them.
+    */
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(useLockFreeRecordAllocator, bool, false);
+
+    DeletedRecordStack::~DeletedRecordStack() {
+        Node* n = reinterpret_cast<Node*>( _head.load() );
+        while ( n ) {
+            Node* next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+    void DeletedRecordStack::push( const DiskLoc& loc, int lengthWithHeaders ) {
+        Node* n = new Node();
+        n->loc = loc;
+        n->lengthWithHeaders = lengthWithHeaders;
+        while ( 1 ) {
+            unsigned long long head = _head.load();
+            n->next = reinterpret_cast<Node*>( head );
+            if ( _head.compareAndSwap( head,
+                                       reinterpret_cast<uintptr_t>( n ) ) == head )
+                return;
+        }
+    }
+
+    bool DeletedRecordStack::pop( DiskLoc* loc, int* lengthWithHeaders ) {
+        while ( 1 ) {
+            unsigned long long head = _head.load();
+            if ( !head )
+                return false;
+            Node* n = reinterpret_cast<Node*>( head );
+            if ( _head.compareAndSwap( head,
+                                       reinterpret_cast<uintptr_t>( n->next ) ) == head ) {
+                *loc = n->loc;
+                *lengthWithHeaders = n->lengthWithHeaders;
+                delete n;
+                return true;
+            }
+        }
+    }
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( OperationContext* txn,
                                               const StringData& ns,
                                               RecordStoreV1MetaData* details,
@@ -77,6 +124,8 @@ namespace mongo {
             _details->setPaddingFactor(txn, 1.0);
         }
 
+        if ( useLockFreeRecordAllocator )
+            _freelistCache.reset( new DeletedRecordStack[Buckets] );
     }
 
     SimpleRecordStoreV1::~SimpleRecordStoreV1() {
@@ -89,7 +138,12 @@ namespace mongo {
 
         freelistAllocs.increment();
         DiskLoc loc;
-        {
+        if ( _freelistCache ) {
+            loc = _allocFromFreelistCache( txn, lenToAlloc );
+            if ( loc.isNull() )
+                return loc; // out of space. alloc a new extent.
+        }
+        else {
             DiskLoc *prev = 0;
             DiskLoc *bestprev = 0;
             DiskLoc bestmatch;
@@ -225,6 +279,76 @@ namespace mongo {
 
     }
 
+    DiskLoc SimpleRecordStoreV1::_allocFromFreelistCache( OperationContext* txn,
+                                                          int lenToAlloc ) {
+        int b = bucket(lenToAlloc);
+
+        DiskLoc loc;
+        int len;
+
+        // a record in our own bucket may still be smaller than lenToAlloc (a bucket
+        // covers a size range), so allow one probe there before moving up
+        bool have = _freelistCache[b].pop( &loc, &len );
+        if ( !have && _refillFreelistCache( txn, b ) > 0 )
+            have = _freelistCache[b].pop( &loc, &len );
+        if ( have ) {
+            if ( len >= lenToAlloc ) {
+                freelistIterations.increment();
+                return loc;
+            }
+            _freelistCache[b].push( loc, len );
+            freelistBucketExhausted.increment();
+        }
+
+        // everything in a higher bucket is guaranteed big enough
+        for ( b++; b <= MaxBucket; b++ ) {
+            if ( _freelistCache[b].pop( &loc, &len ) ||
+                 ( _refillFreelistCache( txn, b ) > 0 &&
+                   _freelistCache[b].pop( &loc, &len ) ) ) {
+                dassert( len >= lenToAlloc );
+                freelistIterations.increment();
+                return loc;
+            }
+        }
+
+        return DiskLoc();
+    }
+
+    int SimpleRecordStoreV1::_refillFreelistCache( OperationContext* txn, int bucketNum ) {
+        const int BatchSize = 64;
+
+        int n = 0;
+        DiskLoc cur = _details->deletedListEntry(bucketNum);
+        while ( !cur.isNull() && n < BatchSize ) {
+            { // defensive check, mirrors the scan path
+                int fileNumber = cur.a();
+                int fileOffset = cur.getOfs();
+                if (fileNumber < -1 || fileNumber >= 100000 || fileOffset < 0) {
+                    StringBuilder sb;
+                    sb << "Deleted record list corrupted in collection " << _ns
+                       << ", bucket " << bucketNum
+                       << ", link number " << n
+                       << ", invalid link is " << cur.toString()
+                       << ", throwing Fatal Assertion";
+                    log() << sb.str() << endl;
+                    fassertFailed(18503);
+                }
+            }
+
+            DeletedRecord* r = drec(cur);
+            const DiskLoc next = r->nextDeleted();
+            *txn->recoveryUnit()->writing(&r->nextDeleted()) = DiskLoc().setInvalid(); // defensive.
+            _freelistCache[bucketNum].push( cur, r->lengthWithHeaders() );
+            cur = next;
+            n++;
+        }
+        if ( n > 0 ) {
+            _details->setDeletedListEntry(txn, bucketNum, cur);
+            freelistIterations.increment( n );
+        }
+        return n;
+    }
+
     StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord( OperationContext* txn,
                                                           int lengthWithHeaders,
                                                           int quotaMax ) {
@@ -270,11 +394,137 @@ namespace mongo {
                        "SimpleRecordStoreV1::truncate not implemented" );
     }
 
+    StatusWith<long long> SimpleRecordStoreV1::truncateHeadExtent( OperationContext* txn ) {
+        const DiskLoc headLoc = _details->firstExtent();
+        invariant( !headLoc.isNull() );
+        Extent* head = _extentManager->getExtent( headLoc );
+        head->assertOk();
+
+        if ( head->xnext.isNull() )
+            return StatusWith<long long>( ErrorCodes::IllegalOperation,
+                                          "cannot free a collection's only extent" );
+
+        // tally what we are about to free
+        long long numRecords = 0;
+        long long dataSize = 0;
+        for ( DiskLoc loc = head->firstRecord;
+              !loc.isNull();
+              loc = getNextRecordInExtent( loc ) ) {
+            dataSize += recordFor( loc )->netLength();
+            numRecords++;
+        }
+
+        _purgeExtentFromFreeLists( txn, headLoc );
+
+        // unlink the extent and give it back, as _compactExtent does
+        DiskLoc newFirst = head->xnext;
+        _details->setFirstExtent( txn, newFirst );
+        *txn->recoveryUnit()->writing( &_extentManager->getExtent( newFirst )->xprev ) = DiskLoc();
+        _details->incrementStats( txn, -dataSize, -numRecords );
+        _extentManager->freeExtent( txn, headLoc );
+
+        // if incremental compaction was draining this extent, its job is done
+        if ( _drainingExtent == headLoc )
+            _drainingExtent = DiskLoc();
+
+        txn->recoveryUnit()->commitIfNeeded();
+
+        return StatusWith<long long>( numRecords );
+    }
+
+    void SimpleRecordStoreV1::_purgeExtentFromFreeLists( OperationContext* txn,
+                                                         const DiskLoc& extLoc ) {
+        // unlink the extent's deleted records from the per-bucket chains
+        for ( int b = 0; b < Buckets; b++ ) {
+            DiskLoc* prev = NULL;
+            DiskLoc cur = _details->deletedListEntry( b );
+            while ( !cur.isNull() ) {
+                DeletedRecord* d = drec( cur );
+                const DiskLoc next = d->nextDeleted();
+                if ( cur.a() == extLoc.a() && d->extentOfs() == extLoc.getOfs() ) {
+                    if ( prev )
+                        *txn->recoveryUnit()->writing( prev ) = next;
+                    else
+                        _details->setDeletedListEntry( txn, b, next );
+                }
+                else {
+                    prev = &d->nextDeleted();
+                }
+                cur = next;
+            }
+        }
+
+        // cached deleted records are already unlinked on disk, so the chain walk
+        // above missed them; drop the ones in this extent or a later allocation
+        // could hand out space inside it
+        if ( _freelistCache ) {
+            for ( int b = 0; b < Buckets; b++ ) {
+                std::vector< std::pair<DiskLoc, int> > keep;
+                DiskLoc loc;
+                int len;
+                while ( _freelistCache[b].pop( &loc, &len ) ) {
+                    if ( loc.a() != extLoc.a() ||
+                         drec( loc )->extentOfs() != extLoc.getOfs() )
+                        keep.push_back( std::make_pair( loc, len ) );
+                }
+                for ( size_t i = 0; i < keep.size(); i++ )
+                    _freelistCache[b].push( keep[i].first, keep[i].second );
+            }
+        }
+    }
+
+    Status SimpleRecordStoreV1::beginHeadExtentDrain( OperationContext* txn ) {
+        const DiskLoc headLoc = _details->firstExtent();
+        invariant( !headLoc.isNull() );
+
+        if ( _drainingExtent == headLoc )
+            return Status::OK(); // resuming an earlier drain
+
+        Extent* head = _extentManager->getExtent( headLoc );
+        head->assertOk();
+
+        if ( head->xnext.isNull() )
+            return Status( ErrorCodes::IllegalOperation,
+                           "cannot drain a collection's only extent" );
+
+        // with the free space unlinked here and addDeletedRec() refusing to relink
+        // space freed inside the extent, nothing can allocate into it again
+        _purgeExtentFromFreeLists( txn, headLoc );
+        _drainingExtent = headLoc;
+
+        return Status::OK();
+    }
+
+    DiskLoc SimpleRecordStoreV1::drainExtentFirstRecord() const {
+        invariant( !_drainingExtent.isNull() );
+        return _getExtent( _drainingExtent )->firstRecord;
+    }
+
+    bool SimpleRecordStoreV1::headExtentNewestRecord( DiskLoc* newest ) const {
+        const DiskLoc headLoc = _details->firstExtent();
+        if ( headLoc.isNull() )
+            return false;
+        Extent* head = _getExtent( headLoc );
+        if ( head->xnext.isNull() )
+            return false;
+        *newest = head->lastRecord;
+        return true;
+    }
+
     void SimpleRecordStoreV1::addDeletedRec( OperationContext* txn, const DiskLoc& dloc ) {
         DeletedRecord* d = drec( dloc );
 
         DEBUGGING log() << "TEMP: add deleted rec " << dloc.toString() << ' ' << hex << d->extentOfs() << endl;
 
+        // space freed inside a draining extent stays unlinked; the whole extent is
+        // handed back once the drain finishes (see beginHeadExtentDrain)
+        if ( !_drainingExtent.isNull() &&
+             dloc.a() == _drainingExtent.a() &&
+             d->extentOfs() == _drainingExtent.getOfs() ) {
+            *txn->recoveryUnit()->writing( &d->nextDeleted() ) = DiskLoc();
+            return;
+        }
+
         int b = bucket(d->lengthWithHeaders());
         *txn->recoveryUnit()->writing(&d->nextDeleted()) = _details->deletedListEntry(b);
         _details->setDeletedListEntry(txn, b, dloc);
@@ -369,7 +619,8 @@ namespace mongo {
             if( !L.isNull() ) {
                 while( 1 ) {
                     Record *recOld = recordFor(L);
-                    RecordData oldData = recOld->toRecordData();
+                    // dataFor() decompresses, so the adaptor always sees a document
+                    RecordData oldData = dataFor(L);
                     L = getNextRecordInExtent(L);
 
                     if ( compactOptions->validateDocuments && !adaptor->isDataValid( oldData ) ) {
@@ -378,8 +629,11 @@ namespace mongo {
                         stats->corruptDocuments++;
                     }
                     else {
-                        unsigned dataSize = adaptor->dataSize( oldData );
-                        unsigned docSize = dataSize;
+                        // compressed records are copied frame and all, so size the new
+                        // record for the frame rather than the logical document
+                        unsigned docSize = _isCompressedRecord( recOld )
+                                         ? static_cast<unsigned>( _compressedFrameLength( recOld ) )
+                                         : adaptor->dataSize( oldData );
 
                         nrecords++;
                         oldObjSize += docSize;
@@ -405,7 +659,7 @@ namespace mongo {
                             break;
                         }
 
-                        CompactDocWriter writer( recOld, dataSize, lenWPadding );
+                        CompactDocWriter writer( recOld, docSize, lenWPadding );
                         StatusWith<DiskLoc> status = insertRecord( txn, &writer, 0 );
                         uassertStatusOK( status.getStatus() );
                         datasize += recordFor( status.getValue() )->netLength();
@@ -472,6 +726,10 @@ namespace mongo {
         log() << "compact orphan deleted lists" << endl;
         _details->orphanDeletedList(txn);
 
+        // drop any cached deleted records too -- their extents are about to be freed
+        if ( _freelistCache )
+            _freelistCache.reset( new DeletedRecordStack[Buckets] );
+
         // Start over from scratch with our extent sizing and growth
         _details->setLastExtentSize( txn, 0 );
 
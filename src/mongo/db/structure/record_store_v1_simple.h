@@ -30,13 +30,43 @@
 
 #pragma once
 
+#include <boost/scoped_array.hpp>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/structure/record_store_v1_base.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
     class SimpleRecordStoreV1Iterator;
 
+    /**
+     * Lock-free LIFO of deleted records belonging to one size bucket.  Used by the
+     * opt-in fast allocation mode of SimpleRecordStoreV1: entries are unlinked from the
+     * on-disk DeletedRecord chain in batches and then handed out with an O(1) pop
+     * instead of a chain scan.  Push and pop are CAS loops on the head pointer so no
+     * mutex is involved.
+     */
+    class DeletedRecordStack : boost::noncopyable {
+    public:
+        DeletedRecordStack() { _head.store(0); }
+        ~DeletedRecordStack();
+
+        void push( const DiskLoc& loc, int lengthWithHeaders );
+
+        /** @return false if the stack is empty */
+        bool pop( DiskLoc* loc, int* lengthWithHeaders );
+
+    private:
+        struct Node {
+            DiskLoc loc;
+            int lengthWithHeaders;
+            Node* next;
+        };
+
+        AtomicWord<unsigned long long> _head; // Node*, as an integer for CAS
+    };
+
     // used by index and original collections
     class SimpleRecordStoreV1 : public RecordStoreV1Base {
     public:
@@ -67,6 +97,39 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        /**
+         * Frees the oldest (first) extent wholesale, records and all.  Used by
+         * time-partitioned expiry.  Refuses to free the collection's only extent.
+         * Indexes are NOT notified -- the caller must ensure there are none.
+         * @return the number of records freed
+         */
+        StatusWith<long long> truncateHeadExtent( OperationContext* txn );
+
+        /**
+         * Locates the newest (last inserted) record of the head extent.
+         * @return false if the collection has fewer than two extents; when true,
+         *         *newest may still be Null if the head extent holds no records
+         */
+        bool headExtentNewestRecord( DiskLoc* newest ) const;
+
+        /**
+         * Online incremental compaction support.  Marks the head (oldest) extent as
+         * draining: its free space is unlinked from the deleted-record chains and
+         * space freed inside it afterwards stays unlinked, so no allocation can land
+         * there while the caller moves records out.  Resume-aware: a no-op when the
+         * head extent is already draining.  Fails if the collection has only one
+         * extent.  The drain state is in-memory only; abandoning a drain (restart,
+         * endHeadExtentDrain without truncating) strands the extent's free space
+         * until the extent is freed or a full compact runs.
+         */
+        Status beginHeadExtentDrain( OperationContext* txn );
+
+        /** The next record still to be moved out of the draining extent. */
+        DiskLoc drainExtentFirstRecord() const;
+
+        /** Forgets the drain state, after the extent is freed or to abort. */
+        void endHeadExtentDrain() { _drainingExtent = DiskLoc(); }
+
     protected:
         virtual bool isCapped() const { return false; }
 
@@ -80,6 +143,19 @@ namespace mongo {
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
                                            int lengthWithHeaders );
 
+        /** O(1) allocation path used when the lock-free freelist mode is on.
+            @return a record already unlinked from the on-disk deleted chains,
+                    or DiskLoc() if no cached or on-disk record fits. */
+        DiskLoc _allocFromFreelistCache( OperationContext* txn, int lenToAlloc );
+
+        /** lazily populate the cache for one bucket from its on-disk chain.
+            @return the number of records moved into the cache */
+        int _refillFreelistCache( OperationContext* txn, int bucketNum );
+
+        /** unlink every deleted record belonging to 'extLoc' from both the
+            on-disk chains and the freelist cache */
+        void _purgeExtentFromFreeLists( OperationContext* txn, const DiskLoc& extLoc );
+
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
                             int extentNumber,
@@ -89,6 +165,14 @@ namespace mongo {
 
         bool _normalCollection;
 
+        // one lock-free stack per deleted-record bucket; NULL unless the
+        // useLockFreeRecordAllocator server parameter is set
+        boost::scoped_array<DeletedRecordStack> _freelistCache;
+
+        // extent currently being drained by incremental compaction, or Null;
+        // see beginHeadExtentDrain()
+        DiskLoc _drainingExtent;
+
         friend class SimpleRecordStoreV1Iterator;
     };
 
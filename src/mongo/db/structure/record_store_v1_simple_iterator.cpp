@@ -31,7 +31,10 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
+#include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/structure/record_store_v1_simple.h"
+#include "mongo/db/structure/scan_readahead.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -42,7 +45,8 @@ namespace mongo {
     SimpleRecordStoreV1Iterator::SimpleRecordStoreV1Iterator(const SimpleRecordStoreV1* collection,
                                                              const DiskLoc& start,
                                                              const CollectionScanParams::Direction& dir)
-        : _curr(start), _recordStore(collection), _direction(dir) {
+        : _curr(start), _recordStore(collection), _direction(dir),
+          _lastExtentA(-1), _lastExtentOfs(-1), _accessClock(0) {
 
         if (_curr.isNull()) {
 
@@ -94,17 +98,33 @@ namespace mongo {
 
         // Move to the next thing.
         if (!isEOF()) {
-            if (CollectionScanParams::FORWARD == _direction) {
-                _curr = _recordStore->getNextRecord( _curr );
+            if ( ( ++_accessClock & 0x3F ) != 0 ) {
+                _advance();
             }
             else {
-                _curr = _recordStore->getPrevRecord( _curr );
+                // Advancing dereferences the current record, so on cold data this is
+                // where the scan stalls on a page fault; sampled timings feed the
+                // readahead window tuner.
+                Timer timer;
+                _advance();
+                ScanReadahead::global.noteAccessMicros( timer.micros() );
             }
         }
 
         return ret;
     }
 
+    void SimpleRecordStoreV1Iterator::_advance() {
+        _noteScanPosition();
+
+        if (CollectionScanParams::FORWARD == _direction) {
+            _curr = _recordStore->getNextRecord( _curr );
+        }
+        else {
+            _curr = _recordStore->getPrevRecord( _curr );
+        }
+    }
+
     void SimpleRecordStoreV1Iterator::invalidate(const DiskLoc& dl) {
         // Just move past the thing being deleted.
         if (dl == _curr) {
@@ -122,6 +142,32 @@ namespace mongo {
         return true;
     }
 
+    void SimpleRecordStoreV1Iterator::_noteScanPosition() {
+        const Record* rec = _recordStore->recordFor( _curr );
+        if ( _curr.a() == _lastExtentA && rec->extentOfs() == _lastExtentOfs ) {
+            return;
+        }
+        _lastExtentA = _curr.a();
+        _lastExtentOfs = rec->extentOfs();
+
+        // We just crossed into a new extent; if the tuner thinks the scan is faulting
+        // cold pages, hand the next stretch of the chain to the readahead worker.
+        const int lookahead = ScanReadahead::global.lookaheadExtents();
+        if ( lookahead == 0 ) {
+            return;
+        }
+
+        Extent* e = _recordStore->_extentManager->getExtent(
+            DiskLoc( _curr.a(), rec->extentOfs() ) );
+        const bool forward = CollectionScanParams::FORWARD == _direction;
+        const DiskLoc next = forward ? e->xnext : e->xprev;
+        if ( next.isNull() ) {
+            return;
+        }
+
+        ScanReadahead::global.requestReadahead( _recordStore->_ns, next, lookahead, forward );
+    }
+
     RecordData SimpleRecordStoreV1Iterator::dataFor( const DiskLoc& loc ) const {
         return _recordStore->dataFor( loc );
     }
@@ -58,12 +58,28 @@ namespace mongo {
         virtual RecordData dataFor( const DiskLoc& loc ) const;
 
     private:
+        // Moves _curr one record in the scan direction.
+        void _advance();
+
+        /**
+         * Detects when the iteration crosses into a new extent and, if the readahead
+         * window is open, queues the upcoming extents for background paging-in.
+         */
+        void _noteScanPosition();
+
         // The result returned on the next call to getNext().
         DiskLoc _curr;
 
         const SimpleRecordStoreV1* _recordStore;
 
         CollectionScanParams::Direction _direction;
+
+        // Extent the scan was last seen in, for boundary detection in _noteScanPosition().
+        int _lastExtentA;
+        int _lastExtentOfs;
+
+        // Advance counter for sampled latency reporting in getNext().
+        unsigned _accessClock;
     };
 
 }  // namespace mongo
@@ -430,6 +430,113 @@ namespace {
         ASSERT_EQUALS( 512, rs.getRecordAllocationSize( 300 ) );
     }
 
+    /**
+     * With Flag_CompressRecords set, a compressible document is stored smaller than its
+     * raw size and reads back byte for byte through dataFor().
+     */
+    TEST(SimpleRecordStoreV1, CompressRecordsRoundTrip) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(
+                                                false,
+                                                RecordStoreV1Base::Flag_CompressRecords );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        BSONObj doc = BSON( "_id" << 1 << "x" << string( 4000, 'x' ) );
+        StatusWith<DiskLoc> loc = rs.insertRecord( &txn, doc.objdata(), doc.objsize(), 0 );
+        ASSERT_OK( loc.getStatus() );
+
+        // the record holds the compressed frame, not the raw document
+        ASSERT_LESS_THAN( md->dataSize(), static_cast<long long>( doc.objsize() ) );
+
+        RecordData data = rs.dataFor( loc.getValue() );
+        ASSERT_EQUALS( doc.objsize(), data.size() );
+        ASSERT_EQUALS( 0, memcmp( doc.objdata(), data.data(), doc.objsize() ) );
+        ASSERT_EQUALS( doc, data.toBson() );
+    }
+
+    /**
+     * Incompressible documents are stored raw even with Flag_CompressRecords set, and
+     * the in-place damage path is refused while compression is on.
+     */
+    TEST(SimpleRecordStoreV1, CompressRecordsIncompressibleStoredRaw) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(
+                                                false,
+                                                RecordStoreV1Base::Flag_CompressRecords );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        BSONObj doc = BSON( "_id" << 1 );
+        StatusWith<DiskLoc> loc = rs.insertRecord( &txn, doc.objdata(), doc.objsize(), 0 );
+        ASSERT_OK( loc.getStatus() );
+
+        RecordData data = rs.dataFor( loc.getValue() );
+        ASSERT_EQUALS( doc.objsize(), data.size() );
+        ASSERT_EQUALS( 0, memcmp( doc.objdata(), data.data(), doc.objsize() ) );
+
+        ASSERT( !rs.updateWithDamagesSupported( loc.getValue() ) );
+    }
+
+    /**
+     * getRecordAllocationSize() stops applying the padding factor to a size bucket once
+     * enough updates in that bucket have been observed to fit in place.
+     */
+    TEST(SimpleRecordStoreV1, GetRecordAllocationSizePaddingDroppedForStableBucket) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+        md->setPaddingFactor( &txn, 1.2 );
+
+        StatusWith<DiskLoc> loc = rs.insertRecord( &txn, zeros, 300, 1000 );
+        ASSERT_TRUE( loc.isOK() );
+
+        // With no growth profile yet, padding still applies.
+        ASSERT_EQUALS( int( 300 * 1.2 ), rs.getRecordAllocationSize( 300 ) );
+
+        // Every update fits in place, so the record's size bucket becomes stable.
+        for ( int i = 0; i < 1000; i++ ) {
+            ASSERT_TRUE( rs.updateRecord( &txn, loc.getValue(), zeros, 300, 1000,
+                                          NULL ).isOK() );
+        }
+
+        ASSERT_EQUALS( 300, rs.getRecordAllocationSize( 300 ) );
+    }
+
+    /**
+     * validateOnlineStep() covers the whole store one extent at a time and counts
+     * every record.
+     */
+    TEST(SimpleRecordStoreV1, ValidateOnlineStepWalksAllRecords) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        const int nDocs = 20;
+        for ( int i = 0; i < nDocs; i++ ) {
+            ASSERT_TRUE( rs.insertRecord( &txn, zeros, 4000, 0 ).isOK() );
+        }
+
+        ValidateResults results;
+        long long totalRecords = 0;
+        int steps = 0;
+        DiskLoc token; // null: start at the first extent
+        do {
+            DiskLoc next;
+            long long stepRecords = 0;
+            ASSERT_OK( rs.validateOnlineStep( &txn, token, &next, &stepRecords, &results ) );
+            totalRecords += stepRecords;
+            token = next;
+            steps++;
+        } while ( !token.isNull() );
+
+        ASSERT_TRUE( results.valid );
+        ASSERT_EQUALS( nDocs, totalRecords );
+        ASSERT_GREATER_THAN( steps, 1 ); // several extents, each its own step
+    }
+
 
     // -----------------
 
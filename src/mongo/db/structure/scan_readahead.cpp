@@ -0,0 +1,106 @@
+// scan_readahead.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/structure/scan_readahead.h"
+
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    ScanReadahead ScanReadahead::global;
+
+    ScanReadahead::ScanReadahead()
+        : _lock( "ScanReadahead" ),
+          _ewmaAccessMicros( 0 ),
+          // Start with a small window so the first cold scan gets help before
+          // the tuner has seen any samples; warm workloads tune it to zero.
+          _lookahead( 2 ) {
+    }
+
+    int ScanReadahead::lookaheadExtents() const {
+        scoped_lock lk( _lock );
+        return _lookahead;
+    }
+
+    void ScanReadahead::noteAccessMicros( long long micros ) {
+        scoped_lock lk( _lock );
+
+        if ( _ewmaAccessMicros == 0 ) {
+            _ewmaAccessMicros = micros;
+        }
+        else {
+            _ewmaAccessMicros += 0.25 * ( micros - _ewmaAccessMicros );
+        }
+
+        if ( _ewmaAccessMicros >= kColdAccessMicros ) {
+            if ( _lookahead < kMaxLookaheadExtents )
+                _lookahead++;
+        }
+        else if ( _ewmaAccessMicros <= kWarmAccessMicros ) {
+            if ( _lookahead > 0 )
+                _lookahead--;
+        }
+    }
+
+    void ScanReadahead::requestReadahead( const StringData& ns,
+                                          const DiskLoc& firstExtent,
+                                          int numExtents,
+                                          bool forward ) {
+        Request request;
+        request.ns = ns.toString();
+        request.firstExtent = firstExtent;
+        request.numExtents = numExtents;
+        request.forward = forward;
+
+        scoped_lock lk( _lock );
+        if ( _pending.size() >= kMaxPendingRequests ) {
+            _pending.pop_front();
+        }
+        _pending.push_back( request );
+        _hasRequests.notify_one();
+    }
+
+    bool ScanReadahead::blockingPop( Request* request, int maxSecondsToWait ) {
+        boost::xtime xt;
+        boost::xtime_get( &xt, MONGO_BOOST_TIME_UTC );
+        xt.sec += maxSecondsToWait;
+
+        scoped_lock lk( _lock );
+        while ( _pending.empty() ) {
+            if ( !_hasRequests.timed_wait( lk.boost(), xt ) )
+                return false;
+        }
+
+        *request = _pending.front();
+        _pending.pop_front();
+        return true;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,128 @@
+// scan_readahead.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <deque>
+#include <string>
+
+#include <boost/thread/condition.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Request queue and window tuner for background collection scan readahead.
+     *
+     * A sequential scan over memory mapped extents faults every cold page
+     * synchronously, one record at a time.  To stay ahead of that, the simple
+     * record iterator reports each extent boundary it crosses here, and a
+     * background worker (see scan_readahead_worker.cpp) pages in the next few
+     * extents of the chain while the scan is still chewing on the current one.
+     *
+     * The lookahead window adapts to sampled record access latency reported by
+     * the scanning thread: sustained slow accesses (page faults going to disk)
+     * grow the window, fast accesses (resident data) shrink it down to zero so
+     * warm scans pay nothing beyond the sampling itself.
+     *
+     * Everything here is best effort: requests are dropped when the queue is
+     * full, and requests that have gone stale (collection dropped, etc.) are
+     * discarded by the worker.
+     */
+    class ScanReadahead {
+        MONGO_DISALLOW_COPYING(ScanReadahead);
+    public:
+
+        struct Request {
+            Request() : numExtents(0), forward(true) {}
+            std::string ns;
+            DiskLoc firstExtent;
+            int numExtents;
+            bool forward;
+        };
+
+        ScanReadahead();
+
+        /**
+         * Current lookahead window in extents.  Zero means the recently sampled
+         * accesses were fast enough that readahead would be wasted work.
+         */
+        int lookaheadExtents() const;
+
+        /**
+         * Reports one sampled record access time from a scan; feeds the window
+         * tuner.  Called on a small fraction of accesses, so a mutex is fine.
+         */
+        void noteAccessMicros( long long micros );
+
+        /**
+         * Queues the extents starting at 'firstExtent' for background paging-in.
+         * If the queue is full the oldest request is dropped; a stale readahead
+         * request is worth less than a fresh one.
+         */
+        void requestReadahead( const StringData& ns,
+                               const DiskLoc& firstExtent,
+                               int numExtents,
+                               bool forward );
+
+        /**
+         * Worker side: blocks up to maxSecondsToWait for a request.  Returns
+         * true and fills in 'request' if one was dequeued.
+         */
+        bool blockingPop( Request* request, int maxSecondsToWait );
+
+        static ScanReadahead global;
+
+    private:
+        // Bounds on the adaptive lookahead window.
+        static const int kMaxLookaheadExtents = 8;
+
+        // Sampled access EWMA thresholds: above the cold mark the window grows,
+        // below the warm mark it shrinks.  A resident access is a handful of
+        // microseconds; anything in the hundreds means we went to disk.
+        static const int kColdAccessMicros = 100;
+        static const int kWarmAccessMicros = 20;
+
+        // Cap on queued requests; requests are tiny, this just bounds staleness.
+        static const size_t kMaxPendingRequests = 64;
+
+        mutable mongo::mutex _lock;
+        boost::condition _hasRequests;
+        std::deque<Request> _pending;
+
+        double _ewmaAccessMicros;
+        int _lookahead;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,84 @@
+// scan_readahead_test.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/structure/scan_readahead.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    TEST( ScanReadahead, WindowGrowsWhenColdAndShrinksWhenWarm ) {
+        ScanReadahead ra;
+
+        const int initial = ra.lookaheadExtents();
+        ASSERT_GREATER_THAN( initial, 0 );
+
+        // Sustained slow (disk-bound) accesses open the window...
+        for ( int i = 0; i < 32; i++ ) {
+            ra.noteAccessMicros( 5000 );
+        }
+        ASSERT_GREATER_THAN( ra.lookaheadExtents(), initial );
+
+        // ...and sustained fast (resident) accesses close it entirely.
+        for ( int i = 0; i < 32; i++ ) {
+            ra.noteAccessMicros( 2 );
+        }
+        ASSERT_EQUALS( 0, ra.lookaheadExtents() );
+    }
+
+    TEST( ScanReadahead, RequestsRoundTripThroughQueue ) {
+        ScanReadahead ra;
+
+        ra.requestReadahead( "test.foo", DiskLoc( 2, 4096 ), 3, true );
+
+        ScanReadahead::Request request;
+        ASSERT( ra.blockingPop( &request, 1 ) );
+        ASSERT_EQUALS( "test.foo", request.ns );
+        ASSERT_EQUALS( DiskLoc( 2, 4096 ), request.firstExtent );
+        ASSERT_EQUALS( 3, request.numExtents );
+        ASSERT( request.forward );
+    }
+
+    TEST( ScanReadahead, FullQueueDropsOldestRequest ) {
+        ScanReadahead ra;
+
+        // Over-fill the queue; the earliest (stalest) requests should fall out.
+        for ( int i = 0; i < 100; i++ ) {
+            ra.requestReadahead( "test.foo", DiskLoc( 1, i ), 1, true );
+        }
+
+        ScanReadahead::Request request;
+        ASSERT( ra.blockingPop( &request, 1 ) );
+        ASSERT_GREATER_THAN( request.firstExtent.getOfs(), 0 );
+    }
+
+}  // namespace
@@ -0,0 +1,79 @@
+// scan_readahead_worker.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/structure/scan_readahead_worker.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/structure/scan_readahead.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    ScanReadaheadWorker scanReadaheadWorker;
+
+    void ScanReadaheadWorker::run() {
+        Client::initThread( name().c_str() );
+
+        while ( !inShutdown() ) {
+
+            ScanReadahead::Request request;
+            if ( !ScanReadahead::global.blockingPop( &request, 1 ) ) {
+                continue;
+            }
+
+            try {
+                OperationContextImpl txn;
+                Client::ReadContext ctx( &txn, request.ns );
+
+                // The scan that queued this may have outlived its collection; requests
+                // are hints, so a vanished namespace just means there is nothing to do.
+                Collection* collection = ctx.ctx().db()->getCollection( &txn, request.ns );
+                if ( !collection ) {
+                    continue;
+                }
+
+                collection->getRecordStore()->touchExtents( request.firstExtent,
+                                                            request.numExtents,
+                                                            request.forward );
+            }
+            catch ( const DBException& e ) {
+                LOG(2) << "scan readahead for " << request.ns << " skipped"
+                       << causedBy( e ) << endl;
+            }
+        }
+
+        cc().shutdown();
+    }
+
+}  // namespace mongo
@@ -142,8 +142,73 @@ namespace mongo {
 
                 LOG(1) << "\tTTL deleted: " << n << endl;
             }
-            
-            
+
+
+        }
+
+        void doTimePartitionedForDB( const string& dbName ) {
+
+            // freeing an extent is not written to the oplog, so a secondary could
+            // never replay it; restrict extent expiry to standalone servers until
+            // a replicated truncation op exists
+            if (repl::getGlobalReplicationCoordinator()->getReplicationMode() !=
+                    repl::ReplicationCoordinator::modeNone)
+                return;
+
+            vector<BSONObj> colls;
+            {
+                auto_ptr<DBClientCursor> cursor =
+                                db.query( dbName + ".system.namespaces" ,
+                                          BSON( "options.timePartitionExpireSeconds"
+                                                << BSON( "$exists" << true ) ) );
+                if ( cursor.get() ) {
+                    while ( cursor->more() ) {
+                        colls.push_back( cursor->next().getOwned() );
+                    }
+                }
+            }
+
+            for ( unsigned i=0; i<colls.size(); i++ ) {
+                BSONElement expire = colls[i]["options"]["timePartitionExpireSeconds"];
+                if ( !expire.isNumber() || expire.numberLong() <= 0 ) {
+                    error() << "invalid timePartitionExpireSeconds for: "
+                            << colls[i]["name"] << endl;
+                    continue;
+                }
+
+                const string ns = colls[i]["name"].String();
+                const Date_t cutoff =
+                    curTimeMillis64() - ( 1000 * expire.numberLong() );
+
+                long long n = 0;
+                {
+                    OperationContextImpl txn;
+                    Client::WriteContext ctx(&txn, ns);
+                    Collection* collection = ctx.ctx().db()->getCollection( &txn, ns );
+                    if ( !collection ) {
+                        // collection was dropped
+                        continue;
+                    }
+
+                    // each call frees at most one extent; keep going while whole
+                    // extents are expired
+                    while ( 1 ) {
+                        StatusWith<long long> res =
+                            collection->truncateExpiredHeadExtent( &txn, cutoff );
+                        if ( !res.isOK() ) {
+                            error() << "time-partitioned expiry failed for " << ns
+                                    << ": " << res.getStatus().toString() << endl;
+                            break;
+                        }
+                        if ( res.getValue() == 0 )
+                            break;
+                        n += res.getValue();
+                    }
+                    ttlDeletedDocuments.increment( n );
+                }
+
+                LOG(1) << "\tTTL expired extents deleted: " << n << " from " << ns << endl;
+            }
         }
 
         virtual void run() {
@@ -186,6 +251,7 @@ namespace mongo {
                     string db = *i;
                     try {
                         doTTLForDB( db );
+                        doTimePartitionedForDB( db );
                     }
                     catch ( DBException& e ) {
                         error() << "error processing ttl for db: " << db << " " << e << endl;
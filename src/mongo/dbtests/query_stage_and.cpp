@@ -44,6 +44,7 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -358,8 +359,10 @@ namespace QueryStageAnd {
 
     // An AND with two children.
     // Add large keys (512 bytes) to index of first child to cause
-    // internal buffer within hashed AND to exceed threshold (32MB)
-    // before gathering all requested results.
+    // internal buffer within hashed AND to exceed threshold
+    // before gathering all requested results.  With spilling enabled (the
+    // default) the stage switches to its Grace hash strategy and still
+    // produces the full intersection; with spilling disabled it fails.
     class QueryStageAndHashTwoLeafFirstChildLargeKeys : public QueryStageAndBase {
     public:
         void run() {
@@ -380,11 +383,30 @@ namespace QueryStageAnd {
             addIndex(BSON("foo" << 1 << "big" << 1));
             addIndex(BSON("bar" << 1));
 
-            // Lower buffer limit to 20 * sizeof(big) to force memory error
-            // before hashed AND is done reading the first child (stage has to
+            // Lower buffer limit to 20 * sizeof(big) so the stage runs out of
+            // memory before it is done reading the first child (stage has to
             // hold 21 keys in buffer for Foo <= 20).
             WorkingSet ws;
-            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 20 * big.size()));
+            scoped_ptr<AndHashStage> ah(makeStage(&ws, coll, 20 * big.size(), big));
+
+            // The stage spills and completes.  foo == bar, foo <= 20, bar >= 10,
+            // so our values are foo == 10 through 20.
+            ASSERT_EQUALS(11, countResults(ah.get()));
+
+            // With spilling disabled, stage execution should fail instead.
+            internalQueryHashIntersectionSpillToDisk = false;
+            WorkingSet ws2;
+            scoped_ptr<AndHashStage> ah2(makeStage(&ws2, coll, 20 * big.size(), big));
+            ASSERT_EQUALS(-1, countResults(ah2.get()));
+            internalQueryHashIntersectionSpillToDisk = true;
+        }
+
+    private:
+        AndHashStage* makeStage(WorkingSet* ws,
+                                Collection* coll,
+                                size_t maxMemUsage,
+                                const std::string& big) {
+            auto_ptr<AndHashStage> ah(new AndHashStage(ws, NULL, coll, maxMemUsage));
 
             // Foo <= 20
             IndexScanParams params;
@@ -394,7 +416,7 @@ namespace QueryStageAnd {
             params.bounds.endKey = BSONObj();
             params.bounds.endKeyInclusive = true;
             params.direction = -1;
-            ah->addChild(new IndexScan(params, &ws, NULL));
+            ah->addChild(new IndexScan(params, ws, NULL));
 
             // Bar >= 10
             params.descriptor = getIndex(BSON("bar" << 1), coll);
@@ -402,10 +424,9 @@ namespace QueryStageAnd {
             params.bounds.endKey = BSONObj();
             params.bounds.endKeyInclusive = true;
             params.direction = 1;
-            ah->addChild(new IndexScan(params, &ws, NULL));
+            ah->addChild(new IndexScan(params, ws, NULL));
 
-            // Stage execution should fail.
-            ASSERT_EQUALS(-1, countResults(ah.get()));
+            return ah.release();
         }
     };
 
@@ -519,8 +540,10 @@ namespace QueryStageAnd {
 
     // An AND with three children.
     // Add large keys (512 bytes) to index of second child to cause
-    // internal buffer within hashed AND to exceed threshold (32MB)
-    // before gathering all requested results.
+    // internal buffer within hashed AND to exceed threshold
+    // before gathering all requested results, exercising a spill that starts
+    // in the middle of a probing child (some buffered entries have already
+    // been matched by the second child, some have not).
     // We need 3 children because the hashed AND stage buffered data for
     // N-1 of its children. If the second child is the last child, it will not
     // be buffered.
@@ -545,8 +568,8 @@ namespace QueryStageAnd {
             addIndex(BSON("bar" << 1 << "big" << 1));
             addIndex(BSON("baz" << 1));
 
-            // Lower buffer limit to 10 * sizeof(big) to force memory error
-            // before hashed AND is done reading the second child (stage has to
+            // Lower buffer limit to 10 * sizeof(big) so the stage runs out of
+            // memory before it is done reading the second child (stage has to
             // hold 11 keys in buffer for Foo <= 20 and Bar >= 10).
             WorkingSet ws;
             scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 10 * big.size()));
@@ -577,8 +600,9 @@ namespace QueryStageAnd {
             params.direction = 1;
             ah->addChild(new IndexScan(params, &ws, NULL));
 
-            // Stage execution should fail.
-            ASSERT_EQUALS(-1, countResults(ah.get()));
+            // The stage spills and completes.  foo == bar == baz, foo <= 20,
+            // bar >= 10, 5 <= baz <= 15, so our values are foo == 10 through 15.
+            ASSERT_EQUALS(6, countResults(ah.get()));
         }
     };
 
@@ -0,0 +1,213 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * Stage-level micro-benchmarks for the query execution stages.  The other
+ * query_stage_*.cpp files assert correctness only; these time PlanStage::work()
+ * in isolation over a synthesized collection and report ns per work() call with
+ * a 95% confidence interval, so runs can be compared between releases:
+ *
+ *     ./dbtest query_stage_bench
+ *
+ * Like perftests.cpp, the sizes are kept small enough that the suite can run
+ * as part of the normal dbtest pass.
+ */
+
+#include <cmath>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/util/timer.h"
+
+namespace QueryStageBench {
+
+    class QueryStageBenchBase {
+    public:
+        QueryStageBenchBase() : _padding(padBytes(), 'x') {
+            Client::WriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < numDocs(); ++i) {
+                BSONObjBuilder bob;
+                bob.append("a", i % cardinality());
+                bob.append("pad", _padding);
+                _client.insert(ns(), bob.obj());
+            }
+            _client.ensureIndex(ns(), BSON("a" << 1));
+        }
+
+        virtual ~QueryStageBenchBase() {
+            Client::WriteContext ctx(&_txn, ns());
+            _client.dropCollection(ns());
+        }
+
+        void run() {
+            vector<double> trials;
+            for (int t = 0; t < numTrials(); ++t) {
+                Client::ReadContext ctx(&_txn, ns());
+                Collection* coll = ctx.ctx().db()->getCollection(&_txn, ns());
+
+                WorkingSet ws;
+                scoped_ptr<PlanStage> stage(makeStage(coll, &ws));
+
+                long long works = 0;
+                Timer timer;
+                while (!stage->isEOF()) {
+                    WorkingSetID id = WorkingSet::INVALID_ID;
+                    stage->work(&id);
+                    ++works;
+                }
+                long long micros = timer.micros();
+
+                verify(works > 0);
+                trials.push_back(1000.0 * micros / works);
+            }
+            report(trials);
+        }
+
+        // knobs for the synthesized collection; override to change the shape
+        virtual int numDocs() const { return 1000; }
+        virtual int cardinality() const { return 100; }
+        virtual int padBytes() const { return 64; }
+        virtual int numTrials() const { return 5; }
+
+        // the stage under measurement; caller owns the return
+        virtual PlanStage* makeStage(Collection* coll, WorkingSet* ws) = 0;
+
+        virtual string name() const = 0;
+
+        static const char* ns() { return "unittests.QueryStageBench"; }
+
+    protected:
+        IndexDescriptor* getIndex(const BSONObj& obj, Collection* coll) {
+            return coll->getIndexCatalog()->findIndexByKeyPattern( obj );
+        }
+
+        IndexScanParams fullIndexScanParams(Collection* coll) {
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("a" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << MINKEY);
+            params.bounds.endKey = BSON("" << MAXKEY);
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            return params;
+        }
+
+        void report(const vector<double>& trials) const {
+            // mean and 95% confidence interval over the per-trial ns/work()
+            double sum = 0;
+            for (size_t i = 0; i < trials.size(); ++i)
+                sum += trials[i];
+            double mean = sum / trials.size();
+
+            double sumSq = 0;
+            for (size_t i = 0; i < trials.size(); ++i)
+                sumSq += (trials[i] - mean) * (trials[i] - mean);
+            double halfWidth = trials.size() > 1
+                ? 1.96 * sqrt(sumSq / (trials.size() - 1) / trials.size())
+                : 0;
+
+            cout << "query_stage_bench " << name()
+                 << " " << (long long)mean << " ns/work"
+                 << " +/- " << (long long)halfWidth
+                 << " (" << numDocs() << " docs, cardinality " << cardinality()
+                 << ", pad " << padBytes() << " bytes, " << numTrials() << " trials)"
+                 << endl;
+        }
+
+        OperationContextImpl _txn;
+
+    private:
+        string _padding;
+        DBDirectClient _client;
+    };
+
+    class CollScanBench : public QueryStageBenchBase {
+    public:
+        virtual string name() const { return "collscan"; }
+        virtual PlanStage* makeStage(Collection* coll, WorkingSet* ws) {
+            CollectionScanParams params;
+            params.collection = coll;
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+            return new CollectionScan(params, ws, NULL);
+        }
+    };
+
+    // same scan over documents padded past typical bucket sizes
+    class CollScanPaddedBench : public CollScanBench {
+    public:
+        virtual string name() const { return "collscan_padded"; }
+        virtual int padBytes() const { return 1024; }
+    };
+
+    class IndexScanBench : public QueryStageBenchBase {
+    public:
+        virtual string name() const { return "ixscan"; }
+        virtual PlanStage* makeStage(Collection* coll, WorkingSet* ws) {
+            return new IndexScan(fullIndexScanParams(coll), ws, NULL);
+        }
+    };
+
+    // one distinct key per document instead of runs of duplicates
+    class IndexScanHighCardinalityBench : public IndexScanBench {
+    public:
+        virtual string name() const { return "ixscan_high_cardinality"; }
+        virtual int cardinality() const { return numDocs(); }
+    };
+
+    class FetchBench : public QueryStageBenchBase {
+    public:
+        virtual string name() const { return "fetch"; }
+        virtual PlanStage* makeStage(Collection* coll, WorkingSet* ws) {
+            IndexScan* ixscan = new IndexScan(fullIndexScanParams(coll), ws, NULL);
+            return new FetchStage(ws, ixscan, NULL, coll);
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "query_stage_bench" ) { }
+
+        void setupTests() {
+            add<CollScanBench>();
+            add<CollScanPaddedBench>();
+            add<IndexScanBench>();
+            add<IndexScanHighCardinalityBench>();
+            add<FetchBench>();
+        }
+    }  queryStageBenchAll;
+
+}  // namespace QueryStageBench
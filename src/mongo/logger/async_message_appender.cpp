@@ -0,0 +1,115 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_message_appender.h"
+
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+
+    // Bound on queued messages.  At a typical couple hundred bytes per entry this
+    // keeps the ring under a megabyte while riding out multi-second I/O stalls.
+    const size_t kRingSize = 1024;
+
+}  // namespace
+
+    AsyncMessageAppender::AsyncMessageAppender(Appender<MessageEventEphemeral>* target)
+        : _target(target),
+          _ring(kRingSize),
+          _head(0),
+          _count(0),
+          _shutdown(false) {
+        _thread = boost::thread(stdx::bind(&AsyncMessageAppender::run, this));
+    }
+
+    AsyncMessageAppender::~AsyncMessageAppender() {
+        {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _shutdown = true;
+            _notEmpty.notify_one();
+            _notFull.notify_all();
+        }
+        _thread.join();
+    }
+
+    Status AsyncMessageAppender::append(const MessageEventEphemeral& event) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_count == _ring.size() && !_shutdown) {
+            _notFull.wait(lk);
+        }
+        if (_shutdown) {
+            // The drain thread is gone; write through so nothing is lost.
+            lk.unlock();
+            return _target->append(event);
+        }
+        Entry& entry = _ring[(_head + _count) % _ring.size()];
+        entry.date = event.getDate();
+        entry.severity = event.getSeverity();
+        entry.contextName = event.getContextName().toString();
+        entry.message = event.getMessage().toString();
+        ++_count;
+        _notEmpty.notify_one();
+        return Status::OK();
+    }
+
+    void AsyncMessageAppender::run() {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (true) {
+            while (0 == _count && !_shutdown) {
+                _notEmpty.wait(lk);
+            }
+            if (0 == _count) {
+                return;  // shut down and fully drained
+            }
+
+            Entry entry;
+            entry.date = _ring[_head].date;
+            entry.severity = _ring[_head].severity;
+            entry.contextName.swap(_ring[_head].contextName);
+            entry.message.swap(_ring[_head].message);
+            _head = (_head + 1) % _ring.size();
+            --_count;
+            _notFull.notify_one();
+
+            lk.unlock();
+            MessageEventEphemeral event(entry.date,
+                                        entry.severity,
+                                        entry.contextName,
+                                        entry.message);
+            // There is no caller left to surface a write failure to.
+            _target->append(event);
+            lk.lock();
+        }
+    }
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,94 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/log_severity.h"
+#include "mongo/logger/message_event.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Appender that decouples callers from the cost of encoding and writing a message
+     * event.  append() copies the event into a bounded ring and returns; a background
+     * thread drains the ring into the wrapped appender, which does the formatting and
+     * I/O.  When the ring is full append() blocks until a slot frees up, rather than
+     * dropping messages.
+     *
+     * Takes ownership of the wrapped appender.
+     */
+    class AsyncMessageAppender : public Appender<MessageEventEphemeral> {
+        MONGO_DISALLOW_COPYING(AsyncMessageAppender);
+
+    public:
+        explicit AsyncMessageAppender(Appender<MessageEventEphemeral>* target);
+        virtual ~AsyncMessageAppender();
+
+        virtual Status append(const MessageEventEphemeral& event);
+
+    private:
+        /**
+         * Owned copy of one queued event.  MessageEventEphemeral does not own the
+         * storage behind its strings, so they are materialized here.
+         */
+        struct Entry {
+            Entry() : date(0), severity(LogSeverity::Log()) {}
+
+            Date_t date;
+            LogSeverity severity;
+            std::string contextName;
+            std::string message;
+        };
+
+        void run();
+
+        boost::scoped_ptr<Appender<MessageEventEphemeral> > _target;
+
+        boost::mutex _mutex;
+        boost::condition _notEmpty;
+        boost::condition _notFull;
+        std::vector<Entry> _ring;
+        size_t _head;    // next slot to drain
+        size_t _count;   // occupied slots
+        bool _shutdown;
+
+        boost::thread _thread;
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,119 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/cpu_features.h"
+
+#include "mongo/platform/cstdint.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define MONGO_HAVE_CPUID 1
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define MONGO_HAVE_CPUID 1
+#endif
+
+namespace mongo {
+
+    namespace {
+
+        // cpuid function 1, ecx feature bits
+        const uint32_t kBitSse42 = 1U << 20;
+        const uint32_t kBitOsxsave = 1U << 27;
+        const uint32_t kBitAvx = 1U << 28;
+
+        struct Features {
+            bool sse42;
+            bool avx;
+            Features();
+        };
+
+#if defined(MONGO_HAVE_CPUID)
+
+        uint32_t cpuidEcx1() {
+#if defined(_MSC_VER)
+            int info[4] = { 0, 0, 0, 0 };
+            __cpuid(info, 1);
+            return static_cast<uint32_t>(info[2]);
+#else
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+                return 0;
+            return ecx;
+#endif
+        }
+
+        // Reads XCR0.  Only valid to call when cpuid reports OSXSAVE.
+        uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            uint32_t lo, hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+        }
+
+        Features::Features() {
+            const uint32_t ecx = cpuidEcx1();
+            sse42 = (ecx & kBitSse42) != 0;
+            // AVX needs both the instructions (cpuid) and OS-managed ymm state
+            // (xcr0 bits 1 and 2), or the registers are not saved across
+            // context switches.
+            avx = (ecx & kBitAvx) != 0 &&
+                  (ecx & kBitOsxsave) != 0 &&
+                  (xgetbv0() & 0x6) == 0x6;
+        }
+
+#else
+
+        Features::Features() {
+            sse42 = false;
+            avx = false;
+        }
+
+#endif
+
+        const Features& features() {
+            // Lazy so queries made during static initialization (e.g. to seed
+            // a dispatch function pointer) see detected values.  Process start
+            // is single threaded, so the local static is safe.
+            static Features f;
+            return f;
+        }
+
+    }  // namespace
+
+    bool ProcessorFeatures::hasSse42() {
+        return features().sse42;
+    }
+
+    bool ProcessorFeatures::hasAvx() {
+        return features().avx;
+    }
+
+}  // namespace mongo
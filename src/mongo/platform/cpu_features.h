@@ -0,0 +1,61 @@
+// cpu_features.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * Runtime detection of optional processor instruction set extensions.
+     *
+     * We compile for a baseline architecture, so code that wants to use a
+     * newer instruction (e.g. the SSE4.2 crc32 instruction) must check here
+     * at runtime and select an implementation through a function pointer;
+     * see platform/crc32c.cpp for the pattern.  On non-x86 processors every
+     * query returns false and callers fall back to their portable paths.
+     *
+     * Detection runs once, on the first query; the queries themselves are
+     * just reads of the cached results and are cheap enough for cold paths,
+     * though hot paths should still hoist the selection into a function
+     * pointer rather than branching on every call.
+     */
+    class ProcessorFeatures {
+    public:
+
+        /** True if the processor supports SSE4.2 (crc32, string compares). */
+        static bool hasSse42();
+
+        /** True if the processor and operating system support AVX. */
+        static bool hasAvx();
+
+    private:
+        ProcessorFeatures();
+    };
+
+}  // namespace mongo
@@ -0,0 +1,133 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/crc32c.h"
+
+#include <cstring>
+
+#include "mongo/platform/cpu_features.h"
+
+// The hardware path uses the crc32 instruction via inline assembly rather
+// than <nmmintrin.h> intrinsics: gcc refuses the intrinsics unless the whole
+// translation unit is compiled with -msse4.2, which would let the compiler
+// emit SSE4.2 anywhere in the file and crash older processors.  The assembler
+// has no such qualms, and we only reach the instruction after a cpuid check.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MONGO_HAVE_HARDWARE_CRC32C 1
+#elif defined(_MSC_VER) && defined(_M_X64)
+// MSVC allows SSE4.2 intrinsics without an /arch flag.
+#include <intrin.h>
+#define MONGO_HAVE_HARDWARE_CRC32C 1
+#endif
+
+namespace mongo {
+
+    namespace {
+
+        // reflected form of the Castagnoli polynomial 0x1EDC6F41
+        const uint32_t kCrc32cPolynomial = 0x82f63b78U;
+
+        struct Crc32cTable {
+            uint32_t entries[256];
+            Crc32cTable() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t crc = i;
+                    for (int k = 0; k < 8; k++) {
+                        crc = (crc & 1) ? (crc >> 1) ^ kCrc32cPolynomial : (crc >> 1);
+                    }
+                    entries[i] = crc;
+                }
+            }
+        };
+
+        const Crc32cTable& crc32cTable() {
+            static Crc32cTable table;
+            return table;
+        }
+
+        uint32_t crc32cSoftware(uint32_t crc, const void* data, size_t len) {
+            const uint32_t* table = crc32cTable().entries;
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            uint32_t c = crc ^ 0xffffffffU;
+            for (size_t i = 0; i < len; i++) {
+                c = table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+            }
+            return c ^ 0xffffffffU;
+        }
+
+#if defined(MONGO_HAVE_HARDWARE_CRC32C)
+
+        uint32_t crc32cHardware(uint32_t crc, const void* data, size_t len) {
+            const char* p = static_cast<const char*>(data);
+            uint64_t c = crc ^ 0xffffffffU;
+            while (len >= 8) {
+                uint64_t chunk;
+                memcpy(&chunk, p, 8);  // alignment-safe load
+#if defined(_MSC_VER)
+                c = _mm_crc32_u64(c, chunk);
+#else
+                __asm__("crc32q %1, %0" : "+r"(c) : "rm"(chunk));
+#endif
+                p += 8;
+                len -= 8;
+            }
+            while (len > 0) {
+#if defined(_MSC_VER)
+                c = _mm_crc32_u8(static_cast<uint32_t>(c), static_cast<unsigned char>(*p));
+#else
+                __asm__("crc32b %1, %0" : "+r"(c) : "rm"(*p));
+#endif
+                p++;
+                len--;
+            }
+            return static_cast<uint32_t>(c) ^ 0xffffffffU;
+        }
+
+#endif
+
+        typedef uint32_t (*Crc32cFn)(uint32_t, const void*, size_t);
+
+        Crc32cFn pickCrc32c() {
+#if defined(MONGO_HAVE_HARDWARE_CRC32C)
+            if (ProcessorFeatures::hasSse42())
+                return crc32cHardware;
+#endif
+            // build the table now, while we are still single threaded
+            crc32cTable();
+            return crc32cSoftware;
+        }
+
+    }  // namespace
+
+    uint32_t crc32c(uint32_t crc, const void* data, size_t len) {
+        // Lazy so the first call can come from another file's static
+        // initializer; process start is single threaded.
+        static const Crc32cFn impl = pickCrc32c();
+        return impl(crc, data, len);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,51 @@
+// crc32c.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * CRC-32C (Castagnoli polynomial, as used by iSCSI and ext4).
+     *
+     * Dispatches through a function pointer chosen at startup: the SSE4.2
+     * crc32 instruction when ProcessorFeatures reports it, otherwise a
+     * table-driven software implementation.  Both produce identical values,
+     * so data checksummed on one machine verifies on any other.
+     *
+     * @param crc  running crc from a previous call, or 0 to start
+     * @return crc extended over [data, data+len)
+     */
+    uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+}  // namespace mongo
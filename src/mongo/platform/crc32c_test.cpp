@@ -0,0 +1,89 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include <cstring>
+#include <string>
+
+#include "mongo/platform/crc32c.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::crc32c;
+    using mongo::uint32_t;
+
+    TEST(Crc32c, KnownVectors) {
+        // standard CRC-32C check value
+        ASSERT_EQUALS(0xe3069283U, crc32c(0, "123456789", 9));
+
+        // from RFC 3720 (iSCSI) appendix B.4
+        unsigned char zeros[32];
+        memset(zeros, 0, sizeof(zeros));
+        ASSERT_EQUALS(0x8a9136aaU, crc32c(0, zeros, sizeof(zeros)));
+
+        unsigned char ones[32];
+        memset(ones, 0xff, sizeof(ones));
+        ASSERT_EQUALS(0x62a8ab43U, crc32c(0, ones, sizeof(ones)));
+
+        unsigned char ascending[32];
+        for (unsigned i = 0; i < sizeof(ascending); i++)
+            ascending[i] = static_cast<unsigned char>(i);
+        ASSERT_EQUALS(0x46dd794eU, crc32c(0, ascending, sizeof(ascending)));
+    }
+
+    TEST(Crc32c, Empty) {
+        ASSERT_EQUALS(0U, crc32c(0, "", 0));
+        ASSERT_EQUALS(0x12345678U, crc32c(0x12345678U, "", 0));
+    }
+
+    // Extending a crc byte by byte must match a single pass, regardless of
+    // how the data is split (the hardware path switches between 8-byte and
+    // 1-byte steps internally).
+    TEST(Crc32c, IncrementalMatchesOneShot) {
+        const std::string data = "the quick brown fox jumps over the lazy dog, twice over";
+        const uint32_t whole = crc32c(0, data.data(), data.size());
+        for (size_t split = 0; split <= data.size(); split++) {
+            uint32_t crc = crc32c(0, data.data(), split);
+            crc = crc32c(crc, data.data() + split, data.size() - split);
+            ASSERT_EQUALS(whole, crc);
+        }
+    }
+
+    // The choice of implementation must not depend on buffer alignment.
+    TEST(Crc32c, UnalignedBuffers) {
+        char buf[64 + 8];
+        for (unsigned i = 0; i < sizeof(buf); i++)
+            buf[i] = static_cast<char>(i * 131 + 7);
+        const uint32_t expected = crc32c(0, buf + 1, 64);
+        char shifted[64 + 8];
+        for (int offset = 2; offset < 8; offset++) {
+            memcpy(shifted + offset, buf + 1, 64);
+            ASSERT_EQUALS(expected, crc32c(0, shifted + offset, 64));
+        }
+    }
+
+}  // namespace
@@ -0,0 +1,61 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/striped_counter.h"
+
+#include "mongo/platform/basic.h"
+
+namespace mongo {
+
+namespace {
+
+    AtomicWord<unsigned> nextThreadSlot;
+
+#if defined(MONGO_HAVE___DECLSPEC_THREAD)
+    __declspec( thread ) int myThreadSlot;  // 0 = unassigned; stores slot + 1
+#elif defined(MONGO_HAVE___THREAD)
+    __thread int myThreadSlot;              // 0 = unassigned; stores slot + 1
+#endif
+
+}  // namespace
+
+    int StripedCounter64::_threadSlot() {
+#if defined(MONGO_HAVE___DECLSPEC_THREAD) || defined(MONGO_HAVE___THREAD)
+        int s = myThreadSlot;
+        if ( s == 0 ) {
+            s = static_cast<int>( nextThreadSlot.fetchAndAdd(1) % kNumSlots ) + 1;
+            myThreadSlot = s;
+        }
+        return s - 1;
+#else
+        // No cheap thread-local storage on this platform; everyone shares
+        // slot 0, which is no worse than a plain shared counter.
+        return 0;
+#endif
+    }
+
+}  // namespace mongo
@@ -0,0 +1,91 @@
+// striped_counter.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * A 64-bit counter striped across cache-line-padded slots, so concurrent
+     * increments from different threads usually touch different cache lines
+     * instead of bouncing a single shared line between cores.
+     *
+     * Each thread is assigned a slot round-robin the first time it increments
+     * any StripedCounter64; this approximates one slot per CPU without asking
+     * the OS which core we are running on.  get() sums the slots, so reads are
+     * far more expensive than writes: use this for counters incremented on
+     * every operation but read only by stats reporting.
+     *
+     * Like a plain shared counter, get() is only eventually consistent with
+     * concurrent writers.
+     */
+    class StripedCounter64 {
+    public:
+
+        /** Atomically increment this thread's slot. */
+        void increment( uint64_t n = 1 ) { _slots[_threadSlot()].value.addAndFetch(n); }
+
+        /** Atomically decrement this thread's slot. */
+        void decrement( uint64_t n = 1 ) { _slots[_threadSlot()].value.subtractAndFetch(n); }
+
+        /** Return the sum over all slots. */
+        long long get() const {
+            long long sum = 0;
+            for ( int i = 0; i < kNumSlots; i++ )
+                sum += _slots[i].value.load();
+            return sum;
+        }
+
+        operator long long() const { return get(); }
+
+        /** Reset every slot; not atomic with respect to concurrent writers. */
+        void setToZero() {
+            for ( int i = 0; i < kNumSlots; i++ )
+                _slots[i].value.store(0);
+        }
+
+    private:
+        static const int kNumSlots = 16;
+        static const int kCacheLineBytes = 64;
+
+        struct Slot {
+            AtomicInt64 value;
+            char pad[kCacheLineBytes - sizeof(AtomicInt64)];
+        };
+
+        /** The slot assigned to the calling thread, in [0, kNumSlots). */
+        static int _threadSlot();
+
+        Slot _slots[kNumSlots];
+    };
+
+}  // namespace mongo
@@ -0,0 +1,78 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/platform/striped_counter.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+    namespace {
+
+        TEST(StripedCounter64, BasicOperations) {
+            StripedCounter64 c;
+            ASSERT_EQUALS(0LL, c.get());
+
+            c.increment();
+            ASSERT_EQUALS(1LL, c.get());
+
+            c.increment(41);
+            ASSERT_EQUALS(42LL, c.get());
+
+            c.decrement(2);
+            ASSERT_EQUALS(40LL, c.get());
+
+            ASSERT_EQUALS(40LL, static_cast<long long>(c));
+
+            c.setToZero();
+            ASSERT_EQUALS(0LL, c.get());
+        }
+
+        const int kIncrementsPerThread = 100000;
+
+        void incrementLots(StripedCounter64* c) {
+            for (int i = 0; i < kIncrementsPerThread; ++i)
+                c->increment();
+        }
+
+        TEST(StripedCounter64, ThreadedIncrementsSum) {
+            StripedCounter64 c;
+
+            const int kNumThreads = 8;
+            boost::thread_group threads;
+            for (int i = 0; i < kNumThreads; ++i)
+                threads.create_thread(boost::bind(incrementLots, &c));
+            threads.join_all();
+
+            ASSERT_EQUALS(static_cast<long long>(kNumThreads) * kIncrementsPerThread, c.get());
+        }
+
+    }  // namespace
+}  // namespace mongo
@@ -200,6 +200,28 @@ namespace mongo {
         }        
     }
 
+    long long Balancer::_updateShardLatency( const string& name, const ShardStatus& status ) {
+        const std::pair<long long, long long> current( status.crudOps(), status.crudMicros() );
+
+        std::map< string, std::pair<long long, long long> >::iterator it =
+            _lastLatencySample.find( name );
+
+        long long avgMicros = 0;
+        if ( it != _lastLatencySample.end() ) {
+            const long long ops = current.first - it->second.first;
+            const long long micros = current.second - it->second.second;
+            // negative deltas mean the shard restarted; skip this interval
+            if ( ops > 0 && micros >= 0 )
+                avgMicros = micros / ops;
+            it->second = current;
+        }
+        else {
+            _lastLatencySample[name] = current;
+        }
+
+        return avgMicros;
+    }
+
     void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
@@ -262,7 +284,8 @@ namespace mongo {
                                                   s.isDraining(),
                                                   status.hasOpsQueued(),
                                                   s.tags(),
-                                                  status.mongoVersion()
+                                                  status.mongoVersion(),
+                                                  _updateShardLatency( s.getName(), status )
                                                   );
         }
 
@@ -38,6 +38,8 @@
 
 namespace mongo {
 
+    class ShardStatus;
+
     /**
      * The balancer is a background task that tries to keep the number of chunks across all servers of the cluster even. Although
      * every mongos will have one balancer running, only one of them will be active at the any given point in time. The balancer
@@ -73,7 +75,19 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
-        
+
+        // cumulative (crudOps, crudMicros) per shard from the previous round, used
+        // to turn the shards' monotonic latency totals into a per-round average
+        std::map< std::string, std::pair<long long, long long> > _lastLatencySample;
+
+        /**
+         * Computes the shard's average CRUD op latency (micros) since the last
+         * balancing round from its cumulative serverStatus totals, updating the
+         * stored sample.  Returns 0 on the first round or when no ops ran.
+         */
+        long long _updateShardLatency( const std::string& name, const ShardStatus& status );
+
+
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
          *
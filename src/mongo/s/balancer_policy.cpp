@@ -31,6 +31,7 @@
 
 #include <algorithm>
 
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/config.h"
 #include "mongo/util/stringutils.h"
@@ -39,6 +40,8 @@
 
 namespace mongo {
 
+    MONGO_EXPORT_SERVER_PARAMETER( balancerShardLatencyCeilingMicros, int, 0 );
+
     string TagRange::toString() const {
         return str::stream() << min << " -->> " << max << "  on  " << tag;
     }
@@ -88,6 +91,7 @@ namespace mongo {
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
+        long long bestLatency = 0;
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             if ( i->second.isSizeMaxed() ) {
@@ -110,14 +114,32 @@ namespace mongo {
                 continue;
             }
 
+            const long long myLatency = i->second.getOpLatencyMicros();
+            if ( balancerShardLatencyCeilingMicros > 0 &&
+                 myLatency > balancerShardLatencyCeilingMicros ) {
+                LOG(1) << i->first << " is over the balancer latency ceiling"
+                       << " avg: " << myLatency << "us"
+                       << " ceiling: " << balancerShardLatencyCeilingMicros << "us" << endl;
+                continue;
+            }
+
             unsigned myChunks = numberOfChunksInShard( i->first );
-            if ( myChunks >= minChunks ) {
+            if ( myChunks > minChunks ) {
                 LOG(1) << i->first << " has more chunks me:" << myChunks << " best: " << best << ":" << minChunks << endl;
                 continue;
             }
 
+            // break chunk-count ties on load, so of two equally empty shards the
+            // less busy one takes the chunk
+            if ( myChunks == minChunks && best.size() > 0 && myLatency >= bestLatency ) {
+                LOG(1) << i->first << " has same number of chunks but higher latency"
+                       << " me:" << myLatency << "us best: " << best << ":" << bestLatency << "us" << endl;
+                continue;
+            }
+
             best = i->first;
             minChunks = myChunks;
+            bestLatency = myLatency;
         }
 
         return best;
@@ -417,21 +439,24 @@ namespace mongo {
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining, bool opsQueued,
-                          const set<string>& tags, 
-                          const string& mongoVersion )
+                          const set<string>& tags,
+                          const string& mongoVersion,
+                          long long opLatencyMicros )
         : _maxSize( maxSize ),
           _currSize( currSize ),
           _draining( draining ),
           _hasOpsQueued( opsQueued ),
           _tags( tags ),
-          _mongoVersion( mongoVersion ) {
+          _mongoVersion( mongoVersion ),
+          _opLatencyMicros( opLatencyMicros ) {
     }
 
     ShardInfo::ShardInfo()
         : _maxSize( 0 ),
           _currSize( 0 ),
           _draining( false ),
-          _hasOpsQueued( false ) {
+          _hasOpsQueued( false ),
+          _opLatencyMicros( 0 ) {
     }
 
     void ShardInfo::addTag( const string& tag ) {
@@ -458,6 +483,8 @@ namespace mongo {
         ss << " currSize: " << _currSize;
         ss << " draining: " << _draining;
         ss << " hasOpsQueued: " << _hasOpsQueued;
+        if ( _opLatencyMicros > 0 )
+            ss << " opLatencyMicros: " << _opLatencyMicros;
         if ( _tags.size() > 0 ) {
             ss << "tags : ";
             for ( set<string>::const_iterator i = _tags.begin(); i != _tags.end(); ++i )
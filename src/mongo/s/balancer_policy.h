@@ -64,13 +64,19 @@ namespace mongo {
         std::string toString() const;
     };
     
+    // Shards whose average CRUD latency over the last balancing interval exceeds
+    // this many microseconds are not offered new chunks; 0 (default) disables
+    // the check.
+    extern int balancerShardLatencyCeilingMicros;
+
     class ShardInfo {
     public:
         ShardInfo();
-        ShardInfo( long long maxSize, long long currSize, 
-                   bool draining, bool opsQueued, 
+        ShardInfo( long long maxSize, long long currSize,
+                   bool draining, bool opsQueued,
                    const std::set<std::string>& tags = std::set<std::string>(),
-                   const std::string& _mongoVersion = std::string("") );
+                   const std::string& _mongoVersion = std::string(""),
+                   long long opLatencyMicros = 0 );
 
         void addTag( const std::string& tag );
 
@@ -101,8 +107,15 @@ namespace mongo {
 
         std::string getMongoVersion() const { return _mongoVersion; }
 
+        /**
+         * @return average CRUD op latency on the shard over the last balancing
+         * interval, in microseconds; 0 when unknown.  Used as a load signal so
+         * busy shards aren't asked to take on more chunks.
+         */
+        long long getOpLatencyMicros() const { return _opLatencyMicros; }
+
         std::string toString() const;
-        
+
     private:
         long long _maxSize;
         long long _currSize;
@@ -110,6 +123,7 @@ namespace mongo {
         bool _hasOpsQueued;
         std::set<std::string> _tags;
         std::string _mongoVersion;
+        long long _opLatencyMicros;
     };
     
     struct MigrateInfo {
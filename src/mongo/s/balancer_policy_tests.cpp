@@ -126,6 +126,62 @@ namespace mongo {
             ASSERT( ! c->chunk.min.isEmpty() );
         }
 
+        TEST( BalancerPolicyTests , BalanceLatencyTieBreakTest ) {
+            // 2 chunks on shard0; shard1 and shard2 both empty, shard2 much busier
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunkMap["shard1"] = chunks;
+            chunkMap["shard2"] = chunks;
+
+            // ShardInfo(maxSize, currSize, draining, opsQueued, tags, version, opLatencyMicros)
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 2, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false,
+                                        set<string>(), string(""), 500 );
+            info["shard2"] = ShardInfo( 0, 0, false, false,
+                                        set<string>(), string(""), 9000 );
+
+            DistributionStatus status( info, chunkMap );
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 1 );
+            ASSERT( c );
+            ASSERT_EQUALS( c->to, "shard1" );
+        }
+
+        TEST( BalancerPolicyTests , BalanceLatencyCeilingTest ) {
+            // the only possible receiver is over the latency ceiling
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunkMap["shard1"] = chunks;
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 2, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false,
+                                        set<string>(), string(""), 50000 );
+
+            DistributionStatus status( info, chunkMap );
+
+            balancerShardLatencyCeilingMicros = 10000;
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 1 );
+            ASSERT( ! c );
+
+            balancerShardLatencyCeilingMicros = 0;
+            c = BalancerPolicy::balance( "ns", status, 1 );
+            ASSERT( c );
+            ASSERT_EQUALS( c->to, "shard1" );
+        }
+
         TEST( BalancerPolicyTests , BalanceEndedDrainingTest ) {
             // 2 chunks and 0 chunk (drain completed) shards
             ShardToChunksMap chunkMap;
@@ -38,6 +38,7 @@
 #include "mongo/db/write_concern.h"
 #include "mongo/platform/random.h"
 #include "mongo/s/chunk_diff.h"
+#include "mongo/s/chunk_map_cache.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/cluster_write.h"
@@ -736,8 +737,27 @@ namespace mongo {
                     const_cast<ChunkMap&>(_chunkMap).swap(chunkMap);
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
+
+                    // The map may share Chunk objects with the old manager; now
+                    // that the load has validated, this manager owns them.  Must
+                    // happen before the ranges are rebuilt, which asserts that
+                    // every chunk belongs to one manager.
+                    for ( ChunkMap::const_iterator it = _chunkMap.begin();
+                          it != _chunkMap.end(); ++it ) {
+                        it->second->reassignManager( this );
+                    }
+
                     const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
 
+                    // Persist the validated map so the next cold start of this process can
+                    // seed its load from disk instead of re-reading every chunk document.
+                    if ( ChunkMapCache::enabled() ) {
+                        if ( _version.isSet() )
+                            ChunkMapCache::save( _ns, _version, _chunkMap );
+                        else
+                            ChunkMapCache::forget( _ns );
+                    }
+
                     // Once we load data, clear reference to old manager
                     _oldManager.reset();
 
@@ -748,7 +768,10 @@ namespace mongo {
             if (_chunkMap.size() < 10) {
                 _printChunks();
             }
-            
+
+            // Don't let a bad cache file wedge all three attempts.
+            ChunkMapCache::forget( _ns );
+
             warning() << "ChunkManager loaded an invalid config for " << _ns
                       << ", trying again" << endl;
 
@@ -818,24 +841,14 @@ namespace mongo {
             // Load a copy of the old versions
             shardVersions = oldManager->_shardVersions;
 
-            // Load a copy of the chunk map, replacing the chunk manager with our own
+            // Start from the old chunk map, sharing the Chunk objects themselves.
+            // We used to clone every chunk here (the dominant cost of a refresh
+            // on large collections); instead, unchanged chunks are reused as-is
+            // and re-homed onto this manager only once the refreshed map has
+            // validated -- see loadExistingRanges().  Chunks the diff replaces
+            // below stay owned by (and pointing at) the old manager.
             const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-            // Could be v.expensive
-            // TODO: If chunks were immutable and didn't reference the manager, we could do more
-            // interesting things here
-            for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
-
-                ChunkPtr oldC = it->second;
-                ChunkPtr c( new Chunk( this, oldC->getMin(),
-                                             oldC->getMax(),
-                                             oldC->getShard(),
-                                             oldC->getLastmod() ) );
-
-                c->setBytesWritten( oldC->getBytesWritten() );
-
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
-            }
+            chunkMap = oldChunkMap;
 
             // Also get any minor versions stored for reload
             oldManager->getMarkedMinorVersions( minorVersions );
@@ -844,6 +857,41 @@ namespace mongo {
                    << " using old chunk manager w/ version " << _version.toString()
                    << " and " << oldChunkMap.size() << " chunks" << endl;
         }
+        else if ( ChunkMapCache::enabled() ) {
+
+            // No previous manager to diff from (typically a freshly started mongos).  Seed the
+            // diff from the chunk map this process last persisted, if it was written for the
+            // same collection epoch, so only chunks changed since then are fetched below.
+            vector<BSONObj> cachedDocs;
+            ChunkVersion cachedVersion;
+
+            if ( ChunkMapCache::load( _ns, _version.epoch(), &cachedDocs, &cachedVersion ) ) {
+                try {
+                    for ( size_t i = 0; i < cachedDocs.size(); i++ ) {
+                        ChunkPtr c( new Chunk( this, cachedDocs[i] ) );
+                        chunkMap[c->getMax()] = c;
+
+                        ChunkVersion& shardMax = shardVersions[c->getShard()];
+                        if ( c->getLastmod() > shardMax )
+                            shardMax = c->getLastmod();
+                    }
+
+                    _version = cachedVersion;
+
+                    log() << "seeded chunk manager for " << _ns << " from local cache with "
+                          << cachedDocs.size() << " chunks at version "
+                          << _version.toString() << endl;
+                }
+                catch ( const DBException& e ) {
+                    warning() << "invalid chunk document in chunk map cache for " << _ns
+                              << causedBy( e ) << endl;
+                    ChunkMapCache::forget( _ns );
+                    chunkMap.clear();
+                    shardVersions.clear();
+                    _version = ChunkVersion( 0, 0, _version.epoch() );
+                }
+            }
+        }
 
         // Attach a diff tracker for the versioned chunk data
         CMConfigDiffTracker differ( this );
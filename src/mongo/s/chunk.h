@@ -237,10 +237,22 @@ namespace mongo {
         
 
     private:
+        friend class ChunkManager;
+
+        /**
+         * Re-homes this chunk onto the manager generation that now owns it.
+         * Only called by ChunkManager::loadExistingRanges() once a refreshed
+         * map has validated, so chunks can be shared between generations
+         * instead of cloned.  A reader racing through the old manager may see
+         * either generation's pointer; both return identical collection
+         * metadata (ns, shard key, uniqueness), so this is benign.
+         */
+        void reassignManager( const ChunkManager* manager ) const { _manager = manager; }
 
         // main shard info
-        
-        const ChunkManager * _manager;
+
+        // mutable only so reassignManager() can re-home a shared chunk
+        mutable const ChunkManager * _manager;
 
         BSONObj _min;
         BSONObj _max;
@@ -109,7 +109,7 @@ namespace mongo {
                                         << _manager->getShardKey().key() );
             }
 
-            ChunkPtr chunk = _manager->findChunkForDoc( doc );
+            ChunkPtr chunk = findChunkForDoc( doc );
             *endpoint = new ShardEndpoint( chunk->getShard().getName(),
                                            _manager->getVersion( chunk->getShard() ) );
 
@@ -240,7 +240,7 @@ namespace mongo {
             // Track autosplit stats for sharded collections
             // Note: this is only best effort accounting and is not accurate.
             if ( exactShardKeyQuery ) {
-                ChunkPtr chunk = _manager->findChunkForDoc(targetedDoc);
+                ChunkPtr chunk = findChunkForDoc(targetedDoc);
                 _stats->chunkSizeDelta[chunk->getMin()] +=
                     ( query.objsize() + updateExpr.objsize() );
             }
@@ -336,13 +336,28 @@ namespace mongo {
         return Status::OK();
     }
 
+    ChunkPtr ChunkManagerTargeter::findChunkForDoc( const BSONObj& doc ) const {
+
+        BSONObj key = _manager->getShardKey().extractKey( doc );
+
+        // Batched writes tend to hit long runs of documents in the same chunk,
+        // so try the last chunk we targeted before searching the chunk map again.
+        if ( !_lastChunk
+             || _lastChunk->getManager() != _manager.get()
+             || !_lastChunk->containsPoint( key ) ) {
+            _lastChunk = _manager->findIntersectingChunk( key );
+        }
+
+        return _lastChunk;
+    }
+
     Status ChunkManagerTargeter::targetShardKey(const BSONObj& doc,
                                                 ShardEndpoint** endpoint) const {
 
         invariant(NULL != _manager);
         dassert(_manager->hasShardKey(doc));
 
-        ChunkPtr chunk = _manager->findChunkForDoc(doc);
+        ChunkPtr chunk = findChunkForDoc(doc);
 
         Shard shard = chunk->getShard();
         *endpoint = new ShardEndpoint(shard.getName(),
@@ -127,6 +127,14 @@ namespace mongo {
          */
         Status targetShardKey( const BSONObj& doc, ShardEndpoint** endpoint ) const;
 
+        /**
+         * Finds the chunk owning a doc's shard key, remembering the last chunk
+         * found.  Large batches tend to target long runs of documents into the
+         * same chunk, so a containment check against the remembered chunk
+         * usually replaces a full chunk map search.
+         */
+        ChunkPtr findChunkForDoc( const BSONObj& doc ) const;
+
         NamespaceString _nss;
 
         // Zero or one of these are filled at all times
@@ -134,6 +142,11 @@ namespace mongo {
         ChunkManagerPtr _manager;
         ShardPtr _primary;
 
+        // Last chunk targeted by findChunkForDoc(); ignored if it belongs to a
+        // different chunk manager than the current one.  Only a targeting hint,
+        // never authoritative.
+        mutable ChunkPtr _lastChunk;
+
         // Map of shard->remote shard version reported from stale errors
         typedef std::map<std::string, ChunkVersion> ShardVersionMap;
         ShardVersionMap _remoteShardVersions;
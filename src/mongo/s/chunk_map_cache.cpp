@@ -0,0 +1,236 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/s/chunk_map_cache.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/type_chunk.h"
+
+namespace mongo {
+
+    // Directory mongos persists its last-known chunk maps into.  Empty (the default)
+    // disables the cache entirely.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER( chunkMapCachePath, std::string, "" );
+
+    namespace {
+
+        const int kCacheFormatVersion = 1;
+
+        // Namespaces are mostly filesystem-safe, but don't rely on it; anything outside a
+        // conservative character set is flattened.  Collisions are harmless because the
+        // header records the real namespace and load() verifies it.
+        string cacheFileFor( const string& ns ) {
+            string name = ns;
+            for ( size_t i = 0; i < name.size(); i++ ) {
+                char c = name[i];
+                bool safe = ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+                            ( c >= '0' && c <= '9' ) || c == '.' || c == '-' || c == '_';
+                if ( !safe )
+                    name[i] = '_';
+            }
+
+            boost::filesystem::path p( chunkMapCachePath );
+            p /= name + ".chunkmap";
+            return p.string();
+        }
+    }
+
+    bool ChunkMapCache::enabled() {
+        return !chunkMapCachePath.empty();
+    }
+
+    bool ChunkMapCache::load( const string& ns,
+                              const OID& epoch,
+                              vector<BSONObj>* docs,
+                              ChunkVersion* version ) {
+
+        if ( !enabled() )
+            return false;
+
+        const string file = cacheFileFor( ns );
+
+        std::ifstream in( file.c_str(), std::ios::in | std::ios::binary );
+        if ( !in.is_open() )
+            return false;
+
+        in.seekg( 0, std::ios::end );
+        const std::streamoff fileLen = in.tellg();
+        in.seekg( 0, std::ios::beg );
+
+        if ( fileLen < 5 ) {
+            warning() << "chunk map cache file " << file << " is truncated, ignoring" << endl;
+            return false;
+        }
+
+        std::vector<char> buf( static_cast<size_t>( fileLen ) );
+        in.read( &buf[0], fileLen );
+        if ( !in.good() ) {
+            warning() << "could not read chunk map cache file " << file << ", ignoring" << endl;
+            return false;
+        }
+
+        const char* p = &buf[0];
+        long long remaining = fileLen;
+
+        vector<BSONObj> loaded;
+        BSONObj header;
+
+        while ( remaining > 0 ) {
+            if ( remaining < 5 ) {
+                warning() << "chunk map cache file " << file << " is truncated, ignoring" << endl;
+                return false;
+            }
+
+            const int objSize = *reinterpret_cast<const int*>( p );
+            if ( objSize < 5 || objSize > remaining || objSize > BSONObjMaxInternalSize ) {
+                warning() << "chunk map cache file " << file << " is corrupt, ignoring" << endl;
+                return false;
+            }
+
+            BSONObj o( p );
+            if ( header.isEmpty() ) {
+                header = o.getOwned();
+            }
+            else {
+                loaded.push_back( o.getOwned() );
+            }
+
+            p += objSize;
+            remaining -= objSize;
+        }
+
+        if ( header["formatVersion"].numberInt() != kCacheFormatVersion ||
+             header["ns"].str() != ns ) {
+            warning() << "chunk map cache file " << file
+                      << " has an unexpected header, ignoring" << endl;
+            return false;
+        }
+
+        if ( header["count"].numberLong() != static_cast<long long>( loaded.size() ) ) {
+            warning() << "chunk map cache file " << file << " is truncated, ignoring" << endl;
+            return false;
+        }
+
+        ChunkVersion cachedVersion = ChunkVersion::fromBSON( header, "version" );
+        if ( !cachedVersion.isSet() || cachedVersion.epoch() != epoch ) {
+            // Dropped and recreated since the cache was written; a full reload is needed.
+            LOG(1) << "chunk map cache for " << ns << " has epoch " << cachedVersion.epoch()
+                   << ", collection now has " << epoch << ", ignoring" << endl;
+            return false;
+        }
+
+        docs->swap( loaded );
+        *version = cachedVersion;
+        return true;
+    }
+
+    void ChunkMapCache::save( const string& ns,
+                              const ChunkVersion& version,
+                              const ChunkMap& chunks ) {
+
+        if ( !enabled() )
+            return;
+
+        const string file = cacheFileFor( ns );
+        const string tmp = file + ".tmp";
+
+        try {
+            BSONObjBuilder hb;
+            hb.append( "formatVersion", kCacheFormatVersion );
+            hb.append( "ns", ns );
+            version.addToBSON( hb, "version" );
+            hb.appendNumber( "count", static_cast<long long>( chunks.size() ) );
+            const BSONObj header = hb.obj();
+
+            std::ofstream out( tmp.c_str(),
+                               std::ios::out | std::ios::binary | std::ios::trunc );
+            if ( !out.is_open() ) {
+                warning() << "could not open chunk map cache file " << tmp
+                          << " for writing" << endl;
+                return;
+            }
+
+            out.write( header.objdata(), header.objsize() );
+
+            for ( ChunkMap::const_iterator it = chunks.begin(); it != chunks.end(); ++it ) {
+                const ChunkPtr& c = it->second;
+
+                // Same format as a config.chunks document, so the Chunk constructor and the
+                // config diff machinery can consume it unchanged.
+                BSONObjBuilder b;
+                b << ChunkType::name( Chunk::genID( ns, c->getMin() ) );
+                c->getLastmod().addToBSON( b, ChunkType::DEPRECATED_lastmod() );
+                b << ChunkType::ns( ns );
+                b << ChunkType::min( c->getMin() );
+                b << ChunkType::max( c->getMax() );
+                b << ChunkType::shard( c->getShard().getName() );
+                if ( c->isJumbo() )
+                    b << ChunkType::jumbo( true );
+
+                const BSONObj doc = b.obj();
+                out.write( doc.objdata(), doc.objsize() );
+            }
+
+            out.close();
+            if ( out.fail() ) {
+                warning() << "failed writing chunk map cache file " << tmp << endl;
+                boost::filesystem::remove( tmp );
+                return;
+            }
+
+            boost::filesystem::rename( tmp, file );
+
+            LOG(1) << "saved chunk map cache for " << ns << " with " << chunks.size()
+                   << " chunks at version " << version << endl;
+        }
+        catch ( const std::exception& e ) {
+            warning() << "failed to save chunk map cache for " << ns
+                      << causedBy( e.what() ) << endl;
+        }
+    }
+
+    void ChunkMapCache::forget( const string& ns ) {
+
+        if ( !enabled() )
+            return;
+
+        try {
+            boost::filesystem::remove( cacheFileFor( ns ) );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "failed to remove chunk map cache for " << ns
+                      << causedBy( e.what() ) << endl;
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,85 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/s/chunk.h"
+#include "mongo/s/chunk_version.h"
+
+namespace mongo {
+
+    /**
+     * Local disk cache of the last chunk map this mongos loaded for a collection.
+     *
+     * When enabled (--setParameter chunkMapCachePath=<directory>), a mongos that has to build
+     * a ChunkManager with no previous manager to diff from seeds the config diff with the
+     * cached chunk documents and fetches only chunks changed since the cached ChunkVersion,
+     * instead of re-reading every config.chunks document.  A fleet-wide mongos restart then
+     * costs each process a small diff query per collection rather than a full chunk scan.
+     *
+     * Cache files are strictly advisory: a missing, truncated, or stale-epoch file is ignored
+     * and the load falls back to a full read from the config servers.  A file is one header
+     * document followed by the chunk documents, concatenated in BSON wire format.
+     */
+    class ChunkMapCache {
+    public:
+        /** true if a cache directory was configured at startup */
+        static bool enabled();
+
+        /**
+         * Loads the cached chunk documents for 'ns' into 'docs' (same format as config.chunks
+         * documents) and the version the cache was written at into 'version'.  Returns false,
+         * leaving the outputs untouched, if the cache is disabled, has no file for 'ns', the
+         * file fails validation, or it was written for a collection epoch other than 'epoch'.
+         */
+        static bool load( const std::string& ns,
+                          const OID& epoch,
+                          std::vector<BSONObj>* docs,
+                          ChunkVersion* version );
+
+        /**
+         * Rewrites the cache file for 'ns' from a validated chunk map, via a temporary file
+         * and rename so readers never see a half-written file.  Failures are logged and
+         * swallowed; the cache is best-effort.
+         */
+        static void save( const std::string& ns,
+                          const ChunkVersion& version,
+                          const ChunkMap& chunks );
+
+        /**
+         * Removes any cache file for 'ns', e.g. when the collection turns out to be dropped
+         * or a cache-seeded load could not produce a consistent chunk map.
+         */
+        static void forget( const std::string& ns );
+    };
+
+} // namespace mongo
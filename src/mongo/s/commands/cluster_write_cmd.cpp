@@ -31,6 +31,7 @@
 #include "mongo/db/client_basic.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/write_commands/write_commands_common.h"
+#include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/s/cluster_write.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/stats/counters.h"
@@ -162,8 +163,19 @@ namespace mongo {
             // Disable the last error object for the duration of the write
             LastError::Disabled disableLastError( cmdLastError );
 
+            // maxTimeMS is a generic command option, so the batch parsers ignore it; it is
+            // extracted here and threaded through to batch execution, which deducts elapsed
+            // time before forwarding the remainder to the shards.
+            StatusWith<int> maxTimeMS = LiteParsedQuery::parseMaxTimeMSCommand( cmdObj );
+
             // TODO: if we do namespace parsing, push this to the type
-            if ( !request.parseBSON( cmdObj, &errMsg ) || !request.isValid( &errMsg ) ) {
+            if ( !maxTimeMS.isOK() ) {
+
+                response.setOk( false );
+                response.setErrCode( ErrorCodes::FailedToParse );
+                response.setErrMessage( maxTimeMS.getStatus().reason() );
+            }
+            else if ( !request.parseBSON( cmdObj, &errMsg ) || !request.isValid( &errMsg ) ) {
 
                 // Batch parse failure
                 response.setOk( false );
@@ -172,6 +184,10 @@ namespace mongo {
             }
             else {
 
+                if ( maxTimeMS.getValue() != 0 ) {
+                    request.setMaxTimeMS( maxTimeMS.getValue() );
+                }
+
                 // Fixup the namespace to be a full ns internally
                 NamespaceString nss( dbName, request.getNS() );
                 request.setNS( nss.ns() );
@@ -620,6 +620,21 @@ namespace mongo {
                             return false;
                         }
 
+                        // mongos routing and chunk boundaries are defined in terms of the
+                        // original (hashVersion 0) hash, so alternate hash versions can't
+                        // be used for sharding.
+                        if ( isHashedShardKey && !idx["hashVersion"].eoo()
+                            && idx["hashVersion"].numberInt() != 0 ) {
+                            errmsg = str::stream()
+                                    << "can't shard collection " << ns << " with hashed shard key "
+                                    << proposedKey
+                                    << " because the hashed index uses hashVersion "
+                                    << idx["hashVersion"].numberInt()
+                                    << "; mongos routing requires hashVersion 0";
+                            conn.done();
+                            return false;
+                        }
+
                         hasUsefulIndexForKey = true;
                     }
                 }
@@ -32,9 +32,11 @@
 
 #include "pcrecpp.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/chunk.h"
@@ -62,6 +64,23 @@ namespace mongo {
 
     OID serverID;
 
+    /**
+     * Metadata cache counters, reported under metrics.configCache in serverStatus.
+     * A hit is a config.collections entry whose lastmodEpoch still matched the
+     * cached chunk manager during a db reload; a coalesced load is a load() call
+     * that waited on another thread's in-flight config server fetch instead of
+     * issuing its own.
+     */
+    static Counter64 configCacheHits;
+    static Counter64 configCacheMisses;
+    static Counter64 configCacheLoadsCoalesced;
+    static ServerStatusMetricField<Counter64> displayConfigCacheHits(
+            "configCache.hits", &configCacheHits );
+    static ServerStatusMetricField<Counter64> displayConfigCacheMisses(
+            "configCache.misses", &configCacheMisses );
+    static ServerStatusMetricField<Counter64> displayConfigCacheLoadsCoalesced(
+            "configCache.loadsCoalesced", &configCacheLoadsCoalesced );
+
     /* --- DBConfig --- */
 
     DBConfig::CollectionInfo::CollectionInfo( const BSONObj& in ) {
@@ -351,14 +370,20 @@ namespace mongo {
         ChunkVersion oldVersion;
         ChunkManagerPtr oldManager;
 
+        bool earlyReload = false;
+        {
+            scoped_lock lk( _lock );
+            earlyReload = ! _collections[ns].isSharded() && ( shouldReload || forceReload );
+        }
+
+        if ( earlyReload ) {
+            // this is to catch cases where there this is a new sharded collection.
+            // load() coalesces concurrent callers onto a single config server fetch.
+            load();
+        }
+
         {
             scoped_lock lk( _lock );
-            
-            bool earlyReload = ! _collections[ns].isSharded() && ( shouldReload || forceReload );
-            if ( earlyReload ) {
-                // this is to catch cases where there this is a new sharded collection
-                _reload();
-            }
 
             CollectionInfo& ci = _collections[ns];
             uassert( 10181 ,  (string)"not sharded:" + ns , ci.isSharded() );
@@ -509,39 +534,112 @@ namespace mongo {
     }
 
     bool DBConfig::load() {
+        {
+            scoped_lock lk( _lock );
+
+            // Single-flight: if another thread is already fetching this db's
+            // metadata from the config servers, wait for its result instead of
+            // issuing a duplicate round of queries.  During metadata churn many
+            // threads notice staleness at once.
+            while ( _loadInProgress ) {
+                long long myGeneration = _loadGeneration;
+                configCacheLoadsCoalesced.increment();
+
+                while ( _loadInProgress && _loadGeneration == myGeneration ) {
+                    _loadDoneCV.wait( lk.boost() );
+                }
+
+                if ( _loadGeneration != myGeneration && _lastLoadOk ) {
+                    return _lastLoadResult;
+                }
+
+                // the load we waited on threw - retry it ourselves
+            }
+
+            _loadInProgress = true;
+        }
+
+        bool successful = false;
+        try {
+            successful = _load();
+        }
+        catch ( ... ) {
+            scoped_lock lk( _lock );
+            _loadInProgress = false;
+            _loadGeneration++;
+            _lastLoadOk = false;
+            _loadDoneCV.notify_all();
+            throw;
+        }
+
         scoped_lock lk( _lock );
-        return _load();
+        _loadInProgress = false;
+        _loadGeneration++;
+        _lastLoadOk = true;
+        _lastLoadResult = successful;
+        _loadDoneCV.notify_all();
+
+        return successful;
     }
 
     bool DBConfig::_load() {
-        ScopedDbConnection conn(configServer.modelServer(), 30.0);
+        // Fetch phase: all config server I/O happens with no locks held, so a slow
+        // config server doesn't stall every thread touching this DBConfig.
+        BSONObj dbObj;
+        vector<BSONObj> collObjs;
+        {
+            ScopedDbConnection conn(configServer.modelServer(), 30.0);
 
-        BSONObj dbObj = conn->findOne( DatabaseType::ConfigNS,
-                                       BSON( DatabaseType::name( _name ) ) );
+            dbObj = conn->findOne( DatabaseType::ConfigNS,
+                                   BSON( DatabaseType::name( _name ) ) );
+
+            if ( dbObj.isEmpty() ) {
+                conn.done();
+                return false;
+            }
+
+            BSONObjBuilder b;
+            b.appendRegex(CollectionType::ns(),
+                          (string)"^" + pcrecpp::RE::QuoteMeta( _name ) + "\\." );
+
+            auto_ptr<DBClientCursor> cursor = conn->query(CollectionType::ConfigNS, b.obj());
+            verify( cursor.get() );
+            while ( cursor->more() ) {
+                collObjs.push_back( cursor->next().getOwned() );
+            }
 
-        if ( dbObj.isEmpty() ) {
             conn.done();
-            return false;
         }
 
-        unserialize( dbObj );
-
-        BSONObjBuilder b;
-        b.appendRegex(CollectionType::ns(),
-                      (string)"^" + pcrecpp::RE::QuoteMeta( _name ) + "\\." );
+        // Snapshot the epochs of the chunk managers we already have.  A collection
+        // whose lastmodEpoch is unchanged was not dropped or resharded, which is
+        // all a db-level reload needs to notice - newer chunk versions within the
+        // same epoch are picked up by getChunkManager()'s version check, not here.
+        map<string, OID> cachedEpochs;
+        {
+            scoped_lock lk( _lock );
+            for ( Collections::const_iterator i = _collections.begin();
+                    i != _collections.end(); ++i ) {
+                if ( i->second.isSharded() )
+                    cachedEpochs[ i->first ] = i->second.getCM()->getVersion().epoch();
+            }
+        }
 
         int numCollsErased = 0;
         int numCollsSharded = 0;
+        int numCollsCached = 0;
 
-        auto_ptr<DBClientCursor> cursor = conn->query(CollectionType::ConfigNS, b.obj());
-        verify( cursor.get() );
-        while ( cursor->more() ) {
+        vector<string> erasedColls;               // dropped, to remove from the cache
+        map<string, CollectionInfo> changedColls; // epoch changed, rebuilt below
 
-            BSONObj collObj = cursor->next();
+        for ( vector<BSONObj>::const_iterator it = collObjs.begin();
+                it != collObjs.end(); ++it ) {
+
+            const BSONObj& collObj = *it;
             string collName = collObj[CollectionType::ns()].String();
 
             if( collObj[CollectionType::dropped()].trueValue() ){
-                _collections.erase( collName );
+                erasedColls.push_back( collName );
                 numCollsErased++;
             }
             else if( !collObj[CollectionType::primary()].eoo() ){
@@ -549,19 +647,51 @@ namespace mongo {
                 // "primary" field set.
 
                 // Erased in case it was previously sharded, dropped, then init'd as unsharded
-                _collections.erase( collName );
+                erasedColls.push_back( collName );
                 numCollsErased++;
             }
             else{
-                _collections[ collName ] = CollectionInfo( collObj );
-                if( _collections[ collName ].isSharded() ) numCollsSharded++;
+                map<string, OID>::const_iterator c = cachedEpochs.find( collName );
+                BSONElement epochElem = collObj[CollectionType::DEPRECATED_lastmodEpoch()];
+
+                if ( c != cachedEpochs.end() && epochElem.type() == jstOID &&
+                        epochElem.OID().isSet() && epochElem.OID() == c->second ) {
+                    // cache hit: keep the ChunkManager we already have
+                    numCollsCached++;
+                    configCacheHits.increment();
+                }
+                else {
+                    // cache miss: building the CollectionInfo loads every chunk,
+                    // still with no locks held
+                    changedColls[ collName ] = CollectionInfo( collObj );
+                    if ( changedColls[ collName ].isSharded() ) numCollsSharded++;
+                    configCacheMisses.increment();
+                }
             }
         }
 
-        LOG(2) << "found " << numCollsErased << " dropped collections and "
-               << numCollsSharded << " sharded collections for database " << _name << endl;
+        // Apply phase: swap the results in under the lock.  Collections whose
+        // epoch matched keep whatever the cache holds, including any update a
+        // writer made while we were fetching.
+        {
+            scoped_lock lk( _lock );
 
-        conn.done();
+            unserialize( dbObj );
+
+            for ( vector<string>::const_iterator it = erasedColls.begin();
+                    it != erasedColls.end(); ++it ) {
+                _collections.erase( *it );
+            }
+
+            for ( map<string, CollectionInfo>::const_iterator it = changedColls.begin();
+                    it != changedColls.end(); ++it ) {
+                _collections[ it->first ] = it->second;
+            }
+        }
+
+        LOG(2) << "found " << numCollsErased << " dropped collections, "
+               << numCollsSharded << " newly loaded and " << numCollsCached
+               << " cached sharded collections for database " << _name << endl;
 
         return true;
     }
@@ -603,12 +733,7 @@ namespace mongo {
     }
 
     bool DBConfig::reload() {
-        bool successful = false;
-
-        {
-            scoped_lock lk( _lock );
-            successful = _reload();
-        }
+        bool successful = load();
 
         //
         // If we aren't successful loading the database entry, we don't want to keep the stale
@@ -620,11 +745,6 @@ namespace mongo {
         return successful;
     }
 
-    bool DBConfig::_reload() {
-        // TODO: i don't think is 100% correct
-        return _load();
-    }
-
     bool DBConfig::dropDatabase( string& errmsg ) {
         /**
          * 1) make sure everything is up
@@ -35,6 +35,8 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
+
 #include "mongo/client/dbclient_rs.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/shard.h"
@@ -106,7 +108,11 @@ namespace mongo {
               _primary("config","") ,
               _shardingEnabled(false),
               _lock("DBConfig") ,
-              _hitConfigServerLock( "DBConfig::_hitConfigServerLock" ) {
+              _hitConfigServerLock( "DBConfig::_hitConfigServerLock" ),
+              _loadInProgress(false),
+              _loadGeneration(0),
+              _lastLoadOk(false),
+              _lastLoadResult(false) {
             verify( name.size() );
         }
         virtual ~DBConfig() {}
@@ -167,6 +173,13 @@ namespace mongo {
 
         void setPrimary( const std::string& s );
 
+        /**
+         * Refreshes db and collection metadata from the config servers.  Concurrent
+         * callers are coalesced onto a single fetch, and sharded collections whose
+         * lastmodEpoch is unchanged keep their cached ChunkManager instead of
+         * reloading every chunk.
+         * @return false if the database no longer exists
+         */
         bool load();
         bool reload();
 
@@ -192,8 +205,13 @@ namespace mongo {
 
         bool _dropShardedCollections( int& num, std::set<Shard>& allServers , std::string& errmsg );
 
+        /**
+         * one round of fetch-and-apply against the config servers.  Must be called
+         * WITHOUT _lock held; all network I/O happens locklessly and _lock is only
+         * taken to swap the results in.  Callers go through load(), which makes
+         * concurrent refreshes share a single fetch.
+         */
         bool _load();
-        bool _reload();
         void _save( bool db = true, bool coll = true );
 
         std::string _name; // e.g. "alleyinsider"
@@ -207,6 +225,15 @@ namespace mongo {
 
         mutable mongo::mutex _lock; // TODO: change to r/w lock ??
         mutable mongo::mutex _hitConfigServerLock;
+
+        // single-flight load coordination: one thread at a time fetches from the
+        // config servers while concurrent load() callers wait on _loadDoneCV for
+        // its result.  All of these are protected by _lock.
+        bool _loadInProgress;
+        long long _loadGeneration; // bumped when a load finishes, so waiters can tell
+        bool _lastLoadOk;          // the last load completed without throwing...
+        bool _lastLoadResult;      // ...and returned this
+        boost::condition _loadDoneCV;
     };
 
     class ConfigServer : public DBConfig {
@@ -33,6 +33,7 @@
 #include "mongo/pch.h"
 
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/util/concurrency/ticketholder.h"
@@ -80,6 +81,14 @@ namespace mongo {
         bool hasVersion( const std::string& ns , ChunkVersion& version );
         const ChunkVersion getVersion( const std::string& ns ) const;
 
+        /**
+         * Generation stamp for the collection metadata stored on this shard, bumped every
+         * time any collection's metadata is installed, replaced, or removed.  Lock-free;
+         * connections use it to validate cached shard versions so the per-op version check
+         * can skip _mutex entirely while the metadata is quiescent.
+         */
+        long long getMetadataGeneration() const { return _metadataGeneration.load(); }
+
         /**
          * If the metadata for 'ns' at this shard is at or above the requested version,
          * 'reqShardVersion', returns OK and fills in 'latestShardVersion' with the latest shard
@@ -274,6 +283,13 @@ namespace mongo {
                                   bool useRequestedVersion,
                                   ChunkVersion* latestShardVersion );
 
+        /**
+         * Invalidates cached shard versions on all connections.  Must be called after every
+         * mutation of _collMetadata (callers hold _mutex, though the counter itself is
+         * atomic so readers never need it).
+         */
+        void _signalMetadataChanged() { _metadataGeneration.addAndFetch( 1 ); }
+
         bool _enabled;
 
         std::string _configServer;
@@ -289,6 +305,9 @@ namespace mongo {
         // Map from a namespace into the metadata we need for each collection on this shard
         typedef std::map<std::string,CollectionMetadataPtr> CollectionMetadataMap;
         CollectionMetadataMap _collMetadata;
+
+        // see getMetadataGeneration()
+        AtomicInt64 _metadataGeneration;
     };
 
     extern ShardingState shardingState;
@@ -308,6 +327,20 @@ namespace mongo {
         const ChunkVersion getVersion( const std::string& ns ) const;
         void setVersion( const std::string& ns , const ChunkVersion& version );
 
+        /**
+         * Connection-local cache of the shard-side version for 'ns', keyed by the
+         * ShardingState metadata generation it was read at.  Returns true and fills in
+         * 'version' only when the cached entry's generation matches 'generation'; on a
+         * miss the caller fetches from ShardingState and calls cacheShardVersion().
+         * ShardedConnectionInfo is thread-specific, so no locking is needed.
+         */
+        bool getCachedShardVersion( const std::string& ns,
+                                    long long generation,
+                                    ChunkVersion* version ) const;
+        void cacheShardVersion( const std::string& ns,
+                                long long generation,
+                                const ChunkVersion& version );
+
         static ShardedConnectionInfo* get( bool create );
         static void reset();
         static void addHook();
@@ -327,6 +360,15 @@ namespace mongo {
         typedef std::map<std::string,ChunkVersion> NSVersionMap;
         NSVersionMap _versions;
 
+        // see getCachedShardVersion()
+        struct CachedShardVersion {
+            CachedShardVersion() : generation( -1 ) { }
+            long long generation;
+            ChunkVersion version;
+        };
+        typedef std::map<std::string,CachedShardVersion> ShardVersionCache;
+        ShardVersionCache _shardVersionCache;
+
         static boost::thread_specific_ptr<ShardedConnectionInfo> _tl;
     };
 
@@ -65,6 +65,8 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_config.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/logger/ramlog.h"
 #include "mongo/s/chunk.h"
@@ -92,6 +94,15 @@ namespace mongo {
     MONGO_FP_DECLARE(failMigrationCommit);
     MONGO_FP_DECLARE(failMigrationConfigWritePrepare);
 
+    // When > 0, the migration source watches its recent CRUD op latency and, when
+    // the average exceeds this many microseconds, shrinks clone batches and asks
+    // the destination to sleep between them, so migrations only use headroom the
+    // regular workload isn't.
+    MONGO_EXPORT_SERVER_PARAMETER( migrationThrottleTargetLatencyMicros, int, 0 );
+
+    // Upper bound for the inter-batch sleep the source may request.
+    MONGO_EXPORT_SERVER_PARAMETER( migrationThrottleMaxSleepMillis, int, 200 );
+
     Tee* migrateLog = RamLog::get("migrate");
 
     class MoveTimingHelper {
@@ -195,6 +206,8 @@ namespace mongo {
             _active = false;
             _inCriticalSection = false;
             _memoryUsed = 0;
+            _lastCrudOps = 0;
+            _lastCrudMicros = 0;
         }
 
         /**
@@ -221,9 +234,11 @@ namespace mongo {
             _max = max;
             _shardKeyPattern = shardKeyPattern;
 
+            // baseline for the latency feedback in clone()
+            globalOpLatencyHistograms.getCrudTotals( &_lastCrudOps, &_lastCrudMicros );
+
             verify( _cloneLocs.size() == 0 );
-            verify( _deleted.size() == 0 );
-            verify( _reload.size() == 0 );
+            verify( _mods.size() == 0 );
             verify( _memoryUsed == 0 );
 
             _active = true;
@@ -242,8 +257,7 @@ namespace mongo {
 
             {
                 scoped_spinlock lk( _trackerLocks );
-                _deleted.clear();
-                _reload.clear();
+                _mods.clear();
                 _cloneLocs.clear();
             }
             _memoryUsed = 0;
@@ -298,8 +312,9 @@ namespace mongo {
                 }
 
                 // can't filter deletes :(
-                _deleted.push_back( ide.wrap() );
-                _memoryUsed += ide.size() + 5;
+                BSONObj entry = BSON( "op" << "d" << "o" << ide.wrap() );
+                _mods.push_back( entry );
+                _memoryUsed += entry.objsize() + 5;
                 return;
             }
 
@@ -320,34 +335,34 @@ namespace mongo {
             if ( ! isInRange( it , _min , _max , _shardKeyPattern ) )
                 return;
 
-            _reload.push_back( ide.wrap() );
-            _memoryUsed += ide.size() + 5;
+            // capture the post-image now, oplog style, so transferMods can ship the
+            // queued entries as-is instead of re-querying each document by _id
+            BSONObj entry = BSON( "op" << ( opstr[0] == 'i' ? "i" : "u" ) << "o" << it );
+            _mods.push_back( entry );
+            _memoryUsed += entry.objsize() + 5;
         }
 
-        void xfer( OperationContext* txn, Database* db, list<BSONObj> * l , BSONObjBuilder& b , const char * name , long long& size , bool explode ) {
+        /**
+         * Drains queued entries into 'b' as the "mods" array, in the order the
+         * operations happened, until the transfer reaches ~1MB.  Caller must hold
+         * the collection lock (see transferMods).
+         */
+        void xfer( BSONObjBuilder& b , long long& size ) {
             const long long maxSize = 1024 * 1024;
 
-            if ( l->size() == 0 || size > maxSize )
+            if ( _mods.size() == 0 )
                 return;
 
-            BSONArrayBuilder arr(b.subarrayStart(name));
+            BSONArrayBuilder arr(b.subarrayStart("mods"));
 
-            list<BSONObj>::iterator i = l->begin();
+            list<BSONObj>::iterator i = _mods.begin();
 
-            while ( i != l->end() && size < maxSize ) {
+            while ( i != _mods.end() && size < maxSize ) {
                 BSONObj t = *i;
-                if ( explode ) {
-                    BSONObj it;
-                    if ( Helpers::findById( txn, db , _ns.c_str() , t, it ) ) {
-                        arr.append( it );
-                        size += it.objsize();
-                    }
-                }
-                else {
-                    arr.append( t );
-                }
-                i = l->erase( i );
+                arr.append( t );
+                i = _mods.erase( i );
                 size += t.objsize();
+                _memoryUsed -= t.objsize() + 5;
             }
 
             arr.done();
@@ -366,13 +381,16 @@ namespace mongo {
             long long size = 0;
 
             {
+                // the entries carry their documents already; the lock is only taken
+                // to serialize queue access against logOp()
                 Client::ReadContext cx(txn, _ns);
 
-                xfer( txn, cx.ctx().db(), &_deleted, b, "deleted", size, false );
-                xfer( txn, cx.ctx().db(), &_reload, b, "reload", size, true );
-            }
+                xfer( b, size );
 
-            b.append( "size" , size );
+                b.append( "size" , size );
+                // how much is still queued, so the dest can judge convergence
+                b.append( "remaining" , _memoryUsed > 0 ? _memoryUsed : 0 );
+            }
 
             return true;
         }
@@ -476,6 +494,29 @@ namespace mongo {
 
             ElapsedTracker tracker (128, 10); // same as ClientCursor::_yieldSometimesTracker
 
+            // Latency feedback: when the shard's recent CRUD latency is above the
+            // target, shrink this batch and have the destination sleep before it
+            // asks for the next one, so the migration runs at the fastest rate the
+            // p99 can absorb.
+            int maxBatchBytes = BSONObjMaxUserSize;
+            int throttleMillis = 0;
+            if ( migrationThrottleTargetLatencyMicros > 0 ) {
+                const long long avgMicros = _recentCrudLatencyMicros();
+                if ( avgMicros > migrationThrottleTargetLatencyMicros ) {
+                    const double over =
+                        static_cast<double>( avgMicros ) / migrationThrottleTargetLatencyMicros;
+                    maxBatchBytes = std::max( 256 * 1024,
+                                              static_cast<int>( BSONObjMaxUserSize / over ) );
+                    throttleMillis = std::min( migrationThrottleMaxSleepMillis,
+                                               static_cast<int>( ( over - 1 ) * 10 ) );
+                    LOG(1) << "moveChunk throttling clone batch, avg op latency "
+                           << avgMicros << "us over target "
+                           << migrationThrottleTargetLatencyMicros << "us,"
+                           << " batch " << maxBatchBytes << " bytes,"
+                           << " sleep " << throttleMillis << "ms" << migrateLog;
+                }
+            }
+
             int allocSize;
             {
                 Client::ReadContext ctx(txn, _ns);
@@ -497,7 +538,11 @@ namespace mongo {
                 scoped_spinlock lk( _trackerLocks );
                 set<DiskLoc>::iterator i = _cloneLocs.begin();
                 for ( ; i!=_cloneLocs.end(); ++i ) {
-                    if (tracker.intervalHasElapsed()) // should I yield?
+                    // should I yield?  only end the batch early when another thread is
+                    // actually blocked behind our lock; otherwise keep filling until
+                    // maxBatchBytes bounds us.
+                    if (tracker.intervalHasElapsed() &&
+                        Lock::othersWaitingForLocksHeld(txn->lockState()) > 0)
                         break;
                     
                     invariant( collection );
@@ -508,7 +553,7 @@ namespace mongo {
                     // use the builder size instead of accumulating 'o's size so that we take into consideration
                     // the overhead of BSONArray indices, and *always* append one doc
                     if ( a.arrSize() != 0 &&
-                         a.len() + o.objsize() + 1024 > BSONObjMaxUserSize ) {
+                         a.len() + o.objsize() + 1024 > maxBatchBytes ) {
                         filledBuffer = true; // break out of outer while loop
                         break;
                     }
@@ -523,6 +568,9 @@ namespace mongo {
             }
 
             result.appendArray( "objects" , a.arr() );
+            if ( throttleMillis > 0 ) {
+                result.append( "throttleMillis", throttleMillis );
+            }
             return true;
         }
 
@@ -593,9 +641,35 @@ namespace mongo {
         // updates applied by 1 thread in a write lock
         set<DiskLoc> _cloneLocs;
 
-        list<BSONObj> _reload; // objects that were modified that must be recloned
-        list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
-        long long _memoryUsed; // bytes in _reload + _deleted
+        // ordered oplog-style entries { op: "i"|"u"|"d", o: <doc or _id> } captured
+        // while the migration is active; drained to the TO shard by transferMods
+        list<BSONObj> _mods;
+        long long _memoryUsed; // bytes queued in _mods (small per-entry overhead)
+
+        // cumulative CRUD totals at the previous clone() call (or start()), for
+        // the latency feedback window.  Only touched by the thread serving clone
+        // batches, which the destination drives serially.
+        long long _lastCrudOps;
+        long long _lastCrudMicros;
+
+        /**
+         * Average CRUD op latency on this shard since the previous call, in
+         * microseconds; 0 when no ops ran in the window.
+         */
+        long long _recentCrudLatencyMicros() {
+            long long ops;
+            long long micros;
+            globalOpLatencyHistograms.getCrudTotals( &ops, &micros );
+
+            const long long dOps = ops - _lastCrudOps;
+            const long long dMicros = micros - _lastCrudMicros;
+            _lastCrudOps = ops;
+            _lastCrudMicros = micros;
+
+            if ( dOps <= 0 )
+                return 0;
+            return dMicros / dOps;
+        }
 
         bool _getActive() const { scoped_lock l(_mutex); return _active; }
         void _setActive( bool b ) { scoped_lock l(_mutex); _active = b; }
@@ -1779,6 +1853,14 @@ namespace mongo {
                     BSONObj arr = res["objects"].Obj();
                     int thisTime = 0;
 
+                    // Apply the documents in groups, each under a single write lock,
+                    // and insert them directly rather than through the upsert
+                    // machinery: step 2 emptied the range, and the _id conflict
+                    // check below rejects any document that would collide with one
+                    // outside it.  Group size is bounded so we don't hold the write
+                    // lock (or delay the secondary throttle wait) for too long.
+                    const int maxGroupBytes = 256 * 1024;
+
                     BSONObjIterator i( arr );
                     while( i.more() ) {
                         txn->checkForInterrupt();
@@ -1790,29 +1872,46 @@ namespace mongo {
                             return;
                         }
 
-                        BSONObj o = i.next().Obj();
+                        int groupBytes = 0;
                         {
                             Client::WriteContext cx(txn, ns );
 
-                            BSONObj localDoc;
-                            if ( willOverrideLocalId( txn, cx.ctx().db(), o, &localDoc ) ) {
-                                string errMsg =
-                                    str::stream() << "cannot migrate chunk, local document "
-                                    << localDoc
-                                    << " has same _id as cloned "
-                                    << "remote document " << o;
-
-                                warning() << errMsg << endl;
-
-                                // Exception will abort migration cleanly
-                                uasserted( 16976, errMsg );
+                            Collection* collection = cx.ctx().db()->getCollection( txn, ns );
+                            uassert( 18556,
+                                     str::stream() << "collection " << ns
+                                                   << " dropped during migration",
+                                     collection );
+
+                            while ( i.more() && groupBytes < maxGroupBytes ) {
+                                BSONObj o = i.next().Obj();
+
+                                BSONObj localDoc;
+                                if ( willOverrideLocalId( txn, cx.ctx().db(), o, &localDoc ) ) {
+                                    string errMsg =
+                                        str::stream() << "cannot migrate chunk, local document "
+                                        << localDoc
+                                        << " has same _id as cloned "
+                                        << "remote document " << o;
+
+                                    warning() << errMsg << endl;
+
+                                    // Exception will abort migration cleanly
+                                    uasserted( 16976, errMsg );
+                                }
+
+                                StatusWith<DiskLoc> loc =
+                                    collection->insertDocument( txn, o, true );
+                                uassertStatusOK( loc.getStatus() );
+                                repl::logOp( txn, "i", ns.c_str(), o,
+                                             NULL, NULL, true /* fromMigrate */ );
+                                txn->recoveryUnit()->commitIfNeeded();
+
+                                thisTime++;
+                                numCloned++;
+                                clonedBytes += o.objsize();
+                                groupBytes += o.objsize();
                             }
-
-                            Helpers::upsert( txn, ns, o, true );
                         }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
 
                         if ( secondaryThrottle && thisTime > 0 ) {
                             WriteConcernOptions writeConcern;
@@ -1835,6 +1934,11 @@ namespace mongo {
 
                     if ( thisTime == 0 )
                         break;
+
+                    // source-side latency feedback; see MigrateFromStatus::clone
+                    if ( res["throttleMillis"].isNumber() ) {
+                        sleepmillis( res["throttleMillis"].numberInt() );
+                    }
                 }
 
                 timing.done(3);
@@ -1847,6 +1951,16 @@ namespace mongo {
             {
                 // 4. do bulk of mods
                 setState(CATCHUP);
+
+                // Convergence controller: under sustained writes the donor's mod
+                // queue may never drain to zero, so requiring strict quiescence can
+                // spin here until the migration aborts.  Start out strict, and ramp
+                // up the backlog we are willing to carry into the steady state the
+                // longer catch-up runs; the steady/commit phases keep transferring,
+                // and the final drain happens with donor writes blocked.
+                const long long maxInitialBacklogBytes = 256 * 1024;
+                Timer catchupTimer;
+
                 while ( true ) {
                     BSONObj res;
                     if ( ! conn->runCommand( "admin" , BSON( "_transferMods" << 1 ) , res ) ) {
@@ -1861,7 +1975,7 @@ namespace mongo {
                         break;
 
                     apply( txn, res , &lastOpApplied );
-                    
+
                     const int maxIterations = 3600*50;
                     int i;
                     for ( i=0;i<maxIterations; i++) {
@@ -1891,7 +2005,21 @@ namespace mongo {
                         conn.done();
                         setState(FAIL);
                         return;
-                    } 
+                    }
+
+                    // older donors don't report their backlog; stay strict for them
+                    const long long remaining = res["remaining"].isNumber()
+                        ? res["remaining"].numberLong()
+                        : std::numeric_limits<long long>::max();
+                    const long long acceptableBacklogBytes =
+                        maxInitialBacklogBytes * ( 1 + catchupTimer.seconds() / 15 );
+                    if ( remaining <= acceptableBacklogBytes ) {
+                        if ( remaining > 0 ) {
+                            log() << "migrate catch-up proceeding with " << remaining
+                                  << " bytes of mods still queued on the donor" << migrateLog;
+                        }
+                        break;
+                    }
                 }
 
                 timing.done(4);
@@ -2013,6 +2141,75 @@ namespace mongo {
 
             bool didAnything = false;
 
+            if ( xfer["mods"].isABSONObj() ) {
+                Helpers::RemoveSaver rs( "moveChunk" , ns , "removedDuring" );
+
+                // Apply the ordered delta stream in groups, each under a single
+                // write lock, like the initial clone does; bounded group size keeps
+                // the lock hold time reasonable.
+                const int maxGroupBytes = 256 * 1024;
+
+                BSONObjIterator i( xfer["mods"].Obj() );
+                while ( i.more() ) {
+                    int groupBytes = 0;
+                    Client::WriteContext cx(txn, ns);
+
+                    while ( i.more() && groupBytes < maxGroupBytes ) {
+                        BSONObj entry = i.next().Obj();
+                        BSONObj o = entry["o"].Obj();
+                        groupBytes += o.objsize();
+
+                        if ( entry["op"].valuestrsafe()[0] == 'd' ) {
+                            // do not apply deletes if they do not belong to the chunk being migrated
+                            BSONObj fullObj;
+                            if ( Helpers::findById( txn, cx.ctx().db(), ns.c_str(), o, fullObj ) ) {
+                                if ( ! isInRange( fullObj , min , max , shardKeyPattern ) ) {
+                                    log() << "not applying out of range deletion: " << fullObj << migrateLog;
+
+                                    continue;
+                                }
+                            }
+
+                            // id object most likely has form { _id : ObjectId(...) }
+                            // infer from that correct index to use, e.g. { _id : 1 }
+                            BSONObj idIndexPattern = Helpers::inferKeyPattern( o );
+
+                            // TODO: create a better interface to remove objects directly
+                            KeyRange range( ns, o, o, idIndexPattern );
+                            Helpers::removeRange( txn,
+                                                  range ,
+                                                  true , /*maxInclusive*/
+                                                  false , /* secondaryThrottle */
+                                                  serverGlobalParams.moveParanoia ? &rs : 0 , /*callback*/
+                                                  true ); /*fromMigrate*/
+                        }
+                        else {
+                            // 'i' and 'u' both carry the post-image; apply as upsert
+                            BSONObj localDoc;
+                            if ( willOverrideLocalId( txn, cx.ctx().db(), o, &localDoc ) ) {
+                                string errMsg =
+                                    str::stream() << "cannot migrate chunk, local document "
+                                                  << localDoc
+                                                  << " has same _id as reloaded remote document "
+                                                  << o;
+
+                                warning() << errMsg << endl;
+
+                                // Exception will abort migration cleanly
+                                uasserted( 18573, errMsg );
+                            }
+
+                            // We are in write lock here, so sure we aren't killing
+                            Helpers::upsert( txn, ns , o , true );
+                        }
+
+                        *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                        didAnything = true;
+                    }
+                }
+            }
+
+            // formats sent by older donors
             if ( xfer["deleted"].isABSONObj() ) {
                 Helpers::RemoveSaver rs( "moveChunk" , ns , "removedDuring" );
 
@@ -153,6 +153,7 @@ namespace mongo {
         _configServer.clear();
         _shardName.clear();
         _collMetadata.clear();
+        _signalMetadataChanged();
     }
 
     // TODO we shouldn't need three ways for checking the version. Fix this.
@@ -218,6 +219,7 @@ namespace mongo {
         // TODO: a bit dangerous to have two different zero-version states - no-metadata and
         // no-version
         _collMetadata[ns] = cloned;
+        _signalMetadataChanged();
     }
 
     void ShardingState::undoDonateChunk(OperationContext* txn,
@@ -232,6 +234,7 @@ namespace mongo {
         CollectionMetadataMap::iterator it = _collMetadata.find( ns );
         verify( it != _collMetadata.end() );
         it->second = prevMetadata;
+        _signalMetadataChanged();
     }
 
     bool ShardingState::notePending(OperationContext* txn,
@@ -276,6 +279,7 @@ namespace mongo {
         if ( !cloned ) return false;
 
         _collMetadata[ns] = cloned;
+        _signalMetadataChanged();
         return true;
     }
 
@@ -321,6 +325,7 @@ namespace mongo {
         if ( !cloned ) return false;
 
         _collMetadata[ns] = cloned;
+        _signalMetadataChanged();
         return true;
     }
 
@@ -347,6 +352,7 @@ namespace mongo {
         uassert( 16857, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        _signalMetadataChanged();
     }
 
     void ShardingState::mergeChunks(OperationContext* txn,
@@ -371,6 +377,7 @@ namespace mongo {
         uassert( 17004, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        _signalMetadataChanged();
     }
 
     void ShardingState::resetMetadata( const string& ns ) {
@@ -380,6 +387,7 @@ namespace mongo {
                   << endl;
 
         _collMetadata.erase( ns );
+        _signalMetadataChanged();
     }
 
     Status ShardingState::refreshMetadataIfNeeded( const string& ns,
@@ -652,6 +660,8 @@ namespace mongo {
                     _collMetadata.erase( it );
                 }
 
+                _signalMetadataChanged();
+
                 *latestShardVersion = remoteShardVersion;
             }
         }
@@ -807,6 +817,24 @@ namespace mongo {
         _versions[ns] = version;
     }
 
+    bool ShardedConnectionInfo::getCachedShardVersion( const string& ns,
+                                                       long long generation,
+                                                       ChunkVersion* version ) const {
+        ShardVersionCache::const_iterator it = _shardVersionCache.find( ns );
+        if ( it == _shardVersionCache.end() || it->second.generation != generation )
+            return false;
+        *version = it->second.version;
+        return true;
+    }
+
+    void ShardedConnectionInfo::cacheShardVersion( const string& ns,
+                                                   long long generation,
+                                                   const ChunkVersion& version ) {
+        CachedShardVersion& cached = _shardVersionCache[ns];
+        cached.generation = generation;
+        cached.version = version;
+    }
+
     void ShardedConnectionInfo::addHook() {
         static mongo::mutex lock("ShardedConnectionInfo::addHook mutex");
         static bool done = false;
@@ -1286,7 +1314,17 @@ namespace mongo {
         // TODO : all collections at some point, be sharded or not, will have a version
         //  (and a CollectionMetadata)
         received = info->getVersion( ns );
-        wanted = shardingState.getVersion( ns );
+
+        // Fast path: reuse the shard version this connection last read, as long as the
+        // metadata generation hasn't moved since - skips the sharding state mutex.  The
+        // generation is read before the (possible) locked lookup so a concurrent metadata
+        // change at worst stamps the cache with an already stale generation, forcing a
+        // re-read on the next op rather than ever serving a stale version.
+        const long long generation = shardingState.getMetadataGeneration();
+        if ( !info->getCachedShardVersion( ns, generation, &wanted ) ) {
+            wanted = shardingState.getVersion( ns );
+            info->cacheShardVersion( ns, generation, wanted );
+        }
 
         if( received.isWriteCompatibleWith( wanted ) ) return true;
 
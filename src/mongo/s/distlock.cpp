@@ -37,6 +37,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/s/type_locks.h"
 #include "mongo/s/type_lockpings.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/timer.h"
 
@@ -201,7 +202,7 @@ namespace mongo {
 
                     // Remove old locks, if possible
                     // Make sure no one else is adding to this list at the same time
-                    scoped_lock lk( _mutex );
+                    AdaptiveMutex::scoped_lock lk( _mutex );
 
                     int numOldLocks = _oldLockOIDs.size();
                     if( numOldLocks > 0 ) {
@@ -282,7 +283,7 @@ namespace mongo {
             if (!lockPingerEnabled) return "";
 
             // Make sure we don't start multiple threads for a process id
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
 
             const ConnectionString& conn = lock.getRemoteConnection();
             const string& processId = lock.getProcessId();
@@ -310,18 +311,18 @@ namespace mongo {
 
         void addUnlockOID( const OID& oid ) {
             // Modifying the lock from some other thread
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
             _oldLockOIDs.push_back( oid );
         }
 
         bool willUnlockOID( const OID& oid ) {
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
             return find( _oldLockOIDs.begin(), _oldLockOIDs.end(), oid ) != _oldLockOIDs.end();
         }
 
         void kill( const ConnectionString& conn, const string& processId ) {
             // Make sure we're in a consistent state before other threads can see us
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
 
             string pingId = pingThreadId( conn, processId );
 
@@ -331,13 +332,13 @@ namespace mongo {
         }
 
         bool shouldKill( const ConnectionString& conn, const string& processId ) {
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
             return _kill.count( pingThreadId( conn, processId ) ) > 0;
         }
 
         void finishKill( const ConnectionString& conn, const string& processId ) {
             // Make sure we're in a consistent state before other threads can see us
-            scoped_lock lk( _mutex );
+            AdaptiveMutex::scoped_lock lk( _mutex );
 
             string pingId = pingThreadId( conn, processId );
 
@@ -348,7 +349,7 @@ namespace mongo {
 
     private:
         // Protects all of the members below.
-        mongo::mutex _mutex;
+        AdaptiveMutex _mutex;
         set<string> _kill;
         set<string> _seen;
         list<OID> _oldLockOIDs;
@@ -883,15 +884,21 @@ namespace mongo {
             BSONObj err = conn->getLastErrorDetailed();
             string errMsg = DBClientWithCommands::getLastErrorString(err);
 
-            currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
-
             if ( !errMsg.empty() || !err["n"].type() || err["n"].numberInt() < 1 ) {
+                // fetch the current lock doc only when we lost, to report who won
+                currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
                 logErrMsgOrWarn("could not acquire lock", lockName, errMsg, "(another update won)");
                 *other = currLock;
                 other->getOwned();
                 gotLock = false;
             }
             else {
+                // our update matched, so the lock doc now holds exactly what we
+                // wrote; no need to read it back
+                BSONObjBuilder lb;
+                lb.append( LocksType::name(), _name );
+                lb.appendElements( lockDetails );
+                currLock = lb.obj();
                 gotLock = true;
             }
 
@@ -1000,29 +1007,33 @@ namespace mongo {
             // when something goes wrong.
             try {
 
-                BSONObjBuilder finalLockDetails;
+                BSONObjBuilder finalLockDetailsBuilder;
                 BSONObjIterator bi( lockDetails );
                 while( bi.more() ) {
                     BSONElement el = bi.next();
                     if( (string) ( el.fieldName() ) == LocksType::state() )
-                        finalLockDetails.append( LocksType::state(), 2 );
-                    else finalLockDetails.append( el );
+                        finalLockDetailsBuilder.append( LocksType::state(), 2 );
+                    else finalLockDetailsBuilder.append( el );
                 }
+                BSONObj finalLockDetails = finalLockDetailsBuilder.obj();
 
-                conn->update( LocksType::ConfigNS , BSON( LocksType::name(_name) ) , BSON( "$set" << finalLockDetails.obj() ) );
+                conn->update( LocksType::ConfigNS , BSON( LocksType::name(_name) ) , BSON( "$set" << finalLockDetails ) );
 
                 BSONObj err = conn->getLastErrorDetailed();
                 string errMsg = DBClientWithCommands::getLastErrorString(err);
 
-                currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
-
                 if ( !errMsg.empty() || !err["n"].type() || err["n"].numberInt() < 1 ) {
+                    currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
                     warning() << "could not finalize winning lock " << lockName
                               << ( !errMsg.empty() ? causedBy( errMsg ) : " (did not update lock) " ) << endl;
                     gotLock = false;
                 }
                 else {
-                    // SUCCESS!
+                    // SUCCESS!  As above, the doc now holds what we just wrote.
+                    BSONObjBuilder lb;
+                    lb.append( LocksType::name(), _name );
+                    lb.appendElements( finalLockDetails );
+                    currLock = lb.obj();
                     gotLock = true;
                 }
 
@@ -190,6 +190,7 @@ namespace mongo {
         cacheInvalidatorThread.go();
 
         PeriodicTask::startRunningPeriodicTasks();
+        startFastClockThread();
 
         ShardedMessageHandler handler;
         MessageServer * server = createServer( opts , &handler );
@@ -46,6 +46,7 @@
 #include "mongo/db/auth/security_key.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
 #include "mongo/s/request.h"
@@ -451,8 +452,14 @@ namespace mongo {
         _hasOpsQueued = obj["writeBacksQueued"].Bool();
         _writeLock = 0; // TODO
         _mongoVersion = obj["version"].String();
+        _crudOps = obj.getFieldDotted( "opLatencies.crudOps" ).numberLong();
+        _crudMicros = obj.getFieldDotted( "opLatencies.crudMicros" ).numberLong();
     }
 
+    // compress traffic on connections to shards (snappy, negotiated per connection);
+    // connections to peers that don't support it silently stay uncompressed
+    MONGO_EXPORT_SERVER_PARAMETER( shardConnectionCompression, bool, false );
+
     void ShardingConnectionHook::onCreate( DBClientBase * conn ) {
         if(getGlobalAuthorizationManager()->isAuthEnabled()) {
             LOG(2) << "calling onCreate auth for " << conn->toString() << endl;
@@ -460,10 +467,14 @@ namespace mongo {
             bool result = authenticateInternalUser(conn);
 
             uassert( 15847, str::stream() << "can't authenticate to server "
-                                          << conn->getServerAddress(), 
+                                          << conn->getServerAddress(),
                      result );
         }
 
+        if ( shardConnectionCompression ) {
+            conn->negotiateNetworkCompression();
+        }
+
         if ( _shardedConnections ) {
             if ( versionManager.isVersionableCB( conn )) {
                 // We must initialize sharding on all connections, so that we get exceptions
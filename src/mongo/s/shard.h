@@ -220,6 +220,19 @@ namespace mongo {
             return _hasOpsQueued;
         }
 
+        /**
+         * Cumulative CRUD op count and latency from the shard's opLatencies
+         * serverStatus section; 0 on shards that don't report them.  Sampled
+         * across balancing rounds to estimate shard load.
+         */
+        long long crudOps() const {
+            return _crudOps;
+        }
+
+        long long crudMicros() const {
+            return _crudMicros;
+        }
+
         std::string mongoVersion() const {
             return _mongoVersion;
         }
@@ -228,6 +241,8 @@ namespace mongo {
         Shard _shard;
         long long _mapped;
         bool _hasOpsQueued;  // true if 'writebacks' are pending
+        long long _crudOps;
+        long long _crudMicros;
         double _writeLock;
         std::string _mongoVersion;
     };
@@ -40,8 +40,6 @@
 namespace mongo {
 
     ShardKeyPattern::ShardKeyPattern( BSONObj p ) : pattern( p.getOwned() ) {
-        pattern.toBSON().getFieldNames( patternfields );
-
         BSONObjBuilder min;
         BSONObjBuilder max;
 
@@ -57,15 +55,16 @@ namespace mongo {
     }
 
     static bool _hasShardKey(const BSONObj& doc,
-                             const set<string>& patternFields,
+                             const MultiPathExtractor& extractor,
                              bool allowRegex) {
 
-        // this is written s.t. if doc has lots of fields, if the shard key fields are early,
-        // it is fast.  so a bit more work to try to be semi-fast.
+        // one walk of doc resolves every shard key field, however many there are
+        vector<BSONElement> shardKeyFields;
+        extractor.extract(doc, &shardKeyFields);
 
-        for (set<string>::const_iterator it = patternFields.begin(); it != patternFields.end();
-            ++it) {
-            BSONElement shardKeyField = doc.getFieldDotted(it->c_str());
+        for (vector<BSONElement>::const_iterator it = shardKeyFields.begin();
+            it != shardKeyFields.end(); ++it) {
+            const BSONElement& shardKeyField = *it;
             if (shardKeyField.eoo()
                 || shardKeyField.type() == Array
                 || (!allowRegex && shardKeyField.type() == RegEx)
@@ -79,11 +78,11 @@ namespace mongo {
     }
 
     bool ShardKeyPattern::hasShardKey(const BSONObj& doc) const {
-        return _hasShardKey(doc, patternfields, true);
+        return _hasShardKey(doc, pattern.fieldExtractor(), true);
     }
 
     bool ShardKeyPattern::hasTargetableShardKey(const BSONObj& doc) const {
-        return _hasShardKey(doc, patternfields, false);
+        return _hasShardKey(doc, pattern.fieldExtractor(), false);
     }
 
     bool ShardKeyPattern::isUniqueIndexCompatible( const KeyPattern& uniqueIndexPattern ) const {
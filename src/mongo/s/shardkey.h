@@ -150,8 +150,6 @@ namespace mongo {
         BSONObj gMin;
         BSONObj gMax;
 
-        /* question: better to have patternfields precomputed or not?  depends on if we use copy constructor often. */
-        std::set<std::string> patternfields;
     };
 
     inline BSONObj ShardKeyPattern::extractKey(const BSONObj& from) const {
@@ -238,6 +238,11 @@ namespace mongo {
         if ( handleSpecialNamespaces( r , q ) )
             return;
 
+        // Tracks the whole life of the command, including stale config retries below, so
+        // that each attempt is forwarded with the remaining time budget rather than being
+        // granted the client's full maxTimeMS anew.
+        Timer commandTimer;
+
         int loops = 5;
         while ( true ) {
             BSONObjBuilder builder;
@@ -270,6 +275,33 @@ namespace mongo {
                     }
                 }
 
+                // Handle command option maxTimeMS: deduct the time already burned (mostly
+                // earlier stale config attempts) and rewrite the forwarded command with the
+                // remainder, so the shards enforce the overall budget.  Once nothing is
+                // left, fail here instead of making another round trip.
+                StatusWith<int> maxTimeMS = LiteParsedQuery::parseMaxTimeMSCommand( cmdObj );
+                uassert( 18579, maxTimeMS.getStatus().reason(), maxTimeMS.isOK() );
+                if ( maxTimeMS.getValue() > 0 ) {
+                    int leftMillis = maxTimeMS.getValue() - commandTimer.millis();
+                    uassert( ErrorCodes::ExceededTimeLimit,
+                             str::stream() << "operation exceeded time limit of "
+                                           << maxTimeMS.getValue() << "ms",
+                             leftMillis > 0 );
+                    if ( leftMillis != maxTimeMS.getValue() ) {
+                        BSONObjBuilder timeLeft;
+                        BSONObjIterator cmdIt( cmdObj );
+                        while ( cmdIt.more() ) {
+                            BSONElement el = cmdIt.next();
+                            if ( LiteParsedQuery::cmdOptionMaxTimeMS
+                                     != el.fieldNameStringData() ) {
+                                timeLeft.append( el );
+                            }
+                        }
+                        timeLeft.append( LiteParsedQuery::cmdOptionMaxTimeMS, leftMillis );
+                        cmdObj = timeLeft.obj();
+                    }
+                }
+
                 Command::runAgainstRegistered(q.ns, cmdObj, builder, q.queryOptions);
                 BSONObj x = builder.done();
                 replyToQuery(0, r.p(), r.m(), x);
@@ -60,6 +60,10 @@ namespace mongo {
          * Executes a command against a particular database, and targets the command based on a
          * collection in that database.
          *
+         * Any maxTimeMS option on 'command' is forwarded as-is and enforced by each targeted
+         * shard; callers re-issuing a command should deduct elapsed time from the option first
+         * (client commands get this from the retry loop in clientCommandOp).
+         *
          * This version should be used by internal commands when possible.
          */
         void commandOp( const std::string& db,
@@ -33,11 +33,20 @@
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h" // ConnectionString (header-only)
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/write_error_detail.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // When enabled, ordered batches dispatch child batches for distinct shards
+    // concurrently instead of round-tripping them one at a time, turning cross-shard
+    // ordered bulk latency from sum-of-shards into max-of-shards.  Each shard still
+    // applies its writes in client order, but a write after a failed one may already
+    // have executed on another shard, so this is opt-in.
+    MONGO_EXPORT_SERVER_PARAMETER( batchWriteOrderedPipelining, bool, false );
+
     BatchWriteExec::BatchWriteExec( NSTargeter* targeter,
                                     ShardResolver* resolver,
                                     MultiCommandDispatch* dispatcher ) :
@@ -93,6 +102,7 @@ namespace mongo {
 
         BatchWriteOp batchOp;
         batchOp.initClientRequest( &clientRequest );
+        batchOp.setOrderedPipelining( batchWriteOrderedPipelining );
 
         // Current batch status
         bool refreshedTargeter = false;
@@ -100,8 +110,30 @@ namespace mongo {
         int numCompletedOps = 0;
         int numRoundsWithoutProgress = 0;
 
+        // If the client gave the operation a time budget, propagate what remains of it to
+        // the shards.  Each dispatched child batch is stamped with the leftover maxTimeMS
+        // (enforced server-side by the generic command processing, which kills overrunning
+        // shard work), and once the budget is exhausted we stop retargeting/retrying and
+        // report what completed alongside an ExceededTimeLimit write error.
+        Timer deadlineTimer;
+        const int maxTimeMS = clientRequest.isMaxTimeMSSet() ? clientRequest.getMaxTimeMS() : 0;
+
         while ( !batchOp.isFinished() ) {
 
+            if ( maxTimeMS > 0 && deadlineTimer.millis() >= maxTimeMS ) {
+
+                stringstream msg;
+                msg << "batch write op in " << clientRequest.getNS()
+                    << " exceeded the operation time limit of " << maxTimeMS << "ms ("
+                    << batchOp.numWriteOpsIn( WriteOpState_Completed ) << " ops completed in "
+                    << rounds << " rounds)";
+
+                WriteErrorDetail error;
+                buildErrorFrom( Status( ErrorCodes::ExceededTimeLimit, msg.str() ), &error );
+                batchOp.abortBatch( error );
+                break;
+            }
+
             //
             // Get child batches to send using the targeter
             //
@@ -211,6 +243,17 @@ namespace mongo {
                     BatchedCommandRequest request( clientRequest.getBatchType() );
                     batchOp.buildBatchRequest( *nextBatch, &request );
 
+                    // Stamp the child batch with whatever is left of the operation's time
+                    // budget, so the shard gives up on its own rather than burning the full
+                    // client limit on every dispatch.  A floor of 1ms keeps the stamp valid
+                    // if the deadline passed since the round started; the check at the top
+                    // of the round loop aborts before we would dispatch again.
+                    if ( maxTimeMS > 0 ) {
+                        int leftMillis = maxTimeMS - deadlineTimer.millis();
+                        if ( leftMillis < 1 ) leftMillis = 1;
+                        request.setMaxTimeMS( leftMillis );
+                    }
+
                     // Internally we use full namespaces for request/response, but we send the
                     // command to a database with the collection name in the request.
                     NamespaceString nss( request.getNS() );
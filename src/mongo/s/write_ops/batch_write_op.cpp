@@ -60,7 +60,8 @@ namespace mongo {
     }
 
     BatchWriteOp::BatchWriteOp() :
-        _clientRequest( NULL ), _writeOps( NULL ), _stats( new BatchWriteStats ) {
+        _clientRequest( NULL ), _pipelineOrdered( false ), _writeOps( NULL ),
+        _stats( new BatchWriteStats ) {
     }
 
     void BatchWriteOp::initClientRequest( const BatchedCommandRequest* clientRequest ) {
@@ -264,16 +265,21 @@ namespace mongo {
         //  [{ skey : x }]
         //
         // Ordered update Batch of :
-        //  [{ skey : a }{ $push }, 
-        //   { skey : b }{ $push }, 
+        //  [{ skey : a }{ $push },
+        //   { skey : b }{ $push },
         //   { skey : [c, x] }{ $push },
         //   { skey : y }{ $push },
         //   { skey : z }{ $push }]
-        // broken into: 
+        // broken into:
         //  [{ skey : a }, { skey : b }],
-        //  [{ skey : [c,x] }], 
+        //  [{ skey : [c,x] }],
         //  [{ skey : y }, { skey : z }]
         //
+        // With ordered pipelining (see setOrderedPipelining()), single-shard write ops may
+        // open batches for several shards in one round - each shard still sees its writes in
+        // client order - so the insert example above targets both shards at once.  Only
+        // multi-shard write ops are still sent one-by-one.
+        //
 
         const bool ordered = _clientRequest->getOrdered();
 
@@ -340,11 +346,17 @@ namespace mongo {
             // If ordered and we have a previous endpoint, make sure we don't need to send these
             // targeted writes to any other endpoints.
             //
+            // With ordered pipelining we relax this: single-endpoint writes may open batches
+            // for new shards, since walking the ops in client order means each shard's batch
+            // still receives its writes in client order.  Multi-endpoint writes must still be
+            // sent alone, so they can't be appended behind pending ops.
+            //
 
             if ( ordered && !batchMap.empty() ) {
 
-                dassert( batchMap.size() == 1u );
-                if ( isNewBatchRequired( writes, batchMap ) ) {
+                dassert( _pipelineOrdered || batchMap.size() == 1u );
+                if ( _pipelineOrdered ? writes.size() > 1u
+                                      : isNewBatchRequired( writes, batchMap ) ) {
 
                     writeOp.cancelWrites( NULL );
                     break;
@@ -389,15 +401,19 @@ namespace mongo {
                 batch->addWrite( write );
             }
 
+            const bool multiEndpointWrite = writes.size() > 1u;
+
             // Relinquish ownership of TargetedWrites, now the TargetedBatches own them
             writesOwned.mutableVector().clear();
 
             //
             // Break if we're ordered and we have more than one endpoint - later writes cannot be
-            // enforced as ordered across multiple shard endpoints.
+            // enforced as ordered across multiple shard endpoints.  With ordered pipelining
+            // multiple endpoints are fine, but a multi-endpoint write op still goes out alone.
             //
 
-            if ( ordered && batchMap.size() > 1u )
+            if ( ordered &&
+                 ( _pipelineOrdered ? multiEndpointWrite : batchMap.size() > 1u ) )
                 break;
         }
 
@@ -89,6 +89,14 @@ namespace mongo {
          */
         void initClientRequest( const BatchedCommandRequest* clientRequest );
 
+        /**
+         * When enabled, targetBatch() may return batches for several distinct shard
+         * endpoints at once even for ordered batches.  Each shard still receives its
+         * writes in client order, but writes on different shards may execute
+         * concurrently, so a write after a failed one may already have run elsewhere.
+         */
+        void setOrderedPipelining( bool enabled ) { _pipelineOrdered = enabled; }
+
         /**
          * Targets one or more of the next write ops in this batch op using a NSTargeter.  The
          * resulting TargetedWrites are aggregated together in the returned TargetedWriteBatches.
@@ -165,6 +173,9 @@ namespace mongo {
         // Incoming client request, not owned here
         const BatchedCommandRequest* _clientRequest;
 
+        // See setOrderedPipelining()
+        bool _pipelineOrdered;
+
         // Array of ops being processed from the client request
         WriteOp* _writeOps;
 
@@ -595,6 +595,125 @@ namespace {
         ASSERT_EQUALS( clientResponse.getN(), 2 );
     }
 
+    TEST(WriteOpTests, MultiOpTwoShardsOrderedPipelined) {
+
+        //
+        // Multi-op, multi-endpoint targeting test (ordered, with pipelining enabled)
+        // There should be one set of two batches (one to each shard), as for unordered
+        //
+
+        NamespaceString nss( "foo.bar" );
+        ShardEndpoint endpointA( "shardA", ChunkVersion::IGNORED() );
+        ShardEndpoint endpointB( "shardB", ChunkVersion::IGNORED() );
+        MockNSTargeter targeter;
+        initTargeterSplitRange( nss, endpointA, endpointB, &targeter );
+
+        // Do multi-target, multi-doc batch write op
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( true );
+        request.getInsertRequest()->addToDocuments( BSON( "x" << -1 ) );
+        request.getInsertRequest()->addToDocuments( BSON( "x" << 1 ) );
+
+        BatchWriteOp batchOp;
+        batchOp.initClientRequest( &request );
+        batchOp.setOrderedPipelining( true );
+        ASSERT( !batchOp.isFinished() );
+
+        OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+        vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+        Status status = batchOp.targetBatch( targeter, false, &targeted );
+
+        ASSERT( status.isOK() );
+        ASSERT( !batchOp.isFinished() );
+        ASSERT_EQUALS( targeted.size(), 2u );
+        sortByEndpoint( &targeted );
+        ASSERT_EQUALS( targeted.front()->getWrites().size(), 1u );
+        assertEndpointsEqual( targeted.front()->getEndpoint(), endpointA );
+        ASSERT_EQUALS( targeted.back()->getWrites().size(), 1u );
+        assertEndpointsEqual( targeted.back()->getEndpoint(), endpointB );
+
+        BatchedCommandResponse response;
+        buildResponse( 1, &response );
+
+        // Respond to both targeted batches
+        batchOp.noteBatchResponse( *targeted.front(), response, NULL );
+        ASSERT( !batchOp.isFinished() );
+        batchOp.noteBatchResponse( *targeted.back(), response, NULL );
+        ASSERT( batchOp.isFinished() );
+
+        BatchedCommandResponse clientResponse;
+        batchOp.buildClientResponse( &clientResponse );
+        ASSERT( clientResponse.getOk() );
+        ASSERT_EQUALS( clientResponse.getN(), 2 );
+    }
+
+    TEST(WriteOpTests, MultiOpOneOrTwoShardsOrderedPipelined) {
+
+        //
+        // Multi-op (ordered, pipelined) where the second op targets both shards.
+        // A write op spanning multiple endpoints must still be sent by itself, so the
+        // first round should contain only the single-shard op.
+        //
+
+        NamespaceString nss( "foo.bar" );
+        ShardEndpoint endpointA( "shardA", ChunkVersion::IGNORED() );
+        ShardEndpoint endpointB( "shardB", ChunkVersion::IGNORED() );
+        MockNSTargeter targeter;
+        initTargeterSplitRange( nss, endpointA, endpointB, &targeter );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Delete );
+        request.setNS( nss.ns() );
+        request.setOrdered( true );
+        // Targets shard A only
+        request.getDeleteRequest()->addToDeletes( buildDelete( BSON( "x" << -1 ), 1 ) );
+        // Targets both shards
+        BSONObj queryBoth = BSON( "x" << GTE << -1 << LT << 2 );
+        request.getDeleteRequest()->addToDeletes( buildDelete( queryBoth, 0 ) );
+
+        BatchWriteOp batchOp;
+        batchOp.initClientRequest( &request );
+        batchOp.setOrderedPipelining( true );
+        ASSERT( !batchOp.isFinished() );
+
+        OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+        vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+        Status status = batchOp.targetBatch( targeter, false, &targeted );
+
+        ASSERT( status.isOK() );
+        ASSERT( !batchOp.isFinished() );
+        ASSERT_EQUALS( targeted.size(), 1u );
+        ASSERT_EQUALS( targeted.front()->getWrites().size(), 1u );
+        assertEndpointsEqual( targeted.front()->getEndpoint(), endpointA );
+
+        BatchedCommandResponse response;
+        buildResponse( 1, &response );
+
+        batchOp.noteBatchResponse( *targeted.front(), response, NULL );
+        ASSERT( !batchOp.isFinished() );
+
+        // Second round gets the multi-endpoint op, alone, to both shards
+        targetedOwned.clear();
+        status = batchOp.targetBatch( targeter, false, &targeted );
+
+        ASSERT( status.isOK() );
+        ASSERT( !batchOp.isFinished() );
+        ASSERT_EQUALS( targeted.size(), 2u );
+        sortByEndpoint( &targeted );
+        ASSERT_EQUALS( targeted.front()->getWrites().size(), 1u );
+        ASSERT_EQUALS( targeted.back()->getWrites().size(), 1u );
+
+        batchOp.noteBatchResponse( *targeted.front(), response, NULL );
+        ASSERT( !batchOp.isFinished() );
+        batchOp.noteBatchResponse( *targeted.back(), response, NULL );
+        ASSERT( batchOp.isFinished() );
+
+        BatchedCommandResponse clientResponse;
+        batchOp.buildClientResponse( &clientResponse );
+        ASSERT( clientResponse.getOk() );
+        ASSERT_EQUALS( clientResponse.getN(), 3 );
+    }
+
     TEST(WriteOpTests, MultiOpTwoShardsEachOrdered) {
 
         //
@@ -36,7 +36,7 @@ namespace mongo {
     const size_t BatchedCommandRequest::kMaxWriteBatchSize = 1000;
 
     BatchedCommandRequest::BatchedCommandRequest( BatchType batchType ) :
-            _batchType( batchType ) {
+            _batchType( batchType ), _isMaxTimeMSSet( false ), _maxTimeMS( 0 ) {
         switch ( getBatchType() ) {
         case BatchedCommandRequest::BatchType_Insert:
             _insertReq.reset( new BatchedInsertRequest );
@@ -162,6 +162,8 @@ namespace mongo {
         other->_updateReq.reset();
         other->_deleteReq.reset();
         other->_batchType = _batchType;
+        other->_isMaxTimeMSSet = _isMaxTimeMSSet;
+        other->_maxTimeMS = _maxTimeMS;
 
         switch ( getBatchType() ) {
         case BatchedCommandRequest::BatchType_Insert:
@@ -185,7 +187,29 @@ namespace mongo {
     }
 
     BSONObj BatchedCommandRequest::toBSON() const {
-        INVOKE( toBSON );
+        BSONObj batchObj;
+        switch ( getBatchType() ) {
+        case BatchedCommandRequest::BatchType_Insert:
+            batchObj = _insertReq->toBSON();
+            break;
+        case BatchedCommandRequest::BatchType_Update:
+            batchObj = _updateReq->toBSON();
+            break;
+        default:
+            dassert( getBatchType() == BatchedCommandRequest::BatchType_Delete );
+            batchObj = _deleteReq->toBSON();
+            break;
+        }
+
+        if ( !_isMaxTimeMSSet )
+            return batchObj;
+
+        // maxTimeMS is a generic command option, not a batch field, so it is appended
+        // here rather than serialized by the individual batch types.
+        BSONObjBuilder builder;
+        builder.appendElements( batchObj );
+        builder.append( "maxTimeMS", _maxTimeMS );
+        return builder.obj();
     }
 
     bool BatchedCommandRequest::parseBSON( const BSONObj& source, std::string* errMsg ) {
@@ -193,6 +217,8 @@ namespace mongo {
     }
 
     void BatchedCommandRequest::clear() {
+        _isMaxTimeMSSet = false;
+        _maxTimeMS = 0;
         INVOKE( clear );
     }
 
@@ -259,6 +285,25 @@ namespace mongo {
         INVOKE( getOrdered );
     }
 
+    void BatchedCommandRequest::setMaxTimeMS( int maxTimeMS ) {
+        _maxTimeMS = maxTimeMS;
+        _isMaxTimeMSSet = true;
+    }
+
+    void BatchedCommandRequest::unsetMaxTimeMS() {
+        _isMaxTimeMSSet = false;
+        _maxTimeMS = 0;
+    }
+
+    bool BatchedCommandRequest::isMaxTimeMSSet() const {
+        return _isMaxTimeMSSet;
+    }
+
+    int BatchedCommandRequest::getMaxTimeMS() const {
+        dassert( _isMaxTimeMSSet );
+        return _maxTimeMS;
+    }
+
     void BatchedCommandRequest::setMetadata(BatchedRequestMetadata* metadata) {
         INVOKE( setMetadata, metadata );
     }
@@ -64,21 +64,24 @@ namespace mongo {
          * insertReq ownership is transferred to here.
          */
         BatchedCommandRequest( BatchedInsertRequest* insertReq ) :
-                _batchType( BatchType_Insert ), _insertReq( insertReq ) {
+                _batchType( BatchType_Insert ), _insertReq( insertReq ),
+                _isMaxTimeMSSet( false ), _maxTimeMS( 0 ) {
         }
 
         /**
          * updateReq ownership is transferred to here.
          */
         BatchedCommandRequest( BatchedUpdateRequest* updateReq ) :
-                _batchType( BatchType_Update ), _updateReq( updateReq ) {
+                _batchType( BatchType_Update ), _updateReq( updateReq ),
+                _isMaxTimeMSSet( false ), _maxTimeMS( 0 ) {
         }
 
         /**
          * deleteReq ownership is transferred to here.
          */
         BatchedCommandRequest( BatchedDeleteRequest* deleteReq ) :
-                _batchType( BatchType_Delete ), _deleteReq( deleteReq ) {
+                _batchType( BatchType_Delete ), _deleteReq( deleteReq ),
+                _isMaxTimeMSSet( false ), _maxTimeMS( 0 ) {
         }
 
         virtual ~BatchedCommandRequest() {};
@@ -134,6 +137,17 @@ namespace mongo {
         bool isOrderedSet() const;
         bool getOrdered() const;
 
+        /**
+         * maxTimeMS is a generic command option rather than a field of the individual batch
+         * types, so it lives on this wrapper.  When set it rides along in toBSON() and is
+         * enforced by the generic command processing on the server side; parseBSON() does
+         * not extract it.
+         */
+        void setMaxTimeMS( int maxTimeMS );
+        void unsetMaxTimeMS();
+        bool isMaxTimeMSSet() const;
+        int getMaxTimeMS() const;
+
         void setMetadata(BatchedRequestMetadata* metadata);
         void unsetMetadata();
         bool isMetadataSet() const;
@@ -181,6 +195,9 @@ namespace mongo {
         scoped_ptr<BatchedUpdateRequest> _updateReq;
         scoped_ptr<BatchedDeleteRequest> _deleteReq;
 
+        bool _isMaxTimeMSSet;
+        int _maxTimeMS;
+
     };
 
     /**
@@ -42,10 +42,17 @@
 #include "mongo/s/server.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/version_manager.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // All writes now go through the versioned batched write path, which returns
+    // stale-version errors synchronously, so the writeback channel is only needed
+    // to drain writebacks queued by pre-2.6 shards.  Once every shard is upgraded,
+    // this can be turned off to eliminate the per-shard listener threads.
+    MONGO_EXPORT_SERVER_PARAMETER( enableWriteBackListener, bool, true );
+
     unordered_map<string,WriteBackListener*> WriteBackListener::_cache;
     unordered_set<string> WriteBackListener::_seenSets;
     mongo::mutex WriteBackListener::_cacheLock("WriteBackListener");
@@ -58,6 +65,10 @@ namespace mongo {
     /* static */
     void WriteBackListener::init( DBClientBase& conn ) {
 
+        if ( !enableWriteBackListener ) {
+            return;
+        }
+
         if ( conn.type() == ConnectionString::SYNC ) {
             // don't want write back listeners for config servers
             return;
@@ -93,6 +104,10 @@ namespace mongo {
 
     /* static */
     void WriteBackListener::init( const string& host ) {
+        if ( !enableWriteBackListener ) {
+            return;
+        }
+
         scoped_lock lk( _cacheLock );
         WriteBackListener*& l = _cache[host];
         if ( l )
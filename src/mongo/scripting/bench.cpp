@@ -69,6 +69,75 @@ namespace {
 
 namespace mongo {
 
+    const int BenchRunLatencyHistogram::kSubBucketBits;
+    const int BenchRunLatencyHistogram::kSubBuckets;
+    const int BenchRunLatencyHistogram::kNumSlots;
+
+    BenchRunLatencyHistogram::BenchRunLatencyHistogram() {
+        reset();
+    }
+
+    void BenchRunLatencyHistogram::reset() {
+        memset(_counts, 0, sizeof(_counts));
+        _count = 0;
+        _maxMicros = 0;
+    }
+
+    void BenchRunLatencyHistogram::record(long long micros) {
+        ++_counts[slotFor(micros)];
+        ++_count;
+        if (micros > _maxMicros)
+            _maxMicros = micros;
+    }
+
+    void BenchRunLatencyHistogram::updateFrom(const BenchRunLatencyHistogram &other) {
+        for (int slot = 0; slot < kNumSlots; ++slot)
+            _counts[slot] += other._counts[slot];
+        _count += other._count;
+        if (other._maxMicros > _maxMicros)
+            _maxMicros = other._maxMicros;
+    }
+
+    int BenchRunLatencyHistogram::slotFor(long long micros) {
+        unsigned long long v = micros > 0 ? static_cast<unsigned long long>(micros) : 0;
+        if (v < static_cast<unsigned>(kSubBuckets))
+            return static_cast<int>(v);  // group 0 is exact
+        int shift = 0;
+        while ((v >> shift) >= static_cast<unsigned>(2 * kSubBuckets))
+            ++shift;
+        // kSubBuckets <= (v >> shift) < 2 * kSubBuckets here
+        const int slot = (shift + 1) * kSubBuckets + static_cast<int>((v >> shift) - kSubBuckets);
+        return slot < kNumSlots ? slot : kNumSlots - 1;
+    }
+
+    long long BenchRunLatencyHistogram::slotMidpointMicros(int slot) {
+        const int group = slot >> kSubBucketBits;
+        if (group == 0)
+            return slot;
+        const long long base =
+            static_cast<long long>(kSubBuckets + (slot & (kSubBuckets - 1))) << (group - 1);
+        return base + (1LL << (group - 1)) / 2;
+    }
+
+    long long BenchRunLatencyHistogram::getPercentile(double p) const {
+        if (_count == 0)
+            return 0;
+        unsigned long long target = static_cast<unsigned long long>(p * _count + 0.5);
+        if (target < 1)
+            target = 1;
+        if (target > _count)
+            target = _count;
+        unsigned long long seen = 0;
+        for (int slot = 0; slot < kNumSlots; ++slot) {
+            seen += _counts[slot];
+            if (seen >= target) {
+                const long long v = slotMidpointMicros(slot);
+                return v > _maxMicros ? _maxMicros : v;
+            }
+        }
+        return _maxMicros;
+    }
+
     BenchRunEventCounter::BenchRunEventCounter() {
         reset();
     }
@@ -78,11 +147,13 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        _histogram.reset();
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        _histogram.updateFrom(other._histogram);
     }
 
     BenchRunStats::BenchRunStats() {
@@ -100,6 +171,7 @@ namespace mongo {
         insertCounter.reset();
         deleteCounter.reset();
         queryCounter.reset();
+        schedulingLagCounter.reset();
 
         trappedErrors.clear();
     }
@@ -114,6 +186,7 @@ namespace mongo {
         insertCounter.updateFrom(other.insertCounter);
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
+        schedulingLagCounter.updateFrom(other.schedulingLagCounter);
 
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
@@ -131,6 +204,8 @@ namespace mongo {
 
         parallel = 1;
         seconds = 1;
+        opsPerSecPerWorker = 0; // closed loop
+        warmupSeconds = 0;
         hideResults = true;
         handleErrors = false;
         hideErrors = false;
@@ -168,6 +243,10 @@ namespace mongo {
             this->parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             this->seconds = args["seconds"].number();
+        if ( args["opsPerSecPerWorker"].isNumber() )
+            this->opsPerSecPerWorker = args["opsPerSecPerWorker"].number();
+        if ( args["warmupSeconds"].isNumber() )
+            this->warmupSeconds = args["warmupSeconds"].number();
         if ( ! args["hideResults"].eoo() )
             this->hideResults = args["hideResults"].trueValue();
         if ( ! args["handleErrors"].eoo() )
@@ -332,6 +411,15 @@ namespace mongo {
         BsonTemplateEvaluator bsonTemplateEvaluator;
         invariant(bsonTemplateEvaluator.setId(_id) == BsonTemplateEvaluator::StatusSuccess);
 
+        // deadline scheduling: with a configured arrival rate, every op has a fixed
+        // intended start time on this worker's schedule
+        const long long intervalMicros = _config->opsPerSecPerWorker > 0 ?
+            (long long)( 1000000.0 / _config->opsPerSecPerWorker ) : 0;
+        long long nextOpDeadlineMicros = timer.micros() + intervalMicros;
+
+        const long long warmupMicros = (long long)( _config->warmupSeconds * 1000000.0 );
+        bool warmedUp = ( warmupMicros == 0 );
+
         while ( !shouldStop() ) {
             BSONObjIterator i( _config->ops );
             while ( i.more() ) {
@@ -340,6 +428,24 @@ namespace mongo {
 
                 BSONElement e = i.next();
 
+                // If we are ahead of the arrival schedule, wait for the op's intended
+                // start time.  If we are behind it (an earlier op stalled and work
+                // queued up), issue immediately and carry the lateness into this op's
+                // recorded latency, so stalls can't hide queueing delay from the
+                // numbers (coordinated omission).
+                long long scheduleLagMicros = 0;
+                if ( intervalMicros > 0 ) {
+                    const long long now = timer.micros();
+                    if ( now < nextOpDeadlineMicros ) {
+                        sleepmicros( nextOpDeadlineMicros - now );
+                    }
+                    else {
+                        scheduleLagMicros = now - nextOpDeadlineMicros;
+                    }
+                    nextOpDeadlineMicros += intervalMicros;
+                    _stats.schedulingLagCounter.countOne( scheduleLagMicros );
+                }
+
                 string ns = e["ns"].String();
                 string op = e["op"].String();
 
@@ -390,7 +496,7 @@ namespace mongo {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_stats.findOneCounter, scheduleLagMicros);
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -445,12 +551,12 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, scheduleLagMicros);
                             stdx::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, scheduleLagMicros);
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
                             count = cursor->itcount();
@@ -486,7 +592,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_stats.updateCounter, scheduleLagMicros);
 
                             if (useWriteCmd) {
                                 // TODO: Replace after SERVER-11774.
@@ -537,7 +643,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
+                            BenchRunEventTrace _bret(&_stats.insertCounter, scheduleLagMicros);
 
                             BSONObjBuilder builder;
                             BSONObj insertDoc = fixQuery(e["doc"].Obj(), bsonTemplateEvaluator);
@@ -588,7 +694,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_stats.deleteCounter, scheduleLagMicros);
 
                             if (useWriteCmd) {
                                 // TODO: Replace after SERVER-11774.
@@ -683,6 +789,12 @@ namespace mongo {
                     conn->getLastError();
                 }
 
+                if ( !warmedUp && timer.micros() >= warmupMicros ) {
+                    // measurement phase begins; discard everything observed while warming up
+                    _stats.reset();
+                    warmedUp = true;
+                }
+
                 sleepmillis( delay );
             }
         }
@@ -838,6 +950,25 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendLatencyPercentilesIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() == 0)
+             return;
+
+         const BenchRunLatencyHistogram &histo = counter.histogram();
+         BSONObjBuilder sub(buf.subobjStart(name));
+         sub.append("count", static_cast<long long>(counter.getNumEvents()));
+         sub.append("averageMicros",
+                    static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
+         sub.append("p50Micros", histo.getPercentile(0.50));
+         sub.append("p90Micros", histo.getPercentile(0.90));
+         sub.append("p99Micros", histo.getPercentile(0.99));
+         sub.append("p999Micros", histo.getPercentile(0.999));
+         sub.append("maxMicros", histo.getMaxMicros());
+         sub.done();
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -865,13 +996,23 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
 
+         appendLatencyPercentilesIfAvailable(buf, "findOneLatency", stats.findOneCounter);
+         appendLatencyPercentilesIfAvailable(buf, "insertLatency", stats.insertCounter);
+         appendLatencyPercentilesIfAvailable(buf, "deleteLatency", stats.deleteCounter);
+         appendLatencyPercentilesIfAvailable(buf, "updateLatency", stats.updateCounter);
+         appendLatencyPercentilesIfAvailable(buf, "queryLatency", stats.queryCounter);
+         appendLatencyPercentilesIfAvailable(buf, "schedulingLag", stats.schedulingLagCounter);
+
          {
+             // opcounter deltas span warmup and measurement, so divide by the whole run
+             const double totalSeconds =
+                 runner->_config->seconds + runner->_config->warmupSeconds;
              BSONObjIterator i( after );
              while ( i.more() ) {
                  BSONElement e = i.next();
                  double x = e.number();
                  x -= before[e.fieldName()].number();
-                 buf.append( e.fieldName() , x / runner->_config->seconds );
+                 buf.append( e.fieldName() , x / totalSeconds );
              }
          }
 
@@ -893,7 +1034,8 @@ namespace mongo {
 
          OID oid = OID( start.firstElement().String() );
          BenchRunner* runner = BenchRunner::get( oid );
-         sleepmillis( (int)(1000.0 * runner->config().seconds) );
+         sleepmillis( (int)(1000.0 * (runner->config().warmupSeconds +
+                                      runner->config().seconds)) );
 
          return benchFinish( start, data );
      }
@@ -97,6 +97,26 @@ namespace mongo {
          */
         double seconds;
 
+        /**
+         * Target operation arrival rate for each worker, in ops per second.
+         *
+         * When positive, each worker issues operations on a fixed schedule instead of a
+         * closed loop: every operation has an intended start time, and if the worker is
+         * running behind (a stall queued work up), the lateness is recorded and carried
+         * into the affected operations' latencies so stalls can't hide queueing delay
+         * from the results (coordinated omission).  Zero means the classic closed loop.
+         */
+        double opsPerSecPerWorker;
+
+        /**
+         * Length of the warmup phase, in seconds.
+         *
+         * Statistics gathered before the warmup deadline are discarded, so reported
+         * numbers cover only the steady-state measurement phase.  The javascript
+         * benchRunSync() runs for warmupSeconds + seconds in total.
+         */
+        double warmupSeconds;
+
         bool hideResults;
         bool handleErrors;
         bool hideErrors;
@@ -127,6 +147,50 @@ namespace mongo {
         void initializeToDefaults();
     };
 
+    /**
+     * Compact latency histogram: exponential buckets subdivided linearly, in the style
+     * of HDR histograms.  Values are recorded with bounded relative error (about 6%),
+     * so tail percentiles stay meaningful however skewed the distribution is, while the
+     * footprint stays a few KB per counter.
+     *
+     * Not thread safe.  Expected use is one instance per thread during parallel execution.
+     */
+    class BenchRunLatencyHistogram {
+    public:
+        BenchRunLatencyHistogram();
+
+        void reset();
+
+        /// Record one observation of "micros" microseconds.
+        void record(long long micros);
+
+        /// Conceptually the equivalent of "+=".  Adds "other" into this.
+        void updateFrom(const BenchRunLatencyHistogram &other);
+
+        unsigned long long getCount() const { return _count; }
+
+        /// Largest recorded value, exact.
+        long long getMaxMicros() const { return _maxMicros; }
+
+        /**
+         * Approximate value at quantile "p" (0 < p <= 1), e.g. 0.99 for the 99th
+         * percentile.  Returns 0 if nothing has been recorded.
+         */
+        long long getPercentile(double p) const;
+
+    private:
+        static const int kSubBucketBits = 4;  // 16 linear sub-buckets per power of two
+        static const int kSubBuckets = 1 << kSubBucketBits;
+        static const int kNumSlots = 50 * kSubBuckets;  // last slot is a catch-all
+
+        static int slotFor(long long micros);
+        static long long slotMidpointMicros(int slot);
+
+        unsigned long long _counts[kNumSlots];
+        unsigned long long _count;
+        long long _maxMicros;
+    };
+
     /**
      * An event counter for events that have an associated duration.
      *
@@ -154,8 +218,14 @@ namespace mongo {
         void countOne(long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            _histogram.record(timeMicros);
         }
 
+        /**
+         * Get the latency distribution of the observed events.
+         */
+        const BenchRunLatencyHistogram &histogram() const { return _histogram; }
+
         /**
          * Get the total number of microseconds ellapsed during all observed events.
          */
@@ -169,6 +239,7 @@ namespace mongo {
     private:
         unsigned long long _numEvents;
         long long _totalTimeMicros;
+        BenchRunLatencyHistogram _histogram;
     };
 
     /**
@@ -186,8 +257,16 @@ namespace mongo {
      */
     class BenchRunEventTrace : private boost::noncopyable {
     public:
-        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter) {
+        /**
+         * "scheduleLagMicros" is how late the event started relative to its intended
+         * start time under deadline scheduling; it is added to the recorded duration so
+         * latencies are measured from when the operation should have been issued, not
+         * from when a backed-up worker got around to it.
+         */
+        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter,
+                                    long long scheduleLagMicros = 0) {
             initialize(eventCounter, eventCounter, false);
+            _scheduleLagMicros = scheduleLagMicros;
         }
 
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
@@ -197,7 +276,8 @@ namespace mongo {
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            (_succeeded ? _successCounter : _failCounter)->countOne(
+                    _timer.micros() + _scheduleLagMicros);
         }
 
         void succeed() { _succeeded = true; }
@@ -210,11 +290,13 @@ namespace mongo {
             _successCounter = successCounter;
             _failCounter = failCounter;
             _succeeded = !defaultToFailure;
+            _scheduleLagMicros = 0;
         }
 
         Timer _timer;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
+        long long _scheduleLagMicros;
         bool _succeeded;
     };
 
@@ -239,6 +321,13 @@ namespace mongo {
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
 
+        /**
+         * Lateness of each operation relative to its deadline-scheduled start time.
+         * Only populated when opsPerSecPerWorker is configured; on-time operations
+         * record zero, so the distribution shows what fraction of the schedule slipped.
+         */
+        BenchRunEventCounter schedulingLagCounter;
+
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
     };
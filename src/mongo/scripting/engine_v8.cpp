@@ -29,6 +29,8 @@
 
 #include "mongo/scripting/engine_v8.h"
 
+#include <deque>
+
 #include "mongo/base/init.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/scripting/v8_db.h"
@@ -50,6 +52,69 @@ namespace mongo {
         extern const JSFile assert;
     }
 
+namespace {
+    /**
+     * Cache of v8::ScriptData pre-parse data keyed by script source.  The data
+     * is context- and isolate-independent, so one entry serves every scope that
+     * compiles the same source: the core .js files run on each fresh scope's
+     * setup, and $where / mapReduce functions recompiled across pooled scopes.
+     * V8 only reads the data during compilation, so a single entry can be
+     * handed to several isolates at once.
+     *
+     * More-recently used entries are kept at the front, as in ScopeCache.
+     * Callers must hold their isolate's locker, as PreCompile() parses within
+     * the current isolate.
+     */
+    class PrecompiledScriptCache {
+    public:
+        PrecompiledScriptCache() : _mutex("PrecompiledScriptCache") {}
+
+        /**
+         * Returns pre-parse data for source, generating and caching it on a
+         * miss.  Returns NULL if the source could not be pre-parsed; the
+         * caller then just compiles without a hint.
+         */
+        boost::shared_ptr<v8::ScriptData> get(const string& source) {
+            scoped_lock lk(_mutex);
+
+            for (Entries::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+                if (it->source == source) {
+                    Entry hit = *it;
+                    _entries.erase(it);
+                    _entries.push_front(hit);
+                    return hit.data;
+                }
+            }
+
+            boost::shared_ptr<v8::ScriptData> data(
+                    v8::ScriptData::PreCompile(source.c_str(), source.size()));
+            if (!data || data->HasError())
+                return boost::shared_ptr<v8::ScriptData>();
+
+            if (_entries.size() >= kMaxEntries)
+                _entries.pop_back();
+
+            Entry toStore = {source, data};
+            _entries.push_front(toStore);
+            return data;
+        }
+
+    private:
+        struct Entry {
+            string source;
+            boost::shared_ptr<v8::ScriptData> data;
+        };
+
+        static const size_t kMaxEntries = 100;
+
+        typedef std::deque<Entry> Entries; // More-recently used entries at the front.
+        Entries _entries;  // protected by _mutex
+        mongo::mutex _mutex;
+    };
+
+    PrecompiledScriptCache precompiledScriptCache;
+} // anonymous namespace
+
     // The  unwrapXXX functions extract internal fields from an object wrapped by wrapBSONObject.
     // These functions are currently only used in places that should always have the correct
     // type of object, however it may be possible for users to come up with a way to make these
@@ -960,9 +1025,12 @@ namespace mongo {
         string fn = str::stream() << "_funcs" << functionNumber;
         code = str::stream() << fn << " = " << code;
 
+        boost::shared_ptr<v8::ScriptData> preData = precompiledScriptCache.get(code);
+        v8::ScriptOrigin origin(v8::String::New(fn.c_str()));
         v8::Handle<v8::Script> script = v8::Script::Compile(
                                             v8::String::New(code.c_str(), code.length()),
-                                            v8::String::New(fn.c_str()));
+                                            &origin,
+                                            preData.get());
 
         // throw on error
         checkV8ErrorState(script, try_catch);
@@ -1074,9 +1142,13 @@ namespace mongo {
         V8_SIMPLE_HEADER
         v8::TryCatch try_catch;
 
+        boost::shared_ptr<v8::ScriptData> preData =
+                precompiledScriptCache.get(code.toString());
+        v8::ScriptOrigin origin(v8::String::New(name.c_str(), name.length()));
         v8::Handle<v8::Script> script =
                 v8::Script::Compile(v8::String::New(code.rawData(), code.size()),
-                                    v8::String::New(name.c_str(), name.length()));
+                                    &origin,
+                                    preData.get());
 
         if (checkV8ErrorState(script, try_catch, reportError, assertOnError))
             return false;
@@ -30,6 +30,7 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <map>
@@ -45,6 +46,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/tools/mongodump_options.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/options_parser/option_section.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -92,15 +94,15 @@ public:
     };
 
     void doCollection( const string coll , Query q, FILE* out , ProgressMeter *m,
-                       bool usingMongos ) {
+                       bool usingMongos, DBClientBase* useConn = NULL ) {
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
         if (startsWith(coll.c_str(), "local.oplog.") && q.obj.hasField("ts"))
             queryOptions |= QueryOption_OplogReplay;
         else if (mongoDumpGlobalParams.snapShotQuery) {
             q.snapshot();
         }
-        
-        DBClientBase& connBase = conn(true);
+
+        DBClientBase& connBase = useConn ? *useConn : conn(true);
         Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
@@ -118,18 +120,109 @@ public:
         }
     }
 
+    // Shared flags for a group of dump worker threads.
+    struct WorkerState {
+        WorkerState() : lock("dumpWorkers"), next(0), failed(false) {}
+        SimpleMutex lock;
+        size_t next;    // next unclaimed index for pool workers
+        bool failed;
+    };
+
+    // Streams one parallelCollectionScan segment into a shared writer.  Each reader
+    // owns its connection; writes interleave under the state lock, which is fine for
+    // a dump file since document order carries no meaning.
+    struct SegmentReader {
+        SegmentReader(Dump* tool, const string& ns, long long cursorId,
+                      Writer* writer, WorkerState* state)
+            : _tool(tool), _ns(ns), _cursorId(cursorId), _writer(writer), _state(state) {}
+
+        void operator()() {
+            try {
+                scoped_ptr<DBClientBase> myConn(_tool->newConnection());
+                DBClientCursor cursor(myConn.get(), _ns, _cursorId, 0,
+                                      QueryOption_SlaveOk | QueryOption_NoCursorTimeout);
+                while (cursor.more()) {
+                    BSONObj obj = cursor.next();
+                    SimpleMutex::scoped_lock lk(_state->lock);
+                    (*_writer)(obj);
+                }
+            }
+            catch (const std::exception& e) {
+                toolError() << "error dumping segment of " << _ns << ": " << e.what()
+                            << std::endl;
+                SimpleMutex::scoped_lock lk(_state->lock);
+                _state->failed = true;
+            }
+        }
+
+        Dump* _tool;
+        string _ns;
+        long long _cursorId;
+        Writer* _writer;
+        WorkerState* _state;
+    };
+
+    /**
+     * Dumps 'coll' through concurrent parallelCollectionScan segment streams.  Returns
+     * false without writing anything if the server can't split the collection, in
+     * which case the caller falls back to the single-cursor path.
+     */
+    bool dumpCollectionSegments(const string& coll, FILE* out, ProgressMeter* m,
+                                int numSegments) {
+        BSONObj res;
+        BSONObj cmd = BSON("parallelCollectionScan" << nsToCollectionSubstring(coll).toString()
+                           << "numCursors" << numSegments);
+        if (!conn(true).runCommand(nsToDatabase(coll), cmd, res)) {
+            toolInfoLog() << "\t\t parallelCollectionScan unavailable for " << coll << ": "
+                          << res["errmsg"].str() << "; dumping with a single cursor"
+                          << std::endl;
+            return false;
+        }
+
+        vector<BSONElement> cursors = res["cursors"].Array();
+        if (cursors.size() < 2) {
+            // One segment gains nothing over the plain cursor (and loses exhaust mode).
+            return false;
+        }
+
+        Writer writer(out, m);
+        WorkerState state;
+        boost::thread_group readers;
+        for (size_t i = 0; i < cursors.size(); i++) {
+            long long cursorId = cursors[i].Obj()["cursor"].Obj()["id"].Long();
+            readers.create_thread(SegmentReader(this, coll, cursorId, &writer, &state));
+        }
+        readers.join_all();
+
+        uassert(18541, str::stream() << "parallel dump of " << coll << " failed",
+                !state.failed);
+        return true;
+    }
+
     void writeCollectionFile( const string coll , Query q, boost::filesystem::path outputFile,
-                              bool usingMongos ) {
+                              bool usingMongos, DBClientBase* useConn = NULL,
+                              bool allowSegments = false ) {
         toolInfoLog() << "\t" << coll << " to " << outputFile.string() << std::endl;
 
+        DBClientBase& c = useConn ? *useConn : conn(true);
+
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        ProgressMeter m(c.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
         m.setName("Collection File Writing Progress");
         m.setUnits("documents");
 
-        doCollection(coll, q, f, &m, usingMongos);
+        // Segment streams scan in natural order, so they are only used when the user
+        // already opted out of $snapshot and isn't filtering.
+        if (allowSegments && q.obj.isEmpty() && !mongoDumpGlobalParams.snapShotQuery &&
+            dumpCollectionSegments(coll, f, &m,
+                                   mongoDumpGlobalParams.numParallelCollections)) {
+            // dumped via concurrent segment streams
+        }
+        else {
+            doCollection(coll, q, f, &m, usingMongos, &c);
+        }
 
         toolInfoLog() << "\t\t " << m.done()
                       << ((m.done() == 1) ? " document" : " documents")
@@ -174,6 +267,57 @@ public:
         doCollection(coll, dumpQuery, stdout, NULL, usingMongos);
     }
 
+    // Pool worker that claims collections off the shared list and dumps each over its
+    // own connection.  Metadata maps are filled before the workers start and only read
+    // here.
+    struct CollectionDumpWorker {
+        CollectionDumpWorker(Dump* tool, WorkerState* state, const vector<string>* colls,
+                             const string& db, const Query& query,
+                             const boost::filesystem::path& outdir, bool usingMongos,
+                             const map<string, BSONObj>* options,
+                             const multimap<string, BSONObj>* indexes)
+            : _tool(tool), _state(state), _colls(colls), _db(db), _query(query),
+              _outdir(outdir), _usingMongos(usingMongos), _options(options),
+              _indexes(indexes) {}
+
+        void operator()() {
+            try {
+                scoped_ptr<DBClientBase> myConn(_tool->newConnection());
+                while (true) {
+                    size_t i;
+                    {
+                        SimpleMutex::scoped_lock lk(_state->lock);
+                        i = _state->next++;
+                    }
+                    if (i >= _colls->size()) {
+                        break;
+                    }
+                    const string& name = (*_colls)[i];
+                    const string filename = name.substr(_db.size() + 1);
+                    _tool->writeCollectionFile(name, _query, _outdir / (filename + ".bson"),
+                                               _usingMongos, myConn.get());
+                    _tool->writeMetadataFile(name, _outdir / (filename + ".metadata.json"),
+                                             *_options, *_indexes);
+                }
+            }
+            catch (const std::exception& e) {
+                toolError() << "error dumping collection: " << e.what() << std::endl;
+                SimpleMutex::scoped_lock lk(_state->lock);
+                _state->failed = true;
+            }
+        }
+
+        Dump* _tool;
+        WorkerState* _state;
+        const vector<string>* _colls;
+        string _db;
+        Query _query;
+        boost::filesystem::path _outdir;
+        bool _usingMongos;
+        const map<string, BSONObj>* _options;
+        const multimap<string, BSONObj>* _indexes;
+    };
+
     void go(const string& db,
             const string& coll,
             const Query& query,
@@ -278,10 +422,34 @@ public:
             collections.push_back(name);
         }
         
+        const bool parallel = mongoDumpGlobalParams.numParallelCollections > 1 &&
+            !toolGlobalParams.useDirectClient;
+
+        if (parallel && collections.size() > 1) {
+            WorkerState state;
+            boost::thread_group workers;
+            const size_t numWorkers =
+                std::min(static_cast<size_t>(mongoDumpGlobalParams.numParallelCollections),
+                         collections.size());
+            for (size_t i = 0; i < numWorkers; i++) {
+                workers.create_thread(CollectionDumpWorker(this, &state, &collections, db,
+                                                           query, outdir, usingMongos,
+                                                           &collectionOptions, &indexes));
+            }
+            workers.join_all();
+            uassert(18542, "one or more collections failed to dump", !state.failed);
+            return;
+        }
+
+        // With a single collection the parallelism budget goes to segment streams of
+        // that collection instead.
+        const bool allowSegments = parallel && !usingMongos;
+
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
             string name = *it;
             const string filename = outFilename != "" ? outFilename : name.substr( db.size() + 1 );
-            writeCollectionFile( name , query, outdir / ( filename + ".bson" ), usingMongos );
+            writeCollectionFile( name , query, outdir / ( filename + ".bson" ), usingMongos,
+                                 NULL, allowSegments );
             writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
         }
 
@@ -30,26 +30,130 @@
 
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/tools/fast_json.h"
 #include "mongo/tools/mongoexport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/tools/tool_logger.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/options_parser/option_section.h"
 
 using namespace mongo;
 
 class Export : public Tool {
 public:
+    // serialized JSON is handed to the output stream in chunks of roughly this
+    // size rather than one ostream insertion per document
+    static const int kFlushBytes = 64 * 1024;
+
     Export() : Tool() { }
 
     virtual void printHelp( ostream & out ) {
         printMongoExportHelp(&out);
     }
 
+    // Shared state for parallel segment export: one output stream fed by several
+    // reader threads, each flushing whole documents under the lock.
+    struct WorkerState {
+        WorkerState( ostream* o ) : lock("exportWorkers"), out(o), num(0), failed(false) {}
+        SimpleMutex lock;
+        ostream* out;
+        long long num;
+        bool failed;
+    };
+
+    // Streams one parallelCollectionScan segment as JSON lines into the shared
+    // output.  Each reader owns its connection and serializes into its own
+    // buffer; only complete documents cross the lock, so lines never interleave.
+    struct SegmentReader {
+        SegmentReader( Export* tool, const string& ns, long long cursorId, WorkerState* state )
+            : _tool(tool), _ns(ns), _cursorId(cursorId), _state(state) {}
+
+        void operator()() {
+            try {
+                scoped_ptr<DBClientBase> myConn(_tool->newConnection());
+                DBClientCursor cursor(myConn.get(), _ns, _cursorId, 0,
+                                      (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
+                                      QueryOption_NoCursorTimeout);
+                FastJsonWriter writer;
+                long long myNum = 0;
+                while (cursor.more()) {
+                    writer.writeObject(cursor.next());
+                    writer.writeRaw("\n");
+                    myNum++;
+                    if (writer.len() >= kFlushBytes)
+                        _flush(writer);
+                }
+                _flush(writer);
+
+                SimpleMutex::scoped_lock lk(_state->lock);
+                _state->num += myNum;
+            }
+            catch (const std::exception& e) {
+                toolError() << "error exporting segment of " << _ns << ": " << e.what()
+                            << std::endl;
+                SimpleMutex::scoped_lock lk(_state->lock);
+                _state->failed = true;
+            }
+        }
+
+        void _flush( FastJsonWriter& writer ) {
+            if (!writer.len())
+                return;
+            SimpleMutex::scoped_lock lk(_state->lock);
+            _state->out->write(writer.data(), writer.len());
+            writer.reset();
+        }
+
+        Export* _tool;
+        string _ns;
+        long long _cursorId;
+        WorkerState* _state;
+    };
+
+    /**
+     * Exports 'ns' through concurrent parallelCollectionScan segment streams, one
+     * JSON document per line in arbitrary order.  Returns false without writing
+     * anything if the server cannot split the collection, in which case the
+     * caller falls back to the single-cursor path.
+     */
+    bool exportSegments( const string& ns, ostream& out, long long* numExported ) {
+        BSONObj res;
+        BSONObj cmd = BSON("parallelCollectionScan" << nsToCollectionSubstring(ns).toString()
+                           << "numCursors" << mongoExportGlobalParams.parallel);
+        if (!conn(true).runCommand(nsToDatabase(ns), cmd, res)) {
+            toolInfoOutput() << "parallelCollectionScan unavailable for " << ns << ": "
+                             << res["errmsg"].str() << "; exporting with a single cursor"
+                             << endl;
+            return false;
+        }
+
+        vector<BSONElement> cursors = res["cursors"].Array();
+        if (cursors.size() < 2) {
+            // one segment gains nothing over the plain cursor
+            return false;
+        }
+
+        WorkerState state(&out);
+        boost::thread_group readers;
+        for (size_t i = 0; i < cursors.size(); i++) {
+            long long cursorId = cursors[i].Obj()["cursor"].Obj()["id"].Long();
+            readers.create_thread(SegmentReader(this, ns, cursorId, &state));
+        }
+        readers.join_all();
+
+        uassert(18566, str::stream() << "parallel export of " << ns << " failed",
+                !state.failed);
+        *numExported = state.num;
+        return true;
+    }
+
     // Turn every double quote character into two double quote characters
     // If hasSurroundingQuotes is true, doesn't escape the first and last
     // characters of the string, if it's false, add a double quote character
@@ -176,6 +280,16 @@ public:
             return -1;
         }
 
+        if (mongoExportGlobalParams.parallel > 1) {
+            long long numParallel = 0;
+            if (exportSegments(ns, out, &numParallel)) {
+                toolInfoOutput() << "exported " << numParallel << " records" << endl;
+                return 0;
+            }
+            // the server couldn't split the collection; fall through to the
+            // single-cursor path
+        }
+
         Query q(mongoExportGlobalParams.query);
         if (mongoExportGlobalParams.sort != "") {
             BSONObj sortSpec = mongo::fromjson(mongoExportGlobalParams.sort);
@@ -204,6 +318,7 @@ public:
         if (mongoExportGlobalParams.jsonArray)
             out << '[';
 
+        FastJsonWriter writer;
         long long num = 0;
         while ( cursor->more() ) {
             num++;
@@ -222,15 +337,25 @@ public:
             }
             else {
                 if (mongoExportGlobalParams.jsonArray && num != 1)
-                    out << ',';
+                    writer.writeRaw(",");
 
-                out << obj.jsonString();
+                writer.writeObject(obj);
 
                 if (!mongoExportGlobalParams.jsonArray)
-                    out << endl;
+                    writer.writeRaw("\n");
+
+                if (writer.len() >= kFlushBytes) {
+                    out.write(writer.data(), writer.len());
+                    writer.reset();
+                }
             }
         }
 
+        if (writer.len()) {
+            out.write(writer.data(), writer.len());
+            writer.reset();
+        }
+
         if (mongoExportGlobalParams.jsonArray)
             out << ']' << endl;
 
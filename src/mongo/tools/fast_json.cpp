@@ -0,0 +1,315 @@
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/fast_json.h"
+
+#include <limits>
+
+#include "mongo/platform/float_utils.h"
+#include "mongo/util/hex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    namespace {
+
+        // Which bytes need escaping inside a JSON string: the control range, the
+        // quote and the backslash.  Everything else -- including UTF-8 multibyte
+        // sequences -- passes through verbatim, exactly like escape() in
+        // bson-inl.h.
+        unsigned char escapeTable[256];
+
+        struct EscapeTableInit {
+            EscapeTableInit() {
+                for ( int i = 0; i < 256; i++ )
+                    escapeTable[i] = ( i < 0x20 || i == '"' || i == '\\' ) ? 1 : 0;
+            }
+        } escapeTableInit;
+
+        // true if any byte of 'w' is below 0x20 or equals '"' or '\\'.  The usual
+        // portable word-at-a-time bit tricks (hasless/hasvalue), standing in for
+        // a SIMD scan without taking an instruction set dependency.
+        inline bool anyNeedsEscape( unsigned long long w ) {
+            const unsigned long long ones = 0x0101010101010101ULL;
+            const unsigned long long highs = 0x8080808080808080ULL;
+
+            unsigned long long isControl = ( w - ones * 0x20 ) & ~w & highs;
+
+            unsigned long long q = w ^ ( ones * '"' );
+            unsigned long long isQuote = ( q - ones ) & ~q & highs;
+
+            unsigned long long b = w ^ ( ones * '\\' );
+            unsigned long long isBackslash = ( b - ones ) & ~b & highs;
+
+            return ( isControl | isQuote | isBackslash ) != 0;
+        }
+    }
+
+    FastJsonWriter::FastJsonWriter() : _buf( 1024 * 1024 ) {
+    }
+
+    void FastJsonWriter::writeObject( const BSONObj& obj ) {
+        _writeObject( obj, false );
+    }
+
+    void FastJsonWriter::_writeObject( const BSONObj& obj, bool isArray ) {
+        if ( obj.isEmpty() ) {
+            _buf.appendStr( isArray ? "[]" : "{}", false );
+            return;
+        }
+
+        _buf.appendStr( isArray ? "[ " : "{ ", false );
+
+        BSONObjIterator i( obj );
+        BSONElement e = i.next();
+        if ( !e.eoo() ) {
+            while ( 1 ) {
+                _writeElement( e, !isArray );
+                e = i.next();
+                if ( e.eoo() )
+                    break;
+                _buf.appendStr( ", ", false );
+            }
+        }
+
+        _buf.appendStr( isArray ? " ]" : " }", false );
+    }
+
+    void FastJsonWriter::_writeElement( const BSONElement& e, bool includeFieldNames ) {
+        if ( includeFieldNames ) {
+            _buf.appendChar( '"' );
+            _writeEscaped( e.fieldName(), e.fieldNameSize() - 1 );
+            _buf.appendStr( "\" : ", false );
+        }
+
+        switch ( e.type() ) {
+        case mongo::String:
+        case Symbol:
+            _buf.appendChar( '"' );
+            _writeEscaped( e.valuestr(), e.valuestrsize() - 1 );
+            _buf.appendChar( '"' );
+            break;
+
+        case NumberLong:
+            _buf.appendStr( "{ \"$numberLong\" : \"", false );
+            _writeLongLong( e.numberLong() );
+            _buf.appendStr( "\" }", false );
+            break;
+
+        case NumberInt:
+            // ints print the same digits through %d as through the 16-digit
+            // double path in BSONElement::jsonString
+            _writeInt( e.numberInt() );
+            break;
+
+        case NumberDouble:
+            _writeDouble( e.number() );
+            break;
+
+        case mongo::Bool:
+            _buf.appendStr( e.boolean() ? "true" : "false", false );
+            break;
+
+        case jstNULL:
+            _buf.appendStr( "null", false );
+            break;
+
+        case Undefined:
+            _buf.appendStr( "{ \"$undefined\" : true }", false );
+            break;
+
+        case Object:
+            _writeObject( e.embeddedObject(), false );
+            break;
+
+        case mongo::Array: {
+            if ( e.embeddedObject().isEmpty() ) {
+                _buf.appendStr( "[]", false );
+                break;
+            }
+            _buf.appendStr( "[ ", false );
+            BSONObjIterator i( e.embeddedObject() );
+            BSONElement sub = i.next();
+            if ( !sub.eoo() ) {
+                int count = 0;
+                while ( 1 ) {
+                    if ( strtol( sub.fieldName(), 0, 10 ) > count ) {
+                        _buf.appendStr( "undefined", false );
+                    }
+                    else {
+                        _writeElement( sub, false );
+                        sub = i.next();
+                    }
+                    count++;
+                    if ( sub.eoo() )
+                        break;
+                    _buf.appendStr( ", ", false );
+                }
+            }
+            _buf.appendStr( " ]", false );
+            break;
+        }
+
+        case jstOID:
+            _buf.appendStr( "{ \"$oid\" : \"", false );
+            _buf.appendStr( e.__oid().str(), false );
+            _buf.appendStr( "\" }", false );
+            break;
+
+        case mongo::Date: {
+            Date_t d = e.date();
+            _buf.appendStr( "{ \"$date\" : ", false );
+            if ( d.isFormatable() ) {
+                _buf.appendChar( '"' );
+                _buf.appendStr( dateToISOStringLocal( d ), false );
+                _buf.appendChar( '"' );
+            }
+            else {
+                _buf.appendStr( "{ \"$numberLong\" : \"", false );
+                _writeLongLong( static_cast<long long>( d.millis ) );
+                _buf.appendStr( "\" }", false );
+            }
+            _buf.appendStr( " }", false );
+            break;
+        }
+
+        case Timestamp:
+            _buf.appendStr( "{ \"$timestamp\" : { \"t\" : ", false );
+            _writeUnsignedLongLong( e.timestampTime().millis / 1000 );
+            _buf.appendStr( ", \"i\" : ", false );
+            _writeUnsignedLongLong( e.timestampInc() );
+            _buf.appendStr( " } }", false );
+            break;
+
+        case MinKey:
+            _buf.appendStr( "{ \"$minKey\" : 1 }", false );
+            break;
+
+        case MaxKey:
+            _buf.appendStr( "{ \"$maxKey\" : 1 }", false );
+            break;
+
+        default:
+            // rare types (BinData, RegEx, DBRef, Code, CodeWScope) go through the
+            // existing serializer; they never dominate an export
+            _buf.appendStr( e.jsonString( Strict, false ), false );
+            break;
+        }
+    }
+
+    void FastJsonWriter::_writeEscaped( const char* s, size_t len ) {
+        size_t i = 0;
+        while ( i < len ) {
+            size_t runStart = i;
+
+            // scan a word at a time for anything needing an escape; a clean run
+            // (the overwhelmingly common case) is copied with a single memcpy
+            while ( i + sizeof( unsigned long long ) <= len ) {
+                unsigned long long w;
+                memcpy( &w, s + i, sizeof( w ) );
+                if ( anyNeedsEscape( w ) )
+                    break;
+                i += sizeof( w );
+            }
+            while ( i < len && !escapeTable[ static_cast<unsigned char>( s[i] ) ] )
+                i++;
+
+            if ( i > runStart )
+                _buf.appendBuf( s + runStart, i - runStart );
+            if ( i == len )
+                break;
+
+            char c = s[i++];
+            switch ( c ) {
+            case '"':  _buf.appendStr( "\\\"", false ); break;
+            case '\\': _buf.appendStr( "\\\\", false ); break;
+            case '\b': _buf.appendStr( "\\b", false ); break;
+            case '\f': _buf.appendStr( "\\f", false ); break;
+            case '\n': _buf.appendStr( "\\n", false ); break;
+            case '\r': _buf.appendStr( "\\r", false ); break;
+            case '\t': _buf.appendStr( "\\t", false ); break;
+            default:
+                // TODO: these should be utf16 code-units not bytes (same caveat
+                // as escape() in bson-inl.h)
+                _buf.appendStr( "\\u00", false );
+                _buf.appendStr( toHexLower( &c, 1 ), false );
+                break;
+            }
+        }
+    }
+
+    void FastJsonWriter::_writeDouble( double d ) {
+        if ( d >= -std::numeric_limits<double>::max() &&
+             d <= std::numeric_limits<double>::max() ) {
+            // same digits as the precision(16) ostream path in
+            // BSONElement::jsonString, but one snprintf straight into the buffer
+            const int maxSize = 32;
+            const int prev = _buf.len();
+            char* start = _buf.grow( maxSize );
+            int z = snprintf( start, maxSize, "%.16g", d );
+            verify( z >= 0 && z < maxSize );
+            _buf.setlen( prev + z );
+        }
+        else if ( mongo::isNaN( d ) ) {
+            _buf.appendStr( "NaN", false );
+        }
+        else {
+            int sign = 0;
+            massert( 18565, "Number cannot be represented in JSON",
+                     mongo::isInf( d, &sign ) );
+            _buf.appendStr( sign == 1 ? "Infinity" : "-Infinity", false );
+        }
+    }
+
+    void FastJsonWriter::_writeInt( int x ) {
+        const int maxSize = 12;
+        const int prev = _buf.len();
+        int z = snprintf( _buf.grow( maxSize ), maxSize, "%d", x );
+        verify( z >= 0 && z < maxSize );
+        _buf.setlen( prev + z );
+    }
+
+    void FastJsonWriter::_writeLongLong( long long x ) {
+        const int maxSize = 23;
+        const int prev = _buf.len();
+        int z = snprintf( _buf.grow( maxSize ), maxSize, "%lld", x );
+        verify( z >= 0 && z < maxSize );
+        _buf.setlen( prev + z );
+    }
+
+    void FastJsonWriter::_writeUnsignedLongLong( unsigned long long x ) {
+        const int maxSize = 22;
+        const int prev = _buf.len();
+        int z = snprintf( _buf.grow( maxSize ), maxSize, "%llu", x );
+        verify( z >= 0 && z < maxSize );
+        _buf.setlen( prev + z );
+    }
+
+}  // namespace mongo
@@ -0,0 +1,77 @@
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Serializes BSON documents to strict-mode JSON, producing the same bytes as
+     * BSONObj::jsonString(Strict) but writing directly into a reusable buffer
+     * instead of going through per-value ostream formatting and string
+     * concatenation.  String escaping is table driven and scans eight bytes at a
+     * time so that clean runs (the overwhelmingly common case) cost one word
+     * compare and one memcpy; numbers are formatted with snprintf straight into
+     * the buffer.  Built for mongoexport, where serialization dominates CPU time.
+     *
+     * The caller drains the buffer with data()/len() and reset(); documents are
+     * only appended whole, so the buffer always ends on a document boundary.
+     */
+    class FastJsonWriter : boost::noncopyable {
+    public:
+        FastJsonWriter();
+
+        /** appends the strict extended JSON rendering of 'obj' */
+        void writeObject( const BSONObj& obj );
+
+        /** appends raw bytes untouched (separators, newlines) */
+        void writeRaw( const StringData& s ) { _buf.appendStr( s, false ); }
+
+        const char* data() const { return _buf.buf(); }
+        int len() const { return _buf.len(); }
+        void reset() { _buf.reset(); }
+
+    private:
+        void _writeObject( const BSONObj& obj, bool isArray );
+        void _writeElement( const BSONElement& e, bool includeFieldNames );
+        void _writeEscaped( const char* s, size_t len );
+        void _writeQuotedEscaped( const StringData& s );
+        void _writeDouble( double d );
+        void _writeInt( int x );
+        void _writeLongLong( long long x );
+        void _writeUnsignedLongLong( unsigned long long x );
+
+        BufBuilder _buf;
+    };
+
+}  // namespace mongo
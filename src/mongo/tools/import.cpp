@@ -29,15 +29,20 @@
 #include "mongo/pch.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
+#include <map>
 
 #include "mongo/base/initializer.h"
 #include "mongo/db/json.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/tools/mongoimport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/text.h"
 
 using namespace mongo;
@@ -183,14 +188,15 @@ class Import : public Tool {
     }
 
     /*
-     * Parses one object from the input file.  This usually corresponds to one line in the input
-     * file, unless the file is a CSV and contains a newline within a quoted string entry.
-     * Returns a true if a BSONObj was successfully created and false if not.
+     * Reads one raw row from the input file into 'row'.  This usually corresponds to one line,
+     * unless the file is a CSV and contains a newline within a quoted string entry.
+     * Returns true if a row was read and false if the input is exhausted.
      */
-    bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
+    bool readRow(istream* in, string& row, int& numBytesRead) {
         boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
         char* line = buffer.get();
 
+        row.clear();
         numBytesRead = getLine(in, line);
         line += numBytesRead;
 
@@ -199,24 +205,7 @@ class Import : public Tool {
         }
         numBytesRead += strlen( line );
 
-        if (_type == JSON) {
-            // Strip out trailing whitespace
-            char * end = ( line + strlen( line ) ) - 1;
-            while ( end >= line && isspace(*end) ) {
-                *end = 0;
-                end--;
-            }
-            try {
-                o = fromjson( line );
-            } catch ( MsgAssertionException& e ) {
-                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
-            }
-            return true;
-        }
-
-        vector<string> tokens;
         if (_type == CSV) {
-            string row;
             bool inside_quotes = false;
             size_t last_quote = 0;
             while (true) {
@@ -244,41 +233,292 @@ class Import : public Tool {
             }
             // now 'row' is string corresponding to one row of the CSV file
             // (which may span multiple lines) and represents one BSONObj
+        }
+        else {
+            row = line;
+        }
+        return true;
+    }
+
+    void tokenizeRow(const string& row, vector<string>& tokens) {
+        if (_type == CSV) {
             csvTokenizeRow(row, tokens);
+            return;
         }
-        else {  // _type == TSV
-            while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
-                line++;
-            }
 
-            boost::split(tokens, line, boost::is_any_of(_sep));
+        // _type == TSV
+        const char* line = row.c_str();
+        while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
+            line++;
         }
 
-        // Now that the row is tokenized, create a BSONObj out of it.
+        boost::split(tokens, line, boost::is_any_of(_sep));
+    }
+
+    BSONObj buildObjFromTokens(const vector<string>& tokens) {
         BSONObjBuilder b;
         unsigned int pos=0;
-        for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
-            string token = *it;
-            if (mongoImportGlobalParams.headerLine) {
-                toolGlobalParams.fields.push_back(token);
+        for (vector<string>::const_iterator it = tokens.begin(); it != tokens.end(); ++it) {
+            string name;
+            if (pos < toolGlobalParams.fields.size()) {
+                name = toolGlobalParams.fields[pos];
+            }
+            else {
+                stringstream ss;
+                ss << "field" << pos;
+                name = ss.str();
+            }
+            pos++;
+
+            _append( b , name , *it );
+        }
+        return b.obj();
+    }
+
+    /*
+     * Converts one raw row (as produced by readRow) into a BSONObj.  Once the header line has
+     * been consumed this only reads immutable state, so parser threads may run it concurrently.
+     */
+    BSONObj parseRowString(const string& row) {
+        if (_type == JSON) {
+            // Strip out trailing whitespace
+            size_t end = row.find_last_not_of(" \f\n\r\t\v");
+            string json = row.substr( 0 , end == string::npos ? 0 : end + 1 );
+            try {
+                return fromjson( json );
+            } catch ( MsgAssertionException& e ) {
+                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
+            }
+        }
+
+        vector<string> tokens;
+        tokenizeRow(row, tokens);
+        return buildObjFromTokens(tokens);
+    }
+
+    /*
+     * Parses one object from the input file.  This usually corresponds to one line in the input
+     * file, unless the file is a CSV and contains a newline within a quoted string entry.
+     * Returns a true if a BSONObj was successfully created and false if not.
+     */
+    bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
+        string row;
+        if (!readRow(in, row, numBytesRead)) {
+            return false;
+        }
+
+        if (_type != JSON && mongoImportGlobalParams.headerLine) {
+            vector<string> tokens;
+            tokenizeRow(row, tokens);
+            for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
+                toolGlobalParams.fields.push_back(*it);
+            }
+            o = BSONObj();
+            return true;
+        }
+
+        o = parseRowString(row);
+        return true;
+    }
+
+    /**
+     * Work items for the parallel import pipeline (--numParseThreads > 1): the reader
+     * (main) thread queues raw rows, parser threads queue parsed documents, and a single
+     * loader thread -- the only conn() user while the pipeline runs -- drives batched
+     * inserts.
+     */
+    struct InputRow {
+        InputRow() : seq(0), eof(false) {}
+        unsigned long long seq;
+        string row;
+        bool eof;   // sentinel; the reader hands one to each parser thread at EOF
+    };
+
+    struct ParsedDoc {
+        ParsedDoc() : seq(0), ok(false), eof(false) {}
+        unsigned long long seq;
+        BSONObj obj;
+        bool ok;    // false if the row failed to parse (document is skipped)
+        bool eof;   // sentinel; forwarded by each exiting parser thread
+    };
+
+    AtomicInt32 _parseErrors;
+    AtomicInt32 _stopPipeline;
+    long long _docsLoaded;   // written by the loader thread, read after join()
+
+    void parserThread(BlockingQueue<InputRow>* rows, BlockingQueue<ParsedDoc>* docs) {
+        while (true) {
+            InputRow in = rows->blockingPop();
+
+            ParsedDoc out;
+            out.seq = in.seq;
+            out.eof = in.eof;
+
+            if (!in.eof) {
+                try {
+                    out.obj = parseRowString(in.row);
+                    out.ok = true;
+                }
+                catch ( const std::exception& e ) {
+                    toolError() << "exception:" << e.what() << std::endl;
+                    _parseErrors.addAndFetch(1);
+                    if (mongoImportGlobalParams.stopOnError) {
+                        _stopPipeline.store(1);
+                    }
+                }
+            }
+
+            // Failed rows are forwarded too, so an in-order loader never stalls waiting
+            // for a sequence number that will not arrive.
+            docs->push(out);
+
+            if (in.eof) {
+                return;
+            }
+        }
+    }
+
+    void flushInsertBatch(const string& ns, vector<BSONObj>* batch, int* batchBytes,
+                          int insertFlags) {
+        if (batch->empty()) {
+            return;
+        }
+        conn().insert(ns, *batch, insertFlags);
+        _docsLoaded += batch->size();
+        batch->clear();
+        *batchBytes = 0;
+    }
+
+    void loaderThread(BlockingQueue<ParsedDoc>* docs, string ns, int numParsers) {
+        const bool ordered = mongoImportGlobalParams.maintainInsertionOrder;
+        const size_t batchSize = static_cast<size_t>(mongoImportGlobalParams.insertBatchSize);
+        // stay well below the wire's message limit however large the batch count
+        const int maxBatchBytes = 8 * 1024 * 1024;
+        const int insertFlags =
+            mongoImportGlobalParams.stopOnError ? 0 : InsertOption_ContinueOnError;
+
+        vector<BSONObj> batch;
+        int batchBytes = 0;
+        bool checkedFirstBatch = false;
+
+        map<unsigned long long, ParsedDoc> held;  // out-of-order docs awaiting their turn
+        unsigned long long nextSeq = 0;
+        int parsersDone = 0;
+
+        while (parsersDone < numParsers || !held.empty()) {
+            ParsedDoc d;
+            if (ordered && !held.empty() && held.begin()->first == nextSeq) {
+                d = held.begin()->second;
+                held.erase(held.begin());
+            }
+            else if (parsersDone < numParsers) {
+                d = docs->blockingPop();
+                if (d.eof) {
+                    parsersDone++;
+                    continue;
+                }
+                if (ordered && d.seq != nextSeq) {
+                    held[d.seq] = d;
+                    continue;
+                }
             }
             else {
-                string name;
-                if (pos < toolGlobalParams.fields.size()) {
-                    name = toolGlobalParams.fields[pos];
+                // All parsers are done but a gap remains; this shouldn't happen since
+                // every sequence number is forwarded, but drain in order regardless.
+                d = held.begin()->second;
+                held.erase(held.begin());
+            }
+
+            if (ordered) {
+                nextSeq++;
+            }
+
+            if (!d.ok) {
+                continue;
+            }
+
+            batch.push_back(d.obj);
+            batchBytes += d.obj.objsize();
+            if (batch.size() >= batchSize || batchBytes >= maxBatchBytes) {
+                flushInsertBatch(ns, &batch, &batchBytes, insertFlags);
+                if (!checkedFirstBatch) {
+                    // surface configuration problems right away rather than at EOF
+                    checkLastError();
+                    checkedFirstBatch = true;
                 }
-                else {
-                    stringstream ss;
-                    ss << "field" << pos;
-                    name = ss.str();
+            }
+        }
+
+        flushInsertBatch(ns, &batch, &batchBytes, insertFlags);
+    }
+
+    /*
+     * Reader half of the pipelined import: this thread only does file I/O, handing raw
+     * rows to the parser threads.  Returns the number of documents handed to the server.
+     */
+    int runPipelined(istream* in, const string& ns, ProgressMeter& pm, time_t start,
+                     int* errors) {
+        const int numParsers = mongoImportGlobalParams.numParseThreads;
+
+        // Bound both queues so a fast reader cannot pull the whole file into memory: at
+        // most maxPendingBatches insert batches' worth of parsed documents, plus one
+        // batch's worth of raw rows ahead of the parsers.
+        BlockingQueue<InputRow> rows(
+            static_cast<size_t>(mongoImportGlobalParams.insertBatchSize));
+        BlockingQueue<ParsedDoc> docs(
+            static_cast<size_t>(mongoImportGlobalParams.insertBatchSize) *
+            static_cast<size_t>(mongoImportGlobalParams.maxPendingBatches));
+
+        _parseErrors.store(0);
+        _stopPipeline.store(0);
+        _docsLoaded = 0;
+
+        vector< boost::shared_ptr<boost::thread> > parsers;
+        for (int i = 0; i < numParsers; i++) {
+            parsers.push_back(boost::shared_ptr<boost::thread>(new boost::thread(
+                    boost::bind(&Import::parserThread, this, &rows, &docs))));
+        }
+        boost::thread loader(boost::bind(&Import::loaderThread, this, &docs, ns, numParsers));
+
+        unsigned long long seq = 0;
+        int len = 0;
+        while (in->rdstate() == 0 && !_stopPipeline.load()) {
+            try {
+                InputRow r;
+                if (!readRow(in, r.row, len)) {
+                    continue;
                 }
-                pos++;
+                r.seq = seq++;
+                rows.push(r);
+            }
+            catch ( const std::exception& e ) {
+                toolError() << "exception:" << e.what() << std::endl;
+                (*errors)++;
 
-                _append( b , name , token );
+                if (mongoImportGlobalParams.stopOnError)
+                    break;
+            }
+
+            if (!toolGlobalParams.quiet) {
+                if (pm.hit(len + 1)) {
+                    log() << "\t\t\t" << seq << "\t" << (seq / (time(0) - start)) << "/second"
+                          << std::endl;
+                }
             }
         }
-        o = b.obj();
-        return true;
+
+        for (int i = 0; i < numParsers; i++) {
+            InputRow sentinel;
+            sentinel.eof = true;
+            rows.push(sentinel);
+        }
+        for (int i = 0; i < numParsers; i++) {
+            parsers[i]->join();
+        }
+        loader.join();
+
+        *errors += _parseErrors.load();
+        return static_cast<int>(_docsLoaded);
     }
 
 public:
@@ -515,6 +755,28 @@ public:
                 }
             }
         }
+        else if (mongoImportGlobalParams.numParseThreads > 1 &&
+                 !mongoImportGlobalParams.upsert &&
+                 mongoImportGlobalParams.doimport) {
+            // Parallel pipeline; see runPipelined.  Upserts stay single-threaded (one
+            // query+update round trip per document on one connection), as does
+            // --noimport, which exists to benchmark the plain parser.
+
+            // The header line mutates the global field list, so consume it before the
+            // parser threads start.
+            while (mongoImportGlobalParams.headerLine && in->rdstate() == 0) {
+                BSONObj o;
+                if (parseRow(in, o, len)) {
+                    mongoImportGlobalParams.headerLine = false;
+                    num++;
+                }
+            }
+
+            num += runPipelined(in, ns, pm, start, &errors);
+
+            // The loader checks only its first batch; force the final getLastError below.
+            lastNumChecked = -1;
+        }
         else {
             while (in->rdstate() == 0) {
                 try {
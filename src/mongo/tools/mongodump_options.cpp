@@ -85,6 +85,9 @@ namespace mongo {
                 "Exclude all collections from the dump that have the given prefix")
                         .requires("db").incompatibleWith("collection");
 
+        options->addOptionChaining("numParallelCollections", "numParallelCollections,j", moe::Int,
+                "number of collections to dump in parallel (defaults to 1)");
+
         return Status::OK();
     }
 
@@ -131,6 +134,15 @@ namespace mongo {
                 return Status(ErrorCodes::BadValue, "oplog mode is only supported on full dumps");
             }
         }
+        mongoDumpGlobalParams.numParallelCollections = getParam("numParallelCollections", 1);
+        if (mongoDumpGlobalParams.numParallelCollections < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "numParallelCollections must be a positive integer");
+        }
+        if (mongoDumpGlobalParams.numParallelCollections > 1 && hasParam("dbpath")) {
+            return Status(ErrorCodes::BadValue,
+                          "numParallelCollections is not supported with --dbpath");
+        }
         mongoDumpGlobalParams.outputDirectory = getParam("out");
         mongoDumpGlobalParams.snapShotQuery = false;
         if (!hasParam("query") && !hasParam("dbpath") && !hasParam("forceTableScan")) {
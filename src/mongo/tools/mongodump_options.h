@@ -46,6 +46,7 @@ namespace mongo {
         bool dumpUsersAndRoles;
         std::vector<std::string> excludedCollections;
         std::vector<std::string> excludeCollectionPrefixes;
+        int numParallelCollections;
     };
 
     extern MongoDumpGlobalParams mongoDumpGlobalParams;
@@ -89,6 +89,11 @@ namespace mongo {
         options->addOptionChaining("sort", "sort", moe::String,
                 "sort order, as a JSON string, e.g., '{x:1}'");
 
+        options->addOptionChaining("parallel", "parallel", moe::Int,
+                "number of parallelCollectionScan segments to export concurrently "
+                "(defaults to 1; one-object-per-line JSON only, document order is "
+                "not preserved)");
+
 
         return Status::OK();
     }
@@ -142,6 +147,30 @@ namespace mongo {
         mongoExportGlobalParams.skip = getParam("skip", 0);
         mongoExportGlobalParams.sort = getParam("sort", "");
 
+        mongoExportGlobalParams.parallel = getParam("parallel", 1);
+        if (mongoExportGlobalParams.parallel < 1) {
+            return Status(ErrorCodes::BadValue, "parallel must be a positive integer");
+        }
+        if (mongoExportGlobalParams.parallel > 1) {
+            if (mongoExportGlobalParams.csv || mongoExportGlobalParams.jsonArray) {
+                return Status(ErrorCodes::BadValue,
+                              "--parallel only supports one-object-per-line JSON output");
+            }
+            if (!mongoExportGlobalParams.query.empty() ||
+                    !mongoExportGlobalParams.sort.empty() ||
+                    mongoExportGlobalParams.skip > 0 ||
+                    mongoExportGlobalParams.limit > 0 ||
+                    toolGlobalParams.fieldsSpecified) {
+                return Status(ErrorCodes::BadValue,
+                              "--parallel scans the whole collection and cannot be combined "
+                              "with query, sort, skip, limit or a field list");
+            }
+            if (hasParam("dbpath")) {
+                return Status(ErrorCodes::BadValue,
+                              "--parallel is not supported with --dbpath");
+            }
+        }
+
         // we write output to standard error by default to avoid mangling output, but we don't need
         // to do this if an output file was specified
         toolGlobalParams.canUseStdout = false;
@@ -48,6 +48,7 @@ namespace mongo {
         unsigned int skip;
         unsigned int limit;
         std::string sort;
+        int parallel;
     };
 
     extern MongoExportGlobalParams mongoExportGlobalParams;
@@ -95,6 +95,26 @@ namespace mongo {
                 "don't actually import. useful for benchmarking parser")
                                   .hidden();
 
+        options->addOptionChaining("numParseThreads", "numParseThreads", moe::Int,
+                "number of threads converting input lines to BSON; with more than 1 the "
+                "import runs as a reader/parsers/loader pipeline. default 1 "
+                "(not supported with --upsert or --jsonArray)")
+                                  .setDefault(moe::Value(1));
+
+        options->addOptionChaining("maintainInsertionOrder", "maintainInsertionOrder", moe::Bool,
+                "insert documents in input file order when parsing on several threads, "
+                "default true; false lets each parsed document feed the next insert "
+                "batch as soon as it is ready")
+                                  .setDefault(moe::Value(true));
+
+        options->addOptionChaining("insertBatchSize", "insertBatchSize", moe::Int,
+                "documents per batched insert when parsing on several threads")
+                                  .setDefault(moe::Value(1000));
+
+        options->addOptionChaining("maxPendingBatches", "maxPendingBatches", moe::Int,
+                "bound on parsed-but-not-yet-inserted batches buffered in memory")
+                                  .setDefault(moe::Value(4));
+
 
         return Status::OK();
     }
@@ -156,6 +176,21 @@ namespace mongo {
         mongoImportGlobalParams.headerLine = hasParam("headerline");
         mongoImportGlobalParams.stopOnError = hasParam("stopOnError");
 
+        mongoImportGlobalParams.numParseThreads = params["numParseThreads"].as<int>();
+        mongoImportGlobalParams.maintainInsertionOrder = params["maintainInsertionOrder"].as<bool>();
+        mongoImportGlobalParams.insertBatchSize = params["insertBatchSize"].as<int>();
+        mongoImportGlobalParams.maxPendingBatches = params["maxPendingBatches"].as<int>();
+
+        if (mongoImportGlobalParams.numParseThreads < 1) {
+            return Status(ErrorCodes::BadValue, "numParseThreads must be at least 1");
+        }
+        if (mongoImportGlobalParams.insertBatchSize < 1) {
+            return Status(ErrorCodes::BadValue, "insertBatchSize must be at least 1");
+        }
+        if (mongoImportGlobalParams.maxPendingBatches < 1) {
+            return Status(ErrorCodes::BadValue, "maxPendingBatches must be at least 1");
+        }
+
         return Status::OK();
     }
 
@@ -48,6 +48,10 @@ namespace mongo {
         bool stopOnError;
         bool jsonArray;
         bool doimport;
+        int numParseThreads;
+        bool maintainInsertionOrder;
+        int insertBatchSize;
+        int maxPendingBatches;
     };
 
     extern MongoImportGlobalParams mongoImportGlobalParams;
@@ -57,6 +57,11 @@ using namespace mongo;
 
 namespace {
     const char* OPLOG_SENTINEL = "$oplog";  // compare by ptr not strcmp
+
+    // Plain data documents are queued and inserted in bulk: one round trip per batch
+    // instead of per document.
+    const int INSERT_BATCH_MAX_DOCS = 1000;
+    const int INSERT_BATCH_MAX_BYTES = 16 * 1024 * 1024;
 }
 
 MONGO_INITIALIZER_WITH_PREREQUISITES(RestoreAuthExternalState, ("ToolMocks"))(
@@ -86,8 +91,11 @@ public:
     int _serverAuthzVersion; // authSchemaVersion of the cluster being restored into.
     int _dumpFileAuthzVersion; // version extracted from admin.system.version file in dump.
     bool _serverAuthzVersionDocExists; // Whether the remote cluster has an admin.system.version doc
+    vector<BSONObj> _insertBatch; // queued data documents for the current collection
+    int _insertBatchBytes;
     Restore() : BSONTool(), _oplogEntrySkips(0), _oplogEntryApplies(0), _serverAuthzVersion(0),
-            _dumpFileAuthzVersion(0), _serverAuthzVersionDocExists(false) { }
+            _dumpFileAuthzVersion(0), _serverAuthzVersionDocExists(false),
+            _insertBatchBytes(0) { }
 
     virtual void printHelp(ostream& out) {
         printMongoRestoreHelp(&out);
@@ -514,6 +522,7 @@ public:
 
         // 3) Actually restore the BSONObjs inside the dump file
         processFile( root );
+        flushInsertBatch();
 
         // 4) If running with --drop, remove any users/roles that were in the system at the
         // beginning of the restore but weren't found in the dump file
@@ -717,7 +726,15 @@ public:
                                 << _dumpFileAuthzVersion,
                     _serverAuthzVersion == _dumpFileAuthzVersion);
             }
-            conn().insert(_curns, obj);
+            // processFile() reuses its read buffer, so the queued copy must own its
+            // storage.
+            _insertBatch.push_back(obj.getOwned());
+            _insertBatchBytes += obj.objsize();
+            if (static_cast<int>(_insertBatch.size()) >= INSERT_BATCH_MAX_DOCS ||
+                    _insertBatchBytes >= INSERT_BATCH_MAX_BYTES) {
+                flushInsertBatch();
+            }
+            return;
         }
 
         // wait for insert (or update) to propagate to "w" nodes (doesn't warn if w used
@@ -730,6 +747,27 @@ public:
         }
     }
 
+    void flushInsertBatch() {
+        if (_insertBatch.empty()) {
+            return;
+        }
+
+        // ContinueOnError keeps the batch behaving like the individual inserts it
+        // replaces: one bad document doesn't abort its neighbors.
+        conn().insert(_curns, _insertBatch, InsertOption_ContinueOnError);
+        _insertBatch.clear();
+        _insertBatchBytes = 0;
+
+        // wait for inserts to propagate to "w" nodes (doesn't warn if w used without
+        // replset)
+        if (mongoRestoreGlobalParams.w > 0) {
+            string err = conn().getLastError(_curdb, false, false, mongoRestoreGlobalParams.w);
+            if (!err.empty()) {
+                toolError() << err << std::endl;
+            }
+        }
+    }
+
 private:
 
     BSONObj parseMetadataFile(string filePath) {
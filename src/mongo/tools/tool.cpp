@@ -246,6 +246,28 @@ namespace mongo {
         return "admin";
     }
 
+    DBClientBase* Tool::newConnection() {
+        verify(!toolGlobalParams.useDirectClient && !toolGlobalParams.noconnection);
+
+        std::string errmsg;
+        ConnectionString cs = ConnectionString::parse(toolGlobalParams.connectionString, errmsg);
+        uassert(18539,
+                str::stream() << "invalid hostname [" << toolGlobalParams.connectionString
+                              << "] " << errmsg,
+                cs.isValid());
+
+        DBClientBase* newConn = cs.connect(errmsg);
+        uassert(18540,
+                str::stream() << "couldn't connect to [" << toolGlobalParams.connectionString
+                              << "] " << errmsg,
+                newConn);
+
+        if (!toolGlobalParams.username.empty()) {
+            newConn->auth(makeAuthParams());
+        }
+        return newConn;
+    }
+
     /**
      * Validate authentication on the server for the given dbname.
      */
@@ -262,6 +284,10 @@ namespace mongo {
             return;
         }
 
+        _conn->auth(makeAuthParams());
+    }
+
+    BSONObj Tool::makeAuthParams() {
         BSONObjBuilder authParams;
         authParams <<
             saslCommandUserDBFieldName << getAuthenticationDatabase() <<
@@ -278,7 +304,7 @@ namespace mongo {
             authParams << saslCommandServiceHostnameFieldName << toolGlobalParams.gssapiHostName;
         }
 
-        _conn->auth(authParams.obj());
+        return authParams.obj();
     }
 
     BSONTool::BSONTool() : Tool() { }
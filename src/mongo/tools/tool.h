@@ -76,6 +76,13 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * Opens and authenticates an additional connection to the same server, for use
+         * by a worker thread.  Caller owns the returned connection.  Only valid when
+         * connected to a remote server (not with --dbpath).
+         */
+        mongo::DBClientBase* newConnection();
+
         bool _autoreconnect;
 
     protected:
@@ -85,6 +92,7 @@ namespace mongo {
 
     private:
         void auth();
+        mongo::BSONObj makeAuthParams();
     };
 
     class BSONTool : public Tool {
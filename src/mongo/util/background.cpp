@@ -59,10 +59,31 @@ namespace mongo {
             void add( PeriodicTask* task );
             void remove( PeriodicTask* task );
 
+            void getTaskStats( std::vector<PeriodicTaskStats>* out );
+
             Status stop( int gracePeriodMillis );
 
         private:
 
+            // Per-task scheduling state.
+            struct TaskEntry {
+                TaskEntry()
+                    : task( NULL ),
+                      nextDueMillis( 0 ),
+                      runs( 0 ),
+                      totalTimeMillis( 0 ),
+                      lastTimeMillis( 0 ) {}
+
+                PeriodicTask* task;
+
+                // Absolute wall clock deadline; zero means not yet scheduled.
+                unsigned long long nextDueMillis;
+
+                unsigned long long runs;
+                long long totalTimeMillis;
+                int lastTimeMillis;
+            };
+
             virtual std::string name() const {
                 return "PeriodicTaskRunner";
             }
@@ -73,28 +94,33 @@ namespace mongo {
             // function.
             bool _isShutdownRequested() const;
 
-            // Runs all registered tasks. You must hold _mutex to call this function.
-            void _runTasks();
+            // Runs every task whose deadline has passed and schedules the rest. Returns the
+            // earliest pending deadline. You must hold _mutex to call this function.
+            unsigned long long _runDueTasks( unsigned long long now );
 
             // Runs one task to completion, and optionally reports timing. You must hold _mutex
             // to call this function.
-            void _runTask( PeriodicTask* task );
+            void _runTask( TaskEntry& entry );
+
+            // The task's period with a one second floor applied; shortened in debug mode to
+            // help catch race conditions.
+            static unsigned long long _periodMillis( const PeriodicTask* task );
 
             // _mutex protects the _shutdownRequested flag and the _tasks vector.
             mongo::mutex _mutex;
 
-            // The condition variable is used to sleep for the interval between task
-            // executions, and is notified when the _shutdownRequested flag is toggled.
+            // The condition variable is used to sleep until the earliest task deadline, and
+            // is notified when the _shutdownRequested flag is toggled or a task is added.
             boost::condition _cond;
 
             // Used to break the loop. You should notify _cond after changing this to true
             // so that shutdown proceeds promptly.
             bool _shutdownRequested;
 
-            // The PeriodicTasks contained in this vector are NOT owned by the
+            // The PeriodicTasks pointed to by this vector are NOT owned by the
             // PeriodicTaskRunner, and are not deleted. The vector never shrinks, removed Tasks
-            // have their entry overwritten with NULL.
-            std::vector< PeriodicTask* > _tasks;
+            // have their 'task' pointer overwritten with NULL.
+            std::vector< TaskEntry > _tasks;
         };
 
         // We rely here on zero-initialization of 'runnerMutex' to distinguish whether we are
@@ -275,6 +301,14 @@ namespace mongo {
         runner->go();
     }
 
+    void PeriodicTask::getTaskStats( std::vector<PeriodicTaskStats>* out ) {
+        ConditionalScopedLock lock( runnerMutex );
+        if ( runnerDestroyed || !runner )
+            return;
+
+        runner->getTaskStats( out );
+    }
+
     Status PeriodicTask::stopRunningPeriodicTasks( int gracePeriodMillis ) {
         ConditionalScopedLock lock( runnerMutex );
 
@@ -295,19 +329,41 @@ namespace mongo {
 
     void PeriodicTaskRunner::add( PeriodicTask* task ) {
         mutex::scoped_lock lock( _mutex );
-        _tasks.push_back( task );
+        TaskEntry entry;
+        entry.task = task;
+        _tasks.push_back( entry );
+
+        // Wake the runner in case the new task is due sooner than its current deadline.
+        _cond.notify_one();
     }
 
     void PeriodicTaskRunner::remove( PeriodicTask* task ) {
         mutex::scoped_lock lock( _mutex );
         for ( size_t i = 0; i != _tasks.size(); i++ ) {
-            if ( _tasks[i] == task ) {
-                _tasks[i] = NULL;
+            if ( _tasks[i].task == task ) {
+                _tasks[i].task = NULL;
                 break;
             }
         }
     }
 
+    void PeriodicTaskRunner::getTaskStats( std::vector<PeriodicTaskStats>* out ) {
+        mutex::scoped_lock lock( _mutex );
+        for ( size_t i = 0; i != _tasks.size(); i++ ) {
+            const TaskEntry& entry = _tasks[i];
+            if ( !entry.task )
+                continue;
+
+            PeriodicTaskStats stats;
+            stats.name = entry.task->taskName();
+            stats.periodSeconds = static_cast<int>( _periodMillis( entry.task ) / 1000 );
+            stats.runs = entry.runs;
+            stats.totalTimeMillis = entry.totalTimeMillis;
+            stats.lastTimeMillis = entry.lastTimeMillis;
+            out->push_back( stats );
+        }
+    }
+
     Status PeriodicTaskRunner::stop( int gracePeriodMillis ) {
         {
             mutex::scoped_lock lock( _mutex );
@@ -323,17 +379,18 @@ namespace mongo {
     }
 
     void PeriodicTaskRunner::run() {
-        // Use a shorter cycle time in debug mode to help catch race conditions.
-        const size_t waitMillis = (debug ? 5 : 60) * 1000;
-
         const stdx::function<bool()> predicate =
             stdx::bind( &PeriodicTaskRunner::_isShutdownRequested, this );
 
         mutex::scoped_lock lock( _mutex );
         while ( !predicate() ) {
-            const boost::xtime deadline = incxtimemillis( waitMillis );
-            if ( !_cond.timed_wait( lock.boost(), deadline, predicate ) )
-                _runTasks();
+            const unsigned long long now = curTimeMillis64();
+            const unsigned long long nextDue = _runDueTasks( now );
+
+            // One wakeup per earliest deadline, rather than one fixed tick for every task.
+            const unsigned long long sleepMillis = nextDue > now ? nextDue - now : 1;
+            const boost::xtime deadline = incxtimemillis( static_cast<long long>( sleepMillis ) );
+            _cond.timed_wait( lock.boost(), deadline, predicate );
         }
     }
 
@@ -341,20 +398,59 @@ namespace mongo {
         return _shutdownRequested;
     }
 
-    void PeriodicTaskRunner::_runTasks() {
+    unsigned long long PeriodicTaskRunner::_periodMillis( const PeriodicTask* task ) {
+        int secs = task->taskPeriodSeconds();
+        if ( secs < 1 )
+            secs = 1;
+
+        // Use a shorter cycle time in debug mode to help catch race conditions.
+        if ( debug && secs > 5 )
+            secs = 5;
+
+        return 1000ULL * secs;
+    }
+
+    unsigned long long PeriodicTaskRunner::_runDueTasks( unsigned long long now ) {
+        // If no tasks are registered, just poll occasionally; add() also notifies _cond.
+        unsigned long long nextDue = now + 60 * 1000;
+
         const size_t size = _tasks.size();
-        for ( size_t i = 0; i != size; ++i )
-            if ( PeriodicTask* const task = _tasks[i] )
-                _runTask(task);
+        for ( size_t i = 0; i != size; ++i ) {
+            TaskEntry& entry = _tasks[i];
+            if ( !entry.task )
+                continue;
+
+            const unsigned long long period = _periodMillis( entry.task );
+
+            if ( entry.nextDueMillis == 0 ) {
+                // Newly registered; first run is one period out, as it was when every task
+                // ran on the shared tick.
+                entry.nextDueMillis = now + period;
+            }
+            else if ( entry.nextDueMillis <= now ) {
+                _runTask( entry );
+
+                // Fixed-rate scheduling so a slow run does not stretch the cadence, but do
+                // not try to catch up if we fell more than a period behind.
+                entry.nextDueMillis += period;
+                if ( entry.nextDueMillis <= now )
+                    entry.nextDueMillis = now + period;
+            }
+
+            if ( entry.nextDueMillis < nextDue )
+                nextDue = entry.nextDueMillis;
+        }
+
+        return nextDue;
     }
 
-    void PeriodicTaskRunner::_runTask(PeriodicTask* const task) {
+    void PeriodicTaskRunner::_runTask( TaskEntry& entry ) {
         Timer timer;
 
-        const std::string taskName = task->taskName();
+        const std::string taskName = entry.task->taskName();
 
         try {
-            task->taskDoWork();
+            entry.task->taskDoWork();
         }
         catch ( const std::exception& e ) {
             error() << "task: " << taskName << " failed: " << e.what() << endl;
@@ -365,6 +461,10 @@ namespace mongo {
 
         const int ms = timer.millis();
         LOG( ms <= 3 ? 3 : 0 ) << "task: " << taskName << " took: " << ms << "ms" << endl;
+
+        entry.runs++;
+        entry.totalTimeMillis += ms;
+        entry.lastTimeMillis = ms;
     }
 
 } // namespace mongo
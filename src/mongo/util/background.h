@@ -133,13 +133,29 @@ namespace mongo {
     };
 
     /**
-     * these run "roughly" every minute
+     * Snapshot of the scheduling state of one registered PeriodicTask; see
+     * PeriodicTask::getTaskStats().
+     */
+    struct PeriodicTaskStats {
+        std::string name;
+        int periodSeconds;
+        unsigned long long runs;
+        long long totalTimeMillis;
+        int lastTimeMillis;
+    };
+
+    /**
+     * these run "roughly" every taskPeriodSeconds (every minute by default)
      * instantiate statically
      * class MyTask : public PeriodicTask {
      * public:
      *   virtual std::string name() const { return "MyTask; " }
      *   virtual void doWork() { log() << "hi" << std::endl; }
      * } myTask;
+     *
+     * All tasks share one scheduler thread, so doWork() implementations must be
+     * brief; anything that can block for a long time still deserves its own
+     * BackgroundJob.
      */
     class PeriodicTask {
     public:
@@ -149,6 +165,19 @@ namespace mongo {
         virtual void taskDoWork() = 0;
         virtual std::string taskName() const = 0;
 
+        /**
+         * Desired seconds between runs of this task.  The scheduler runs each task at its
+         * own cadence and sleeps until the earliest due task, rather than waking every
+         * task on a common tick.  Values below one second are treated as one second.
+         */
+        virtual int taskPeriodSeconds() const { return 60; }
+
+        /**
+         * Fills 'out' with one entry per registered task, so callers (e.g. serverStatus)
+         * can see every background cadence in one place.
+         */
+        static void getTaskStats( std::vector<PeriodicTaskStats>* out );
+
         /**
          *  Starts the BackgroundJob that runs PeriodicTasks. You may call this multiple times,
          *  from multiple threads, and the BackgroundJob will be started only once. Please note
@@ -0,0 +1,152 @@
+// adaptive_mutex.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/concurrency/adaptive_mutex.h"
+
+#include <map>
+#include <set>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mongo {
+
+    namespace {
+
+        // Registry of live instances for getAllStats().  Registration happens once per
+        // instance construction, so this mutex is never hot.  The set is leaked so
+        // instances destroyed during static destruction need not touch it.
+        SimpleMutex adaptiveMutexRegistryMutex( "AdaptiveMutexRegistry" );
+        std::set<AdaptiveMutex*>* adaptiveMutexRegistry = NULL;
+
+        void registerAdaptiveMutex( AdaptiveMutex* m ) {
+            SimpleMutex::scoped_lock lk( adaptiveMutexRegistryMutex );
+            if ( !adaptiveMutexRegistry )
+                adaptiveMutexRegistry = new std::set<AdaptiveMutex*>();
+            adaptiveMutexRegistry->insert( m );
+        }
+
+        void unregisterAdaptiveMutex( AdaptiveMutex* m ) {
+            SimpleMutex::scoped_lock lk( adaptiveMutexRegistryMutex );
+            adaptiveMutexRegistry->erase( m );
+        }
+
+    }  // namespace
+
+#if defined(__linux__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
+    AdaptiveMutex::AdaptiveMutex(const StringData& name)
+        : _state( 0 ),
+          _name( name.toString() ) {
+        registerAdaptiveMutex( this );
+    }
+
+    NOINLINE_DECL void AdaptiveMutex::_lockContended() {
+        _contendedAcquires.addAndFetch( 1 );
+
+        // Spin with exponentially growing pause bursts before involving the kernel.
+        // Short bursts keep handoff latency low when the holder is about to release;
+        // doubling them takes waiters off the cache line when it is not.  The total
+        // (~2000 pauses) is roughly the cost of the futex round trip we are avoiding.
+        int burst = 1;
+        for ( int round = 0; round < 11; round++ ) {
+            for ( int i = 0; i < burst; i++ ) {
+#if defined(__i386__) || defined(__x86_64__)
+                asm volatile ( "pause" );
+#endif
+            }
+            if ( _state == 0 && __sync_val_compare_and_swap( &_state, 0U, 1U ) == 0 ) {
+                _spinAcquires.addAndFetch( 1 );
+                return;
+            }
+            if ( burst < 1024 )
+                burst <<= 1;
+        }
+
+        // Park.  Setting state 2 tells unlock() to issue a wake; the exchange also
+        // acquires the lock if the holder released while we were spinning.  We may
+        // hold the lock at state 2 with no waiters left, costing unlock() a spurious
+        // wake -- that only happens after contention heavy enough to park.
+        while ( __sync_lock_test_and_set( &_state, 2U ) != 0 ) {
+            _parks.addAndFetch( 1 );
+            syscall( SYS_futex, &_state, FUTEX_WAIT, 2, NULL, NULL, 0 );
+        }
+    }
+
+    void AdaptiveMutex::unlock() {
+        if ( __sync_lock_test_and_set( &_state, 0U ) == 2 )
+            syscall( SYS_futex, &_state, FUTEX_WAKE, 1, NULL, NULL, 0 );
+    }
+
+#else
+
+    AdaptiveMutex::AdaptiveMutex(const StringData& name)
+        : _fallbackMutex( name ),
+          _name( name.toString() ) {
+        registerAdaptiveMutex( this );
+    }
+
+#endif
+
+    AdaptiveMutex::~AdaptiveMutex() {
+        if ( !StaticObserver::_destroyingStatics ) {
+            unregisterAdaptiveMutex( this );
+        }
+    }
+
+    void AdaptiveMutex::getAllStats(std::vector<Stats>* out) {
+        std::map<std::string, Stats> byName;
+        {
+            SimpleMutex::scoped_lock lk( adaptiveMutexRegistryMutex );
+            if ( !adaptiveMutexRegistry )
+                return;
+            for ( std::set<AdaptiveMutex*>::const_iterator it = adaptiveMutexRegistry->begin();
+                  it != adaptiveMutexRegistry->end();
+                  ++it ) {
+                const AdaptiveMutex* m = *it;
+                Stats& s = byName[ m->_name ];
+                s.name = m->_name;
+                s.contendedAcquires += m->_contendedAcquires.load();
+                s.spinAcquires += m->_spinAcquires.load();
+                s.parks += m->_parks.load();
+            }
+        }
+        for ( std::map<std::string, Stats>::const_iterator it = byName.begin();
+              it != byName.end();
+              ++it ) {
+            out->push_back( it->second );
+        }
+    }
+
+}  // namespace mongo
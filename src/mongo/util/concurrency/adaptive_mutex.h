@@ -0,0 +1,112 @@
+// adaptive_mutex.h
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Mutex for hot locks with short critical sections.  SimpleMutex parks the thread
+     * on any contention (a syscall round trip for a lock held for nanoseconds) and
+     * SpinLock never parks (burning cpu when the holder is descheduled); this one
+     * spins briefly with exponentially growing pause bursts and then parks in the
+     * kernel, so it behaves like a spinlock under light contention and like a mutex
+     * under heavy contention.
+     *
+     * Every instance registers itself under 'name'; contention counters are reported,
+     * aggregated by name, in the opt-in 'adaptiveMutexes' serverStatus section.  The
+     * counters are only touched on the contended path -- an uncontended lock() is a
+     * single atomic operation.
+     *
+     * On platforms without futexes this is a plain SimpleMutex (the counters stay 0).
+     */
+    class AdaptiveMutex : boost::noncopyable {
+    public:
+        explicit AdaptiveMutex(const StringData& name);
+        ~AdaptiveMutex();
+
+        void lock();
+        void unlock();
+        void dassertLocked() const { }
+
+        class scoped_lock : boost::noncopyable {
+            AdaptiveMutex& _m;
+        public:
+            scoped_lock( AdaptiveMutex &m ) : _m(m) { _m.lock(); }
+            ~scoped_lock() { _m.unlock(); }
+            const AdaptiveMutex& m() const { return _m; }
+        };
+
+        struct Stats {
+            Stats() : contendedAcquires(0), spinAcquires(0), parks(0) { }
+            std::string name;
+            long long contendedAcquires; // lock() calls that found the mutex held
+            long long spinAcquires;      // contended acquires resolved without parking
+            long long parks;             // trips into the kernel to wait
+        };
+
+        /**
+         * Appends the stats of every live instance to 'out', summed across instances
+         * that share a name (e.g. the stripes of a striped cache), sorted by name.
+         */
+        static void getAllStats(std::vector<Stats>* out);
+
+    private:
+#if defined(__linux__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+        NOINLINE_DECL void _lockContended();
+
+        // 0 = free, 1 = held, 2 = held and there may be waiters parked in the kernel
+        volatile unsigned _state;
+#else
+        SimpleMutex _fallbackMutex;
+#endif
+        const std::string _name;
+        AtomicInt64 _contendedAcquires;
+        AtomicInt64 _spinAcquires;
+        AtomicInt64 _parks;
+    };
+
+#if defined(__linux__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+    inline void AdaptiveMutex::lock() {
+        if ( MONGO_likely( __sync_val_compare_and_swap( &_state, 0U, 1U ) == 0 ) )
+            return;
+        _lockContended();
+    }
+#else
+    inline void AdaptiveMutex::lock() { _fallbackMutex.lock(); }
+    inline void AdaptiveMutex::unlock() { _fallbackMutex.unlock(); }
+#endif
+
+}  // namespace mongo
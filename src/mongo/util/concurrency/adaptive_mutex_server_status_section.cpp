@@ -0,0 +1,63 @@
+// adaptive_mutex_server_status_section.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * Per-lock contention counters for every live AdaptiveMutex, keyed by lock name.
+     * Opt-in: db.serverStatus( { adaptiveMutexes : 1 } ).
+     */
+    class AdaptiveMutexServerStatusSection : public ServerStatusSection {
+    public:
+
+        AdaptiveMutexServerStatusSection() : ServerStatusSection( "adaptiveMutexes" ) {}
+        virtual bool includeByDefault() const { return false; }
+
+        virtual BSONObj generateSection(const BSONElement& configElement) const {
+            std::vector<AdaptiveMutex::Stats> stats;
+            AdaptiveMutex::getAllStats( &stats );
+
+            BSONObjBuilder builder;
+            for ( size_t i = 0; i < stats.size(); i++ ) {
+                BSONObjBuilder sub( builder.subobjStart( stats[i].name ) );
+                sub.appendNumber( "contendedAcquires", stats[i].contendedAcquires );
+                sub.appendNumber( "spinAcquires", stats[i].spinAcquires );
+                sub.appendNumber( "parks", stats[i].parks );
+                sub.done();
+            }
+            return builder.obj();
+        }
+
+    } adaptiveMutexServerStatusSection;
+}
+}
@@ -33,6 +33,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/time_support.h"
 
@@ -82,6 +83,10 @@ namespace mongo {
         boost::mutex m;
         Z r,w,R,W,U,X;
         int numPendingGlobalWrites;  // >0 if someone wants to acquire a write lock
+
+        // threads currently blocked waiting to enter one of the stop-the-world states
+        // (R, W or X).  readable without m -- see exclusiveWaiting().
+        AtomicUInt32 exclusiveWaiters;
         long long generationX;
         long long generationXExit;
         void _lock_W();
@@ -118,6 +123,11 @@ namespace mongo {
             generationXExit(0) {
         }
 
+        /** @return number of threads currently blocked waiting to enter one of the
+            stop-the-world states (R, W or X).  one atomic read, no mutex; granular
+            lock holders poll this to decide whether yielding would let anyone run. */
+        unsigned exclusiveWaiting() const { return exclusiveWaiters.load(); }
+
         void lock_r();
         void lock_w();
         void lock_R();
@@ -201,18 +211,22 @@ namespace mongo {
     // are writing."
     inline void QLock::lock_R() {
         boost::mutex::scoped_lock lk(m);
+        exclusiveWaiters.fetchAndAdd(1);
         while( ! R_legal() ) {
             R.c.wait(m);
         }
+        exclusiveWaiters.fetchAndSubtract(1);
         R.n++;
     }
 
     inline bool QLock::lock_R_try(int millis) {
         unsigned long long end = curTimeMillis64() + millis;
         boost::mutex::scoped_lock lk(m);
+        exclusiveWaiters.fetchAndAdd(1);
         while( !R_legal() && curTimeMillis64() < end ) {
             R.c.timed_wait(m, boost::posix_time::milliseconds(millis));
         }
+        exclusiveWaiters.fetchAndSubtract(1);
         if ( R_legal() ) {
             R.n++;
             return true;
@@ -225,9 +239,11 @@ namespace mongo {
         boost::mutex::scoped_lock lk(m);
 
         ++numPendingGlobalWrites;
+        exclusiveWaiters.fetchAndAdd(1);
         while (!W_legal() && curTimeMillis64() < end) {
             W.c.timed_wait(m, boost::posix_time::milliseconds(millis));
         }
+        exclusiveWaiters.fetchAndSubtract(1);
         --numPendingGlobalWrites;
 
         if (W_legal()) {
@@ -295,8 +311,10 @@ namespace mongo {
 
         long long myGeneration = generationX;
 
+        exclusiveWaiters.fetchAndAdd(1);
         while ( !X_legal() && (myGeneration == generationX) )
             X.c.wait(m);
+        exclusiveWaiters.fetchAndSubtract(1);
 
         if ( myGeneration == generationX ) {
             fassert( 16214, X_legal() );
@@ -331,9 +349,11 @@ namespace mongo {
     // "i will be writing. i will coordinate with no one. you better stop them all"
     inline void QLock::_lock_W() {
         ++numPendingGlobalWrites;
+        exclusiveWaiters.fetchAndAdd(1);
         while( !W_legal() ) {
             W.c.wait(m);
         }
+        exclusiveWaiters.fetchAndSubtract(1);
         --numPendingGlobalWrites;
         W.n++;
     }
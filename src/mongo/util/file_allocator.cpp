@@ -114,6 +114,8 @@ namespace mongo {
             size = oldSize;
             return;
         }
+        if ( _claimSpare( name, size ) )
+            return;
         _pending.push_back( name );
         _pendingSize[ name ] = size;
         _pendingUpdated.notify_all();
@@ -128,6 +130,13 @@ namespace mongo {
                 return;
         }
         checkFailure();
+        if ( oldSize == -1 ) {
+            long claimed = static_cast<long>( size );
+            if ( _claimSpare( name, claimed ) ) {
+                size = claimed;
+                return;
+            }
+        }
         _pendingSize[ name ] = size;
         if ( _pending.size() == 0 )
             _pending.push_back( name );
@@ -145,6 +154,58 @@ namespace mongo {
 
     }
 
+    void FileAllocator::requestWarmSpare( const string &directory, long size, int maxSpares ) {
+        scoped_lock lk( _pendingMutex );
+        if ( _failed )
+            return;
+
+        int have = 0;
+        map< string, SpareList >::const_iterator it = _spares.find( directory );
+        if ( it != _spares.end() )
+            have = it->second.size();
+        for ( map< string, string >::const_iterator i = _pendingSpares.begin();
+              i != _pendingSpares.end(); ++i ) {
+            if ( i->second == directory )
+                have++;
+        }
+        if ( have >= maxSpares )
+            return;
+
+        const string name = makeTempFileName( boost::filesystem::path( directory ) );
+        _pendingSpares[ name ] = directory;
+        _pending.push_back( name );
+        _pendingSize[ name ] = size;
+        _pendingUpdated.notify_all();
+    }
+
+    bool FileAllocator::_claimSpare( const string &name, long &size ) {
+        const string directory = boost::filesystem::path( name ).branch_path().string();
+        map< string, SpareList >::iterator it = _spares.find( directory );
+        if ( it == _spares.end() )
+            return false;
+        for ( SpareList::iterator i = it->second.begin(); i != it->second.end(); ++i ) {
+            if ( i->first < size )
+                continue;
+            const long spareSize = i->first;
+            const string sparePath = i->second;
+            it->second.erase( i );
+            try {
+                boost::filesystem::rename( sparePath, name );
+                flushMyDirectory( name );
+            }
+            catch ( const std::exception& e ) {
+                log() << "warning: couldn't rename warm spare " << sparePath
+                      << " to " << name << ": " << e.what() << endl;
+                return false;
+            }
+            size = spareSize;
+            log() << "allocated datafile " << name << " from pre-zeroed spare, size: "
+                  << size / 1024 / 1024 << "MB" << endl;
+            return true;
+        }
+        return false;
+    }
+
     void FileAllocator::waitUntilFinished() const {
         if ( _failed )
             return;
@@ -390,6 +451,11 @@ namespace mongo {
 
                 {
                     scoped_lock lk( fa->_pendingMutex );
+                    map< string, string >::iterator sp = fa->_pendingSpares.find( name );
+                    if ( sp != fa->_pendingSpares.end() ) {
+                        fa->_spares[ sp->second ].push_back( make_pair( size, name ) );
+                        fa->_pendingSpares.erase( sp );
+                    }
                     fa->_pendingSize.erase( name );
                     fa->_pending.pop_front();
                     fa->_pendingUpdated.notify_all();
@@ -30,6 +30,9 @@
 #include "mongo/pch.h"
 
 #include <list>
+#include <map>
+#include <string>
+#include <utility>
 #include <boost/filesystem/path.hpp>
 #include <boost/thread/condition.hpp>
 
@@ -64,6 +67,16 @@ namespace mongo {
          */
         void allocateAsap( const std::string &name, unsigned long long &size );
 
+        /**
+         * Keep up to maxSpares pre-zeroed spare files of the given size on hand in
+         * 'directory' (they live under its _tmp subdirectory, so boot-time cleanup
+         * removes strays).  A later allocation request in that directory for a file
+         * no bigger than a spare is satisfied by renaming the spare into place
+         * instead of zero-filling synchronously.  Spares are built by the background
+         * thread behind any real allocation requests.
+         */
+        void requestWarmSpare( const std::string &directory, long size, int maxSpares );
+
         void waitUntilFinished() const;
         
         bool hasFailed() const;
@@ -86,6 +99,11 @@ namespace mongo {
         // caller must hold pendingMutex_ lock.
         bool inProgress( const std::string &name ) const;
 
+        // caller must hold _pendingMutex lock.  If a warm spare at least 'size'
+        // bytes exists in name's directory, renames it to 'name', updates size to
+        // the spare's size and returns true.
+        bool _claimSpare( const std::string &name, long &size );
+
         /** called from the worked thread */
         static void run( FileAllocator * fa );
 
@@ -98,6 +116,12 @@ namespace mongo {
         std::list< std::string > _pending;
         mutable std::map< std::string, long > _pendingSize;
 
+        // ready pre-zeroed spare files: directory -> list of (size, path)
+        typedef std::list< std::pair< long, std::string > > SpareList;
+        std::map< std::string, SpareList > _spares;
+        // spare files being built by the worker thread: path -> directory
+        std::map< std::string, std::string > _pendingSpares;
+
         // unique number for temporary files
         static unsigned long long _uniqueNumber;
 
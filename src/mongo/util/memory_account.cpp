@@ -0,0 +1,71 @@
+// memory_account.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/util/memory_account.h"
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    MemoryAccount* MemoryAccount::_head = NULL;
+    AtomicInt64 MemoryAccount::_budgetBytes(0);
+
+    MemoryAccount::MemoryAccount( const char* name )
+        : _name( name ),
+          _next( _head ) {
+        // only called from static initializers, so no locking needed
+        _head = this;
+    }
+
+    long long MemoryAccount::totalBytes() {
+        long long total = 0;
+        for ( const MemoryAccount* a = _head; a; a = a->_next )
+            total += a->bytes();
+        return total;
+    }
+
+    bool MemoryAccount::wouldExceedBudget( size_t want ) {
+        long long budget = _budgetBytes.load();
+        if ( budget <= 0 )
+            return false;
+        return totalBytes() + static_cast<long long>( want ) > budget;
+    }
+
+    void MemoryAccount::appendInfo( BSONObjBuilder& b ) {
+        long long total = 0;
+        for ( const MemoryAccount* a = _head; a; a = a->_next ) {
+            long long n = a->bytes();
+            b.appendNumber( a->name(), n );
+            total += n;
+        }
+        b.appendNumber( "total", total );
+        b.appendNumber( "budgetBytes", _budgetBytes.load() );
+    }
+
+} // namespace mongo
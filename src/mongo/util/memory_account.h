@@ -0,0 +1,126 @@
+// memory_account.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/striped_counter.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Tracks the bytes a subsystem currently has buffered in memory, so the
+     * big consumers (sorts, hash intersections, $group, ...) are visible in
+     * one place instead of spread across independent per-subsystem knobs.
+     *
+     * Accounts are file-scope statics in the subsystem that owns them, e.g.
+     *
+     *     namespace { MemoryAccount sortMemoryAccount( "sortStage" ); }
+     *
+     * and register themselves in a global list during static initialization
+     * (the only time construction is safe).  Subsystems call allocated() /
+     * freed() at the points where they already track their own usage; the
+     * counter is striped, so the hot path is one uncontended atomic add.
+     *
+     * A process-wide budget (memoryAccountingBudgetMB server parameter;
+     * 0 = unlimited, the default) lets the subsystems coordinate: operations
+     * already holding tracked memory consult wouldExceedBudget() and spill to
+     * disk or fail early instead of growing further, so many memory-hungry
+     * operations arriving together degrade to disk rather than driving the
+     * process into the OOM killer.
+     */
+    class MemoryAccount {
+        MONGO_DISALLOW_COPYING(MemoryAccount);
+    public:
+        explicit MemoryAccount( const char* name );
+
+        void allocated( size_t bytes ) { _bytes.increment( bytes ); }
+        void freed( size_t bytes ) { _bytes.decrement( bytes ); }
+
+        long long bytes() const { return _bytes.get(); }
+        const char* name() const { return _name; }
+
+        /** Sum of every account's current bytes. */
+        static long long totalBytes();
+
+        /**
+         * True when growing tracked memory by 'want' bytes would push the
+         * total past the configured budget.  Always false when no budget is
+         * set.  Advisory only: the caller decides whether to spill or fail.
+         */
+        static bool wouldExceedBudget( size_t want );
+
+        static void setBudgetBytes( long long bytes ) { _budgetBytes.store( bytes ); }
+        static long long getBudgetBytes() { return _budgetBytes.load(); }
+
+        /** One field per account plus the total and budget; for serverStatus. */
+        static void appendInfo( BSONObjBuilder& b );
+
+    private:
+        const char* const _name;
+        StripedCounter64 _bytes;
+
+        MemoryAccount* _next; // intrusive list of all accounts, linked at registration
+        static MemoryAccount* _head;
+        static AtomicInt64 _budgetBytes; // 0 = unlimited
+    };
+
+    /**
+     * Keeps a MemoryAccount in sync with a byte count the owner already
+     * maintains: call set() with the new local total and the account is
+     * adjusted by the difference.  The destructor releases whatever is still
+     * charged, so a stage that dies mid-query cannot leak account bytes.
+     */
+    class ScopedMemoryTracker {
+        MONGO_DISALLOW_COPYING(ScopedMemoryTracker);
+    public:
+        explicit ScopedMemoryTracker( MemoryAccount& account )
+            : _account( account ), _current( 0 ) {}
+
+        ~ScopedMemoryTracker() { _account.freed( _current ); }
+
+        void set( size_t bytes ) {
+            if ( bytes >= _current )
+                _account.allocated( bytes - _current );
+            else
+                _account.freed( _current - bytes );
+            _current = bytes;
+        }
+
+        size_t get() const { return _current; }
+
+    private:
+        MemoryAccount& _account;
+        size_t _current;
+    };
+
+} // namespace mongo
@@ -201,6 +201,31 @@ namespace {
         return thingsToFlush.size();
     }
 
+    /*static*/ int MongoFile::flushAllDirty() {
+        notifyPreFlush();
+
+        // same shape as the sync branch of _flushAll, but lets each file narrow its
+        // flush to the regions it knows are dirty
+        OwnedPointerVector<Flushable> thingsToFlushWrapper;
+        vector<Flushable*>& thingsToFlush = thingsToFlushWrapper.mutableVector();
+        {
+            LockMongoFilesShared lk;
+            for ( set<MongoFile*>::iterator i = mmfiles.begin(); i != mmfiles.end(); i++ ) {
+                MongoFile* mmf = *i;
+                if ( !mmf )
+                    continue;
+                thingsToFlush.push_back( mmf->prepareDirtyFlush() );
+            }
+        }
+
+        for ( size_t i = 0; i < thingsToFlush.size(); i++ ) {
+            thingsToFlush[i]->flush();
+        }
+
+        notifyPostFlush();
+        return thingsToFlush.size();
+    }
+
     void MongoFile::created() {
         LockMongoFilesExclusive lk;
         mmfiles.insert(this);
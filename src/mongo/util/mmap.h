@@ -31,6 +31,7 @@
 
 #include <set>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include <boost/thread/xtime.hpp>
@@ -58,6 +59,26 @@ namespace mongo {
         unsigned _len;
     };
 
+    /** Pins a region of a memory mapped file in physical memory (mlock); the pin is
+        released on destruction.  Strictly advisory: if the mlock fails (for example
+        RLIMIT_MEMLOCK is too small) the object is simply inactive.  No-op on
+        platforms without mlock.  Note mlock does not nest, so do not create
+        overlapping pins and expect the region to stay resident after one of them
+        is destroyed.
+    */
+    class MemoryPin {
+        MONGO_DISALLOW_COPYING(MemoryPin);
+    public:
+        MemoryPin(void *p, unsigned len);
+        ~MemoryPin(); // releases the pin
+        /** @return true if the region is actually pinned */
+        bool active() const { return _active; }
+    private:
+        void *_p;
+        unsigned _len;
+        bool _active;
+    };
+
     // lock order: lock dbMutex before this if you lock both
     class MONGO_CLIENT_API LockMongoFilesShared {
         friend class LockMongoFilesExclusive;
@@ -119,6 +140,11 @@ namespace mongo {
         static void (*notifyPostFlush)();
 
         static int flushAll( bool sync ); // returns n flushed
+
+        /** like flushAll(true), but files that track their dirty regions flush only
+            those.  used by the periodic data file flusher; explicit fsync paths keep
+            flushAll so they never depend on the bookkeeping. */
+        static int flushAllDirty();
         static long long totalMappedLength();
         static void closeAllFiles( std::stringstream &message );
 
@@ -141,6 +167,10 @@ namespace mongo {
          */
         virtual Flushable * prepareFlush() = 0;
 
+        /** as prepareFlush(), but subclasses that know which regions are dirty may
+            return a Flushable covering just those */
+        virtual Flushable * prepareDirtyFlush() { return prepareFlush(); }
+
         void created(); /* subclass must call after create */
 
         /* subclass must call in destructor (or at close).
@@ -209,6 +239,13 @@ namespace mongo {
         void flush(bool sync);
         virtual Flushable * prepareFlush();
 
+#if !defined(_WIN32)
+        /** a Flushable that syncs only the given (offset, length) ranges of the view,
+            which must be page aligned and ascending.  posix only; windows callers
+            fall back to prepareFlush(). */
+        Flushable * prepareRangesFlush( const std::vector< std::pair<size_t, size_t> >& ranges );
+#endif
+
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
         HANDLE getFd() const              { return fd; }
@@ -148,6 +148,28 @@ namespace mongo {
     }
 #endif
 
+    MemoryPin::MemoryPin(void *p, unsigned len) {
+        _p = _pageAlign( p );
+
+        _len = len + static_cast<unsigned>( reinterpret_cast<size_t>(p) -
+                                            reinterpret_cast<size_t>(_p)  );
+
+        _active = mlock(_p, _len) == 0;
+        if ( !_active ) {
+            static bool warned = false;
+            if ( !warned ) {
+                warned = true;
+                warning() << "mlock failed: " << errnoWithDescription()
+                          << " (is RLIMIT_MEMLOCK large enough?)" << endl;
+            }
+        }
+    }
+    MemoryPin::~MemoryPin() {
+        if ( _active ) {
+            munlock(_p, _len);
+        }
+    }
+
     void* MemoryMappedFile::map(const char *filename, unsigned long long &length, int options) {
         // length may be updated by callee.
         setFilename(filename);
@@ -259,6 +281,28 @@ namespace mongo {
         }
     }
 
+    /** msync errors are tolerable if the file was closed or deleted while we were
+        unlocked; anything else is fatal.  @return true if the error can be ignored */
+    static bool msyncFailureIsBenign( MemoryMappedFile* theFile, uint64_t id ) {
+        if ( errno == EBADF ) {
+            // ok, we were unlocked, so this file was closed
+            return true;
+        }
+
+        // some error, lets see if we're supposed to exist
+        LockMongoFilesShared mmfilesLock;
+        std::set<MongoFile*> mmfs = MongoFile::getAllFiles();
+        std::set<MongoFile*>::const_iterator it = mmfs.find(theFile);
+        if ( (it == mmfs.end()) || ((*it)->getUniqueId() != id) ) {
+            log() << "msync failed with: " << errnoWithDescription()
+                  << " but file doesn't exist anymore, so ignoring";
+            // this was deleted while we were unlocked
+            return true;
+        }
+
+        return false;
+    }
+
     class PosixFlushable : public MemoryMappedFile::Flushable {
     public:
         PosixFlushable( MemoryMappedFile* theFile, void* view , HANDLE fd , long len)
@@ -272,21 +316,8 @@ namespace mongo {
             if ( msync(_view, _len, MS_SYNC ) == 0 )
                 return;
 
-            if ( errno == EBADF ) {
-                // ok, we were unlocked, so this file was closed
+            if ( msyncFailureIsBenign( _theFile, _id ) )
                 return;
-            }
-
-            // some error, lets see if we're supposed to exist
-            LockMongoFilesShared mmfilesLock;
-            std::set<MongoFile*> mmfs = MongoFile::getAllFiles();
-            std::set<MongoFile*>::const_iterator it = mmfs.find(_theFile);
-            if ( (it == mmfs.end()) || ((*it)->getUniqueId() != _id) ) {
-                log() << "msync failed with: " << errnoWithDescription()
-                      << " but file doesn't exist anymore, so ignoring";
-                // this was deleted while we were unlocked
-                return;
-            }
 
             // we got an error, and we still exist, so this is bad, we fail
             log() << "msync " << errnoWithDescription() << endl;
@@ -304,6 +335,46 @@ namespace mongo {
         return new PosixFlushable( this, viewForFlushing(), fd, len);
     }
 
+    /** as PosixFlushable, but msyncs only the given ranges of the view */
+    class PosixRangesFlushable : public MemoryMappedFile::Flushable {
+    public:
+        PosixRangesFlushable( MemoryMappedFile* theFile,
+                              void* view,
+                              HANDLE fd,
+                              const std::vector< std::pair<size_t, size_t> >& ranges )
+            : _theFile( theFile ), _view( view ), _fd( fd ),
+              _ranges( ranges ), _id( _theFile->getUniqueId() ) {
+        }
+
+        void flush() {
+            if ( _view == NULL || _fd == 0 )
+                return;
+
+            for ( size_t i = 0; i < _ranges.size(); i++ ) {
+                char* start = static_cast<char*>( _view ) + _ranges[i].first;
+                if ( msync(start, _ranges[i].second, MS_SYNC ) == 0 )
+                    continue;
+
+                if ( msyncFailureIsBenign( _theFile, _id ) )
+                    return;
+
+                log() << "msync " << errnoWithDescription() << endl;
+                dataSyncFailedHandler();
+            }
+        }
+
+        MemoryMappedFile* _theFile;
+        void * _view;
+        HANDLE _fd;
+        std::vector< std::pair<size_t, size_t> > _ranges;
+        const uint64_t _id;
+    };
+
+    MemoryMappedFile::Flushable * MemoryMappedFile::prepareRangesFlush(
+            const std::vector< std::pair<size_t, size_t> >& ranges ) {
+        return new PosixRangesFlushable( this, viewForFlushing(), fd, ranges );
+    }
+
 
 } // namespace mongo
 
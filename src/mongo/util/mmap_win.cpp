@@ -59,6 +59,9 @@ namespace mongo {
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
 
+    MemoryPin::MemoryPin(void *,unsigned) : _p(0), _len(0), _active(false) { }
+    MemoryPin::~MemoryPin() { }
+
     const unsigned long long memoryMappedFileLocationFloor = 256LL * 1024LL * 1024LL * 1024LL;
     static unsigned long long _nextMemoryMappedFileLocation = memoryMappedFileLocationFloor;
 
@@ -135,6 +135,14 @@ namespace mongo {
             _version = 0;
             _operation = o;
         }
+
+        /* _flags bit 0: the data section is snappy compressed.  only ever set on
+           connections that negotiated compression (see MessagingPort), so old
+           peers never see it. */
+        enum { Compressed = 1 };
+        bool isCompressed() const { return ( _flags & Compressed ) != 0; }
+        void setCompressed()      { _flags |= Compressed; }
+        void clearCompressed()    { _flags &= ~Compressed; }
         char _data[4];
 
         int& dataAsInt() {
@@ -194,6 +202,9 @@ namespace mongo {
 
         bool empty() const { return !_buf && _data.empty(); }
 
+        /** @return true if the message is a single contiguous buffer (singleData() is safe) */
+        bool hasSingleData() const { return _buf != 0; }
+
         int size() const {
             int res = 0;
             if ( _buf ) {
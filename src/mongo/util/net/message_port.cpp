@@ -34,7 +34,9 @@
 #include <fcntl.h>
 #include <time.h>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/background.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
@@ -138,22 +140,60 @@ namespace mongo {
         ports.closeAll(mask);
     }
 
-    MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+    MessagingPort::MessagingPort(int fd, const SockAddr& remote)
+        : psock( new Socket( fd , remote ) ) , piggyBackData(0), _compressOut(false) {
         ports.insert(this);
     }
 
-    MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+    MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll )
+        : psock( new Socket( timeout, ll ) ), _compressOut(false) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ), piggyBackData( 0 ), _compressOut(false) {
         ports.insert(this);
     }
 
+    // don't bother compressing payloads smaller than this; the snappy framing and
+    // cpu aren't worth it and small messages are usually latency sensitive anyway
+    const int MessageCompressionMinBytes = 1024;
+
+    static AtomicInt64 _compressionBytesSavedOut;
+    static AtomicInt64 _compressionBytesSavedIn;
+
+    long long MessagingPort::compressionBytesSavedOut() {
+        return _compressionBytesSavedOut.load();
+    }
+    long long MessagingPort::compressionBytesSavedIn() {
+        return _compressionBytesSavedIn.load();
+    }
+
+    /** snappy compress the data section of 'in', leaving the header intact apart from
+        len and the compressed flag.  @return false if compression wouldn't shrink it. */
+    static bool compressMessage( const Message& in, Message* out ) {
+        MsgData* src = in.singleData();
+        const int dataLen = src->dataLen();
+
+        std::string compressed;
+        const size_t resultLen = compress( src->_data, dataLen, &compressed );
+        if ( resultLen >= static_cast<size_t>( dataLen ) )
+            return false;
+
+        const int newLen = MsgDataHeaderSize + resultLen;
+        MsgData* md = reinterpret_cast<MsgData*>( malloc( newLen ) );
+        verify( md );
+        memcpy( md, src, MsgDataHeaderSize );
+        memcpy( md->_data, compressed.data(), resultLen );
+        md->len = newLen;
+        md->setCompressed();
+        out->setData( md, true );
+
+        _compressionBytesSavedOut.fetchAndAdd( dataLen - static_cast<int>( resultLen ) );
+        return true;
+    }
+
     void MessagingPort::setSocketTimeout(double timeout) {
         psock->setTimeout(timeout);
     }
@@ -235,6 +275,31 @@ again:
 
             psock->recv( (char *)&md->_data, left );
 
+            if ( md->isCompressed() ) {
+                // inflate in place; always accepted regardless of whether we negotiated
+                // compression for our own sends
+                std::string body;
+                if ( !uncompress( md->_data, md->dataLen(), &body )
+                     || MsgDataHeaderSize + body.size() > MaxMessageSizeBytes ) {
+                    LOG(0) << "recv(): bad compressed message from " << psock->remoteString();
+                    return false;
+                }
+
+                const int newLen = MsgDataHeaderSize + body.size();
+                MsgData* inflated = reinterpret_cast<MsgData*>( malloc( newLen ) );
+                verify( inflated );
+                memcpy( inflated, md, MsgDataHeaderSize );
+                memcpy( inflated->_data, body.data(), body.size() );
+                inflated->len = newLen;
+                inflated->clearCompressed();
+
+                _compressionBytesSavedIn.fetchAndAdd( static_cast<int>( body.size() )
+                                                      - md->dataLen() );
+
+                m.setData(inflated, true);
+                return true; // guard frees the compressed buffer
+            }
+
             guard.Dismiss();
             m.setData(md, true);
             return true;
@@ -294,20 +359,29 @@ again:
         toSend.header()->id = nextMessageId();
         toSend.header()->responseTo = responseTo;
 
+        Message compressed;
+        Message* out = &toSend;
+        if ( _compressOut && toSend.hasSingleData()
+             && !toSend.header()->isCompressed()
+             && toSend.header()->dataLen() >= MessageCompressionMinBytes ) {
+            if ( compressMessage( toSend, &compressed ) )
+                out = &compressed;
+        }
+
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header()->len ) > 1300 ) {
+            if ( ( piggyBackData->len() + out->header()->len ) > 1300 ) {
                 // won't fit in a packet - so just send it off
                 piggyBackData->flush();
             }
             else {
-                piggyBackData->append( toSend );
+                piggyBackData->append( *out );
                 piggyBackData->flush();
                 return;
             }
         }
 
-        toSend.send( *this, "say" );
+        out->send( *this, "say" );
     }
 
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
@@ -62,6 +62,13 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /** once both ends have negotiated (see the networkCompress command), message
+            payloads above a size threshold are snappy compressed on the wire.
+            incoming compressed messages are always accepted; this only turns on
+            compression of what we send. */
+        virtual void enableCompression() {}
+        virtual bool isCompressionEnabled() const { return false; }
+
     public:
         // TODO make this private with some helpers
 
@@ -114,6 +121,13 @@ namespace mongo {
 
         void piggyBack( Message& toSend , int responseTo = 0 );
 
+        virtual void enableCompression() { _compressOut = true; }
+        virtual bool isCompressionEnabled() const { return _compressOut; }
+
+        /** cumulative wire bytes saved by message compression, all connections */
+        static long long compressionBytesSavedOut();
+        static long long compressionBytesSavedIn();
+
         unsigned remotePort() const { return psock->remotePort(); }
         virtual HostAndPort remote() const;
         virtual SockAddr remoteAddr() const;
@@ -147,17 +161,23 @@ namespace mongo {
             return psock->isStillConnected();
         }
 
+        bool isDataPending() {
+            return psock->isDataPending();
+        }
+
         uint64_t getSockCreationMicroSec() const {
             return psock->getSockCreationMicroSec();
         }
 
     private:
-        
+
         PiggyBackData * piggyBackData;
 
+        bool _compressOut; // negotiated; compress outgoing payloads above threshold
+
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
-        mutable HostAndPort _remoteParsed; 
+        mutable HostAndPort _remoteParsed;
 
     public:
         static void closeAllSockets(unsigned tagMask = 0xffffffff);
@@ -39,6 +39,7 @@
 namespace mongo {
 
     struct LastError;
+    class TicketHolder;
 
     class MessageHandler {
     public:
@@ -67,7 +68,13 @@ namespace mongo {
             int port;                   // port to bind to
             std::string ipList;             // addresses to bind to
 
-            Options() : port(0), ipList("") {}
+            // Connection tickets for this server.  Null means share
+            // Listener::globalTicketHolder with every other listener; a dedicated
+            // holder gives this server's connections their own budget so they can't
+            // be refused when the shared pool is exhausted.
+            TicketHolder* connTickets;
+
+            Options() : port(0), ipList(""), connTickets(0) {}
         };
 
         virtual ~MessageServer() {}
@@ -78,4 +85,14 @@ namespace mongo {
 
     // TODO use a factory here to decide between port and asio variations
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    /**
+     * epoll/kqueue based server that multiplexes idle connections onto a fixed-size
+     * worker pool instead of dedicating a thread to each connection.  See
+     * message_server_async.cpp.
+     */
+    MessageServer * createAsyncServer( const MessageServer::Options& opts ,
+                                       MessageHandler * handler );
+#endif
 }
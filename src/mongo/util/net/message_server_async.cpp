@@ -0,0 +1,369 @@
+// message_server_async.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#if defined(__linux__)
+# include <sys/epoll.h>
+#else
+# include <sys/types.h>
+# include <sys/event.h>
+# include <sys/time.h>
+#endif
+#include <unistd.h>
+
+#include "mongo/db/lasterror.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    /**
+     * Number of worker threads used by the async message server.  Unlike the classic
+     * thread-per-connection server, this bounds memory and scheduler load by the number
+     * of concurrently *active* requests rather than the number of open sockets.
+     */
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncMessageServerThreads, int, 0); // 0 => # cores
+
+    namespace {
+
+        /**
+         * Thin wrapper over the platform readiness facility (epoll on Linux, kqueue on
+         * BSD/OS X).  Sockets are registered one-shot so that a connection is owned by at
+         * most one worker at a time; the worker re-arms the socket once it has consumed a
+         * full message.
+         */
+        class SocketPoller : boost::noncopyable {
+        public:
+            SocketPoller() {
+#if defined(__linux__)
+                _pollFd = epoll_create(1024 /* ignored by modern kernels */);
+#else
+                _pollFd = kqueue();
+#endif
+                massert( 18500, "could not create socket poller for async message server",
+                         _pollFd >= 0 );
+            }
+
+            ~SocketPoller() { close(_pollFd); }
+
+            void add( int fd, void* token ) {
+#if defined(__linux__)
+                struct epoll_event ev;
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = token;
+                massert( 18501, "epoll_ctl(ADD) failed",
+                         epoll_ctl(_pollFd, EPOLL_CTL_ADD, fd, &ev) == 0 );
+#else
+                struct kevent ev;
+                EV_SET(&ev, fd, EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, token);
+                massert( 18501, "kevent(EV_ADD) failed",
+                         kevent(_pollFd, &ev, 1, NULL, 0, NULL) == 0 );
+#endif
+            }
+
+            /** re-arm a one-shot registration after a message has been handled */
+            void rearm( int fd, void* token ) {
+#if defined(__linux__)
+                struct epoll_event ev;
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = token;
+                massert( 18502, "epoll_ctl(MOD) failed",
+                         epoll_ctl(_pollFd, EPOLL_CTL_MOD, fd, &ev) == 0 );
+#else
+                add( fd, token ); // EV_ADD on an existing fd re-enables the one-shot event
+#endif
+            }
+
+            void remove( int fd ) {
+#if defined(__linux__)
+                epoll_ctl(_pollFd, EPOLL_CTL_DEL, fd, NULL); // ok if already gone
+#else
+                struct kevent ev;
+                EV_SET(&ev, fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+                kevent(_pollFd, &ev, 1, NULL, 0, NULL); // ok if already gone
+#endif
+            }
+
+            /**
+             * Waits up to timeoutMillis and appends the tokens of ready sockets to
+             * 'ready'.  Returns the number of ready sockets.
+             */
+            int wait( std::vector<void*>* ready, int timeoutMillis ) {
+                const int kMaxEvents = 256;
+#if defined(__linux__)
+                struct epoll_event evs[kMaxEvents];
+                int n = epoll_wait(_pollFd, evs, kMaxEvents, timeoutMillis);
+                for ( int i = 0; i < n; i++ )
+                    ready->push_back( evs[i].data.ptr );
+#else
+                struct kevent evs[kMaxEvents];
+                struct timespec ts;
+                ts.tv_sec = timeoutMillis / 1000;
+                ts.tv_nsec = (timeoutMillis % 1000) * 1000 * 1000;
+                int n = kevent(_pollFd, NULL, 0, evs, kMaxEvents, &ts);
+                for ( int i = 0; i < n; i++ )
+                    ready->push_back( evs[i].udata );
+#endif
+                return n;
+            }
+
+        private:
+            int _pollFd;
+        };
+
+    }  // namespace
+
+    /**
+     * MessageServer that multiplexes idle connections on epoll/kqueue instead of parking
+     * a thread per connection.  A single event loop thread watches all registered
+     * sockets; when one becomes readable its connection is handed to a fixed-size worker
+     * pool which reads exactly one message, processes it, and re-arms the socket.
+     *
+     * Selected at startup with --setParameter asyncMessageServer=true (see
+     * createServer() in message_server_port.cpp).
+     */
+    class AsyncMessageServer : public MessageServer, public Listener {
+    public:
+        AsyncMessageServer( const MessageServer::Options& opts, MessageHandler* handler )
+            : Listener( "" , opts.ipList, opts.port ),
+              _handler(handler),
+              _nWorkers( asyncMessageServerThreads > 0
+                             ? asyncMessageServerThreads
+                             : static_cast<int>( ProcessInfo().getNumCores() ) ),
+              _readyMutex( "AsyncMessageServer::_readyMutex" ) {
+        }
+
+        virtual void acceptedMP( MessagingPort* p ) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: "
+                      << Listener::globalTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            Connection* c = new Connection( p );
+            try {
+                _handler->connected( p );
+                _poller.add( p->psock->rawFD(), c );
+            }
+            catch ( ... ) {
+                log() << "unknown error registering new socket with poller" << endl;
+                _teardown( c, false );
+            }
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            log() << "async message server starting with " << _nWorkers
+                  << " worker threads" << endl;
+            for ( int i = 0; i < _nWorkers; i++ ) {
+                boost::thread thr( stdx::bind( &AsyncMessageServer::_workerLoop, this ) );
+            }
+            boost::thread eventThread( stdx::bind( &AsyncMessageServer::_eventLoop, this ) );
+            initAndListen(); // never returns unless error
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        /**
+         * Per-connection state.  The LastError lives here rather than in thread-local
+         * storage because consecutive messages on one socket may be served by different
+         * workers.
+         */
+        struct Connection {
+            explicit Connection( MessagingPort* p )
+                : port(p), le( new LastError() ), otherSide( p->psock->remoteString() ) {
+            }
+            ~Connection() { delete le; }
+
+            MessagingPort* port;
+            LastError* le;
+            const std::string otherSide;
+        };
+
+        /** ready connections handed from the event loop to the workers */
+        void _enqueue( Connection* c ) {
+            scoped_lock lk( _readyMutex );
+            _ready.push_back( c );
+            _readyCondition.notify_one();
+        }
+
+        Connection* _dequeue() {
+            scoped_lock lk( _readyMutex );
+            while ( _ready.empty() ) {
+                if ( inShutdown() )
+                    return NULL;
+                _readyCondition.timed_wait( lk.boost(), boost::posix_time::milliseconds(250) );
+            }
+            Connection* c = _ready.front();
+            _ready.pop_front();
+            return c;
+        }
+
+        void _eventLoop() {
+            setThreadName( "asyncEventLoop" );
+            std::vector<void*> ready;
+            while ( ! inShutdown() ) {
+                ready.clear();
+                _poller.wait( &ready, 250 );
+                for ( size_t i = 0; i < ready.size(); i++ ) {
+                    _enqueue( static_cast<Connection*>( ready[i] ) );
+                }
+            }
+        }
+
+        void _workerLoop() {
+            while ( ! inShutdown() ) {
+                Connection* c = _dequeue();
+                if ( ! c )
+                    continue;
+                _handleOneMessage( c );
+            }
+        }
+
+        /**
+         * Reads a single message off a ready socket, dispatches it, and re-arms the
+         * socket with the poller.  Any failure tears the connection down; the classic
+         * server's per-thread loop has the same terminating conditions.
+         */
+        void _handleOneMessage( Connection* c ) {
+            MessagingPort* p = c->port;
+
+            {
+                string threadName = "conn";
+                if ( p->connectionId() > 0 )
+                    threadName = str::stream() << threadName << p->connectionId();
+                setThreadName( threadName.c_str() );
+            }
+
+            // point thread-local lastError at this connection's entry for the duration
+            lastError.reset( c->le );
+
+            bool ok = true;
+            Message m;
+            try {
+                p->psock->clearCounters();
+                if ( ! p->recv(m) ) {
+                    if ( ! serverGlobalParams.quiet ) {
+                        int conns = Listener::globalTicketHolder.used()-1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "end connection " << c->otherSide << " (" << conns << word
+                              << " now open)" << endl;
+                    }
+                    ok = false;
+                }
+                else {
+                    _handler->process( m, p, c->le );
+                    networkCounter.hit( p->psock->getBytesIn(), p->psock->getBytesOut() );
+                }
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: "
+                      << e << endl;
+                ok = false;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: "
+                      << e << endl;
+                ok = false;
+            }
+            catch ( const DBException& e ) {
+                log() << "DBException handling request, closing client connection: "
+                      << e << endl;
+                ok = false;
+            }
+            catch ( std::exception& e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            lastError.release(); // the Connection keeps ownership of the LastError
+
+            if ( ok )
+                _poller.rearm( p->psock->rawFD(), c );
+            else
+                _teardown( c, true );
+        }
+
+        void _teardown( Connection* c, bool notifyHandler ) {
+            _poller.remove( c->port->psock->rawFD() );
+            if ( notifyHandler )
+                _handler->disconnected( c->port );
+            c->port->shutdown();
+            delete c->port;
+            delete c;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        const int _nWorkers;
+        SocketPoller _poller;
+
+        mongo::mutex _readyMutex;
+        boost::condition _readyCondition;
+        std::deque<Connection*> _ready;
+    };
+
+    MessageServer* createAsyncServer( const MessageServer::Options& opts,
+                                      MessageHandler* handler ) {
+        return new AsyncMessageServer( opts, handler );
+    }
+
+}  // namespace mongo
+
+#endif  // defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
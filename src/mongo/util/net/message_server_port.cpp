@@ -36,6 +36,7 @@
 
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -53,6 +54,14 @@
 
 namespace mongo {
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    /**
+     * When true, use the epoll/kqueue based AsyncMessageServer instead of spawning a
+     * thread per connection.  See message_server_async.cpp.
+     */
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncMessageServer, bool, false);
+#endif
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -63,13 +72,15 @@ namespace mongo {
          *     and should make sure that it lives longer than this server.
          */
         PortMessageServer(  const MessageServer::Options& opts, MessageHandler * handler ) :
-            Listener( "" , opts.ipList, opts.port ), _handler(handler) {
+            Listener( "" , opts.ipList, opts.port ),
+            _handler(handler),
+            _tickets( opts.connTickets ? opts.connTickets : &Listener::globalTicketHolder ) {
         }
 
         virtual void acceptedMP(MessagingPort * p) {
 
-            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
-                log() << "connection refused because too many open connections: " << Listener::globalTicketHolder.used() << endl;
+            if ( ! _tickets->tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << _tickets->used() << endl;
 
                 // TODO: would be nice if we notified them...
                 p->shutdown();
@@ -82,7 +93,7 @@ namespace mongo {
             try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
                 {
-                    HandleIncomingMsgParam* himParam = new HandleIncomingMsgParam(p, _handler);
+                    HandleIncomingMsgParam* himParam = new HandleIncomingMsgParam(p, _handler, _tickets);
                     boost::thread thr(stdx::bind(&handleIncomingMsg, himParam));
                 }
 #else
@@ -104,7 +115,7 @@ namespace mongo {
 
 
                 pthread_t thread;
-                HandleIncomingMsgParam* himParam = new HandleIncomingMsgParam(p, _handler);
+                HandleIncomingMsgParam* himParam = new HandleIncomingMsgParam(p, _handler, _tickets);
                 int failed = pthread_create(&thread, &attrs, &handleIncomingMsg, himParam);
 
                 pthread_attr_destroy(&attrs);
@@ -116,7 +127,7 @@ namespace mongo {
 #endif
             }
             catch ( boost::thread_resource_error& ) {
-                Listener::globalTicketHolder.release();
+                _tickets->release();
                 log() << "can't create new thread, closing connection" << endl;
 
                 p->shutdown();
@@ -125,7 +136,7 @@ namespace mongo {
                 sleepmillis(2);
             }
             catch ( ... ) {
-                Listener::globalTicketHolder.release();
+                _tickets->release();
                 log() << "unknown error accepting new socket" << endl;
 
                 p->shutdown();
@@ -152,18 +163,21 @@ namespace mongo {
 
     private:
         MessageHandler* _handler;
+        TicketHolder* _tickets;
 
         /**
          * Simple holder for threadRun parameters. Should not destroy the objects it holds -
          * it is the responsibility of the caller to take care of them.
          */
         struct HandleIncomingMsgParam {
-            HandleIncomingMsgParam(MessagingPort* inPort,  MessageHandler* handler):
-                inPort(inPort), handler(handler) {
+            HandleIncomingMsgParam(MessagingPort* inPort,  MessageHandler* handler,
+                                   TicketHolder* tickets):
+                inPort(inPort), handler(handler), tickets(tickets) {
             }
 
             MessagingPort* inPort;
             MessageHandler* handler;
+            TicketHolder* tickets;
         };
 
         /**
@@ -179,9 +193,8 @@ namespace mongo {
          * @return NULL
          */
         static void* handleIncomingMsg(void* arg) {
-            TicketHolderReleaser connTicketReleaser( &Listener::globalTicketHolder );
-
             scoped_ptr<HandleIncomingMsgParam> himArg(static_cast<HandleIncomingMsgParam*>(arg));
+            TicketHolderReleaser connTicketReleaser( himArg->tickets );
             MessagingPort* inPort = himArg->inPort;
             MessageHandler* handler = himArg->handler;
 
@@ -213,7 +226,7 @@ namespace mongo {
 
                     if ( ! p->recv(m) ) {
                         if (!serverGlobalParams.quiet) {
-                            int conns = Listener::globalTicketHolder.used()-1;
+                            int conns = himArg->tickets->used()-1;
                             const char* word = (conns == 1 ? " connection" : " connections");
                             log() << "end connection " << otherSide << " (" << conns << word << " now open)" << endl;
                         }
@@ -256,6 +269,12 @@ namespace mongo {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+        // The async server shares its worker pool across all connections, which is
+        // exactly what a caller asking for a dedicated ticket pool wants to avoid.
+        if ( asyncMessageServer && !opts.connTickets )
+            return createAsyncServer( opts , handler );
+#endif
         return new PortMessageServer( opts , handler );
     }
 
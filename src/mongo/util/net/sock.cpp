@@ -939,6 +939,29 @@ namespace mongo {
         return false;
     }
 
+    // isDataPending() does a non-blocking poll for readable data.  A true return does not
+    // guarantee a whole message has arrived; recv() may still block briefly for the rest.
+    // Conservatively claims data is pending when readiness cannot be determined, so
+    // callers fall back to an ordinary blocking recv().
+    bool Socket::isDataPending() {
+
+        if ( ! isPollSupported() ) return true; // nothing we can do
+
+        pollfd pollInfo;
+        pollInfo.fd = _fd;
+        pollInfo.events = POLLIN;
+
+        // Poll( info[], size, timeout ) - timeout == 0 => nonblocking
+        int nEvents = socketPoll( &pollInfo, 1, 0 );
+
+        if ( nEvents < 0 ) {
+            // Poll itself failed; claim readiness and let recv() surface any real error.
+            return true;
+        }
+
+        return nEvents > 0;
+    }
+
 #if defined(_WIN32)
     struct WinsockInit {
         WinsockInit() {
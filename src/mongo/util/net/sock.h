@@ -239,6 +239,7 @@ namespace mongo {
 
         void setTimeout( double secs );
         bool isStillConnected();
+        bool isDataPending();
 
         void setHandshakeReceived() {
             _awaitingHandshake = false;
@@ -0,0 +1,166 @@
+// @file numa.h minimal NUMA helpers (no libnuma dependency)
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mongo {
+
+    /** Small NUMA helpers used by the storage layer.
+
+        We deliberately do not link against libnuma -- it is not available on all
+        of our build hosts and everything we need is a couple of raw syscalls plus
+        /proc parsing.  On non-Linux platforms (and Linux kernels without NUMA
+        syscalls) every helper degrades to a no-op that returns false; callers
+        should log a warning and carry on.
+    */
+    namespace numautil {
+
+#if defined(__linux__) && defined(__NR_mbind) && defined(__NR_get_mempolicy)
+
+        // from <linux/mempolicy.h>, which ships with libnuma-dev; redefined here
+        // so we build without it.
+        const int MPOL_INTERLEAVE_ = 3;
+        const unsigned long MPOL_F_MEMS_ALLOWED_ = (1 << 2);
+
+        // room for 1024 nodes, far beyond anything we run on
+        const size_t NodeMaskWords = 16;
+
+        /** Ask the kernel to interleave allocation of the (not yet faulted) pages
+            of [p, p+len) across all nodes we are allowed to allocate on.  Call
+            right after mmap(), before anything touches the region; pages that are
+            already resident are left where they are.
+            @return true if the policy was applied
+        */
+        inline bool interleaveMemory(void* p, size_t len) {
+            unsigned long allowed[NodeMaskWords];
+            for (size_t i = 0; i < NodeMaskWords; i++)
+                allowed[i] = 0;
+            if (syscall(__NR_get_mempolicy, NULL, allowed,
+                        NodeMaskWords * sizeof(unsigned long) * 8,
+                        NULL, MPOL_F_MEMS_ALLOWED_) != 0) {
+                return false;
+            }
+            return syscall(__NR_mbind, p, len, MPOL_INTERLEAVE_, allowed,
+                           NodeMaskWords * sizeof(unsigned long) * 8,
+                           0 /*flags*/) == 0;
+        }
+
+        /** Restrict the calling thread to the cpus of NUMA node 'node', per
+            /sys/devices/system/node.  @return true if affinity was applied */
+        inline bool bindThisThreadToNode(int node) {
+            std::stringstream fn;
+            fn << "/sys/devices/system/node/node" << node << "/cpulist";
+            std::ifstream f(fn.str().c_str());
+            if (!f.is_open())
+                return false;
+            std::string cpulist; // e.g. "0-7,32-39"
+            f >> cpulist;
+
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            bool any = false;
+            const char* s = cpulist.c_str();
+            while (*s) {
+                char* end;
+                long lo = strtol(s, &end, 10);
+                long hi = lo;
+                if (end == s)
+                    break;
+                s = end;
+                if (*s == '-') {
+                    hi = strtol(s + 1, &end, 10);
+                    s = end;
+                }
+                for (long c = lo; c <= hi && c < CPU_SETSIZE; c++) {
+                    CPU_SET((int)c, &cpus);
+                    any = true;
+                }
+                if (*s == ',')
+                    s++;
+            }
+            if (!any)
+                return false;
+            return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+        }
+
+        /** Tally how many of our resident pages live on each NUMA node, from the
+            per-mapping N<node>=<pages> counters in /proc/self/numa_maps.  Reading
+            that file walks our page tables, so this is not free -- keep it out of
+            default serverStatus output.
+            @return true if the counters were read
+        */
+        inline bool pageResidencyByNode(std::map<int, long long>* pagesPerNode) {
+            std::ifstream f("/proc/self/numa_maps");
+            if (!f.is_open())
+                return false;
+            std::string token;
+            while (f >> token) {
+                if (token.size() < 3 || token[0] != 'N')
+                    continue;
+                std::string::size_type eq = token.find('=');
+                if (eq == std::string::npos)
+                    continue;
+                char* end;
+                long node = strtol(token.c_str() + 1, &end, 10);
+                if (end != token.c_str() + eq)
+                    continue; // e.g. "kernelpagesize_kB=4"
+                long long pages = strtoll(token.c_str() + eq + 1, &end, 10);
+                if (*end)
+                    continue;
+                (*pagesPerNode)[(int)node] += pages;
+            }
+            return true;
+        }
+
+#else
+
+        inline bool interleaveMemory(void*, size_t) { return false; }
+        inline bool bindThisThreadToNode(int) { return false; }
+        inline bool pageResidencyByNode(std::map<int, long long>*) { return false; }
+
+#endif
+
+    }
+
+}
@@ -38,8 +38,10 @@
 
 #include "mongo/base/parse_number.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
 
 #ifdef _WIN32
 #include <boost/date_time/filetime_functions.hpp>
@@ -1000,4 +1002,34 @@ namespace {
     }
 #endif
 
+    namespace {
+
+        // Refreshed by the fast clock thread; 0 until the thread has started.
+        AtomicUInt64 fastClockMicros;
+
+        void fastClockThread() {
+            setThreadName( "fastClock" );
+            while ( true ) {
+                fastClockMicros.store( curTimeMicros64() );
+                sleepmillis( 1 );
+            }
+        }
+    }
+
+    unsigned long long curTimeMicros64Fast() {
+        unsigned long long cached = fastClockMicros.load();
+        if ( cached == 0 )
+            return curTimeMicros64(); // fast clock thread not started yet
+        return cached;
+    }
+
+    unsigned long long curTimeMillis64Fast() {
+        return curTimeMicros64Fast() / 1000;
+    }
+
+    void startFastClockThread() {
+        boost::thread t( fastClockThread );
+        t.detach();
+    }
+
 }  // namespace mongo
@@ -172,6 +172,21 @@ namespace mongo {
     unsigned long long curTimeMicros64();
     unsigned long long curTimeMillis64();
 
+    /**
+     * Coarse versions of the above for hot paths that stamp operations but
+     * don't need better than millisecond granularity.  They read a timestamp
+     * that a background thread refreshes about once a millisecond, so a call
+     * is a single atomic load rather than a clock syscall (even a vDSO
+     * gettimeofday costs tens of nanoseconds, and we make several calls per
+     * operation).  Until startFastClockThread() has run they fall back to the
+     * precise clock.
+     */
+    unsigned long long curTimeMicros64Fast();
+    unsigned long long curTimeMillis64Fast();
+
+    /** Spawn the thread that refreshes the fast clock.  Called once at startup. */
+    void startFastClockThread();
+
     // these are so that if you use one of them compilation will fail
     char *asctime(const struct tm *tm);
     char *ctime(const time_t *timep);